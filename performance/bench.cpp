@@ -0,0 +1,305 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+// Microbenchmarks of the core engines, over the tasks of a data set, such as
+// one written by 'generate'.  Each reports the time, allocations and bytes
+// allocated per operation.
+
+#include <cmake.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <Allocations.h>
+#include <Context.h>
+#include <Column.h>
+#include <Eval.h>
+#include <Filter.h>
+#include <Lexer.h>
+#include <Task.h>
+#include <ViewTask.h>
+#include <main.h>
+
+extern thread_local const Task* contextTask;
+
+////////////////////////////////////////////////////////////////////////////////
+// Every allocation is counted, by the task library if built to, otherwise by
+// replacing the global operator new here.
+#ifdef HAVE_ALLOCATION_COUNTING
+static uint64_t allocations () { return Allocations::count (); }
+static uint64_t allocated ()   { return Allocations::bytes (); }
+#else
+static std::atomic <uint64_t> allocation_count {0};
+static std::atomic <uint64_t> allocation_bytes {0};
+static uint64_t allocations () { return allocation_count.load (); }
+static uint64_t allocated ()   { return allocation_bytes.load (); }
+
+void* operator new (size_t size)
+{
+  allocation_count.fetch_add (1, std::memory_order_relaxed);
+  allocation_bytes.fetch_add (size, std::memory_order_relaxed);
+
+  if (void* memory = malloc (size ? size : 1))
+    return memory;
+
+  throw std::bad_alloc ();
+}
+
+void operator delete (void* memory) noexcept
+{
+  free (memory);
+}
+
+void operator delete (void* memory, size_t) noexcept
+{
+  free (memory);
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Runs body, which performs ops operations, until at least the minimum time has
+// passed, and reports the cost of one.
+static double minimum = 1.0;
+static std::string only;
+
+static void measure (
+  const std::string& name,
+  size_t ops,
+  const std::function <void ()>& body)
+{
+  if (only != "" && name.find (only) == std::string::npos)
+    return;
+
+  // Once to warm up, uncounted.
+  body ();
+
+  uint64_t runs = 0;
+  uint64_t count_before = allocations ();
+  uint64_t bytes_before = allocated ();
+  auto start = std::chrono::steady_clock::now ();
+  std::chrono::duration <double> elapsed {};
+  do
+  {
+    body ();
+    ++runs;
+    elapsed = std::chrono::steady_clock::now () - start;
+  }
+  while (elapsed.count () < minimum);
+
+  double total = (double) runs * (ops ? ops : 1);
+  printf ("%-28s %12.1f ns/op %10.2f allocs/op %12.1f bytes/op %10zu ops\n",
+          name.c_str (),
+          elapsed.count () * 1e9 / total,
+          (allocations () - count_before) / total,
+          (allocated ()   - bytes_before) / total,
+          (size_t) total);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static std::vector <std::string> readLines (const std::string& file)
+{
+  std::vector <std::string> lines;
+  std::ifstream in (file);
+  std::string line;
+  while (std::getline (in, line))
+    if (line != "")
+      lines.push_back (line);
+
+  return lines;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static std::vector <std::pair <std::string, Lexer::Type>> tokenize (const std::string& expression)
+{
+  std::vector <std::pair <std::string, Lexer::Type>> tokens;
+  Lexer lexer (expression);
+  std::string token;
+  Lexer::Type type;
+  while (lexer.token (token, type))
+    tokens.push_back (std::pair <std::string, Lexer::Type> (token, type));
+
+  return tokens;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static void benchmarks ()
+{
+  auto& context  = Context::getContext ();
+  auto location  = context.config.get ("data.location");
+  auto pending   = readLines (location + "/pending.data");
+  auto completed = readLines (location + "/completed.data");
+
+  std::vector <std::string> lines (pending);
+  lines.insert (lines.end (), completed.begin (), completed.end ());
+  if (lines.empty ())
+    throw std::string ("No tasks found in ") + location;
+
+  std::vector <Task> tasks;
+  tasks.reserve (lines.size ());
+  for (auto& line : lines)
+    tasks.push_back (Task (line));
+
+  std::cout << "Benchmarks over " << tasks.size () << " tasks in " << location << '\n';
+
+  measure ("Task::parse", lines.size (), [&] ()
+  {
+    for (auto& line : lines)
+    {
+      Task task (line);
+    }
+  });
+
+  measure ("Task::composeF4", tasks.size (), [&] ()
+  {
+    for (auto& task : tasks)
+      task.composeF4 ();
+  });
+
+  measure ("Task::composeJSON", tasks.size (), [&] ()
+  {
+    std::string json;
+    for (auto& task : tasks)
+    {
+      json.clear ();
+      task.composeJSON (json);
+    }
+  });
+
+  // A typical report filter, of a junction, a match and a date comparison.
+  Eval eval;
+  eval.addSource (domSource);
+  eval.compileExpression (tokenize ("( project == 'Home' or priority == 'H' ) and description ~ 'report' and due < '20180101T000000Z'"));
+  measure ("Eval::evaluateCompiled", tasks.size (), [&] ()
+  {
+    Variant result;
+    for (auto& task : tasks)
+    {
+      contextTask = &task;
+      eval.evaluateCompiledExpression (result);
+    }
+  });
+
+  std::vector <int> sequence;
+  measure ("sort_tasks", tasks.size (), [&] ()
+  {
+    sequence.clear ();
+    for (size_t i = 0; i < tasks.size (); ++i)
+      sequence.push_back ((int) i);
+
+    sort_tasks (tasks, sequence, "urgency-,project+,due+,description+");
+  });
+
+  // The rows of a 'list'-like report, rendered to a string.
+  std::string report = "bench";
+  ViewTask view;
+  for (auto& column : {"id", "start.age", "entry.age", "depends.indicator", "priority",
+                       "project", "tags", "recur.indicator", "due.relative", "until.remaining",
+                       "description.count", "urgency"})
+    view.add (Column::factory (column, report));
+  view.width (160);
+  view.intraPadding (1);
+
+  std::vector <int> rows;
+  for (size_t i = 0; i < tasks.size () && i < 1000; ++i)
+    rows.push_back ((int) i);
+
+  measure ("ViewTask::render", rows.size (), [&] ()
+  {
+    view.render (tasks, rows);
+  });
+
+  auto& file = context.tdb2.pending;
+  file.get_tasks ();
+  measure ("TF2::dependency_scan", file._tasks.size (), [&] ()
+  {
+    file.dependency_scan ();
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main (int argc, const char** argv)
+{
+  int status = 0;
+
+  try
+  {
+    // The remaining arguments, such as rc:<file>, configure Context.
+    std::vector <const char*> args {argv[0]};
+    for (int i = 1; i < argc; i++)
+    {
+      if (! strcmp (argv[i], "-h") || ! strcmp (argv[i], "--help"))
+      {
+        std::cout << '\n'
+                  << "Usage: " << argv[0] << " [options] [rc:<file>] [rc.<name>:<value> ...]\n"
+                  << '\n'
+                  << "Options:\n"
+                  << "  -h|--help         Display this usage\n"
+                  << "  --time SECONDS    Minimum time per benchmark (1)\n"
+                  << "  --only NAME       Run only the benchmarks named with NAME\n"
+                  << '\n';
+        exit (1);
+      }
+      else if (! strcmp (argv[i], "--time") && i + 1 < argc)
+        minimum = strtod (argv[++i], nullptr);
+      else if (! strcmp (argv[i], "--only") && i + 1 < argc)
+        only = argv[++i];
+      else
+        args.push_back (argv[i]);
+    }
+
+    args.push_back ("rc.gc:0");
+    args.push_back ("rc.hooks:0");
+    args.push_back ("_version");
+
+    Context globalContext;
+    Context::setContext (&globalContext);
+    status = globalContext.initialize ((int) args.size (), &args[0]);
+    if (status == 0)
+      benchmarks ();
+  }
+
+  catch (const std::string& error)
+  {
+    std::cerr << error << '\n';
+    status = -1;
+  }
+
+  catch (...)
+  {
+    std::cerr << "Unknown error occured.  Oops.\n";
+    status = -2;
+  }
+
+  return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
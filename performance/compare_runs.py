@@ -4,83 +4,175 @@
 #
 # Run without arguments for usage information.
 #
-# "Perf task" lines in debug output differing between the two versions is
-# poorly handled, if at all.  Best used for comparing performance between two
-# similar Taskwarrior versions only differing in performance related code.
+# Each file holds the timings of N repetitions of the benchmarks, as either
+# the JSON lines written with rc.perf.output:json, or, for older versions, the
+# "Perf task" lines of run_perf output.  Every command found in both files is
+# compared, which with run_perf covers every report.
 #
-# "total" will probably not be the sum of the shown individual parts, but
-# slightly larger since not all minimum values will have been present in the
-# same run.
+# For each command and timing, the medians of the two versions are shown, and
+# a difference is marked as a regression when the current version is slower
+# by more than the threshold, and a Mann-Whitney U test finds the difference
+# significant.  The exit status is 1 if there is any regression, so that the
+# comparison can gate a change.
 #
 
 import collections
+import json
+import math
 import re
 import sys
 
-# Adjust if more performance tests are added
-COMMANDS = "next list all add export import".split()
+# A regression is flagged when slower by more than this fraction, and with a
+# p-value below this level.
+THRESHOLD = 0.05
+SIGNIFICANCE = 0.05
 
-TaskPerf = collections.namedtuple("TaskPerf", "version commit at timing")
+# Timings below this many microseconds are too noisy to gate on.
+MINIMUM_US = 100
+
+TaskPerf = collections.namedtuple("TaskPerf", "version commit at timing counters")
 
 
 def parse_perf(input):
-    tests = {}
-    for command in COMMANDS:
-        tests[command] = []
-
-        # Parse concatenated run_perf output
-        for i in re.findall("^  - task %s\.\.\.\n"
-                            "Perf task ([^ ]+) ([^ ]+) ([^ ]+) (.+)$"
-                            % command, input, re.MULTILINE):
-            info = i[0:3] + ({k:v for k, v in (i.split(":") for i in i[-1].split())},)
-            pt = TaskPerf(*info)
-            tests[command].append(pt)
+    tests = collections.OrderedDict()
+
+    # JSON lines, from rc.perf.output:json.
+    for line in input.splitlines():
+        line = line.strip()
+        if line.startswith("{"):
+            try:
+                perf = json.loads(line)
+            except ValueError:
+                continue
+            # Allocations, where counted, are compared as timings are.
+            timing = perf["timing"]
+            if "allocations" in perf:
+                timing["allocs"] = perf["allocations"]["count"]
+                timing["alloc_bytes"] = perf["allocations"]["bytes"]
+            # As are the bytes held, so that memory regressions are found.
+            for k, v in perf.get("memory", {}).items():
+                timing["mem_" + k] = v
+            # And the time taken by each hook script.
+            for k, v in perf.get("hooks", {}).items():
+                timing["hook_" + k] = v
+            pt = TaskPerf(perf["version"], perf["commit"], perf["timestamp"],
+                          timing, perf.get("counters", {}))
+            tests.setdefault(perf["command"], []).append(pt)
+
+    if tests:
+        return tests
+
+    # Concatenated run_perf output.
+    for i in re.findall("^  - task ([^.]+)\.\.\.\n"
+                        "Perf task ([^ ]+) ([^ ]+) ([^ ]+) (.+)$",
+                        input, re.MULTILINE):
+        timing = {k: int(v) for k, v in (j.split(":") for j in i[-1].split())}
+        pt = TaskPerf(i[1], i[2], i[3], timing, {})
+        tests.setdefault(i[0], []).append(pt)
     return tests
 
 
-def get_best(tests):
-    best = {}
-    for command in tests:
-        best[command] = {}
-        for k in tests[command][0].timing:
-            best[command][k] = str(min(int(t.timing[k]) for t in tests[command]))
-    return best
+def median(values):
+    values = sorted(values)
+    middle = len(values) // 2
+    if len(values) % 2:
+        return float(values[middle])
+    return (values[middle - 1] + values[middle]) / 2.0
+
+
+def slower_p(previous, current):
+    """One-sided p-value that current is slower than previous, by the
+    Mann-Whitney U test with the normal approximation."""
+    n1, n2 = len(previous), len(current)
+    if n1 < 2 or n2 < 2:
+        return 1.0
+
+    # U counts the pairs in which current is slower, ties counting half.
+    u = 0.0
+    for c in current:
+        for p in previous:
+            if c > p:
+                u += 1
+            elif c == p:
+                u += 0.5
+
+    mean = n1 * n2 / 2.0
+    sd = math.sqrt(n1 * n2 * (n1 + n2 + 1) / 12.0)
+    z = (u - mean) / sd
+    return 0.5 * math.erfc(z / math.sqrt(2))
+
+
+def compare(command, prev, cur):
+    print("# %s (%d, %d runs):" % (command, len(prev), len(cur)))
+
+    regressions = []
+    keys = [k for k in prev[0].timing if k in cur[0].timing]
+    out = ["" for i in range(6)]
+    for k in keys:
+        p_values = [int(t.timing[k]) for t in prev]
+        c_values = [int(t.timing[k]) for t in cur]
+        p_median, c_median = median(p_values), median(c_values)
+        diff = c_median - p_median
+
+        if p_median > 0:
+            percentage = "%d%%" % int(diff / p_median * 100)
+        else:
+            percentage = "0%"
+
+        p = slower_p(p_values, c_values)
+        flag = ""
+        if (c_median >= MINIMUM_US and
+                diff > p_median * THRESHOLD and
+                p < SIGNIFICANCE):
+            flag = "SLOWER"
+            regressions.append("%s %s +%s" % (command, k, percentage))
+
+        cells = (k, "%d" % p_median, "%d" % c_median, "%d" % diff,
+                 percentage, flag)
+        pad = max(map(len, cells))
+        for row, cell in enumerate(cells):
+            out[row] += " %s" % cell.rjust(pad)
+    for line in out:
+        if line.strip():
+            print(line)
+
+    # Counters should match, unless the data or the command differs.
+    for k in sorted(cur[0].counters):
+        if k in prev[0].counters and prev[0].counters[k] != cur[0].counters[k]:
+            print(" note: %s %s differs, %s -> %s" % (
+                command, k, prev[0].counters[k], cur[0].counters[k]))
+
+    return regressions
 
 
 if len(sys.argv) != 3:
     print("Usage:")
     print(" $ %s file1 file2" % sys.argv[0])
     print("Where file1, file2 are generated as such:")
+    print(" $ for i in `seq 20`; do PERF_OUTPUT=filename ./run_perf; done")
+    print("or, for versions without rc.perf.output:")
     print(" $ for i in `seq 20`; do ./run_perf >> filename 2>&1; done")
-    sys.exit(1)
+    sys.exit(2)
 
 with open(sys.argv[1], "r") as fh:
     tests_prev = parse_perf(fh.read())
-    best_prev = get_best(tests_prev)
 with open(sys.argv[2], "r") as fh:
     tests_cur = parse_perf(fh.read())
-    best_cur = get_best(tests_cur)
-
-print("Previous: %s (%s)" % (tests_prev[COMMANDS[0]][0].version, tests_prev[COMMANDS[0]][0].commit))
-print("Current:  %s (%s)" % (tests_cur[COMMANDS[0]][0].version, tests_cur[COMMANDS[0]][0].commit))
 
-for test in COMMANDS:
-    print("# %s:" % test)
+commands = [c for c in tests_cur if c in tests_prev]
+if not commands:
+    print("No commands in common.")
+    sys.exit(2)
 
-    out = ["" for i in range(5)]
-    for k in sorted(best_prev[test].keys()):
-        diff = str(int(best_cur[test][k]) - int(best_prev[test][k]))
+print("Previous: %s (%s)" % (tests_prev[commands[0]][0].version, tests_prev[commands[0]][0].commit))
+print("Current:  %s (%s)" % (tests_cur[commands[0]][0].version, tests_cur[commands[0]][0].commit))
 
-        if float(best_prev[test][k]) > 0:
-            percentage = str(int((float(diff) / float(best_prev[test][k]) * 100))) + "%"
-        else:
-            percentage = "0%"
+regressions = []
+for command in commands:
+    regressions += compare(command, tests_prev[command], tests_cur[command])
 
-        pad = max(map(len, (k, best_prev[test][k], best_cur[test][k], diff, percentage)))
-        out[0] += " %s" % k.rjust(pad)
-        out[1] += " %s" % best_prev[test][k].rjust(pad)
-        out[2] += " %s" % best_cur[test][k].rjust(pad)
-        out[3] += " %s" % diff.rjust(pad)
-        out[4] += " %s" % percentage.rjust(pad)
-    for line in out:
-        print(line)
+if regressions:
+    print("Regressions:")
+    for regression in regressions:
+        print("  %s" % regression)
+    sys.exit(1)
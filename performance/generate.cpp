@@ -0,0 +1,536 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+// Writes a synthetic data set, of pending.data, completed.data, undo.data and
+// backlog.data, directly in the formats that TDB2 reads, along with an rc file
+// that defines its UDAs.  The same options and seed always give the same data.
+
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// The shape of the data set.  Percentages are of the plain tasks.
+struct Shape
+{
+  size_t      tasks       {10000};
+  int         completed   {60};
+  int         deleted     {5};
+  int         waiting     {5};
+  int         depends     {20};
+  int         annotated   {15};
+  int         due         {30};
+  int         backlog     {10};
+  size_t      recurring   {20};
+  size_t      udas        {3};
+  uint64_t    seed        {1};
+  std::string output      {"."};
+  std::string rc          {"perf.rc"};
+};
+
+// A task, as its attributes.
+typedef std::map <std::string, std::string> Attributes;
+
+static const char* words[] =
+{
+  "review", "write", "call", "fix", "plan", "order", "update", "check",
+  "report", "meeting", "budget", "garden", "invoice", "kitchen", "draft",
+  "release", "notes", "schedule", "backup", "server", "letter", "tickets",
+  "renew", "insurance", "paint", "fence", "groceries", "dentist", "slides",
+  "proposal", "taxes", "library", "books", "quarterly", "design", "test",
+};
+
+static const char* projects[] =
+{
+  "Home", "Home.Garden", "Home.Kitchen", "Work", "Work.Release",
+  "Work.Meetings", "Work.Planning", "Finance", "Finance.Taxes", "Health",
+  "Travel", "Learning",
+};
+
+static const char* tags[] =
+{
+  "next", "phone", "errand", "email", "waiting", "someday", "review", "online",
+};
+
+static const char* priorities[] = {"H", "M", "L"};
+
+#define COUNT(array) (sizeof (array) / sizeof (array[0]))
+
+// 2017-07-14, from when the tasks were entered, over a year.
+static const int64_t base = 1500000000;
+static const int64_t year = 365 * 86400;
+
+// Waiting tasks wait until 2100-01-01, so remain waiting whenever run.
+static const int64_t waitUntil = 4102444800;
+
+////////////////////////////////////////////////////////////////////////////////
+// Xorshift, so that the data does not depend on the platform rand ().
+class Random
+{
+public:
+  explicit Random (uint64_t seed) : _state (seed ? seed : 1) {}
+
+  uint64_t next ()
+  {
+    _state ^= _state << 13;
+    _state ^= _state >> 7;
+    _state ^= _state << 17;
+    return _state;
+  }
+
+  size_t below (size_t limit)           { return (size_t) (next () % limit); }
+  bool   chance (int percent)           { return (int) below (100) < percent; }
+  const char* pick (const char** array, size_t count) { return array[below (count)]; }
+
+private:
+  uint64_t _state;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+static std::string uuid (Random& random)
+{
+  static const char* hex = "0123456789abcdef";
+  std::string id (36, '-');
+  for (int i = 0; i < 36; ++i)
+    if (i != 8 && i != 13 && i != 18 && i != 23)
+      id[i] = hex[random.below (16)];
+
+  id[14] = '4';
+  id[19] = hex[8 + random.below (4)];
+  return id;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static std::string sentence (Random& random, size_t low, size_t high)
+{
+  std::string text;
+  auto count = low + random.below (high - low + 1);
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (i)
+      text += ' ';
+    text += random.pick (words, COUNT (words));
+  }
+
+  return text;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static std::string epoch (int64_t value)
+{
+  return std::to_string (value);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static std::string iso (const std::string& value)
+{
+  char buffer[32];
+  struct tm t;
+  time_t when = (time_t) strtoll (value.c_str (), nullptr, 10);
+  gmtime_r (&when, &t);
+  strftime (buffer, sizeof (buffer), "%Y%m%dT%H%M%SZ", &t);
+  return buffer;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static bool isDate (const std::string& name)
+{
+  return name == "entry" || name == "modified" || name == "end"  ||
+         name == "due"   || name == "wait"     || name == "until";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The generated text holds nothing that F4 or JSON would encode.
+static std::string composeF4 (const Attributes& task)
+{
+  std::string line = "[";
+  for (auto& attribute : task)
+  {
+    if (line.length () > 1)
+      line += ' ';
+    line += attribute.first + ":\"" + attribute.second + '"';
+  }
+
+  return line + ']';
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static std::string composeJSON (const Attributes& task)
+{
+  std::string json = "{";
+  std::string annotations;
+  for (auto& attribute : task)
+  {
+    auto& name = attribute.first;
+    auto& value = attribute.second;
+
+    if (name.compare (0, 11, "annotation_") == 0)
+    {
+      annotations += std::string (annotations == "" ? "" : ",") +
+                     "{\"entry\":\"" + iso (name.substr (11)) +
+                     "\",\"description\":\"" + value + "\"}";
+      continue;
+    }
+
+    if (json.length () > 1)
+      json += ',';
+    json += '"' + name + "\":";
+
+    if (name == "tags" || name == "depends")
+    {
+      json += "[\"";
+      for (auto c : value)
+        json += c == ',' ? std::string ("\",\"") : std::string (1, c);
+      json += "\"]";
+    }
+    else if (isDate (name))
+      json += '"' + iso (value) + '"';
+    else if (name == "imask" || name.compare (0, 6, "metric") == 0)
+      json += value;
+    else
+      json += '"' + value + '"';
+  }
+
+  if (annotations != "")
+    json += ",\"annotations\":[" + annotations + ']';
+
+  return json + '}';
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The UDAs alternate between numeric 'metricN' and string 'labelN'.
+static std::string udaName (size_t index)
+{
+  return (index % 2 ? "label" : "metric") + std::to_string (index + 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static void common (Attributes& task, Random& random, const Shape& shape, int64_t entry)
+{
+  task["uuid"]        = uuid (random);
+  task["description"] = sentence (random, 3, 10);
+  task["entry"]       = epoch (entry);
+  task["modified"]    = epoch (entry + (int64_t) random.below (30 * 86400));
+
+  if (random.chance (70))
+    task["project"] = random.pick (projects, COUNT (projects));
+
+  if (random.chance (40))
+    task["priority"] = random.pick (priorities, COUNT (priorities));
+
+  std::string tagList;
+  for (auto count = random.below (4); count; --count)
+  {
+    std::string tag = random.pick (tags, COUNT (tags));
+    if (("," + tagList + ",").find ("," + tag + ",") == std::string::npos)
+      tagList += (tagList == "" ? "" : ",") + tag;
+  }
+  if (tagList != "")
+    task["tags"] = tagList;
+
+  for (size_t i = 0; i < shape.udas; ++i)
+    if (random.chance (50))
+      task[udaName (i)] = i % 2 ? std::string (random.pick (words, COUNT (words)))
+                                : std::to_string (random.below (1000));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+class Writer
+{
+public:
+  Writer (const Shape& shape)
+  : _shape (shape)
+  , _pending   (shape.output + "/pending.data")
+  , _completed (shape.output + "/completed.data")
+  , _undo      (shape.output + "/undo.data")
+  , _backlog   (shape.output + "/backlog.data")
+  {
+    if (! _pending || ! _completed || ! _undo || ! _backlog)
+      throw std::string ("Could not write to ") + shape.output;
+  }
+
+  // Each task is added, and if no longer pending, modified, as it would have
+  // been by the 'add' and 'done' or 'delete' commands.
+  void write (const Attributes& task, Random& random)
+  {
+    auto& status = task.at ("status");
+    auto line = composeF4 (task);
+    bool open = status == "pending" || status == "waiting" || status == "recurring";
+
+    (open ? _pending : _completed) << line << '\n';
+
+    if (open)
+      _undo << "time " << task.at ("entry") << "\nnew " << line << "\n---\n";
+    else
+    {
+      Attributes added (task);
+      added["status"] = "pending";
+      added["modified"] = added["entry"];
+      added.erase ("end");
+      _undo << "time " << task.at ("entry") << "\nnew " << composeF4 (added) << "\n---\n"
+            << "time " << task.at ("end") << "\nold " << composeF4 (added)
+            << "\nnew " << line << "\n---\n";
+    }
+
+    if (random.chance (_shape.backlog))
+      _backlog << composeJSON (task) << '\n';
+  }
+
+  bool close ()
+  {
+    _pending.close ();
+    _completed.close ();
+    _undo.close ();
+    _backlog.close ();
+    return _pending && _completed && _undo && _backlog;
+  }
+
+private:
+  const Shape&  _shape;
+  std::ofstream _pending;
+  std::ofstream _completed;
+  std::ofstream _undo;
+  std::ofstream _backlog;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+static void generate (const Shape& shape)
+{
+  Random random (shape.seed);
+  Writer writer (shape);
+
+  // Open tasks may be depended upon, by those added after them.
+  std::vector <std::string> open;
+  open.reserve (shape.tasks);
+
+  size_t counts[4] {0, 0, 0, 0};
+  for (size_t i = 0; i < shape.tasks; ++i)
+  {
+    int64_t entry = base + (int64_t) ((double) year * i / shape.tasks);
+
+    Attributes task;
+    common (task, random, shape, entry);
+
+    if (random.chance (shape.due))
+      task["due"] = epoch (entry + (int64_t) random.below (60 * 86400));
+
+    if (random.chance (shape.annotated))
+      for (auto count = 1 + random.below (3); count; --count)
+        task["annotation_" + epoch (entry + 3600 * (int64_t) count)] = sentence (random, 2, 8);
+
+    int roll = (int) random.below (100);
+    if (roll < shape.completed)
+    {
+      task["status"] = "completed";
+      task["end"] = task["modified"];
+      ++counts[1];
+    }
+    else if (roll < shape.completed + shape.deleted)
+    {
+      task["status"] = "deleted";
+      task["end"] = task["modified"];
+      ++counts[2];
+    }
+    else
+    {
+      if (roll < shape.completed + shape.deleted + shape.waiting)
+      {
+        task["status"] = "waiting";
+        task["wait"] = epoch (waitUntil);
+      }
+      else
+        task["status"] = "pending";
+
+      // Up to three dependencies, on recent open tasks.
+      if (open.size () && random.chance (shape.depends))
+      {
+        std::string depends;
+        for (auto count = 1 + random.below (3); count; --count)
+        {
+          auto& dependency = open[open.size () - 1 - random.below (std::min (open.size (), (size_t) 100))];
+          if (depends.find (dependency) == std::string::npos)
+            depends += (depends == "" ? "" : ",") + dependency;
+        }
+
+        task["depends"] = depends;
+      }
+
+      open.push_back (task["uuid"]);
+      ++counts[0];
+    }
+
+    writer.write (task, random);
+  }
+
+  // Each template has four weekly pending instances, and ends with the last of
+  // them, so that no more are due to be generated.
+  for (size_t i = 0; i < shape.recurring; ++i)
+  {
+    int64_t entry = base + (int64_t) ((double) year * i / shape.recurring);
+
+    Attributes parent;
+    common (parent, random, shape, entry);
+    parent["status"] = "recurring";
+    parent["recur"]  = "weekly";
+    parent["due"]    = epoch (entry + 86400);
+    parent["until"]  = epoch (entry + 86400 + 3 * 7 * 86400);
+    parent["mask"]   = "----";
+    writer.write (parent, random);
+
+    for (int instance = 0; instance < 4; ++instance)
+    {
+      Attributes child (parent);
+      child["uuid"]   = uuid (random);
+      child["status"] = "pending";
+      child["parent"] = parent["uuid"];
+      child["imask"]  = std::to_string (instance);
+      child["due"]    = epoch (entry + 86400 + instance * 7 * 86400);
+      child.erase ("mask");
+      writer.write (child, random);
+    }
+
+    counts[3] += 5;
+  }
+
+  if (! writer.close ())
+    throw std::string ("Could not write to ") + shape.output;
+
+  // The rc file points at the data, and defines the UDAs.
+  std::ofstream rc (shape.rc);
+  rc << "data.location=" << shape.output << '\n'
+     << "color=on\n"
+     << "_forcecolor=on\n"
+     << "verbose=label\n"
+     << "hooks=off\n"
+     << "color.debug=\n"
+     << "recurrence.limit=4\n";
+  for (size_t i = 0; i < shape.udas; ++i)
+    rc << "uda." << udaName (i) << ".type=" << (i % 2 ? "string" : "numeric") << '\n'
+       << "uda." << udaName (i) << ".label=" << udaName (i) << '\n';
+
+  rc.close ();
+  if (! rc)
+    throw std::string ("Could not write ") + shape.rc;
+
+  std::cout << "Generated " << counts[0] << " open, "
+                            << counts[1] << " completed, "
+                            << counts[2] << " deleted and "
+                            << counts[3] << " recurring tasks.\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static void usage (const char* program)
+{
+  std::cout << '\n'
+            << "Usage: " << program << " [options]\n"
+            << '\n'
+            << "Options:\n"
+            << "  --tasks N         Plain tasks to generate (10000)\n"
+            << "  --completed %     Of which completed (60)\n"
+            << "  --deleted %       Of which deleted (5)\n"
+            << "  --waiting %       Of which waiting (5)\n"
+            << "  --depends %       Open tasks with dependencies (20)\n"
+            << "  --annotated %     Tasks with annotations (15)\n"
+            << "  --due %           Tasks with a due date (30)\n"
+            << "  --backlog %       Tasks also in backlog.data (10)\n"
+            << "  --recurring N     Recurring templates, of four instances each (20)\n"
+            << "  --udas N          UDAs, alternately numeric and string (3)\n"
+            << "  --seed N          Random seed (1)\n"
+            << "  --output DIR      Data directory (.)\n"
+            << "  --rc FILE         The rc file to write (perf.rc)\n"
+            << '\n';
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main (int argc, char** argv)
+{
+  int status = 0;
+
+  try
+  {
+    Shape shape;
+
+    for (int i = 1; i < argc; i++)
+    {
+      std::string option = argv[i];
+      if (option == "-h" || option == "--help")
+      {
+        usage (argv[0]);
+        return 1;
+      }
+
+      if (i + 1 >= argc)
+        throw "Missing value for " + option;
+
+      std::string value = argv[++i];
+      auto number = strtoull (value.c_str (), nullptr, 10);
+
+           if (option == "--tasks")     shape.tasks     = (size_t) number;
+      else if (option == "--completed") shape.completed = (int) number;
+      else if (option == "--deleted")   shape.deleted   = (int) number;
+      else if (option == "--waiting")   shape.waiting   = (int) number;
+      else if (option == "--depends")   shape.depends   = (int) number;
+      else if (option == "--annotated") shape.annotated = (int) number;
+      else if (option == "--due")       shape.due       = (int) number;
+      else if (option == "--backlog")   shape.backlog   = (int) number;
+      else if (option == "--recurring") shape.recurring = (size_t) number;
+      else if (option == "--udas")      shape.udas      = (size_t) number;
+      else if (option == "--seed")      shape.seed      = (uint64_t) number;
+      else if (option == "--output")    shape.output    = value;
+      else if (option == "--rc")        shape.rc        = value;
+      else
+        throw "Unrecognized option " + option;
+    }
+
+    if (shape.completed + shape.deleted + shape.waiting > 100)
+      throw std::string ("The completed, deleted and waiting percentages exceed 100.");
+
+    generate (shape);
+  }
+
+  catch (const std::string& error)
+  {
+    std::cerr << error << '\n';
+    status = -1;
+  }
+
+  catch (...)
+  {
+    std::cerr << "Unknown error occured.  Oops.\n";
+    status = -2;
+  }
+
+  return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
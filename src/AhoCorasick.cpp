@@ -0,0 +1,170 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmake.h>
+#include <AhoCorasick.h>
+#include <algorithm>
+#include <deque>
+
+////////////////////////////////////////////////////////////////////////////////
+AhoCorasick::AhoCorasick (bool sensitive /* = true */)
+: _sensitive (sensitive)
+, _compiled (false)
+, _count (0)
+, _nodes (1, Node {{}, 0, {}})
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Adds a pattern to the trie.  An empty pattern matches any text, as it does
+// for find ().
+void AhoCorasick::add (const std::string& pattern)
+{
+  int id = _count++;
+  if (pattern == "")
+  {
+    _empty.push_back (id);
+    return;
+  }
+
+  int node = 0;
+  for (unsigned char c : pattern)
+  {
+    c = fold (c);
+    int next = child (node, c);
+    if (next == -1)
+    {
+      next = (int) _nodes.size ();
+      _nodes.push_back (Node {{}, 0, {}});
+
+      auto& links = _nodes[node].next;
+      links.insert (std::lower_bound (links.begin (), links.end (), std::make_pair (c, 0)),
+                    std::make_pair (c, next));
+    }
+
+    node = next;
+  }
+
+  _nodes[node].patterns.push_back (id);
+  _compiled = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Computes the failure link of every node, breadth first, and merges into each
+// node the patterns of the nodes its failure links lead to.
+void AhoCorasick::compile ()
+{
+  if (_compiled)
+    return;
+
+  std::deque <int> queue;
+  for (auto& link : _nodes[0].next)
+  {
+    _nodes[link.second].fail = 0;
+    queue.push_back (link.second);
+  }
+
+  while (! queue.empty ())
+  {
+    int node = queue.front ();
+    queue.pop_front ();
+
+    for (auto& link : _nodes[node].next)
+    {
+      int fail = _nodes[node].fail;
+      int target;
+      while ((target = child (fail, link.first)) == -1 && fail != 0)
+        fail = _nodes[fail].fail;
+
+      _nodes[link.second].fail = target == -1 ? 0 : target;
+
+      const auto& inherited = _nodes[_nodes[link.second].fail].patterns;
+      _nodes[link.second].patterns.insert (_nodes[link.second].patterns.end (),
+                                           inherited.begin (), inherited.end ());
+      queue.push_back (link.second);
+    }
+  }
+
+  _compiled = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool AhoCorasick::empty () const
+{
+  return _count == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Marks found[i] for every pattern i that occurs in the text.  The found vector
+// is grown to the number of patterns, but never cleared, so that several texts
+// can be matched into it.
+void AhoCorasick::match (const std::string& text, std::vector <char>& found) const
+{
+  if (! _compiled)
+    throw std::string ("AhoCorasick::match called before compile.");
+
+  if (found.size () < (size_t) _count)
+    found.resize (_count, 0);
+
+  for (auto id : _empty)
+    found[id] = 1;
+
+  int node = 0;
+  for (unsigned char c : text)
+  {
+    c = fold (c);
+    int next;
+    while ((next = child (node, c)) == -1 && node != 0)
+      node = _nodes[node].fail;
+
+    node = next == -1 ? 0 : next;
+    for (auto id : _nodes[node].patterns)
+      found[id] = 1;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int AhoCorasick::child (int node, unsigned char c) const
+{
+  const auto& links = _nodes[node].next;
+  auto link = std::lower_bound (links.begin (), links.end (), std::make_pair (c, 0));
+  if (link != links.end () && link->first == c)
+    return link->second;
+
+  return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+unsigned char AhoCorasick::fold (unsigned char c) const
+{
+  if (! _sensitive && c >= 'A' && c <= 'Z')
+    return c + ('a' - 'A');
+
+  return c;
+}
+
+////////////////////////////////////////////////////////////////////////////////
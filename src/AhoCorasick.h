@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef INCLUDED_AHOCORASICK
+#define INCLUDED_AHOCORASICK
+
+#include <vector>
+#include <string>
+
+// AhoCorasick finds every occurrence of any of a set of patterns in a single
+// pass over a text, however many patterns there are.  Patterns are numbered in
+// the order they are added.  Without case sensitivity, ASCII letters are
+// folded, as they are by find ().
+class AhoCorasick
+{
+public:
+  explicit AhoCorasick (bool sensitive = true);
+
+  void add (const std::string&);
+  void compile ();
+  bool empty () const;
+  void match (const std::string&, std::vector <char>&) const;
+
+private:
+  struct Node
+  {
+    std::vector <std::pair <unsigned char, int>> next;  // Sorted by byte
+    int fail;
+    std::vector <int> patterns;                        // Ending here
+  };
+
+  int child (int, unsigned char) const;
+  unsigned char fold (unsigned char) const;
+
+private:
+  bool _sensitive;
+  bool _compiled;
+  int _count;
+  std::vector <int> _empty;
+  std::vector <Node> _nodes;
+};
+
+#endif
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,238 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmake.h>
+#include <Allocations.h>
+#include <sys/resource.h>
+
+#if defined (HAVE_ALLOCATION_COUNTING) || defined (HAVE_ARENA)
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <stdlib.h>
+
+#ifdef HAVE_ARENA
+#include <sys/mman.h>
+#endif
+
+#ifdef HAVE_ALLOCATION_COUNTING
+// Totals for the process, and for each thread, so that a span may count only
+// the allocations of its own thread.
+static std::atomic <uint64_t> total_count {0};
+static std::atomic <uint64_t> total_bytes {0};
+static thread_local uint64_t thread_count = 0;
+static thread_local uint64_t thread_bytes = 0;
+#endif
+
+#ifdef HAVE_ARENA
+// The arena is a single reservation of address space, whose pages are only
+// committed when first touched.  Allocations within it are never freed, but
+// are released together when the process exits.  Once it is full, or if it
+// could not be reserved, allocations are made by malloc.
+static const size_t arena_size = sizeof (void*) == 8 ? (size_t) 1 << 30 : (size_t) 1 << 28;
+static std::atomic <size_t> arena_used {0};
+static std::atomic <bool>   arena_disabled {false};
+
+////////////////////////////////////////////////////////////////////////////////
+static char* arena ()
+{
+  static char* base = [] ()
+  {
+    void* memory = mmap (nullptr, arena_size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return memory == MAP_FAILED ? (char*) nullptr : (char*) memory;
+  } ();
+
+  return base;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static bool inArena (void* memory)
+{
+  auto base = arena ();
+  return base && (char*) memory >= base && (char*) memory < base + arena_size;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+static void* allocate (size_t size)
+{
+#ifdef HAVE_ALLOCATION_COUNTING
+  total_count.fetch_add (1, std::memory_order_relaxed);
+  total_bytes.fetch_add (size, std::memory_order_relaxed);
+  ++thread_count;
+  thread_bytes += size;
+#endif
+
+#ifdef HAVE_ARENA
+  // Every allocation keeps the alignment of malloc.
+  auto base = arena_disabled.load (std::memory_order_relaxed) ? nullptr : arena ();
+  if (base)
+  {
+    const size_t alignment = alignof (std::max_align_t);
+    auto aligned = size ? (size + alignment - 1) & ~(alignment - 1) : alignment;
+    auto offset  = arena_used.fetch_add (aligned, std::memory_order_relaxed);
+    if (offset + aligned <= arena_size)
+      return base + offset;
+  }
+#endif
+
+  return malloc (size ? size : 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static void release (void* memory)
+{
+#ifdef HAVE_ARENA
+  if (inArena (memory))
+    return;
+#endif
+
+  free (memory);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void* operator new (size_t size)
+{
+  if (void* memory = allocate (size))
+    return memory;
+
+  throw std::bad_alloc ();
+}
+
+void* operator new[] (size_t size)
+{
+  if (void* memory = allocate (size))
+    return memory;
+
+  throw std::bad_alloc ();
+}
+
+void* operator new (size_t size, const std::nothrow_t&) noexcept
+{
+  return allocate (size);
+}
+
+void* operator new[] (size_t size, const std::nothrow_t&) noexcept
+{
+  return allocate (size);
+}
+
+void operator delete (void* memory) noexcept                          { release (memory); }
+void operator delete[] (void* memory) noexcept                        { release (memory); }
+void operator delete (void* memory, size_t) noexcept                  { release (memory); }
+void operator delete[] (void* memory, size_t) noexcept                { release (memory); }
+void operator delete (void* memory, const std::nothrow_t&) noexcept   { release (memory); }
+void operator delete[] (void* memory, const std::nothrow_t&) noexcept { release (memory); }
+
+#endif
+
+#ifdef HAVE_ALLOCATION_COUNTING
+////////////////////////////////////////////////////////////////////////////////
+bool Allocations::enabled ()
+{
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t Allocations::count ()
+{
+  return total_count.load (std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t Allocations::bytes ()
+{
+  return total_bytes.load (std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t Allocations::threadCount ()
+{
+  return thread_count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t Allocations::threadBytes ()
+{
+  return thread_bytes;
+}
+
+#else
+
+bool     Allocations::enabled ()     { return false; }
+uint64_t Allocations::count ()       { return 0; }
+uint64_t Allocations::bytes ()       { return 0; }
+uint64_t Allocations::threadCount () { return 0; }
+uint64_t Allocations::threadBytes () { return 0; }
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+void Allocations::disableArena ()
+{
+#ifdef HAVE_ARENA
+  arena_disabled.store (true, std::memory_order_relaxed);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t Allocations::peakRSS ()
+{
+  struct rusage usage;
+  if (getrusage (RUSAGE_SELF, &usage) != 0)
+    return 0;
+
+#if defined (DARWIN)
+  return (uint64_t) usage.ru_maxrss;
+#else
+  return (uint64_t) usage.ru_maxrss * 1024;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t Allocations::held (const std::string& text)
+{
+  auto data = text.data ();
+  if (data >= (const char*) &text && data < (const char*) (&text + 1))
+    return 0;
+
+  return text.capacity () + 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t Allocations::held (const std::vector <std::string>& texts)
+{
+  uint64_t bytes = texts.capacity () * sizeof (std::string);
+  for (auto& text : texts)
+    bytes += held (text);
+
+  return bytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef INCLUDED_ALLOCATIONS
+#define INCLUDED_ALLOCATIONS
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// Allocations counts every allocation, when built with the
+// ENABLE_ALLOCATION_COUNTING option, which replaces the global operator new and
+// delete.  Otherwise it is disabled, and every count is zero.
+//
+// The ENABLE_ARENA option also replaces them, to allocate from an arena that is
+// released when the process exits.  A process that runs more than one command,
+// such as the shell or watch, turns it off, so that what each command allocates
+// is freed.
+class Allocations
+{
+public:
+  static bool     enabled ();
+  static uint64_t count ();
+  static uint64_t bytes ();
+  static uint64_t threadCount ();
+  static uint64_t threadBytes ();
+
+  // Allocates by malloc from now on, leaving what the arena holds in place.
+  static void     disableArena ();
+
+  // The peak resident set size of the process, in bytes, however built.
+  static uint64_t peakRSS ();
+
+  // The bytes that strings hold beyond the string objects themselves, which
+  // hold a short string within, and that a vector of them holds in all.
+  static uint64_t held (const std::string&);
+  static uint64_t held (const std::vector <std::string>&);
+};
+
+#endif
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,279 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmake.h>
+#include <AttributeMap.h>
+#include <Allocations.h>
+#include <algorithm>
+#include <utility>
+#include <stdlib.h>
+
+////////////////////////////////////////////////////////////////////////////////
+static bool before (const AttributeMap::value_type& left, const std::string& right)
+{
+  return left.first < right;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+AttributeMap::iterator AttributeMap::lower_bound (const std::string& name)
+{
+  return std::lower_bound (_data.begin (), _data.end (), name, before);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+AttributeMap::const_iterator AttributeMap::lower_bound (const std::string& name) const
+{
+  return std::lower_bound (_data.begin (), _data.end (), name, before);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+AttributeMap& AttributeMap::operator= (const AttributeMap& other)
+{
+  if (this != &other)
+  {
+    discard ();
+    _data = other._data;
+  }
+
+  return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// A moved-from map is left empty, with nothing memoized.
+AttributeMap::AttributeMap (AttributeMap&& other)
+: _data (std::move (other._data))
+, _cache (std::move (other._cache))
+, _known (other._known)
+, _flags (other._flags)
+{
+  other.clear ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+AttributeMap& AttributeMap::operator= (AttributeMap&& other)
+{
+  if (this != &other)
+  {
+    _data  = std::move (other._data);
+    _cache = std::move (other._cache);
+    _known = other._known;
+    _flags = other._flags;
+    other.clear ();
+  }
+
+  return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+AttributeMap::iterator AttributeMap::find (const std::string& name)
+{
+  discard ();
+  auto i = lower_bound (name);
+  if (i != _data.end () && i->first == name)
+    return i;
+
+  return _data.end ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+AttributeMap::const_iterator AttributeMap::find (const std::string& name) const
+{
+  auto i = lower_bound (name);
+  if (i != _data.end () && i->first == name)
+    return i;
+
+  return _data.end ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The attributes whose names begin with the prefix, such as the annotations,
+// which are adjacent in name order.
+AttributeMap::range AttributeMap::prefixed (const std::string& prefix) const
+{
+  auto first = lower_bound (prefix);
+  auto last = first;
+  while (last != _data.end () &&
+         ! last->first.compare (0, prefix.length (), prefix))
+    ++last;
+
+  return {first, last};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The bytes held beyond the map itself, as an estimate for perf.output.
+size_t AttributeMap::bytes () const
+{
+  size_t bytes = _data.capacity () * sizeof (value_type) +
+                 _cache.capacity () * sizeof (cached);
+  for (auto& attribute : _data)
+    bytes += Allocations::held (attribute.first) + Allocations::held (attribute.second);
+
+  return bytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+size_t AttributeMap::count (const std::string& name) const
+{
+  return find (name) != _data.end () ? 1 : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::string& AttributeMap::operator[] (const std::string& name)
+{
+  discard ();
+  auto i = lower_bound (name);
+  if (i == _data.end () || i->first != name)
+    i = _data.insert (i, value_type (name, ""));
+
+  return i->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// As with std::map, an existing value is not replaced.
+std::pair <AttributeMap::iterator, bool> AttributeMap::insert (const value_type& value)
+{
+  discard ();
+  auto i = lower_bound (value.first);
+  if (i != _data.end () && i->first == value.first)
+    return std::pair <iterator, bool> (i, false);
+
+  return std::pair <iterator, bool> (_data.insert (i, value), true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+size_t AttributeMap::erase (const std::string& name)
+{
+  auto i = find (name);  // Discards the cache.
+  if (i == _data.end ())
+    return 0;
+
+  _data.erase (i);
+  return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Returns the element following the one erased, as with std::map.
+AttributeMap::iterator AttributeMap::erase (const_iterator i)
+{
+  discard ();
+  return _data.erase (i);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+time_t AttributeMap::get_date (const std::string& name) const
+{
+  const std::string* value;
+  auto c = lookup (name, value);
+  if (! c)
+    return 0;
+
+  if (! (c->flags & cached::date))
+  {
+    c->date_value = (time_t) strtoul (value->c_str (), nullptr, 10);
+    c->flags |= cached::date;
+  }
+
+  return c->date_value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+float AttributeMap::get_float (const std::string& name) const
+{
+  const std::string* value;
+  auto c = lookup (name, value);
+  if (! c)
+    return 0.0;
+
+  if (! (c->flags & cached::real))
+  {
+    c->real_value = strtof (value->c_str (), nullptr);
+    c->flags |= cached::real;
+  }
+
+  return c->real_value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The parse function may throw, in which case nothing is cached.
+int AttributeMap::get_enum (
+  const std::string& name,
+  int (*parse)(const std::string&),
+  int fallback) const
+{
+  const std::string* value;
+  auto c = lookup (name, value);
+  if (! c)
+    return fallback;
+
+  if (! (c->flags & cached::code))
+  {
+    c->code_value = parse (*value);
+    c->flags |= cached::code;
+  }
+
+  return c->code_value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool AttributeMap::get_flag (int bit, bool& value) const
+{
+  if (! (_known & (1u << bit)))
+    return false;
+
+  value = (_flags & (1u << bit)) != 0;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void AttributeMap::set_flag (int bit, bool value) const
+{
+  _known |= 1u << bit;
+  if (value)
+    _flags |= 1u << bit;
+  else
+    _flags &= ~(1u << bit);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Locates the cache entry for an attribute, and its string value.  Returns
+// nullptr if the attribute is absent.
+AttributeMap::cached* AttributeMap::lookup (
+  const std::string& name,
+  const std::string*& value) const
+{
+  auto i = lower_bound (name);
+  if (i == _data.end () || i->first != name)
+    return nullptr;
+
+  if (_cache.size () != _data.size ())
+    _cache.assign (_data.size (), cached ());
+
+  value = &i->second;
+  return &_cache[i - _data.begin ()];
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef INCLUDED_ATTRIBUTEMAP
+#define INCLUDED_ATTRIBUTEMAP
+
+#include <vector>
+#include <string>
+#include <time.h>
+
+// AttributeMap holds the attributes of a Task as a sorted, contiguous vector of
+// name/value pairs.  A task has few attributes, so a binary search over one
+// allocation beats a tree of separately allocated nodes.  The interface is the
+// subset of std::map that Task::data has always offered, and iteration is in
+// the same, sorted, order.
+//
+// Values may also be read as dates, numbers or enumerations, which are parsed
+// once and cached.  Boolean properties of the attributes as a whole, such as
+// Task virtual tags, may be memoized by bit number.  Any non-const access
+// discards the cache and memo, because it may be used to change a value.
+// Copies start with an empty cache.
+class AttributeMap
+{
+public:
+  using value_type     = std::pair <std::string, std::string>;
+  using iterator       = std::vector <value_type>::iterator;
+  using const_iterator = std::vector <value_type>::const_iterator;
+
+  // A run of adjacent attributes, for range-based for.
+  struct range
+  {
+    const_iterator first;
+    const_iterator last;
+    const_iterator begin () const    { return first; }
+    const_iterator end () const      { return last; }
+    size_t size () const             { return last - first; }
+    bool empty () const              { return first == last; }
+  };
+
+  AttributeMap () = default;
+  AttributeMap (const AttributeMap& other) : _data (other._data) {}
+  AttributeMap (AttributeMap&&);
+  AttributeMap& operator= (const AttributeMap&);
+  AttributeMap& operator= (AttributeMap&&);
+
+  iterator begin ()                { discard (); return _data.begin (); }
+  iterator end ()                  { return _data.end ();   }
+  const_iterator begin () const    { return _data.begin (); }
+  const_iterator end () const      { return _data.end ();   }
+  size_t size () const             { return _data.size ();  }
+  bool empty () const              { return _data.empty (); }
+  void clear ()                    { discard (); _data.clear (); }
+  size_t bytes () const;
+
+  iterator find (const std::string&);
+  const_iterator find (const std::string&) const;
+  size_t count (const std::string&) const;
+  range prefixed (const std::string&) const;
+  std::string& operator[] (const std::string&);
+  std::pair <iterator, bool> insert (const value_type&);
+  size_t erase (const std::string&);
+  iterator erase (const_iterator);
+
+  // Cached, typed values.  Absent attributes yield zero, or the fallback.
+  time_t get_date (const std::string&) const;
+  float get_float (const std::string&) const;
+  int get_enum (const std::string&, int (*)(const std::string&), int) const;
+
+  // Memoized properties, bits 0 to 31.  Returns false if the bit is unknown.
+  bool get_flag (int, bool&) const;
+  void set_flag (int, bool) const;
+
+  bool operator== (const AttributeMap& other) const { return _data == other._data; }
+  bool operator!= (const AttributeMap& other) const { return _data != other._data; }
+
+private:
+  struct cached
+  {
+    enum {date = 1, real = 2, code = 4};
+    int    flags {0};
+    time_t date_value {0};
+    float  real_value {0.0};
+    int    code_value {0};
+  };
+
+  iterator lower_bound (const std::string&);
+  const_iterator lower_bound (const std::string&) const;
+  cached* lookup (const std::string&, const std::string*&) const;
+  void discard ()                  { _cache.clear (); _known = _flags = 0; }
+
+private:
+  std::vector <value_type> _data {};
+  mutable std::vector <cached> _cache {};  // Parallel to _data, when used
+  mutable unsigned int _known {0};         // Memoized bits
+  mutable unsigned int _flags {0};         // Memoized values
+};
+
+#endif
+////////////////////////////////////////////////////////////////////////////////
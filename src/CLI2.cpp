@@ -26,6 +26,7 @@
 
 #include <cmake.h>
 #include <CLI2.h>
+#include <ParseCache.h>
 #include <sstream>
 #include <algorithm>
 #include <stdlib.h>
@@ -41,6 +42,18 @@ int CLI2::minimumMatchLength = 3;
 // Alias expansion limit. Any more indicates some kind of error.
 static int safetyValveDefault = 10;
 
+// Names of the tags, in the order of A2::Tag.
+static const char* tagNames[] =
+{
+  "BINARY", "CMD", "FILTER", "MODIFICATION", "MISCELLANEOUS", "RC", "CONFIG",
+  "ORIGINAL", "PLAIN", "QUOTED", "TERMINATED", "DEFAULT", "ASSUMED", "UNKNOWN",
+  "READONLY", "SHOWSID", "RUNSGC", "USESCONTEXT", "ALLOWSFILTER",
+  "ALLOWSMODIFICATIONS", "ALLOWSMISC"
+};
+
+// Attributes held in fields rather than the map, in the order of _fields bits.
+static const char* fieldNames[] = {"raw", "canonical", "name", "modifier", "sign"};
+
 ////////////////////////////////////////////////////////////////////////////////
 A2::A2 (const std::string& raw, Lexer::Type lextype)
 {
@@ -49,60 +62,86 @@ A2::A2 (const std::string& raw, Lexer::Type lextype)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-A2::A2 (const A2& other)
-: _lextype (other._lextype)
-, _tags (other._tags)
-, _attributes (other._attributes)
+bool A2::hasTag (Tag tag) const
 {
+  return _tags & (1u << (int) tag);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-A2& A2::operator= (const A2& other)
+void A2::tag (Tag tag)
 {
-  _lextype    = other._lextype;
-  _tags       = other._tags;
-  _attributes = other._attributes;
-  return *this;
+  if (! hasTag (tag))
+  {
+    _tags |= 1u << (int) tag;
+    _tag_order.push_back (tag);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-bool A2::hasTag (const std::string& tag) const
+void A2::unTag (Tag tag)
 {
-  return std::find (_tags.begin (), _tags.end (), tag) != _tags.end ();
+  if (hasTag (tag))
+  {
+    _tags &= ~(1u << (int) tag);
+    _tag_order.erase (std::find (_tag_order.begin (), _tag_order.end (), tag));
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void A2::tag (const std::string& tag)
+// The index in fieldNames of the field that holds an attribute, or -1 if the
+// attribute is in the map.
+int A2::fieldIndex (const std::string& name)
 {
-  if (! hasTag (tag))
-    _tags.push_back (tag);
+  switch (name[0])
+  {
+  case 'r': if (name == "raw")       return 0; break;
+  case 'c': if (name == "canonical") return 1; break;
+  case 'n': if (name == "name")      return 2; break;
+  case 'm': if (name == "modifier")  return 3; break;
+  case 's': if (name == "sign")      return 4; break;
+  }
+
+  return -1;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void A2::unTag (const std::string& tag)
+const std::string& A2::field (int index) const
 {
-  for (auto i = _tags.begin (); i != _tags.end (); ++i)
-    if (*i == tag)
-    {
-      _tags.erase (i);
-      break;
-    }
+  switch (index)
+  {
+  case 0:  return _raw;
+  case 1:  return _canonical;
+  case 2:  return _name;
+  case 3:  return _modifier;
+  default: return _sign;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // Accessor for attributes.
 void A2::attribute (const std::string& name, const std::string& value)
 {
-  _attributes[name] = value;
+  auto index = fieldIndex (name);
+  if (index == -1)
+    _attributes[name] = value;
+  else
+  {
+    const_cast <std::string&> (field (index)) = value;
+    _fields |= 1u << index;
 
-  if (name == "raw")
-    decompose ();
+    if (index == 0)
+      decompose ();
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // Accessor for attributes.
 const std::string A2::attribute (const std::string& name) const
 {
+  auto index = fieldIndex (name);
+  if (index != -1)
+    return field (index);
+
   // Prevent autovivification.
   auto i = _attributes.find (name);
   if (i != _attributes.end ())
@@ -114,11 +153,7 @@ const std::string A2::attribute (const std::string& name) const
 ////////////////////////////////////////////////////////////////////////////////
 const std::string A2::getToken () const
 {
-  auto i = _attributes.find ("canonical");
-  if (i == _attributes.end ())
-    i = _attributes.find ("raw");
-
-  return i->second;
+  return _fields & 2 ? _canonical : _raw;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -126,7 +161,7 @@ void A2::decompose ()
 {
   if (_lextype == Lexer::Type::tag)
   {
-    std::string raw = _attributes["raw"];
+    std::string raw = _raw;
     attribute ("name", raw.substr (1));
     attribute ("sign", raw.substr (0, 1));
   }
@@ -139,7 +174,7 @@ void A2::decompose ()
     std::string from;
     std::string to;
     std::string flags;
-    if (Lexer::decomposeSubstitution (_attributes["raw"], from, to, flags))
+    if (Lexer::decomposeSubstitution (_raw, from, to, flags))
     {
       attribute ("from",  from);
       attribute ("to",    to);
@@ -153,7 +188,7 @@ void A2::decompose ()
     std::string mod;
     std::string sep;
     std::string value;
-    if (Lexer::decomposePair (_attributes["raw"], name, mod, sep, value))
+    if (Lexer::decomposePair (_raw, name, mod, sep, value))
     {
       attribute ("name",      name);
       attribute ("modifier",  mod);
@@ -163,9 +198,9 @@ void A2::decompose ()
       if (name == "rc")
       {
         if (mod != "")
-          tag ("CONFIG");
+          tag (Tag::CONFIG);
         else
-          tag ("RC");
+          tag (Tag::RC);
       }
     }
   }
@@ -177,7 +212,7 @@ void A2::decompose ()
 
     std::string pattern;
     std::string flags;
-    if (Lexer::decomposePattern (_attributes["raw"], pattern, flags))
+    if (Lexer::decomposePattern (_raw, pattern, flags))
     {
       attribute ("pattern", pattern);
       attribute ("flags",   flags);
@@ -185,29 +220,101 @@ void A2::decompose ()
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Appends the argument to a parse cache entry.
+void A2::encode (std::string& output) const
+{
+  ParseCache::encode (output, format ((int) _lextype));
+
+  std::string tags;
+  for (auto& t : _tag_order)
+    tags += format ("{1} ", (int) t);
+  ParseCache::encode (output, tags);
+
+  ParseCache::encode (output, format ((int) _fields));
+  for (int i = 0; i < 5; ++i)
+    ParseCache::encode (output, field (i));
+
+  ParseCache::encode (output, format ((int) _attributes.size ()));
+  for (auto& a : _attributes)
+  {
+    ParseCache::encode (output, a.first);
+    ParseCache::encode (output, a.second);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Restores an argument from a parse cache entry, without decomposing it again.
+bool A2::decode (const std::string& input, std::string::size_type& cursor)
+{
+  std::string value;
+  if (! ParseCache::decode (input, cursor, value))
+    return false;
+  _lextype = (Lexer::Type) strtol (value.c_str (), nullptr, 10);
+
+  if (! ParseCache::decode (input, cursor, value))
+    return false;
+  _tags = 0;
+  _tag_order.clear ();
+  for (auto& t : split (value, ' '))
+    if (t != "")
+      tag ((Tag) strtol (t.c_str (), nullptr, 10));
+
+  if (! ParseCache::decode (input, cursor, value))
+    return false;
+  _fields = strtoul (value.c_str (), nullptr, 10);
+
+  if (! ParseCache::decode (input, cursor, _raw)       ||
+      ! ParseCache::decode (input, cursor, _canonical) ||
+      ! ParseCache::decode (input, cursor, _name)      ||
+      ! ParseCache::decode (input, cursor, _modifier)  ||
+      ! ParseCache::decode (input, cursor, _sign))
+    return false;
+
+  if (! ParseCache::decode (input, cursor, value))
+    return false;
+  _attributes.clear ();
+  for (auto count = strtol (value.c_str (), nullptr, 10); count > 0; --count)
+  {
+    std::string name;
+    if (! ParseCache::decode (input, cursor, name) ||
+        ! ParseCache::decode (input, cursor, value))
+      return false;
+
+    _attributes[name] = value;
+  }
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 const std::string A2::dump () const
 {
   auto output = Lexer::typeToString (_lextype);
 
-  // Dump attributes.
+  // Dump attributes, in name order, as the map held them all.
+  auto all = _attributes;
+  for (unsigned int i = 0; i < sizeof (fieldNames) / sizeof (fieldNames[0]); ++i)
+    if (_fields & (1u << i))
+      all[fieldNames[i]] = field (i);
+
   std::string atts;
-  for (const auto& a : _attributes)
+  for (const auto& a : all)
     atts += a.first + "='\033[33m" + a.second + "\033[0m' ";
 
   // Dump tags.
   std::string tags;
-  for (const auto& tag : _tags)
+  for (const auto& t : _tag_order)
   {
-         if (tag == "BINARY")        tags += "\033[1;37;44m"           + tag + "\033[0m ";
-    else if (tag == "CMD")           tags += "\033[1;37;46m"           + tag + "\033[0m ";
-    else if (tag == "FILTER")        tags += "\033[1;37;42m"           + tag + "\033[0m ";
-    else if (tag == "MODIFICATION")  tags += "\033[1;37;43m"           + tag + "\033[0m ";
-    else if (tag == "MISCELLANEOUS") tags += "\033[1;37;45m"           + tag + "\033[0m ";
-    else if (tag == "RC")            tags += "\033[1;37;41m"           + tag + "\033[0m ";
-    else if (tag == "CONFIG")        tags += "\033[1;37;101m"          + tag + "\033[0m ";
-    else if (tag == "?")             tags += "\033[38;5;255;48;5;232m" + tag + "\033[0m ";
-    else                             tags += "\033[32m"                + tag + "\033[0m ";
+    std::string tag = tagNames[(int) t];
+         if (t == Tag::BINARY)        tags += "\033[1;37;44m"           + tag + "\033[0m ";
+    else if (t == Tag::CMD)           tags += "\033[1;37;46m"           + tag + "\033[0m ";
+    else if (t == Tag::FILTER)        tags += "\033[1;37;42m"           + tag + "\033[0m ";
+    else if (t == Tag::MODIFICATION)  tags += "\033[1;37;43m"           + tag + "\033[0m ";
+    else if (t == Tag::MISCELLANEOUS) tags += "\033[1;37;45m"           + tag + "\033[0m ";
+    else if (t == Tag::RC)            tags += "\033[1;37;41m"           + tag + "\033[0m ";
+    else if (t == Tag::CONFIG)        tags += "\033[1;37;101m"          + tag + "\033[0m ";
+    else                              tags += "\033[32m"                + tag + "\033[0m ";
   }
 
   return output + ' ' + atts + tags;
@@ -325,7 +432,7 @@ void CLI2::entity (const std::string& category, const std::string& name)
 void CLI2::add (const std::string& argument)
 {
   A2 arg (Lexer::trim (argument), Lexer::Type::word);
-  arg.tag ("ORIGINAL");
+  arg.tag (A2::Tag::ORIGINAL);
   _original_args.push_back (arg);
 
   // Adding a new argument invalidates prior analysis.
@@ -363,7 +470,7 @@ void CLI2::handleArg0 ()
   // need special handling.
   auto raw = _original_args[0].attribute ("raw");
   A2 a (raw, Lexer::Type::word);
-  a.tag ("BINARY");
+  a.tag (A2::Tag::BINARY);
 
   std::string basename = "task";
   auto slash = raw.rfind ('/');
@@ -415,12 +522,12 @@ void CLI2::lexArguments ()
 
       A2 a (_original_args[i].attribute ("raw"), type);
       if (terminated)
-        a.tag ("TERMINATED");
+        a.tag (A2::Tag::TERMINATED);
       if (quoted)
-        a.tag ("QUOTED");
+        a.tag (A2::Tag::QUOTED);
 
-      if (_original_args[i].hasTag ("ORIGINAL"))
-        a.tag ("ORIGINAL");
+      if (_original_args[i].hasTag (A2::Tag::ORIGINAL))
+        a.tag (A2::Tag::ORIGINAL);
 
       _args.push_back (a);
     }
@@ -439,10 +546,10 @@ void CLI2::lexArguments ()
         Lexer::dequote (word);
         A2 unknown (word, Lexer::Type::word);
         if (lex.wasQuoted (_original_args[i].attribute ("raw")))
-          unknown.tag ("QUOTED");
+          unknown.tag (A2::Tag::QUOTED);
 
-        if (_original_args[i].hasTag ("ORIGINAL"))
-          unknown.tag ("ORIGINAL");
+        if (_original_args[i].hasTag (A2::Tag::ORIGINAL))
+          unknown.tag (A2::Tag::ORIGINAL);
 
         _args.push_back (unknown);
       }
@@ -451,13 +558,13 @@ void CLI2::lexArguments ()
       else
       {
         A2 unknown (_original_args[i].attribute ("raw"), Lexer::Type::word);
-        unknown.tag ("UNKNOWN");
+        unknown.tag (A2::Tag::UNKNOWN);
 
         if (lex.wasQuoted (_original_args[i].attribute ("raw")))
-          unknown.tag ("QUOTED");
+          unknown.tag (A2::Tag::QUOTED);
 
-        if (_original_args[i].hasTag ("ORIGINAL"))
-          unknown.tag ("ORIGINAL");
+        if (_original_args[i].hasTag (A2::Tag::ORIGINAL))
+          unknown.tag (A2::Tag::ORIGINAL);
 
         _args.push_back (unknown);
       }
@@ -510,6 +617,40 @@ void CLI2::demotion ()
     Context::getContext ().debug (dump ("CLI2::analyze demotion"));
 }
 
+////////////////////////////////////////////////////////////////////////////////
+std::string CLI2::encodeArgs (const std::vector <A2>& args) const
+{
+  std::string output;
+  ParseCache::encode (output, format ((int) args.size ()));
+  for (auto& a : args)
+    a.encode (output);
+
+  return output;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CLI2::decodeArgs (
+  const std::string& input,
+  std::string::size_type& cursor,
+  std::vector <A2>& args) const
+{
+  std::string count;
+  if (! ParseCache::decode (input, cursor, count))
+    return false;
+
+  args.clear ();
+  for (auto n = strtol (count.c_str (), nullptr, 10); n > 0; --n)
+  {
+    A2 a ("", Lexer::Type::word);
+    if (! a.decode (input, cursor))
+      return false;
+
+    args.push_back (a);
+  }
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Intended to be called after ::add() to perform the final analysis.
 void CLI2::analyze ()
@@ -517,6 +658,27 @@ void CLI2::analyze ()
   if (Context::getContext ().config.getInteger ("debug.parser") >= 2)
     Context::getContext ().debug (dump ("CLI2::analyze"));
 
+  // The same arguments, with the same configuration, are analyzed the same way.
+  std::string key;
+  auto stamp = ParseCache::stamp ();
+  if (stamp != "")
+  {
+    key = "analyze\n" + stamp + encodeArgs (_original_args);
+
+    std::string cached;
+    std::string::size_type cursor = 0;
+    std::vector <A2> original;
+    std::vector <A2> args;
+    if (ParseCache::get (key, cached)             &&
+        decodeArgs (cached, cursor, original)     &&
+        decodeArgs (cached, cursor, args))
+    {
+      _original_args = original;
+      _args = args;
+      return;
+    }
+  }
+
   // Process _original_args.
   _args.clear ();
   handleArg0 ();
@@ -537,6 +699,9 @@ void CLI2::analyze ()
   // Determine arg types: FILTER, MODIFICATION, MISCELLANEOUS.
   categorizeArgs ();
   parenthesizeOriginalFilter ();
+
+  if (key != "")
+    ParseCache::put (key, encodeArgs (_original_args) + encodeArgs (_args));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -616,24 +781,68 @@ void CLI2::prepareFilter ()
   _uuid_list.clear ();
   _context_filter_added = false;
 
-  // Remove all the syntactic sugar for FILTERs.
-  lexFilterArgs ();
-  findIDs ();
-  findUUIDs ();
-  insertIDExpr ();
-  desugarFilterPlainArgs ();
-  findStrayModifications ();
-  desugarFilterTags ();
-  desugarFilterAttributes ();
-  desugarFilterPatterns ();
-  insertJunctions ();                 // Deliberately after all desugar calls.
+  // The desugared filter depends only on the arguments and configuration.
+  std::string key;
+  auto stamp = ParseCache::stamp ();
+  if (stamp != "")
+    key = "filter\n" + stamp + encodeArgs (_args);
+
+  std::string cached;
+  std::string::size_type cursor = 0;
+  std::vector <A2> args;
+  std::string ranges;
+  std::string uuids;
+  if (key != ""                                   &&
+      ParseCache::get (key, cached)               &&
+      decodeArgs (cached, cursor, args)           &&
+      ParseCache::decode (cached, cursor, ranges) &&
+      ParseCache::decode (cached, cursor, uuids))
+  {
+    _args = args;
+
+    auto bounds = split (ranges, ' ');
+    for (unsigned int i = 0; i + 1 < bounds.size (); i += 2)
+      _id_ranges.push_back (std::pair <std::string, std::string> (bounds[i], bounds[i + 1]));
+
+    for (auto& uuid : split (uuids, ' '))
+      if (uuid != "")
+        _uuid_list.push_back (uuid);
+  }
+  else
+  {
+    // Remove all the syntactic sugar for FILTERs.
+    lexFilterArgs ();
+    findIDs ();
+    findUUIDs ();
+    insertIDExpr ();
+    desugarFilterPlainArgs ();
+    findStrayModifications ();
+    desugarFilterTags ();
+    desugarFilterAttributes ();
+    desugarFilterPatterns ();
+    insertJunctions ();                 // Deliberately after all desugar calls.
+
+    if (key != "")
+    {
+      for (auto& range : _id_ranges)
+        ranges += range.first + ' ' + range.second + ' ';
+
+      for (auto& uuid : _uuid_list)
+        uuids += uuid + ' ';
+
+      cached = encodeArgs (_args);
+      ParseCache::encode (cached, ranges);
+      ParseCache::encode (cached, uuids);
+      ParseCache::put (key, cached);
+    }
+  }
 
   if (Context::getContext ().verbose ("filter"))
   {
     std::string combined;
     for (const auto& a : _args)
     {
-      if (a.hasTag ("FILTER"))
+      if (a.hasTag (A2::Tag::FILTER))
       {
         if (combined != "")
           combined += ' ';
@@ -653,7 +862,7 @@ const std::vector <std::string> CLI2::getWords ()
 {
   std::vector <std::string> words;
   for (const auto& a : _args)
-    if (a.hasTag ("MISCELLANEOUS"))
+    if (a.hasTag (A2::Tag::MISCELLANEOUS))
       words.push_back (a.attribute ("raw"));
 
   if (Context::getContext ().config.getInteger ("debug.parser") >= 2)
@@ -714,7 +923,7 @@ std::string CLI2::getBinary () const
 std::string CLI2::getCommand (bool canonical) const
 {
   for (const auto& a : _args)
-    if (a.hasTag ("CMD"))
+    if (a.hasTag (A2::Tag::CMD))
       return a.attribute (canonical ? "canonical" : "raw");
 
   return "";
@@ -735,7 +944,7 @@ const std::string CLI2::dump (const std::string& title) const
     if (i != _original_args.begin ())
       out << ' ';
 
-    if (i->hasTag ("ORIGINAL"))
+    if (i->hasTag (A2::Tag::ORIGINAL))
       out << colorArgs.colorize (i->attribute ("raw"));
     else
       out << colorFilter.colorize (i->attribute ("raw"));
@@ -793,7 +1002,7 @@ void CLI2::aliasExpansion ()
     for (const auto& i : _args)
     {
       raw = i.attribute ("raw");
-      if (i.hasTag ("TERMINATED"))
+      if (i.hasTag (A2::Tag::TERMINATED))
       {
         reconstructed.push_back (i);
       }
@@ -909,15 +1118,15 @@ void CLI2::categorizeArgs ()
       continue;
 
     // Record that the command has been found, it affects behavior.
-    if (a.hasTag ("CMD"))
+    if (a.hasTag (A2::Tag::CMD))
     {
       afterCommand = true;
     }
 
     // Skip admin args.
-    else if (a.hasTag ("BINARY") ||
-             a.hasTag ("RC")     ||
-             a.hasTag ("CONFIG"))
+    else if (a.hasTag (A2::Tag::BINARY) ||
+             a.hasTag (A2::Tag::RC)     ||
+             a.hasTag (A2::Tag::CONFIG))
     {
       // NOP.
     }
@@ -946,7 +1155,7 @@ void CLI2::categorizeArgs ()
              ! cmd->accepts_modifications () &&
                cmd->accepts_miscellaneous ())
     {
-      a.tag ("MISCELLANEOUS");
+      a.tag (A2::Tag::MISCELLANEOUS);
       changes = true;
     }
     else if (cmd                             &&
@@ -954,7 +1163,7 @@ void CLI2::categorizeArgs ()
                cmd->accepts_modifications () &&
              ! cmd->accepts_miscellaneous ())
     {
-      a.tag ("MODIFICATION");
+      a.tag (A2::Tag::MODIFICATION);
       changes = true;
     }
     else if (cmd                             &&
@@ -970,7 +1179,7 @@ void CLI2::categorizeArgs ()
              ! cmd->accepts_modifications () &&
              ! cmd->accepts_miscellaneous ())
     {
-      a.tag ("FILTER");
+      a.tag (A2::Tag::FILTER);
       changes = true;
     }
     else if (cmd                             &&
@@ -979,9 +1188,9 @@ void CLI2::categorizeArgs ()
                cmd->accepts_miscellaneous ())
     {
       if (!afterCommand)
-        a.tag ("FILTER");
+        a.tag (A2::Tag::FILTER);
       else
-        a.tag ("MISCELLANEOUS");
+        a.tag (A2::Tag::MISCELLANEOUS);
 
       changes = true;
     }
@@ -991,9 +1200,9 @@ void CLI2::categorizeArgs ()
              ! cmd->accepts_miscellaneous ())
     {
       if (!afterCommand)
-        a.tag ("FILTER");
+        a.tag (A2::Tag::FILTER);
       else
-        a.tag ("MODIFICATION");
+        a.tag (A2::Tag::MODIFICATION);
 
       changes = true;
     }
@@ -1039,8 +1248,8 @@ void CLI2::parenthesizeOriginalFilter ()
   unsigned int lastOriginalFilter = 0;
   for (unsigned int i = 1; i < _args.size (); ++i)
   {
-    if (_args[i].hasTag ("FILTER") &&
-        _args[i].hasTag ("ORIGINAL"))
+    if (_args[i].hasTag (A2::Tag::FILTER) &&
+        _args[i].hasTag (A2::Tag::ORIGINAL))
     {
       if (firstOriginalFilter == 0)
         firstOriginalFilter = i;
@@ -1059,8 +1268,8 @@ void CLI2::parenthesizeOriginalFilter ()
       if (i == firstOriginalFilter)
       {
         A2 openParen ("(", Lexer::Type::op);
-        openParen.tag ("ORIGINAL");
-        openParen.tag ("FILTER");
+        openParen.tag (A2::Tag::ORIGINAL);
+        openParen.tag (A2::Tag::FILTER);
         reconstructed.push_back (openParen);
       }
 
@@ -1069,8 +1278,8 @@ void CLI2::parenthesizeOriginalFilter ()
       if (i == lastOriginalFilter)
       {
         A2 closeParen (")", Lexer::Type::op);
-        closeParen.tag ("ORIGINAL");
-        closeParen.tag ("FILTER");
+        closeParen.tag (A2::Tag::ORIGINAL);
+        closeParen.tag (A2::Tag::FILTER);
         reconstructed.push_back (closeParen);
       }
     }
@@ -1106,17 +1315,17 @@ bool CLI2::findCommand ()
       continue;
 
     a.attribute ("canonical", canonical);
-    a.tag ("CMD");
+    a.tag (A2::Tag::CMD);
 
     // Apply command DNA as tags.
     Command* command = Context::getContext ().commands[canonical];
-    if (command->read_only ())             a.tag ("READONLY");
-    if (command->displays_id ())           a.tag ("SHOWSID");
-    if (command->needs_gc ())              a.tag ("RUNSGC");
-    if (command->uses_context ())          a.tag ("USESCONTEXT");
-    if (command->accepts_filter ())        a.tag ("ALLOWSFILTER");
-    if (command->accepts_modifications ()) a.tag ("ALLOWSMODIFICATIONS");
-    if (command->accepts_miscellaneous ()) a.tag ("ALLOWSMISC");
+    if (command->read_only ())             a.tag (A2::Tag::READONLY);
+    if (command->displays_id ())           a.tag (A2::Tag::SHOWSID);
+    if (command->needs_gc ())              a.tag (A2::Tag::RUNSGC);
+    if (command->uses_context ())          a.tag (A2::Tag::USESCONTEXT);
+    if (command->accepts_filter ())        a.tag (A2::Tag::ALLOWSFILTER);
+    if (command->accepts_modifications ()) a.tag (A2::Tag::ALLOWSMODIFICATIONS);
+    if (command->accepts_miscellaneous ()) a.tag (A2::Tag::ALLOWSMISC);
 
     if (Context::getContext ().config.getInteger ("debug.parser") >= 2)
       Context::getContext ().debug (dump ("CLI2::analyze findCommand"));
@@ -1154,22 +1363,22 @@ void CLI2::desugarFilterTags ()
   for (const auto& a : _args)
   {
     if (a._lextype == Lexer::Type::tag &&
-        a.hasTag ("FILTER"))
+        a.hasTag (A2::Tag::FILTER))
     {
       changes = true;
 
       A2 left ("tags", Lexer::Type::dom);
-      left.tag ("FILTER");
+      left.tag (A2::Tag::FILTER);
       reconstructed.push_back (left);
 
       std::string raw = a.attribute ("raw");
 
       A2 op (raw[0] == '+' ? "_hastag_" : "_notag_", Lexer::Type::op);
-      op.tag ("FILTER");
+      op.tag (A2::Tag::FILTER);
       reconstructed.push_back (op);
 
       A2 right ("" + raw.substr (1) + "", Lexer::Type::string);
-      right.tag ("FILTER");
+      right.tag (A2::Tag::FILTER);
       reconstructed.push_back (right);
     }
     else
@@ -1196,10 +1405,10 @@ void CLI2::findStrayModifications ()
   {
     for (auto& a : _args)
     {
-      if (a.hasTag ("FILTER"))
+      if (a.hasTag (A2::Tag::FILTER))
       {
-        a.unTag ("FILTER");
-        a.tag ("MODIFICATION");
+        a.unTag (A2::Tag::FILTER);
+        a.tag (A2::Tag::MODIFICATION);
         changes = true;
       }
     }
@@ -1219,7 +1428,7 @@ void CLI2::desugarFilterAttributes ()
   for (auto& a : _args)
   {
     if (a._lextype == Lexer::Type::pair &&
-        a.hasTag ("FILTER"))
+        a.hasTag (A2::Tag::FILTER))
     {
       std::string raw   = a.attribute ("raw");
       std::string name  = a.attribute ("name");
@@ -1267,15 +1476,15 @@ void CLI2::desugarFilterAttributes ()
           evalSupported = false;
 
         A2 lhs (name, Lexer::Type::dom);
-        lhs.tag ("FILTER");
+        lhs.tag (A2::Tag::FILTER);
         lhs.attribute ("canonical", canonical);
         lhs.attribute ("modifier", mod);
 
         A2 op ("", Lexer::Type::op);
-        op.tag ("FILTER");
+        op.tag (A2::Tag::FILTER);
 
         A2 rhs ("", values[0]._lextype);
-        rhs.tag ("FILTER");
+        rhs.tag (A2::Tag::FILTER);
 
         // Special case for '<name>:<value>'.
         if (mod == "")
@@ -1422,21 +1631,21 @@ void CLI2::desugarFilterPatterns ()
   for (const auto& a : _args)
   {
     if (a._lextype == Lexer::Type::pattern &&
-        a.hasTag ("FILTER"))
+        a.hasTag (A2::Tag::FILTER))
     {
       changes = true;
 
       A2 lhs ("description", Lexer::Type::dom);
-      lhs.tag ("FILTER");
+      lhs.tag (A2::Tag::FILTER);
       reconstructed.push_back (lhs);
 
       A2 op ("~", Lexer::Type::op);
-      op.tag ("FILTER");
+      op.tag (A2::Tag::FILTER);
       reconstructed.push_back (op);
 
       A2 rhs (a.attribute ("pattern"), Lexer::Type::string);
       rhs.attribute ("flags", a.attribute ("flags"));
-      rhs.tag ("FILTER");
+      rhs.tag (A2::Tag::FILTER);
       reconstructed.push_back (rhs);
     }
     else
@@ -1472,7 +1681,7 @@ void CLI2::findIDs ()
 
     for (const auto& a : _args)
     {
-      if (a.hasTag ("FILTER"))
+      if (a.hasTag (A2::Tag::FILTER))
       {
         ++filterCount;
 
@@ -1522,7 +1731,7 @@ void CLI2::findIDs ()
     {
       for (auto& a : _args)
       {
-        if (a.hasTag ("MODIFICATION"))
+        if (a.hasTag (A2::Tag::MODIFICATION))
         {
           std::string raw = a.attribute ("raw");
 
@@ -1534,14 +1743,14 @@ void CLI2::findIDs ()
               raw.find ('-') == std::string::npos)
           {
             changes = true;
-            a.unTag ("MODIFICATION");
-            a.tag ("FILTER");
+            a.unTag (A2::Tag::MODIFICATION);
+            a.tag (A2::Tag::FILTER);
             _id_ranges.push_back (std::pair <std::string, std::string> (raw, raw));
           }
           else if (a._lextype == Lexer::Type::set)
           {
-            a.unTag ("MODIFICATION");
-            a.tag ("FILTER");
+            a.unTag (A2::Tag::MODIFICATION);
+            a.tag (A2::Tag::FILTER);
 
             // Split the ID list into elements.
             auto elements = split (raw, ',');
@@ -1567,12 +1776,12 @@ void CLI2::findIDs ()
     std::vector <A2> reconstructed;
     for (const auto& a : _args)
     {
-      if (a.hasTag ("FILTER") &&
+      if (a.hasTag (A2::Tag::FILTER) &&
           a._lextype == Lexer::Type::number)
       {
         changes = true;
         A2 pair ("id:" + a.attribute ("raw"), Lexer::Type::pair);
-        pair.tag ("FILTER");
+        pair.tag (A2::Tag::FILTER);
         pair.decompose ();
         reconstructed.push_back (pair);
       }
@@ -1599,7 +1808,7 @@ void CLI2::findUUIDs ()
     for (const auto& a : _args)
     {
       if (a._lextype == Lexer::Type::uuid &&
-          a.hasTag ("FILTER"))
+          a.hasTag (A2::Tag::FILTER))
       {
         changes = true;
         _uuid_list.push_back (a.attribute ("raw"));
@@ -1611,11 +1820,11 @@ void CLI2::findUUIDs ()
       for (auto& a : _args)
       {
         if (a._lextype == Lexer::Type::uuid &&
-            a.hasTag ("MODIFICATION"))
+            a.hasTag (A2::Tag::MODIFICATION))
         {
           changes = true;
-          a.unTag ("MODIFICATION");
-          a.tag ("FILTER");
+          a.unTag (A2::Tag::MODIFICATION);
+          a.tag (A2::Tag::FILTER);
           _uuid_list.push_back (a.attribute ("raw"));
         }
       }
@@ -1628,12 +1837,12 @@ void CLI2::findUUIDs ()
     std::vector <A2> reconstructed;
     for (const auto& a : _args)
     {
-      if (a.hasTag ("FILTER") &&
+      if (a.hasTag (A2::Tag::FILTER) &&
           a._lextype == Lexer::Type::uuid)
       {
         changes = true;
         A2 pair ("uuid:" + a.attribute ("raw"), Lexer::Type::pair);
-        pair.tag ("FILTER");
+        pair.tag (A2::Tag::FILTER);
         pair.decompose ();
         reconstructed.push_back (pair);
       }
@@ -1669,7 +1878,7 @@ void CLI2::insertIDExpr ()
     if ((a._lextype == Lexer::Type::set ||
          a._lextype == Lexer::Type::number ||
          a._lextype == Lexer::Type::uuid) &&
-        a.hasTag ("FILTER"))
+        a.hasTag (A2::Tag::FILTER))
     {
       if (! foundID)
       {
@@ -1692,21 +1901,21 @@ void CLI2::insertIDExpr ()
         //   )
 
         // Building block operators.
-        A2 openParen  ("(",   Lexer::Type::op);  openParen.tag  ("FILTER");
-        A2 closeParen (")",   Lexer::Type::op);  closeParen.tag ("FILTER");
-        A2 opOr       ("or",  Lexer::Type::op);  opOr.tag       ("FILTER");
-        A2 opAnd      ("and", Lexer::Type::op);  opAnd.tag      ("FILTER");
-        A2 opSimilar  ("=",   Lexer::Type::op);  opSimilar.tag  ("FILTER");
-        A2 opEqual    ("==",  Lexer::Type::op);  opEqual.tag    ("FILTER");
-        A2 opGTE      (">=",  Lexer::Type::op);  opGTE.tag      ("FILTER");
-        A2 opLTE      ("<=",  Lexer::Type::op);  opLTE.tag      ("FILTER");
+        A2 openParen  ("(",   Lexer::Type::op);  openParen.tag  (A2::Tag::FILTER);
+        A2 closeParen (")",   Lexer::Type::op);  closeParen.tag (A2::Tag::FILTER);
+        A2 opOr       ("or",  Lexer::Type::op);  opOr.tag       (A2::Tag::FILTER);
+        A2 opAnd      ("and", Lexer::Type::op);  opAnd.tag      (A2::Tag::FILTER);
+        A2 opSimilar  ("=",   Lexer::Type::op);  opSimilar.tag  (A2::Tag::FILTER);
+        A2 opEqual    ("==",  Lexer::Type::op);  opEqual.tag    (A2::Tag::FILTER);
+        A2 opGTE      (">=",  Lexer::Type::op);  opGTE.tag      (A2::Tag::FILTER);
+        A2 opLTE      ("<=",  Lexer::Type::op);  opLTE.tag      (A2::Tag::FILTER);
 
         // Building block attributes.
         A2 argID ("id", Lexer::Type::dom);
-        argID.tag ("FILTER");
+        argID.tag (A2::Tag::FILTER);
 
         A2 argUUID ("uuid", Lexer::Type::dom);
-        argUUID.tag ("FILTER");
+        argUUID.tag (A2::Tag::FILTER);
 
         reconstructed.push_back (openParen);
 
@@ -1723,7 +1932,7 @@ void CLI2::insertIDExpr ()
             reconstructed.push_back (opEqual);
 
             A2 value (r->first, Lexer::Type::number);
-            value.tag ("FILTER");
+            value.tag (A2::Tag::FILTER);
             reconstructed.push_back (value);
 
             reconstructed.push_back (closeParen);
@@ -1743,7 +1952,7 @@ void CLI2::insertIDExpr ()
             reconstructed.push_back (opGTE);
 
             A2 startValue ((ascending ? r->first : r->second), Lexer::Type::number);
-            startValue.tag ("FILTER");
+            startValue.tag (A2::Tag::FILTER);
             reconstructed.push_back (startValue);
 
             reconstructed.push_back (opAnd);
@@ -1751,7 +1960,7 @@ void CLI2::insertIDExpr ()
             reconstructed.push_back (opLTE);
 
             A2 endValue ((ascending ? r->second : r->first), Lexer::Type::number);
-            endValue.tag ("FILTER");
+            endValue.tag (A2::Tag::FILTER);
             reconstructed.push_back (endValue);
 
             reconstructed.push_back (closeParen);
@@ -1774,7 +1983,7 @@ void CLI2::insertIDExpr ()
           reconstructed.push_back (opSimilar);
 
           A2 value (*u, Lexer::Type::string);
-          value.tag ("FILTER");
+          value.tag (A2::Tag::FILTER);
           reconstructed.push_back (value);
 
           reconstructed.push_back (closeParen);
@@ -1808,7 +2017,7 @@ void CLI2::lexFilterArgs ()
   for (const auto& a : _args)
   {
     if (a._lextype == Lexer::Type::word &&
-        a.hasTag ("FILTER"))
+        a.hasTag (A2::Tag::FILTER))
     {
       changes = true;
 
@@ -1818,7 +2027,7 @@ void CLI2::lexFilterArgs ()
       while (lex.token (lexeme, type))
       {
         A2 extra (lexeme, type);
-        extra.tag ("FILTER");
+        extra.tag (A2::Tag::FILTER);
         reconstructed.push_back (extra);
       }
     }
@@ -1867,7 +2076,7 @@ void CLI2::desugarFilterPlainArgs ()
         (prev->_lextype == Lexer::Type::identifier ||  // candidate
          prev->_lextype == Lexer::Type::word)      &&  // candidate
 
-        prev->hasTag ("FILTER")                    &&  // candidate
+        prev->hasTag (A2::Tag::FILTER)                    &&  // candidate
 
         (a._lextype != Lexer::Type::op             ||  // argY
          raw == "("                                ||
@@ -1876,7 +2085,7 @@ void CLI2::desugarFilterPlainArgs ()
          raw == "or"                               ||
          raw == "xor"))
     {
-      prev->tag ("PLAIN");
+      prev->tag (A2::Tag::PLAIN);
     }
 
     prevprev = prev;
@@ -1897,9 +2106,9 @@ void CLI2::desugarFilterPlainArgs ()
       (last._lextype == Lexer::Type::identifier    ||  // candidate
        last._lextype == Lexer::Type::word)         &&  // candidate
 
-      last.hasTag ("FILTER"))                          // candidate
+      last.hasTag (A2::Tag::FILTER))                          // candidate
   {
-    last.tag ("PLAIN");
+    last.tag (A2::Tag::PLAIN);
   }
 
   // Walk the list again, upgrading PLAIN args.
@@ -1907,26 +2116,26 @@ void CLI2::desugarFilterPlainArgs ()
   std::vector <A2> reconstructed;
   for (const auto& a : _args)
   {
-    if (a.hasTag ("PLAIN"))
+    if (a.hasTag (A2::Tag::PLAIN))
     {
       changes = true;
 
       A2 lhs ("description", Lexer::Type::dom);
       lhs.attribute ("canonical", "description");
-      lhs.tag ("FILTER");
-      lhs.tag ("PLAIN");
+      lhs.tag (A2::Tag::FILTER);
+      lhs.tag (A2::Tag::PLAIN);
       reconstructed.push_back (lhs);
 
       A2 op ("~", Lexer::Type::op);
-      op.tag ("FILTER");
-      op.tag ("PLAIN");
+      op.tag (A2::Tag::FILTER);
+      op.tag (A2::Tag::PLAIN);
       reconstructed.push_back (op);
 
       std::string word = a.attribute ("raw");
       Lexer::dequote (word);
       A2 rhs (word, Lexer::Type::string);
-      rhs.tag ("FILTER");
-      rhs.tag ("PLAIN");
+      rhs.tag (A2::Tag::FILTER);
+      rhs.tag (A2::Tag::PLAIN);
       reconstructed.push_back (rhs);
     }
     else
@@ -1959,7 +2168,7 @@ void CLI2::insertJunctions ()
 
   for (auto a = _args.begin (); a != _args.end (); ++a)
   {
-    if (a->hasTag ("FILTER"))
+    if (a->hasTag (A2::Tag::FILTER))
     {
       // The prev iterator should be the first FILTER arg.
       if (prev == _args.begin ())
@@ -1974,7 +2183,7 @@ void CLI2::insertJunctions ()
             (prev->attribute ("raw") == ")"    && a->attribute ("raw") == "("))
         {
           A2 opOr ("and", Lexer::Type::op);
-          opOr.tag ("FILTER");
+          opOr.tag (A2::Tag::FILTER);
           reconstructed.push_back (opOr);
           changes = true;
         }
@@ -2017,7 +2226,7 @@ void CLI2::defaultCommand ()
   {
     std::string raw = a.attribute ("raw");
 
-    if (a.hasTag ("CMD"))
+    if (a.hasTag (A2::Tag::CMD))
       found_command = true;
 
     if (a._lextype == Lexer::Type::uuid ||
@@ -2050,7 +2259,7 @@ void CLI2::defaultCommand ()
           reconstructedOriginals.push_back (A2 (lexeme, type));
 
           A2 cmd (lexeme, type);
-          cmd.tag ("DEFAULT");
+          cmd.tag (A2::Tag::DEFAULT);
           reconstructed.push_back (cmd);
         }
 
@@ -2068,7 +2277,7 @@ void CLI2::defaultCommand ()
     else
     {
       A2 info ("information", Lexer::Type::word);
-      info.tag ("ASSUMED");
+      info.tag (A2::Tag::ASSUMED);
       _args.push_back (info);
       changes = true;
     }
@@ -2099,7 +2308,7 @@ std::vector <A2> CLI2::lexExpression (const std::string& expression)
   while (lex.token (lexeme, type))
   {
     A2 token (lexeme, type);
-    token.tag ("FILTER");
+    token.tag (A2::Tag::FILTER);
     lexed.push_back (token);
   }
 
@@ -2108,9 +2317,9 @@ std::vector <A2> CLI2::lexExpression (const std::string& expression)
   if (lexed.size () > 1)
   {
     A2 openParen  ("(", Lexer::Type::op);
-    openParen.tag ("FILTER");
+    openParen.tag (A2::Tag::FILTER);
     A2 closeParen (")", Lexer::Type::op);
-    closeParen.tag ("FILTER");
+    closeParen.tag (A2::Tag::FILTER);
 
     lexed.insert (lexed.begin (), openParen);
     lexed.push_back (closeParen);
@@ -36,22 +36,43 @@
 class A2
 {
 public:
+  // Argument tags, each a bit in _tags.
+  enum class Tag
+  {
+    BINARY, CMD, FILTER, MODIFICATION, MISCELLANEOUS, RC, CONFIG, ORIGINAL,
+    PLAIN, QUOTED, TERMINATED, DEFAULT, ASSUMED, UNKNOWN, READONLY, SHOWSID,
+    RUNSGC, USESCONTEXT, ALLOWSFILTER, ALLOWSMODIFICATIONS, ALLOWSMISC
+  };
+
   A2 (const std::string&, Lexer::Type);
-  A2 (const A2&);
-  A2& operator= (const A2&);
-  bool hasTag (const std::string&) const;
-  void tag (const std::string&);
-  void unTag (const std::string&);
+  A2 (const A2&) = default;
+  A2& operator= (const A2&) = default;
+  bool hasTag (Tag) const;
+  void tag (Tag);
+  void unTag (Tag);
   void attribute (const std::string&, const std::string&);
   const std::string attribute (const std::string&) const;
   const std::string getToken () const;
   const std::string dump () const;
   void decompose ();
+  void encode (std::string&) const;
+  bool decode (const std::string&, std::string::size_type&);
+
+private:
+  static int fieldIndex (const std::string&);
+  const std::string& field (int) const;
 
 public:
   Lexer::Type                         _lextype     {Lexer::Type::word};
-  std::vector <std::string>           _tags        {};
-  std::map <std::string, std::string> _attributes  {};
+  unsigned int                        _tags        {0};
+  std::vector <Tag>                   _tag_order   {};   // For dump
+  std::string                         _raw         {};
+  std::string                         _canonical   {};
+  std::string                         _name        {};
+  std::string                         _modifier    {};
+  std::string                         _sign        {};
+  unsigned int                        _fields      {0};  // Which are set
+  std::map <std::string, std::string> _attributes  {};   // All others
 };
 
 // Represents the command line.
@@ -103,6 +124,8 @@ private:
   void insertJunctions ();
   void defaultCommand ();
   std::vector <A2> lexExpression (const std::string&);
+  std::string encodeArgs (const std::vector <A2>&) const;
+  bool decodeArgs (const std::string&, std::string::size_type&, std::vector <A2>&) const;
 
 public:
   std::multimap <std::string, std::string>           _entities             {};
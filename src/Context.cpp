@@ -36,13 +36,19 @@
 #include <string.h>
 #include <unistd.h>
 #include <FS.h>
+#include <JSON.h>
 #include <Eval.h>
 #include <Variant.h>
 #include <Datetime.h>
+#include <Trace.h>
+#include <ReportCache.h>
+#include <CmdCustom.h>
+#include <Allocations.h>
 #include <Duration.h>
 #include <shared.h>
 #include <format.h>
 #include <main.h>
+#include <util.h>
 
 #ifdef HAVE_COMMIT
 #include <commit.h>
@@ -72,9 +78,28 @@ std::string configurationDefaults =
   "# Files\n"
   "data.location=~/.task\n"
   "locking=1                                      # Use file-level locking\n"
+  "data.append=0                                  # Additions are appended under a shared lock, concurrently\n"
+  "data.atomic=0                                  # Commit all data files under one lock, with fsync and rename\n"
+  "data.backlog=1                                 # Record changes for sync, even with no taskd.server\n"
+  "data.index=1                                   # Maintain an index of the data files\n"
+  "data.journal=0                                 # Modifications appended before a data file is rewritten\n"
+  "data.snapshot=0                                # Read-only commands read the data files as of one commit\n"
+  "data.sources=                                  # Other data locations read by read-only commands, as <name>:<directory>,...\n"
+  "data.threads=1                                 # Threads used to parse large data files, 0 for all cores\n"
+  "memory.budget=0                                # MiB for reading completed.data, in bounded blocks, 0 for no limit\n"
+  "parser.cache=0                                 # Cache parsed command lines in parse.cache\n"
+  "report.cache=0                                 # Seconds a repeated report may reuse its output, 0 for never\n"
   "gc=1                                           # Garbage-collect data files - DO NOT CHANGE unless you are sure\n"
+  "gc.deferred=1                                  # Read-only commands garbage-collect in memory, leaving the files\n"
   "exit.on.missing.db=0                           # Whether to exit if ~/.task is not found\n"
   "hooks=1                                        # Master control switch for hooks\n"
+  "hooks.async=                                   # on-exit hook scripts left running in the background\n"
+  "hooks.budget=0                                 # Milliseconds all the hook scripts of an event may run, 0 for no limit\n"
+  "hooks.parallel=                                # on-launch and on-exit hook scripts run concurrently\n"
+  "hooks.resident=                                # Hook scripts kept running between events\n"
+  "hooks.timeout=0                                # Milliseconds a hook script may run, 0 for no limit\n"
+  "import.hooks=1                                 # Whether import runs on-add and on-modify hooks\n"
+  "import.threads=1                               # Threads used to parse large imports, 0 for all cores\n"
   "\n"
   "# Terminal\n"
   "detection=1                                    # Detects terminal width\n"
@@ -96,6 +121,7 @@ std::string configurationDefaults =
   "indent.report=0                                # Indent spaces for whole report\n"
   "row.padding=0                                  # Left and right padding for each row of report\n"
   "column.padding=1                               # Spaces between each column in a report\n"
+  "column.sample=0                                # Tasks measured to lay out report columns, 0 for all\n"
   "bulk=3                                         # 3 or more tasks considered a bulk change and is confirmed\n"
   "nag=You have more urgent tasks.                # Nag message to keep you honest\n"                      // TODO
   "search.case.sensitive=1                        # Setting to no allows case insensitive searches\n"
@@ -104,10 +130,19 @@ std::string configurationDefaults =
   "dependency.indicator=D                         # What to show as a dependency indicator\n"
   "recurrence.indicator=R                         # What to show as a task recurrence indicator\n"
   "recurrence.limit=1                             # Number of future recurring pending tasks\n"
+  "undo.delta=0                                   # Keep only the changed attributes in undo.data\n"
+  "undo.size=0                                    # Maximum size of undo.data in KB, 0 for no limit\n"
   "undo.style=side                                # Undo style - can be 'side', or 'diff'\n"
   "regex=1                                        # Assume all search/filter strings are regexes\n"
   "xterm.title=0                                  # Sets xterm title for some commands\n"
   "expressions=infix                              # Prefer infix over postfix expressions\n"
+  "filter.threads=1                               # Threads used to filter large task sets, 0 for all cores\n"
+  "export.after=                                  # Export only tasks with a uuid sorting after this\n"
+  "export.fields=                                 # Attributes exported, all when empty\n"
+  "export.page=0                                  # Tasks exported, in uuid order, 0 for all in any order\n"
+  "export.threads=1                               # Threads used to compose large exports, 0 for all cores\n"
+  "render.threads=1                               # Threads used to render large reports, 0 for all cores\n"
+  "threads=0                                      # Threads shared by all concurrent work, 0 for all cores\n"
   "json.array=1                                   # Enclose JSON output in [ ]\n"
   "json.depends.array=0                           # Encode dependencies as a JSON array\n"
   "abbreviation.minimum=2                         # Shortest allowed abbreviation\n"
@@ -263,7 +298,11 @@ std::string configurationDefaults =
   "summary.all.projects=0                         # Include old project names in 'summary' command\n"
   "list.all.tags=0                                # Include old tag names in 'tags' command\n"
   "print.empty.columns=0                          # Print columns which have no data for any task\n"
+  "print.stream=0                                 # Write report rows as they are rendered\n"
   "debug=0                                        # Display diagnostics\n"
+  "perf.output=                                   # Timing output of each command, as 'json'\n"
+  "perf.file=                                     # File, or file descriptor, for perf.output\n"
+  "trace.file=                                    # Chrome trace event file of timed spans\n"
   "debug.tls=0                                    # Sync diagnostics\n"
   "sugar=1                                        # Syntactic sugar\n"
   "obfuscate=0                                    # Obfuscate data for error reporting\n"
@@ -279,6 +318,8 @@ std::string configurationDefaults =
   "#taskd.trust=ignore hostname\n"
   "#taskd.trust=allow all\n"
   "taskd.ciphers=NORMAL\n"
+  "taskd.resume=0\n"
+  "taskd.background=0\n"
   "\n"
   "# Aliases - alternate names for commands\n"
   "alias.rm=delete                                # Alias for the delete command\n"
@@ -413,6 +454,9 @@ static const char* modifierNames[] =
 
 Context* Context::context;
 
+// The messages of a worker thread, see Context::Worker.
+static thread_local Context::Messages* worker = nullptr;
+
 ////////////////////////////////////////////////////////////////////////////////
 Context& Context::getContext ()
 {
@@ -436,123 +480,193 @@ Context::~Context ()
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-int Context::initialize (int argc, const char** argv)
+// Startup that does not depend on the command, other than its overrides.
+void Context::configure (int argc, const char** argv)
 {
-  timer_total.start ();
-  int rc = 0;
-
-  try
+  ////////////////////////////////////////////////////////////////////////////
+  //
+  // [1] Load the correct config file.
+  //     - Default to ~/.taskrc (ctor).
+  //     - Allow $TASKRC override.
+  //     - Allow command line override rc:<file>
+  //     - Load resultant file.
+  //     - Apply command line overrides to the config.
+  //
+  ////////////////////////////////////////////////////////////////////////////
+
+  bool taskrc_overridden = CLI2::getOverride (argc, argv, home_dir, rc_file);
+  if (! taskrc_overridden)
   {
-    ////////////////////////////////////////////////////////////////////////////
-    //
-    // [1] Load the correct config file.
-    //     - Default to ~/.taskrc (ctor).
-    //     - Allow $TASKRC override.
-    //     - Allow command line override rc:<file>
-    //     - Load resultant file.
-    //     - Apply command line overrides to the config.
-    //
-    ////////////////////////////////////////////////////////////////////////////
-
-    bool taskrc_overridden = CLI2::getOverride (argc, argv, home_dir, rc_file);
-    if (! taskrc_overridden)
+    char *override = getenv ("TASKRC");
+    if (override)
     {
-      char *override = getenv ("TASKRC");
-      if (override)
-      {
-        rc_file = File (override);
-        taskrc_overridden = true;
-      }
+      rc_file = File (override);
+      taskrc_overridden = true;
     }
+  }
 
-    // Artificial scope for timing purposes.
-    {
-      Timer timer;
-      config.parse (configurationDefaults);
-      config.load (rc_file._data);
-      debugTiming (format ("Config::load ({1})", rc_file._data), timer);
-    }
+  // Artificial scope for timing purposes.
+  {
+    Timer timer;
+    config.parse (configurationDefaults);
+    config.load (rc_file._data);
+    debugTiming (format ("Config::load ({1})", rc_file._data), timer);
+  }
 
-    CLI2::applyOverrides (argc, argv);
+  CLI2::applyOverrides (argc, argv);
 
-    if (taskrc_overridden && verbose ("override"))
-      header (format ("TASKRC override: {1}", rc_file._data));
+  if (config.get ("trace.file") != "")
+    Trace::enable ();
 
-    ////////////////////////////////////////////////////////////////////////////
-    //
-    // [2] Locate the data directory.
-    //     - Default to ~/.task (ctor).
-    //     - Allow $TASKDATA override.
-    //     - Allow command line override rc.data.location:<dir>
-    //     - Inform TDB2 where to find data.
-    //     - Create the rc_file and data_dir, if necessary.
-    //
-    ////////////////////////////////////////////////////////////////////////////
+  if (taskrc_overridden && verbose ("override"))
+    header (format ("TASKRC override: {1}", rc_file._data));
 
-    bool taskdata_overridden = CLI2::getDataLocation (argc, argv, data_dir);
-    if (! taskdata_overridden)
+  ////////////////////////////////////////////////////////////////////////////
+  //
+  // [2] Locate the data directory.
+  //     - Default to ~/.task (ctor).
+  //     - Allow $TASKDATA override.
+  //     - Allow command line override rc.data.location:<dir>
+  //     - Inform TDB2 where to find data.
+  //     - Create the rc_file and data_dir, if necessary.
+  //
+  ////////////////////////////////////////////////////////////////////////////
+
+  bool taskdata_overridden = CLI2::getDataLocation (argc, argv, data_dir);
+  if (! taskdata_overridden)
+  {
+    char *override = getenv("TASKDATA");
+    if (override)
     {
-      char *override = getenv("TASKDATA");
-      if (override)
-      {
-        data_dir = Directory (override);
-        config.set ("data.location", data_dir._data);
-        taskdata_overridden = true;
-      }
+      data_dir = Directory (override);
+      config.set ("data.location", data_dir._data);
+      taskdata_overridden = true;
     }
-    if (taskdata_overridden && verbose ("override"))
-      header (format ("TASKDATA override: {1}", data_dir._data));
+  }
+  if (taskdata_overridden && verbose ("override"))
+    header (format ("TASKDATA override: {1}", data_dir._data));
+
+  tdb2.set_location (data_dir);
+  tdb2.prefetch ();
+  createDefaultConfig ();
+
+  ////////////////////////////////////////////////////////////////////////////
+  //
+  // [3] Instantiate Command objects and capture command entities.
+  //
+  ////////////////////////////////////////////////////////////////////////////
+
+  Command::factory (commands);
+  for (auto& cmd : commands)
+    cli2.entity ("cmd", cmd.first);
+
+  ////////////////////////////////////////////////////////////////////////////
+  //
+  // [4] Instantiate Column objects and capture column entities.
+  //
+  ////////////////////////////////////////////////////////////////////////////
+
+  Column::factory (columns);
+  for (auto& col : columns)
+    cli2.entity ("attribute", col.first);
 
-    tdb2.set_location (data_dir);
-    createDefaultConfig ();
+  cli2.entity ("pseudo", "limit");
 
-    ////////////////////////////////////////////////////////////////////////////
-    //
-    // [3] Instantiate Command objects and capture command entities.
-    //
-    ////////////////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////////////////
+  //
+  // [5] Capture modifier and operator entities.
+  //
+  ////////////////////////////////////////////////////////////////////////////
 
-    Command::factory (commands);
-    for (auto& cmd : commands)
-      cli2.entity ("cmd", cmd.first);
+  for (unsigned int i = 0; i < NUM_MODIFIER_NAMES; ++i)
+    cli2.entity ("modifier", modifierNames[i]);
 
-    ////////////////////////////////////////////////////////////////////////////
-    //
-    // [4] Instantiate Column objects and capture column entities.
-    //
-    ////////////////////////////////////////////////////////////////////////////
+  for (auto& op : Eval::getOperators ())
+    cli2.entity ("operator", op);
 
-    Column::factory (columns);
-    for (auto& col : columns)
-      cli2.entity ("attribute", col.first);
+  for (auto& op : Eval::getBinaryOperators ())
+    cli2.entity ("binary_operator", op);
 
-    cli2.entity ("pseudo", "limit");
+  ////////////////////////////////////////////////////////////////////////////
+  //
+  // [6] Complete the Context initialization.
+  //
+  ////////////////////////////////////////////////////////////////////////////
 
-    ////////////////////////////////////////////////////////////////////////////
-    //
-    // [5] Capture modifier and operator entities.
-    //
-    ////////////////////////////////////////////////////////////////////////////
+  staticInitialization ();
+  propagateDebug ();
+  loadAliases ();
 
-    for (unsigned int i = 0; i < NUM_MODIFIER_NAMES; ++i)
-      cli2.entity ("modifier", modifierNames[i]);
+  // The parser, with all the entities and aliases, before any command line, and
+  // the configuration, with its overrides, before any command changes it.
+  _parser = cli2;
+  _configuration = config;
+}
 
-    for (auto& op : Eval::getOperators ())
-      cli2.entity ("operator", op);
+////////////////////////////////////////////////////////////////////////////////
+// Clears all that a command left, and restores the configuration as it was
+// configured, undoing any pseudo-attribute such as limit:N, or setting that a
+// command changed, so that a further command starts as the first did.  The
+// data files are read again, as another process may have changed them.
+void Context::reset ()
+{
+  config = _configuration;
 
-    for (auto& op : Eval::getBinaryOperators ())
-      cli2.entity ("binary_operator", op);
+  timer_total = Timer ();
+  timer_total.start ();
 
-    ////////////////////////////////////////////////////////////////////////////
-    //
-    // [6] Complete the Context initialization.
-    //
-    ////////////////////////////////////////////////////////////////////////////
+  cli2 = _parser;
+  tdb2.clear ();
+  tdb2.set_location (data_dir);
+  Task::compileTimeFrame ();
+
+  determine_color_use = true;
+  run_gc              = true;
+  helper              = false;
+  headers.clear ();
+  headers_written = 0;
+  report_cache.clear ();
+  footnotes.clear ();
+  errors.clear ();
+  debugMessages.clear ();
+  terminal_width  = 0;
+  terminal_height = 0;
+  _width          = -1;
+  _height         = -1;
+
+  time_total_us  = time_init_us   = time_load_us   = time_gc_us     = 0;
+  time_filter_us = time_commit_us = time_sort_us   = time_render_us = 0;
+  time_hooks_us  = time_config_us = time_parse_us  = time_hooks_init_us = 0;
+  time_lock_us   = 0;
+  time_hook_us.clear ();
+  count_loaded   = count_parsed   = count_filtered = count_rendered = 0;
+  count_compared = count_spawned  = 0;
+  memory_tasks   = memory_lines   = memory_undo    = 0;
+  memory_import  = memory_render  = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int Context::initialize (int argc, const char** argv)
+{
+  timer_total.start ();
+  int rc = 0;
 
-    initializeColorRules ();
-    staticInitialization ();
-    propagateDebug ();
-    loadAliases ();
+  try
+  {
+    // A further command run by the same process keeps the configuration,
+    // commands, columns and rules of the first, and only parses its own
+    // command line.
+    if (_configured)
+      reset ();
+    else
+    {
+      Timer timer;
+      configure (argc, argv);
+      _configured = true;
+
+      time_config_us = timer.total_us ();
+      Trace::add ("config", time_config_us);
+    }
 
     ////////////////////////////////////////////////////////////////////////////
     //
@@ -560,10 +674,15 @@ int Context::initialize (int argc, const char** argv)
     //
     ////////////////////////////////////////////////////////////////////////////
 
-    for (int i = 0; i < argc; i++)
-      cli2.add (argv[i]);
+    {
+      Trace::Span span ("parse");
+      Timer timer;
+      for (int i = 0; i < argc; i++)
+        cli2.add (argv[i]);
 
-    cli2.analyze ();
+      cli2.analyze ();
+      time_parse_us = timer.total_us ();
+    }
 
     // Extract a recomposed command line.
     auto foundDefault = false;
@@ -576,10 +695,10 @@ int Context::initialize (int argc, const char** argv)
 
       combined += a.attribute ("raw");
 
-      if (a.hasTag ("DEFAULT"))
+      if (a.hasTag (A2::Tag::DEFAULT))
         foundDefault = true;
 
-      if (a.hasTag ("ASSUMED"))
+      if (a.hasTag (A2::Tag::ASSUMED))
         foundAssumed = true;
     }
 
@@ -592,10 +711,27 @@ int Context::initialize (int argc, const char** argv)
     ////////////////////////////////////////////////////////////////////////////
     //
     // [8] Initialize hooks.
+    //     - Read-only helper commands, which the shell completion scripts run
+    //       on every TAB, need none, and run no GC.
+    //     - Color rules are compiled when first needed, which a command that
+    //       writes no colored output never does.
     //
     ////////////////////////////////////////////////////////////////////////////
 
-    hooks.initialize ();
+    auto command = commands.find (cli2.getCommand ());
+    helper = command != commands.end () &&
+             command->first[0] == '_' &&
+             command->second->read_only ();
+
+    if (helper)
+      hooks.enable (false);
+    else
+    {
+      Trace::Span span ("hooks init");
+      Timer timer;
+      hooks.initialize ();
+      time_hooks_init_us = timer.total_us ();
+    }
   }
 
   catch (const std::string& message)
@@ -659,6 +795,7 @@ int Context::initialize (int argc, const char** argv)
   }
 
   time_init_us += timer_total.total_us ();
+  Trace::add ("init", time_init_us);
   return rc;
 }
 
@@ -671,13 +808,31 @@ int Context::run ()
   try
   {
     hooks.onLaunch ();
+    syncResults ();
     rc = dispatch (output);
+    tdb2.apply_batch ();
+    bool changed = tdb2.backlog._dirty;
     tdb2.commit ();           // Harmless if called when nothing changed.
+    if (changed)
+      syncInBackground ();
     hooks.onExit ();          // No chance to update data.
 
+    // The report is stored with the data as it now is, which includes any
+    // change made by the gc, or by recurrence.
+    if (report_cache != "" &&
+        rc == 0            &&
+        errors.empty ())
+      ReportCache::put (ReportCache::key (),
+                        output,
+                        std::vector <std::string> (headers.begin () + report_headers, headers.end ()),
+                        std::vector <std::string> (footnotes.begin () + report_footnotes, footnotes.end ()));
+
     timer_total.stop ();
     time_total_us += timer_total.total_us ();
 
+    if (config.get ("perf.output") == "json")
+      writePerf ();
+
     std::stringstream s;
     s << "Perf "
       << PACKAGE_STRING
@@ -707,6 +862,7 @@ int Context::run ()
                        time_render_us -
                        time_hooks_us
       << " total:"  << time_total_us
+      << " rss:"    << Allocations::peakRSS ()
       << '\n';
     debug (s.str ());
   }
@@ -740,14 +896,7 @@ int Context::run ()
   }
 
   // Dump all headers, controlled by 'header' verbosity token.
-  if (verbose ("header"))
-  {
-    for (auto& h : headers)
-      if (color ())
-        std::cerr << colorizeHeader (h) << '\n';
-      else
-        std::cerr << h << '\n';
-  }
+  writeHeaders ();
 
   // Dump the report output.
   std::cout << output;
@@ -770,6 +919,9 @@ int Context::run ()
     else
       std::cerr << e << '\n';
 
+  if (Trace::enabled () && ! Trace::write (config.get ("trace.file")))
+    std::cerr << format ("Could not write trace.file {1}", config.get ("trace.file")) << '\n';
+
   return rc;
 }
 
@@ -779,6 +931,7 @@ int Context::dispatch (std::string &out)
 {
   // Autocomplete args against keywords.
   std::string command = cli2.getCommand ();
+  Trace::Span span ("command", command);
   if (command != "")
   {
     updateXtermTitle ();
@@ -787,12 +940,40 @@ int Context::dispatch (std::string &out)
     Command* c = commands[command];
     assert (c);
 
-    // The command know whether they need a GC.
+    // A custom report repeated before anything it shows may have changed
+    // reuses its output, for report.cache seconds.
+    if (dynamic_cast <CmdCustom*> (c) &&
+        (report_cache = ReportCache::key ()) != "")
+    {
+      std::vector <std::string> cached_headers;
+      std::vector <std::string> cached_footnotes;
+      if (tdb2.events_due () || tdb2.expiry_due ())
+        report_cache = "";
+      else if (ReportCache::get (report_cache, out, cached_headers, cached_footnotes))
+      {
+        report_cache = "";
+        headers.insert (headers.end (), cached_headers.begin (), cached_headers.end ());
+        footnotes.insert (footnotes.end (), cached_footnotes.begin (), cached_footnotes.end ());
+        return 0;
+      }
+
+      report_headers   = headers.size ();
+      report_footnotes = footnotes.size ();
+    }
+
+    // A read-only command may read the data files as of one commit.
+    if (c->read_only () &&
+        config.getBoolean ("data.snapshot"))
+      tdb2.snapshot ();
+
+    // The command know whether they need a GC.  Helper commands number the
+    // tasks as a GC would, but leave the GC to the next command.
     if (c->needs_gc () &&
         ! tdb2.read_only ())
     {
       run_gc = config.getBoolean ("gc");
-      tdb2.gc ();
+      if (! helper)
+        tdb2.gc (c->read_only () && config.getBoolean ("gc.deferred"));
     }
     else
     {
@@ -829,14 +1010,21 @@ int Context::dispatch (std::string &out)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+// The width is determined once per command, after color () has decided
+// whether the output is a terminal that can be queried.
 int Context::getWidth ()
 {
+  if (_width != -1)
+    return _width;
+
+  color ();
+
   // Determine window size.
   auto width = config.getInteger ("defaultwidth");
 
   // A zero width value means 'infinity', which is approximated here by 2^16.
   if (width == 0)
-    return 65536;
+    return _width = 65536;
 
   if (config.getBoolean ("detection"))
   {
@@ -860,18 +1048,24 @@ int Context::getWidth ()
       --width;
   }
 
-  return width;
+  return _width = width;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+// As is the height.
 int Context::getHeight ()
 {
+  if (_height != -1)
+    return _height;
+
+  color ();
+
   // Determine window size.
   auto height = config.getInteger ("defaultheight");
 
   // A zero height value means 'infinity', which is approximated here by 2^16.
   if (height == 0)
-    return 65536;
+    return _height = 65536;
 
   if (config.getBoolean ("detection"))
   {
@@ -889,7 +1083,7 @@ int Context::getHeight ()
     height = terminal_height;
   }
 
-  return height;
+  return _height = height;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1064,13 +1258,14 @@ void Context::staticInitialization ()
 
   TDB2::debug_mode                   = config.getBoolean ("debug");
 
-  for (auto& rc : config)
+  auto udas = settings (config, "uda.");
+  for (auto rc = udas.first; rc != udas.second; ++rc)
   {
-    if (rc.first.substr (0, 4) == "uda." &&
-        rc.first.substr (rc.first.length () - 7, 7) == ".values")
+    if (rc->first.length () > 11 &&
+        ! rc->first.compare (rc->first.length () - 7, 7, ".values"))
     {
-      std::string name = rc.first.substr (4, rc.first.length () - 7 - 4);
-      auto values = split (rc.second, ',');
+      std::string name = rc->first.substr (4, rc->first.length () - 7 - 4);
+      auto values = split (rc->second, ',');
 
       for (auto r = values.rbegin(); r != values.rend (); ++r)
         Task::customOrder[name].push_back (*r);
@@ -1096,10 +1291,32 @@ void Context::staticInitialization ()
   Task::urgencyAgeMax                 = config.getReal ("urgency.age.max");
 
   // Tag- and project-specific coefficients.
-  for (auto& var : config.all ())
-    if (var.substr (0, 13) == "urgency.user." ||
-        var.substr (0, 12) == "urgency.uda.")
-      Task::coefficients[var] = config.getReal (var);
+  for (auto prefix : {"urgency.user.", "urgency.uda."})
+  {
+    auto coefficients = settings (config, prefix);
+    for (auto var = coefficients.first; var != coefficients.second; ++var)
+      Task::coefficients[var->first] = config.getReal (var->first);
+  }
+
+  Task::compileCoefficients ();
+  Task::compileTimeFrame ();
+
+  // Identifies the coefficients, so that urgency kept in an index from a run
+  // with other settings is not used.  It is never zero.
+  std::string all;
+  auto append = [&all] (float value) { all.append ((const char*) &value, sizeof (value)); };
+  append (Task::urgencyProjectCoefficient);
+  append (Task::urgencyActiveCoefficient);
+  append (Task::urgencyWaitingCoefficient);
+  append (Task::urgencyAnnotationsCoefficient);
+  append (Task::urgencyTagsCoefficient);
+  for (auto& var : Task::coefficients)
+  {
+    all += var.first;
+    append (var.second);
+  }
+
+  Task::urgencyKey = (uint32_t) std::hash <std::string> () (all) | 1;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1213,6 +1430,88 @@ void Context::debugTiming (const std::string& details, const Timer& timer)
   debug (out.str ());
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Writes the timings and counters of the command as one line of JSON, appended
+// to perf.file, or written to the file descriptor it names, or to stderr.
+void Context::writePerf ()
+{
+  tdb2.memory ();
+
+  long gc    = time_gc_us > 0 ? time_gc_us - time_load_us : time_gc_us;
+  long other = time_total_us  - time_init_us   - time_gc_us     - time_filter_us -
+               time_commit_us - time_sort_us   - time_render_us - time_hooks_us;
+
+  std::stringstream s;
+  s << "{\"version\":\"" << PACKAGE_STRING << '"'
+#ifdef HAVE_COMMIT
+    << ",\"commit\":\"" << COMMIT << '"'
+#else
+    << ",\"commit\":\"-\""
+#endif
+    << ",\"timestamp\":\"" << Datetime ().toISO () << '"'
+    << ",\"command\":\"" << json::encode (cli2.getCommand ()) << '"'
+    << ",\"timing\":{"
+    <<   "\"init\":"    << time_init_us
+    << ",\"init_config\":" << time_config_us
+    << ",\"init_parse\":"  << time_parse_us
+    << ",\"init_hooks\":"  << time_hooks_init_us
+    << ",\"load\":"     << time_load_us
+    << ",\"gc\":"       << gc
+    << ",\"filter\":"   << time_filter_us
+    << ",\"commit\":"   << time_commit_us
+    << ",\"sort\":"     << time_sort_us
+    << ",\"render\":"   << time_render_us
+    << ",\"hooks\":"    << time_hooks_us
+    << ",\"lock\":"     << time_lock_us
+    << ",\"other\":"    << other
+    << ",\"total\":"    << time_total_us
+    << "},\"counters\":{"
+    <<   "\"loaded\":"   << count_loaded
+    << ",\"parsed\":"   << count_parsed
+    << ",\"filtered\":" << count_filtered
+    << ",\"rendered\":" << count_rendered
+    << ",\"compared\":" << count_compared
+    << ",\"spawned\":"  << count_spawned
+    << "},\"memory\":{"
+    <<   "\"peak_rss\":" << Allocations::peakRSS ()
+    << ",\"tasks\":"    << memory_tasks
+    << ",\"lines\":"    << memory_lines
+    << ",\"undo\":"     << memory_undo
+    << ",\"import\":"   << memory_import
+    << ",\"render\":"   << memory_render
+    << "},\"hooks\":{";
+
+  // The time taken by each hook script, by name.
+  for (auto i = time_hook_us.begin (); i != time_hook_us.end (); ++i)
+    s << (i == time_hook_us.begin () ? "" : ",")
+      << '"' << json::encode (i->first) << "\":" << i->second;
+
+  s << '}';
+
+  if (Allocations::enabled ())
+    s << ",\"allocations\":{\"count\":" << Allocations::count ()
+      << ",\"bytes\":"                  << Allocations::bytes ()
+      << '}';
+
+  s << "}\n";
+
+  auto text = s.str ();
+  auto file = config.get ("perf.file");
+  if (file == "")
+    std::cerr << text;
+  else if (Lexer::isAllDigits (file))
+  {
+    if (::write (strtol (file.c_str (), nullptr, 10), text.data (), text.length ()) != (ssize_t) text.length ())
+      debug (format ("Could not write perf.output to descriptor {1}", file));
+  }
+  else
+  {
+    std::ofstream out (file, std::ios::app);
+    if (! (out << text))
+      debug (format ("Could not write perf.output to {1}", file));
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // This capability is to answer the question of 'what did I just do to generate
 // this output?'.
@@ -1250,9 +1549,9 @@ void Context::updateVerbosity ()
 ////////////////////////////////////////////////////////////////////////////////
 void Context::loadAliases ()
 {
-  for (auto& i : config)
-    if (i.first.substr (0, 6) == "alias.")
-      cli2.alias (i.first.substr (6), i.second);
+  auto aliases = settings (config, "alias.");
+  for (auto i = aliases.first; i != aliases.second; ++i)
+    cli2.alias (i->first.substr (6), i->second);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1280,20 +1579,71 @@ void Context::propagateDebug ()
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// A chunk run by a worker may itself run workers, whose messages are merged
+// into those of the chunk.
+Context::Worker::Worker (Messages& messages)
+{
+  _previous = worker;
+  worker = &messages;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+Context::Worker::~Worker ()
+{
+  worker = _previous;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Called once the worker is done, by the thread that started it.
+void Context::merge (const Messages& messages)
+{
+  for (auto& message : messages.headers)
+    header (message);
+
+  for (auto& message : messages.footnotes)
+    footnote (message);
+
+  for (auto& message : messages.errors)
+    error (message);
+
+  for (auto& message : messages.debug)
+    debug (message);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // No duplicates.
 void Context::header (const std::string& input)
 {
-  if (input.length () &&
+  if (worker)
+    worker->headers.push_back (input);
+  else if (input.length () &&
       std::find (headers.begin (), headers.end (), input) == headers.end ())
     headers.push_back (input);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Headers are written before any output, so a command that writes its output
+// directly writes the headers first.
+void Context::writeHeaders ()
+{
+  if (verbose ("header"))
+  {
+    for (; headers_written < headers.size (); ++headers_written)
+      if (color ())
+        std::cerr << colorizeHeader (headers[headers_written]) << '\n';
+      else
+        std::cerr << headers[headers_written] << '\n';
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // No duplicates.
 void Context::footnote (const std::string& input)
 {
-  if (input.length () &&
+  if (worker)
+    worker->footnotes.push_back (input);
+  else if (input.length () &&
       std::find (footnotes.begin (), footnotes.end (), input) == footnotes.end ())
     footnotes.push_back (input);
 }
@@ -1302,16 +1652,24 @@ void Context::footnote (const std::string& input)
 // No duplicates.
 void Context::error (const std::string& input)
 {
-  if (input.length () &&
+  if (worker)
+    worker->errors.push_back (input);
+  else if (input.length () &&
       std::find (errors.begin (), errors.end (), input) == errors.end ())
     errors.push_back (input);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+// Worker threads that have no Worker in scope may also add messages.
 void Context::debug (const std::string& input)
 {
-  if (input.length ())
+  if (worker)
+    worker->debug.push_back (input);
+  else if (input.length ())
+  {
+    std::lock_guard <std::mutex> lock (debug_mutex);
     debugMessages.push_back (input);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -37,10 +37,32 @@
 #include <CLI2.h>
 #include <Timer.h>
 #include <set>
+#include <mutex>
 
 class Context
 {
 public:
+  // Messages from a worker thread are held for it, while a Worker is in scope,
+  // and merged by the thread that started the workers once they are done, so
+  // that the messages do not race, and appear in the same order as serially.
+  struct Messages
+  {
+    std::vector <std::string> headers;
+    std::vector <std::string> footnotes;
+    std::vector <std::string> errors;
+    std::vector <std::string> debug;
+  };
+
+  class Worker
+  {
+  public:
+    explicit Worker (Messages&);
+    ~Worker ();
+
+  private:
+    Messages* _previous;
+  };
+
   Context () = default;                // Default constructor
   ~Context ();                         // Destructor
 
@@ -67,11 +89,16 @@ public:
   void footnote (const std::string&);  // Footnote message sink
   void debug (const std::string&);     // Debug message sink
   void error (const std::string&);     // Error message sink - non-maskable
+  void writeHeaders ();                // Write headers not yet written
+  void merge (const Messages&);        // Merge a worker's messages
 
   void decomposeSortField (const std::string&, std::string&, bool&, bool&);
   void debugTiming (const std::string&, const Timer&);
+  void writePerf ();
 
 private:
+  void configure (int, const char**);
+  void reset ();
   void staticInitialization ();
   void createDefaultConfig ();
   void updateXtermTitle ();
@@ -81,6 +108,12 @@ private:
 
   static Context* context;
 
+  CLI2                                _parser             {};
+  Configuration                       _configuration      {};
+  bool                                _configured         {false};
+  int                                 _width              {-1};
+  int                                 _height             {-1};
+
 public:
   CLI2                                cli2                {};
   std::string                         home_dir            {};
@@ -92,12 +125,18 @@ public:
   bool                                determine_color_use {true};
   bool                                use_color           {true};
   bool                                run_gc              {true};
+  bool                                helper              {false};
   bool                                verbosity_legacy    {false};
   std::set <std::string>              verbosity           {};
   std::vector <std::string>           headers             {};
+  size_t                              headers_written     {0};
   std::vector <std::string>           footnotes           {};
   std::vector <std::string>           errors              {};
   std::vector <std::string>           debugMessages       {};
+  std::string                         report_cache        {};   // Key of a report to store
+  size_t                              report_headers      {0};  // Its first header
+  size_t                              report_footnotes    {0};  // Its first footnote
+  std::mutex                          debug_mutex         {};
   std::map <std::string, Command*>    commands            {};
   std::map <std::string, Column*>     columns             {};
   int                                 terminal_width      {0};
@@ -106,6 +145,9 @@ public:
   Timer                               timer_total         {};
   long                                time_total_us       {0};
   long                                time_init_us        {0};
+  long                                time_config_us      {0};  // Parts of time_init_us
+  long                                time_parse_us       {0};
+  long                                time_hooks_init_us  {0};
   long                                time_load_us        {0};
   long                                time_gc_us          {0};
   long                                time_filter_us      {0};
@@ -113,6 +155,22 @@ public:
   long                                time_sort_us        {0};
   long                                time_render_us      {0};
   long                                time_hooks_us       {0};
+  long                                time_lock_us        {0};  // Waiting for locks, within the above
+  std::map <std::string, long>        time_hook_us        {};
+
+  long                                count_loaded        {0};
+  long                                count_parsed        {0};
+  long                                count_filtered      {0};
+  long                                count_rendered      {0};
+  long                                count_compared      {0};  // Sort comparisons
+  long                                count_spawned       {0};  // Hook script processes started
+
+  // The peak bytes held, as estimated for perf.output.
+  long                                memory_tasks        {0};  // Tasks of pending.data and completed.data
+  long                                memory_lines        {0};  // Their lines, as read
+  long                                memory_undo         {0};  // Lines of undo.data and backlog.data
+  long                                memory_import       {0};  // Objects and tasks held by import
+  long                                memory_render       {0};  // Rendered output
 };
 
 #endif
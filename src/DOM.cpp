@@ -27,17 +27,56 @@
 #include <cmake.h>
 #include <DOM.h>
 #include <sstream>
+#include <algorithm>
+#include <unordered_map>
 #include <map>
+#include <mutex>
 #include <stdlib.h>
 #include <Variant.h>
 #include <Lexer.h>
 #include <Context.h>
 #include <Datetime.h>
 #include <Duration.h>
+#include <Trace.h>
 #include <shared.h>
 #include <format.h>
 #include <util.h>
 
+// Filters may be evaluated on several threads.  Anything that reaches beyond
+// the task being evaluated, into TDB2 or the context, is serialized.
+static std::mutex shared;
+
+// The elements of a date, as in <date>.year, in the order of dateElement.
+static const std::vector <std::string> dateElements =
+{
+  "year", "month", "day", "week", "weekday", "julian", "hour", "minute", "second"
+};
+
+////////////////////////////////////////////////////////////////////////////////
+static int dateElement (const Datetime& date, int element)
+{
+  switch (element)
+  {
+  case 0:  return date.year ();
+  case 1:  return date.month ();
+  case 2:  return date.day ();
+  case 3:  return date.week ();
+  case 4:  return date.dayOfWeek ();
+  case 5:  return date.dayOfYear ();
+  case 6:  return date.hour ();
+  case 7:  return date.minute ();
+  default: return date.second ();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Position of the date element in dateElements, or -1.
+static int findDateElement (const std::string& name)
+{
+  auto found = std::find (dateElements.begin (), dateElements.end (), name);
+  return found == dateElements.end () ? -1 : (int) (found - dateElements.begin ());
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // DOM Supported References:
 //
@@ -89,16 +128,7 @@ bool getDOM (const std::string& name, Variant& value)
   {
     if (name == "tw.syncneeded")
     {
-      value = Variant (0);
-      for (const auto& line : Context::getContext ().tdb2.backlog.get_lines ())
-      {
-        if (line[0] == '{')
-        {
-          value = Variant (1);
-          break;
-        }
-      }
-
+      value = Variant (Context::getContext ().tdb2.backlog_count () > 0 ? 1 : 0);
       return true;
     }
     else if (name == "tw.program")
@@ -241,6 +271,8 @@ bool getDOM (const std::string& name, Variant& value)
 // as special cases.
 bool getDOM (const std::string& name, const Task& task, Variant& value)
 {
+  Trace::Span span ("dom", name);
+
   // Special case, blank refs cause problems.
   if (name == "")
     return false;
@@ -254,14 +286,27 @@ bool getDOM (const std::string& name, const Task& task, Variant& value)
 
   if (task.data.size () && name == "urgency")
   {
+    std::lock_guard <std::mutex> lock (shared);
     value = Variant (task.urgency_c ());
     return true;
   }
 
+  // References are resolved once per thread, and then read directly.  Those
+  // that are unresolved, or not found in the task, are looked up below.
+  static thread_local std::unordered_map <std::string, DOM::Accessor> accessors;
+  auto accessor = accessors.find (name);
+  if (accessor == accessors.end ())
+    accessor = accessors.emplace (name, DOM::Accessor (name)).first;
+
+  if (task.data.size () && accessor->second.get (task, value))
+    return true;
+
   // split name on '.'
   auto elements = split (name, '.');
 
-  Task ref (task);
+  // Refer to the given task, and only copy when a different task is named.
+  const Task* ref = &task;
+  Task other;
   Lexer lexer (elements[0]);
   std::string token;
   Lexer::Type type;
@@ -270,8 +315,10 @@ bool getDOM (const std::string& name, const Task& task, Variant& value)
     if (type == Lexer::Type::uuid &&
         token.length () == elements[0].length ())
     {
-      if (token != ref.get ("uuid"))
-        Context::getContext ().tdb2.get (token, ref);
+      std::lock_guard <std::mutex> lock (shared);
+      if (token != ref->get ("uuid") &&
+          Context::getContext ().tdb2.get (token, other))
+        ref = &other;
 
       // Eat elements[0]/UUID.
       elements.erase (elements.begin ());
@@ -280,8 +327,10 @@ bool getDOM (const std::string& name, const Task& task, Variant& value)
              token.find ('.') == std::string::npos)
     {
       auto id = strtol (token.c_str (), nullptr, 10);
-      if (id && id != ref.id)
-        Context::getContext ().tdb2.get (id, ref);
+      std::lock_guard <std::mutex> lock (shared);
+      if (id && id != ref->id &&
+          Context::getContext ().tdb2.get (id, other))
+        ref = &other;
 
       // Eat elements[0]/ID.
       elements.erase (elements.begin ());
@@ -295,23 +344,25 @@ bool getDOM (const std::string& name, const Task& task, Variant& value)
   {
     // Now that 'ref' is the contextual task, and any ID/UUID is chopped off the
     // elements vector, DOM resolution is now simple.
-    if (ref.data.size () && size == 1 && canonical == "id")
+    if (ref->data.size () && size == 1 && canonical == "id")
     {
-      value = Variant (static_cast<int> (ref.id));
+      value = Variant (static_cast<int> (ref->id));
       return true;
     }
 
-    if (ref.data.size () && size == 1 && canonical == "urgency")
+    if (ref->data.size () && size == 1 && canonical == "urgency")
     {
-      value = Variant (ref.urgency_c ());
+      std::lock_guard <std::mutex> lock (shared);
+      value = Variant (ref->urgency_c ());
       return true;
     }
 
-    Column* column = Context::getContext ().columns[canonical];
+    auto found = Context::getContext ().columns.find (canonical);
+    Column* column = found != Context::getContext ().columns.end () ? found->second : nullptr;
 
-    if (ref.data.size () && size == 1 && column)
+    if (ref->data.size () && size == 1 && column)
     {
-      if (column->is_uda () && ! ref.has (canonical))
+      if (column->is_uda () && ! ref->has (canonical))
       {
         value = Variant ("");
         return true;
@@ -319,7 +370,7 @@ bool getDOM (const std::string& name, const Task& task, Variant& value)
 
       if (column->type () == "date")
       {
-        auto numeric = ref.get_date (canonical);
+        auto numeric = ref->get_date (canonical);
         if (numeric == 0)
           value = Variant ("");
         else
@@ -327,32 +378,32 @@ bool getDOM (const std::string& name, const Task& task, Variant& value)
       }
       else if (column->type () == "duration" || canonical == "recur")
       {
-        auto period = ref.get (canonical);
+        auto period = ref->get (canonical);
 
         Duration iso;
         std::string::size_type cursor = 0;
         if (iso.parse (period, cursor))
           value = Variant (iso.toTime_t (), Variant::type_duration);
         else
-          value = Variant (Duration (ref.get (canonical)).toTime_t (), Variant::type_duration);
+          value = Variant (Duration (ref->get (canonical)).toTime_t (), Variant::type_duration);
       }
       else if (column->type () == "numeric")
-        value = Variant (ref.get_float (canonical));
+        value = Variant (ref->get_float (canonical));
       else
-        value = Variant (ref.get (canonical));
+        value = Variant (ref->get (canonical));
 
       return true;
     }
 
-    if (ref.data.size () && size == 2 && canonical == "tags")
+    if (ref->data.size () && size == 2 && canonical == "tags")
     {
-      value = Variant (ref.hasTag (elements[1]) ? elements[1] : "");
+      value = Variant (ref->hasTag (elements[1]) ? elements[1] : "");
       return true;
     }
 
-    if (ref.data.size () && size == 2 && column && column->type () == "date")
+    if (ref->data.size () && size == 2 && column && column->type () == "date")
     {
-      Datetime date (ref.get_date (canonical));
+      Datetime date (ref->get_date (canonical));
            if (elements[1] == "year")    { value = Variant (static_cast<int> (date.year ()));      return true; }
       else if (elements[1] == "month")   { value = Variant (static_cast<int> (date.month ()));     return true; }
       else if (elements[1] == "day")     { value = Variant (static_cast<int> (date.day ()));       return true; }
@@ -365,15 +416,15 @@ bool getDOM (const std::string& name, const Task& task, Variant& value)
     }
   }
 
-  if (ref.data.size () && size == 2 && elements[0] == "annotations" && elements[1] == "count")
+  if (ref->data.size () && size == 2 && elements[0] == "annotations" && elements[1] == "count")
   {
-    value = Variant (static_cast<int> (ref.getAnnotationCount ()));
+    value = Variant (static_cast<int> (ref->getAnnotationCount ()));
     return true;
   }
 
-  if (ref.data.size () && size == 3 && elements[0] == "annotations")
+  if (ref->data.size () && size == 3 && elements[0] == "annotations")
   {
-    auto annos = ref.getAnnotations ();
+    auto annos = ref->annotations ();
 
     int a = strtol (elements[1].c_str (), nullptr, 10);
     int count = 0;
@@ -399,9 +450,9 @@ bool getDOM (const std::string& name, const Task& task, Variant& value)
     }
   }
 
-  if (ref.data.size () && size == 4 && elements[0] == "annotations" && elements[2] == "entry")
+  if (ref->data.size () && size == 4 && elements[0] == "annotations" && elements[2] == "entry")
   {
-    auto annos = ref.getAnnotations ();
+    auto annos = ref->annotations ();
 
     int a = strtol (elements[1].c_str (), nullptr, 10);
     int count = 0;
@@ -435,9 +486,187 @@ bool getDOM (const std::string& name, const Task& task, Variant& value)
   }
 
   // Delegate to the context-free version of DOM::get.
+  std::lock_guard <std::mutex> lock (shared);
   return getDOM (name, value);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Resolves the reference as getDOM would for the task being evaluated.
+DOM::Accessor::Accessor (const std::string& name)
+{
+  if (name == "")
+    return;
+
+  auto elements = split (name, '.');
+
+  Lexer lexer (elements[0]);
+  std::string token;
+  Lexer::Type type;
+  if (lexer.token (token, type) &&
+      ((type == Lexer::Type::uuid   && token.length () == elements[0].length ()) ||
+       (type == Lexer::Type::number && token.find ('.') == std::string::npos)))
+    return;
+
+  auto size = elements.size ();
+
+  std::string canonical;
+  if ((size == 1 || size == 2) && Context::getContext ().cli2.canonicalize (canonical, "attribute", elements[0]))
+  {
+    if (size == 1 && canonical == "id")
+    {
+      _kind = id;
+      return;
+    }
+
+    if (size == 1 && canonical == "urgency")
+    {
+      _kind = urgency;
+      return;
+    }
+
+    auto found = Context::getContext ().columns.find (canonical);
+    Column* column = found != Context::getContext ().columns.end () ? found->second : nullptr;
+
+    if (size == 1 && column)
+    {
+      _name = canonical;
+      _uda  = column->is_uda ();
+           if (column->type () == "date")                            _kind = date;
+      else if (column->type () == "duration" || canonical == "recur") _kind = duration;
+      else if (column->type () == "numeric")                         _kind = numeric;
+      else                                                           _kind = string;
+      return;
+    }
+
+    if (size == 2 && canonical == "tags")
+    {
+      _kind = tag;
+      _name = elements[1];
+      return;
+    }
+
+    if (size == 2 && column && column->type () == "date" &&
+        findDateElement (elements[1]) != -1)
+    {
+      _kind    = date_element;
+      _name    = canonical;
+      _element = findDateElement (elements[1]);
+      return;
+    }
+  }
+
+  if (size == 2 && elements[0] == "annotations" && elements[1] == "count")
+    _kind = annotation_count;
+
+  else if (size == 3 && elements[0] == "annotations" &&
+           (elements[2] == "entry" || elements[2] == "description"))
+  {
+    _kind   = elements[2] == "entry" ? annotation_entry : annotation_description;
+    _number = strtol (elements[1].c_str (), nullptr, 10);
+  }
+
+  else if (size == 4 && elements[0] == "annotations" && elements[2] == "entry" &&
+           findDateElement (elements[3]) != -1)
+  {
+    _kind    = annotation_entry_element;
+    _number  = strtol (elements[1].c_str (), nullptr, 10);
+    _element = findDateElement (elements[3]);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// False if the reference is unresolved, or the annotation is not found.
+bool DOM::Accessor::get (const Task& task, Variant& value) const
+{
+  switch (_kind)
+  {
+  case unresolved:
+    return false;
+
+  case id:
+    value = Variant (static_cast<int> (task.id));
+    return true;
+
+  case urgency:
+    {
+      std::lock_guard <std::mutex> lock (shared);
+      value = Variant (task.urgency_c ());
+    }
+    return true;
+
+  case string:
+  case date:
+  case duration:
+  case numeric:
+    if (_uda && ! task.has (_name))
+      value = Variant ("");
+
+    else if (_kind == date)
+    {
+      auto epoch = task.get_date (_name);
+      if (epoch == 0)
+        value = Variant ("");
+      else
+        value = Variant (epoch, Variant::type_date);
+    }
+
+    else if (_kind == duration)
+    {
+      auto period = task.get (_name);
+
+      Duration iso;
+      std::string::size_type cursor = 0;
+      if (iso.parse (period, cursor))
+        value = Variant (iso.toTime_t (), Variant::type_duration);
+      else
+        value = Variant (Duration (period).toTime_t (), Variant::type_duration);
+    }
+
+    else if (_kind == numeric)
+      value = Variant (task.get_float (_name));
+
+    else
+      value = Variant (task.get (_name));
+
+    return true;
+
+  case tag:
+    value = Variant (task.hasTag (_name) ? _name : "");
+    return true;
+
+  case date_element:
+    value = Variant (dateElement (Datetime (task.get_date (_name)), _element));
+    return true;
+
+  case annotation_count:
+    value = Variant (static_cast<int> (task.getAnnotationCount ()));
+    return true;
+
+  case annotation_entry:
+  case annotation_description:
+  case annotation_entry_element:
+    {
+      auto annos = task.annotations ();
+      if (_number < 1 || (size_t) _number > annos.size ())
+        return false;
+
+      // annotation_1234567890
+      // 0          ^11
+      auto& i = annos.begin ()[_number - 1];
+      if (_kind == annotation_entry)
+        value = Variant ((time_t) strtol (i.first.substr (11).c_str (), NULL, 10), Variant::type_date);
+      else if (_kind == annotation_description)
+        value = Variant (i.second);
+      else
+        value = Variant (dateElement (Datetime (i.first.substr (11)), _element));
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // DOM Class
 //
@@ -50,6 +50,30 @@ public:
   static std::vector <std::string> decomposeReference (const std::string&);
   std::string dump () const;
 
+  // A reference to the task being evaluated, resolved once so that it can be
+  // read directly from each task.  References to other tasks, by ID or UUID,
+  // and anything that is not a task attribute, are left unresolved.
+  class Accessor
+  {
+  public:
+    explicit Accessor (const std::string&);
+    bool get (const Task&, Variant&) const;
+
+  private:
+    enum kind
+    {
+      unresolved, id, urgency,
+      string, date, duration, numeric, tag, date_element,
+      annotation_count, annotation_entry, annotation_description, annotation_entry_element
+    };
+
+    kind        _kind    {unresolved};
+    std::string _name    {};       // Canonical attribute, or tag
+    bool        _uda     {false};
+    int         _number  {0};      // Annotation, counting from 1
+    int         _element {0};      // Date element
+  };
+
 private:
   class Node
   {
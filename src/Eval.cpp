@@ -31,10 +31,11 @@
 #include <Context.h>
 #include <Task.h>
 #include <Color.h>
+#include <ParseCache.h>
 #include <shared.h>
 #include <format.h>
 
-extern Task& contextTask;
+extern thread_local const Task* contextTask;
 
 ////////////////////////////////////////////////////////////////////////////////
 // Supported operators, borrowed from C++, particularly the precedence.
@@ -164,6 +165,28 @@ void Eval::compileExpression (
 {
   _compiled = precompiled;
 
+  // A repeated expression has the same postfix form.
+  std::string key;
+  auto stamp = _cache ? ParseCache::stamp () : "";
+  if (stamp != "")
+  {
+    key = "eval\n" + stamp;
+    for (auto& token : _compiled)
+    {
+      ParseCache::encode (key, token.first);
+      ParseCache::encode (key, format ((int) token.second));
+    }
+  }
+
+  std::string cached;
+  if (key != "" &&
+      ParseCache::get (key, cached) &&
+      decodeCompiled (cached))
+  {
+    compileBytecode ();
+    return;
+  }
+
   // Parse for syntax checking and operator replacement.
   if (_debug)
     Context::getContext ().debug ("[1;37;42mFILTER[0m Infix        " + dump (_compiled));
@@ -175,13 +198,48 @@ void Eval::compileExpression (
   infixToPostfix (_compiled);
   if (_debug)
     Context::getContext ().debug ("[1;37;42mFILTER[0m Postfix      " + dump (_compiled));
+
+  if (key != "")
+  {
+    for (auto& token : _compiled)
+    {
+      ParseCache::encode (cached, token.first);
+      ParseCache::encode (cached, format ((int) token.second));
+    }
+
+    ParseCache::put (key, cached);
+  }
+
+  // Lower postfix --> bytecode.
+  compileBytecode ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Restores _compiled from a parse cache entry.
+bool Eval::decodeCompiled (const std::string& cached)
+{
+  std::vector <std::pair <std::string, Lexer::Type>> compiled;
+  std::string::size_type cursor = 0;
+  while (cursor < cached.size ())
+  {
+    std::string token;
+    std::string type;
+    if (! ParseCache::decode (cached, cursor, token) ||
+        ! ParseCache::decode (cached, cursor, type))
+      return false;
+
+    compiled.push_back (std::pair <std::string, Lexer::Type> (token, (Lexer::Type) strtol (type.c_str (), nullptr, 10)));
+  }
+
+  _compiled = compiled;
+  return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 void Eval::evaluateCompiledExpression (Variant& v)
 {
-  // Call the postfix evaluator.
-  evaluatePostfixStack (_compiled, v);
+  // Call the bytecode evaluator.
+  evaluateBytecode (v);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -190,6 +248,13 @@ void Eval::debug (bool value)
   _debug = value;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Whether compiled expressions may be kept in the parse cache.
+void Eval::cache (bool value)
+{
+  _cache = value;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Static.
 std::vector <std::string> Eval::getOperators ()
@@ -213,6 +278,470 @@ std::vector <std::string> Eval::getBinaryOperators ()
   return all;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Lowers the postfix tokens in _compiled to bytecode, so that evaluation does
+// no string comparison of operators, and no casting of literals.
+void Eval::compileBytecode ()
+{
+  static const std::map <std::string, opcode> opcodes =
+  {
+    {"!",        op_not},
+    {"_neg_",    op_neg},
+    {"_pos_",    op_pos},
+    {"and",      op_and},
+    {"or",       op_or},
+    {"&&",       op_and},
+    {"||",       op_or},
+    {"xor",      op_xor},
+    {"<",        op_lt},
+    {"<=",       op_le},
+    {">",        op_gt},
+    {">=",       op_ge},
+    {"==",       op_eq},
+    {"!==",      op_ne},
+    {"=",        op_partial},
+    {"!=",       op_nopartial},
+    {"+",        op_add},
+    {"-",        op_sub},
+    {"*",        op_mul},
+    {"/",        op_div},
+    {"^",        op_exp},
+    {"%",        op_mod},
+    {"~",        op_match},
+    {"!~",       op_nomatch},
+    {"_hastag_", op_hastag},
+    {"_notag_",  op_notag},
+  };
+
+  std::vector <instruction> lowered;
+  lowered.reserve (_compiled.size ());
+
+  for (const auto& token : _compiled)
+  {
+    instruction i {op_literal, token.first, Variant (token.first), 0};
+
+    if (token.second == Lexer::Type::op)
+    {
+      auto found = opcodes.find (token.first);
+      i.op = found != opcodes.end () ? found->second : op_unsupported;
+    }
+    else
+    {
+      switch (token.second)
+      {
+      case Lexer::Type::number:
+        if (Lexer::isAllDigits (token.first))
+        {
+          i.value.cast (Variant::type_integer);
+          if (_debug)
+            Context::getContext ().debug (format ("Eval literal number ↑'{1}'", (std::string) i.value));
+        }
+        else
+        {
+          i.value.cast (Variant::type_real);
+          if (_debug)
+            Context::getContext ().debug (format ("Eval literal decimal ↑'{1}'", (std::string) i.value));
+        }
+        break;
+
+      case Lexer::Type::dom:
+      case Lexer::Type::identifier:
+        // Named constants are always the first source, and never vary, so they
+        // are resolved now.  Anything else depends on the task.
+        if (namedConstants (token.first, i.value))
+        {
+          if (_debug)
+            Context::getContext ().debug (format ("Eval identifier source '{1}' → ↑'{2}'", token.first, (std::string) i.value));
+        }
+        else
+          i.op = op_identifier;
+        break;
+
+      case Lexer::Type::date:
+        i.value.cast (Variant::type_date);
+        if (_debug)
+          Context::getContext ().debug (format ("Eval literal date ↑'{1}'", (std::string) i.value));
+        break;
+
+      case Lexer::Type::duration:
+        i.value.cast (Variant::type_duration);
+        if (_debug)
+          Context::getContext ().debug (format ("Eval literal duration ↑'{1}'", (std::string) i.value));
+        break;
+
+      // Nothing to do.
+      case Lexer::Type::string:
+      default:
+        if (_debug)
+          Context::getContext ().debug (format ("Eval literal string ↑'{1}'", (std::string) i.value));
+        break;
+      }
+    }
+
+    lowered.push_back (i);
+  }
+
+  _bytecode = optimize (lowered);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Rearranges lowered postfix code so that 'and' and 'or' skip their right
+// operand when the left one decides the result.  The terms of a chain of 'and'
+// are commutative, and are ordered cheapest first, so that regex matches and
+// DOM lookups are made last.
+//
+// Operators applied only to literals are evaluated now, so that expressions
+// such as 'now - 7d' are not evaluated for every task, and literal patterns are
+// prepared.  Malformed code is returned unchanged, to fail as usual when
+// evaluated.
+std::vector <Eval::instruction> Eval::optimize (const std::vector <instruction>& lowered) const
+{
+  struct fragment
+  {
+    std::vector <instruction>                                code;
+    int                                                      cost;
+    std::vector <std::pair <int, std::vector <instruction>>> terms;  // Of an 'and' chain
+    instruction                                              junction;
+  };
+
+  // Lays out the terms of an 'and' chain, each guarded by a jump.
+  auto assemble = [] (fragment& f)
+  {
+    if (f.terms.size () == 0)
+      return;
+
+    std::stable_sort (f.terms.begin (), f.terms.end (),
+                      [] (const std::pair <int, std::vector <instruction>>& left,
+                          const std::pair <int, std::vector <instruction>>& right)
+                      {
+                        return left.first < right.first;
+                      });
+
+    f.code = f.terms[0].second;
+    for (size_t t = 1; t < f.terms.size (); ++t)
+    {
+      auto& term = f.terms[t].second;
+      f.code.push_back ({op_jump_false, f.junction.token, Variant (false), term.size () + 1});
+      f.code.insert (f.code.end (), term.begin (), term.end ());
+      f.code.push_back (f.junction);
+    }
+
+    f.terms.clear ();
+  };
+
+  // The terms of an operand, which is a term itself unless it is a chain.
+  auto terms = [] (fragment& f, fragment& chain)
+  {
+    if (f.terms.size ())
+      chain.terms.insert (chain.terms.end (), f.terms.begin (), f.terms.end ());
+    else
+      chain.terms.push_back (std::pair <int, std::vector <instruction>> (f.cost, f.code));
+  };
+
+  std::vector <fragment> operands;
+  for (const auto& i : lowered)
+  {
+    if (i.op == op_literal || i.op == op_identifier)
+    {
+      int cost = i.op == op_identifier ? 4 : 0;
+      operands.push_back ({{i}, cost, {}, i});
+    }
+
+    else if (i.op == op_not || i.op == op_neg || i.op == op_pos)
+    {
+      if (operands.size () < 1)
+        return lowered;
+
+      auto& operand = operands.back ();
+      assemble (operand);
+
+      if (operand.code.size () == 1 &&
+          operand.code[0].op == op_literal)
+      {
+        try
+        {
+          auto value = operand.code[0].value;
+          if (i.op == op_not)
+            value = Variant (! value);
+          else if (i.op == op_neg)
+            value = Variant (0) - value;
+
+          operand.code[0] = {op_literal, (std::string) value, value, 0};
+          continue;
+        }
+
+        catch (...)
+        {
+          // Left to be raised when evaluated.
+        }
+      }
+
+      operand.code.push_back (i);
+      operand.cost += 1;
+    }
+
+    else
+    {
+      if (operands.size () < 2)
+        return lowered;
+
+      auto right = operands.back ();
+      operands.pop_back ();
+      auto left = operands.back ();
+      operands.pop_back ();
+
+      fragment result {{}, left.cost + right.cost + 1, {}, i};
+      if (i.op == op_and)
+      {
+        terms (left, result);
+        terms (right, result);
+      }
+      else
+      {
+        assemble (left);
+        assemble (right);
+
+        bool literals = left.code.size ()  == 1 && left.code[0].op  == op_literal &&
+                        right.code.size () == 1 && right.code[0].op == op_literal;
+
+        // A literal pattern is prepared once.
+        if ((i.op == op_match || i.op == op_nomatch) &&
+            right.code.size () == 1 &&
+            right.code[0].op == op_literal)
+          result.junction.pattern = Pattern (right.code[0].value);
+
+        if (literals && fold (i, left.code[0].value, right.code[0].value, result.code))
+        {
+          operands.push_back ({result.code, 0, {}, i});
+          continue;
+        }
+
+        result.code = left.code;
+        if (i.op == op_or)
+          result.code.push_back ({op_jump_true, i.token, Variant (true), right.code.size () + 1});
+        result.code.insert (result.code.end (), right.code.begin (), right.code.end ());
+        result.code.push_back (result.junction);
+
+        if (i.op == op_match || i.op == op_nomatch)
+          result.cost += 16;
+      }
+
+      operands.push_back (result);
+    }
+  }
+
+  if (operands.size () != 1)
+    return lowered;
+
+  assemble (operands[0]);
+  return operands[0].code;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Evaluates a binary operator applied to literals, when it does not depend on
+// the task.  Errors are left to be raised when the expression is evaluated.
+bool Eval::fold (
+  const instruction& i,
+  const Variant& left,
+  const Variant& right,
+  std::vector <instruction>& code) const
+{
+  if (i.op == op_match   || i.op == op_nomatch ||
+      i.op == op_hastag  || i.op == op_notag   ||
+      i.op == op_and     || i.op == op_or      ||
+      i.op == op_unsupported)
+    return false;
+
+  Variant value;
+  try
+  {
+    value = apply (i, left, right);
+  }
+
+  catch (...)
+  {
+    return false;
+  }
+
+  if (_debug)
+    Context::getContext ().debug (format ("Eval folded ↓'{1}' {2} ↓'{3}' → ↑'{4}'", (std::string) left, i.token, (std::string) right, (std::string) value));
+
+  code = {{op_literal, (std::string) value, value, 0}};
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Applies a binary operator.
+Variant Eval::apply (const instruction& i, const Variant& left, const Variant& right) const
+{
+  switch (i.op)
+  {
+  case op_and:       return left && right;
+  case op_or:        return left || right;
+  case op_lt:        return left < right;
+  case op_le:        return left <= right;
+  case op_gt:        return left > right;
+  case op_ge:        return left >= right;
+  case op_eq:        return left.operator== (right);
+  case op_ne:        return left.operator!= (right);
+  case op_partial:   return left.operator_partial (right);
+  case op_nopartial: return left.operator_nopartial (right);
+  case op_add:       return left + right;
+  case op_sub:       return left - right;
+  case op_mul:       return left * right;
+  case op_div:       return left / right;
+  case op_exp:       return left ^ right;
+  case op_mod:       return left % right;
+  case op_xor:       return left.operator_xor (right);
+  case op_match:     return match (i, left, right);
+  case op_nomatch:   return ! match (i, left, right);
+  case op_hastag:    return left.operator_hastag (right, *contextTask);
+  case op_notag:     return left.operator_notag (right, *contextTask);
+  default:
+    throw format ("Unsupported operator '{1}'.", i.token);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The ~ operator, using the pattern prepared at compile time if there is one.
+bool Eval::match (const instruction& i, const Variant& left, const Variant& right) const
+{
+  if (i.pattern.prepared ())
+    return i.pattern.match (left, *contextTask);
+
+  return left.operator_match (right, *contextTask);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Equivalent to evaluatePostfixStack, for the bytecode in _bytecode.
+void Eval::evaluateBytecode (Variant& result) const
+{
+  if (_bytecode.size () == 0)
+    throw std::string ("No expression to evaluate.");
+
+  // This is stack used by the postfix evaluator, kept between evaluations so
+  // that it is allocated only once.
+  auto& values = _stack;
+  values.clear ();
+  values.reserve (_bytecode.size ());
+
+  for (size_t pc = 0; pc < _bytecode.size (); ++pc)
+  {
+    const auto& i = _bytecode[pc];
+    switch (i.op)
+    {
+    case op_literal:
+      values.push_back (i.value);
+      break;
+
+    // The left operand of 'and' or 'or' that decides the result replaces it,
+    // and the right operand is skipped.
+    case op_jump_false:
+    case op_jump_true:
+      {
+        if (values.size () < 1)
+          throw std::string ("The expression could not be evaluated.");
+
+        bool decided = i.op == op_jump_false ? ! (Variant (true) && values.back ())
+                                             : (Variant (false) || values.back ());
+        if (decided)
+        {
+          if (_debug)
+            Context::getContext ().debug (format ("Eval {1} ↓'{2}' → ↑'{3}' skips right operand", i.token, (std::string) values.back (), (std::string) i.value));
+
+          values.back () = i.value;
+          pc += i.jump;
+        }
+      }
+      break;
+
+    case op_identifier:
+      {
+        // Named constants, the first source, were resolved at compile time.
+        Variant v (i.token);
+        bool found = false;
+        for (auto source = _sources.begin () + 1; source != _sources.end (); ++source)
+        {
+          if ((*source) (i.token, v))
+          {
+            if (_debug)
+              Context::getContext ().debug (format ("Eval identifier source '{1}' → ↑'{2}'", i.token, (std::string) v));
+            found = true;
+            break;
+          }
+        }
+
+        // An identifier that fails lookup is a string.
+        if (! found)
+        {
+          v.cast (Variant::type_string);
+          if (_debug)
+            Context::getContext ().debug (format ("Eval identifier source failed '{1}'", i.token));
+        }
+
+        values.push_back (std::move (v));
+      }
+      break;
+
+    case op_pos:
+      // The _pos_ operator is a NOP.
+      if (_debug)
+        Context::getContext ().debug (format ("[{1}] eval op {2} NOP", values.size (), i.token));
+      break;
+
+    // Unary operators.
+    case op_not:
+    case op_neg:
+      {
+        if (values.size () < 1)
+          throw std::string ("The expression could not be evaluated.");
+
+        Variant right = std::move (values.back ());
+        Variant& top = values.back ();
+        if (i.op == op_not)
+        {
+          top = ! right;
+        }
+        else
+        {
+          top = Variant (0);
+          top -= right;
+        }
+
+        if (_debug)
+          Context::getContext ().debug (format ("Eval {1} ↓'{2}' → ↑'{3}'", i.token, (std::string) right, (std::string) top));
+      }
+      break;
+
+    // Binary operators.
+    default:
+      {
+        if (values.size () < 2)
+          throw std::string ("The expression could not be evaluated.");
+
+        Variant right = std::move (values.back ());
+        values.pop_back ();
+
+        Variant left = std::move (values.back ());
+        Variant& top = values.back ();
+
+        top = apply (i, left, right);
+
+        if (_debug)
+          Context::getContext ().debug (format ("Eval ↓'{1}' {2} ↓'{3}' → ↑'{4}'", (std::string) left, i.token, (std::string) right, (std::string) top));
+      }
+      break;
+    }
+  }
+
+  // If there is more than one variant left on the stack, then the original
+  // expression was not valid.
+  if (values.size () != 1)
+    throw std::string ("The value is not an expression.");
+
+  result = std::move (values[0]);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void Eval::evaluatePostfixStack (
   const std::vector <std::pair <std::string, Lexer::Type>>& tokens,
@@ -296,10 +825,10 @@ void Eval::evaluatePostfixStack (
       else if (token.first == "^")        result = left ^ right;
       else if (token.first == "%")        result = left % right;
       else if (token.first == "xor")      result = left.operator_xor (right);
-      else if (token.first == "~")        result = left.operator_match (right, contextTask);
-      else if (token.first == "!~")       result = left.operator_nomatch (right, contextTask);
-      else if (token.first == "_hastag_") result = left.operator_hastag (right, contextTask);
-      else if (token.first == "_notag_")  result = left.operator_notag (right, contextTask);
+      else if (token.first == "~")        result = left.operator_match (right, *contextTask);
+      else if (token.first == "!~")       result = left.operator_nomatch (right, *contextTask);
+      else if (token.first == "_hastag_") result = left.operator_hastag (right, *contextTask);
+      else if (token.first == "_notag_")  result = left.operator_notag (right, *contextTask);
       else
         throw format ("Unsupported operator '{1}'.", token.first);
 
@@ -31,6 +31,7 @@
 #include <string>
 #include <Lexer.h>
 #include <Variant.h>
+#include <Pattern.h>
 
 class Eval
 {
@@ -43,11 +44,43 @@ public:
   void compileExpression (const std::vector <std::pair <std::string, Lexer::Type>>&);
   void evaluateCompiledExpression (Variant&);
   void debug (bool);
+  void cache (bool);
 
   static std::vector <std::string> getOperators ();
   static std::vector <std::string> getBinaryOperators ();
 
 private:
+  // Compiled form of a postfix expression.  Operators are resolved to opcodes
+  // and literals are cast once, at compile time.
+  enum opcode
+  {
+    op_literal, op_identifier,
+    op_not, op_neg, op_pos,
+    op_and, op_or, op_xor,
+    op_lt, op_le, op_gt, op_ge,
+    op_eq, op_ne, op_partial, op_nopartial,
+    op_add, op_sub, op_mul, op_div, op_exp, op_mod,
+    op_match, op_nomatch, op_hastag, op_notag,
+    op_jump_false, op_jump_true,
+    op_unsupported
+  };
+
+  struct instruction
+  {
+    opcode      op;
+    std::string token;
+    Variant     value;
+    size_t      jump;        // Instructions skipped by a jump
+    Pattern     pattern {};  // A literal right operand of ~ or !~
+  };
+
+  void compileBytecode ();
+  std::vector <instruction> optimize (const std::vector <instruction>&) const;
+  bool fold (const instruction&, const Variant&, const Variant&, std::vector <instruction>&) const;
+  bool decodeCompiled (const std::string&);
+  void evaluateBytecode (Variant&) const;
+  Variant apply (const instruction&, const Variant&, const Variant&) const;
+  bool match (const instruction&, const Variant&, const Variant&) const;
   void evaluatePostfixStack (const std::vector <std::pair <std::string, Lexer::Type>>&, Variant&) const;
   void infixToPostfix (std::vector <std::pair <std::string, Lexer::Type>>&) const;
   void infixParse (std::vector <std::pair <std::string, Lexer::Type>>&) const;
@@ -68,7 +101,10 @@ private:
 private:
   std::vector <bool (*)(const std::string&, Variant&)> _sources {};
   bool _debug                                                   {false};
+  bool _cache                                                   {false};
   std::vector <std::pair <std::string, Lexer::Type>> _compiled  {};
+  std::vector <instruction> _bytecode                           {};
+  mutable std::vector <Variant> _stack                          {};  // Reused by evaluateBytecode
 };
 
 #endif
@@ -27,8 +27,11 @@
 #include <cmake.h>
 #include <Filter.h>
 #include <algorithm>
+#include <unordered_set>
 #include <Context.h>
+#include <Pool.h>
 #include <Timer.h>
+#include <Trace.h>
 #include <DOM.h>
 #include <Eval.h>
 #include <Variant.h>
@@ -36,14 +39,551 @@
 #include <shared.h>
 
 ////////////////////////////////////////////////////////////////////////////////
-// Const iterator that can be derefenced into a Task by domSource.
+// The task being evaluated, which is dereferenced by domSource.  It points at
+// the task itself, rather than a copy, and is per-thread so that filters can be
+// evaluated in parallel.
 static Task dummy;
-Task& contextTask = dummy;
+thread_local const Task* contextTask = &dummy;
+
+// Fewest tasks worth handing to a thread of their own.
+#define FILTER_CHUNK_MINIMUM 1000
+
+// Most alternatives that bounds keep, beyond which only their union is kept.
+#define MAX_ALTERNATIVES 8
+
+using Tokens = std::vector <std::pair <std::string, Lexer::Type>>;
+
+////////////////////////////////////////////////////////////////////////////////
+// Position of the parenthesis that closes the one at begin, or end if none.
+static size_t closing (const Tokens& tokens, size_t begin, size_t end)
+{
+  int depth = 0;
+  for (auto i = begin; i < end; ++i)
+  {
+    if (tokens[i].second == Lexer::Type::op)
+    {
+      if (tokens[i].first == "(")
+        ++depth;
+      else if (tokens[i].first == ")" && --depth == 0)
+        return i;
+    }
+  }
+
+  return end;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The alternatives that make up the bounds, which are the bounds themselves if
+// they have none.
+static std::vector <TF2Index::Bounds> alternatives (const TF2Index::Bounds& bounds)
+{
+  if (! bounds.either.empty ())
+    return bounds.either;
+
+  return std::vector <TF2Index::Bounds> {bounds};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Bounds that hold for tasks within either a or b.  Each is also kept as an
+// alternative, as the union of, say, pending tasks started lately and tasks
+// completed lately is every task.
+static TF2Index::Bounds unite (const TF2Index::Bounds& a, const TF2Index::Bounds& b)
+{
+  if (a.none) return b;
+  if (b.none) return a;
+
+  TF2Index::Bounds u;
+  u.entry_min    = std::min (a.entry_min,    b.entry_min);
+  u.entry_max    = std::max (a.entry_max,    b.entry_max);
+  u.end_min      = std::min (a.end_min,      b.end_min);
+  u.end_max      = std::max (a.end_max,      b.end_max);
+  u.modified_min = std::min (a.modified_min, b.modified_min);
+  u.modified_max = std::max (a.modified_max, b.modified_max);
+  u.due_min      = std::min (a.due_min,      b.due_min);
+  u.due_max      = std::max (a.due_max,      b.due_max);
+
+  // The common prefix.
+  size_t common = 0;
+  while (common < a.project.length () &&
+         common < b.project.length () &&
+         a.project[common] == b.project[common])
+    ++common;
+  u.project = a.project.substr (0, common);
+
+  if (a.statuses != "" && b.statuses != "")
+    u.statuses = a.statuses + b.statuses;
+
+  if (! a.any_uuid && ! b.any_uuid)
+  {
+    u.any_uuid = false;
+    u.uuids = a.uuids;
+    u.uuids.insert (u.uuids.end (), b.uuids.begin (), b.uuids.end ());
+  }
+
+  // The words common to both.
+  for (auto& word : a.words)
+    if (std::find (b.words.begin (), b.words.end (), word) != b.words.end ())
+      u.words.push_back (word);
+
+  u.either = alternatives (a);
+  for (auto& alternative : alternatives (b))
+    u.either.push_back (alternative);
+
+  if (u.either.size () > MAX_ALTERNATIVES)
+    u.either.clear ();
+
+  return u;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Bounds that hold for tasks within both a and b.  Where an intersection is not
+// simply expressed, the narrower of the two is kept.
+static TF2Index::Bounds intersect (const TF2Index::Bounds& a, const TF2Index::Bounds& b)
+{
+  TF2Index::Bounds i;
+  i.none         = a.none || b.none;
+  i.entry_min    = std::max (a.entry_min,    b.entry_min);
+  i.entry_max    = std::min (a.entry_max,    b.entry_max);
+  i.end_min      = std::max (a.end_min,      b.end_min);
+  i.end_max      = std::min (a.end_max,      b.end_max);
+  i.modified_min = std::max (a.modified_min, b.modified_min);
+  i.modified_max = std::min (a.modified_max, b.modified_max);
+  i.due_min      = std::max (a.due_min,      b.due_min);
+  i.due_max      = std::min (a.due_max,      b.due_max);
+
+  // One prefix must extend the other.
+  auto& shorter = a.project.length () < b.project.length () ? a.project : b.project;
+  auto& longer  = a.project.length () < b.project.length () ? b.project : a.project;
+  if (longer.compare (0, shorter.length (), shorter) == 0)
+    i.project = longer;
+  else
+    i.none = true;
+
+  if (a.statuses == "" || b.statuses == "")
+    i.statuses = a.statuses + b.statuses;
+  else
+  {
+    for (auto status : a.statuses)
+      if (b.statuses.find (status) != std::string::npos)
+        i.statuses += status;
+
+    if (i.statuses == "")
+      i.none = true;
+  }
+
+  if (! a.any_uuid || ! b.any_uuid)
+  {
+    i.any_uuid = false;
+    i.uuids = a.any_uuid                         ? b.uuids :
+              b.any_uuid                         ? a.uuids :
+              a.uuids.size () <= b.uuids.size () ? a.uuids : b.uuids;
+  }
+
+  i.words = a.words;
+  i.words.insert (i.words.end (), b.words.begin (), b.words.end ());
+
+  // The intersection distributes over the alternatives of either.
+  if (! i.none &&
+      (! a.either.empty () || ! b.either.empty ()) &&
+      alternatives (a).size () * alternatives (b).size () <= MAX_ALTERNATIVES)
+  {
+    for (auto& x : alternatives (a))
+      for (auto& y : alternatives (b))
+      {
+        auto alternative = intersect (x, y);
+        if (! alternative.none)
+          i.either.push_back (alternative);
+      }
+
+    if (i.either.empty ())
+      i.none = true;
+  }
+
+  return i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Bounds for a single comparison, '<attribute> <op> <value>', of an attribute
+// that the index records, where the value is an expression of constants only.
+// Anything else is unbounded.  Numbered is set for tasks that may have IDs.
+static TF2Index::Bounds compare (
+  const Tokens& tokens,
+  size_t begin,
+  size_t end,
+  bool numbered)
+{
+  TF2Index::Bounds bounds;
+  if (end - begin < 3                              ||
+      tokens[begin].second     != Lexer::Type::dom ||
+      tokens[begin + 1].second != Lexer::Type::op)
+    return bounds;
+
+  for (auto i = begin + 2; i < end; ++i)
+    if (tokens[i].second == Lexer::Type::dom  ||
+        tokens[i].second == Lexer::Type::uuid ||
+        tokens[i].second == Lexer::Type::pair)
+      return bounds;
+
+  // The virtual tags of a status are equivalent to a status comparison.
+  static const std::map <std::string, std::string> statusTags =
+  {
+    {"PENDING",   "p"},
+    {"WAITING",   "w"},
+    {"COMPLETED", "c"},
+    {"DELETED",   "d"},
+  };
+
+  auto& name = tokens[begin].first;
+  auto& op   = tokens[begin + 1].first;
+  if (name == "tags" && op == "_hastag_" && end - begin == 3)
+  {
+    auto tag = statusTags.find (tokens[begin + 2].first);
+    if (tag != statusTags.end ())
+      bounds.statuses = tag->second;
+
+    return bounds;
+  }
+
+  Variant value;
+  try
+  {
+    Eval eval;
+    eval.compileExpression (Tokens (tokens.begin () + begin + 2, tokens.begin () + end));
+    eval.evaluateCompiledExpression (value);
+  }
+
+  catch (...)
+  {
+    return bounds;
+  }
+
+  int64_t* min = nullptr;
+  int64_t* max = nullptr;
+  if (name == "entry")         { min = &bounds.entry_min;    max = &bounds.entry_max;    }
+  else if (name == "end")      { min = &bounds.end_min;      max = &bounds.end_max;      }
+  else if (name == "modified") { min = &bounds.modified_min; max = &bounds.modified_max; }
+  else if (name == "due")      { min = &bounds.due_min;      max = &bounds.due_max;      }
+
+  if (min && value.type () == Variant::type_date)
+  {
+    int64_t date = value.get_date ();
+         if (op == ">")  *min = date + 1;
+    else if (op == ">=") *min = date;
+    else if (op == "<")  *max = date - 1;
+    else if (op == "<=") *max = date;
+  }
+
+  // The bounds only apply to files without IDs, where no task matches a
+  // positive one.
+  else if (! numbered && name == "id" && (op == "==" || op == ">=") &&
+           value.type () == Variant::type_integer && value.get_integer () > 0)
+  {
+    bounds.none = true;
+  }
+
+  else if (value.type () == Variant::type_string)
+  {
+    auto text = value.get_string ();
+    Lexer::dequote (text);
+
+    // 'project:X' is a left match.  Values that are stored encoded are ignored.
+    if (name == "project" && op == "=" && text != "" &&
+        text.find_first_of ("\"\\[]&") == std::string::npos)
+      bounds.project = text;
+
+    // Status is compared caseless, and in full.
+    else if (name == "status" && (op == "=" || op == "=="))
+    {
+      text = lowerCase (text);
+      if (text == "pending"   || text == "waiting" || text == "recurring" ||
+          text == "completed" || text == "deleted")
+        bounds.statuses = text.substr (0, 1);
+    }
+
+    // 'uuid:X' is a left match.
+    else if (name == "uuid" && op == "=" && text != "")
+    {
+      bounds.any_uuid = false;
+      bounds.uuids.push_back (text);
+    }
+
+    // 'description ~ X' holds X, in the description or an annotation, unless
+    // X is a regex.
+    else if (name == "description" && op == "~" && text != "" &&
+             (! Variant::searchUsingRegex ||
+              text.find_first_of ("\\^$.|?*+()[]{}") == std::string::npos))
+      bounds.words.push_back (text);
+  }
+
+  return bounds;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Narrows [begin, end) to within any enclosing parentheses.
+static void unwrap (const Tokens& tokens, size_t& begin, size_t& end)
+{
+  while (end - begin >= 2 &&
+         tokens[begin].second == Lexer::Type::op &&
+         tokens[begin].first == "(" &&
+         closing (tokens, begin, end) == end - 1)
+  {
+    ++begin;
+    --end;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The positions of top-level 'or' and 'and', which binds more tightly.  False
+// if there is a top-level 'xor' or 'not', which are not split.
+static bool junctions (
+  const Tokens& tokens,
+  size_t begin,
+  size_t end,
+  std::vector <size_t>& ors,
+  std::vector <size_t>& ands)
+{
+  int depth = 0;
+  for (auto i = begin; i < end; ++i)
+  {
+    if (tokens[i].second != Lexer::Type::op)
+      continue;
+
+    auto& op = tokens[i].first;
+         if (op == "(")                              ++depth;
+    else if (op == ")")                              --depth;
+    else if (depth)                                  ;
+    else if (op == "or"  || op == "||")              ors.push_back (i);
+    else if (op == "and" || op == "&&")              ands.push_back (i);
+    else if (op == "xor" || op == "!" || op == "not") return false;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Bounds that hold for every task that the infix expression matches.  Terms
+// joined by 'or' unite their bounds, and terms joined by 'and' intersect them.
+// Anything not understood is unbounded, so the result may be wider than the
+// expression, but is never narrower.
+static TF2Index::Bounds bounds (
+  const Tokens& tokens,
+  size_t begin,
+  size_t end,
+  bool numbered = false)
+{
+  unwrap (tokens, begin, end);
+
+  std::vector <size_t> ors;
+  std::vector <size_t> ands;
+  if (! junctions (tokens, begin, end, ors, ands))
+    return TF2Index::Bounds ();
+
+  if (ors.size ())
+  {
+    ors.push_back (end);
+    auto result = bounds (tokens, begin, ors[0], numbered);
+    for (size_t i = 0; i + 1 < ors.size (); ++i)
+      result = unite (result, bounds (tokens, ors[i] + 1, ors[i + 1], numbered));
+
+    return result;
+  }
+
+  if (ands.size ())
+  {
+    ands.push_back (end);
+    auto result = bounds (tokens, begin, ands[0], numbered);
+    for (size_t i = 0; i + 1 < ands.size (); ++i)
+      result = intersect (result, bounds (tokens, ands[i] + 1, ands[i + 1], numbered));
+
+    return result;
+  }
+
+  return compare (tokens, begin, end, numbered);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Whether a task cannot lie within the bounds, judged from its status, dates,
+// project and uuid alone.  This is TF2Index::excludes for a task in memory, and
+// is far cheaper than evaluating the filter.
+static bool excluded (const Task& task, const TF2Index::Bounds& bounds)
+{
+  if (bounds.none)
+    return true;
+
+  if (! bounds.either.empty ())
+  {
+    for (auto& alternative : bounds.either)
+      if (! excluded (task, alternative))
+        return false;
+
+    return true;
+  }
+
+  if (bounds.statuses != "")
+  {
+    auto& status = task.get_ref ("status");
+    if (bounds.statuses.find (status == "" ? 'p' : tolower (status[0])) == std::string::npos)
+      return true;
+  }
+
+  auto outside = [&task] (const std::string& name, int64_t min, int64_t max)
+  {
+    if (min == INT64_MIN && max == INT64_MAX)
+      return false;
+
+    auto date = (int64_t) task.get_date (name);
+    return date != 0 && (date < min || date > max);
+  };
+
+  if (outside ("entry",    bounds.entry_min,    bounds.entry_max)    ||
+      outside ("end",      bounds.end_min,      bounds.end_max)      ||
+      outside ("modified", bounds.modified_min, bounds.modified_max) ||
+      outside ("due",      bounds.due_min,      bounds.due_max))
+    return true;
+
+  if (bounds.project != "" &&
+      task.get_ref ("project").compare (0, bounds.project.length (), bounds.project) != 0)
+    return true;
+
+  if (! bounds.any_uuid)
+  {
+    auto& uuid = task.get_ref ("uuid");
+    for (auto& prefix : bounds.uuids)
+      if (uuid.compare (0, prefix.length (), prefix) == 0)
+        return false;
+
+    return true;
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Whether the infix expression is a set of IDs and full UUIDs, joined by 'or',
+// as CLI2::insertIDExpr writes them.  The ID ranges and UUIDs are appended.
+static bool idSet (
+  const Tokens& tokens,
+  size_t begin,
+  size_t end,
+  std::vector <std::pair <int, int>>& ranges,
+  std::vector <std::string>& uuids)
+{
+  unwrap (tokens, begin, end);
+
+  std::vector <size_t> ors;
+  std::vector <size_t> ands;
+  if (! junctions (tokens, begin, end, ors, ands))
+    return false;
+
+  if (ors.size ())
+  {
+    ors.push_back (end);
+    if (! idSet (tokens, begin, ors[0], ranges, uuids))
+      return false;
+
+    for (size_t i = 0; i + 1 < ors.size (); ++i)
+      if (! idSet (tokens, ors[i] + 1, ors[i + 1], ranges, uuids))
+        return false;
+
+    return true;
+  }
+
+  auto is = [&] (size_t i, Lexer::Type type, const std::string& text)
+  {
+    return tokens[begin + i].second == type && tokens[begin + i].first == text;
+  };
+
+  auto number = [&] (size_t i)
+  {
+    auto& token = tokens[begin + i];
+    return token.second == Lexer::Type::number && Lexer::isAllDigits (token.first)
+             ? strtol (token.first.c_str (), nullptr, 10)
+             : 0;
+  };
+
+  // id == <n>
+  if (end - begin == 3 &&
+      is (0, Lexer::Type::dom, "id") && is (1, Lexer::Type::op, "==") &&
+      number (2) > 0)
+  {
+    ranges.push_back (std::pair <int, int> (number (2), number (2)));
+    return true;
+  }
+
+  // id >= <low> and id <= <high>
+  if (end - begin == 7 &&
+      is (0, Lexer::Type::dom, "id") && is (1, Lexer::Type::op, ">=") &&
+      is (3, Lexer::Type::op, "and") &&
+      is (4, Lexer::Type::dom, "id") && is (5, Lexer::Type::op, "<=") &&
+      number (2) > 0 && number (6) > 0)
+  {
+    ranges.push_back (std::pair <int, int> (number (2), number (6)));
+    return true;
+  }
+
+  // uuid = <uuid>, where a full UUID matches only itself.
+  if (end - begin == 3 &&
+      is (0, Lexer::Type::dom, "uuid") && is (1, Lexer::Type::op, "="))
+  {
+    auto text = tokens[begin + 2].first;
+    Lexer::dequote (text);
+
+    Lexer lexer (text);
+    std::string uuid;
+    Lexer::Type type;
+    if (text.length () == 36      &&
+        lexer.token (uuid, type)  &&
+        type == Lexer::Type::uuid &&
+        uuid == text)
+    {
+      uuids.push_back (text);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Whether the infix expression is an ID set, or has one among the terms that
+// it joins by 'and'.  Every task it matches is then in that set.
+static bool idConjunct (
+  const Tokens& tokens,
+  size_t begin,
+  size_t end,
+  std::vector <std::pair <int, int>>& ranges,
+  std::vector <std::string>& uuids)
+{
+  if (idSet (tokens, begin, end, ranges, uuids))
+    return true;
+
+  ranges.clear ();
+  uuids.clear ();
+
+  unwrap (tokens, begin, end);
+
+  std::vector <size_t> ors;
+  std::vector <size_t> ands;
+  if (! junctions (tokens, begin, end, ors, ands) ||
+      ors.size ()                                 ||
+      ! ands.size ())
+    return false;
+
+  ands.push_back (end);
+  if (idConjunct (tokens, begin, ands[0], ranges, uuids))
+    return true;
+
+  for (size_t i = 0; i + 1 < ands.size (); ++i)
+    if (idConjunct (tokens, ands[i] + 1, ands[i + 1], ranges, uuids))
+      return true;
+
+  return false;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 bool domSource (const std::string& identifier, Variant& value)
 {
-  if (getDOM (identifier, contextTask, value))
+  if (getDOM (identifier, *contextTask, value))
   {
     value.source (identifier);
     return true;
@@ -56,14 +596,16 @@ bool domSource (const std::string& identifier, Variant& value)
 // Take an input set of tasks and filter into a subset.
 void Filter::subset (const std::vector <Task>& input, std::vector <Task>& output)
 {
+  Trace::Span span ("filter");
   Timer timer;
   _startCount = (int) input.size ();
+  _endCount = 0;
 
   Context::getContext ().cli2.prepareFilter ();
 
   std::vector <std::pair <std::string, Lexer::Type>> precompiled;
   for (auto& a : Context::getContext ().cli2._args)
-    if (a.hasTag ("FILTER"))
+    if (a.hasTag (A2::Tag::FILTER))
       precompiled.push_back (std::pair <std::string, Lexer::Type> (a.getToken (), a._lextype));
 
   if (precompiled.size ())
@@ -74,25 +616,28 @@ void Filter::subset (const std::vector <Task>& input, std::vector <Task>& output
     // Debug output from Eval during compilation is useful.  During evaluation
     // it is mostly noise.
     eval.debug (Context::getContext ().config.getInteger ("debug.parser") >= 3 ? true : false);
+    eval.cache (true);
     eval.compileExpression (precompiled);
 
-    for (auto& task : input)
+    auto limits = bounds (precompiled, 0, precompiled.size (), true);
+    std::function <void (const Task&)> append = [&] (const Task& task)
     {
-      // Set up context for any DOM references.
-      contextTask = task;
-
-      Variant var;
-      eval.evaluateCompiledExpression (var);
-      if (var.get_bool ())
-        output.push_back (task);
-    }
-
+      ++_endCount;
+      output.push_back (task);
+    };
+    evaluate (eval, limits, input, append);
     eval.debug (false);
   }
   else
+  {
     output = input;
+    if (_limit && output.size () > (size_t) _limit)
+      output.resize (_limit);
+  }
 
   _endCount = (int) output.size ();
+  Context::getContext ().count_loaded   += _startCount;
+  Context::getContext ().count_filtered += _endCount;
   Context::getContext ().debug (format ("Filtered {1} tasks --> {2} tasks [list subset]", _startCount, _endCount));
   Context::getContext ().time_filter_us += timer.total_us ();
 }
@@ -100,22 +645,100 @@ void Filter::subset (const std::vector <Task>& input, std::vector <Task>& output
 ////////////////////////////////////////////////////////////////////////////////
 // Take the set of all tasks and filter into a subset.
 void Filter::subset (std::vector <Task>& output)
+{
+  output.clear ();
+  visit ([&output] (const Task& task) { output.push_back (task); });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Filter the set of all tasks, as subset does, but pass each matching task to
+// the callback instead of copying it.  Commands that only need a field or two
+// of each task avoid the copies.
+void Filter::visit (std::function <void (const Task&)> callback)
+{
+  Timer timer;
+  auto precompiled = prepare ();
+  Context::getContext ().time_filter_us += timer.total_us ();
+
+  visit (precompiled, callback);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The number of tasks that match the filter, not counting recurring templates.
+// A filter that is a single project, tag or status term is answered from the
+// project and tag counts, without reading any task, and any other filter is
+// evaluated without copying the tasks.
+int Filter::count ()
 {
   Timer timer;
+  auto precompiled = prepare ();
+  Context::getContext ().time_filter_us += timer.total_us ();
+
+  int total = 0;
+  if (counted (precompiled, total))
+  {
+    Context::getContext ().debug (format ("Filtered 0 tasks --> {1} tasks [counts]", total));
+    return total;
+  }
+
+  visit (precompiled, [&total] (const Task& task)
+  {
+    if (task.getStatus () != Task::recurring)
+      ++total;
+  });
+
+  return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Stops filtering once this many tasks match, so that only the first of them,
+// in the order of the data files, are passed on.  Zero means no limit.
+void Filter::limit (int value)
+{
+  _limit = std::max (value, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The desugared filter, as tokens for Eval.
+std::vector <std::pair <std::string, Lexer::Type>> Filter::prepare () const
+{
   Context::getContext ().cli2.prepareFilter ();
 
   std::vector <std::pair <std::string, Lexer::Type>> precompiled;
   for (auto& a : Context::getContext ().cli2._args)
-    if (a.hasTag ("FILTER"))
+    if (a.hasTag (A2::Tag::FILTER))
       precompiled.push_back (std::pair <std::string, Lexer::Type> (a.getToken (), a._lextype));
 
-  // Shortcut indicates that only pending.data needs to be loaded.
+  return precompiled;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Filter::visit (
+  const std::vector <std::pair <std::string, Lexer::Type>>& precompiled,
+  std::function <void (const Task&)> callback)
+{
+  Trace::Span span ("filter");
+  Timer timer;
+
+  // Shortcut indicates that only pending.data needs to be loaded, and lookup
+  // that only the tasks in an ID set were evaluated.
   bool shortcut = false;
+  bool lookup = false;
+
+  _endCount = 0;
+  std::function <void (const Task&)> emit = [&] (const Task& task)
+  {
+    if (full ())
+      return;
+
+    ++_endCount;
+    callback (task);
+  };
 
   if (precompiled.size ())
   {
     Timer timer_pending;
-    auto pending = Context::getContext ().tdb2.pending.get_tasks ();
+    auto& pending = Context::getContext ().tdb2.pending.get_tasks ();
     Context::getContext ().time_filter_us -= timer_pending.total_us ();
     _startCount = (int) pending.size ();
 
@@ -125,40 +748,61 @@ void Filter::subset (std::vector <Task>& output)
     // Debug output from Eval during compilation is useful.  During evaluation
     // it is mostly noise.
     eval.debug (Context::getContext ().config.getInteger ("debug.parser") >= 3 ? true : false);
+    eval.cache (true);
     eval.compileExpression (precompiled);
 
-    output.clear ();
-    for (auto& task : pending)
-    {
-      // Set up context for any DOM references.
-      contextTask = task;
+    // Pending tasks have IDs, so are bounded apart from completed tasks.
+    auto numbered = bounds (precompiled, 0, precompiled.size (), true);
 
-      Variant var;
-      eval.evaluateCompiledExpression (var);
-      if (var.get_bool ())
-        output.push_back (task);
+    std::vector <Task> candidates;
+    lookup = candidatesByID (precompiled, candidates);
+    if (lookup)
+    {
+      _startCount = (int) candidates.size ();
+      evaluate (eval, numbered, candidates, emit);
     }
+    else
+      evaluate (eval, numbered, pending, emit);
 
-    shortcut = pendingOnly ();
-    if (! shortcut)
+    shortcut = lookup || pendingOnly ();
+    if (! shortcut && ! full ())
     {
-      Timer timer_completed;
-      auto completed = Context::getContext ().tdb2.completed.get_tasks ();
-      Context::getContext ().time_filter_us -= timer_completed.total_us ();
-      _startCount += (int) completed.size ();
+      // Only the completed tasks that may match are read.  For a read-only
+      // command, they are evaluated as they are parsed, and only the matches
+      // are kept, unless the index allows a partial read.
+      auto limits = bounds (precompiled, 0, precompiled.size ());
+      auto& file = Context::getContext ().tdb2.completed;
+
+      auto loaded = Context::getContext ().time_load_us;
+      bool streamed = readOnly () &&
+                      file.stream ([&] (const std::vector <Task>& block)
+                      {
+                        _startCount += (int) block.size ();
+                        evaluate (eval, limits, block, emit);
+                        return ! full ();
+                      });
+      Context::getContext ().time_filter_us -= Context::getContext ().time_load_us - loaded;
 
-      for (auto& task : completed)
+      if (! streamed)
       {
-        // Set up context for any DOM references.
-        contextTask = task;
+        Timer timer_completed;
+        auto& completed = file.get_tasks (limits);
+        Context::getContext ().time_filter_us -= timer_completed.total_us ();
+        _startCount += (int) completed.size ();
 
-        Variant var;
-        eval.evaluateCompiledExpression (var);
-        if (var.get_bool ())
-          output.push_back (task);
+        evaluate (eval, limits, completed, emit);
       }
     }
 
+    // The tasks of other data locations follow, for a read-only command that
+    // does not select tasks by ID.
+    if (! lookup && ! full () && readOnly ())
+    {
+      auto& federated = Context::getContext ().tdb2.federated ();
+      _startCount += (int) federated.size ();
+      evaluate (eval, bounds (precompiled, 0, precompiled.size ()), federated, emit);
+    }
+
     eval.debug (false);
   }
   else
@@ -167,23 +811,273 @@ void Filter::subset (std::vector <Task>& output)
 
     Timer pending_completed;
     for (auto& task : Context::getContext ().tdb2.pending.get_tasks ())
-      output.push_back (task);
+      emit (task);
 
-    for (auto& task : Context::getContext ().tdb2.completed.get_tasks ())
-      output.push_back (task);
+    if (! full ())
+    {
+      auto& file = Context::getContext ().tdb2.completed;
+      bool streamed = readOnly () &&
+                      file.stream ([&] (const std::vector <Task>& block)
+                      {
+                        for (auto& task : block)
+                          emit (task);
+                        return ! full ();
+                      });
+
+      if (! streamed)
+        for (auto& task : file.get_tasks ())
+          emit (task);
+    }
+
+    if (! full () && readOnly ())
+      for (auto& task : Context::getContext ().tdb2.federated ())
+        emit (task);
     Context::getContext ().time_filter_us -= pending_completed.total_us ();
   }
 
-  _endCount = (int) output.size ();
-  Context::getContext ().debug (format ("Filtered {1} tasks --> {2} tasks [{3}]", _startCount, _endCount, (shortcut ? "pending only" : "all tasks")));
+  Context::getContext ().count_loaded   += _startCount;
+  Context::getContext ().count_filtered += _endCount;
+  Context::getContext ().debug (format ("Filtered {1} tasks --> {2} tasks [{3}]", _startCount, _endCount, (lookup ? "id lookup" : shortcut ? "pending only" : "all tasks")));
   Context::getContext ().time_filter_us += timer.total_us ();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Counts the tasks that match a filter of no terms, or of one project, tag or
+// status term, from the project and tag counts.  Virtual tags, and values that
+// Eval would resolve as DOM references, are left to evaluation.
+bool Filter::counted (const Tokens& precompiled, int& total) const
+{
+  // The counts are of this data location alone.
+  if (Context::getContext ().config.get ("data.sources") != "")
+    return false;
+
+  size_t begin = 0;
+  size_t end = precompiled.size ();
+  while (end - begin >= 2 && closing (precompiled, begin, end) == end - 1)
+  {
+    ++begin;
+    --end;
+  }
+
+  auto& tdb2 = Context::getContext ().tdb2;
+  std::map <std::string, ProjectCount> counts;
+  total = 0;
+
+  if (begin == end)
+  {
+    tdb2.counts ("projects", counts);
+    for (auto& project : counts)
+      total += project.second.pending + project.second.done + project.second.deleted;
+    return true;
+  }
+
+  if (end - begin != 3 ||
+      precompiled[begin].second != Lexer::Type::dom ||
+      precompiled[begin + 1].second != Lexer::Type::op)
+    return false;
+
+  auto& name  = precompiled[begin].first;
+  auto& op    = precompiled[begin + 1].first;
+  auto  value = precompiled[begin + 2].first;
+  auto  type  = precompiled[begin + 2].second;
+
+  if (type != Lexer::Type::string)
+  {
+    Variant resolved;
+    if ((type != Lexer::Type::identifier && type != Lexer::Type::word) ||
+        value == "true" || value == "false" || value == "pi"       ||
+        domSource (value, resolved))
+      return false;
+  }
+
+  Lexer::dequote (value);
+
+  if (name == "project" && op == "=")
+  {
+    tdb2.counts ("projects", counts);
+    for (auto& project : counts)
+      if (value == "" ? project.first == ""
+                      : project.first.length () >= value.length () &&
+                        project.first.compare (0, value.length (), value) == 0)
+        total += project.second.pending + project.second.done + project.second.deleted;
+    return true;
+  }
+
+  if (name == "tags" && (op == "_hastag_" || op == "_notag_"))
+  {
+    // Virtual tags are upper case, and are not counted.
+    if (value == "" || isupper (value[0]))
+      return false;
+
+    tdb2.counts ("tags", counts);
+    auto tag = counts.find (value);
+    if (tag != counts.end ())
+      total = tag->second.pending + tag->second.done + tag->second.deleted;
+
+    if (op == "_notag_")
+    {
+      int tagged = total;
+      total = -tagged;
+      tdb2.counts ("projects", counts);
+      for (auto& project : counts)
+        total += project.second.pending + project.second.done + project.second.deleted;
+    }
+    return true;
+  }
+
+  // Pending and waiting tasks are counted together, so only the other
+  // statuses can be answered.
+  if (name == "status" && op == "=")
+  {
+    bool done = compare (value, "completed", false);
+    if (! done && ! compare (value, "deleted", false))
+      return false;
+
+    tdb2.counts ("projects", counts);
+    for (auto& project : counts)
+      total += done ? project.second.done : project.second.deleted;
+    return true;
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Evaluate the compiled filter for each input task, and pass the matching tasks
+// to the callback, in input order.  Tasks that the bounds exclude are rejected
+// first, without evaluation.  With filter.threads, a large input is split into
+// contiguous chunks that are evaluated concurrently.
+void Filter::evaluate (
+  Eval& eval,
+  const TF2Index::Bounds& limits,
+  const std::vector <Task>& input,
+  std::function <void (const Task&)>& callback) const
+{
+  size_t threads = Context::getContext ().config.getInteger ("filter.threads");
+  if (threads == 0)
+    threads = Pool::threads ();
+
+  // Parser debugging writes from the evaluator, so is kept single-threaded.
+  threads = std::min (threads, input.size () / FILTER_CHUNK_MINIMUM);
+  if (threads <= 1 ||
+      Context::getContext ().config.getInteger ("debug.parser") >= 3)
+  {
+    for (auto& task : input)
+    {
+      if (full ())
+        break;
+
+      if (excluded (task, limits))
+        continue;
+
+      // Set up context for any DOM references.
+      contextTask = &task;
+
+      Variant var;
+      eval.evaluateCompiledExpression (var);
+      if (var.get_bool ())
+        callback (task);
+    }
+
+    contextTask = &dummy;
+    return;
+  }
+
+  // Matches are recorded by position, then gathered in order.
+  std::vector <char> matches (input.size (), 0);
+
+  auto chunk = (input.size () + threads - 1) / threads;
+  Pool::run (threads, [&] (size_t t)
+  {
+    Eval local (eval);
+    auto end = std::min (input.size (), (t + 1) * chunk);
+    for (auto i = t * chunk; i < end; ++i)
+    {
+      if (excluded (input[i], limits))
+        continue;
+
+      // Set up context for any DOM references.
+      contextTask = &input[i];
+
+      Variant var;
+      local.evaluateCompiledExpression (var);
+      matches[i] = var.get_bool ();
+    }
+
+    contextTask = &dummy;
+  });
+
+  for (size_t i = 0; i < input.size () && ! full (); ++i)
+    if (matches[i])
+      callback (input[i]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// When every task the filter matches is in an ID set, the tasks in that set are
+// looked up directly, rather than evaluating the filter for all tasks.  Pending
+// tasks are found by ID and in file order, followed by any other tasks given
+// by UUID.
+bool Filter::candidatesByID (
+  const std::vector <std::pair <std::string, Lexer::Type>>& precompiled,
+  std::vector <Task>& candidates) const
+{
+  std::vector <std::pair <int, int>> ranges;
+  std::vector <std::string> uuids;
+  if (! idConjunct (precompiled, 0, precompiled.size (), ranges, uuids))
+    return false;
+
+  auto& tdb2 = Context::getContext ().tdb2;
+  int latest = tdb2.latest_id ();
+
+  std::vector <int> ids;
+  for (auto& range : ranges)
+  {
+    auto low  = std::min (range.first, range.second);
+    auto high = std::min (std::max (range.first, range.second), latest);
+    for (auto id = low; id <= high; ++id)
+      ids.push_back (id);
+  }
+
+  std::vector <std::string> others;
+  for (auto& uuid : uuids)
+  {
+    auto id = tdb2.pending.id (uuid);
+    if (id)
+      ids.push_back (id);
+    else
+      others.push_back (uuid);
+  }
+
+  std::sort (ids.begin (), ids.end ());
+  ids.erase (std::unique (ids.begin (), ids.end ()), ids.end ());
+
+  for (auto id : ids)
+  {
+    Task task;
+    if (tdb2.pending.uuid (id) != "" &&
+        tdb2.pending.get (id, task))
+      candidates.push_back (task);
+  }
+
+  // UUIDs without an ID are completed or deleted, and the completed.data index
+  // can find them without reading the whole file.
+  std::unordered_set <std::string> seen;
+  for (auto& uuid : others)
+  {
+    Task task;
+    if (seen.insert (uuid).second &&
+        (tdb2.pending.get (uuid, task) || tdb2.completed.get (uuid, task)))
+      candidates.push_back (task);
+  }
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 bool Filter::hasFilter () const
 {
   for (const auto& a : Context::getContext ().cli2._args)
-    if (a.hasTag ("FILTER"))
+    if (a.hasTag (A2::Tag::FILTER))
       return true;
 
   return false;
@@ -217,7 +1111,7 @@ bool Filter::pendingOnly () const
 
   for (const auto& a : Context::getContext ().cli2._args)
   {
-    if (a.hasTag ("FILTER"))
+    if (a.hasTag (A2::Tag::FILTER))
     {
       std::string raw       = a.attribute ("raw");
       std::string canonical = a.attribute ("canonical");
@@ -252,6 +1146,25 @@ bool Filter::pendingOnly () const
   return false;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Whether the command only reads tasks, so that those of completed.data that
+// it does not see need not be kept.
+bool Filter::readOnly () const
+{
+  for (const auto& a : Context::getContext ().cli2._args)
+    if (a.hasTag (A2::Tag::CMD))
+      return a.hasTag (A2::Tag::READONLY);
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Whether the limit of matching tasks is reached.
+bool Filter::full () const
+{
+  return _limit && _endCount >= _limit;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Disaster avoidance mechanism. If a !READONLY has no filter, then it can cause
 // all tasks to be modified. This is usually not intended.
@@ -263,11 +1176,11 @@ void Filter::safety () const
     bool filter = false;
     for (const auto& a : Context::getContext ().cli2._args)
     {
-      if (a.hasTag ("CMD") &&
-          ! a.hasTag ("READONLY"))
+      if (a.hasTag (A2::Tag::CMD) &&
+          ! a.hasTag (A2::Tag::READONLY))
         readonly = false;
 
-      if (a.hasTag ("FILTER"))
+      if (a.hasTag (A2::Tag::FILTER))
         filter = true;
     }
 
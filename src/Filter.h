@@ -29,8 +29,11 @@
 
 #include <string>
 #include <vector>
+#include <functional>
 #include <Task.h>
 #include <Variant.h>
+#include <Eval.h>
+#include <TF2Index.h>
 
 bool domSource (const std::string&, Variant&);
 
@@ -41,14 +44,27 @@ public:
 
   void subset (const std::vector <Task>&, std::vector <Task>&);
   void subset (std::vector <Task>&);
+  void visit (std::function <void (const Task&)>);
+  int count ();
+  void limit (int);
   bool hasFilter () const;
   bool pendingOnly () const;
   void safety () const;
   void disableSafety ();
 
+private:
+  std::vector <std::pair <std::string, Lexer::Type>> prepare () const;
+  void visit (const std::vector <std::pair <std::string, Lexer::Type>>&, std::function <void (const Task&)>);
+  bool counted (const std::vector <std::pair <std::string, Lexer::Type>>&, int&) const;
+  void evaluate (Eval&, const TF2Index::Bounds&, const std::vector <Task>&, std::function <void (const Task&)>&) const;
+  bool candidatesByID (const std::vector <std::pair <std::string, Lexer::Type>>&, std::vector <Task>&) const;
+  bool readOnly () const;
+  bool full () const;
+
 private:
   int  _startCount {0};
   int  _endCount   {0};
+  int  _limit      {0};
   bool _safety     {true};
 };
 
@@ -33,7 +33,14 @@
 #define _WITH_GETLINE
 #endif
 #include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <signal.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <poll.h>
 #include <sys/wait.h>
 #include <sys/types.h>
 #include <Context.h>
@@ -42,6 +49,7 @@
 #include <Lexer.h>
 #include <JSON.h>
 #include <Timer.h>
+#include <Trace.h>
 #include <FS.h>
 #include <format.h>
 #include <shared.h>
@@ -57,14 +65,24 @@
 #define STRING_HOOK_ERROR_SAME1      "Hook Error: JSON must be for the same task: {1}, in hook script: {2}"
 #define STRING_HOOK_ERROR_SAME2      "Hook Error: JSON must be for the same task: {1} != {2}, in hook script: {3}"
 #define STRING_HOOK_ERROR_NOFEEDBACK "Hook Error: Expected feedback from failing hook script: {1}"
+#define STRING_HOOK_ERROR_RESIDENT   "Hook Error: Resident hook script ended unexpectedly: {1}"
+#define STRING_HOOK_ERROR_TIMEOUT    "Hook Error: Hook script exceeded its time limit of {1}ms: {2}"
+
+////////////////////////////////////////////////////////////////////////////////
+Hooks::~Hooks ()
+{
+  stopResidentScripts ();
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 void Hooks::initialize ()
 {
   _debug = Context::getContext ().config.getInteger ("debug.hooks");
 
-  // Scan <rc.hooks.location>
-  //      <rc.data.location>/hooks
+  // Locate <rc.hooks.location>
+  //        <rc.data.location>/hooks
+  // but defer the listing until an event first needs it, as most commands
+  // fire nothing beyond on-launch and on-exit, and many have no hooks at all.
   Directory d;
   if (Context::getContext ().config.has ("hooks.location"))
   {
@@ -76,7 +94,36 @@ void Hooks::initialize ()
     d += "hooks";
   }
 
-  if (d.is_directory () &&
+  _location = d._data;
+  _scanned = false;
+  _events.clear ();
+
+  // A single stat decides whether there is anything to scan.
+  struct stat s;
+  _present = ::stat (_location.c_str (), &s) == 0 && S_ISDIR (s.st_mode);
+  if (! _present && _debug >= 1)
+    Context::getContext ().debug ("Hook directory not readable: " + _location);
+
+  _enabled = Context::getContext ().config.getBoolean ("hooks");
+  _resident = split (Context::getContext ().config.get ("hooks.resident"), ',');
+  _parallel = split (Context::getContext ().config.get ("hooks.parallel"), ',');
+  _async    = split (Context::getContext ().config.get ("hooks.async"), ',');
+  _timeout  = Context::getContext ().config.getInteger ("hooks.timeout");
+  _budget   = Context::getContext ().config.getInteger ("hooks.budget");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Lists the hook directory, once.
+void Hooks::scan () const
+{
+  if (_scanned)
+    return;
+
+  _scanned = true;
+  _scripts.clear ();
+
+  Directory d (_location);
+  if (_present &&
       d.readable ())
   {
     _scripts = d.list ();
@@ -101,10 +148,8 @@ void Hooks::initialize ()
       }
     }
   }
-  else if (_debug >= 1)
-    Context::getContext ().debug ("Hook directory not readable: " + d._data);
-
-  _enabled = Context::getContext ().config.getBoolean ("hooks");
+  else if (_present && _debug >= 1)
+    Context::getContext ().debug ("Hook directory not readable: " + _location);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -133,15 +178,21 @@ void Hooks::onLaunch () const
     return;
 
   Timer timer;
+  _event = Timer ();
 
-  std::vector <std::string> matchingScripts = scripts ("on-launch");
+  const std::vector <std::string>& matchingScripts = scripts ("on-launch");
   if (matchingScripts.size ())
   {
-    for (auto& script : matchingScripts)
+    std::vector <std::string> input;
+    std::vector <int> statuses;
+    std::vector <std::vector <std::string>> outputs;
+    callHookScripts (matchingScripts, input, statuses, outputs);
+
+    for (size_t i = 0; i < statuses.size (); ++i)
     {
-      std::vector <std::string> input;
-      std::vector <std::string> output;
-      int status = callHookScript (script, input, output);
+      auto& script = matchingScripts[i];
+      auto& output = outputs[i];
+      int status = statuses[i];
 
       std::vector <std::string> outputJSON;
       std::vector <std::string> outputFeedback;
@@ -182,13 +233,17 @@ void Hooks::onLaunch () const
 //
 void Hooks::onExit () const
 {
+  // Resident on-add and on-modify scripts see no more events.
+  stopResidentScripts ();
+
   if (! _enabled)
     return;
 
   Timer timer;
+  _event = Timer ();
 
-  std::vector <std::string> matchingScripts = scripts ("on-exit");
-  if (matchingScripts.size ())
+  const std::vector <std::string>& exitScripts = scripts ("on-exit");
+  if (exitScripts.size ())
   {
     // Get the set of changed tasks.
     std::vector <Task> tasks;
@@ -199,11 +254,26 @@ void Hooks::onExit () const
     for (auto& t : tasks)
       input.push_back (t.composeJSON ());
 
+    // The scripts listed in hooks.async are left running, and not waited on.
+    std::vector <std::string> matchingScripts;
+    for (auto& script : exitScripts)
+    {
+      if (isAsync (script))
+        callAsyncScript (script, input);
+      else
+        matchingScripts.push_back (script);
+    }
+
     // Call the hook scripts, with the invariant input.
-    for (auto& script : matchingScripts)
+    std::vector <int> statuses;
+    std::vector <std::vector <std::string>> outputs;
+    callHookScripts (matchingScripts, input, statuses, outputs);
+
+    for (size_t i = 0; i < statuses.size (); ++i)
     {
-      std::vector <std::string> output;
-      int status = callHookScript (script, input, output);
+      auto& script = matchingScripts[i];
+      auto& output = outputs[i];
+      int status = statuses[i];
 
       std::vector <std::string> outputJSON;
       std::vector <std::string> outputFeedback;
@@ -248,13 +318,15 @@ void Hooks::onAdd (Task& task) const
     return;
 
   Timer timer;
+  _event = Timer ();
 
-  std::vector <std::string> matchingScripts = scripts ("on-add");
+  const std::vector <std::string>& matchingScripts = scripts ("on-add");
   if (matchingScripts.size ())
   {
     // Convert task to a vector of strings.
     std::vector <std::string> input;
     input.push_back (task.composeJSON ());
+    std::string composed = input[0];
 
     // Call the hook scripts.
     for (auto& script : matchingScripts)
@@ -268,9 +340,8 @@ void Hooks::onAdd (Task& task) const
 
       if (status == 0)
       {
-        assertNTasks    (outputJSON, 1, script);
-        assertValidJSON (outputJSON, script);
-        assertSameTask  (outputJSON, task, script);
+        assertNTasks (outputJSON, 1, script);
+        assertOutput (outputJSON[0], input[0], task, script);
 
         // Propagate forward to the next script.
         input[0] = outputJSON[0];
@@ -288,10 +359,88 @@ void Hooks::onAdd (Task& task) const
       }
     }
 
-    // Transfer the modified task back to the original task.
-    task = Task (input[0]);
+    // Transfer the modified task back to the original task, unless no script
+    // changed it.
+    if (input[0] != composed)
+      task = Task (input[0]);
+  }
+
+  Context::getContext ().time_hooks_us += timer.total_us ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The on-add-batch event is triggered once for tasks added together, such as
+// recurring task instances.  Without on-add-batch scripts, the on-add event is
+// triggered for each task instead
+//
+// Input:
+// - line of JSON for each task added
+//
+// Output:
+// - emitted JSON for each input task, in the same order, is added, if the exit
+//   code is zero, otherwise ignored.
+// - all emitted non-JSON lines are considered feedback or error messages
+//   depending on the status code.
+//
+void Hooks::onAddBatch (std::vector <Task>& tasks) const
+{
+  if (! _enabled)
+    return;
+
+  const std::vector <std::string>& matchingScripts = scripts ("on-add-batch");
+  if (matchingScripts.size () == 0)
+  {
+    for (auto& task : tasks)
+      onAdd (task);
+
+    return;
+  }
+
+  Timer timer;
+  _event = Timer ();
+
+  std::vector <std::string> input;
+  for (auto& task : tasks)
+    input.push_back (task.composeJSON ());
+  std::vector <std::string> composed = input;
+
+  // Call the hook scripts.
+  for (auto& script : matchingScripts)
+  {
+    std::vector <std::string> output;
+    int status = callHookScript (script, input, output);
+
+    std::vector <std::string> outputJSON;
+    std::vector <std::string> outputFeedback;
+    separateOutput (output, outputJSON, outputFeedback);
+
+    if (status == 0)
+    {
+      assertNTasks (outputJSON, tasks.size (), script);
+      for (size_t i = 0; i < outputJSON.size (); ++i)
+        assertOutput (outputJSON[i], input[i], tasks[i], script);
+
+      // Propagate forward to the next script.
+      input = outputJSON;
+
+      for (auto& message : outputFeedback)
+        Context::getContext ().footnote (message);
+    }
+    else
+    {
+      assertFeedback (outputFeedback, script);
+      for (auto& message : outputFeedback)
+        Context::getContext ().error (message);
+
+      throw 0;  // This is how hooks silently terminate processing.
+    }
   }
 
+  // Transfer the modified tasks back to the original tasks.
+  for (size_t i = 0; i < tasks.size (); ++i)
+    if (input[i] != composed[i])
+      tasks[i] = Task (input[i]);
+
   Context::getContext ().time_hooks_us += timer.total_us ();
 }
 
@@ -314,14 +463,16 @@ void Hooks::onModify (const Task& before, Task& after) const
     return;
 
   Timer timer;
+  _event = Timer ();
 
-  std::vector <std::string> matchingScripts = scripts ("on-modify");
+  const std::vector <std::string>& matchingScripts = scripts ("on-modify");
   if (matchingScripts.size ())
   {
     // Convert vector of tasks to a vector of strings.
     std::vector <std::string> input;
     input.push_back (before.composeJSON ()); // [line 0] original, never changes
     input.push_back (after.composeJSON ());  // [line 1] modified
+    std::string composed = input[1];
 
     // Call the hook scripts.
     for (auto& script : matchingScripts)
@@ -335,9 +486,8 @@ void Hooks::onModify (const Task& before, Task& after) const
 
       if (status == 0)
       {
-        assertNTasks    (outputJSON, 1, script);
-        assertValidJSON (outputJSON, script);
-        assertSameTask  (outputJSON, before, script);
+        assertNTasks (outputJSON, 1, script);
+        assertOutput (outputJSON[0], input[1], before, script);
 
         // Propagate accepted changes forward to the next script.
         input[1] = outputJSON[0];
@@ -355,25 +505,119 @@ void Hooks::onModify (const Task& before, Task& after) const
       }
     }
 
-    after = Task (input[1]);
+    if (input[1] != composed)
+      after = Task (input[1]);
+  }
+
+  Context::getContext ().time_hooks_us += timer.total_us ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The on-modify-batch event is triggered once for all the tasks modified by a
+// command, after their on-modify events
+//
+// Input:
+// - line of JSON for the original task, then a line of JSON for the modified
+//   task, for each task in turn
+//
+// Output:
+// - emitted JSON for each input task, in the same order, is saved, if the exit
+//   code is zero, otherwise ignored.
+// - all emitted non-JSON lines are considered feedback or error messages
+//   depending on the status code.
+//
+void Hooks::onModifyBatch (const std::vector <Task>& before, std::vector <Task>& after) const
+{
+  if (! _enabled)
+    return;
+
+  Timer timer;
+  _event = Timer ();
+
+  const std::vector <std::string>& matchingScripts = scripts ("on-modify-batch");
+  if (matchingScripts.size ())
+  {
+    std::vector <std::string> input;
+    for (size_t i = 0; i < before.size (); ++i)
+    {
+      input.push_back (before[i].composeJSON ()); // [line 2i] original, never changes
+      input.push_back (after[i].composeJSON ());  // [line 2i+1] modified
+    }
+    std::vector <std::string> composed = input;
+
+    // Call the hook scripts.
+    for (auto& script : matchingScripts)
+    {
+      std::vector <std::string> output;
+      int status = callHookScript (script, input, output);
+
+      std::vector <std::string> outputJSON;
+      std::vector <std::string> outputFeedback;
+      separateOutput (output, outputJSON, outputFeedback);
+
+      if (status == 0)
+      {
+        assertNTasks (outputJSON, before.size (), script);
+        for (size_t i = 0; i < outputJSON.size (); ++i)
+          assertOutput (outputJSON[i], input[2 * i + 1], before[i], script);
+
+        // Propagate accepted changes forward to the next script.
+        for (size_t i = 0; i < outputJSON.size (); ++i)
+          input[2 * i + 1] = outputJSON[i];
+
+        for (auto& message : outputFeedback)
+          Context::getContext ().footnote (message);
+      }
+      else
+      {
+        assertFeedback (outputFeedback, script);
+        for (auto& message : outputFeedback)
+          Context::getContext ().error (message);
+
+        throw 0;  // This is how hooks silently terminate processing.
+      }
+    }
+
+    for (size_t i = 0; i < after.size (); ++i)
+      if (input[2 * i + 1] != composed[2 * i + 1])
+        after[i] = Task (input[2 * i + 1]);
   }
 
   Context::getContext ().time_hooks_us += timer.total_us ();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Whether any on-modify-batch scripts need modifications to be gathered.
+bool Hooks::batched () const
+{
+  return _enabled && scripts ("on-modify-batch").size ();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 std::vector <std::string> Hooks::list () const
 {
+  scan ();
   return _scripts;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-std::vector <std::string> Hooks::scripts (const std::string& event) const
+// The scripts for an event are resolved the first time it fires, and reused
+// for every later task, rather than checked for executability each time.
+const std::vector <std::string>& Hooks::scripts (const std::string& event) const
 {
-  std::vector <std::string> matching;
+  auto cached = _events.find (event);
+  if (cached != _events.end ())
+    return cached->second;
+
+  scan ();
+
+  std::vector <std::string>& matching = _events[event];
   for (const auto& i : _scripts)
   {
-    if (i.find ("/" + event) != std::string::npos)
+    // The on-add-batch and on-modify-batch scripts are not on-add and
+    // on-modify scripts.
+    if (i.find ("/" + event) != std::string::npos &&
+        i.find ("/" + event + "-batch") == std::string::npos)
     {
       File script (i);
       if (script.executable ())
@@ -510,6 +754,23 @@ void Hooks::assertSameTask (
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// A line emitted by a script identical to the one it was given, as from a hook
+// that only observes, is already known to be valid, and is not parsed again.
+void Hooks::assertOutput (
+  const std::string& output,
+  const std::string& given,
+  const Task& task,
+  const std::string& script) const
+{
+  if (output != given)
+  {
+    std::vector <std::string> line {output};
+    assertValidJSON (line, script);
+    assertSameTask  (line, task, script);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void Hooks::assertFeedback (
   const std::vector <std::string>& input,
@@ -560,6 +821,8 @@ int Hooks::callHookScript (
   const std::vector <std::string>& input,
   std::vector <std::string>& output) const
 {
+  Trace::Span span ("hook", script);
+
   if (_debug >= 1)
     Context::getContext ().debug ("Hook: Calling " + script);
 
@@ -583,17 +846,32 @@ int Hooks::callHookScript (
       Context::getContext ().debug ("  " + arg);
   }
 
-  // Measure time for each hook if running in debug
+  // A script with a time limit is run as the parallel scripts are, which can
+  // stop it.
+  if (! isResident (script) && allowance () != -1)
+  {
+    std::vector <int> statuses;
+    std::vector <std::vector <std::string>> outputs;
+    callParallelScripts ({script}, input, statuses, outputs);
+    output = outputs[0];
+    return statuses[0];
+  }
+
+  // Measure time for each hook, for perf.output, and if running in debug.
   int status;
   std::string outputStr;
-  if (_debug >= 2)
+  Timer timer;
+  if (isResident (script))
+    status = callResidentScript (script, args, inputStr, outputStr);
+  else
   {
-    Timer timer;
     status = execute (script, args, inputStr, outputStr);
-    Context::getContext ().debugTiming (format ("Hooks::execute ({1})", script), timer);
+    ++Context::getContext ().count_spawned;
   }
-  else
-    status = execute (script, args, inputStr, outputStr);
+
+  Context::getContext ().time_hook_us[Path (script).name ()] += timer.total_us ();
+  if (_debug >= 2)
+    Context::getContext ().debugTiming (format ("Hooks::execute ({1})", script), timer);
 
   output = split (outputStr, '\n');
 
@@ -612,3 +890,539 @@ int Hooks::callHookScript (
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+// Calls scripts that all receive the same input, and only emit feedback.  The
+// scripts listed in hooks.parallel are run concurrently, then the others in
+// order, until one fails.  Results are returned in script order, and only up to
+// the first failure.
+void Hooks::callHookScripts (
+  const std::vector <std::string>& scripts,
+  const std::vector <std::string>& input,
+  std::vector <int>& statuses,
+  std::vector <std::vector <std::string>>& outputs) const
+{
+  std::vector <std::string> parallel;
+  for (auto& script : scripts)
+    if (isParallel (script) && ! isResident (script))
+      parallel.push_back (script);
+
+  std::vector <int> parallelStatuses;
+  std::vector <std::vector <std::string>> parallelOutputs;
+  if (parallel.size ())
+    callParallelScripts (parallel, input, parallelStatuses, parallelOutputs);
+
+  size_t next = 0;
+  for (auto& script : scripts)
+  {
+    if (next < parallel.size () && parallel[next] == script)
+    {
+      statuses.push_back (parallelStatuses[next]);
+      outputs.push_back (parallelOutputs[next]);
+      ++next;
+    }
+    else
+    {
+      std::vector <std::string> output;
+      statuses.push_back (callHookScript (script, input, output));
+      outputs.push_back (output);
+    }
+
+    if (statuses.back () != 0)
+      break;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Runs all the scripts as concurrent processes, writing the input to each, and
+// reading their output as it arrives.
+void Hooks::callParallelScripts (
+  const std::vector <std::string>& scripts,
+  const std::vector <std::string>& input,
+  std::vector <int>& statuses,
+  std::vector <std::vector <std::string>>& outputs) const
+{
+  std::string inputStr;
+  for (const auto& i : input)
+    inputStr += i + "\n";
+
+  std::vector <std::string> args;
+  buildHookScriptArgs (args);
+
+  struct Child
+  {
+    pid_t       pid     {0};
+    int         input   {-1};
+    int         output  {-1};
+    size_t      written {0};
+    std::string buffer  {};
+    long        elapsed {0};
+    bool        expired {false};
+  };
+
+  std::vector <Child> children (scripts.size ());
+
+  Timer timer;
+  fflush (stdout);
+  for (size_t i = 0; i < scripts.size (); ++i)
+  {
+    if (_debug >= 1)
+      Context::getContext ().debug ("Hook: Calling " + scripts[i] + " in parallel");
+
+    // The descriptors are closed on exec, so that no script holds the pipes of
+    // another, and delays its end of file.
+    int to[2];
+    int from[2];
+    if (pipe (to) == -1 || pipe (from) == -1)
+      throw std::string (strerror (errno));
+
+    for (auto fd : {to[0], to[1], from[0], from[1]})
+      fcntl (fd, F_SETFD, FD_CLOEXEC);
+
+    std::vector <char*> argv;
+    argv.push_back ((char*) scripts[i].c_str ());
+    for (auto& arg : args)
+      argv.push_back ((char*) arg.c_str ());
+    argv.push_back (nullptr);
+
+    pid_t pid = fork ();
+    if (pid == -1)
+      throw std::string (strerror (errno));
+
+    if (pid == 0)
+    {
+      dup2 (to[0], STDIN_FILENO);
+      dup2 (from[1], STDOUT_FILENO);
+      execv (scripts[i].c_str (), argv.data ());
+      _exit (127);
+    }
+
+    close (to[0]);
+    close (from[1]);
+    ++Context::getContext ().count_spawned;
+
+    children[i].pid    = pid;
+    children[i].input  = to[1];
+    children[i].output = from[0];
+    fcntl (to[1], F_SETFL, fcntl (to[1], F_GETFL) | O_NONBLOCK);
+
+    if (inputStr.size () == 0)
+    {
+      close (children[i].input);
+      children[i].input = -1;
+    }
+  }
+
+  // A script that exits without reading its input must not terminate
+  // Taskwarrior with SIGPIPE.
+  auto handler = signal (SIGPIPE, SIG_IGN);
+
+  // Scripts still running when the time allowed is up are stopped.
+  int allowed = allowance ();
+
+  while (true)
+  {
+    std::vector <pollfd> fds;
+    std::vector <size_t> owners;
+    for (size_t i = 0; i < children.size (); ++i)
+    {
+      if (children[i].input != -1)
+      {
+        fds.push_back ({children[i].input, POLLOUT, 0});
+        owners.push_back (i);
+      }
+
+      if (children[i].output != -1)
+      {
+        fds.push_back ({children[i].output, POLLIN, 0});
+        owners.push_back (i);
+      }
+    }
+
+    if (fds.size () == 0)
+      break;
+
+    int wait = -1;
+    if (allowed != -1)
+    {
+      wait = std::max (0, allowed - (int) timer.total_ms ());
+      if (wait == 0)
+      {
+        for (auto& child : children)
+        {
+          if (child.input == -1 && child.output == -1)
+            continue;
+
+          kill (child.pid, SIGKILL);
+          child.expired = true;
+          child.elapsed = timer.total_us ();
+          for (auto fd : {&child.input, &child.output})
+          {
+            if (*fd != -1)
+              close (*fd);
+            *fd = -1;
+          }
+        }
+
+        break;
+      }
+    }
+
+    if (poll (fds.data (), fds.size (), wait) == -1)
+    {
+      if (errno == EINTR)
+        continue;
+
+      signal (SIGPIPE, handler);
+      throw std::string (strerror (errno));
+    }
+
+    for (size_t f = 0; f < fds.size (); ++f)
+    {
+      if (! fds[f].revents)
+        continue;
+
+      auto& child = children[owners[f]];
+      if (fds[f].fd == child.input)
+      {
+        auto written = write (child.input,
+                              inputStr.data () + child.written,
+                              inputStr.size () - child.written);
+        if (written > 0)
+          child.written += written;
+
+        if ((written == -1 && errno != EAGAIN && errno != EINTR) ||
+            child.written == inputStr.size ())
+        {
+          close (child.input);
+          child.input = -1;
+        }
+      }
+      else
+      {
+        char buffer[4096];
+        auto received = read (child.output, buffer, sizeof (buffer));
+        if (received > 0)
+          child.buffer.append (buffer, received);
+        else if (received == 0 || errno != EINTR)
+        {
+          close (child.output);
+          child.output = -1;
+          child.elapsed = timer.total_us ();
+        }
+      }
+    }
+  }
+
+  signal (SIGPIPE, handler);
+
+  for (size_t i = 0; i < children.size (); ++i)
+  {
+    int status;
+    while (waitpid (children[i].pid, &status, 0) == -1 && errno == EINTR)
+      ;
+
+    auto name = Path (scripts[i]).name ();
+    Context::getContext ().time_hook_us[name] += children[i].elapsed;
+
+    if (children[i].expired)
+    {
+      statuses.push_back (1);
+      outputs.push_back ({format (STRING_HOOK_ERROR_TIMEOUT, allowed, name)});
+    }
+    else
+    {
+      statuses.push_back (WIFEXITED (status) ? WEXITSTATUS (status) : -1);
+      outputs.push_back (split (children[i].buffer, '\n'));
+    }
+
+    if (_debug >= 2)
+    {
+      Context::getContext ().debug ("Hook: output of " + scripts[i]);
+      for (const auto& line : outputs.back ())
+        if (line != "")
+          Context::getContext ().debug ("  " + line);
+
+      Context::getContext ().debug (format ("Hook: Completed with status {1}", statuses.back ()));
+      Context::getContext ().debug (" "); // Blank line
+    }
+  }
+
+  if (_debug >= 2)
+    Context::getContext ().debugTiming ("Hooks::callParallelScripts", timer);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool Hooks::isResident (const std::string& script) const
+{
+  if (_resident.size () == 0)
+    return false;
+
+  auto name = Path (script).name ();
+  return std::find (_resident.begin (), _resident.end (), name) != _resident.end ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// A resident hook script is started with "api:3" on its first event, and kept
+// running until Taskwarrior exits.  For each event it is sent the usual input
+// lines, and it responds with the usual output lines, followed by a line
+// "status:<n>" in place of the exit status.  It is stopped by closing its
+// input.
+int Hooks::callResidentScript (
+  const std::string& script,
+  const std::vector <std::string>& args,
+  const std::string& input,
+  std::string& output) const
+{
+  auto process = _processes.find (script);
+  if (process == _processes.end ())
+  {
+    int to[2];
+    int from[2];
+    if (pipe (to) == -1)
+      throw std::string (strerror (errno));
+
+    if (pipe (from) == -1)
+    {
+      close (to[0]);
+      close (to[1]);
+      throw std::string (strerror (errno));
+    }
+
+    // Build argv before forking, so that the child does not allocate.
+    std::vector <std::string> residentArgs {args};
+    residentArgs[0] = "api:3";
+
+    std::vector <char*> argv;
+    argv.push_back ((char*) script.c_str ());
+    for (auto& arg : residentArgs)
+      argv.push_back ((char*) arg.c_str ());
+    argv.push_back (nullptr);
+
+    fflush (stdout);
+    pid_t pid = fork ();
+    if (pid == -1)
+    {
+      close (to[0]);
+      close (to[1]);
+      close (from[0]);
+      close (from[1]);
+      throw std::string (strerror (errno));
+    }
+
+    if (pid == 0)
+    {
+      dup2 (to[0], STDIN_FILENO);
+      dup2 (from[1], STDOUT_FILENO);
+      close (to[0]);
+      close (to[1]);
+      close (from[0]);
+      close (from[1]);
+
+      // Descriptors of other resident scripts are not inherited.
+      for (auto& other : _processes)
+      {
+        close (other.second.input);
+        close (fileno (other.second.output));
+      }
+
+      execv (script.c_str (), argv.data ());
+      _exit (127);
+    }
+
+    close (to[0]);
+    close (from[1]);
+
+    Process p;
+    p.pid    = pid;
+    p.input  = to[1];
+    p.output = fdopen (from[0], "r");
+    process = _processes.emplace (script, p).first;
+    ++Context::getContext ().count_spawned;
+
+    if (_debug >= 1)
+      Context::getContext ().debug (format ("Hook: Started resident {1}, pid {2}", script, pid));
+  }
+
+  // A script that has exited must not terminate Taskwarrior with SIGPIPE.
+  auto handler = signal (SIGPIPE, SIG_IGN);
+
+  bool ok = true;
+  const char* data = input.data ();
+  size_t remaining = input.size ();
+  while (ok && remaining)
+  {
+    auto written = write (process->second.input, data, remaining);
+    if (written == -1 && errno == EINTR)
+      continue;
+
+    ok = written > 0;
+    if (ok)
+    {
+      data += written;
+      remaining -= written;
+    }
+  }
+
+  signal (SIGPIPE, handler);
+
+  int status = -1;
+  output = "";
+
+  char* line = nullptr;
+  size_t size = 0;
+  ssize_t length;
+  while (ok && (length = getline (&line, &size, process->second.output)) != -1)
+  {
+    std::string response (line, length);
+    if (response.compare (0, 7, "status:") == 0)
+    {
+      status = strtol (response.c_str () + 7, nullptr, 10);
+      break;
+    }
+
+    output += response;
+  }
+
+  free (line);
+
+  if (status == -1)
+  {
+    // The script is gone, and is not restarted.
+    Context::getContext ().error (format (STRING_HOOK_ERROR_RESIDENT, Path (script).name ()));
+    throw 0;
+  }
+
+  return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Hooks::stopResidentScripts () const
+{
+  for (auto& process : _processes)
+  {
+    close (process.second.input);
+    fclose (process.second.output);
+
+    int status;
+    while (waitpid (process.second.pid, &status, 0) == -1 && errno == EINTR)
+      ;
+  }
+
+  _processes.clear ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool Hooks::isAsync (const std::string& script) const
+{
+  if (_async.size () == 0)
+    return false;
+
+  auto name = Path (script).name ();
+  return std::find (_async.begin (), _async.end (), name) != _async.end ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Starts the script in a detached process, which is given the input and left
+// to be reaped by init.  Whatever the script emits is discarded.
+void Hooks::callAsyncScript (
+  const std::string& script,
+  const std::vector <std::string>& input) const
+{
+  if (_debug >= 1)
+    Context::getContext ().debug ("Hook: Calling " + script + " in the background");
+
+  std::string inputStr;
+  for (const auto& i : input)
+    inputStr += i + "\n";
+
+  std::vector <std::string> args;
+  buildHookScriptArgs (args);
+
+  std::vector <char*> argv;
+  argv.push_back ((char*) script.c_str ());
+  for (auto& arg : args)
+    argv.push_back ((char*) arg.c_str ());
+  argv.push_back (nullptr);
+
+  fflush (stdout);
+  auto pid = fork ();
+  if (pid == 0)
+  {
+    // Detach, so that the command does not wait on the script.
+    setsid ();
+    if (fork () != 0)
+      _exit (0);
+
+    int null = open ("/dev/null", O_RDWR);
+    if (null != -1)
+    {
+      dup2 (null, STDOUT_FILENO);
+      dup2 (null, STDERR_FILENO);
+    }
+
+    int to[2];
+    if (pipe (to) == -1)
+      _exit (1);
+
+    signal (SIGPIPE, SIG_IGN);
+    auto child = fork ();
+    if (child == 0)
+    {
+      dup2 (to[0], STDIN_FILENO);
+      close (to[0]);
+      close (to[1]);
+      execv (script.c_str (), argv.data ());
+      _exit (127);
+    }
+
+    close (to[0]);
+    if (child > 0)
+    {
+      size_t written = 0;
+      while (written < inputStr.size ())
+      {
+        auto n = write (to[1], inputStr.data () + written, inputStr.size () - written);
+        if (n == -1 && errno == EINTR)
+          continue;
+        if (n <= 0)
+          break;
+        written += n;
+      }
+    }
+
+    close (to[1]);
+    _exit (0);
+  }
+
+  if (pid > 0)
+  {
+    waitpid (pid, nullptr, 0);
+    ++Context::getContext ().count_spawned;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The milliseconds the next script may run, the least of hooks.timeout and
+// what is left of hooks.budget for the event, or -1 for no limit.
+int Hooks::allowance () const
+{
+  int allowed = _timeout > 0 ? _timeout : -1;
+  if (_budget > 0)
+  {
+    int left = std::max (0, _budget - (int) _event.total_ms ());
+    allowed = allowed == -1 ? left : std::min (allowed, left);
+  }
+
+  return allowed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool Hooks::isParallel (const std::string& script) const
+{
+  if (_parallel.size () == 0)
+    return false;
+
+  auto name = Path (script).name ();
+  return std::find (_parallel.begin (), _parallel.end (), name) != _parallel.end ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -29,35 +29,77 @@
 
 #include <vector>
 #include <string>
+#include <map>
+#include <stdio.h>
+#include <sys/types.h>
+#include <Timer.h>
 #include <Task.h>
 
 class Hooks
 {
 public:
   Hooks () = default;
+  ~Hooks ();
   void initialize ();
   bool enable (bool);
   void onLaunch () const;
   void onExit () const;
   void onAdd (Task&) const;
+  void onAddBatch (std::vector <Task>&) const;
   void onModify (const Task&, Task&) const;
+  void onModifyBatch (const std::vector <Task>&, std::vector <Task>&) const;
+  bool batched () const;
   std::vector <std::string> list () const;
 
 private:
-  std::vector <std::string> scripts (const std::string&) const;
+  void scan () const;
+  const std::vector <std::string>& scripts (const std::string&) const;
   void separateOutput (const std::vector <std::string>&, std::vector <std::string>&, std::vector <std::string>&) const;
   bool isJSON (const std::string&) const;
   void assertValidJSON (const std::vector <std::string>&, const std::string&) const;
   void assertNTasks (const std::vector <std::string>&, unsigned int, const std::string&) const;
   void assertSameTask (const std::vector <std::string>&, const Task&, const std::string&) const;
+  void assertOutput (const std::string&, const std::string&, const Task&, const std::string&) const;
   void assertFeedback (const std::vector <std::string>&, const std::string&) const;
   std::vector <std::string>& buildHookScriptArgs (std::vector <std::string>&) const;
   int callHookScript (const std::string&, const std::vector <std::string>&, std::vector <std::string>&) const;
+  void callHookScripts (const std::vector <std::string>&, const std::vector <std::string>&, std::vector <int>&, std::vector <std::vector <std::string>>&) const;
+  void callParallelScripts (const std::vector <std::string>&, const std::vector <std::string>&, std::vector <int>&, std::vector <std::vector <std::string>>&) const;
+  bool isResident (const std::string&) const;
+  bool isParallel (const std::string&) const;
+  bool isAsync (const std::string&) const;
+  void callAsyncScript (const std::string&, const std::vector <std::string>&) const;
+  int allowance () const;
+  int callResidentScript (const std::string&, const std::vector <std::string>&, const std::string&, std::string&) const;
+  void stopResidentScripts () const;
 
 private:
   bool                      _enabled {true};
   int                       _debug   {0};
-  std::vector <std::string> _scripts {};
+  std::string               _location {};
+  bool                      _present {false};
+
+  // The directory listing and the executable scripts per event, on demand.
+  mutable bool                      _scanned {false};
+  mutable std::vector <std::string> _scripts {};
+  mutable std::map <std::string, std::vector <std::string>> _events {};
+  std::vector <std::string> _resident {};
+  std::vector <std::string> _parallel {};
+  std::vector <std::string> _async {};
+  int                       _timeout {0};
+  int                       _budget  {0};
+
+  // Started with each event, for hooks.budget.
+  mutable Timer             _event {};
+
+  // Resident hook scripts that are running, by script path.
+  struct Process
+  {
+    pid_t pid    {0};
+    int   input  {-1};
+    FILE* output {nullptr};
+  };
+  mutable std::map <std::string, Process> _processes {};
 };
 
 #endif
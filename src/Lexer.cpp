@@ -77,23 +77,32 @@ bool Lexer::token (std::string& token, Lexer::Type& type)
   //   - path < substitution < pattern
   //   - set < number
   //   - word last
-  if (isString       (token, type, "'\"") ||
-      isDate         (token, type)        ||
-      isDuration     (token, type)        ||
-      isURL          (token, type)        ||
-      isPair         (token, type)        ||
-      isUUID         (token, type, true)  ||
-      isSet          (token, type)        ||
-      isDOM          (token, type)        ||
-      isHexNumber    (token, type)        ||
-      isNumber       (token, type)        ||
-      isSeparator    (token, type)        ||
-      isTag          (token, type)        ||
-      isPath         (token, type)        ||
-      isSubstitution (token, type)        ||
-      isPattern      (token, type)        ||
-      isOperator     (token, type)        ||
-      isIdentifier   (token, type)        ||
+  //
+  // Most recognizers only match tokens that start with particular characters,
+  // so those that cannot match are skipped, without changing the sequence.
+  // Dates and durations are words or numbers, except that a date format may
+  // begin with a literal character.
+  int c = _text[_cursor];
+  bool punctuation = isPunctuation (c);
+  bool dateStart = ! punctuation || c == '.' || (Lexer::dateFormat != "" && c == Lexer::dateFormat[0]);
+
+  if (((c == '\'' || c == '"')             && isString       (token, type, "'\"")) ||
+      (dateStart                           && isDate         (token, type))       ||
+      ((! punctuation || c == '.')         && isDuration     (token, type))       ||
+      ((c == 'h' || c == 'H')              && isURL          (token, type))       ||
+      (isIdentifierStart (c)               && isPair         (token, type))       ||
+      (isHexPrefix (uuid_min_length)       && isUUID         (token, type, true)) ||
+      (unicodeLatinDigit (c)               && isSet          (token, type))       ||
+      (! punctuation                       && isDOM          (token, type))       ||
+      (c == '0'                            && isHexNumber    (token, type))       ||
+      (unicodeLatinDigit (c)               && isNumber       (token, type))       ||
+      (c == '-'                            && isSeparator    (token, type))       ||
+      ((c == '+' || c == '-')              && isTag          (token, type))       ||
+      (c == '/'                            && isPath         (token, type))       ||
+      (c == '/'                            && isSubstitution (token, type))       ||
+      (c == '/'                            && isPattern      (token, type))       ||
+      isOperator     (token, type)                                                ||
+      isIdentifier   (token, type)                                                ||
       isWord         (token, type))
     return true;
 
@@ -274,6 +283,20 @@ bool Lexer::wasQuoted (const std::string& input)
   return false;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Whether the text at the cursor starts with the given number of hex digits.
+bool Lexer::isHexPrefix (std::size_t length) const
+{
+  if (_eos - _cursor < length)
+    return false;
+
+  for (std::size_t i = 0; i < length; ++i)
+    if (! unicodeHexDigit (_text[_cursor + i]))
+      return false;
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 bool Lexer::isEOS () const
 {
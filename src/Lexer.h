@@ -92,6 +92,7 @@ public:
 
   // Stream Classifiers.
   bool isEOS          () const;
+  bool isHexPrefix    (std::size_t) const;
   bool isString       (std::string&, Lexer::Type&, const std::string&);
   bool isDate         (std::string&, Lexer::Type&);
   bool isDuration     (std::string&, Lexer::Type&);
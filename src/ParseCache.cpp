@@ -0,0 +1,155 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmake.h>
+#include <ParseCache.h>
+#include <functional>
+#include <Context.h>
+#include <FS.h>
+#include <format.h>
+
+// Beyond this size, the cache is started afresh.
+#define PARSE_CACHE_LIMIT 1048576
+
+bool ParseCache::_loaded = false;
+std::unordered_map <std::string, std::string> ParseCache::_entries;
+
+////////////////////////////////////////////////////////////////////////////////
+// Identifies everything other than its input that a parse depends on.  Empty
+// when the cache is not used, including while debugging the parser, which is
+// done by watching it run.
+std::string ParseCache::stamp ()
+{
+  auto& config = Context::getContext ().config;
+  if (! config.getBoolean ("parser.cache") ||
+      config.getBoolean ("debug")          ||
+      config.getInteger ("debug.parser"))
+    return "";
+
+  std::string all;
+  for (auto& setting : config)
+    all += setting.first + '=' + setting.second + '\n';
+
+  return format ("{1} {2}\n", PACKAGE_VERSION, (unsigned long long) std::hash <std::string> () (all));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool ParseCache::get (const std::string& key, std::string& value)
+{
+  if (! _loaded)
+    load ();
+
+  auto entry = _entries.find (key);
+  if (entry == _entries.end ())
+    return false;
+
+  value = entry->second;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Entries are appended, and replace any earlier entry with the same key when
+// the file is next loaded.
+void ParseCache::put (const std::string& key, const std::string& value)
+{
+  if (! _loaded)
+    load ();
+
+  _entries[key] = value;
+
+  std::string entry;
+  encode (entry, key);
+  encode (entry, value);
+
+  File file (Context::getContext ().data_dir._data + "/parse.cache");
+  if (file.open ())
+  {
+    if (Context::getContext ().config.getBoolean ("locking"))
+      file.lock ();
+
+    if (file.size () + entry.length () > PARSE_CACHE_LIMIT)
+      file.truncate ();
+
+    file.append (std::string (""));  // Seek to end of file
+    file.write_raw (entry);
+    file.close ();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Strings are stored as "<length>:<bytes>", so that they may contain anything.
+void ParseCache::encode (std::string& output, const std::string& value)
+{
+  output += format ("{1}:", value.length ()) + value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool ParseCache::decode (
+  const std::string& input,
+  std::string::size_type& cursor,
+  std::string& value)
+{
+  auto colon = input.find (':', cursor);
+  if (colon == std::string::npos || colon == cursor)
+    return false;
+
+  std::string::size_type length = 0;
+  for (auto i = cursor; i < colon; ++i)
+  {
+    if (input[i] < '0' || input[i] > '9')
+      return false;
+
+    length = length * 10 + (input[i] - '0');
+  }
+
+  if (length > input.length () - colon - 1)
+    return false;
+
+  value = input.substr (colon + 1, length);
+  cursor = colon + 1 + length;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// A damaged entry, and any after it, is ignored.
+void ParseCache::load ()
+{
+  _loaded = true;
+
+  std::string contents;
+  if (! File::read (Context::getContext ().data_dir._data + "/parse.cache", contents))
+    return;
+
+  std::string::size_type cursor = 0;
+  std::string key;
+  std::string value;
+  while (decode (contents, cursor, key) &&
+         decode (contents, cursor, value))
+    _entries[key] = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
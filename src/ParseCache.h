@@ -0,0 +1,57 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef INCLUDED_PARSECACHE
+#define INCLUDED_PARSECACHE
+
+#include <string>
+#include <unordered_map>
+
+// ParseCache keeps the results of parsing command lines and filters in
+// parse.cache, in the data directory, so that a repeated invocation may skip
+// the parse.  Entries are keyed by the parse input, and by a stamp of the
+// program version and configuration, which determine the parse result.
+class ParseCache
+{
+public:
+  static std::string stamp ();
+  static bool get (const std::string&, std::string&);
+  static void put (const std::string&, const std::string&);
+
+  static void encode (std::string&, const std::string&);
+  static bool decode (const std::string&, std::string::size_type&, std::string&);
+
+private:
+  static void load ();
+
+private:
+  static bool _loaded;
+  static std::unordered_map <std::string, std::string> _entries;
+};
+
+#endif
+////////////////////////////////////////////////////////////////////////////////
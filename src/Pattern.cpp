@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmake.h>
+#include <Pattern.h>
+#include <Lexer.h>
+#include <shared.h>
+
+////////////////////////////////////////////////////////////////////////////////
+Pattern::Pattern (const Variant& other)
+: _prepared (true)
+, _use_regex (Variant::searchUsingRegex)
+, _case_sensitive (Variant::searchCaseSensitive)
+{
+  Variant right (other);
+  right.cast (Variant::type_string);
+  _pattern = right.get_string ();
+  if (other.type () == Variant::type_string)
+    Lexer::dequote (_pattern);
+
+  Lexer::dequote (_pattern);
+
+  // Without metacharacters, a regex matches just as a search does.
+  if (_use_regex &&
+      _pattern.find_first_of (".[]()*+?{}|^$\\") != std::string::npos)
+  {
+    _regex = true;
+    _rx = RX (_pattern, _case_sensitive);
+  }
+  else if (! _case_sensitive)
+    _pattern = lowerCase (_pattern);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool Pattern::prepared () const
+{
+  return _prepared;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// If the subject does not match, and its source is "description", then the
+// annotations are matched too.
+bool Pattern::match (const Variant& other, const Task& task) const
+{
+  Variant left (other);
+  left.cast (Variant::type_string);
+  std::string subject = left.get_string ();
+  if (other.type () == Variant::type_string)
+    Lexer::dequote (subject);
+
+  if (matchText (subject, true))
+    return true;
+
+  if (other.source () == "description")
+    for (auto& a : task.annotations ())
+      if (matchText (a.second, false))
+        return true;
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Without regexes, a leading '^' or trailing '$' anchors the search, except in
+// annotations.
+bool Pattern::matchText (const std::string& text, bool anchored) const
+{
+  if (_regex)
+    return _rx.match (text);
+
+  const std::string& subject = _case_sensitive ? text : lowerCase (text);
+
+  if (! _use_regex && anchored && _pattern.length ())
+  {
+    // If pattern starts with '^', look for a leftmost compare only.
+    if (_pattern[0] == '^' &&
+        subject.find (_pattern.substr (1)) == 0)
+      return true;
+
+    // If pattern ends with '$', look for a rightmost compare only.
+    if (_pattern[_pattern.length () - 1] == '$' &&
+        subject.find (_pattern.substr (0, _pattern.length () - 1)) == subject.length () - _pattern.length () + 1)
+      return true;
+  }
+
+  return subject.find (_pattern) != std::string::npos;
+}
+
+////////////////////////////////////////////////////////////////////////////////
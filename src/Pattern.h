@@ -0,0 +1,61 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef INCLUDED_PATTERN
+#define INCLUDED_PATTERN
+
+#include <string>
+#include <RX.h>
+#include <Task.h>
+#include <Variant.h>
+
+// The right operand of the ~ and !~ operators, prepared once so that it may be
+// matched against many tasks.  A pattern without regex metacharacters is
+// searched for as a literal, and the subject is case-folded only once.
+class Pattern
+{
+public:
+  Pattern () = default;
+  explicit Pattern (const Variant&);
+
+  bool prepared () const;
+  bool match (const Variant&, const Task&) const;
+
+private:
+  bool matchText (const std::string&, bool) const;
+
+private:
+  bool        _prepared       {false};
+  bool        _use_regex      {false};  // As Variant::searchUsingRegex
+  bool        _regex          {false};  // Matched by _rx, not searched for
+  bool        _case_sensitive {true};
+  std::string _pattern        {};       // Case-folded unless _case_sensitive
+  mutable RX  _rx             {};       // Compiled on first use
+};
+
+#endif
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,178 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmake.h>
+#include <Pool.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <Context.h>
+
+// A batch, while its chunks are being run.
+struct Batch
+{
+  const std::function <void (size_t)>* chunk;
+  size_t                               chunks;
+  std::atomic <size_t>                 next     {0};
+  size_t                               done     {0};
+  std::vector <Context::Messages>      messages {};
+  std::vector <std::exception_ptr>     errors   {};
+};
+
+static std::mutex pool_mutex;
+static std::condition_variable queued;
+static std::condition_variable finished;
+static std::deque <std::shared_ptr <Batch>> queue;
+static std::vector <std::thread> workers;
+static bool stopping = false;
+
+// The pool threads are stopped at exit.
+static struct Stopper
+{
+  ~Stopper ()
+  {
+    {
+      std::lock_guard <std::mutex> lock (pool_mutex);
+      stopping = true;
+    }
+
+    queued.notify_all ();
+    for (auto& worker : workers)
+      worker.join ();
+  }
+} stopper;
+
+////////////////////////////////////////////////////////////////////////////////
+// Runs chunks of the batch until none are left to take.
+static void take (Batch& batch)
+{
+  for (size_t i; (i = batch.next++) < batch.chunks; )
+  {
+    {
+      Context::Worker worker (batch.messages[i]);
+      try
+      {
+        (*batch.chunk) (i);
+      }
+
+      catch (...)
+      {
+        batch.errors[i] = std::current_exception ();
+      }
+    }
+
+    std::lock_guard <std::mutex> lock (pool_mutex);
+    if (++batch.done == batch.chunks)
+      finished.notify_all ();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// A pool thread takes chunks from the oldest batch that has any left.
+static void serve ()
+{
+  std::unique_lock <std::mutex> lock (pool_mutex);
+  while (true)
+  {
+    queued.wait (lock, [] () { return stopping || ! queue.empty (); });
+    if (stopping)
+      return;
+
+    auto batch = queue.front ();
+    if (batch->next >= batch->chunks)
+    {
+      queue.pop_front ();
+      continue;
+    }
+
+    lock.unlock ();
+    take (*batch);
+    lock.lock ();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The threads a batch may run on, including the calling thread.
+size_t Pool::threads ()
+{
+  size_t threads = Context::getContext ().config.getInteger ("threads");
+  if (threads == 0)
+    threads = std::thread::hardware_concurrency ();
+
+  return std::max (threads, (size_t) 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Runs chunk (0) to chunk (chunks - 1), concurrently where there are threads.
+void Pool::run (size_t chunks, const std::function <void (size_t)>& chunk)
+{
+  auto count = threads ();
+  if (chunks <= 1 || count <= 1)
+  {
+    for (size_t i = 0; i < chunks; ++i)
+      chunk (i);
+
+    return;
+  }
+
+  auto batch = std::make_shared <Batch> ();
+  batch->chunk  = &chunk;
+  batch->chunks = chunks;
+  batch->messages.resize (chunks);
+  batch->errors.resize (chunks);
+
+  {
+    std::lock_guard <std::mutex> lock (pool_mutex);
+    while (workers.size () + 1 < count)
+      workers.emplace_back (serve);
+
+    queue.push_back (batch);
+  }
+
+  queued.notify_all ();
+  take (*batch);
+
+  {
+    std::unique_lock <std::mutex> lock (pool_mutex);
+    finished.wait (lock, [&batch] () { return batch->done == batch->chunks; });
+  }
+
+  for (auto& messages : batch->messages)
+    Context::getContext ().merge (messages);
+
+  for (auto& error : batch->errors)
+    if (error)
+      std::rethrow_exception (error);
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,51 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef INCLUDED_POOL
+#define INCLUDED_POOL
+
+#include <functional>
+#include <stddef.h>
+
+// Pool is the one set of threads, sized by rc.threads, that every concurrent
+// stage runs on, so that stages never have more threads than cores between
+// them.  A stage splits its batch into chunks, which the pool threads and the
+// calling thread take in turn until none are left, so that a chunk may itself
+// run a batch without waiting for a free thread.
+//
+// The messages of each chunk are held, and merged in chunk order, and the
+// first error in chunk order is rethrown, so the result is that of running the
+// chunks serially.
+class Pool
+{
+public:
+  static size_t threads ();
+  static void run (size_t, const std::function <void (size_t)>&);
+};
+
+#endif
+////////////////////////////////////////////////////////////////////////////////
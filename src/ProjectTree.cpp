@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmake.h>
+#include <ProjectTree.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Finds or adds the node for a project, and its parents.  A shown project
+// shows its parents too.
+ProjectTree::Node& ProjectTree::add (const std::string& project, bool shown /* = true */)
+{
+  Node* node = &_root;
+  std::string::size_type start = 0;
+  std::string::size_type pos = 0;
+  while (start < project.length ())
+  {
+    // A leading or trailing delimiter is part of the name.
+    pos = project.find ('.', pos + 1);
+    if (pos == project.length () - 1)
+      pos = std::string::npos;
+
+    auto end = pos == std::string::npos ? project.length () : pos;
+    node = &node->children[project.substr (start, end - start)];
+    if (node->name == "")
+      node->name = project.substr (0, end);
+
+    node->shown = node->shown || shown;
+    start = end + 1;
+  }
+
+  if (project == "")
+    _root.shown = _root.shown || shown;
+
+  return *node;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Adds the counts of every project to those of its parents.  The empty project
+// is not a parent.
+void ProjectTree::total ()
+{
+  for (auto& child : _root.children)
+    total (child.second);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ProjectTree::total (Node& node)
+{
+  for (auto& child : node.children)
+  {
+    total (child.second);
+    node.tasks     += child.second.tasks;
+    node.pending   += child.second.pending;
+    node.completed += child.second.completed;
+    node.age       += child.second.age;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Visits the shown projects, each followed by its subprojects, in name order.
+void ProjectTree::visit (std::function <void (const Node&)> callback) const
+{
+  visit (_root, callback);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ProjectTree::visit (const Node& node, std::function <void (const Node&)>& callback) const
+{
+  if (node.shown)
+    callback (node);
+
+  for (auto& child : node.children)
+    visit (child.second, callback);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The number of shown projects, including the empty project.
+int ProjectTree::shown () const
+{
+  return shown (_root);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int ProjectTree::shown (const Node& node) const
+{
+  int count = node.shown ? 1 : 0;
+  for (auto& child : node.children)
+    count += shown (child.second);
+
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
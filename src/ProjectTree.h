@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef INCLUDED_PROJECTTREE
+#define INCLUDED_PROJECTTREE
+
+#include <map>
+#include <string>
+#include <functional>
+
+// ProjectTree holds project names as a trie of their dot-separated parts, so
+// that counts roll up to the parent projects, and the projects can be listed
+// in hierarchical order, in one traversal.  Names are split wherever
+// extractParents splits them.
+class ProjectTree
+{
+public:
+  struct Node
+  {
+    std::string name;                       // Full project name
+    bool shown {false};                     // Listed by visit ()
+    int tasks {0};                          // Counts include subprojects
+    int pending {0};
+    int completed {0};
+    double age {0.0};
+    std::map <std::string, Node> children;  // By name part, ordered
+  };
+
+  Node& add (const std::string&, bool shown = true);
+  void total ();
+  void visit (std::function <void (const Node&)>) const;
+  int shown () const;
+
+private:
+  void total (Node&);
+  void visit (const Node&, std::function <void (const Node&)>&) const;
+  int shown (const Node&) const;
+
+private:
+  Node _root;                               // The empty project
+};
+
+#endif
+////////////////////////////////////////////////////////////////////////////////
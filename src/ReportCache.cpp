@@ -0,0 +1,194 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmake.h>
+#include <ReportCache.h>
+#include <functional>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <Context.h>
+#include <ParseCache.h>
+#include <Datetime.h>
+#include <FS.h>
+#include <format.h>
+
+// The most recent entries kept.
+#define REPORT_CACHE_ENTRIES 8
+
+////////////////////////////////////////////////////////////////////////////////
+// Identifies everything the output of a report depends on, other than the
+// time.  Empty when the cache is not used, including when a streamed report
+// is written as it is rendered, and not kept.
+std::string ReportCache::key ()
+{
+  auto& context = Context::getContext ();
+  if (context.config.getInteger ("report.cache") <= 0 ||
+      context.config.get ("data.sources") != ""    ||
+      context.config.getBoolean ("print.stream")   ||
+      context.config.getBoolean ("debug"))
+    return "";
+
+  std::string all = PACKAGE_VERSION "\n";
+  for (auto& arg : context.cli2._original_args)
+    all += arg.attribute ("raw") + '\n';
+
+  for (auto& setting : context.config)
+    all += setting.first + '=' + setting.second + '\n';
+
+  // Every commit appends to undo.data, so that its stamp changes even when a
+  // data file is rewritten within the same second, at the same size.
+  for (auto& name : {"pending.data", "completed.data", "undo.data", "backlog.data"})
+  {
+    struct stat s;
+    if (stat ((context.data_dir._data + '/' + name).c_str (), &s) == 0)
+      all += format ("{1} {2} {3}\n", (long long) s.st_size, (long long) s.st_mtime, (long long) s.st_ino);
+    else
+      all += "-\n";
+  }
+
+  // Relative dates, and virtual tags such as TODAY, change at midnight.
+  all += format ("{1} {2} {3}\n", context.getWidth (), context.color () ? 1 : 0, Datetime ().startOfDay ().toEpoch ());
+
+  return format ("{1}", (unsigned long long) std::hash <std::string> () (all));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool ReportCache::get (
+  const std::string& key,
+  std::string& output,
+  std::vector <std::string>& headers,
+  std::vector <std::string>& footnotes)
+{
+  std::vector <std::string> records;
+  if (! load (records))
+    return false;
+
+  auto now = Datetime ().toEpoch ();
+  for (auto& record : records)
+  {
+    std::string::size_type cursor = 0;
+    std::string value;
+    if (! ParseCache::decode (record, cursor, value) ||
+        value != key                                 ||
+        ! ParseCache::decode (record, cursor, value) ||
+        strtoll (value.c_str (), nullptr, 10) <= now ||
+        ! ParseCache::decode (record, cursor, output))
+      continue;
+
+    std::vector <std::string> lines[2];
+    for (auto& list : lines)
+    {
+      if (! ParseCache::decode (record, cursor, value))
+        return false;
+
+      for (auto count = strtol (value.c_str (), nullptr, 10); count > 0; --count)
+      {
+        if (! ParseCache::decode (record, cursor, value))
+          return false;
+
+        list.push_back (value);
+      }
+    }
+
+    headers   = lines[0];
+    footnotes = lines[1];
+    return true;
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The new entry is kept first, followed by the most recent others, which
+// replaces any earlier entry for the same key.
+void ReportCache::put (
+  const std::string& key,
+  const std::string& output,
+  const std::vector <std::string>& headers,
+  const std::vector <std::string>& footnotes)
+{
+  auto& context = Context::getContext ();
+
+  std::string record;
+  ParseCache::encode (record, key);
+  ParseCache::encode (record, format ((long long) Datetime ().toEpoch () + context.config.getInteger ("report.cache")));
+  ParseCache::encode (record, output);
+  for (auto list : {&headers, &footnotes})
+  {
+    ParseCache::encode (record, format ((int) list->size ()));
+    for (auto& line : *list)
+      ParseCache::encode (record, line);
+  }
+
+  std::vector <std::string> records;
+  load (records);
+
+  std::string contents;
+  ParseCache::encode (contents, record);
+  int kept = 1;
+  for (auto& other : records)
+  {
+    std::string::size_type cursor = 0;
+    std::string value;
+    if (kept < REPORT_CACHE_ENTRIES              &&
+        ParseCache::decode (other, cursor, value) &&
+        value != key)
+    {
+      ParseCache::encode (contents, other);
+      ++kept;
+    }
+  }
+
+  File file (context.data_dir._data + "/report.cache");
+  if (file.open ())
+  {
+    if (context.config.getBoolean ("locking"))
+      file.lock ();
+
+    file.truncate ();
+    file.write_raw (contents);
+    file.close ();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// A damaged record, and any after it, is ignored.
+bool ReportCache::load (std::vector <std::string>& records)
+{
+  std::string contents;
+  if (! File::read (Context::getContext ().data_dir._data + "/report.cache", contents))
+    return false;
+
+  std::string::size_type cursor = 0;
+  std::string record;
+  while (ParseCache::decode (contents, cursor, record))
+    records.push_back (record);
+
+  return records.size () > 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,52 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef INCLUDED_REPORTCACHE
+#define INCLUDED_REPORTCACHE
+
+#include <string>
+#include <vector>
+
+// ReportCache keeps the output of recent reports in report.cache, in the data
+// directory, so that a report repeated before the data changes, and within
+// report.cache seconds, is not run again.  The burndown charts keep their
+// counts in the same way.  Entries are keyed by the command
+// line, the configuration, the terminal, the date, and a stamp of each data
+// file, which changes with every commit.
+class ReportCache
+{
+public:
+  static std::string key ();
+  static bool get (const std::string&, std::string&, std::vector <std::string>&, std::vector <std::string>&);
+  static void put (const std::string&, const std::string&, const std::vector <std::string>&, const std::vector <std::string>&);
+
+private:
+  static bool load (std::vector <std::string>&);
+};
+
+#endif
+////////////////////////////////////////////////////////////////////////////////
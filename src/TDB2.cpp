@@ -27,16 +27,30 @@
 #include <cmake.h>
 #include <TDB2.h>
 #include <iostream>
+#include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <cfloat>
+#include <limits>
 #include <list>
+#include <numeric>
 #include <set>
+#include <unordered_map>
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 #include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <Allocations.h>
 #include <Context.h>
 #include <Color.h>
 #include <Datetime.h>
+#include <Pool.h>
 #include <Table.h>
+#include <Trace.h>
 #include <shared.h>
 #include <format.h>
 #include <main.h>
@@ -44,8 +58,24 @@
 
 #define STRING_TDB2_REVERTED         "Modified task reverted."
 
+#define LOAD_CHUNK_MINIMUM 1000
+
+// Tasks parsed at a time by TF2::stream.
+#define STREAM_BLOCK 1000
+
 bool TDB2::debug_mode = false;
 
+////////////////////////////////////////////////////////////////////////////////
+// The start of a mapped file, after any UTF-8 byte order mark, which File::read
+// also skips.
+static const char* skip_bom (const char* start, const char* end)
+{
+  if (end - start >= 3 && memcmp (start, "\xEF\xBB\xBF", 3) == 0)
+    return start + 3;
+
+  return start;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 TF2::TF2 ()
 : _read_only (false)
@@ -54,6 +84,17 @@ TF2::TF2 ()
 , _loaded_lines (false)
 , _has_ids (false)
 , _auto_dep_scan (false)
+, _use_index (false)
+, _end_order (false)
+, _staged_index (false)
+, _superseded (0)
+, _snapshot (-1)
+, _held (false)
+, _bom (0)
+, _indexed (0)
+, _unparsed (false)
+, _numbered (-1)
+, _index_gc (-1)
 {
 }
 
@@ -68,6 +109,7 @@ TF2::~TF2 ()
 void TF2::target (const std::string& f)
 {
   _file = File (f);
+  _index.target (f);
 
   // A missing file is not considered unwritable.
   _read_only = false;
@@ -84,6 +126,90 @@ const std::vector <Task>& TF2::get_tasks ()
   return _tasks;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// The tasks that may lie within the bounds.  With a current index, segments of
+// an unloaded file that cannot hold such a task are not read, and tasks that
+// cannot lie within the bounds are not parsed.  Otherwise, this is all tasks.
+const std::vector <Task>& TF2::get_tasks (const TF2Index::Bounds& bounds)
+{
+  if (_loaded_tasks || _has_ids || ! index_ok ())
+    return get_tasks ();
+
+  Timer timer;
+
+  // A journaled file may hold earlier records of a task, which are skipped.
+  auto& entries = _index.entries ();
+  std::unordered_map <std::string, uint64_t> current;
+  current.reserve (entries.size ());
+  for (auto& entry : entries)
+    current[std::string (entry.uuid, 36)] = entry.offset;
+
+  _partial.clear ();
+  std::string text;
+  std::vector <size_t> candidates;
+  int read = 0;
+  _index.open ();
+  auto& segments = _index.segments ();
+  for (auto s : _index.candidates (bounds))
+  {
+    auto& segment = segments[s];
+    candidates.clear ();
+    for (auto i = segment.first; i < segment.first + segment.count; ++i)
+      if (! _index.excludes (entries[i], bounds) &&
+          current[std::string (entries[i].uuid, 36)] == entries[i].offset)
+        candidates.push_back (i);
+
+    if (candidates.empty ())
+      continue;
+
+    // A few lines are read individually, otherwise the whole segment.
+    bool ok = true;
+    if (candidates.size () * 4 < segment.count)
+    {
+      for (auto i : candidates)
+      {
+        if (! (ok = _index.read (entries[i], text)))
+          break;
+
+        _partial.push_back (Task (text));
+      }
+    }
+    else if ((ok = _index.read (segment, text)))
+    {
+      auto base = entries[segment.first].offset;
+      for (auto i : candidates)
+        _partial.push_back (Task (text.substr (entries[i].offset - base, entries[i].length)));
+    }
+
+    if (! ok)
+    {
+      _index.close ();
+      _partial.clear ();
+      Context::getContext ().time_load_us += timer.total_us ();
+      return get_tasks ();
+    }
+
+    ++read;
+  }
+
+  _index.close ();
+
+  Context::getContext ().debug (format ("TF2 {1} parsed {2} tasks from {3} of {4} segments",
+                                        std::string (_file),
+                                        (int) _partial.size (),
+                                        read,
+                                        (int) _index.segments ().size ()));
+
+  Context::getContext ().count_parsed += (long) _partial.size ();
+
+  // Tasks added since, which are not in the file.
+  for (auto& task : _tasks)
+    _partial.push_back (task);
+
+  Context::getContext ().time_load_us += timer.total_us ();
+  return _partial;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 const std::vector <std::string>& TF2::get_lines ()
 {
@@ -121,56 +247,246 @@ bool TF2::get (int id, Task& task)
 bool TF2::get (const std::string& uuid, Task& task)
 {
   if (! _loaded_tasks)
+  {
+    // The index allows a single task to be located and parsed without loading
+    // the whole file.  Files with IDs are excluded, because an ID depends on
+    // the position of every preceding task.
+    if (! _has_ids && uuid.size () == 36 && index_ok ())
+    {
+      for (auto& i : _added_tasks)
+      {
+        if (i.get ("uuid") == uuid)
+        {
+          task = i;
+          return true;
+        }
+      }
+
+      // The latest modification made without loading the file, if any.
+      for (auto i = _modified_tasks.rbegin (); i != _modified_tasks.rend (); ++i)
+      {
+        if (i->get ("uuid") == uuid)
+        {
+          task = *i;
+          return true;
+        }
+      }
+
+      std::string line;
+      auto entry = _index.find (uuid);
+      if (entry && _index.read (*entry, line))
+      {
+        task = Task (line);
+        return true;
+      }
+
+      if (! entry)
+        return false;
+    }
+
     load_tasks ();
+  }
+
+  size_t position;
+  if (uuid.size () == 36)
+  {
+    if (! this->position (uuid, position))
+      return false;
+
+    task = _tasks[position];
+    return true;
+  }
 
-  if (_tasks_map.size () > 0 && uuid.size () == 36)
+  // A partial UUID needs a scan.
+  for (auto& i : _tasks)
   {
-    // Fast lookup, same result as below. Only used during "task import".
-    auto i = _tasks_map.find (uuid);
-    if (i != _tasks_map.end ())
+    if (closeEnough (i.get ("uuid"), uuid, uuid.length ()))
     {
-      task = i->second;
+      task = i;
       return true;
     }
   }
-  else
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TF2::has (const std::string& uuid)
+{
+  if (! _loaded_tasks)
   {
-    // Slow lookup, same result as above.
-    for (auto& i : _tasks)
+    // The index can answer this without loading the file, see TF2::get.
+    if (! _has_ids && uuid.size () == 36 && index_ok ())
     {
-      if (closeEnough (i.get ("uuid"), uuid, uuid.length ()))
-      {
-        task = i;
-        return true;
-      }
+      for (auto& i : _added_tasks)
+        if (i.get ("uuid") == uuid)
+          return true;
+
+      return _index.find (uuid) != nullptr;
     }
+
+    load_tasks ();
   }
 
-  return false;
+  size_t position;
+  return this->position (uuid, position);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-bool TF2::has (const std::string& uuid)
+// Whether a new task can be added to the unloaded file without loading it.  The
+// index must show that the uuid is new, and give the number of tasks a load
+// would number, as TF2::assign_id does, so that the new task follows them.
+bool TF2::can_append (const std::string& uuid, int& numbered)
+{
+  if (_loaded_tasks || ! _has_ids || ! _modified_tasks.empty () ||
+      ! _added_lines.empty () || uuid.size () != 36 || ! index_ok ())
+    return false;
+
+  for (auto& task : _added_tasks)
+    if (task.get ("uuid") == uuid)
+      return false;
+
+  if (_index.find (uuid))
+    return false;
+
+  if (_numbered < 0)
+  {
+    // The last record of a journaled task holds its status.
+    std::unordered_map <std::string, char> statuses;
+    statuses.reserve (_index.entries ().size ());
+    for (auto& entry : _index.entries ())
+      statuses[std::string (entry.uuid, 36)] = entry.status;
+
+    _numbered = 0;
+    for (auto& status : statuses)
+      if (! Context::getContext ().run_gc ||
+          (status.second != 'c' && status.second != 'd'))
+        ++_numbered;
+  }
+
+  numbered = _numbered;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The positions in _tasks of the tasks with the given parent.  Tasks are only
+// ever appended to _tasks, or replaced in place, so the index is extended as
+// required, and each position is checked in case the parent has since changed.
+void TF2::children (const std::string& parent, std::vector <size_t>& positions)
 {
   if (! _loaded_tasks)
     load_tasks ();
 
-  for (auto& i : _tasks)
-    if (i.get ("uuid") == uuid)
+  index_tasks ();
+
+  // A file holding text that is not a UUID is scanned.
+  Uuid key;
+  if (_unparsed || ! Uuid::parse (parent, key))
+  {
+    for (size_t i = 0; i < _tasks.size (); ++i)
+      if (_tasks[i].get ("parent") == parent)
+        positions.push_back (i);
+
+    return;
+  }
+
+  auto range = _children.equal_range (key);
+  for (auto i = range.first; i != range.second; ++i)
+    if (_tasks[i->second].get ("parent") == parent)
+      positions.push_back (i->second);
+
+  // The order of the file, as a scan would find them.
+  std::sort (positions.begin (), positions.end ());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Indexes a task modified in place, whose parent has changed.
+void TF2::index_child (const Task& task)
+{
+  Uuid parent;
+  Uuid uuid;
+  if (_indexed == 0 ||
+      ! Uuid::parse (task.get ("parent"), parent) ||
+      ! Uuid::parse (task.get ("uuid"), uuid))
+    return;
+
+  // A task beyond those indexed is indexed when reached.
+  auto found = _positions.find (uuid);
+  if (found == _positions.end ())
+    return;
+
+  auto range = _children.equal_range (parent);
+  for (auto i = range.first; i != range.second; ++i)
+    if (i->second == found->second)
+      return;
+
+  _children.emplace (parent, found->second);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Extends the UUID and parent indexes over tasks appended to _tasks.  Where a
+// UUID appears more than once, the first is found, as a scan would.  Should a
+// file hold text that is not a UUID, lookups fall back to scanning.
+void TF2::index_tasks ()
+{
+  Uuid uuid;
+  for (; _indexed < _tasks.size (); ++_indexed)
+  {
+    auto& task = _tasks[_indexed];
+    if (Uuid::parse (task.get ("uuid"), uuid))
+      _positions.emplace (uuid, _indexed);
+    else
+      _unparsed = true;
+
+    if (task.has ("parent"))
+    {
+      if (Uuid::parse (task.get ("parent"), uuid))
+        _children.emplace (uuid, _indexed);
+      else
+        _unparsed = true;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The position in _tasks of the task with the given UUID.
+bool TF2::position (const std::string& uuid, size_t& position)
+{
+  index_tasks ();
+
+  Uuid key;
+  if (Uuid::parse (uuid, key))
+  {
+    auto found = _positions.find (key);
+    if (found != _positions.end ())
+    {
+      position = found->second;
       return true;
+    }
+  }
+
+  if (_unparsed)
+  {
+    for (size_t i = 0; i < _tasks.size (); ++i)
+    {
+      if (_tasks[i].get ("uuid") == uuid)
+      {
+        position = i;
+        return true;
+      }
+    }
+  }
 
   return false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void TF2::add_task (Task& task)
+// The composed F4, where the caller already has it, is kept to be written.
+void TF2::add_task (Task& task, const std::string& composed)
 {
   _tasks.push_back (task);           // For subsequent queries
   _added_tasks.push_back (task);     // For commit/synch
-
-  // For faster lookup
-  if (Context::getContext ().cli2.getCommand () == "import")
-    _tasks_map.insert (std::pair<std::string, Task> (task.get("uuid"), task));
+  keep_composed (task, composed);
 
   Task::status status = task.getStatus ();
   if (task.id == 0 &&
@@ -181,41 +497,84 @@ void TF2::add_task (Task& task)
     task.id = Context::getContext ().tdb2.next_id ();
   }
 
-  _I2U[task.id] = task.get ("uuid");
-  _U2I[task.get ("uuid")] = task.id;
+  auto uuid = task.get ("uuid");
+  _I2U[task.id] = uuid;
+  _U2I[uuid] = task.id;
 
   _dirty = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-bool TF2::modify_task (const Task& task)
+bool TF2::modify_task (const Task& task, const std::string& composed)
 {
   std::string uuid = task.get ("uuid");
 
-  if (Context::getContext ().cli2.getCommand () == "import")
+  // With data.journal, a task in the index is superseded by appending it, so
+  // the file need not be loaded.  Should the file be rewritten instead, it is
+  // loaded then, see TF2::stage.
+  if (! _loaded_tasks &&
+      ! _has_ids &&
+      Context::getContext ().config.getInteger ("data.journal") > 0 &&
+      index_ok () &&
+      has (uuid))
   {
-    // Update map used for faster lookup
-    auto i = _tasks_map.find (uuid);
-    if (i != _tasks_map.end ())
-    {
-      i->second = task;
-    }
+    _modified_tasks.push_back (task);
+    keep_composed (task, composed);
+    _dirty = true;
+    return true;
   }
 
-  for (auto& i : _tasks)
-  {
-    if (i.get ("uuid") == uuid)
-    {
-      // Modify in-place.
-      i = task;
-      _modified_tasks.push_back (task);
-      _dirty = true;
+  // The task may have been found through the index, or a partial read.
+  if (! _loaded_tasks)
+    load_tasks ();
 
-      return true;
-    }
+  // Modify in-place.
+  size_t position;
+  if (! this->position (uuid, position))
+    return false;
+
+  _tasks[position] = task;
+  _modified.insert (position);
+  keep_composed (task, composed);
+  _dirty = true;
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The latest composed F4 of a task supersedes any earlier one.
+void TF2::keep_composed (const Task& task, const std::string& composed)
+{
+  Uuid key;
+  if (Uuid::parse (task.get ("uuid"), key))
+  {
+    if (composed != "")
+      _composed[key] = composed;
+    else
+      _composed.erase (key);
   }
+}
 
-  return false;
+////////////////////////////////////////////////////////////////////////////////
+// The F4 of a task, as kept by add_task or modify_task, or composed now.
+std::string TF2::compose (const Task& task, const Uuid& key) const
+{
+  auto found = _composed.find (key);
+  if (found != _composed.end ())
+    return found->second;
+
+  return task.composeF4 ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The loaded task in place, or nullptr.
+const Task* TF2::find (const std::string& uuid)
+{
+  size_t position;
+  if (! _loaded_tasks || ! this->position (uuid, position))
+    return nullptr;
+
+  return &_tasks[position];
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -226,8 +585,16 @@ bool TF2::purge_task (const Task& task)
   if (!has (uuid))
     return false;
 
+  Uuid key;
+  if (! Uuid::parse (uuid, key))
+    throw format ("Not a valid UUID '{1}'.", uuid);
+
+  // The file is rewritten without the task, so must be complete.
+  if (! _loaded_tasks)
+    load_tasks ();
+
   // Mark the task to be purged
-  _purged_tasks.insert (uuid);
+  _purged_tasks.insert (key);
   _dirty = true;
 
   return true;
@@ -245,6 +612,12 @@ void TF2::add_line (const std::string& line)
 void TF2::clear_tasks ()
 {
   _tasks.clear ();
+  _modified.clear ();
+  _composed.clear ();
+  _positions.clear ();
+  _children.clear ();
+  _indexed = 0;
+  _unparsed = false;
   _dirty = true;
 }
 
@@ -257,130 +630,544 @@ void TF2::clear_lines ()
 
 ////////////////////////////////////////////////////////////////////////////////
 // Top-down recomposition.
-void TF2::commit ()
+void TF2::commit (bool concurrent /* = false */)
 {
-  // The _dirty flag indicates that the file needs to be written.
-  if (_dirty)
+  // A snapshot is read as it was, while a commit writes the file as it is.
+  if (_snapshot >= 0)
   {
-    // Special case: added but no modified means just append to the file.
-    if (!_modified_tasks.size () && !_purged_tasks.size () &&
-        (_added_tasks.size () || _added_lines.size ()))
-    {
-      if (_file.open ())
-      {
-        if (Context::getContext ().config.getBoolean ("locking"))
-          _file.lock ();
+    _file.close ();
+    _snapshot = -1;
+  }
 
-        // Write out all the added tasks.
-        _file.append (std::string(""));  // Seek to end of file
-        for (auto& task : _added_tasks)
-          _file.write_raw (task.composeF4 () + "\n");
+  // Concurrent additions are appended without the index, which cannot know the
+  // offset of each, and which is left stale, to be rebuilt on next load.
+  if (_dirty && concurrent)
+  {
+    std::string text;
+    if (! stage (text) || ! append (text))
+      throw format ("Could not write to '{1}'.", _file._data);
+
+    _staged_index = false;
+    written ();
+  }
 
-        _added_tasks.clear ();
+  // The _dirty flag indicates that the file needs to be written.
+  else if (_dirty)
+  {
+    if (_file.open ())
+    {
+      lock (false);
 
-        // Write out all the added lines.
-        _file.append (_added_lines);
+      // A file loaded by TF2::stage is read through the locked file, which is
+      // neither locked again nor closed, as either would release the lock.
+      _held = true;
 
-        _added_lines.clear ();
-        _file.close ();
-        _dirty = false;
+      // A rewritten file replaces the old one, so that a reader that does not
+      // lock never sees it partly written.
+      std::string text;
+      bool staged;
+      try
+      {
+        staged = stage (text);
       }
-    }
-    else
-    {
-      if (_file.open ())
+      catch (...)
       {
-        if (Context::getContext ().config.getBoolean ("locking"))
-          _file.lock ();
-
-        // Truncate the file and rewrite.
-        _file.truncate ();
+        _held = false;
+        _file.close ();
+        throw;
+      }
 
-        // Only write out _tasks, because any deltas have already been applied.
+      _held = false;
+      if (staged)
+      {
+        if (! replace (text))
+        {
+          _file.close ();
+          throw format ("Could not write to '{1}'.", _file._data);
+        }
+      }
+      else
+      {
         _file.append (std::string(""));  // Seek to end of file
-        for (auto& task : _tasks)
-          // Skip over the tasks that are marked to be purged
-          if (_purged_tasks.find (task.get ("uuid")) == _purged_tasks.end ())
-            _file.write_raw (task.composeF4 () + '\n');
-
-        // Write out all the added lines.
-        _file.append (_added_lines);
-
-        _added_lines.clear ();
-        _file.close ();
-        _dirty = false;
+        _file.write_raw (text);
       }
+
+      _file.close ();
+      written ();
     }
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-// Load a single Task object, handle necessary plumbing work
-Task TF2::load_task (const std::string& line)
+// Whether a commit would only append added tasks or lines, as a commit that
+// does nothing does.
+bool TF2::adds_only () const
 {
-  Task task (line);
+  return ! _dirty ||
+         (_purged_tasks.empty ()   &&
+          _modified_tasks.empty () &&
+          _modified.empty ()       &&
+          (_added_tasks.size () || _added_lines.size ()));
+}
 
-  // Some tasks get an ID.
-  if (_has_ids)
+////////////////////////////////////////////////////////////////////////////////
+// Appends the text in one write, through O_APPEND, under a shared lock, so that
+// other appends go ahead at the same time, while a rewrite, which locks the file
+// exclusively, waits.  A partial record left at the end of the file by a
+// writer that failed is first cut off, under an exclusive lock.
+bool TF2::append (const std::string& text)
+{
+  auto path = _file._data;
+  bool locking = Context::getContext ().config.getBoolean ("locking");
+  auto set_lock = [&] (int fd, short type)
   {
-    Task::status status = task.getStatus ();
-    // Completed / deleted tasks in pending.data get an ID if GC is off.
-    if (! Context::getContext ().run_gc ||
-        (status != Task::completed && status != Task::deleted))
-      task.id = Context::getContext ().tdb2.next_id ();
-  }
-
-  // Maintain mapping for ease of link/dependency resolution.
-  // Note that this mapping is not restricted by the filter, and is
-  // therefore a complete set.
-  if (task.id)
+    struct flock fl {};
+    fl.l_type   = type;
+    fl.l_whence = SEEK_SET;
+    Timer timer;
+    auto locked = fcntl (fd, F_SETLKW, &fl);
+    Context::getContext ().time_lock_us += timer.total_us ();
+    return locked == 0;
+  };
+
+  // The file locked must still be the one named, not one since replaced.
+  auto named = [&] (int fd)
   {
-    _I2U[task.id] = task.get ("uuid");
-    _U2I[task.get ("uuid")] = task.id;
-  }
+    struct stat opened;
+    struct stat current;
+    return fstat (fd, &opened) != 0            ||
+           stat (path.c_str (), &current) != 0 ||
+           (opened.st_dev == current.st_dev &&
+            opened.st_ino == current.st_ino);
+  };
+
+  // Opens and locks the file named, again if it is replaced meanwhile.
+  auto open_locked = [&] (short type)
+  {
+    while (true)
+    {
+      int fd = open (path.c_str (), O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+      if (fd == -1 || ! locking || ! set_lock (fd, type) || named (fd))
+        return fd;
 
-  return task;
-}
+      close (fd);
+    }
+  };
 
-////////////////////////////////////////////////////////////////////////////////
-// Check whether task needs to be relocated to pending/completed,
-// or needs to be 'woken'.
-void TF2::load_gc (Task& task)
-{
-  Datetime now;
+  // Where the file does not end a line, either a write was cut short, leaving
+  // a partial task record, which is cut off, or the last line only lacks its
+  // newline.  Returns the length to keep, and whether a newline is needed.
+  auto unended = [] (int fd, off_t& keep, bool& newline)
+  {
+    struct stat st;
+    if (fstat (fd, &st) != 0 || st.st_size == 0)
+      return false;
+
+    char c = '\n';
+    keep = st.st_size;
+    while (keep > 0 && pread (fd, &c, 1, keep - 1) == 1 && c != '\n')
+      --keep;
+
+    char first = 0;
+    char last = 0;
+    bool partial = keep != st.st_size                        &&
+                   pread (fd, &first, 1, keep) == 1          &&
+                   pread (fd, &last, 1, st.st_size - 1) == 1 &&
+                   first == '[' && last != ']';
+    newline = keep != st.st_size && ! partial;
+    if (! partial)
+      keep = st.st_size;
+
+    return partial || newline;
+  };
+
+  int fd = open_locked (F_RDLCK);
+  if (fd == -1)
+    return false;
 
-  std::string status = task.get ("status");
-  if (status == "pending" ||
-      status == "recurring")
+  off_t keep = 0;
+  bool newline = false;
+  bool repair = unended (fd, keep, newline);
+  if (repair && locking)
   {
-    Context::getContext ().tdb2.pending._tasks.push_back (task);
+    // While the lock is released, the file may be replaced, so the tail is
+    // looked at again, of whichever file is locked exclusively.
+    set_lock (fd, F_UNLCK);
+    if (! set_lock (fd, F_WRLCK) || ! named (fd))
+    {
+      close (fd);
+      fd = open_locked (F_WRLCK);
+      if (fd == -1)
+        return false;
+    }
+
+    repair = unended (fd, keep, newline);
   }
-  else if (status == "waiting")
+
+  if (repair && ! newline)
   {
-    Datetime wait (task.get_date ("wait"));
-    if (wait < now)
+    Context::getContext ().debug (format ("TF2::append {1} cut at a partial record, at byte {2}", path, (long long) keep));
+    if (ftruncate (fd, keep) != 0)
     {
-      task.set ("status", "pending");
-      task.remove ("wait");
-      // Unwaiting pending tasks is the only case not caught by the size()
-      // checks in TDB2::gc(), so we need to signal it here.
-      Context::getContext ().tdb2.pending._dirty = true;
-
-      if (Context::getContext ().verbose ("unwait"))
-        Context::getContext ().footnote (format ("Un-waiting task {1} '{2}'", task.id, task.get ("description")));
+      close (fd);
+      return false;
     }
-
-    Context::getContext ().tdb2.pending._tasks.push_back (task);
   }
-  else
+
+  std::string ended;
+  if (newline)
+    ended = '\n' + text;
+
+  const char* data = newline ? ended.data () : text.data ();
+  size_t remaining = newline ? ended.length () : text.length ();
+  while (remaining)
   {
-    Context::getContext ().tdb2.completed._tasks.push_back (task);
+    auto n = write (fd, data, remaining);
+    if (n < 0)
+    {
+      close (fd);
+      return false;
+    }
+
+    data += n;
+    remaining -= n;
+  }
+
+  close (fd);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Writes the text to a copy of the file, which is then renamed over it, while
+// the lock on the old file is held.  A symlink is followed, so that the file
+// linked to is the one replaced, and the owner, group and permissions are kept.
+// A file with several hard links is rewritten in place instead, as a rename
+// would leave the other links on the old contents.
+bool TF2::replace (const std::string& text)
+{
+  std::string path = _file._data;
+  char resolved[PATH_MAX];
+  if (realpath (path.c_str (), resolved))
+    path = resolved;
+
+  struct stat s;
+  bool exists = stat (path.c_str (), &s) == 0;
+  if (exists && s.st_nlink > 1)
+  {
+    _file.truncate ();
+    _file.write_raw (text);
+    return true;
+  }
+
+  auto temp = path + ".new";
+  int fd = open (temp.c_str (), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd == -1)
+    return false;
+
+  auto abandon = [&] ()
+  {
+    close (fd);
+    unlink (temp.c_str ());
+    return false;
+  };
+
+  // Only the owner may give the file away, so a failure leaves it to whoever
+  // rewrote it, as the old in-place rewrite did not.
+  if (exists)
+  {
+    if (fchown (fd, s.st_uid, s.st_gid) != 0)
+      Context::getContext ().debug (format ("TF2::replace could not keep the owner of {1}", path));
+
+    if (fchmod (fd, s.st_mode & 07777) != 0)
+      return abandon ();
+  }
+
+  const char* data = text.data ();
+  size_t remaining = text.length ();
+  while (remaining)
+  {
+    auto n = write (fd, data, remaining);
+    if (n < 0)
+      return abandon ();
+
+    data += n;
+    remaining -= n;
+  }
+
+  // The contents are on disk before the rename, so that a crash leaves either
+  // the old file or the new one, never an empty or partial one.
+  if (fsync (fd) != 0)
+    return abandon ();
+
+  close (fd);
+  if (rename (temp.c_str (), path.c_str ()) != 0)
+  {
+    unlink (temp.c_str ());
+    return false;
+  }
+
+  // A rename is only durable once the directory is synced.
+  auto slash = path.rfind ('/');
+  int dir = open (slash == std::string::npos ? "." : path.substr (0, slash + (slash == 0)).c_str (),
+                  O_RDONLY | O_CLOEXEC);
+  if (dir != -1)
+  {
+    fsync (dir);
+    close (dir);
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Opens the file and notes its size, for TDB2::snapshot.  Once read, the file is
+// not read again, and the index, which describes the file as it is, is unused.
+void TF2::snapshot ()
+{
+  if (_loaded_lines || _loaded_tasks || ! _file.open ())
+    return;
+
+  struct stat st;
+  if (fstat (fileno (_file._fh), &st) == 0)
+    _snapshot = st.st_size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Locks the open file, shared to read it, so that readers wait for a commit but
+// not for each other, or exclusive to write it.  Should a commit replace the
+// file during the wait, the replacement is opened and locked instead.
+void TF2::lock (bool shared)
+{
+  if (! Context::getContext ().config.getBoolean ("locking"))
+    return;
+
+  while (true)
+  {
+    struct flock fl {};
+    fl.l_type   = shared ? F_RDLCK : F_WRLCK;
+    fl.l_whence = SEEK_SET;
+
+    int fd = fileno (_file._fh);
+    struct stat opened;
+    struct stat named;
+    Timer timer;
+    auto locked = fcntl (fd, F_SETLKW, &fl);
+    Context::getContext ().time_lock_us += timer.total_us ();
+    if (locked != 0                                     ||
+        fstat (fd, &opened) != 0                        ||
+        stat (_file._data.c_str (), &named) != 0        ||
+        (opened.st_dev == named.st_dev &&
+         opened.st_ino == named.st_ino))
+      return;
+
+    _file.close ();
+    if (! _file.open ())
+      throw format ("Could not open '{1}'.", _file._data);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Compose the text to be written, and return true if it replaces the contents
+// of the file, or false if it is appended.  The index is updated to match, and
+// is saved by TF2::written, once the text is written.
+bool TF2::stage (std::string& text)
+{
+  // Special case: added but no modified means just append to the file.
+  // With data.journal, modified tasks are appended too, each superseding
+  // the earlier record of the task, until too many have accumulated.
+  auto modified = _modified_tasks.size () + _modified.size ();
+  bool append = !_purged_tasks.size () &&
+                (_added_tasks.size () || _added_lines.size () || modified) &&
+                journal_ok (modified);
+
+  // A file with tasks modified before it was loaded, see TF2::modify_task,
+  // must be loaded to be rewritten.
+  if (! append && ! _loaded_tasks && _modified_tasks.size ())
+    load_tasks ();
+
+  // An index that matches the file before the append can simply be extended,
+  // otherwise it is left stale, to be rebuilt on next load.  When the whole
+  // file is rewritten, so is the index.
+  uint64_t offset = 0;
+  if (append)
+  {
+    _staged_index = index_ok ();
+    offset = _file.size ();
+  }
+  else
+  {
+    _staged_index = _use_index &&
+                    Context::getContext ().config.getBoolean ("data.index");
+    _index.clear ();
+  }
+
+  // Tasks added or modified by TDB2::update were composed there already.
+  Uuid uuid;
+  auto compose = [&] (const Task& task)
+  {
+    if (_composed.size () && Uuid::parse (task.get ("uuid"), uuid))
+      return this->compose (task, uuid);
+
+    return task.composeF4 ();
+  };
+
+  // The static urgency of a task written unchanged is kept in its new entry.
+  auto write = [&] (const std::string& line, const Task& task)
+  {
+    text += line;
+    text += '\n';
+
+    if (_staged_index)
+    {
+      _index.append (line, offset);
+      offset += line.length () + 1;
+
+      if (! task.recalc_static)
+        _index.urgency (_index.entries ().size () - 1, task.urgency_static_value, Task::urgencyKey);
+    }
+  };
+
+  if (append)
+  {
+    // Write out all the added and modified tasks.
+    for (auto& task : _added_tasks)
+      write (compose (task), task);
+
+    for (auto& task : _modified_tasks)
+      write (compose (task), task);
+
+    for (auto position : _modified)
+      write (compose (_tasks[position]), _tasks[position]);
+
+    _superseded += modified;
+    _added_tasks.clear ();
+    _modified_tasks.clear ();
+    _modified.clear ();
+  }
+  else
+  {
+    // Only write out _tasks, because any deltas have already been applied.
+    // Skip over the tasks that are marked to be purged.  A file kept in end
+    // order is written with any task without an end first, then by end.
+    std::vector <size_t> order (_tasks.size ());
+    std::iota (order.begin (), order.end (), 0);
+    if (_end_order)
+    {
+      std::vector <time_t> ends;
+      ends.reserve (_tasks.size ());
+      for (auto& task : _tasks)
+        ends.push_back (task.get_date ("end"));
+
+      std::stable_sort (order.begin (), order.end (),
+                        [&ends] (size_t a, size_t b) { return ends[a] < ends[b]; });
+    }
+
+    for (auto position : order)
+    {
+      auto& task = _tasks[position];
+      if (! Uuid::parse (task.get ("uuid"), uuid))
+        write (task.composeF4 (), task);
+      else if (_purged_tasks.find (uuid) == _purged_tasks.end ())
+        write (this->compose (task, uuid), task);
+    }
+
+    _superseded = 0;
+  }
+
+  // Write out all the added lines.
+  for (auto& line : _added_lines)
+    text += line;
+
+  _added_lines.clear ();
+  _composed.clear ();
+  return ! append;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Called once the staged text is written.
+void TF2::written ()
+{
+  _dirty = false;
+  _index_gc = -1;
+
+  if (_staged_index)
+    _index.save ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Load a single Task object, handle necessary plumbing work
+Task TF2::load_task (const std::string& line)
+{
+  Task task (line);
+  assign_id (task);
+  return task;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Tasks must be numbered in file order, so this is always called serially.
+void TF2::assign_id (Task& task)
+{
+  // Some tasks get an ID.
+  if (_has_ids)
+  {
+    Task::status status = task.getStatus ();
+    // Completed / deleted tasks in pending.data get an ID if GC is off.
+    if (! Context::getContext ().run_gc ||
+        (status != Task::completed && status != Task::deleted))
+      task.id = Context::getContext ().tdb2.next_id ();
+  }
+
+  // Maintain mapping for ease of link/dependency resolution.
+  // Note that this mapping is not restricted by the filter, and is
+  // therefore a complete set.
+  if (task.id)
+  {
+    auto uuid = task.get ("uuid");
+    _U2I[uuid] = task.id;
+    _I2U[task.id] = std::move (uuid);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Check whether task needs to be relocated to pending/completed,
+// or needs to be 'woken'.
+void TF2::load_gc (Task& task)
+{
+  Datetime now;
+
+  std::string status = task.get ("status");
+  if (status == "pending" ||
+      status == "recurring")
+  {
+    Context::getContext ().tdb2.pending._tasks.push_back (task);
+  }
+  else if (status == "waiting")
+  {
+    Datetime wait (task.get_date ("wait"));
+    if (wait < now)
+    {
+      task.set ("status", "pending");
+      task.remove ("wait");
+      // Unwaiting pending tasks is the only case not caught by the size()
+      // checks in TDB2::gc(), so we need to signal it here.
+      Context::getContext ().tdb2.pending._dirty = true;
+
+      if (Context::getContext ().verbose ("unwait"))
+        Context::getContext ().footnote (format ("Un-waiting task {1} '{2}'", task.id, task.get ("description")));
+    }
+
+    Context::getContext ().tdb2.pending._tasks.push_back (task);
+  }
+  else
+  {
+    Context::getContext ().tdb2.completed._tasks.push_back (task);
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 void TF2::load_tasks (bool from_gc /* = false */)
 {
+  Trace::Span span ("parse", _file._data);
   Timer timer;
 
   if (! _loaded_lines)
@@ -399,18 +1186,99 @@ void TF2::load_tasks (bool from_gc /* = false */)
   int line_number = 0;  // Used for error message in catch block.
   try
   {
+    std::vector <Task> parsed;
+    std::vector <char> ok;
+    parse_lines (parsed, ok);
+
+    // Lines not parsed concurrently, including any that failed, are parsed
+    // here, so that errors are reported as before.
+    parsed.resize (_lines.size ());
     for (auto& line : _lines)
     {
       ++line_number;
-      auto task = load_task (line);
+      if (ok.empty () || ! ok[line_number - 1])
+        parsed[line_number - 1] = Task (line);
+    }
+
+    // The static urgency of each task, as kept in the index by an earlier run
+    // with the same coefficients, need not be recomputed.
+    if (_has_ids && _added_lines.empty () && index_ok () &&
+        _index.entries ().size () == parsed.size ())
+    {
+      auto& entries = _index.entries ();
+      for (size_t i = 0; i < parsed.size (); ++i)
+      {
+        if (entries[i].urgency_key == Task::urgencyKey)
+        {
+          parsed[i].urgency_static_value = entries[i].urgency;
+          parsed[i].recalc_static = false;
+        }
+      }
+    }
+
+    supersede (parsed);
+    Context::getContext ().count_parsed += (long) parsed.size ();
+
+    // The maps are sized once, rather than grown task by task.
+    if (_has_ids)
+    {
+      _I2U.reserve (_I2U.size () + parsed.size ());
+      _U2I.reserve (_U2I.size () + parsed.size ());
+    }
+
+    if (! from_gc)
+      _positions.reserve (_positions.size () + parsed.size ());
+
+    // Tasks added before the file was loaded, see TF2::can_append, were
+    // numbered after those in the file, and so follow them.
+    std::vector <Task> early;
+    int resume = 0;
+    if (_numbered >= 0 && ! from_gc)
+    {
+      early.swap (_tasks);
+      _positions.clear ();
+      _children.clear ();
+      _indexed = 0;
+      resume = Context::getContext ().tdb2.next_id ();
+      Context::getContext ().tdb2.next_id (1);
+    }
+
+    for (auto& task : parsed)
+    {
+      assign_id (task);
 
       if (from_gc)
         load_gc (task);
       else
-        _tasks.push_back (task);
+        _tasks.push_back (std::move (task));
+    }
+
+    if (_numbered >= 0 && ! from_gc)
+    {
+      for (auto& task : early)
+        _tasks.push_back (std::move (task));
+
+      Context::getContext ().tdb2.next_id (resume);
+      _numbered = -1;
+    }
+
+    // Tasks modified before the file was loaded supersede their records.
+    if (! from_gc)
+    {
+      index_tasks ();
+
+      size_t position;
+      for (auto& task : _modified_tasks)
+      {
+        if (this->position (task.get ("uuid"), position))
+        {
+          _tasks[position] = task;
+          _modified.insert (position);
+          index_child (task);
+        }
+      }
 
-      if (Context::getContext ().cli2.getCommand () == "import")  // For faster lookup only
-        _tasks_map.insert (std::pair<std::string, Task> (task.get("uuid"), task));
+      _modified_tasks.clear ();
     }
 
     // TDB2::gc() calls this after loading both pending and completed
@@ -418,6 +1286,27 @@ void TF2::load_tasks (bool from_gc /* = false */)
       dependency_scan ();
 
     _loaded_tasks = true;
+
+    // Having read the whole file, (re)build a missing or stale index, provided
+    // the lines exactly reflect the file contents.
+    if (! _read_only && _added_lines.empty () && _loaded_lines &&
+        _use_index && _snapshot < 0 &&
+        Context::getContext ().config.getBoolean ("data.index") &&
+        ! _index.load ())
+    {
+      _index.build (_lines, _bom);
+      _index.save ();
+    }
+
+    Context::getContext ().tdb2.memory ();
+
+    // The raw lines are no longer needed once parsed, and are a second copy of
+    // the whole file.  They are re-read on demand by TF2::get_lines.
+    if (_added_lines.empty ())
+    {
+      std::vector <std::string> ().swap (_lines);
+      _loaded_lines = false;
+    }
   }
 
   catch (const std::string& e)
@@ -429,340 +1318,2642 @@ void TF2::load_tasks (bool from_gc /* = false */)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void TF2::load_lines ()
+// A journaled file may hold several records for a task, of which the last is
+// current.  It takes the place of the first, so that IDs follow the original
+// order, and the others are dropped.
+void TF2::supersede (std::vector <Task>& tasks)
 {
-  if (_file.open ())
+  std::unordered_map <std::string, size_t> first;
+  first.reserve (tasks.size ());
+
+  size_t kept = 0;
+  for (size_t i = 0; i < tasks.size (); ++i)
   {
-    if (Context::getContext ().config.getBoolean ("locking"))
-      _file.lock ();
+    auto uuid = tasks[i].get ("uuid");
+    auto found = uuid == "" ? first.end () : first.find (uuid);
+    if (found != first.end ())
+    {
+      tasks[found->second] = std::move (tasks[i]);
+      continue;
+    }
 
-    _file.read (_lines);
-    _file.close ();
-    _loaded_lines = true;
-  }
-}
+    if (uuid != "")
+      first.emplace (uuid, kept);
 
-////////////////////////////////////////////////////////////////////////////////
-std::string TF2::uuid (int id)
-{
-  if (! _loaded_tasks)
-  {
-    load_tasks ();
+    if (kept != i)
+      tasks[kept] = std::move (tasks[i]);
 
-    // Apply previously added tasks.
-    for (auto& task : _added_tasks)
-      _tasks.push_back (task);
+    ++kept;
   }
 
-  auto i = _I2U.find (id);
-  if (i != _I2U.end ())
-    return i->second;
-
-  return "";
+  _superseded = tasks.size () - kept;
+  tasks.resize (kept);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-int TF2::id (const std::string& uuid)
+// The uuid of an FF4 line, found without parsing the line, or "".
+static std::string line_uuid (const std::string& line)
 {
-  if (! _loaded_tasks)
-  {
-    load_tasks ();
-
-    // Apply previously added tasks.
-    for (auto& task : _added_tasks)
-      _tasks.push_back (task);
-  }
+  auto pos = line.find ("uuid:\"");
+  while (pos != std::string::npos &&
+         pos > 0 && line[pos - 1] != '[' && line[pos - 1] != ' ')
+    pos = line.find ("uuid:\"", pos + 1);
 
-  auto i = _U2I.find (uuid);
-  if (i != _U2I.end ())
-    return i->second;
+  if (pos == std::string::npos || pos + 42 > line.length () || line[pos + 42] != '"')
+    return "";
 
-  return 0;
+  return line.substr (pos + 6, 36);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void TF2::has_ids ()
+// For a read-only command, passes the tasks of the file to the callback a block
+// at a time, as they are parsed, rather than loading them all, so that only the
+// tasks the callback keeps are held.  As when loaded, the last record of a
+// journaled task is passed in place of its first.  The callback returns false
+// to stop early, once it needs no more tasks.  Returns false, having passed
+// nothing, where the tasks are loaded, changed or given IDs, where an index
+// allows a partial read instead, or where a line is not FF4.
+//
+// Under memory.budget, the lines are read through a mapping of the file, and
+// never copied, even where an index would allow a partial read, and the blocks
+// are kept within the budget, so that a large archive is read in bounded
+// memory.
+bool TF2::stream (const std::function <bool (const std::vector <Task>&)>& callback)
 {
-  _has_ids = true;
-}
+  size_t budget = (size_t) std::max (0, Context::getContext ().config.getInteger ("memory.budget")) << 20;
+  if (_loaded_tasks || _has_ids || _dirty || (! budget && index_ok ()) ||
+      ! _tasks.empty () || ! _modified_tasks.empty ())
+    return false;
 
-////////////////////////////////////////////////////////////////////////////////
-void TF2::auto_dep_scan ()
-{
-  _auto_dep_scan = true;
-}
+  Trace::Span span ("parse", _file._data);
+  Timer timer;
 
-////////////////////////////////////////////////////////////////////////////////
-// Completely wipe it all clean.
-void TF2::clear ()
-{
-  _read_only       = false;
-  _dirty           = false;
-  _loaded_tasks    = false;
-  _loaded_lines    = false;
+  // The lines are held here, not in _lines, as a DOM reference made by the
+  // callback may load the file meanwhile.  Each is seen through a view, of
+  // either the lines loaded or the mapped file.
+  std::vector <std::string> lines;
+  std::vector <std::pair <const char*, size_t>> views;
+  struct Mapping
+  {
+    TF2& file;
+    void* map {MAP_FAILED};
+    size_t size {0};
+    ~Mapping ()
+    {
+      if (map != MAP_FAILED)
+      {
+        munmap (map, size);
+        file._held = false;
+        file._file.close ();
+      }
+    }
+  } mapping {*this};
 
-  // Note that these are deliberately not cleared.
-  //_file._data      = "";
-  //_has_ids         = false;
-  //_auto_dep_scan   = false;
+  if (budget && ! _loaded_lines)
+    mapping.map = map_file (mapping.size);
+
+  if (mapping.map != MAP_FAILED)
+  {
+    const char* end  = (const char*) mapping.map + mapping.size;
+    const char* line = skip_bom ((const char*) mapping.map, end);
+    while (line < end)
+    {
+      auto eol = (const char*) memchr (line, '\n', end - line);
+      if (! eol)
+        eol = end;
+
+      auto last = eol;
+      if (last > line && *(last - 1) == '\r')
+        --last;
+
+      // As for map_lines, a partial task record at the end is not read.
+      if (eol == end && *line == '[' && *(last - 1) != ']')
+        break;
+
+      views.emplace_back (line, last - line);
+      line = eol + 1;
+    }
+  }
+  else
+  {
+    if (! _loaded_lines)
+      load_lines ();
+
+    lines.swap (_lines);
+    _loaded_lines = false;
+    views.reserve (lines.size ());
+    for (auto& line : lines)
+      views.emplace_back (line.data (), line.size ());
+  }
+
+  // The position of the last record of each task, by its value where the uuid
+  // is canonical.  Once passed, a task is marked as done.
+  static const size_t done = (size_t) -1;
+  std::unordered_map <Uuid, size_t> last;
+  std::unordered_map <std::string, size_t> last_other;
+  last.reserve (views.size ());
+  auto find = [&] (const std::pair <const char*, size_t>& view) -> size_t*
+  {
+    auto text = line_uuid (std::string (view.first, view.second));
+    Uuid key;
+    if (Uuid::parse (text, key))
+      return &last[key];
+    if (text != "")
+      return &last_other[text];
+    return nullptr;
+  };
+
+  for (size_t i = 0; i < views.size (); ++i)
+  {
+    if (views[i].second == 0 || views[i].first[0] != '[')
+    {
+      if (mapping.map == MAP_FAILED)
+      {
+        lines.swap (_lines);
+        _loaded_lines = true;
+      }
+
+      Context::getContext ().time_load_us += timer.total_us ();
+      return false;
+    }
+
+    auto position = find (views[i]);
+    if (position)
+      *position = i;
+  }
+
+  // The time of the callback is not that of loading.
+  long callback_us = 0;
+  auto pass = [&] (const std::vector <Task>& block)
+  {
+    Context::getContext ().count_parsed += (long) block.size ();
+
+    Timer timer_callback;
+    auto more = callback (block);
+    callback_us += timer_callback.total_us ();
+    return more;
+  };
+
+  // A parsed task takes several times the bytes of its line, so a block under
+  // a budget is kept to an eighth of it, in line bytes.
+  std::vector <Task> block;
+  block.reserve (std::min (views.size (), (size_t) STREAM_BLOCK));
+  size_t block_bytes = 0;
+
+  for (size_t i = 0; i < views.size (); ++i)
+  {
+    auto position = find (views[i]);
+    auto line_number = position ? *position : i;
+    try
+    {
+      if (! position)
+        block.push_back (Task (std::string (views[i].first, views[i].second)));
+      else if (*position != done)
+      {
+        auto& line = views[*position];
+        block.push_back (Task (std::string (line.first, line.second)));
+        block_bytes += line.second;
+        *position = done;
+      }
+    }
+
+    catch (const std::string& e)
+    {
+      throw e + format (" in {1} at line {2}", _file._data, (int) line_number + 1);
+    }
+
+    if (block.size () >= STREAM_BLOCK ||
+        (budget && block_bytes * 8 >= budget))
+    {
+      auto more = pass (block);
+      block.clear ();
+      block_bytes = 0;
+      if (! more)
+        break;
+    }
+  }
+
+  if (block.size ())
+    pass (block);
+
+  Context::getContext ().time_load_us += timer.total_us () - callback_us;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Whether the file may hold a pending, waiting or recurring task.  Without a
+// current index, or once loaded, that is not known.
+bool TF2::holds_pending ()
+{
+  if (_loaded_tasks || ! index_ok ())
+    return true;
+
+  for (auto& entry : _index.entries ())
+    if (entry.status != 'c' && entry.status != 'd')
+      return true;
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Gathers the columns of every task in the file.  A file that holds only
+// completed and deleted tasks, and is not loaded, is read from its index where
+// that is current, without parsing any task, as the other fields are not used
+// for those tasks.
+void TF2::columns (TaskColumns& columns)
+{
+  if (_dirty || ! _tasks.empty () || holds_pending ())
+  {
+    for (auto& task : get_tasks ())
+      columns.add (task);
+
+    return;
+  }
+
+  // A journaled file may hold earlier records of a task, which are skipped.
+  auto& entries = _index.entries ();
+  std::unordered_map <std::string, uint64_t> current;
+  current.reserve (entries.size ());
+  for (auto& entry : entries)
+    current[std::string (entry.uuid, 36)] = entry.offset;
+
+  for (auto& entry : entries)
+    if (current[std::string (entry.uuid, 36)] == entry.offset)
+      columns.add (entry.status == 'c' ? Task::completed : Task::deleted,
+                   (time_t) entry.entry,
+                   0,
+                   (time_t) entry.end);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Computes the static urgency of every task that the index does not yet hold,
+// and keeps it there for later runs.  Only a file that is loaded, unchanged and
+// fully described by its index, with one entry per task, is updated.
+void TF2::keep_urgency ()
+{
+  if (_read_only || _dirty || ! _loaded_tasks || ! _added_lines.empty () ||
+      ! _modified.empty () || ! index_ok ())
+    return;
+
+  auto& entries = _index.entries ();
+  if (entries.size () != _tasks.size ())
+    return;
+
+  bool changed = false;
+  for (size_t i = 0; i < _tasks.size (); ++i)
+  {
+    auto& task = _tasks[i];
+    if (entries[i].urgency_key == Task::urgencyKey ||
+        task.get_ref ("uuid").compare (0, 36, entries[i].uuid, 36) != 0)
+      continue;
+
+    if (task.recalc_static)
+    {
+      task.urgency_static_value = task.urgency_static ();
+      task.recalc_static = false;
+    }
+
+    _index.urgency (i, task.urgency_static_value, Task::urgencyKey);
+    changed = true;
+  }
+
+  if (changed)
+    _index.refresh ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Whether a further number of superseding records may be appended to the file,
+// within the data.journal limit.  A file over the limit is rewritten.
+bool TF2::journal_ok (size_t records)
+{
+  auto limit = Context::getContext ().config.getInteger ("data.journal");
+  return _superseded + records <= (size_t) std::max (limit, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// With data.threads, a large file has its FF4 lines parsed concurrently, in
+// contiguous chunks, into tasks.  Only FF4 lines are parsed here, as the JSON
+// parser is not thread-safe.  The ok flags show which lines were parsed, and
+// both vectors are left empty if the file is parsed serially.
+void TF2::parse_lines (std::vector <Task>& tasks, std::vector <char>& ok)
+{
+  size_t threads = Context::getContext ().config.getInteger ("data.threads");
+  if (threads == 0)
+    threads = Pool::threads ();
+
+  threads = std::min (threads, _lines.size () / LOAD_CHUNK_MINIMUM);
+  if (threads <= 1)
+    return;
+
+  tasks.resize (_lines.size ());
+  ok.assign (_lines.size (), 0);
+
+  auto chunk = (_lines.size () + threads - 1) / threads;
+  Pool::run (threads, [&] (size_t t)
+  {
+    auto end = std::min (_lines.size (), (t + 1) * chunk);
+    for (auto i = t * chunk; i < end; ++i)
+    {
+      if (_lines[i][0] == '[')
+      {
+        try
+        {
+          tasks[i] = Task (_lines[i]);
+          ok[i] = 1;
+        }
+
+        catch (...)
+        {
+          // Left to the serial pass, which reports the error.
+        }
+      }
+    }
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TF2::load_lines ()
+{
+  Trace::Span span ("load", _file._data);
+  if (_held || _file.open ())
+  {
+    // A snapshot is read without a lock, and a file held by TF2::commit or
+    // TF2::stream is already locked.
+    if (_snapshot < 0 && ! _held)
+      lock (true);
+
+    if (! map_lines ())
+      _file.read (_lines);
+
+    if (! _held)
+      _file.close ();
+    _loaded_lines = true;
+    Context::getContext ().tdb2.memory ();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Counts the lines that start with the prefix, such as the '---' separators in
+// undo.data, by scanning the mapped file rather than loading its lines.
+int TF2::count_lines (const std::string& prefix)
+{
+  if (! _loaded_lines && _file.open ())
+  {
+    lock (true);
+
+    int fd = fileno (_file._fh);
+    struct stat st;
+    if (fd != -1 && fstat (fd, &st) != -1)
+    {
+      if (st.st_size == 0)
+      {
+        _file.close ();
+        return 0;
+      }
+
+      size_t size = (size_t) st.st_size;
+      void* map = mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map != MAP_FAILED)
+      {
+        int count = 0;
+        const char* end  = (const char*) map + size;
+        const char* line = skip_bom ((const char*) map, end);
+        while (line < end)
+        {
+          if ((size_t) (end - line) >= prefix.length () &&
+              memcmp (line, prefix.data (), prefix.length ()) == 0)
+            ++count;
+
+          auto eol = (const char*) memchr (line, '\n', end - line);
+          if (! eol)
+            break;
+
+          line = eol + 1;
+        }
+
+        munmap (map, size);
+        _file.close ();
+        return count;
+      }
+    }
+
+    _file.close ();
+  }
+
+  int count = 0;
+  for (auto& line : get_lines ())
+    if (line.compare (0, prefix.length (), prefix) == 0)
+      ++count;
+
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reads only the last transaction of a file of transactions separated by '---'
+// lines, such as undo.data, by reading backwards from the end of the file,
+// along with the transactions before it in the same group, as named on their
+// 'time' lines.  The offset is set to the start of the first transaction read,
+// where the file may be truncated to remove them.
+void TF2::get_transaction (std::vector <std::string>& lines, uint64_t& offset)
+{
+  lines.clear ();
+  offset = 0;
+
+  if (! _file.open ())
+    return;
+
+  lock (true);
+
+  // Blocks are read, and prepended to the tail, as needed.
+  std::string tail;
+  long start = _file.size ();
+  long block = 4096;
+  auto more = [&] ()
+  {
+    if (start == 0)
+      return false;
+
+    long length = std::min (block, start);
+    start -= length;
+    block *= 2;
+
+    std::string chunk (length, '\0');
+    if (fseek (_file._fh, start, SEEK_SET) != 0 ||
+        fread (&chunk[0], 1, length, _file._fh) != (size_t) length)
+    {
+      _file.close ();
+      throw format ("Could not read '{1}'.", _file._data);
+    }
+
+    tail = chunk + tail;
+    return true;
+  };
+
+  // Each transaction follows the separator that precedes its own, or starts
+  // the file.  The length kept is counted from the end of the tail, which
+  // grows at the front.
+  size_t kept = 0;
+  std::string group;
+  while (true)
+  {
+    size_t found = std::string::npos;
+    while (true)
+    {
+      auto end = tail.length () - kept;
+      if (end > 5 &&
+          (found = tail.rfind ("\n---\n", end - 6)) != std::string::npos)
+        break;
+
+      if (! more ())
+        break;
+    }
+
+    // The group is whatever follows the time on the first line, if anything.
+    size_t first = found == std::string::npos ? 0 : found + 5;
+    auto eol = tail.find ('\n', first);
+    auto time = tail.substr (first, eol == std::string::npos ? std::string::npos : eol - first);
+    auto space = time.compare (0, 5, "time ", 5) ? std::string::npos : time.find (' ', 5);
+    auto name = space == std::string::npos ? "" : time.substr (space + 1);
+
+    if (kept > 0 && (name == "" || name != group))
+      break;
+
+    group = name;
+    kept = tail.length () - first;
+    if (found == std::string::npos || group == "")
+      break;
+  }
+
+  _file.close ();
+
+  size_t begin = tail.length () - kept;
+  offset = start + begin;
+  while (begin < tail.length ())
+  {
+    auto eol = tail.find ('\n', begin);
+    if (eol == std::string::npos)
+      eol = tail.length ();
+
+    lines.push_back (tail.substr (begin, eol - begin));
+    begin = eol + 1;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Limits a file of transactions to the given size, once it is exceeded, by
+// keeping only the newest transactions that fit in half of it.  The file is
+// rewritten in place, under the same lock as any other write.
+void TF2::compact (uint64_t maximum)
+{
+  if (maximum == 0 || _file.size () <= maximum || ! _file.open ())
+    return;
+
+  lock (false);
+
+  uint64_t size = _file.size ();
+  uint64_t keep = maximum / 2;
+  std::string tail (keep, '\0');
+  if (fseek (_file._fh, (long) (size - keep), SEEK_SET) != 0 ||
+      fread (&tail[0], 1, keep, _file._fh) != keep)
+  {
+    _file.close ();
+    throw format ("Could not read '{1}'.", _file._data);
+  }
+
+  // Only whole transactions are kept.
+  auto found = tail.find ("\n---\n");
+  tail = found == std::string::npos ? "" : tail.substr (found + 5);
+
+  _file.truncate ();
+  _file.append (std::string(""));  // Seek to end of file
+  _file.write_raw (tail);
+  _file.close ();
+
+  Context::getContext ().debug (format ("TF2::compact {1} reduced from {2} to {3} bytes", _file._data, size, tail.length ()));
 
-  _tasks.clear ();
-  _added_tasks.clear ();
-  _modified_tasks.clear ();
-  _purged_tasks.clear ();
   _lines.clear ();
-  _added_lines.clear ();
-  _I2U.clear ();
-  _U2I.clear ();
+  _loaded_lines = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reads the open file by mapping it into memory and splitting it in place,
+// which avoids the buffered copy that File::read makes of every line.  Returns
+// false if the file cannot be mapped, so that the caller can fall back.
+bool TF2::map_lines ()
+{
+  int fd = fileno (_file._fh);
+  struct stat st;
+  if (fd == -1 || fstat (fd, &st) == -1)
+    return false;
+
+  // A snapshot ends where the file did, whatever has been appended since.
+  size_t size = (size_t) st.st_size;
+  if (_snapshot >= 0 && (size_t) _snapshot < size)
+    size = (size_t) _snapshot;
+
+  _lines.clear ();
+  _bom = 0;
+  if (size == 0)
+    return true;
+
+  void* map = mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED)
+    return false;
+
+#ifdef MADV_SEQUENTIAL
+  madvise (map, size, MADV_SEQUENTIAL);
+#endif
+
+  const char* end   = (const char*) map + size;
+  const char* start = skip_bom ((const char*) map, end);
+  _bom = start - (const char*) map;
+
+  // Count lines first, so that _lines is allocated once.
+  size_t count = 0;
+  for (auto p = start; (p = (const char*) memchr (p, '\n', end - p)) != nullptr; ++p)
+    ++count;
+
+  _lines.reserve (count + 1);
+
+  const char* line = start;
+  while (line < end)
+  {
+    auto eol = (const char*) memchr (line, '\n', end - line);
+    if (! eol)
+      eol = end;
+
+    // Tolerate DOS line endings, as File::read does.
+    auto last = eol;
+    if (last > line && *(last - 1) == '\r')
+      --last;
+
+    // A task record at the end, not yet ended, is still being appended, or
+    // was cut short, and is not read.
+    if (eol == end && *line == '[' && *(last - 1) != ']')
+      break;
+
+    _lines.emplace_back (line, last - line);
+    line = eol + 1;
+  }
+
+  munmap (map, size);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Maps the file for reading, up to the end of any snapshot, or returns
+// MAP_FAILED.  A file may be cut short in place, by TF2::append or TF2::replace,
+// under an exclusive lock, and reading a mapping past its end raises SIGBUS, so
+// the file is left open, held under the shared lock, until the caller unmaps it
+// and closes the file.
+void* TF2::map_file (size_t& size)
+{
+  if (! _file.open ())
+    return MAP_FAILED;
+
+  if (_snapshot < 0)
+    lock (true);
+
+  void* map = MAP_FAILED;
+  int fd = fileno (_file._fh);
+  struct stat st;
+  if (fd != -1 && fstat (fd, &st) != -1 && st.st_size > 0)
+  {
+    size = (size_t) st.st_size;
+    if (_snapshot >= 0 && (size_t) _snapshot < size)
+      size = (size_t) _snapshot;
+
+    if (size)
+    {
+      map = mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+#ifdef MADV_SEQUENTIAL
+      if (map != MAP_FAILED)
+        madvise (map, size, MADV_SEQUENTIAL);
+#endif
+    }
+  }
+
+  if (map == MAP_FAILED)
+    _file.close ();
+  else
+    _held = true;
+
+  return map;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::string TF2::uuid (int id)
+{
+  if (index_numbers ())
+  {
+    if (id < 1 || id > (int) _index_ids.size ())
+      return "";
+
+    return std::string (_index.entries ()[_index_ids[id - 1]].uuid, 36);
+  }
+
+  if (! _loaded_tasks)
+  {
+    load_tasks ();
+
+    // Apply previously added tasks.
+    for (auto& task : _added_tasks)
+      _tasks.push_back (task);
+  }
+
+  auto i = _I2U.find (id);
+  if (i != _I2U.end ())
+    return i->second;
+
+  return "";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int TF2::id (const std::string& uuid)
+{
+  // The index holds only canonical UUIDs, see TF2::index_numbers.
+  if (index_numbers ())
+  {
+    Uuid key;
+    if (! Uuid::parse (uuid, key))
+      return 0;
+
+    auto found = _index_uuids.find (key);
+    return found != _index_uuids.end () ? found->second : 0;
+  }
+
+  if (! _loaded_tasks)
+  {
+    load_tasks ();
+
+    // Apply previously added tasks.
+    for (auto& task : _added_tasks)
+      _tasks.push_back (task);
+  }
+
+  auto i = _U2I.find (uuid);
+  if (i != _U2I.end ())
+    return i->second;
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Numbers the tasks of an unloaded file from its index, as loading it would, so
+// that IDs and UUIDs are mapped without parsing the file.  A journaled task
+// keeps the position of its first record, and the status of its last, as
+// TF2::supersede does.  False if the file must be loaded instead.
+bool TF2::index_numbers ()
+{
+  if (_loaded_tasks || ! _has_ids || ! _added_tasks.empty () ||
+      ! _modified_tasks.empty () || ! _added_lines.empty () || ! index_ok ())
+    return false;
+
+  int gc = Context::getContext ().run_gc ? 1 : 0;
+  if (_index_gc == gc)
+    return true;
+
+  auto& entries = _index.entries ();
+  std::vector <size_t> latest;
+  std::vector <Uuid> keys;
+  std::unordered_map <Uuid, size_t> first;
+  latest.reserve (entries.size ());
+  keys.reserve (entries.size ());
+  first.reserve (entries.size ());
+  for (size_t i = 0; i < entries.size (); ++i)
+  {
+    // Text that is not a canonical UUID is left to the parser.
+    Uuid key;
+    if (! Uuid::parse (entries[i].uuid, 36, key))
+      return false;
+
+    auto found = first.emplace (key, latest.size ());
+    if (found.second)
+    {
+      latest.push_back (i);
+      keys.push_back (key);
+    }
+    else
+      latest[found.first->second] = i;
+  }
+
+  _index_ids.clear ();
+  _index_uuids.clear ();
+  _index_uuids.reserve (latest.size ());
+  for (size_t i = 0; i < latest.size (); ++i)
+  {
+    // As TF2::assign_id numbers them.
+    auto status = entries[latest[i]].status;
+    if (! gc || (status != 'c' && status != 'd'))
+    {
+      _index_ids.push_back (latest[i]);
+      _index_uuids[keys[i]] = (int) _index_ids.size ();
+    }
+  }
+
+  _index_gc = gc;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TF2::has_ids ()
+{
+  _has_ids = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TF2::auto_dep_scan ()
+{
+  _auto_dep_scan = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TF2::use_index ()
+{
+  _use_index = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TF2::end_order ()
+{
+  _end_order = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The index is only consulted if it is enabled, and describes the current file.
+bool TF2::index_ok ()
+{
+  // The index describes the file as it is, not as it was for a snapshot.
+  return _use_index &&
+         _snapshot < 0 &&
+         Context::getContext ().config.getBoolean ("data.index") &&
+         _index.load ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The bytes held by the tasks of the file, as an estimate.
+long TF2::task_bytes () const
+{
+  long bytes = (long) ((_tasks.capacity () + _added_tasks.capacity () +
+                        _modified_tasks.capacity () + _partial.capacity ()) * sizeof (Task));
+  for (auto tasks : {&_tasks, &_added_tasks, &_modified_tasks, &_partial})
+    for (auto& task : *tasks)
+      bytes += (long) task.data.bytes ();
+
+  return bytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The bytes held by the lines of the file, as an estimate.
+long TF2::line_bytes () const
+{
+  return (long) (Allocations::held (_lines) + Allocations::held (_added_lines));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Compares the index with the lines of the file, as read from disk, and
+// describes it.  Returns false if the index is loaded but does not describe
+// the lines.  With repair, an index that is missing, stale or wrong is rebuilt.
+bool TF2::check_index (bool repair, std::string& status)
+{
+  if (! _use_index ||
+      ! Context::getContext ().config.getBoolean ("data.index"))
+  {
+    status = "not used";
+    return true;
+  }
+
+  // The lines must be those on disk, not those of pending changes.
+  auto& lines = get_lines ();
+  if (_dirty || ! _added_lines.empty ())
+  {
+    status = "not checked, the file is changed";
+    return true;
+  }
+
+  bool ok = true;
+  bool current = false;
+  if (! _index.load ())
+  {
+    status = "missing or stale";
+  }
+  else
+  {
+    auto& entries = _index.entries ();
+    size_t line = 0;
+    uint64_t offset = _bom;
+    for (; line < lines.size () && line < entries.size (); ++line)
+    {
+      auto expected = TF2Index::parse (lines[line], offset);
+      auto& entry = entries[line];
+      if (entry.offset   != expected.offset   ||
+          entry.length   != expected.length   ||
+          entry.status   != expected.status   ||
+          entry.entry    != expected.entry    ||
+          entry.end      != expected.end      ||
+          entry.modified != expected.modified ||
+          memcmp (entry.uuid, expected.uuid, sizeof (entry.uuid)) != 0)
+        break;
+
+      offset += lines[line].length () + 1;
+    }
+
+    if (line < lines.size () || line < entries.size ())
+    {
+      status = format ("inconsistent at line {1}", line + 1);
+      ok = false;
+    }
+    else
+    {
+      status = format ("{1} entries", entries.size ());
+      current = true;
+    }
+  }
+
+  if (repair && ! current)
+  {
+    _index.build (lines, _bom);
+    status += _index.save () ? ", rebuilt" : ", could not be rebuilt";
+  }
+
+  return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Completely wipe it all clean.
+void TF2::clear ()
+{
+  _read_only       = false;
+  _dirty           = false;
+  _loaded_tasks    = false;
+  _loaded_lines    = false;
+
+  // Note that these are deliberately not cleared.
+  //_file._data      = "";
+  //_has_ids         = false;
+  //_auto_dep_scan   = false;
+
+  _tasks.clear ();
+  _added_tasks.clear ();
+  _modified_tasks.clear ();
+  _modified.clear ();
+  _composed.clear ();
+  _purged_tasks.clear ();
+  _lines.clear ();
+  _added_lines.clear ();
+  _I2U.clear ();
+  _U2I.clear ();
+  _index.clear ();
+  _partial.clear ();
+  _superseded = 0;
+  _snapshot = -1;
+  _positions.clear ();
+  _children.clear ();
+  _indexed = 0;
+  _unparsed = false;
+  _numbered = -1;
+  _index_gc = -1;
+  _index_ids.clear ();
+  _index_uuids.clear ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// For any task that has depenencies, follow the chain of dependencies until the
+// end.  Along the way, update the Task::is_blocked and Task::is_blocking data
+// cache.
+void TF2::dependency_scan ()
+{
+  Trace::Span span ("dependency scan", _file._data);
+
+  // GC hasn't run yet, check both tasks for their current status.  A file with
+  // no open task that depends on another, such as completed.data usually, is
+  // not indexed at all.
+  std::vector <Task*> lefts;
+  for (auto& left : _tasks)
+  {
+    if (left.has ("depends"))
+    {
+      Task::status lstatus = left.getStatus ();
+      if (lstatus != Task::completed &&
+          lstatus != Task::deleted)
+        lefts.push_back (&left);
+    }
+  }
+
+  if (lefts.empty ())
+    return;
+
+  // Index the tasks by uuid once, so that each dependency is a single lookup.
+  // The first task with a given uuid wins, as it did for a linear search.
+  std::unordered_map <std::string, Task*> by_uuid;
+  by_uuid.reserve (_tasks.size ());
+  for (auto& task : _tasks)
+    by_uuid.emplace (task.get ("uuid"), &task);
+
+  // Iterate and modify TDB2 in-place.  Don't do this at home.  The key is
+  // reused, so that the lookups allocate nothing.
+  std::string dep;
+  for (auto left : lefts)
+  {
+    scanFields (left->get_ref ("depends"), ',', [&] (const char* field, size_t length)
+    {
+      dep.assign (field, length);
+      auto found = by_uuid.find (dep);
+      if (found != by_uuid.end ())
+      {
+        Task& right = *found->second;
+        Task::status rstatus = right.getStatus ();
+        if (rstatus != Task::completed &&
+            rstatus != Task::deleted)
+        {
+          left->is_blocked = true;
+          right.is_blocking = true;
+        }
+      }
+
+      return true;
+    });
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const std::string TF2::dump ()
+{
+  Color red    ("rgb500 on rgb100");
+  Color yellow ("rgb550 on rgb220");
+  Color green  ("rgb050 on rgb010");
+
+  // File label.
+  std::string label;
+  auto slash = _file._data.rfind ('/');
+  if (slash != std::string::npos)
+    label = rightJustify (_file._data.substr (slash + 1), 14);
+
+  // File mode.
+  std::string mode = std::string (_file.exists () && _file.readable () ? "r" : "-") +
+                     std::string (_file.exists () && _file.writable () ? "w" : "-");
+       if (mode == "r-") mode = red.colorize (mode);
+  else if (mode == "rw") mode = green.colorize (mode);
+  else                   mode = yellow.colorize (mode);
+
+  // Hygiene.
+  std::string hygiene = _dirty ? red.colorize ("O") : green.colorize ("-");
+
+  std::string tasks          = green.colorize  (rightJustifyZero ((int) _tasks.size (),          4));
+  std::string tasks_added    = red.colorize    (rightJustifyZero ((int) _added_tasks.size (),    3));
+  std::string tasks_modified = yellow.colorize (rightJustifyZero ((int) (_modified_tasks.size () + _modified.size ()), 3));
+  std::string tasks_purged   = red.colorize    (rightJustifyZero ((int) _purged_tasks.size (),   3));
+  std::string lines          = green.colorize  (rightJustifyZero ((int) _lines.size (),          4));
+  std::string lines_added    = red.colorize    (rightJustifyZero ((int) _added_lines.size (),    3));
+
+  char buffer[256];  // Composed string is actually 246 bytes.  Yikes.
+  snprintf (buffer, 256, "%14s %s %s T%s+%s~%s-%s L%s+%s",
+            label.c_str (),
+            mode.c_str (),
+            hygiene.c_str (),
+            tasks.c_str (),
+            tasks_added.c_str (),
+            tasks_modified.c_str (),
+            tasks_purged.c_str (),
+            lines.c_str (),
+            lines_added.c_str ());
+
+  return std::string (buffer);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TDB2::TDB2 ()
+: _location ("")
+, _id (1)
+, _events_ok (false)
+, _gc_deferred (false)
+, _generation (0)
+, _rollup_stale (false)
+, _graph_built (false)
+, _ready_built (false)
+, _federated_loaded (false)
+{
+  // Mark the pending file as the only one that has ID numbers.
+  pending.has_ids ();
+
+  // Indicate that dependencies should be automatically scanned on startup,
+  // setting Task::is_blocked and Task::is_blocking accordingly.
+  pending.auto_dep_scan ();
+
+  // Both task files maintain a sidecar index.
+  pending.use_index ();
+  completed.use_index ();
+
+  // Completed tasks are rewritten in order of end, for date range reports.
+  completed.end_order ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Once a location is known, the files can be set up.  Note that they are not
+// read.
+void TDB2::set_location (const std::string& location)
+{
+  _location = location;
+
+  pending.target   (location + "/pending.data");
+  completed.target (location + "/completed.data");
+  undo.target      (location + "/undo.data");
+  backlog.target   (location + "/backlog.data");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Asks the kernel to start reading the files every command loads, while the
+// command line is parsed and the hooks are found.  The completed and undo
+// data are left alone, as most commands read neither, or only the index.
+void TDB2::prefetch ()
+{
+#ifdef POSIX_FADV_WILLNEED
+  for (auto& file : {pending._file._data,
+                     pending._file._data + ".idx",
+                     completed._file._data + ".idx"})
+  {
+    int fd = open (file.c_str (), O_RDONLY | O_CLOEXEC);
+    if (fd != -1)
+    {
+      posix_fadvise (fd, 0, 0, POSIX_FADV_WILLNEED);
+      close (fd);
+    }
+  }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Add the new task to the appropriate file.
+void TDB2::add (Task& task, bool add_to_backlog /* = true */)
+{
+  verifyNew (task, add_to_backlog);
+
+  // Only locally-added tasks trigger hooks.  This means that tasks introduced
+  // via 'sync' do not trigger hooks.
+  if (add_to_backlog)
+    Context::getContext ().hooks.onAdd (task);
+
+  update (task, add_to_backlog, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Add the new tasks together, so that on-add-batch scripts see them all at
+// once.  Nothing is added unless every task is valid.
+void TDB2::add (std::vector <Task>& tasks)
+{
+  if (tasks.size () == 0)
+    return;
+
+  for (auto& task : tasks)
+    verifyNew (task, true);
+
+  Context::getContext ().hooks.onAddBatch (tasks);
+
+  for (auto& task : tasks)
+    update (task, true, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TDB2::modify (Task& task, bool add_to_backlog /* = true */)
+{
+  // Ensure the task is consistent.
+  task.validate (false);
+  std::string uuid = task.get ("uuid");
+
+  // Get the unmodified task as reference, so the hook can compare.
+  if (add_to_backlog)
+  {
+    Task original;
+    get (uuid, original);
+    Context::getContext ().hooks.onModify (original, task);
+
+    // Held until commit, so that on-modify-batch scripts see all the
+    // modifications at once.
+    if (Context::getContext ().hooks.batched ())
+    {
+      auto held = _batch.find (uuid);
+      if (held != _batch.end ())
+        _batch_after[held->second] = task;
+      else
+      {
+        _batch[uuid] = _batch_before.size ();
+        _batch_before.push_back (original);
+        _batch_after.push_back (task);
+      }
+
+      return;
+    }
+  }
+
+  update (task, add_to_backlog);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Passes the held modifications through the on-modify-batch scripts, then
+// applies them.
+void TDB2::apply_batch ()
+{
+  if (_batch_before.size () == 0)
+    return;
+
+  std::vector <Task> before;
+  std::vector <Task> after;
+  before.swap (_batch_before);
+  after.swap (_batch_after);
+  _batch.clear ();
+
+  Context::getContext ().hooks.onModifyBatch (before, after);
+
+  for (auto& task : after)
+    update (task, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TDB2::purge (Task& task)
+{
+  // Delete the task from completed.data
+  completed.purge_task (task);
+  rollup_count (_rollup_deltas, task, -1);
+  project_count (_project_deltas, task, -1);
+  tag_count (_tag_deltas, task, -1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// A record of a modification, as kept with undo.delta: the attributes of one
+// side that differ from the other, and those only the other has, with no
+// value.  With both sides, 'was' and 'set', only the changes are kept.
+static std::string undo_delta (const Task& from, const Task& to, bool identified = false)
+{
+  Task changed;
+  if (identified)
+    changed.data["uuid"] = from.get ("uuid");
+
+  std::string added;
+  for (auto& att : from.data)
+    if (to.get (att.first) != att.second)
+      changed.data[att.first] = att.second;
+
+  for (auto& att : to.data)
+    if (! from.has (att.first))
+      added += ' ' + att.first + ":\"\"";
+
+  // composeF4 leaves out empty values, so they are added here.
+  auto delta = changed.composeF4 ();
+  if (delta == "[]")
+    return '[' + added.substr (1) + ']';
+
+  return delta.insert (delta.length () - 1, added);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The first line of a transaction in undo.data.  Every transaction of one
+// command carries the same group after the time, so that they are undone
+// together.  Older versions wrote the time alone.
+std::string TDB2::undo_time ()
+{
+  if (_undo_group == "")
+    _undo_group = ::uuid ().substr (0, 8);
+
+  return "time " + Datetime ().toEpochString () + ' ' + _undo_group + '\n';
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TDB2::update (
+  Task& task,
+  const bool add_to_backlog,
+  const bool addition /* = false */)
+{
+  // Validate to add metadata, unless add or modify already did, and no hook
+  // has since replaced the task.  Only the structure is then checked.
+  if (! task.validated)
+    task.validate (false);
+  else if (task.get ("uuid") == "" || task.get ("description") == "")
+    throw std::string ("A task must have a uuid and a description.");
+
+  // If the task already exists, it is a modification, else addition.  A loaded
+  // task is used in place, rather than copied.
+  const Task* original = nullptr;
+  Task copy;
+  if (not addition)
+  {
+    auto uuid = task.get ("uuid");
+    original = pending.find (uuid);
+    if (! original)
+      original = completed.find (uuid);
+    if (! original && get (uuid, copy))
+      original = &copy;
+  }
+
+  if (original)
+  {
+    // Update only if the tasks differ
+    if (task == *original)
+      return;
+
+    if (add_to_backlog)
+    {
+      // All locally modified tasks are timestamped, implicitly overwriting any
+      // changes the user or hooks tried to apply to the "modified" attribute.
+      task.setAsNow ("modified");
+    }
+
+    // The original is replaced by the modification, so is used up first.
+    bool reparented = task.get ("parent") != original->get ("parent");
+    auto depends = original->get ("depends");
+    bool relinked = task.get ("depends") != depends ||
+                    task.getStatus () != original->getStatus ();
+    rollup_count (_rollup_deltas, *original, -1);
+    project_count (_project_deltas, *original, -1);
+    tag_count (_tag_deltas, *original, -1);
+
+    // With undo.delta, only the attributes that change are kept, before and
+    // after.
+    bool delta = Context::getContext ().config.getBoolean ("undo.delta");
+    auto old = delta ? undo_delta (*original, task) : original->composeF4 ();
+    auto changes = delta ? undo_delta (task, *original, true) : "";
+
+    // The task is composed once, for both the undo log and the data file.
+    auto after = task.composeF4 ();
+
+    // Update the task, wherever it is.
+    if (pending.modify_task (task, after))
+    {
+      update_graph (task);
+      if (relinked)
+        update_blocking (task, depends);
+      update_ready (task);
+      if (reparented)
+        pending.index_child (task);
+    }
+    else
+      completed.modify_task (task, after);
+
+    rollup_count (_rollup_deltas, task, 1);
+    project_count (_project_deltas, task, 1);
+    tag_count (_tag_deltas, task, 1);
+
+    // time <time> <group>
+    // old <task>  or  was <delta>
+    // new <task>  or  set <delta>
+    // ---
+    undo.add_line (undo_time ());
+    undo.add_line ((delta ? "was " : "old ") + old + '\n');
+    undo.add_line (delta ? "set " + changes + '\n' : "new " + after + '\n');
+    undo.add_line ("---\n");
+  }
+  else
+  {
+    // Add new task to either pending or completed.
+    auto after = task.composeF4 ();
+    std::string status = task.get ("status");
+    if (status == "completed" ||
+        status == "deleted")
+      completed.add_task (task, after);
+    else
+    {
+      pending.add_task (task, after);
+      update_graph (task);
+      if (task.has ("depends"))
+        update_blocking (task, "");
+      update_ready (task);
+    }
+
+    rollup_count (_rollup_deltas, task, 1);
+    project_count (_project_deltas, task, 1);
+    tag_count (_tag_deltas, task, 1);
+
+    // Add undo data lines:
+    //   time <time> <group>
+    //   new <task>
+    //   ---
+    undo.add_line (undo_time ());
+    undo.add_line ("new " + after + '\n');
+    undo.add_line ("---\n");
+  }
+
+  // Add task to backlog.
+  if (add_to_backlog && uses_backlog ())
+    backlog.add_line (task.composeJSON () + '\n');
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Changes are recorded in backlog.data for the next sync, unless there is no
+// Taskserver to sync with, and data.backlog=0 says not to prepare for one.
+bool TDB2::uses_backlog ()
+{
+  return Context::getContext ().config.getBoolean ("data.backlog") ||
+         Context::getContext ().config.get ("taskd.server") != "";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Counts a task of the given status, in one project or tag.
+static void status_count (ProjectCount& count, Task::status status, int sign)
+{
+  switch (status)
+  {
+  case Task::pending:
+  case Task::waiting:   count.pending   += sign; break;
+  case Task::completed: count.done      += sign; break;
+  case Task::recurring: count.templates += sign; break;
+  case Task::deleted:   count.deleted   += sign; break;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Applies the changes since the counts were written.
+static void add_counts (
+  std::map <std::string, ProjectCount>& counts,
+  const std::map <std::string, ProjectCount>& deltas)
+{
+  for (auto& delta : deltas)
+  {
+    auto& count = counts[delta.first];
+    count.pending   += delta.second.pending;
+    count.done      += delta.second.done;
+    count.templates += delta.second.templates;
+    count.deleted   += delta.second.deleted;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TDB2::commit ()
+{
+  apply_batch ();
+
+  Trace::Span span ("commit");
+  Timer timer;
+
+  // Ignore harmful signals.
+  signal (SIGHUP,    SIG_IGN);
+  signal (SIGINT,    SIG_IGN);
+  signal (SIGPIPE,   SIG_IGN);
+  signal (SIGTERM,   SIG_IGN);
+  signal (SIGUSR1,   SIG_IGN);
+  signal (SIGUSR2,   SIG_IGN);
+
+  // The tasks moved by a GC in memory are written along with any other change,
+  // as a GC would have written them.
+  if (_gc_deferred && (pending._dirty || completed._dirty))
+  {
+    pending._dirty = true;
+    completed._dirty = true;
+  }
+
+  _gc_deferred = false;
+
+  dump ();
+  gather_changes ();
+  bool undone = undo._dirty;
+
+  // With data.append, a commit that only adds is appended under shared locks,
+  // at the same time as other such commits.  The counts kept beside the data
+  // cannot be updated safely meanwhile, so are left to be found afresh.
+  auto& config = Context::getContext ().config;
+  bool concurrent = config.getBoolean ("data.append")  &&
+                    ! config.getBoolean ("data.atomic") &&
+                    pending.adds_only ()   &&
+                    completed.adds_only () &&
+                    undo.adds_only ()      &&
+                    backlog.adds_only ();
+  if (concurrent)
+    _rollup_stale = true;
+
+  // The per-day counts are carried forward if they were up to date.
+  bool rollupChanged = pending._dirty || completed._dirty;
+  std::map <time_t, RollupDay> days;
+  bool rollupSave = rollupChanged && ! _rollup_stale && read_rollup (days);
+  if (rollupSave)
+  {
+    for (auto& delta : _rollup_deltas)
+    {
+      auto& day = days[delta.first];
+      day.added     += delta.second.added;
+      day.templates += delta.second.templates;
+      day.completed += delta.second.completed;
+      day.deleted   += delta.second.deleted;
+    }
+  }
+
+  // The per-project and per-tag counts likewise, or else counted afresh when
+  // every task has been loaded anyway, and reflects every change.
+  std::map <std::string, ProjectCount> projects;
+  std::map <std::string, ProjectCount> tags;
+  bool projectsValid = ! _rollup_stale && read_counts ("projects.data", projects);
+  bool tagsValid     = ! _rollup_stale && read_counts ("tags.data", tags);
+  bool projectsSave  = projectsValid && rollupChanged;
+  bool tagsSave      = tagsValid && rollupChanged;
+  if (projectsSave)
+    add_counts (projects, _project_deltas);
+
+  if (tagsSave)
+    add_counts (tags, _tag_deltas);
+
+  if ((! projectsValid || ! tagsValid) && ! _rollup_stale &&
+      pending._loaded_tasks && completed._loaded_tasks)
+  {
+    for (auto& task : all_tasks ())
+    {
+      if (! projectsValid)
+        project_count (projects, task, 1);
+
+      if (! tagsValid)
+        tag_count (tags, task, 1);
+    }
+
+    projectsSave = true;
+    tagsSave = true;
+  }
+
+  _rollup_deltas.clear ();
+  _project_deltas.clear ();
+  _tag_deltas.clear ();
+  _rollup_stale = false;
+
+  // The count of unsynced changes is carried forward if it was up to date.
+  int backlogCount = -1;
+  if (backlog._dirty && ! concurrent && read_backlog_count (backlogCount))
+    for (auto& line : backlog._added_lines)
+      if (line[0] == '{')
+        ++backlogCount;
+
+  // The undo index is extended with the transactions about to be appended, if
+  // it describes undo.data as it is.
+  std::vector <std::string> undoAdded;
+  uint64_t undoSize = undo._file.size ();
+  if (undo._dirty && ! concurrent && undo_indexed (undoSize))
+    undoAdded = undo._added_lines;
+
+  // The next event is found from the tasks as they are about to be written,
+  // if pending.data changes, or the record of it is stale.
+  bool eventsChanged = pending._dirty;
+  bool eventsSave = false;
+  time_t next = 0;
+  time_t expiry = 0;
+  if (pending._loaded_tasks && ! concurrent)
+  {
+    if (! eventsChanged && ! _events_ok)
+      read_events (next, expiry);
+
+    eventsSave = eventsChanged || ! _events_ok;
+    if (eventsSave)
+      next_events (next, expiry);
+  }
+
+  // The derived files are written under the lock that the data files were
+  // committed under, so that no concurrent append lands in between, and is
+  // stamped as though it were counted.
+  auto save_derived = [&] ()
+  {
+    if (rollupSave)
+      write_rollup (days);
+    else if (rollupChanged)
+      unlink ((_location + "/rollup.data").c_str ());
+
+    if (projectsSave)
+      write_counts ("projects.data", projects);
+    else if (rollupChanged)
+      unlink ((_location + "/projects.data").c_str ());
+
+    if (tagsSave)
+      write_counts ("tags.data", tags);
+    else if (rollupChanged)
+      unlink ((_location + "/tags.data").c_str ());
+
+    if (eventsSave)
+      save_events (next, expiry);
+    else if (eventsChanged)
+      unlink ((_location + "/pending.data.next").c_str ());
+
+    if (backlogCount >= 0)
+      write_backlog_count (backlogCount);
+
+    // The completion candidates are found afresh when every task is loaded, and
+    // otherwise when next needed.
+    if (rollupChanged)
+    {
+      if (pending._loaded_tasks && completed._loaded_tasks && ! concurrent)
+      {
+        Completions candidates;
+        gather_completions (candidates);
+        write_completions (candidates);
+      }
+      else
+        unlink ((_location + "/completion.data").c_str ());
+    }
+  };
+
+  auto locked = [this] (bool shared, bool committed, const std::function <void ()>& body)
+  {
+    int lock = lock_data (shared);
+    try
+    {
+      body ();
+    }
+
+    catch (...)
+    {
+      unlock_data (lock, false);
+      throw;
+    }
+
+    unlock_data (lock, committed);
+  };
+
+  bool dirty    = pending._dirty || completed._dirty || undo._dirty || backlog._dirty;
+  bool deriving = rollupSave || rollupChanged || projectsSave || tagsSave ||
+                  eventsSave || eventsChanged || backlogCount >= 0;
+
+  if (Context::getContext ().config.getBoolean ("data.atomic"))
+  {
+    commit_atomic ();
+    if (deriving)
+      locked (false, false, save_derived);
+  }
+  else if (concurrent && dirty)
+  {
+    // Shared, so that no generation is counted, as concurrent commits could
+    // not count one each.
+    locked (true, false, [&] ()
+    {
+      pending.commit (true);
+      completed.commit (true);
+      undo.commit (true);
+      backlog.commit (true);
+      save_derived ();
+    });
+  }
+  else if (dirty)
+  {
+    // The files are committed in turn, but under one lock, so that a snapshot
+    // sees all of them before the commit or all after.
+    locked (false, true, [&] ()
+    {
+      pending.commit ();
+      completed.commit ();
+      undo.commit ();
+      backlog.commit ();
+      save_derived ();
+    });
+  }
+  else if (deriving)
+    locked (false, false, save_derived);
+
+  if (undoAdded.size ())
+    index_undo (undoSize, undoAdded);
+
+  if (undone)
+    undo.compact ((uint64_t) std::max (Context::getContext ().config.getInteger ("undo.size"), 0) * 1024);
+
+  // Restore signal handling.
+  signal (SIGHUP,    SIG_DFL);
+  signal (SIGINT,    SIG_DFL);
+  signal (SIGPIPE,   SIG_DFL);
+  signal (SIGTERM,   SIG_DFL);
+  signal (SIGUSR1,   SIG_DFL);
+  signal (SIGUSR2,   SIG_DFL);
+
+  Context::getContext ().time_commit_us += timer.total_us ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The earliest times at which handleRecurrence, and handleUntil, may change a
+// pending task.
+void TDB2::next_events (time_t& next, time_t& expiry)
+{
+  next = expiry = std::numeric_limits <time_t>::max ();
+  for (auto& task : pending.get_tasks ())
+  {
+    auto status = task.getStatus ();
+    if (status == Task::recurring)
+      next = std::min (next, nextRecurrenceEvent (task));
+
+    // A waiting task becomes pending without being modified.
+    else if ((status == Task::pending || status == Task::waiting) &&
+             task.has ("until"))
+      expiry = std::min (expiry, task.get_date ("until"));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Records the next recurrence, the recurrence.limit it assumes, the size and
+// modification time of pending.data, and the earliest until date, in
+// pending.data.next.  A stale record is ignored.
+void TDB2::save_events (time_t next, time_t expiry)
+{
+  struct stat s;
+  if (stat (std::string (pending._file).c_str (), &s) == -1)
+    return;
+
+  File file (_location + "/pending.data.next");
+  if (file.open ())
+  {
+    file.truncate ();
+    file.write_raw (format ("{1} {2} {3} {4} {5}\n",
+                            (long long) next,
+                            Context::getContext ().config.getInteger ("recurrence.limit"),
+                            (long long) s.st_size,
+                            (long long) s.st_mtime,
+                            (long long) expiry));
+    file.close ();
+    _events_ok = true;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The size and modification time of pending.data and completed.data, which
+// identify the contents that a derived file describes.
+std::string TDB2::data_stamp ()
+{
+  std::string stamp;
+  for (auto file : {&pending, &completed})
+  {
+    struct stat s;
+    if (stat (std::string (file->_file).c_str (), &s) == -1)
+      return "";
+
+    stamp += format ("{1} {2} ", (long long) s.st_size, (long long) s.st_mtime);
+  }
+
+  return stamp;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Counts a task in the day it was entered, and the day it ended, as the history
+// reports do.
+void TDB2::rollup_count (std::map <time_t, RollupDay>& days, const Task& task, int sign)
+{
+  auto status = task.getStatus ();
+
+  auto& entered = days[Datetime (task.get_date ("entry")).startOfDay ().toEpoch ()];
+  if (status == Task::recurring)
+    entered.templates += sign;
+  else
+    entered.added += sign;
+
+  if (status == Task::completed ||
+      status == Task::deleted)
+  {
+    Datetime end;
+    if (task.has ("end"))
+      end = Datetime (task.get_date ("end"));
+
+    auto& ended = days[end.startOfDay ().toEpoch ()];
+    if (status == Task::completed)
+      ended.completed += sign;
+    else
+      ended.deleted += sign;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reads rollup.data, which is only valid for the data files it was written
+// with.
+bool TDB2::read_rollup (std::map <time_t, RollupDay>& days)
+{
+  auto stamp = data_stamp ();
+  if (stamp == "")
+    return false;
+
+  std::ifstream in (_location + "/rollup.data");
+  std::string line;
+  if (! std::getline (in, line) || line != stamp)
+    return false;
+
+  days.clear ();
+  long long epoch;
+  RollupDay day;
+  while (in >> epoch >> day.added >> day.templates >> day.completed >> day.deleted)
+    days[epoch] = day;
+
+  return in.eof ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TDB2::write_rollup (const std::map <time_t, RollupDay>& days)
+{
+  auto stamp = data_stamp ();
+  if (stamp == "")
+    return;
+
+  std::string contents = stamp + '\n';
+  for (auto& day : days)
+    if (day.second.added || day.second.templates || day.second.completed || day.second.deleted)
+      contents += format ("{1} {2} {3} {4} {5}\n",
+                          (long long) day.first,
+                          day.second.added,
+                          day.second.templates,
+                          day.second.completed,
+                          day.second.deleted);
+
+  File file (_location + "/rollup.data");
+  if (file.open ())
+  {
+    file.truncate ();
+    file.write_raw (contents);
+    file.close ();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Counts a task in its project, as the project feedback does, and as the
+// projects command does, under "" if it has none.
+void TDB2::project_count (std::map <std::string, ProjectCount>& projects, const Task& task, int sign)
+{
+  status_count (projects[task.get ("project")], task.getStatus (), sign);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Counts a task in each of its tags, as the tags command does.
+void TDB2::tag_count (std::map <std::string, ProjectCount>& tags, const Task& task, int sign)
+{
+  auto status = task.getStatus ();
+  for (auto& tag : task.getTags ())
+    status_count (tags[tag], status, sign);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reads projects.data or tags.data, which is only valid for the data files it
+// was written with.  Each line is the pending, done, template and deleted
+// counts, then the project or tag.
+bool TDB2::read_counts (const std::string& name, std::map <std::string, ProjectCount>& counts)
+{
+  auto stamp = data_stamp ();
+  if (stamp == "")
+    return false;
+
+  std::ifstream in (_location + '/' + name);
+  std::string line;
+  if (! std::getline (in, line) || line != stamp)
+    return false;
+
+  counts.clear ();
+  ProjectCount count;
+  std::string key;
+  while (in >> count.pending >> count.done >> count.templates >> count.deleted &&
+         in.get () == ' ' &&
+         std::getline (in, key))
+    counts[key] = count;
+
+  return in.eof ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TDB2::write_counts (const std::string& name, const std::map <std::string, ProjectCount>& counts)
+{
+  auto stamp = data_stamp ();
+  if (stamp == "")
+    return;
+
+  std::string contents = stamp + '\n';
+  for (auto& count : counts)
+    if (count.second.pending || count.second.done ||
+        count.second.templates || count.second.deleted)
+      contents += format ("{1} {2} {3} {4} {5}\n",
+                          count.second.pending,
+                          count.second.done,
+                          count.second.templates,
+                          count.second.deleted,
+                          count.first);
+
+  File file (_location + '/' + name);
+  if (file.open ())
+  {
+    file.truncate ();
+    file.write_raw (contents);
+    file.close ();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The tasks in a project, from projects.data and the changes since, without
+// loading completed.data.  Should the counts not be known, or an uncounted
+// change have been made, all the tasks are counted instead.
+void TDB2::project_counts (const std::string& project, int& count_pending, int& count_done)
+{
+  std::map <std::string, ProjectCount> projects;
+  if (_rollup_stale || ! read_counts ("projects.data", projects))
+  {
+    projects.clear ();
+    for (auto& task : all_tasks ())
+      if (task.get ("project") == project)
+        project_count (projects, task, 1);
+  }
+  else
+  {
+    auto delta = _project_deltas.find (project);
+    if (delta != _project_deltas.end ())
+    {
+      projects[project].pending += delta->second.pending;
+      projects[project].done    += delta->second.done;
+    }
+  }
+
+  count_pending = projects[project].pending;
+  count_done    = projects[project].done;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The counts of every project, or every tag, from projects.data or tags.data
+// and the changes since, for the unfiltered projects and tags commands.  Should
+// they not be known, all the tasks are counted, and the counts kept for next
+// time if there is no change yet to be written.
+void TDB2::counts (const std::string& name, std::map <std::string, ProjectCount>& counts)
+{
+  bool tags = name == "tags";
+  auto& deltas = tags ? _tag_deltas : _project_deltas;
+  if (! _rollup_stale && read_counts (name + ".data", counts))
+  {
+    add_counts (counts, deltas);
+    return;
+  }
+
+  counts.clear ();
+  for (auto& task : all_tasks ())
+  {
+    if (tags)
+      tag_count (counts, task, 1);
+    else
+      project_count (counts, task, 1);
+  }
+
+  if (! pending._dirty && ! completed._dirty && deltas.empty () && ! _rollup_stale)
+    write_counts (name + ".data", counts);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The counts are only available when there are no uncommitted changes.
+bool TDB2::get_rollup (std::map <time_t, RollupDay>& days)
+{
+  if (pending._dirty || completed._dirty || _rollup_deltas.size () || _rollup_stale)
+    return false;
+
+  return read_rollup (days);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Records the counts of all the tasks, found by a full scan.
+void TDB2::save_rollup (const std::map <time_t, RollupDay>& days)
+{
+  if (pending._dirty || completed._dirty || _rollup_deltas.size () || _rollup_stale)
+    return;
+
+  write_rollup (days);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TDB2::events_due ()
+{
+  time_t next;
+  time_t expiry;
+  return ! read_events (next, expiry) || Datetime ().toEpoch () >= next;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Whether an until date may have passed, so that the pending tasks need to be
+// checked for expiry, which is not often, as few tasks have one.
+bool TDB2::expiry_due ()
+{
+  time_t next;
+  time_t expiry;
+  return ! read_events (next, expiry) || Datetime ().toEpoch () >= expiry;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reads pending.data.next, which is only valid for pending.data as it was when
+// the file was written, and for the same recurrence.limit.  Any change since
+// then may have made an event due.
+bool TDB2::read_events (time_t& next, time_t& expiry)
+{
+  if (pending._dirty)
+    return false;
+
+  char line[128] {};
+  FILE* in = fopen ((_location + "/pending.data.next").c_str (), "r");
+  if (! in)
+    return false;
+
+  long long recurrence, limit, size, mtime, until;
+  bool read = fgets (line, sizeof (line), in) &&
+              sscanf (line, "%lld %lld %lld %lld %lld", &recurrence, &limit, &size, &mtime, &until) == 5;
+  fclose (in);
+
+  struct stat s;
+  _events_ok = read &&
+               stat (std::string (pending._file).c_str (), &s) == 0 &&
+               s.st_size  == size                                    &&
+               s.st_mtime == mtime                                  &&
+               limit == Context::getContext ().config.getInteger ("recurrence.limit");
+
+  next = (time_t) recurrence;
+  expiry = (time_t) until;
+  return _events_ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The changes in backlog.data, which are its lines holding a task, and those
+// not yet committed.  The count is kept in backlog.data.count, with the size
+// and modification time of backlog.data, so that it is not read on every
+// command.  A sync rewrites backlog.data, which makes the count stale, and it
+// is then counted afresh.
+int TDB2::backlog_count ()
+{
+  int count;
+  if (! read_backlog_count (count))
+  {
+    count = backlog.count_lines ("{");
+
+    // Loaded lines include those added.
+    if (backlog._loaded_lines)
+      for (auto& line : backlog._added_lines)
+        if (line[0] == '{')
+          --count;
+
+    write_backlog_count (count);
+  }
+
+  for (auto& line : backlog._added_lines)
+    if (line[0] == '{')
+      ++count;
+
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TDB2::read_backlog_count (int& count)
+{
+  char line[128] {};
+  FILE* in = fopen ((_location + "/backlog.data.count").c_str (), "r");
+  if (! in)
+    return false;
+
+  long long size, mtime;
+  bool read = fgets (line, sizeof (line), in) &&
+              sscanf (line, "%d %lld %lld", &count, &size, &mtime) == 3;
+  fclose (in);
+
+  struct stat s;
+  return read &&
+         stat (std::string (backlog._file).c_str (), &s) == 0 &&
+         s.st_size  == size                                    &&
+         s.st_mtime == mtime;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TDB2::write_backlog_count (int count)
+{
+  struct stat s;
+  if (stat (std::string (backlog._file).c_str (), &s) == -1)
+    return;
+
+  File file (_location + "/backlog.data.count");
+  if (file.open ())
+  {
+    file.truncate ();
+    file.write_raw (format ("{1} {2} {3}\n",
+                            count,
+                            (long long) s.st_size,
+                            (long long) s.st_mtime));
+    file.close ();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TaskColumns::add (const Task& task)
+{
+  add (task.getStatus (),
+       task.get_date ("entry"),
+       task.get_date ("start"),
+       task.get_date ("end"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TaskColumns::add (Task::status s, time_t e, time_t b, time_t d)
+{
+  status.push_back (s);
+  entry.push_back (e);
+  start.push_back (b);
+  end.push_back (d);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The pending tasks are loaded, for their IDs, but completed.data need not be.
+void TDB2::columns (TaskColumns& columns)
+{
+  for (auto& task : pending.get_tasks ())
+    columns.add (task);
+
+  completed.columns (columns);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The candidates that the unfiltered _ids, _projects and _tags helpers show,
+// from completion.data if it is up to date, so that neither data file is read.
+// The IDs are those that a GC assigns, so there are none to give when GC is
+// off.
+bool TDB2::completions (Completions& candidates)
+{
+  if (! Context::getContext ().config.getBoolean ("gc"))
+    return false;
+
+  if (pending._dirty || completed._dirty)
+    gather_completions (candidates);
+
+  else if (! read_completions (candidates))
+  {
+    gather_completions (candidates);
+    write_completions (candidates);
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Tasks in pending.data are numbered in order, skipping those that a GC would
+// move to completed.data.
+void TDB2::gather_completions (Completions& candidates)
+{
+  candidates = Completions ();
+
+  int id = 0;
+  for (auto& task : pending.get_tasks ())
+  {
+    auto status = task.getStatus ();
+    if (status != Task::completed && status != Task::deleted)
+      candidates.ids.push_back (++id);
+  }
+
+  for (auto& task : all_tasks ())
+  {
+    auto status = task.getStatus ();
+    auto project = task.get ("project");
+    if (project != "")
+    {
+      if (status != Task::completed && status != Task::deleted)
+        candidates.projects.insert (project);
+      else
+        candidates.done_projects.insert (project);
+    }
+
+    for (auto& tag : task.getTags ())
+      candidates.tags.insert (tag);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-// For any task that has depenencies, follow the chain of dependencies until the
-// end.  Along the way, update the Task::is_blocked and Task::is_blocking data
-// cache.
-void TF2::dependency_scan ()
+// Reads completion.data, which is only valid for the data files it was written
+// with.  Each line is a type, 'i', 'p', 'd' or 't', then the candidate.
+bool TDB2::read_completions (Completions& candidates)
 {
-  // Iterate and modify TDB2 in-place.  Don't do this at home.
-  for (auto& left : _tasks)
+  auto stamp = data_stamp ();
+  if (stamp == "")
+    return false;
+
+  std::ifstream in (_location + "/completion.data");
+  std::string line;
+  if (! std::getline (in, line) || line != stamp)
+    return false;
+
+  candidates = Completions ();
+  while (std::getline (in, line))
   {
-    if (left.has ("depends"))
+    if (line.length () < 3 || line[1] != ' ')
+      return false;
+
+    auto value = line.substr (2);
+    switch (line[0])
     {
-      for (auto& dep : left.getDependencyUUIDs ())
-      {
-        for (auto& right : _tasks)
-        {
-          if (right.get ("uuid") == dep)
-          {
-            // GC hasn't run yet, check both tasks for their current status
-            Task::status lstatus = left.getStatus ();
-            Task::status rstatus = right.getStatus ();
-            if (lstatus != Task::completed &&
-                lstatus != Task::deleted &&
-                rstatus != Task::completed &&
-                rstatus != Task::deleted)
-            {
-              left.is_blocked = true;
-              right.is_blocking = true;
-            }
-
-            // Only want to break out of the "right" loop.
-            break;
-          }
-        }
-      }
+    case 'i': candidates.ids.push_back (strtol (value.c_str (), nullptr, 10)); break;
+    case 'p': candidates.projects.insert (value);                              break;
+    case 'd': candidates.done_projects.insert (value);                         break;
+    case 't': candidates.tags.insert (value);                                  break;
+    default:  return false;
     }
   }
+
+  return in.eof ();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-const std::string TF2::dump ()
+void TDB2::write_completions (const Completions& candidates)
 {
-  Color red    ("rgb500 on rgb100");
-  Color yellow ("rgb550 on rgb220");
-  Color green  ("rgb050 on rgb010");
-
-  // File label.
-  std::string label;
-  auto slash = _file._data.rfind ('/');
-  if (slash != std::string::npos)
-    label = rightJustify (_file._data.substr (slash + 1), 14);
+  auto stamp = data_stamp ();
+  if (stamp == "")
+    return;
 
-  // File mode.
-  std::string mode = std::string (_file.exists () && _file.readable () ? "r" : "-") +
-                     std::string (_file.exists () && _file.writable () ? "w" : "-");
-       if (mode == "r-") mode = red.colorize (mode);
-  else if (mode == "rw") mode = green.colorize (mode);
-  else                   mode = yellow.colorize (mode);
+  std::string contents = stamp + '\n';
+  for (auto id : candidates.ids)
+    contents += format ("i {1}\n", id);
 
-  // Hygiene.
-  std::string hygiene = _dirty ? red.colorize ("O") : green.colorize ("-");
+  for (auto& project : candidates.projects)
+    contents += "p " + project + '\n';
 
-  std::string tasks          = green.colorize  (rightJustifyZero ((int) _tasks.size (),          4));
-  std::string tasks_added    = red.colorize    (rightJustifyZero ((int) _added_tasks.size (),    3));
-  std::string tasks_modified = yellow.colorize (rightJustifyZero ((int) _modified_tasks.size (), 3));
-  std::string tasks_purged   = red.colorize    (rightJustifyZero ((int) _purged_tasks.size (),   3));
-  std::string lines          = green.colorize  (rightJustifyZero ((int) _lines.size (),          4));
-  std::string lines_added    = red.colorize    (rightJustifyZero ((int) _added_lines.size (),    3));
+  for (auto& project : candidates.done_projects)
+    contents += "d " + project + '\n';
 
-  char buffer[256];  // Composed string is actually 246 bytes.  Yikes.
-  snprintf (buffer, 256, "%14s %s %s T%s+%s~%s-%s L%s+%s",
-            label.c_str (),
-            mode.c_str (),
-            hygiene.c_str (),
-            tasks.c_str (),
-            tasks_added.c_str (),
-            tasks_modified.c_str (),
-            tasks_purged.c_str (),
-            lines.c_str (),
-            lines_added.c_str ());
+  for (auto& tag : candidates.tags)
+    contents += "t " + tag + '\n';
 
-  return std::string (buffer);
+  File file (_location + "/completion.data");
+  if (file.open ())
+  {
+    file.truncate ();
+    file.write_raw (contents);
+    file.close ();
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-TDB2::TDB2 ()
-: _location ("")
-, _id (1)
+// undo.data.index locates the transactions in undo.data by task.  It begins
+// with the size of undo.data that it describes, followed by a line for each
+// transaction, of its offset and the uuid of the task it changed.  The lines
+// are of fixed width, so that the last is found and removed by an undo.
+#define UNDO_INDEX_HEADER 21
+#define UNDO_INDEX_ENTRY  58
+
+static bool undo_index_entry (char* entry, uint64_t offset, const std::string& line)
 {
-  // Mark the pending file as the only one that has ID numbers.
-  pending.has_ids ();
+  auto uuid = line.find ("uuid:\"");
+  if (uuid == std::string::npos || line.length () < uuid + 6 + 36)
+    return false;
 
-  // Indicate that dependencies should be automatically scanned on startup,
-  // setting Task::is_blocked and Task::is_blocking accordingly.
-  pending.auto_dep_scan ();
+  snprintf (entry, UNDO_INDEX_ENTRY + 1, "%020llu %s\n",
+            (unsigned long long) offset,
+            line.substr (uuid + 6, 36).c_str ());
+  return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-// Once a location is known, the files can be set up.  Note that they are not
-// read.
-void TDB2::set_location (const std::string& location)
+// Whether the index describes undo.data of the given size.
+bool TDB2::undo_indexed (uint64_t size)
 {
-  _location = location;
+  FILE* in = fopen ((_location + "/undo.data.index").c_str (), "r");
+  if (! in)
+    return size == 0;
+
+  unsigned long long indexed = 0;
+  bool read = fscanf (in, "%20llu", &indexed) == 1;
+  fclose (in);
+  return read && indexed == size;
+}
 
-  pending.target   (location + "/pending.data");
-  completed.target (location + "/completed.data");
-  undo.target      (location + "/undo.data");
-  backlog.target   (location + "/backlog.data");
+////////////////////////////////////////////////////////////////////////////////
+// Appends the entries of the transactions appended to undo.data, which was
+// of the given size.
+void TDB2::index_undo (uint64_t size, const std::vector <std::string>& lines)
+{
+  std::string entries;
+  char entry[UNDO_INDEX_ENTRY + 1];
+  uint64_t offset = size;
+  uint64_t start = size;
+  for (auto& line : lines)
+  {
+    if ((! line.compare (0, 4, "new ", 4) || ! line.compare (0, 4, "set ", 4)) &&
+        undo_index_entry (entry, start, line))
+      entries += entry;
+
+    offset += line.length ();
+    if (! line.compare (0, 3, "---", 3))
+      start = offset;
+  }
+
+  auto name = _location + "/undo.data.index";
+  int fd = open (name.c_str (), O_RDWR | O_CREAT, 0600);
+  if (fd == -1)
+    return;
+
+  // The header is written last, so that an interrupted update is seen as
+  // stale rather than complete.
+  char header[UNDO_INDEX_HEADER + 1];
+  snprintf (header, sizeof (header), "%020llu\n", (unsigned long long) offset);
+
+  struct stat s;
+  bool ok = fstat (fd, &s) == 0;
+  off_t end = ok && s.st_size >= UNDO_INDEX_HEADER ? s.st_size : UNDO_INDEX_HEADER;
+  ok = ok &&
+       pwrite (fd, entries.data (), entries.length (), end) == (ssize_t) entries.length () &&
+       pwrite (fd, header, UNDO_INDEX_HEADER, 0) == UNDO_INDEX_HEADER;
+  close (fd);
+
+  if (! ok)
+    unlink (name.c_str ());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-// Add the new task to the appropriate file.
-void TDB2::add (Task& task, bool add_to_backlog /* = true */)
+// Indexes the whole of undo.data, reading it a line at a time.
+void TDB2::build_undo_index ()
 {
-  // Ensure the task is consistent, and provide defaults if necessary.
-  // bool argument to validate() is "applyDefault". Pass add_to_backlog through
-  // in order to not apply defaults to synchronized tasks.
-  task.validate (add_to_backlog);
-  std::string uuid = task.get ("uuid");
+  std::ifstream in (undo._file._data);
+  std::string contents (UNDO_INDEX_HEADER, ' ');
+  std::string line;
+  char entry[UNDO_INDEX_ENTRY + 1];
+  uint64_t offset = 0;
+  uint64_t start = 0;
+  while (std::getline (in, line))
+  {
+    if ((! line.compare (0, 4, "new ", 4) || ! line.compare (0, 4, "set ", 4)) &&
+        undo_index_entry (entry, start, line))
+      contents += entry;
 
-  // If the tasks are loaded, then verify that this uuid is not already in
-  // the file.
-  if (!verifyUniqueUUID (uuid))
-    throw format ("Cannot add task because the uuid '{1}' is not unique.", uuid);
+    offset += line.length () + 1;
+    if (line == "---")
+      start = offset;
+  }
 
-  // Only locally-added tasks trigger hooks.  This means that tasks introduced
-  // via 'sync' do not trigger hooks.
-  if (add_to_backlog)
-    Context::getContext ().hooks.onAdd (task);
+  char header[UNDO_INDEX_HEADER + 1];
+  snprintf (header, sizeof (header), "%020llu\n", (unsigned long long) offset);
+  contents.replace (0, UNDO_INDEX_HEADER, header);
 
-  update (task, add_to_backlog, true);
+  File file (_location + "/undo.data.index");
+  if (file.open ())
+  {
+    file.truncate ();
+    file.write_raw (contents);
+    file.close ();
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void TDB2::modify (Task& task, bool add_to_backlog /* = true */)
+// Removes the entries of the last transactions, from the given offset, which
+// undo is about to truncate from undo.data of the given size.
+void TDB2::truncate_undo_index (uint64_t size, uint64_t offset)
 {
-  // Ensure the task is consistent.
-  task.validate (false);
-  std::string uuid = task.get ("uuid");
+  auto name = _location + "/undo.data.index";
+  int fd = open (name.c_str (), O_RDWR);
+  if (fd == -1)
+    return;
+
+  char header[UNDO_INDEX_HEADER + 1] {};
+  char last[UNDO_INDEX_ENTRY + 1] {};
+  struct stat s;
+  bool ok = fstat (fd, &s) == 0 &&
+            s.st_size >= UNDO_INDEX_HEADER &&
+            pread (fd, header, UNDO_INDEX_HEADER, 0) == UNDO_INDEX_HEADER &&
+            strtoull (header, nullptr, 10) == size;
+
+  // The entries are in order of offset, so those removed are the last ones,
+  // of which the first is at the offset.
+  off_t end = ok ? s.st_size : 0;
+  bool found = false;
+  while (ok && end >= UNDO_INDEX_HEADER + UNDO_INDEX_ENTRY)
+  {
+    ok = pread (fd, last, UNDO_INDEX_ENTRY, end - UNDO_INDEX_ENTRY) == UNDO_INDEX_ENTRY;
+    auto at = strtoull (last, nullptr, 10);
+    if (ok && at < offset)
+      break;
 
-  // Get the unmodified task as reference, so the hook can compare.
-  if (add_to_backlog)
+    found = at == offset;
+    end -= UNDO_INDEX_ENTRY;
+  }
+
+  ok = ok && found;
+  if (ok)
   {
-    Task original;
-    get (uuid, original);
-    Context::getContext ().hooks.onModify (original, task);
+    snprintf (header, sizeof (header), "%020llu\n", (unsigned long long) offset);
+    ok = ftruncate (fd, end) == 0 &&
+         pwrite (fd, header, UNDO_INDEX_HEADER, 0) == UNDO_INDEX_HEADER;
   }
 
-  update (task, add_to_backlog);
+  close (fd);
+  if (! ok)
+    unlink (name.c_str ());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void TDB2::purge (Task& task)
+// Replaces the 'was' and 'set' lines written with undo.delta with the 'old'
+// and 'new' lines they stand for, so that either is read the same way.  The
+// lines are of the newest transactions of their tasks, so each task is
+// followed back from its record in the data files, newest first.
+void TDB2::expand_undo (std::vector <std::string>& lines)
 {
-  // Delete the task from completed.data
-  completed.purge_task (task);
+  std::unordered_map <std::string, std::string> records;
+  for (size_t i = lines.size (); i-- > 0; )
+  {
+    auto& line = lines[i];
+    bool set = ! line.compare (0, 4, "set ", 4);
+    if (! set && line.compare (0, 4, "new ", 4))
+      continue;
+
+    auto att = line.find ("uuid:\"");
+    if (att == std::string::npos)
+      continue;
+
+    auto uuid = line.substr (att + 6, 36);
+    if (set)
+    {
+      auto record = records.find (uuid);
+      if (record == records.end ())
+      {
+        Task task;
+        if (! pending.get (uuid, task) &&
+            ! completed.get (uuid, task))
+          throw format ("Cannot read the changes to task {1}, which is no longer in the data files.", uuid);
+
+        record = records.emplace (uuid, task.composeF4 ()).first;
+      }
+
+      line = "new " + record->second;
+    }
+
+    // The record before this transaction, if it was a modification, is the
+    // record after the one before.
+    auto& previous = i > 0 ? lines[i - 1] : line;
+    if (! previous.compare (0, 4, "was ", 4))
+    {
+      Task prior (line.substr (4));
+      Task delta (previous.substr (4));
+      for (auto& change : delta.data)
+      {
+        if (change.second == "")
+          prior.data.erase (change.first);
+        else
+          prior.data[change.first] = change.second;
+      }
+
+      previous = "old " + prior.composeF4 ();
+    }
+
+    if (! previous.compare (0, 4, "old ", 4))
+      records[uuid] = previous.substr (4);
+    else
+      records.erase (uuid);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void TDB2::update (
-  Task& task,
-  const bool add_to_backlog,
-  const bool addition /* = false */)
+// The lines of the transactions that changed the task, in order, as they are
+// in undo.data.  Only those transactions are read, as located by the index,
+// which is rebuilt should it not describe undo.data.
+void TDB2::undo_history (const std::string& uuid, std::vector <std::string>& lines)
 {
-  // Validate to add metadata.
-  task.validate (false);
+  lines.clear ();
+  if (uuid.length () != 36)
+    return;
+
+  if (! undo_indexed (undo._file.size ()))
+    build_undo_index ();
+
+  std::vector <uint64_t> offsets;
+  std::ifstream index (_location + "/undo.data.index");
+  std::string entry;
+  std::getline (index, entry);
+  while (std::getline (index, entry))
+    if (entry.length () == UNDO_INDEX_ENTRY - 1 &&
+        ! entry.compare (21, 36, uuid))
+      offsets.push_back (strtoull (entry.c_str (), nullptr, 10));
+
+  std::ifstream in (undo._file._data);
+  std::string line;
+  for (auto offset : offsets)
+  {
+    in.clear ();
+    in.seekg ((std::streamoff) offset);
+    while (std::getline (in, line))
+    {
+      lines.push_back (line);
+      if (line == "---")
+        break;
+    }
+  }
+
+  expand_undo (lines);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Commits all the dirty files under one lock on the data directory.  Each file
+// is written in one pass, appended to or written in full to a temporary copy,
+// then all are synced together before the copies are renamed into place, so
+// that an interrupted commit leaves every file either old or new.
+void TDB2::commit_atomic ()
+{
+  std::vector <TF2*> files;
+  for (auto file : {&pending, &completed, &undo, &backlog})
+    if (file->_dirty)
+      files.push_back (file);
+
+  if (! files.size ())
+    return;
 
-  // If the task already exists, it is a modification, else addition.
-  Task original;
-  if (not addition && get (task.get ("uuid"), original))
+  int lock = lock_data (false);
+
+  struct staged
   {
-    // Update only if the tasks differ
-    if (task == original)
-      return;
+    TF2* file;
+    std::string path;
+    std::string temp;
+    int fd;
+  };
+
+  std::vector <staged> writes;
+  auto abandon = [&] ()
+  {
+    for (auto& w : writes)
+    {
+      if (w.fd != -1)
+        close (w.fd);
 
-    if (add_to_backlog)
+      if (w.temp != "")
+        unlink (w.temp.c_str ());
+    }
+
+    unlock_data (lock, false);
+  };
+
+  for (auto file : files)
+  {
+    std::string text;
+    staged w {file, file->_file._data, "", -1};
+
+    if (file->stage (text))
     {
-      // All locally modified tasks are timestamped, implicitly overwriting any
-      // changes the user or hooks tried to apply to the "modified" attribute.
-      task.setAsNow ("modified");
+      // Keep the permissions of the file being replaced.
+      struct stat s;
+      mode_t mode = stat (w.path.c_str (), &s) == 0 ? s.st_mode & 07777 : 0600;
+
+      w.temp = w.path + ".new";
+      w.fd = open (w.temp.c_str (), O_WRONLY | O_CREAT | O_TRUNC, mode);
+    }
+    else
+      w.fd = open (w.path.c_str (), O_WRONLY | O_CREAT | O_APPEND, 0600);
+
+    writes.push_back (w);
+    if (w.fd == -1)
+    {
+      abandon ();
+      throw format ("Could not write to '{1}'.", w.temp != "" ? w.temp : w.path);
     }
 
-    // Update the task, wherever it is.
-    if (!pending.modify_task (task))
-      completed.modify_task (task);
+    // Readers wait for an append in place.
+    if (w.temp == "" && Context::getContext ().config.getBoolean ("locking"))
+    {
+      struct flock fl {};
+      fl.l_type   = F_WRLCK;
+      fl.l_whence = SEEK_SET;
+      fcntl (w.fd, F_SETLKW, &fl);
+    }
 
-    // time <time>
-    // old <task>
-    // new <task>
-    // ---
-    undo.add_line ("time " + Datetime ().toEpochString () + '\n');
-    undo.add_line ("old " + original.composeF4 () + '\n');
-    undo.add_line ("new " + task.composeF4 () + '\n');
-    undo.add_line ("---\n");
+    const char* data = text.data ();
+    size_t remaining = text.length ();
+    while (remaining)
+    {
+      auto n = write (w.fd, data, remaining);
+      if (n < 0)
+      {
+        abandon ();
+        throw format ("Could not write to '{1}'.", w.temp != "" ? w.temp : w.path);
+      }
+
+      data += n;
+      remaining -= n;
+    }
   }
-  else
+
+  // One round of syncs, then the replacements, in the order written.
+  for (auto& w : writes)
   {
-    // Add new task to either pending or completed.
-    std::string status = task.get ("status");
-    if (status == "completed" ||
-        status == "deleted")
-      completed.add_task (task);
-    else
-      pending.add_task (task);
+    if (fsync (w.fd) != 0)
+    {
+      abandon ();
+      throw format ("Could not sync '{1}'.", w.temp != "" ? w.temp : w.path);
+    }
+  }
 
-    // Add undo data lines:
-    //   time <time>
-    //   new <task>
-    //   ---
-    undo.add_line ("time " + Datetime ().toEpochString () + '\n');
-    undo.add_line ("new " + task.composeF4 () + '\n');
-    undo.add_line ("---\n");
+  for (auto& w : writes)
+  {
+    close (w.fd);
+    w.fd = -1;
   }
 
-  // Add task to backlog.
-  if (add_to_backlog)
-    backlog.add_line (task.composeJSON () + '\n');
+  bool renamed = false;
+  for (auto& w : writes)
+  {
+    if (w.temp != "")
+    {
+      if (rename (w.temp.c_str (), w.path.c_str ()) != 0)
+      {
+        abandon ();
+        throw format ("Could not replace '{1}'.", w.path);
+      }
+
+      w.temp = "";
+      renamed = true;
+    }
+  }
+
+  // A rename is only durable once the directory is synced.
+  if (renamed)
+  {
+    int dir = open (_location.c_str (), O_RDONLY);
+    if (dir != -1)
+    {
+      fsync (dir);
+      close (dir);
+    }
+  }
+
+  for (auto& w : writes)
+    w.file->written ();
+
+  Context::getContext ().debug (format ("TDB2::commit_atomic wrote {1} files under one lock", writes.size ()));
+
+  unlock_data (lock, true);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void TDB2::commit ()
+// lock.data is locked exclusively by a commit, and shared by a snapshot, so
+// that a snapshot sees every data file as of one commit.  It holds the number
+// of commits made, the generation.
+int TDB2::lock_data (bool shared)
 {
+  if (! Context::getContext ().config.getBoolean ("locking"))
+    return -1;
+
+  auto path = _location + "/lock.data";
+  int fd = open (path.c_str (), O_RDWR | O_CREAT, 0600);
+  if (fd == -1)
+    throw format ("Could not open '{1}'.", path);
+
+  struct flock fl {};
+  fl.l_type   = shared ? F_RDLCK : F_WRLCK;
+  fl.l_whence = SEEK_SET;
   Timer timer;
+  fcntl (fd, F_SETLKW, &fl);
+  Context::getContext ().time_lock_us += timer.total_us ();
 
-  // Ignore harmful signals.
-  signal (SIGHUP,    SIG_IGN);
-  signal (SIGINT,    SIG_IGN);
-  signal (SIGPIPE,   SIG_IGN);
-  signal (SIGTERM,   SIG_IGN);
-  signal (SIGUSR1,   SIG_IGN);
-  signal (SIGUSR2,   SIG_IGN);
+  char buffer[32] {};
+  if (pread (fd, buffer, sizeof (buffer) - 1, 0) > 0)
+    _generation = strtoull (buffer, nullptr, 10);
 
-  dump ();
-  gather_changes ();
-  pending.commit ();
-  completed.commit ();
-  undo.commit ();
-  backlog.commit ();
+  return fd;
+}
 
-  // Restore signal handling.
-  signal (SIGHUP,    SIG_DFL);
-  signal (SIGINT,    SIG_DFL);
-  signal (SIGPIPE,   SIG_DFL);
-  signal (SIGTERM,   SIG_DFL);
-  signal (SIGUSR1,   SIG_DFL);
-  signal (SIGUSR2,   SIG_DFL);
+////////////////////////////////////////////////////////////////////////////////
+void TDB2::unlock_data (int fd, bool committed)
+{
+  if (fd == -1)
+    return;
 
-  Context::getContext ().time_commit_us += timer.total_us ();
+  if (committed)
+  {
+    auto text = std::to_string (++_generation) + '\n';
+    if (pwrite (fd, text.data (), text.length (), 0) == (ssize_t) text.length ())
+      ftruncate (fd, text.length ());
+  }
+
+  close (fd);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Opens pending.data and completed.data as of one commit, so that they are read
+// as they were, however a concurrent commit changes them.  No lock is held for
+// the reading.
+void TDB2::snapshot ()
+{
+  int lock = lock_data (true);
+  pending.snapshot ();
+  completed.snapshot ();
+  unlock_data (lock, false);
+
+  Context::getContext ().debug (format ("TDB2::snapshot generation {1}", std::to_string (_generation)));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -775,11 +3966,17 @@ void TDB2::gather_changes ()
   for (auto& task : pending._modified_tasks)
     _changes.push_back (task);
 
+  for (auto position : pending._modified)
+    _changes.push_back (pending._tasks[position]);
+
   for (auto& task : completed._added_tasks)
     _changes.push_back (task);
 
   for (auto& task : completed._modified_tasks)
     _changes.push_back (task);
+
+  for (auto position : completed._modified)
+    _changes.push_back (completed._tasks[position]);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -791,16 +3988,40 @@ void TDB2::get_changes (std::vector <Task>& changes)
 ////////////////////////////////////////////////////////////////////////////////
 void TDB2::revert ()
 {
-  // Extract the details of the last txn, and roll it back.
-  std::vector <std::string> u = undo.get_lines ();
-  std::string uuid;
-  std::string when;
-  std::string current;
-  std::string prior;
-  revert_undo (u, uuid, when, current, prior);
+  // The reverted changes are not counted.
+  _rollup_stale = true;
+
+  // Extract the details of the last group of txns, the last command, newest
+  // first, and roll them back.
+  std::vector <std::string> u;
+  uint64_t offset;
+  undo.get_transaction (u, offset);
+  expand_undo (u);
+
+  struct Change
+  {
+    std::string uuid;
+    std::string when;
+    std::string current;
+    std::string prior;
+  };
+
+  std::vector <Change> changes;
+  do
+  {
+    Change change;
+    revert_undo (u, change.uuid, change.when, change.current, change.prior);
+    changes.push_back (change);
+  }
+  while (! u.empty ());
+
+  // Display diffs and confirm.
+  if (changes.size () > 1)
+    std::cout << format ("The last command changed {1} tasks.", changes.size ()) << '\n';
+
+  for (auto& change : changes)
+    show_diff (change.current, change.prior, change.when);
 
-  // Display diff and confirm.
-  show_diff (current, prior, when);
   if (! Context::getContext ().config.getBoolean ("confirmation") ||
       confirm ("The undo command is not reversible.  Are you sure you want to revert to the previous state?"))
   {
@@ -839,27 +4060,137 @@ void TDB2::revert ()
     //   - erase from completed
     //   - if in backlog, erase, else cannot undo
 
-    // Modify other data files accordingly.
+    // Modifications that leave each task in its file, [2] and [5], are made
+    // through that file, which with data.journal and an index appends the
+    // prior records, rather than reading and rewriting every file.
+    std::vector <TF2*> files;
+    for (auto& change : changes)
+    {
+      TF2* file = change.current != "" && change.prior != "" ? revert_file (change.uuid, change.prior) : nullptr;
+      if (! file)
+        break;
+
+      files.push_back (file);
+    }
+
+    if (files.size () == changes.size ())
+    {
+      std::vector <std::string> b;
+      std::vector <std::string> added;
+      if (uses_backlog ())
+      {
+        b = backlog.get_lines ();
+        for (auto& change : changes)
+        {
+          revert_backlog (b, change.uuid, change.current, change.prior);
+          added.push_back (b.back ());
+        }
+      }
+
+      truncate_undo_index (undo._file.size (), offset);
+      if (truncate (undo._file._data.c_str (), (off_t) offset) != 0)
+        throw format ("Could not write to '{1}'.", undo._file._data);
+
+      for (size_t i = 0; i < changes.size (); ++i)
+      {
+        files[i]->modify_task (Task (changes[i].prior), changes[i].prior);
+        std::cout << STRING_TDB2_REVERTED << '\n';
+        if (files[i] == &completed)
+          std::cout << "Undo complete.\n";
+      }
+
+      for (auto& line : added)
+        backlog.add_line (line + '\n');
+
+      clear_graph ();
+      return;
+    }
+
+    // Modify other data files accordingly, each change in turn.
     std::vector <std::string> p = pending.get_lines ();
-    revert_pending (p, uuid, prior);
+    supersede_lines (p);
 
     std::vector <std::string> c = completed.get_lines ();
-    revert_completed (p, c, uuid, prior);
+    supersede_lines (c);
+
+    std::vector <std::string> b;
+    if (uses_backlog ())
+      b = backlog.get_lines ();
 
-    std::vector <std::string> b = backlog.get_lines ();
-    revert_backlog (b, uuid, current, prior);
+    for (auto& change : changes)
+    {
+      revert_pending (p, change.uuid, change.prior);
+      revert_completed (p, c, change.uuid, change.prior);
+      if (uses_backlog ())
+        revert_backlog (b, change.uuid, change.current, change.prior);
+    }
 
     // Commit.  If processing makes it this far with no exceptions, then we're
     // done.
-    File::write (undo._file._data, u);
+    truncate_undo_index (undo._file.size (), offset);
+    if (truncate (undo._file._data.c_str (), (off_t) offset) != 0)
+      throw format ("Could not write to '{1}'.", undo._file._data);
+
     File::write (pending._file._data, p);
     File::write (completed._file._data, c);
-    File::write (backlog._file._data, b);
+    if (uses_backlog ())
+      File::write (backlog._file._data, b);
+
+    clear_graph ();
   }
   else
     std::cout << "No changes made.\n";
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// The file that holds the task, if reverting it to the prior record leaves it
+// there.  A completed task that reverts to pending moves between files.
+TF2* TDB2::revert_file (const std::string& uuid, const std::string& prior)
+{
+  if (pending.has (uuid))
+    return &pending;
+
+  if (completed.has (uuid))
+  {
+    auto status = Task (prior).getStatus ();
+    if (status == Task::completed || status == Task::deleted)
+      return &completed;
+  }
+
+  return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The line equivalent of TF2::supersede, so that a journaled data file can be
+// reverted line by line, and is written back compacted.
+void TDB2::supersede_lines (std::vector <std::string>& lines)
+{
+  std::unordered_map <std::string, size_t> first;
+  size_t kept = 0;
+  for (size_t i = 0; i < lines.size (); ++i)
+  {
+    auto entry = TF2Index::parse (lines[i], 0);
+    std::string uuid (entry.uuid, strnlen (entry.uuid, sizeof (entry.uuid)));
+
+    auto found = uuid == "" ? first.end () : first.find (uuid);
+    if (found != first.end ())
+    {
+      lines[found->second] = std::move (lines[i]);
+      continue;
+    }
+
+    if (uuid != "")
+      first.emplace (uuid, kept);
+
+    if (kept != i)
+      lines[kept] = std::move (lines[i]);
+
+    ++kept;
+  }
+
+  lines.resize (kept);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void TDB2::revert_undo (
   std::vector <std::string>& u,
@@ -1245,13 +4576,19 @@ void TDB2::show_diff (
 // - task in pending that needs to be in completed
 // - task in completed that needs to be in pending
 // - waiting task in pending that needs to be un-waited
-void TDB2::gc ()
+// With in_memory, the tasks are collected as usual, but nothing is written
+// unless something else changes, for commands that only read.  The files are
+// left for the next command that writes.
+void TDB2::gc (bool in_memory)
 {
+  Trace::Span span ("gc");
   Timer timer;
 
   // Allowed as an override, but not recommended.
   if (Context::getContext ().config.getBoolean ("gc"))
   {
+    clear_graph ();
+
     // Load pending, check whether completed changes size
     auto size_before = completed._tasks.size ();
     pending.load_tasks (/*from_gc =*/ true);
@@ -1267,21 +4604,40 @@ void TDB2::gc ()
       pending._dirty = true;
     }
 
-    // Load completed, check whether pending changes size
-    size_before = pending._tasks.size ();
-    completed.load_tasks (/*from_gc =*/ true);
-    if (size_before != pending._tasks.size ())
+    // Load completed, check whether pending changes size.  There is no need
+    // if it gained no tasks, and its index shows none that belong in pending.
+    if (completed._dirty || completed.holds_pending ())
     {
-      // GC moved tasks from completed to pending
+      size_before = pending._tasks.size ();
+      completed.load_tasks (/*from_gc =*/ true);
+      if (size_before != pending._tasks.size ())
+      {
+        // GC moved tasks from completed to pending
+        pending._dirty = true;
+        completed._dirty = true;
+      }
+    }
+
+    // A data file with too many superseded records is rewritten.
+    if (! pending.journal_ok (0))
       pending._dirty = true;
+    if (! completed.journal_ok (0))
       completed._dirty = true;
-    }
 
     // Update blocked/blocking status after GC is finished
     if (pending._auto_dep_scan)
       pending.dependency_scan ();
     if (completed._auto_dep_scan)
       completed.dependency_scan ();
+
+    if (in_memory)
+    {
+      _gc_deferred = pending._dirty || completed._dirty;
+      pending._dirty = false;
+      completed._dirty = false;
+      if (_gc_deferred)
+        Context::getContext ().debug ("TDB2::gc deferred");
+    }
   }
 
   Context::getContext ().time_gc_us += timer.total_us ();
@@ -1294,6 +4650,13 @@ int TDB2::next_id ()
   return _id++;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Numbering resumes from the given ID.
+void TDB2::next_id (int id)
+{
+  _id = id;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Latest ID is that of the last pending task.
 int TDB2::latest_id ()
@@ -1302,36 +4665,90 @@ int TDB2::latest_id ()
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-const std::vector <Task> TDB2::all_tasks ()
+// All tasks, pending then completed, without copying either file.
+TaskRange TDB2::all_tasks ()
 {
-  std::vector <Task> all (pending._tasks.size () +
-                          pending._added_tasks.size () +
-                          completed._tasks.size () +
-                          completed._added_tasks.size ());
-  all = pending.get_tasks ();
+  auto& first = pending.get_tasks ();
+  return TaskRange (first, completed.get_tasks ());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The tasks of the data locations listed in data.sources, as <name>:<directory>
+// pairs, each with its source attribute set to the name.  They are read as
+// they are, without GC, and have no IDs, as they are only ever reported.  The
+// files of each source are read one after the other, but each is parsed by
+// data.threads, as the files of this location are.
+const std::vector <Task>& TDB2::federated ()
+{
+  if (_federated_loaded)
+    return _federated;
+
+  _federated_loaded = true;
+  for (auto& source : split (Context::getContext ().config.get ("data.sources"), ','))
+  {
+    if (source == "")
+      continue;
+
+    auto colon = source.find (':');
+    if (colon == 0 || colon == std::string::npos || colon + 1 == source.length ())
+      throw format ("The data source '{1}' is not of the form <name>:<directory>.", source);
+
+    auto name = source.substr (0, colon);
+    Directory location (source.substr (colon + 1));
+    if (! location.exists ())
+      throw format ("The data source '{1}' has no directory '{2}'.", name, location._data);
 
-  std::vector <Task> extra (completed._tasks.size () +
-                            completed._added_tasks.size ());
-  extra = completed.get_tasks ();
+    // The lines are read without opening the files for writing, or locking
+    // them, as the location may belong to another user.
+    for (auto file : {"/pending.data", "/completed.data"})
+    {
+      TF2 tasks;
+      tasks.target (location._data + file);
+      File::read (location._data + file, tasks._lines);
+      tasks._lines.erase (std::remove (tasks._lines.begin (), tasks._lines.end (), ""), tasks._lines.end ());
+      tasks._loaded_lines = true;
 
-  for (auto& task : extra)
-    all.push_back (task);
+      for (auto task : tasks.get_tasks ())
+      {
+        task.id = 0;
+        task.set ("source", name);
+        _federated.push_back (std::move (task));
+      }
+    }
+  }
 
-  return all;
+  return _federated;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // Locate task by ID, wherever it is.
 bool TDB2::get (int id, Task& task)
 {
-  return pending.get   (id, task) ||
-         completed.get (id, task);
+  if (! pending.get   (id, task) &&
+      ! completed.get (id, task))
+    return false;
+
+  if (_batch.size ())
+  {
+    auto held = _batch.find (task.get ("uuid"));
+    if (held != _batch.end ())
+      task = _batch_after[held->second];
+  }
+
+  return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // Locate task by UUID, wherever it is.
 bool TDB2::get (const std::string& uuid, Task& task)
 {
+  auto held = _batch.find (uuid);
+  if (held != _batch.end ())
+  {
+    task = _batch_after[held->second];
+    return true;
+  }
+
   return pending.get   (uuid, task) ||
          completed.get (uuid, task);
 }
@@ -1345,33 +4762,37 @@ bool TDB2::has (const std::string& uuid)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-const std::vector <Task> TDB2::siblings (Task& task)
+// The recurring template tasks, without copying the rest of pending.
+std::vector <Task> TDB2::templates ()
+{
+  std::vector <Task> results;
+  for (auto& i : pending.get_tasks ())
+    if (i.getStatus () == Task::recurring)
+      results.push_back (i);
+
+  return results;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::vector <Task> TDB2::siblings (Task& task)
 {
   std::vector <Task> results;
   if (task.has ("parent"))
   {
-    std::string parent = task.get ("parent");
-
-    // First load and scan pending.
-    if (! pending._loaded_tasks)
-      pending.load_tasks ();
+    std::vector <size_t> positions;
+    pending.children (task.get ("parent"), positions);
 
-    for (auto& i : pending._tasks)
+    for (auto position : positions)
     {
+      auto& i = pending._tasks[position];
+
       // Do not include self in results.
       if (i.id != task.id)
       {
         // Do not include completed or deleted tasks.
         if (i.getStatus () != Task::completed &&
             i.getStatus () != Task::deleted)
-        {
-          // If task has the same parent, it is a sibling.
-          if (i.has ("parent") &&
-              i.get ("parent") == parent)
-          {
-            results.push_back (i);
-          }
-        }
+          results.push_back (i);
       }
     }
   }
@@ -1380,28 +4801,23 @@ const std::vector <Task> TDB2::siblings (Task& task)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-const std::vector <Task> TDB2::children (Task& task)
+std::vector <Task> TDB2::children (Task& task)
 {
   std::vector <Task> results;
-  std::string parent = task.get ("uuid");
+  std::vector <size_t> positions;
+  pending.children (task.get ("uuid"), positions);
 
-  // First load and scan pending.
-  if (! pending._loaded_tasks)
-    pending.load_tasks ();
-
-  for (auto& i : pending._tasks)
+  for (auto position : positions)
   {
+    auto& i = pending._tasks[position];
+
     // Do not include self in results.
     if (i.id != task.id)
     {
       // Do not include completed or deleted tasks.
       if (i.getStatus () != Task::completed &&
           i.getStatus () != Task::deleted)
-      {
-        // If task has the given task as a parent, it is a child task.
-        if (i.get ("parent") == parent)
-          results.push_back (i);
-      }
+        results.push_back (i);
     }
   }
 
@@ -1428,6 +4844,29 @@ int TDB2::id (const std::string& uuid)
   return result;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Ensure the task is consistent, and provide defaults if necessary, and that
+// its uuid is new.  The bool argument to validate() is "applyDefault", which
+// is not done for synchronized tasks.
+void TDB2::verifyNew (Task& task, bool apply_default)
+{
+  bool generated = task.get ("uuid") == "";
+  task.validate (apply_default);
+  std::string uuid = task.get ("uuid");
+
+  // If the tasks are loaded, then verify that this uuid is not already in
+  // the file.  Where the index of an unloaded pending.data shows the uuid is
+  // new, and numbers the new task, the file need never be loaded.  With
+  // data.append, a uuid generated here is new, and the ID is left to the next
+  // command to read the tasks, as concurrent additions would share it.
+  int numbered;
+  if (pending.can_append (uuid, numbered))
+    _id = std::max (_id, numbered + 1);
+  else if (! (generated && Context::getContext ().config.getBoolean ("data.append")) &&
+           ! verifyUniqueUUID (uuid))
+    throw format ("Cannot add task because the uuid '{1}' is not unique.", uuid);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Make sure the specified UUID does not already exist in the data.
 bool TDB2::verifyUniqueUUID (const std::string& uuid)
@@ -1446,6 +4885,20 @@ bool TDB2::read_only ()
          ;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// The peaks are those seen whenever a file is read, and at the end, and are not
+// summed unless perf.output wants them.
+void TDB2::memory ()
+{
+  auto& context = Context::getContext ();
+  if (context.config.get ("perf.output") != "json")
+    return;
+
+  context.memory_tasks = std::max (context.memory_tasks, pending.task_bytes () + completed.task_bytes ());
+  context.memory_lines = std::max (context.memory_lines, pending.line_bytes () + completed.line_bytes ());
+  context.memory_undo  = std::max (context.memory_undo,  undo.line_bytes ()    + backlog.line_bytes ());
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void TDB2::clear ()
 {
@@ -1453,9 +4906,406 @@ void TDB2::clear ()
   completed.clear ();
   undo.clear ();
   backlog.clear ();
+  clear_graph ();
+
+  _batch_before.clear ();
+  _batch_after.clear ();
+  _batch.clear ();
 
   _location = "";
   _id = 1;
+  _changes.clear ();
+  _events_ok = false;
+  _gc_deferred = false;
+  _undo_group = "";
+
+  _rollup_deltas.clear ();
+  _project_deltas.clear ();
+  _tag_deltas.clear ();
+  _rollup_stale = false;
+
+  _federated.clear ();
+  _federated_loaded = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Pending tasks that depend on the given task, and are not completed/deleted.
+const std::vector <Task> TDB2::blocked (const Task& task)
+{
+  build_graph ();
+
+  std::vector <size_t> positions;
+  Uuid key;
+  if (! Uuid::parse (task.get ("uuid"), key))
+    return graph_tasks (positions);
+
+  auto i = _graph_blocked.find (key);
+  if (i != _graph_blocked.end ())
+    for (auto& uuid : i->second)
+      positions.push_back (_graph_position[uuid]);
+
+  return graph_tasks (positions);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Pending tasks that the given task depends on, and are not completed/deleted.
+// The task's own dependencies are used, as it may not yet be committed.
+const std::vector <Task> TDB2::blocking (const Task& task)
+{
+  build_graph ();
+
+  std::vector <size_t> positions;
+  std::vector <Uuid> depends;
+  Uuid::parse_list (task.get ("depends"), depends);
+  for (auto& uuid : depends)
+  {
+    auto i = _graph_position.find (uuid);
+    if (i != _graph_position.end ())
+      positions.push_back (i->second);
+  }
+
+  return graph_tasks (positions);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Dependencies of the task with the given uuid, wherever it is.
+bool TDB2::depends (const Uuid& uuid, std::vector <Uuid>& result)
+{
+  build_graph ();
+
+  auto i = _graph_depends.find (uuid);
+  if (i != _graph_depends.end ())
+  {
+    result = i->second;
+    return true;
+  }
+
+  Task task;
+  if (completed.get (uuid.str (), task))
+  {
+    result.clear ();
+    Uuid::parse_list (task.get ("depends"), result);
+    return true;
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Computes urgency for a set of tasks in one pass.  With urgency.inherit, each
+// pending task's urgency is computed once, after those of the tasks it blocks,
+// instead of once per path through the dependency chain.  The results are
+// cached in the tasks, so that sorting and rendering do no further work.
+void TDB2::urgency (std::vector <Task>& tasks)
+{
+  pending.keep_urgency ();
+
+  if (! Context::getContext ().config.getBoolean ("urgency.inherit"))
+  {
+    for (auto& task : tasks)
+      task.urgency ();
+
+    return;
+  }
+
+  build_graph ();
+
+  std::unordered_map <Uuid, float> memo;
+  Uuid key;
+  for (auto& task : tasks)
+  {
+    if (! task.recalc_urgency)
+      continue;
+
+    // The task itself may differ from its pending copy, so only the tasks it
+    // blocks are taken from the graph.
+    float value = task.urgency_base ();
+    if (task.is_blocking && Uuid::parse (task.get ("uuid"), key))
+    {
+      float inherited = FLT_MIN;
+      auto blocked = _graph_blocked.find (key);
+      if (blocked != _graph_blocked.end ())
+        for (auto& uuid : blocked->second)
+          if (graph_active (uuid))
+            inherited = std::max (inherited, graph_urgency (uuid, memo));
+
+      value = Task::urgency_inherited (value, inherited);
+    }
+
+    task.urgency_value = value;
+    task.recalc_urgency = false;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// True if the uuid is that of a pending task that is not completed/deleted.
+bool TDB2::graph_active (const Uuid& uuid)
+{
+  auto i = _graph_position.find (uuid);
+  if (i == _graph_position.end ())
+    return false;
+
+  auto status = pending._tasks[i->second].getStatus ();
+  return status != Task::completed &&
+         status != Task::deleted;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Urgency, including inheritance, of the pending task with the given uuid.
+// The blocked tasks are visited depth first, and each result is memoized, so
+// that the tasks are computed in reverse topological order.
+float TDB2::graph_urgency (
+  const Uuid& uuid,
+  std::unordered_map <Uuid, float>& memo)
+{
+  auto found = memo.find (uuid);
+  if (found != memo.end ())
+    return found->second;
+
+  // Each entry is a task, and the next of its blocked tasks to visit.  Tasks on
+  // the stack are not revisited, so that a cycle cannot recurse forever.
+  std::vector <std::pair <Uuid, size_t>> stack;
+  std::unordered_set <Uuid> visiting;
+  stack.emplace_back (uuid, 0);
+  visiting.insert (uuid);
+
+  while (! stack.empty ())
+  {
+    auto& top = stack.back ();
+    auto& task = pending._tasks[_graph_position[top.first]];
+
+    const std::vector <Uuid>* blocked = nullptr;
+    if (task.is_blocking)
+    {
+      auto i = _graph_blocked.find (top.first);
+      if (i != _graph_blocked.end ())
+        blocked = &i->second;
+    }
+
+    if (blocked && top.second < blocked->size ())
+    {
+      auto& next = (*blocked)[top.second++];
+      if (graph_active (next) &&
+          memo.find (next) == memo.end () &&
+          visiting.insert (next).second)
+        stack.emplace_back (next, 0);
+
+      continue;
+    }
+
+    float value = task.urgency_base ();
+    if (blocked)
+    {
+      float inherited = FLT_MIN;
+      for (auto& next : *blocked)
+      {
+        auto i = memo.find (next);
+        if (i != memo.end ())
+          inherited = std::max (inherited, i->second);
+      }
+
+      value = Task::urgency_inherited (value, inherited);
+    }
+
+    memo[top.first] = value;
+    visiting.erase (top.first);
+    stack.pop_back ();
+  }
+
+  return memo[uuid];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Tasks at the given positions in pending, in file order, without duplicates
+// and without completed or deleted tasks.
+const std::vector <Task> TDB2::graph_tasks (std::vector <size_t>& positions)
+{
+  std::sort (positions.begin (), positions.end ());
+  positions.erase (std::unique (positions.begin (), positions.end ()), positions.end ());
+
+  std::vector <Task> results;
+  for (auto& position : positions)
+  {
+    auto& task = pending._tasks[position];
+    if (task.getStatus () != Task::completed &&
+        task.getStatus () != Task::deleted)
+      results.push_back (task);
+  }
+
+  return results;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TDB2::build_graph ()
+{
+  if (_graph_built)
+    return;
+
+  auto& tasks = pending.get_tasks ();
+  _graph_position.reserve (tasks.size ());
+  _graph_depends.reserve (tasks.size ());
+
+  Uuid uuid;
+  for (size_t i = 0; i < tasks.size (); ++i)
+  {
+    // The first task with a given uuid wins, as it would for a linear search.
+    if (! Uuid::parse (tasks[i].get ("uuid"), uuid) ||
+        ! _graph_position.emplace (uuid, i).second)
+      continue;
+
+    std::vector <Uuid> depends;
+    Uuid::parse_list (tasks[i].get ("depends"), depends);
+    for (auto& dep : depends)
+      _graph_blocked[dep].push_back (uuid);
+
+    _graph_depends[uuid] = std::move (depends);
+  }
+
+  _graph_built = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Replace the edges of a task just added to, or modified in, pending.
+void TDB2::update_graph (const Task& task)
+{
+  Uuid uuid;
+  if (! _graph_built ||
+      ! Uuid::parse (task.get ("uuid"), uuid))
+    return;
+
+  auto position = _graph_position.find (uuid);
+  if (position == _graph_position.end ())
+  {
+    _graph_position[uuid] = pending._tasks.size () - 1;
+  }
+  else
+  {
+    for (auto& dep : _graph_depends[uuid])
+    {
+      auto& blocked = _graph_blocked[dep];
+      blocked.erase (std::remove (blocked.begin (), blocked.end (), uuid), blocked.end ());
+    }
+  }
+
+  std::vector <Uuid> depends;
+  Uuid::parse_list (task.get ("depends"), depends);
+  for (auto& dep : depends)
+    _graph_blocked[dep].push_back (uuid);
+
+  _graph_depends[uuid] = std::move (depends);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// After a pending task gains or loses dependencies, or changes status, only it,
+// the tasks it depended on before and now, and the tasks that depend on it can
+// change between blocked and blocking.  Their state is recomputed from the
+// graph, as TF2::dependency_scan would find it, rather than scanning the file.
+void TDB2::update_blocking (Task& task, const std::string& before)
+{
+  Uuid uuid;
+  if (! pending._auto_dep_scan ||
+      ! Uuid::parse (task.get ("uuid"), uuid))
+    return;
+
+  build_graph ();
+
+  std::vector <Uuid> affected;
+  Uuid::parse_list (before, affected);
+  affected.push_back (uuid);
+  affected.insert (affected.end (), _graph_depends[uuid].begin (), _graph_depends[uuid].end ());
+  affected.insert (affected.end (), _graph_blocked[uuid].begin (), _graph_blocked[uuid].end ());
+
+  for (auto& next : affected)
+  {
+    auto position = _graph_position.find (next);
+    if (position == _graph_position.end ())
+      continue;
+
+    bool active = graph_active (next);
+    bool blocked = false;
+    bool blocking = false;
+    if (active)
+    {
+      for (auto& dep : _graph_depends[next])
+        blocked = blocked || graph_active (dep);
+
+      for (auto& dependent : _graph_blocked[next])
+        blocking = blocking || graph_active (dependent);
+    }
+
+    auto& other = pending._tasks[position->second];
+    if (other.is_blocked != blocked || other.is_blocking != blocking)
+    {
+      other.is_blocked = blocked;
+      other.is_blocking = blocking;
+      other.recalc_urgency = true;
+    }
+
+    if (next == uuid)
+    {
+      task.is_blocked = blocked;
+      task.is_blocking = blocking;
+      task.recalc_urgency = true;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TDB2::clear_graph ()
+{
+  _graph_position.clear ();
+  _graph_depends.clear ();
+  _graph_blocked.clear ();
+  _graph_built = false;
+
+  _ready.clear ();
+  _ready_entries.clear ();
+  _ready_built = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The highest urgency of the pending tasks that are READY, as compared by the
+// nag.  The urgencies are computed in one pass by TDB2::urgency, then kept as
+// tasks are added and modified.
+float TDB2::ready_urgency ()
+{
+  if (! _ready_built)
+  {
+    pending.get_tasks ();
+    urgency (pending._tasks);
+
+    _ready_built = true;
+    for (auto& task : pending._tasks)
+      update_ready (task);
+  }
+
+  if (_ready.empty ())
+    return std::numeric_limits <float>::lowest ();
+
+  return *_ready.rbegin ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Replace the urgency of a task just added to, or modified in, pending.
+void TDB2::update_ready (Task& task)
+{
+  Uuid uuid;
+  if (! _ready_built ||
+      ! Uuid::parse (task.get ("uuid"), uuid))
+    return;
+
+  auto found = _ready_entries.find (uuid);
+  if (found != _ready_entries.end ())
+  {
+    _ready.erase (found->second);
+    _ready_entries.erase (found);
+  }
+
+  auto status = task.getStatus ();
+  if ((status == Task::pending ||
+       status == Task::waiting) &&
+      task.hasTag ("READY"))
+    _ready_entries[uuid] = _ready.insert (task.urgency ());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
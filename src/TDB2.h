@@ -27,7 +27,9 @@
 #ifndef INCLUDED_TDB2
 #define INCLUDED_TDB2
 
+#include <functional>
 #include <map>
+#include <set>
 #include <unordered_set>
 #include <unordered_map>
 #include <vector>
@@ -35,6 +37,10 @@
 #include <stdio.h>
 #include <FS.h>
 #include <Task.h>
+#include <TF2Index.h>
+#include <Uuid.h>
+
+struct TaskColumns;
 
 // TF2 Class represents a single file in the task database.
 class TF2
@@ -46,24 +52,36 @@ public:
   void target (const std::string&);
 
   const std::vector <Task>&        get_tasks ();
+  const std::vector <Task>&        get_tasks (const TF2Index::Bounds&);
   const std::vector <std::string>& get_lines ();
+  void get_transaction (std::vector <std::string>&, uint64_t&);
+  int count_lines (const std::string&);
+  void snapshot ();
 
   bool get (int, Task&);
   bool get (const std::string&, Task&);
+  const Task* find (const std::string&);
   bool has (const std::string&);
+  bool can_append (const std::string&, int&);
+  void children (const std::string&, std::vector <size_t>&);
+  void index_child (const Task&);
 
-  void add_task (Task&);
-  bool modify_task (const Task&);
+  void add_task (Task&, const std::string& composed = "");
+  bool modify_task (const Task&, const std::string& composed = "");
   bool purge_task (const Task&);
   void add_line (const std::string&);
   void clear_tasks ();
   void clear_lines ();
-  void commit ();
+  void commit (bool concurrent = false);
+  bool adds_only () const;
+  bool stage (std::string&);
+  void written ();
 
   Task load_task (const std::string&);
   void load_gc (Task&);
   void load_tasks (bool from_gc = false);
   void load_lines ();
+  bool stream (const std::function <bool (const std::vector <Task>&)>&);
 
   // ID <--> UUID mapping.
   std::string uuid (int);
@@ -71,10 +89,20 @@ public:
 
   void has_ids ();
   void auto_dep_scan ();
+  void use_index ();
+  void end_order ();
   void clear ();
   const std::string dump ();
 
   void dependency_scan ();
+  bool journal_ok (size_t);
+  bool check_index (bool, std::string&);
+  void compact (uint64_t);
+  bool holds_pending ();
+  void columns (TaskColumns&);
+  void keep_urgency ();
+  long task_bytes () const;
+  long line_bytes () const;
 
   bool _read_only;
   bool _dirty;
@@ -82,23 +110,131 @@ public:
   bool _loaded_lines;
   bool _has_ids;
   bool _auto_dep_scan;
+  bool _use_index;
+  bool _end_order;
   std::vector <Task> _tasks;
 
-  // _tasks_map was introduced mainly for speeding up "task import".
-  // Iterating over all _tasks for each imported task is slow, making use of
-  // appropriate data structures is fast.
-  std::unordered_map <std::string, Task> _tasks_map;
-
   std::vector <Task> _added_tasks;
-  std::vector <Task> _modified_tasks;
-  std::unordered_set <std::string> _purged_tasks;
+  std::vector <Task> _modified_tasks;       // Modified before the file was loaded
+  std::set <size_t> _modified;              // Positions in _tasks modified
+  std::unordered_set <Uuid> _purged_tasks;
+  std::unordered_map <Uuid, std::string> _composed; // F4 of added or modified tasks
   std::vector <std::string> _lines;
   std::vector <std::string> _added_lines;
   File _file;
 
 private:
+  void keep_composed (const Task&, const std::string&);
+  std::string compose (const Task&, const Uuid&) const;
+  bool index_ok ();
+  void lock (bool);
+  bool replace (const std::string&);
+  bool append (const std::string&);
+  bool map_lines ();
+  void* map_file (size_t&);
+  void parse_lines (std::vector <Task>&, std::vector <char>&);
+  void supersede (std::vector <Task>&);
+  void assign_id (Task&);
+  bool index_numbers ();
+  void index_tasks ();
+  bool position (const std::string&, size_t&);
+
+private:
+  TF2Index _index;
+  bool _staged_index;                         // Index to save once written
+  std::vector <Task> _partial;                // Tasks from a partial read
+  size_t _superseded;                         // Journaled records replaced
+  long long _snapshot;                        // Size read, if a snapshot
+  bool _held;                                 // Open and locked, by a commit or a stream
+  size_t _bom;                                // Bytes of a byte order mark, before the first line
   std::unordered_map <int, std::string> _I2U; // ID -> UUID map
   std::unordered_map <std::string, int> _U2I; // UUID -> ID map
+  std::unordered_map <Uuid, size_t> _positions; // UUID -> position in _tasks
+  std::unordered_multimap <Uuid, size_t> _children; // Parent UUID -> position in _tasks
+  size_t _indexed;                            // Positions of _tasks indexed so far
+  bool _unparsed;                             // Some UUID text did not parse
+  int _numbered;                              // Tasks numbered, if added before load
+  int _index_gc;                              // The run_gc of _index_ids, or -1
+  std::vector <size_t> _index_ids;            // ID - 1 -> latest index entry
+  std::unordered_map <Uuid, int> _index_uuids; // UUID -> ID, from the index
+};
+
+// Tasks entered and ended on one day, as counted by the history reports, and
+// kept in rollup.data.
+struct RollupDay
+{
+  int added     {0};   // Entered, excluding templates
+  int templates {0};   // Templates entered
+  int completed {0};
+  int deleted   {0};
+};
+
+// Tasks in one project, as counted by the project feedback, and kept in
+// projects.data, or with one tag, kept in tags.data.
+struct ProjectCount
+{
+  int pending   {0};   // Pending or waiting
+  int done      {0};   // Completed
+  int templates {0};   // Recurring templates
+  int deleted   {0};
+};
+
+// The fields of tasks that the burndown charts count, one array per field,
+// rather than a Task per task.  Dates are epochs, and 0 where not set.
+struct TaskColumns
+{
+  std::vector <Task::status> status;
+  std::vector <time_t>       entry;
+  std::vector <time_t>       start;
+  std::vector <time_t>       end;
+
+  void add (const Task&);
+  void add (Task::status, time_t, time_t, time_t);
+  size_t size () const { return status.size (); }
+};
+
+// Candidates for the shell completion helpers, kept in completion.data.
+struct Completions
+{
+  std::vector <int>      ids;            // As numbered after a GC
+  std::set <std::string> projects;       // Of tasks neither completed nor deleted
+  std::set <std::string> done_projects;  // Of completed and deleted tasks
+  std::set <std::string> tags;           // Of all tasks
+};
+
+// The tasks of two files, the first then the second, viewed in place rather
+// than copied.  The view is invalidated by adding a task to either file.
+class TaskRange
+{
+public:
+  class iterator
+  {
+  public:
+    iterator (const TaskRange& range, size_t index) : _range (range), _index (index) {}
+    const Task& operator* () const                 { return _range[_index]; }
+    const Task* operator-> () const                { return &_range[_index]; }
+    iterator& operator++ ()                        { ++_index; return *this; }
+    bool operator== (const iterator& other) const  { return _index == other._index; }
+    bool operator!= (const iterator& other) const  { return _index != other._index; }
+
+  private:
+    const TaskRange& _range;
+    size_t _index;
+  };
+
+  TaskRange (const std::vector <Task>& first, const std::vector <Task>& second) : _first (first), _second (second) {}
+  size_t size () const                             { return _first.size () + _second.size (); }
+  iterator begin () const                          { return iterator (*this, 0); }
+  iterator end () const                            { return iterator (*this, size ()); }
+
+  const Task& operator[] (size_t index) const
+  {
+    return index < _first.size () ? _first[index] : _second[index - _first.size ()];
+  }
+
+private:
+  const std::vector <Task>& _first;
+  const std::vector <Task>& _second;
 };
 
 // TDB2 Class represents all the files in the task database.
@@ -110,23 +246,39 @@ public:
   TDB2 ();
 
   void set_location (const std::string&);
+  void prefetch ();
   void add (Task&, bool add_to_backlog = true);
+  void add (std::vector <Task>&);
   void modify (Task&, bool add_to_backlog = true);
   void purge (Task&);
   void commit ();
+  void snapshot ();
+  void apply_batch ();
   void get_changes (std::vector <Task>&);
   void revert ();
-  void gc ();
+  void gc (bool in_memory = false);
   int  next_id ();
+  void next_id (int);
   int  latest_id ();
 
   // Generalized task accessors.
-  const std::vector <Task> all_tasks ();
+  TaskRange all_tasks ();
+
+  // The tasks of the other data locations in data.sources, read-only.
+  const std::vector <Task>& federated ();
   bool get (int, Task&);
   bool get (const std::string&, Task&);
   bool has (const std::string&);
-  const std::vector <Task> siblings (Task&);
-  const std::vector <Task> children (Task&);
+  std::vector <Task> siblings (Task&);
+  std::vector <Task> children (Task&);
+  std::vector <Task> templates ();
+
+  // Dependency graph of pending tasks.
+  const std::vector <Task> blocked (const Task&);
+  const std::vector <Task> blocking (const Task&);
+  bool depends (const Uuid&, std::vector <Uuid>&);
+  void urgency (std::vector <Task>&);
+  float ready_urgency ();
 
   // ID <--> UUID mapping.
   std::string uuid (int);
@@ -135,18 +287,82 @@ public:
   // Read-only mode.
   bool read_only ();
 
+  // Whether a recurrence, or an until date, may have come due.
+  bool events_due ();
+  bool expiry_due ();
+
+  // Changes in backlog.data not yet synced.
+  int backlog_count ();
+
+  // Completion candidates of all tasks, kept up to date by commit.
+  bool completions (Completions&);
+
+  // The burndown fields of all tasks.
+  void columns (TaskColumns&);
+
+  // The transactions in undo.data that changed the given task.
+  void undo_history (const std::string&, std::vector <std::string>&);
+
+  // Per-day counts of all tasks, kept up to date by commit.
+  bool get_rollup (std::map <time_t, RollupDay>&);
+  void save_rollup (const std::map <time_t, RollupDay>&);
+  static void rollup_count (std::map <time_t, RollupDay>&, const Task&, int);
+
+  // Per-project and per-tag counts of all tasks, kept up to date by commit.
+  void project_counts (const std::string&, int&, int&);
+  void counts (const std::string&, std::map <std::string, ProjectCount>&);
+  static void project_count (std::map <std::string, ProjectCount>&, const Task&, int);
+  static void tag_count (std::map <std::string, ProjectCount>&, const Task&, int);
+
+  // The peak bytes held by the files, for perf.output.
+  void memory ();
+
   void clear ();
   void dump ();
 
 private:
   void gather_changes ();
+  bool uses_backlog ();
+  void commit_atomic ();
+  int lock_data (bool);
+  void unlock_data (int, bool);
+  void next_events (time_t&, time_t&);
+  void save_events (time_t, time_t);
+  bool read_events (time_t&, time_t&);
+  bool read_backlog_count (int&);
+  void write_backlog_count (int);
+  bool undo_indexed (uint64_t);
+  void index_undo (uint64_t, const std::vector <std::string>&);
+  void build_undo_index ();
+  void truncate_undo_index (uint64_t, uint64_t);
+  void expand_undo (std::vector <std::string>&);
+  std::string data_stamp ();
+  bool read_rollup (std::map <time_t, RollupDay>&);
+  void write_rollup (const std::map <time_t, RollupDay>&);
+  bool read_counts (const std::string&, std::map <std::string, ProjectCount>&);
+  void write_counts (const std::string&, const std::map <std::string, ProjectCount>&);
+  void gather_completions (Completions&);
+  bool read_completions (Completions&);
+  void write_completions (const Completions&);
+  std::string undo_time ();
   void update (Task&, const bool, const bool addition = false);
   bool verifyUniqueUUID (const std::string&);
+  void verifyNew (Task&, bool);
   void show_diff (const std::string&, const std::string&, const std::string&);
+  TF2* revert_file (const std::string&, const std::string&);
+  void supersede_lines (std::vector <std::string>&);
   void revert_undo (std::vector <std::string>&, std::string&, std::string&, std::string&, std::string&);
   void revert_pending (std::vector <std::string>&, const std::string&, const std::string&);
   void revert_completed (std::vector <std::string>&, std::vector <std::string>&, const std::string&, const std::string&);
   void revert_backlog (std::vector <std::string>&, const std::string&, const std::string&, const std::string&);
+  void build_graph ();
+  void update_graph (const Task&);
+  void update_blocking (Task&, const std::string&);
+  void clear_graph ();
+  void update_ready (Task&);
+  const std::vector <Task> graph_tasks (std::vector <size_t>&);
+  bool graph_active (const Uuid&);
+  float graph_urgency (const Uuid&, std::unordered_map <Uuid, float>&);
 
 public:
   TF2 pending;
@@ -158,6 +374,39 @@ private:
   std::string        _location;
   int                _id;
   std::vector <Task> _changes;
+  bool               _events_ok;
+  bool               _gc_deferred;
+  unsigned long long _generation;
+  std::string        _undo_group;
+
+  // Changes to the per-day, per-project and per-tag counts since the last
+  // commit, and whether some change, such as an undo, was not counted.
+  std::map <time_t, RollupDay>           _rollup_deltas;
+  std::map <std::string, ProjectCount>   _project_deltas;
+  std::map <std::string, ProjectCount>   _tag_deltas;
+  bool                                   _rollup_stale;
+
+  // Modifications held for the on-modify-batch hooks, in order, with the
+  // position of each by uuid.
+  std::vector <Task>                        _batch_before;
+  std::vector <Task>                        _batch_after;
+  std::unordered_map <std::string, size_t>  _batch;
+
+  // Forward and reverse dependency edges between pending tasks, by uuid, and
+  // the position of each task in pending._tasks.
+  bool                                                         _graph_built;
+  std::unordered_map <Uuid, size_t>                            _graph_position;
+  std::unordered_map <Uuid, std::vector <Uuid>>                _graph_depends;
+  std::unordered_map <Uuid, std::vector <Uuid>>                _graph_blocked;
+
+  // The urgencies of the READY pending tasks, and the entry of each by uuid.
+  bool                                                         _ready_built;
+  std::multiset <float>                                        _ready;
+  std::unordered_map <Uuid, std::multiset <float>::iterator>   _ready_entries;
+
+  // The tasks of data.sources, loaded on demand.
+  bool                                                         _federated_loaded;
+  std::vector <Task>                                           _federated;
 };
 
 #endif
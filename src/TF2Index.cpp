@@ -0,0 +1,784 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cmake.h>
+#include <TF2Index.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// The on-disk layout is a header followed by a packed array of entries, then
+// the project dictionary, each project as its length and its bytes.  It is
+// written in native byte order, as it is a cache that is only ever read back by
+// the machine that wrote it, and is rebuilt whenever it does not match.
+static const char index_magic[4] = {'T', 'W', 'X', '6'};
+
+// Entries per segment.
+#define SEGMENT_SIZE 256
+
+struct Header
+{
+  char     magic[4];
+  uint32_t count;
+  uint64_t size;
+  int64_t  mtime;
+  int64_t  nsec;
+  uint64_t inode;
+  uint32_t projects;
+  uint32_t pad;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Locate the value of an F4 attribute, which is always preceded by either the
+// opening '[' or a separating ' '.  Returns npos when not found.
+static std::string::size_type findAttribute (
+  const std::string& line,
+  const std::string& name)
+{
+  auto pattern = name + ":\"";
+  auto pos = line.find (pattern);
+  while (pos != std::string::npos)
+  {
+    if (pos > 0 && (line[pos - 1] == '[' || line[pos - 1] == ' '))
+      return pos + pattern.length ();
+
+    pos = line.find (pattern, pos + 1);
+  }
+
+  return std::string::npos;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The extended range [low, high] of a value that may be absent, shown as zero.
+static void extend (int64_t value, int64_t& low, int64_t& high, bool& missing)
+{
+  if (value == 0)
+    missing = true;
+  else
+  {
+    low  = std::min (low,  value);
+    high = std::max (high, value);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Whether the range [low, high] of present values lies outside [min, max].  An
+// absent value is not known to lie outside, so is never excluded.
+static bool outside (
+  int64_t low, int64_t high, bool missing,
+  int64_t min, int64_t max)
+{
+  if (missing || (min == INT64_MIN && max == INT64_MAX))
+    return false;
+
+  return high < min || low > max;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Sets a bit of the signature for every trigram of letters and digits in text,
+// compared caseless.  Other characters, which may be stored encoded, are never
+// part of a trigram.
+static void trigrams (const std::string& text, uint64_t* signature)
+{
+  unsigned int hash = 0;
+  int run = 0;
+  for (auto c : text)
+  {
+    if (! isalnum ((unsigned char) c))
+    {
+      run = 0;
+      continue;
+    }
+
+    hash = ((hash << 8) | (unsigned char) tolower ((unsigned char) c)) & 0xFFFFFF;
+    if (++run >= 3)
+    {
+      auto bit = (hash * 2654435761u) >> 25;
+      signature[bit >> 6] |= (uint64_t) 1 << (bit & 63);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Whether a signature lacks a trigram of any of the words, so that the text it
+// describes cannot hold them all.
+static bool lacks (const uint64_t* signature, const std::vector <std::string>& words)
+{
+  for (auto& word : words)
+  {
+    uint64_t wanted[2] {0, 0};
+    trigrams (word, wanted);
+    if ((signature[0] & wanted[0]) != wanted[0] ||
+        (signature[1] & wanted[1]) != wanted[1])
+      return true;
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Adds the trigrams of the description and of every annotation, as stored.
+static void textAttributes (const std::string& line, uint64_t* signature)
+{
+  auto pos = findAttribute (line, "description");
+  if (pos != std::string::npos)
+    trigrams (line.substr (pos, line.find ('"', pos) - pos), signature);
+
+  for (pos = line.find ("annotation_"); pos != std::string::npos; pos = line.find ("annotation_", pos + 1))
+  {
+    if (pos == 0 || (line[pos - 1] != '[' && line[pos - 1] != ' '))
+      continue;
+
+    auto start = line.find (":\"", pos);
+    if (start == std::string::npos)
+      break;
+
+    start += 2;
+    trigrams (line.substr (start, line.find ('"', start) - start), signature);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static int64_t dateAttribute (const std::string& line, const std::string& name)
+{
+  auto pos = findAttribute (line, name);
+  if (pos != std::string::npos)
+    return (int64_t) strtoll (line.c_str () + pos, nullptr, 10);
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TF2Index::target (const std::string& file)
+{
+  _data_file  = file;
+  _index_file = file + ".idx";
+  clear ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reads the index from disk, and returns true only if it describes the current
+// state of the data file.
+bool TF2Index::load ()
+{
+  if (_loaded)
+    return _valid;
+
+  _loaded = true;
+  _valid  = false;
+  _entries.clear ();
+  _projects.clear ();
+  _codes.clear ();
+
+  Stamp current;
+  if (! stamp (current))
+    return false;
+
+  FILE* in = fopen (_index_file.c_str (), "rb");
+  if (! in)
+    return false;
+
+  Header header;
+  if (fread (&header, sizeof (header), 1, in) == 1 &&
+      memcmp (header.magic, index_magic, sizeof (index_magic)) == 0 &&
+      header.size  == current.size  &&
+      header.mtime == current.mtime &&
+      header.nsec  == current.nsec  &&
+      header.inode == current.inode)
+  {
+    _entries.resize (header.count);
+    bool ok = header.count == 0 ||
+              fread (&_entries[0], sizeof (Entry), header.count, in) == header.count;
+
+    for (uint32_t i = 0; ok && i < header.projects; ++i)
+    {
+      uint32_t length;
+      std::string project;
+      if ((ok = fread (&length, sizeof (length), 1, in) == 1))
+      {
+        project.resize (length);
+        ok = length == 0 || fread (&project[0], 1, length, in) == length;
+      }
+
+      _codes[project] = i + 1;
+      _projects.push_back (project);
+    }
+
+    for (size_t i = 0; ok && i < _entries.size (); ++i)
+      ok = _entries[i].project <= _projects.size ();
+
+    if (ok)
+    {
+      _valid = true;
+      _stamp = current;
+    }
+    else
+    {
+      _entries.clear ();
+      _projects.clear ();
+      _codes.clear ();
+    }
+  }
+
+  summarize ();
+
+  fclose (in);
+  return _valid;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Writes the index, stamped with the current size, mtime and inode of the data
+// file.
+// Must therefore be called after the data file is written.
+bool TF2Index::save ()
+{
+  Stamp current;
+  if (! stamp (current))
+    return false;
+
+  FILE* out = fopen (_index_file.c_str (), "wb");
+  if (! out)
+    return false;
+
+  Header header;
+  memcpy (header.magic, index_magic, sizeof (index_magic));
+  header.count    = (uint32_t) _entries.size ();
+  header.size     = current.size;
+  header.mtime    = current.mtime;
+  header.nsec     = current.nsec;
+  header.inode    = current.inode;
+  header.projects = (uint32_t) _projects.size ();
+  header.pad      = 0;
+
+  bool ok = fwrite (&header, sizeof (header), 1, out) == 1 &&
+            (_entries.size () == 0 ||
+             fwrite (&_entries[0], sizeof (Entry), _entries.size (), out) == _entries.size ());
+
+  for (auto& project : _projects)
+  {
+    uint32_t length = (uint32_t) project.length ();
+    ok = ok &&
+         fwrite (&length, sizeof (length), 1, out) == 1 &&
+         fwrite (project.data (), 1, length, out) == length;
+  }
+
+  if (fclose (out) != 0 || ! ok)
+  {
+    unlink (_index_file.c_str ());
+    return false;
+  }
+
+  _loaded = true;
+  _valid  = true;
+  _stamp  = current;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TF2Index::~TF2Index ()
+{
+  close ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TF2Index::clear ()
+{
+  close ();
+  _entries.clear ();
+  _segments.clear ();
+  _projects.clear ();
+  _codes.clear ();
+  _lead        = 0;
+  _end_ordered = true;
+  _loaded = false;
+  _valid  = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TF2Index::valid () const
+{
+  return _valid;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Recompute all entries from the lines of the data file, as read from disk,
+// the first of which is at the offset.
+void TF2Index::build (const std::vector <std::string>& lines, uint64_t offset /* = 0 */)
+{
+  _entries.clear ();
+  _entries.reserve (lines.size ());
+  _projects.clear ();
+  _codes.clear ();
+
+  for (auto& line : lines)
+  {
+    _entries.push_back (code (line, offset));
+    offset += line.length () + 1;
+  }
+
+  summarize ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TF2Index::append (const std::string& line, uint64_t offset)
+{
+  _entries.push_back (code (line, offset));
+  summarize ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Discard the index, both in memory and on disk, so that a stale copy cannot be
+// mistaken for a current one.
+void TF2Index::invalidate ()
+{
+  close ();
+  _entries.clear ();
+  _segments.clear ();
+  _projects.clear ();
+  _codes.clear ();
+  _lead        = 0;
+  _end_ordered = true;
+  _loaded = true;
+  _valid  = false;
+  unlink (_index_file.c_str ());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Record the static urgency of the task at the given position, computed with
+// the given Task::urgencyKey.
+void TF2Index::urgency (size_t position, float value, uint32_t key)
+{
+  if (position < _entries.size ())
+  {
+    _entries[position].urgency     = value;
+    _entries[position].urgency_key = key;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Writes the index again, after entries have changed, but only while the data
+// file is still the one it was loaded or saved for.
+bool TF2Index::refresh ()
+{
+  Stamp current;
+  if (! _valid || ! stamp (current) || ! (current == _stamp))
+    return false;
+
+  return save ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// A journaled file may hold several records for a task, so the search is from
+// the end, for the current one.
+const TF2Index::Entry* TF2Index::find (const std::string& uuid) const
+{
+  if (_valid && uuid.length () == 36)
+    for (auto entry = _entries.rbegin (); entry != _entries.rend (); ++entry)
+      if (memcmp (entry->uuid, uuid.data (), 36) == 0)
+        return &*entry;
+
+  return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const std::vector <TF2Index::Entry>& TF2Index::entries () const
+{
+  return _entries;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const std::vector <TF2Index::Segment>& TF2Index::segments () const
+{
+  return _segments;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The positions of the segments that may hold a task within the bounds.  Where
+// the segments are ordered by end, only those leading, which hold a task
+// without end, and those overlapping the range of end, are tested.  The limits
+// of a union of alternatives span them all, so the range holds for each.
+std::vector <size_t> TF2Index::candidates (const Bounds& bounds) const
+{
+  std::vector <size_t> result;
+  auto test = [&] (size_t i)
+  {
+    if (! disjoint (_segments[i], bounds))
+      result.push_back (i);
+  };
+
+  if (! _end_ordered)
+  {
+    for (size_t i = 0; i < _segments.size (); ++i)
+      test (i);
+
+    return result;
+  }
+
+  for (size_t i = 0; i < _lead; ++i)
+    test (i);
+
+  auto first = std::partition_point (_segments.begin () + _lead, _segments.end (),
+                                     [&bounds] (const Segment& s) { return s.end_max < bounds.end_min; });
+  auto last  = std::partition_point (first, _segments.end (),
+                                     [&bounds] (const Segment& s) { return s.end_min <= bounds.end_max; });
+  for (auto s = first; s != last; ++s)
+    test (s - _segments.begin ());
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Opens the data file for a run of reads, which then share the one descriptor,
+// rather than each opening the file, which on a network file system is a round
+// trip.  The reads skip about, so read-ahead is not wanted.
+bool TF2Index::open () const
+{
+  if (_fd != -1)
+    return true;
+
+  _fd = ::open (_data_file.c_str (), O_RDONLY);
+  if (_fd == -1)
+    return false;
+
+#ifdef POSIX_FADV_RANDOM
+  posix_fadvise (_fd, 0, 0, POSIX_FADV_RANDOM);
+#endif
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TF2Index::close () const
+{
+  if (_fd != -1)
+  {
+    ::close (_fd);
+    _fd = -1;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reads length bytes at the offset of the data file, within a run of reads if
+// one is open, otherwise opening the file for this read alone.
+bool TF2Index::read (uint64_t offset, size_t length, std::string& text) const
+{
+  bool opened = _fd == -1;
+  if (opened && ! open ())
+    return false;
+
+  text.resize (length);
+  size_t done = 0;
+  while (done < length)
+  {
+    auto n = pread (_fd, &text[done], length - done, (off_t) (offset + done));
+    if (n <= 0)
+      break;
+
+    done += n;
+  }
+
+  if (opened)
+    close ();
+
+  return done == length;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Read the single line described by entry from the data file.  The line is
+// verified to contain the expected uuid, which guards against the unlikely case
+// of a data file modified without changing its size, mtime or inode, on a file
+// system that keeps only whole seconds.
+bool TF2Index::read (const Entry& entry, std::string& line) const
+{
+  return read (entry.offset, entry.length, line) &&
+         line.find ("uuid:\"" + std::string (entry.uuid, 36) + '"') != std::string::npos;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Read the lines of a segment, which are contiguous in the data file, with a
+// single read.  Each line is then at its entry offset, less that of the first.
+bool TF2Index::read (const Segment& segment, std::string& text) const
+{
+  if (segment.count == 0)
+    return false;
+
+  auto& first = _entries[segment.first];
+  auto& last  = _entries[segment.first + segment.count - 1];
+  return read (first.offset, last.offset + last.length - first.offset, text);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Extract the indexed attributes directly from an F4 line, without a full
+// parse.  The project is not coded, as there is no dictionary.
+TF2Index::Entry TF2Index::parse (const std::string& line, uint64_t offset)
+{
+  return parse (line, offset, nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Parse the line, coding its project in the dictionary of the index.
+TF2Index::Entry TF2Index::code (const std::string& line, uint64_t offset)
+{
+  std::string project;
+  auto entry = parse (line, offset, &project);
+  if (project != "")
+  {
+    auto found = _codes.emplace (project, (uint32_t) _projects.size () + 1);
+    if (found.second)
+      _projects.push_back (project);
+
+    entry.project = found.first->second;
+  }
+
+  return entry;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The project of an entry, as stored, or empty.
+const std::string& TF2Index::project (const Entry& entry) const
+{
+  static const std::string none;
+  return entry.project ? _projects[entry.project - 1] : none;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TF2Index::Entry TF2Index::parse (const std::string& line, uint64_t offset, std::string* stored)
+{
+  Entry entry;
+  memset (&entry, 0, sizeof (entry));
+  entry.offset = offset;
+  entry.length = (uint32_t) line.length ();
+
+  auto pos = findAttribute (line, "uuid");
+  if (pos != std::string::npos && pos + 36 <= line.length ())
+    memcpy (entry.uuid, line.data () + pos, 36);
+
+  pos = findAttribute (line, "status");
+  entry.status = pos != std::string::npos && pos < line.length () ? line[pos] : 'p';
+
+  // Only a plain project is known exactly.  One that holds an escape or
+  // entity may not compare as the decoded value would.
+  pos = findAttribute (line, "project");
+  if (pos != std::string::npos)
+  {
+    auto end = line.find ('"', pos);
+    auto project = line.substr (pos, end == std::string::npos ? std::string::npos : end - pos);
+    if (project.find_first_of ("\\&") != std::string::npos)
+      entry.flags |= project_inexact;
+
+    if (stored)
+      *stored = project;
+  }
+
+  entry.entry    = dateAttribute (line, "entry");
+  entry.end      = dateAttribute (line, "end");
+  entry.modified = dateAttribute (line, "modified");
+
+  textAttributes (line, entry.text);
+
+  return entry;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Whether no task in the segment can lie within the bounds.  A project prefix
+// can only be ruled out if every project in the segment is known exactly.
+bool TF2Index::disjoint (const Segment& segment, const Bounds& bounds)
+{
+  if (bounds.none)
+    return true;
+
+  if (! bounds.either.empty ())
+  {
+    for (auto& alternative : bounds.either)
+      if (! disjoint (segment, alternative))
+        return false;
+
+    return true;
+  }
+
+  if (bounds.statuses != "" &&
+      segment.statuses.find_first_of (bounds.statuses) == std::string::npos)
+    return true;
+
+  if (outside (segment.entry_min, segment.entry_max, segment.entry_missing,
+               bounds.entry_min, bounds.entry_max) ||
+      outside (segment.end_min, segment.end_max, segment.end_missing,
+               bounds.end_min, bounds.end_max) ||
+      outside (segment.modified_min, segment.modified_max, segment.modified_missing,
+               bounds.modified_min, bounds.modified_max))
+    return true;
+
+  auto& prefix = bounds.project;
+  if (prefix != "" && segment.projects_exact)
+  {
+    // Every project lies in [project_min, project_max], and every match is at
+    // least the prefix, and begins with it.
+    if (! segment.projects_present                                  ||
+        segment.project_max < prefix                                ||
+        segment.project_min.compare (0, prefix.length (), prefix) > 0)
+      return true;
+  }
+
+  return lacks (segment.text, bounds.words);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Whether the task of an entry cannot lie within the bounds, which is the test
+// of TF2Index::disjoint for a single task, and of its uuid.
+bool TF2Index::excludes (const Entry& entry, const Bounds& bounds) const
+{
+  if (! bounds.none && ! bounds.either.empty ())
+  {
+    for (auto& alternative : bounds.either)
+      if (! excludes (entry, alternative))
+        return false;
+
+    return true;
+  }
+
+  if (bounds.none ||
+      (bounds.statuses != "" &&
+       bounds.statuses.find (entry.status) == std::string::npos))
+    return true;
+
+  if (outside (entry.entry,    entry.entry,    entry.entry    == 0, bounds.entry_min,    bounds.entry_max) ||
+      outside (entry.end,      entry.end,      entry.end      == 0, bounds.end_min,      bounds.end_max)   ||
+      outside (entry.modified, entry.modified, entry.modified == 0, bounds.modified_min, bounds.modified_max))
+    return true;
+
+  auto& prefix = bounds.project;
+  if (prefix != "" &&
+      ! (entry.flags & project_inexact) &&
+      project (entry).compare (0, prefix.length (), prefix) != 0)
+    return true;
+
+  if (! bounds.any_uuid)
+  {
+    for (auto& uuid : bounds.uuids)
+      if (uuid.length () <= sizeof (entry.uuid) &&
+          memcmp (entry.uuid, uuid.data (), uuid.length ()) == 0)
+        return false;
+
+    return true;
+  }
+
+  return lacks (entry.text, bounds.words);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Bring the segments up to date with the entries, which only ever grow, or are
+// rebuilt from scratch.
+void TF2Index::summarize ()
+{
+  size_t done = 0;
+  if (_segments.size ())
+  {
+    // The last segment may be partial, so is summarized again.
+    _segments.pop_back ();
+    done = _segments.size () * SEGMENT_SIZE;
+  }
+
+  for (auto first = done; first < _entries.size (); first += SEGMENT_SIZE)
+  {
+    Segment segment {};
+    segment.first          = first;
+    segment.count          = std::min ((size_t) SEGMENT_SIZE, _entries.size () - first);
+    segment.entry_min      = segment.end_min      = segment.modified_min = INT64_MAX;
+    segment.entry_max      = segment.end_max      = segment.modified_max = INT64_MIN;
+    segment.projects_exact = true;
+
+    for (auto i = first; i < first + segment.count; ++i)
+    {
+      auto& entry = _entries[i];
+      extend (entry.entry,    segment.entry_min,    segment.entry_max,    segment.entry_missing);
+      extend (entry.end,      segment.end_min,      segment.end_max,      segment.end_missing);
+      extend (entry.modified, segment.modified_min, segment.modified_max, segment.modified_missing);
+
+      if (entry.flags & project_inexact)
+        segment.projects_exact = false;
+
+      if (segment.statuses.find (entry.status) == std::string::npos)
+        segment.statuses += entry.status;
+
+      segment.text[0] |= entry.text[0];
+      segment.text[1] |= entry.text[1];
+
+      if (entry.project)
+      {
+        auto& project = _projects[entry.project - 1];
+        if (! segment.projects_present || project < segment.project_min)
+          segment.project_min = project;
+        if (! segment.projects_present || project > segment.project_max)
+          segment.project_max = project;
+
+        segment.projects_present = true;
+      }
+    }
+
+    _segments.push_back (segment);
+  }
+
+  // Extending a segment cannot restore the order, or end its lead, so only the
+  // segments just summarized are checked.
+  auto from = done / SEGMENT_SIZE;
+  _lead = std::min (_lead, from);
+  for (auto i = from; i < _segments.size (); ++i)
+  {
+    auto& segment = _segments[i];
+    if (i == _lead && segment.end_missing)
+      ++_lead;
+    else if (segment.end_missing ||
+             (i > _lead && segment.end_min < _segments[i - 1].end_max))
+      _end_ordered = false;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// A write within the same second that keeps the size, such as one date replaced
+// by another, changes the nanoseconds of the mtime, and a replaced file changes
+// the inode.
+bool TF2Index::stamp (Stamp& current) const
+{
+  struct stat s;
+  if (stat (_data_file.c_str (), &s) == -1)
+    return false;
+
+  current.size  = (uint64_t) s.st_size;
+  current.mtime = (int64_t) s.st_mtime;
+#if defined (DARWIN)
+  current.nsec  = (int64_t) s.st_mtimespec.tv_nsec;
+#else
+  current.nsec  = (int64_t) s.st_mtim.tv_nsec;
+#endif
+  current.inode = (uint64_t) s.st_ino;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef INCLUDED_TF2INDEX
+#define INCLUDED_TF2INDEX
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+#include <time.h>
+
+// TF2Index is a sidecar index for a single TF2 data file.  It records the byte
+// offset and a few key attributes of every line, so that a task can be located
+// and parsed without reading and parsing the whole file.
+//
+// The index is stamped with the size, modification time, to the nanosecond,
+// and inode of the data file it describes, and is ignored whenever those do not
+// match.
+//
+// Consecutive entries are also summarized in segments, each recording the
+// range of dates and projects of its tasks, so that a query can skip the parts
+// of a file that cannot hold a match.  Where the file is ordered by end, as
+// completed.data is when rewritten, the segments wanted for a range of end are
+// found by binary search.
+//
+// Projects are recorded by code, in a dictionary of the distinct projects that
+// the index keeps alongside its entries, so that every project is known in
+// full however long, once, rather than as the leading bytes of each task's.
+//
+// The words of the description and annotations are recorded as a signature of
+// their trigrams, so that a search for a word skips the tasks that cannot hold
+// it.
+//
+// The part of a task's urgency that depends on neither the time nor other tasks
+// is kept too, once computed, so that later runs need not recompute it.
+class TF2Index
+{
+public:
+  struct Entry
+  {
+    uint64_t offset;
+    uint32_t length;
+    char     uuid[36];
+    char     status;
+    char     flags;
+    char     pad[2];
+    uint32_t project;      // Code of the project, as stored, or zero if none
+    int64_t  entry;
+    int64_t  end;
+    int64_t  modified;
+    uint64_t text[2];      // Trigrams of the description and annotations
+    float    urgency;      // See Task::urgency_static
+    uint32_t urgency_key;  // The Task::urgencyKey of urgency, or zero
+  };
+
+  enum {project_inexact = 1};
+
+  struct Segment
+  {
+    size_t      first;
+    size_t      count;
+    int64_t     entry_min,    entry_max;
+    int64_t     end_min,      end_max;
+    int64_t     modified_min, modified_max;
+    bool        entry_missing, end_missing, modified_missing;
+    bool        projects_exact;
+    bool        projects_present;
+    std::string project_min,  project_max;
+    std::string statuses;
+    uint64_t    text[2];
+  };
+
+  // Inclusive limits on the tasks wanted, a project prefix, the status letters
+  // and uuid prefixes allowed, if limited, words that the description or an
+  // annotation must hold, or none at all.  The index does not record due, so
+  // its limits only apply to tasks in memory.
+  struct Bounds
+  {
+    int64_t     entry_min    {INT64_MIN};
+    int64_t     entry_max    {INT64_MAX};
+    int64_t     end_min      {INT64_MIN};
+    int64_t     end_max      {INT64_MAX};
+    int64_t     modified_min {INT64_MIN};
+    int64_t     modified_max {INT64_MAX};
+    int64_t     due_min      {INT64_MIN};
+    int64_t     due_max      {INT64_MAX};
+    std::string project      {};
+    std::string statuses     {};
+    bool        any_uuid     {true};
+    std::vector <std::string> uuids {};
+    std::vector <std::string> words {};
+    bool        none         {false};
+
+    // Where the bounds unite looser alternatives, such as the terms of an 'or',
+    // those alternatives, of which a task must lie within one.
+    std::vector <Bounds> either {};
+  };
+
+  TF2Index () = default;
+  ~TF2Index ();
+
+  void target (const std::string&);
+  bool load ();
+  bool save ();
+  void clear ();
+  bool valid () const;
+
+  void build (const std::vector <std::string>&, uint64_t offset = 0);
+  void append (const std::string&, uint64_t);
+  void invalidate ();
+  void urgency (size_t, float, uint32_t);
+  bool refresh ();
+
+  const Entry* find (const std::string&) const;
+  const std::vector <Entry>& entries () const;
+  const std::vector <Segment>& segments () const;
+  std::vector <size_t> candidates (const Bounds&) const;
+  bool open () const;
+  void close () const;
+  bool read (const Entry&, std::string&) const;
+  bool read (const Segment&, std::string&) const;
+
+  const std::string& project (const Entry&) const;
+
+  static Entry parse (const std::string&, uint64_t);
+  static bool disjoint (const Segment&, const Bounds&);
+  bool excludes (const Entry&, const Bounds&) const;
+
+private:
+  struct Stamp
+  {
+    uint64_t size  {0};
+    int64_t  mtime {0};
+    int64_t  nsec  {0};
+    uint64_t inode {0};
+
+    bool operator== (const Stamp& other) const
+    {
+      return size  == other.size  &&
+             mtime == other.mtime &&
+             nsec  == other.nsec  &&
+             inode == other.inode;
+    }
+  };
+
+  static Entry parse (const std::string&, uint64_t, std::string*);
+  Entry code (const std::string&, uint64_t);
+  bool stamp (Stamp&) const;
+  bool read (uint64_t, size_t, std::string&) const;
+  void summarize ();
+
+private:
+  std::string          _data_file  {};
+  std::string          _index_file {};
+  std::vector <Entry>  _entries    {};
+  std::vector <Segment> _segments  {};
+  std::vector <std::string> _projects {};  // Project of each code, less one
+  std::unordered_map <std::string, uint32_t> _codes {};
+  size_t               _lead       {0};     // Segments leading with a task without end
+  bool                 _end_ordered {true}; // Segments after the lead ordered by end
+  bool                 _loaded     {false};
+  bool                 _valid      {false};
+  Stamp                _stamp      {};
+  mutable int          _fd         {-1};
+};
+
+#endif
+////////////////////////////////////////////////////////////////////////////////
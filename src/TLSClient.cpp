@@ -30,6 +30,7 @@
 
 #include <TLSClient.h>
 #include <iostream>
+#include <algorithm>
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -128,6 +129,33 @@ void TLSClient::ciphers (const std::string& cipher_list)
   _ciphers = cipher_list;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Session data from an earlier connection to the same server, which connect
+// offers to the server, so that the handshake may resume that session.
+void TLSClient::session (const std::string& data)
+{
+  _resume = data;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The data needed to resume this session later, or "" if there is none.
+std::string TLSClient::session () const
+{
+  gnutls_datum_t data {nullptr, 0};
+  if (gnutls_session_get_data2 (_session, &data) < 0) // All
+    return "";
+
+  std::string result ((const char*) data.data, data.size);
+  gnutls_free (data.data); // All
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TLSClient::resumed () const
+{
+  return gnutls_session_is_resumed (_session) != 0; // All
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void TLSClient::init (
   const std::string& ca,
@@ -234,6 +262,15 @@ void TLSClient::connect (const std::string& host, const std::string& port)
       throw format ("TLS SNI error. {1}", gnutls_strerror (ret)); // All
   }
 
+  // Offer the earlier session.  A server that declines it performs a full
+  // handshake instead.
+  if (_resume != "")
+  {
+    ret = gnutls_session_set_data (_session, _resume.data (), _resume.length ()); // All
+    if (ret < 0 && _debug)
+      std::cout << "c: WARNING Session not resumable. " << gnutls_strerror (ret) << '\n'; // All
+  }
+
   // Store the TLSClient instance, so that the verification callback can access
   // it during the handshake below and call the verification method.
   gnutls_session_set_ptr (_session, (void*) this); // All
@@ -461,36 +498,43 @@ int TLSClient::verify_certificate () const
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+// Sends the encoded length, then the data, in records of up to MAX_BUF bytes,
+// so that a large payload is not copied to be sent.
 void TLSClient::send (const std::string& data)
 {
-  std::string packet = "XXXX" + data;
-
-  // Encode the length.
-  unsigned long l = packet.length ();
-  packet[0] = l >>24;
-  packet[1] = l >>16;
-  packet[2] = l >>8;
-  packet[3] = l;
-
-  unsigned int total = 0;
-  unsigned int remaining = packet.length ();
-
-  while (total < packet.length ())
+  // Encode the length, which includes the four bytes of the length itself.
+  unsigned long l = data.length () + 4;
+  char header[4];
+  header[0] = l >>24;
+  header[1] = l >>16;
+  header[2] = l >>8;
+  header[3] = l;
+
+  auto write = [this] (const char* bytes, size_t length)
   {
-    int status;
-    do
+    size_t total = 0;
+    while (total < length)
     {
-      status = gnutls_record_send (_session, packet.c_str () + total, remaining); // All
+      int status;
+      do
+      {
+        status = gnutls_record_send (_session, bytes + total, std::min (length - total, (size_t) MAX_BUF)); // All
+      }
+      while (status == GNUTLS_E_INTERRUPTED ||
+             status == GNUTLS_E_AGAIN);
+
+      if (status < 0)
+        break;
+
+      total += (size_t) status;
     }
-    while (errno == GNUTLS_E_INTERRUPTED ||
-           errno == GNUTLS_E_AGAIN);
 
-    if (status == -1)
-      break;
+    return total;
+  };
 
-    total     += (unsigned int) status;
-    remaining -= (unsigned int) status;
-  }
+  auto total = write (header, 4);
+  if (total == 4)
+    total += write (data.data (), data.length ());
 
   if (_debug)
     std::cout << "c: INFO Sending 'XXXX"
@@ -500,6 +544,8 @@ void TLSClient::send (const std::string& data)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+// Receives the encoded length, then reads the data directly into a string
+// allocated to that length.
 void TLSClient::recv (std::string& data)
 {
   data = "";          // No appending of data.
@@ -511,37 +557,39 @@ void TLSClient::recv (std::string& data)
   {
     received = gnutls_record_recv (_session, header, 4); // All
   }
-  while (received > 0 &&
-         (errno == GNUTLS_E_INTERRUPTED ||
-          errno == GNUTLS_E_AGAIN));
+  while (received == GNUTLS_E_INTERRUPTED ||
+         received == GNUTLS_E_AGAIN);
 
-  int total = received;
+  if (received < 0)
+    throw std::string (gnutls_strerror (received)); // All
+
+  unsigned long total = received;
 
   // Decode the length.
-  unsigned long expected = (header[0]<<24) |
-                           (header[1]<<16) |
-                           (header[2]<<8) |
-                            header[3];
+  unsigned long expected = ((unsigned long) header[0]<<24) |
+                           ((unsigned long) header[1]<<16) |
+                           ((unsigned long) header[2]<<8) |
+                            (unsigned long) header[3];
   if (_debug)
     std::cout << "c: INFO expecting " << expected << " bytes.\n";
 
-  // TODO This would be a good place to assert 'expected < _limit'.
+  if (_limit && expected > (unsigned long) _limit)
+    throw format ("The Taskserver response of {1} bytes exceeds the limit of {2} bytes.", expected, _limit);
 
-  // Arbitrary buffer size.
-  char buffer[MAX_BUF];
+  if (expected > total)
+    data.resize (expected - total);
 
-  // Keep reading until no more data.  Concatenate chunks of data if a) the
-  // read was interrupted by a signal, and b) if there is more data than
-  // fits in the buffer.
-  do
+  // Keep reading until the expected data has arrived, retrying a read that
+  // was interrupted by a signal.
+  size_t length = 0;
+  while (length < data.length ())
   {
     do
     {
-      received = gnutls_record_recv (_session, buffer, MAX_BUF - 1); // All
+      received = gnutls_record_recv (_session, &data[length], std::min (data.length () - length, (size_t) MAX_BUF)); // All
     }
-    while (received > 0 &&
-           (errno == GNUTLS_E_INTERRUPTED ||
-            errno == GNUTLS_E_AGAIN));
+    while (received == GNUTLS_E_INTERRUPTED ||
+           received == GNUTLS_E_AGAIN);
 
     // Other end closed the connection.
     if (received == 0)
@@ -556,19 +604,16 @@ void TLSClient::recv (std::string& data)
     {
       if (_debug)
         std::cout << "c: WARNING " << gnutls_strerror (received) << '\n'; // All
+      continue;
     }
     else if (received < 0)
       throw std::string (gnutls_strerror (received)); // All
 
-    buffer [received] = '\0';
-    data += buffer;
-    total += received;
-
-    // Stop at defined limit.
-    if (_limit && total > _limit)
-      break;
+    length += received;
   }
-  while (received > 0 && total < (int) expected);
+
+  data.resize (length);
+  total += length;
 
   if (_debug)
     std::cout << "c: INFO Receiving 'XXXX"
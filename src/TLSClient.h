@@ -42,6 +42,9 @@ public:
   void debug (int);
   void trust (const enum trust_level);
   void ciphers (const std::string&);
+  void session (const std::string&);
+  std::string session () const;
+  bool resumed () const;
   void init (const std::string&, const std::string&, const std::string&);
   void connect (const std::string&, const std::string&);
   void bye ();
@@ -57,6 +60,7 @@ private:
   std::string                      _ciphers     {""};
   std::string                      _host        {""};
   std::string                      _port        {""};
+  std::string                      _resume      {""};
   gnutls_certificate_credentials_t _credentials {};
   gnutls_session_t                 _session     {nullptr};
   int                              _socket      {0};
@@ -28,6 +28,8 @@
 #include <Task.h>
 #include <sstream>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <assert.h>
 #include <string>
 #ifdef PRODUCT_TASKWARRIOR
@@ -35,7 +37,10 @@
 #include <ctype.h>
 #endif
 #include <cfloat>
+#include <limits>
+#include <array>
 #include <algorithm>
+#include <unordered_map>
 #include <Lexer.h>
 #ifdef PRODUCT_TASKWARRIOR
 #include <Context.h>
@@ -45,6 +50,8 @@
 #include <Datetime.h>
 #ifdef PRODUCT_TASKWARRIOR
 #include <RX.h>
+#include <Trace.h>
+#include <Uuid.h>
 #endif
 #include <shared.h>
 #include <format.h>
@@ -60,7 +67,7 @@
 
 #define APPROACHING_INFINITY 1000   // Close enough.  This isn't rocket surgery.
 
-extern Task& contextTask;
+extern thread_local const Task* contextTask;
 
 static const float epsilon = 0.000001;
 #endif
@@ -73,6 +80,7 @@ bool Task::regex                   = false;
 std::map <std::string, std::string> Task::attributes;
 
 std::map <std::string, float> Task::coefficients;
+std::vector <Task::Coefficient> Task::userCoefficients;
 float Task::urgencyProjectCoefficient     = 0.0;
 float Task::urgencyActiveCoefficient      = 0.0;
 float Task::urgencyScheduledCoefficient   = 0.0;
@@ -84,11 +92,64 @@ float Task::urgencyDueCoefficient         = 0.0;
 float Task::urgencyBlockingCoefficient    = 0.0;
 float Task::urgencyAgeCoefficient         = 0.0;
 float Task::urgencyAgeMax                 = 0.0;
+uint32_t Task::urgencyKey                 = 0;
+Task::TimeFrame Task::timeFrame;
 
 std::map <std::string, std::vector <std::string>> Task::customOrder;
 
 static const std::string dummy ("");
 
+// Virtual tags, by number.  These also identify the memoized bits in the task
+// data, so there can be no more than 32.
+enum virtualTag
+{
+  vt_blocked, vt_unblocked, vt_blocking, vt_ready, vt_latest,
+  vt_due, vt_today, vt_yesterday, vt_tomorrow, vt_overdue, vt_week, vt_month,
+  vt_quarter, vt_year, vt_uda, vt_orphan, vt_active, vt_scheduled,
+  vt_instance, vt_until, vt_annotated, vt_tagged, vt_template, vt_waiting,
+  vt_pending, vt_completed, vt_deleted, vt_project, vt_priority
+};
+
+static const std::unordered_map <std::string, int> virtualTags =
+{
+  {"BLOCKED",   vt_blocked},
+  {"UNBLOCKED", vt_unblocked},
+  {"BLOCKING",  vt_blocking},
+#ifdef PRODUCT_TASKWARRIOR
+  {"READY",     vt_ready},
+  {"DUE",       vt_due},
+  {"DUETODAY",  vt_today},                // 2016-03-29: Deprecated in 2.6.0
+  {"TODAY",     vt_today},
+  {"YESTERDAY", vt_yesterday},
+  {"TOMORROW",  vt_tomorrow},
+  {"OVERDUE",   vt_overdue},
+  {"WEEK",      vt_week},
+  {"MONTH",     vt_month},
+  {"QUARTER",   vt_quarter},
+  {"YEAR",      vt_year},
+#endif
+  {"ACTIVE",    vt_active},
+  {"SCHEDULED", vt_scheduled},
+  {"CHILD",     vt_instance},             // 2017-01-07: Deprecated in 2.6.0
+  {"INSTANCE",  vt_instance},
+  {"UNTIL",     vt_until},
+  {"ANNOTATED", vt_annotated},
+  {"TAGGED",    vt_tagged},
+  {"PARENT",    vt_template},             // 2017-01-07: Deprecated in 2.6.0
+  {"TEMPLATE",  vt_template},
+  {"WAITING",   vt_waiting},
+  {"PENDING",   vt_pending},
+  {"COMPLETED", vt_completed},
+  {"DELETED",   vt_deleted},
+#ifdef PRODUCT_TASKWARRIOR
+  {"UDA",       vt_uda},
+  {"ORPHAN",    vt_orphan},
+  {"LATEST",    vt_latest},
+#endif
+  {"PROJECT",   vt_project},
+  {"PRIORITY",  vt_priority},
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 // The uuid and id attributes must be exempt from comparison.
 //
@@ -185,6 +246,7 @@ void Task::setAsNow (const std::string& att)
   set (att, now);
 
   recalc_urgency = true;
+  recalc_static = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -249,32 +311,25 @@ unsigned long Task::get_ulong (const std::string& name) const
 ////////////////////////////////////////////////////////////////////////////////
 float Task::get_float (const std::string& name) const
 {
-  auto i = data.find (name);
-  if (i != data.end ())
-    return strtof (i->second.c_str (), nullptr);
-
-  return 0.0;
+  return data.get_float (name);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 time_t Task::get_date (const std::string& name) const
 {
-  auto i = data.find (name);
-  if (i != data.end ())
-    return (time_t) strtoul (i->second.c_str (), nullptr, 10);
-
-  return 0;
+  return data.get_date (name);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 void Task::set (const std::string& name, const std::string& value)
 {
-  data[name] = json::decode (value);
-
-  if (! name.compare (0, 11, "annotation_", 11))
+  if (! name.compare (0, 11, "annotation_", 11) && ! has (name))
     ++annotation_count;
 
+  data[name] = json::decode (value);
+
   recalc_urgency = true;
+  recalc_static = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -283,25 +338,32 @@ void Task::set (const std::string& name, int value)
   data[name] = format (value);
 
   recalc_urgency = true;
+  recalc_static = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 void Task::remove (const std::string& name)
 {
   if (data.erase (name))
+  {
     recalc_urgency = true;
+    recalc_static = true;
 
-  if (! name.compare (0, 11, "annotation_", 11))
-    --annotation_count;
+    if (! name.compare (0, 11, "annotation_", 11))
+      --annotation_count;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-Task::status Task::getStatus () const
+static int statusCode (const std::string& input)
 {
-  if (! has ("status"))
-    return Task::pending;
+  return Task::textToStatus (input);
+}
 
-  return textToStatus (get ("status"));
+////////////////////////////////////////////////////////////////////////////////
+Task::status Task::getStatus () const
+{
+  return (Task::status) data.get_enum ("status", statusCode, Task::pending);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -310,37 +372,71 @@ void Task::setStatus (Task::status status)
   set ("status", statusToText (status));
 
   recalc_urgency = true;
+  recalc_static = true;
 }
 
 #ifdef PRODUCT_TASKWARRIOR
+////////////////////////////////////////////////////////////////////////////////
+// Finds the boundaries of Task::timeFrame, as of now.  Context does this once
+// the configuration is read, and anything else on first use.
+void Task::compileTimeFrame ()
+{
+  Datetime now;
+  Datetime today ("today");
+  Datetime tomorrow ("tomorrow");
+
+  timeFrame.now        = now.toEpoch ();
+  timeFrame.yesterday  = Datetime ("yesterday").toEpoch ();
+  timeFrame.today      = today.toEpoch ();
+  timeFrame.tomorrow   = tomorrow.toEpoch ();
+  timeFrame.overmorrow = (tomorrow + 36 * 3600).startOfDay ().toEpoch ();
+
+  // With no imminent period, every later date is imminent.
+  int imminentperiod = Context::getContext ().config.getInteger ("due");
+  timeFrame.imminent = imminentperiod == 0
+                     ? std::numeric_limits <time_t>::max ()
+                     : (today + imminentperiod * 86400).toEpoch ();
+
+  timeFrame.sow = Datetime ("sow").toEpoch ();
+  timeFrame.eow = Datetime ("eow").toEpoch ();
+  timeFrame.som = Datetime ("som").toEpoch ();
+  timeFrame.eom = Datetime ("eom").toEpoch ();
+  timeFrame.soq = Datetime ("soq").toEpoch ();
+  timeFrame.eoq = Datetime ("eoq").toEpoch ();
+  timeFrame.soy = Datetime ("soy").toEpoch ();
+  timeFrame.eoy = Datetime ("eoy").toEpoch ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static const Task::TimeFrame& frame ()
+{
+  if (Task::timeFrame.now == 0)
+    Task::compileTimeFrame ();
+
+  return Task::timeFrame;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Determines status of a date attribute.
 Task::dateState Task::getDateState (const std::string& name) const
 {
-  std::string value = get (name);
-  if (value.length ())
+  if (has (name))
   {
-    Datetime reference (value);
-    Datetime now;
-    Datetime today ("today");
+    auto& f = frame ();
+    auto reference = get_date (name);
 
-    if (reference < today)
+    if (reference < f.today)
       return dateBeforeToday;
 
-    if (reference.sameDay (now))
+    if (reference < f.tomorrow)
     {
-      if (reference < now)
+      if (reference < f.now)
         return dateEarlierToday;
       else
         return dateLaterToday;
     }
 
-    int imminentperiod = Context::getContext ().config.getInteger ("due");
-    if (imminentperiod == 0)
-      return dateAfterToday;
-
-    Datetime imminentDay = today + imminentperiod * 86400;
-    if (reference < imminentDay)
+    if (reference < f.imminent)
       return dateAfterToday;
   }
 
@@ -355,7 +451,7 @@ bool Task::is_ready () const
   return getStatus () == Task::pending &&
          ! is_blocked                  &&
          (! has ("scheduled")          ||
-          Datetime ("now").operator> (get_date ("scheduled")));
+          frame ().now > get_date ("scheduled"));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -389,7 +485,9 @@ bool Task::is_dueyesterday () const
     if (status != Task::completed &&
         status != Task::deleted)
     {
-      if (Datetime ("yesterday").sameDay (get_date ("due")))
+      auto due = get_date ("due");
+      if (due >= frame ().yesterday &&
+          due <  frame ().today)
         return true;
     }
   }
@@ -427,7 +525,9 @@ bool Task::is_duetomorrow () const
     if (status != Task::completed &&
         status != Task::deleted)
     {
-      if (Datetime ("tomorrow").sameDay (get_date ("due")))
+      auto due = get_date ("due");
+      if (due >= frame ().tomorrow &&
+          due <  frame ().overmorrow)
         return true;
     }
   }
@@ -445,9 +545,9 @@ bool Task::is_dueweek () const
     if (status != Task::completed &&
         status != Task::deleted)
     {
-      Datetime due (get_date ("due"));
-      if (due >= Datetime ("sow") &&
-          due <= Datetime ("eow"))
+      auto due = get_date ("due");
+      if (due >= frame ().sow &&
+          due <= frame ().eow)
         return true;
     }
   }
@@ -465,9 +565,9 @@ bool Task::is_duemonth () const
     if (status != Task::completed &&
         status != Task::deleted)
     {
-      Datetime due (get_date ("due"));
-      if (due >= Datetime ("som") &&
-          due <= Datetime ("eom"))
+      auto due = get_date ("due");
+      if (due >= frame ().som &&
+          due <= frame ().eom)
         return true;
     }
   }
@@ -485,9 +585,9 @@ bool Task::is_duequarter () const
     if (status != Task::completed &&
         status != Task::deleted)
     {
-      Datetime due (get_date ("due"));
-      if (due >= Datetime ("soq") &&
-          due <= Datetime ("eoq"))
+      auto due = get_date ("due");
+      if (due >= frame ().soq &&
+          due <= frame ().eoq)
         return true;
     }
   }
@@ -505,9 +605,9 @@ bool Task::is_dueyear () const
     if (status != Task::completed &&
         status != Task::deleted)
     {
-      Datetime due (get_date ("due"));
-      if (due >= Datetime ("soy") &&
-          due <= Datetime ("eoy"))
+      auto due = get_date ("due");
+      if (due >= frame ().soy &&
+          due <= frame ().eoy)
         return true;
     }
   }
@@ -580,42 +680,44 @@ void Task::parse (const std::string& input)
 
     if (input[0] == '[')
     {
-      Pig pig (input);
-      std::string line;
-      if (pig.skip     ('[')       &&
-          pig.getUntil (']', line) &&
-          pig.skip     (']')       &&
-          (pig.skip ('\n') || pig.eos ()))
+      // Lines written by composeF4 take the fast path, anything unusual the
+      // general one.
+      if (! parseF4 (input))
       {
-        if (line.length () == 0)
-          throw std::string ("Empty record in input.");
-
-        Pig attLine (line);
-        std::string name;
-        std::string value;
-        while (!attLine.eos ())
+        Pig pig (input);
+        std::string line;
+        if (pig.skip     ('[')       &&
+            pig.getUntil (']', line) &&
+            pig.skip     (']')       &&
+            (pig.skip ('\n') || pig.eos ()))
         {
-          if (attLine.getUntil (':', name) &&
-              attLine.skip (':')           &&
-              attLine.getQuoted ('"', value))
+          if (line.length () == 0)
+            throw std::string ("Empty record in input.");
+
+          Pig attLine (line);
+          std::string name;
+          std::string value;
+          while (!attLine.eos ())
           {
+            if (attLine.getUntil (':', name) &&
+                attLine.skip (':')           &&
+                attLine.getQuoted ('"', value))
+            {
 #ifdef PRODUCT_TASKWARRIOR
-            legacyAttributeMap (name);
+              legacyAttributeMap (name);
 #endif
 
-            if (! name.compare (0, 11, "annotation_", 11))
-              ++annotation_count;
+              data[name] = decode (json::decode (value));
+            }
 
-            data[name] = decode (json::decode (value));
+            attLine.skip (' ');
           }
 
-          attLine.skip (' ');
+          std::string remainder;
+          attLine.getRemainder (remainder);
+          if (remainder.length ())
+            throw std::string ("Unrecognized characters at end of line.");
         }
-
-        std::string remainder;
-        attLine.getRemainder (remainder);
-        if (remainder.length ())
-          throw std::string ("Unrecognized characters at end of line.");
       }
     }
     else if (input[0] == '{')
@@ -629,13 +731,470 @@ void Task::parse (const std::string& input)
     parseLegacy (input);
   }
 
+  annotation_count = annotations ().size ();
   recalc_urgency = true;
+  recalc_static = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// A single pass over an FF4 line, as written by composeF4:
+//
+//   [name:"value" name:"value" ...]
+//
+// Delimiters are found with memchr, and values are only decoded if they contain
+// an escape or an entity.  Returns false, with no attributes set, on anything
+// unexpected, leaving the line to the general parser.
+bool Task::parseF4 (const std::string& input)
+{
+  const char* text = input.data ();
+  const char* end  = text + input.length ();
+
+  // One record, optionally followed by a newline.
+  auto close = (const char*) memchr (text, ']', end - text);
+  if (! close                  ||
+      close == text + 1        ||
+      (close + 1 != end &&
+       (close + 2 != end || close[1] != '\n')))
+    return false;
+
+  auto p = text + 1;
+  while (p < close)
+  {
+    auto colon = (const char*) memchr (p, ':', close - p);
+    if (! colon                 ||
+        colon == p              ||
+        colon + 1 == close      ||
+        colon[1] != '"')
+      break;
+
+    // The closing quote is the first one not escaped by a backslash.
+    auto start = colon + 2;
+    auto quote = start;
+    while ((quote = (const char*) memchr (quote, '"', close - quote)))
+    {
+      auto backslash = quote;
+      while (backslash > start && backslash[-1] == '\\')
+        --backslash;
+
+      if ((quote - backslash) % 2 == 0)
+        break;
+
+      ++quote;
+    }
+
+    if (! quote)
+      break;
+
+    std::string name (p, colon - p);
+#ifdef PRODUCT_TASKWARRIOR
+    legacyAttributeMap (name);
+#endif
+
+    std::string value (start, quote - start);
+    if (memchr (start, '\\', quote - start))
+      value = json::decode (value);
+
+    if (memchr (value.data (), '&', value.length ()))
+      value = decode (value);
+
+    data[name] = std::move (value);
+
+    p = quote + 1;
+    if (p < close && *p == ' ')
+      ++p;
+  }
+
+  if (p != close)
+  {
+    data.clear ();
+    return false;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// A member of a task object, as read by Task::readJSON.  Strings are kept as
+// they appear, still escaped, as the values of a json::object are.
+struct JSONMember
+{
+  enum kind {string, number, strings, annotations};
+
+  std::string name;
+  kind type;
+  std::string value;
+  std::vector <std::string> values;   // Strings, or entry/description pairs
+};
+
+////////////////////////////////////////////////////////////////////////////////
+static void skipJSONSpace (const char*& p, const char* end)
+{
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+    ++p;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static bool readJSONString (const char*& p, const char* end, std::string& raw)
+{
+  if (p == end || *p != '"')
+    return false;
+
+  auto start = ++p;
+  while (p < end && *p != '"')
+    if (*p++ == '\\' && p < end)
+      ++p;
+
+  if (p == end)
+    return false;
+
+  raw.assign (start, p++);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static bool readJSONStrings (const char*& p, const char* end, std::vector <std::string>& values)
+{
+  ++p;
+  skipJSONSpace (p, end);
+  if (p < end && *p == ']')
+  {
+    ++p;
+    return true;
+  }
+
+  while (true)
+  {
+    std::string raw;
+    skipJSONSpace (p, end);
+    if (! readJSONString (p, end, raw))
+      return false;
+
+    values.push_back (raw);
+    skipJSONSpace (p, end);
+    if (p < end && *p == ']')
+    {
+      ++p;
+      return true;
+    }
+
+    if (p == end || *p++ != ',')
+      return false;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Annotations are objects with 'entry' and 'description' strings, and any other
+// members, which are ignored, must be strings too.
+static bool readJSONAnnotations (const char*& p, const char* end, std::vector <std::string>& values)
+{
+  ++p;
+  skipJSONSpace (p, end);
+  if (p < end && *p == ']')
+  {
+    ++p;
+    return true;
+  }
+
+  while (true)
+  {
+    skipJSONSpace (p, end);
+    if (p == end || *p++ != '{')
+      return false;
+
+    std::string entry;
+    std::string description;
+    bool has_entry = false;
+    bool has_description = false;
+    while (true)
+    {
+      std::string name;
+      std::string raw;
+      skipJSONSpace (p, end);
+      if (! readJSONString (p, end, name))
+        return false;
+
+      skipJSONSpace (p, end);
+      if (p == end || *p++ != ':')
+        return false;
+
+      skipJSONSpace (p, end);
+      if (! readJSONString (p, end, raw))
+        return false;
+
+      if (name == "entry" && ! has_entry)
+      {
+        entry = raw;
+        has_entry = true;
+      }
+      else if (name == "description" && ! has_description)
+      {
+        description = raw;
+        has_description = true;
+      }
+      else if (name == "entry" || name == "description")
+        return false;
+
+      skipJSONSpace (p, end);
+      if (p < end && *p == '}')
+      {
+        ++p;
+        break;
+      }
+
+      if (p == end || *p++ != ',')
+        return false;
+    }
+
+    // Missing values are reported by the full parse.
+    if (! has_entry || ! has_description)
+      return false;
+
+    values.push_back (entry);
+    values.push_back (description);
+
+    skipJSONSpace (p, end);
+    if (p < end && *p == ']')
+    {
+      ++p;
+      return true;
+    }
+
+    if (p == end || *p++ != ',')
+      return false;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The epoch of an ISO 8601 date.  The form written by composeJSON is converted
+// directly, anything else by Datetime.
+static std::string epochJSONDate (const std::string& iso)
+{
+  auto digits = [&iso] (int start, int length)
+  {
+    int value = 0;
+    for (int i = start; i < start + length; ++i)
+    {
+      if (! isdigit ((unsigned char) iso[i]))
+        return -1;
+
+      value = value * 10 + (iso[i] - '0');
+    }
+
+    return value;
+  };
+
+  if (iso.length () == 16 && iso[8] == 'T' && iso[15] == 'Z')
+  {
+    struct tm t {};
+    t.tm_year = digits (0, 4) - 1900;
+    t.tm_mon  = digits (4, 2) - 1;
+    t.tm_mday = digits (6, 2);
+    t.tm_hour = digits (9, 2);
+    t.tm_min  = digits (11, 2);
+    t.tm_sec  = digits (13, 2);
+
+    static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    auto year = t.tm_year + 1900;
+    auto leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+
+    if (t.tm_year >= 70 &&
+        t.tm_mon  >= 0  && t.tm_mon  < 12 &&
+        t.tm_mday >= 1  && t.tm_mday <= days[t.tm_mon] + (t.tm_mon == 1 && leap) &&
+        t.tm_hour >= 0  && t.tm_hour < 24 &&
+        t.tm_min  >= 0  && t.tm_min  < 60 &&
+        t.tm_sec  >= 0  && t.tm_sec  < 60)
+      return std::to_string ((long long) timegm (&t));
+  }
+
+  return Datetime (iso).toEpochString ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reads a task object directly, without building a json::object, applying the
+// members as parseJSON (const json::object*) does.  Returns false, having
+// changed nothing, for anything but the plain objects that export and sync
+// write, which are then left to the full parse, and its errors.
+bool Task::readJSON (const std::string& input)
+{
+  std::vector <JSONMember> members;
+
+  const char* p = input.data ();
+  const char* end = p + input.length ();
+  skipJSONSpace (p, end);
+  if (p == end || *p++ != '{')
+    return false;
+
+  skipJSONSpace (p, end);
+  bool empty = p < end && *p == '}';
+  if (empty)
+    ++p;
+
+  while (! empty)
+  {
+    JSONMember member;
+    skipJSONSpace (p, end);
+    if (! readJSONString (p, end, member.name))
+      return false;
+
+    skipJSONSpace (p, end);
+    if (p == end || *p++ != ':')
+      return false;
+
+    auto attribute = Task::attributes.find (member.name);
+    bool known = attribute != Task::attributes.end () && attribute->second != "";
+
+    skipJSONSpace (p, end);
+    if (p == end)
+      return false;
+    else if (*p == '"')
+    {
+      member.type = JSONMember::string;
+      if (! readJSONString (p, end, member.value))
+        return false;
+    }
+
+    // Only the numbers that are ignored, as a full parse would format others.
+    else if ((*p == '-' || isdigit ((unsigned char) *p)) &&
+             known && (member.name == "id" || member.name == "urgency"))
+    {
+      member.type = JSONMember::number;
+      while (p < end && strchr ("+-.0123456789eE", *p))
+        ++p;
+    }
+
+    else if (*p == '[' && known && (member.name == "tags" || member.name == "depends"))
+    {
+      member.type = JSONMember::strings;
+      if (! readJSONStrings (p, end, member.values))
+        return false;
+    }
+
+    else if (*p == '[' && ! known && member.name == "annotations")
+    {
+      member.type = JSONMember::annotations;
+      if (! readJSONAnnotations (p, end, member.values))
+        return false;
+    }
+
+    else
+      return false;
+
+    members.push_back (member);
+
+    skipJSONSpace (p, end);
+    if (p < end && *p == '}')
+    {
+      ++p;
+      break;
+    }
+
+    if (p == end || *p++ != ',')
+      return false;
+  }
+
+  skipJSONSpace (p, end);
+  if (p != end)
+    return false;
+
+  // The members are applied in name order, as those of a json::object are, and
+  // a repeated name is left to the full parse.
+  std::sort (members.begin (), members.end (),
+             [] (const JSONMember& left, const JSONMember& right)
+             {
+               return left.name < right.name;
+             });
+
+  for (size_t i = 1; i < members.size (); ++i)
+    if (members[i].name == members[i - 1].name)
+      return false;
+
+  // Dates that do not convert are rejected by the full parse too.
+  for (auto& member : members)
+  {
+    auto attribute = Task::attributes.find (member.name);
+    if (attribute != Task::attributes.end () &&
+        attribute->second == "date" &&
+        member.type == JSONMember::string &&
+        member.value == "")
+      return false;
+  }
+
+  for (auto& member : members)
+  {
+    auto attribute = Task::attributes.find (member.name);
+    std::string type = attribute != Task::attributes.end () ? attribute->second : "";
+    if (type != "")
+    {
+      // Any specified id and urgency are ignored.
+      if (member.name == "id" ||
+          member.name == "urgency")
+        ;
+
+      // TW-1274 Standardization.
+      else if (member.name == "modification")
+        set ("modified", epochJSONDate (member.value));
+
+      else if (type == "date")
+        set (member.name, epochJSONDate (member.value));
+
+      else if (member.name == "tags" && member.type == JSONMember::strings)
+      {
+        for (auto& tag : member.values)
+          addTag (tag);
+      }
+
+      else if (member.name == "tags")
+        addTag (member.value);
+
+      else if (member.name == "depends" && member.type == JSONMember::strings)
+      {
+        for (auto& dep : member.values)
+          addDependency (dep);
+      }
+
+      else if (member.name == "depends")
+      {
+        for (const auto& uuid : split (member.value, ','))
+          addDependency (uuid);
+      }
+
+      else if (type == "string")
+        set (member.name, json::decode (member.value));
+
+      else
+        set (member.name, member.value);
+    }
+
+    else if (member.type == JSONMember::annotations)
+    {
+      std::map <std::string, std::string> annos;
+      for (size_t i = 0; i < member.values.size (); i += 2)
+        annos.insert (std::make_pair ("annotation_" + epochJSONDate (member.values[i]),
+                                      json::decode (member.values[i + 1])));
+
+      setAnnotations (annos);
+    }
+
+    // UDA Orphan - must be preserved.
+    else
+    {
+#ifdef PRODUCT_TASKWARRIOR
+      Context::getContext ().debug ("Task::readJSON found orphan '" + member.name + "' with value '" + member.value + "' --> preserved");
+#endif
+      set (member.name, json::decode (member.value));
+    }
+  }
+
+  return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // Note that all fields undergo encode/decode.
 void Task::parseJSON (const std::string& line)
 {
+  if (readJSON (line))
+    return;
+
   // Parse the whole thing.
   json::value* root = json::parse (line);
   if (root &&
@@ -651,8 +1210,10 @@ void Task::parseJSON (const json::object* root_obj)
   // For each object element...
   for (auto& i : root_obj->_data)
   {
-    // If the attribute is a recognized column.
-    std::string type = Task::attributes[i.first];
+    // If the attribute is a recognized column.  The attributes are only read,
+    // so that tasks may be parsed concurrently.
+    auto attribute = Task::attributes.find (i.first);
+    std::string type = attribute != Task::attributes.end () ? attribute->second : "";
     if (type != "")
     {
       // Any specified id is ignored.
@@ -824,6 +1385,41 @@ void Task::parseLegacy (const std::string& line)
   }
 
   recalc_urgency = true;
+  recalc_static = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Appends the value escaped as json::encode does, and for F4 also with the
+// brackets encoded, as Task::encode does.  Most values need neither, which a
+// table lookup per character finds, and are appended as they are.
+static void composeEscaped (std::string& out, const std::string& value, bool f4)
+{
+  static const auto escaped = [] ()
+  {
+    std::array <bool, 256> table {};
+    for (int c = 0; c < 0x20; ++c)
+      table[c] = true;
+
+    for (unsigned char c : std::string ("\"\\/[]"))
+      table[c] = true;
+
+    return table;
+  } ();
+
+  bool plain = true;
+  for (unsigned char c : value)
+    if (escaped[c])
+    {
+      plain = false;
+      break;
+    }
+
+  if (plain)
+    out += value;
+  else if (f4)
+    out += str_replace (str_replace (json::encode (value), "[", "&open;"), "]", "&close;");
+  else
+    out += json::encode (value);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -833,49 +1429,108 @@ void Task::parseLegacy (const std::string& line)
 //
 std::string Task::composeF4 () const
 {
-  std::string ff4 = "[";
+  std::string ff4;
+  composeF4 (ff4);
+  return ff4;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Appends the F4 for the task to out, so that a caller writing many tasks can
+// reuse one buffer.
+void Task::composeF4 (std::string& out) const
+{
+  auto size = out.size () + 2;
+  for (auto& i : data)
+    size += i.first.size () + i.second.size () + 4;
+
+  out.reserve (size);
+  out += '[';
 
   bool first = true;
-  for (auto it : data)
+  for (auto& i : data)
   {
-    // Orphans have no type, treat as string.
-    std::string type = Task::attributes[it.first];
-    if (type == "")
-      type = "string";
-
     // If there is a value.
-    if (it.second != "")
+    if (i.second != "")
     {
-      ff4 += (first ? "" : " ");
-      ff4 += it.first;
-      ff4 += ":\"";
-      if (type == "string")
-        ff4 += encode (json::encode (it.second));
+      if (! first)
+        out += ' ';
+
+      out += i.first;
+      out += ":\"";
+
+      // Orphans have no type, treat as string.
+      auto attribute = Task::attributes.find (i.first);
+      if (attribute == Task::attributes.end () ||
+          attribute->second == ""              ||
+          attribute->second == "string")
+        composeEscaped (out, i.second, true);
       else
-        ff4 += it.second;
-      ff4 += '"';
+        out += i.second;
 
+      out += '"';
       first = false;
     }
   }
 
-  ff4 += ']';
-  return ff4;
+  out += ']';
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Appends the epoch as ISO 8601, as Datetime::toISO does, but with gmtime_r, so
+// that tasks may be composed concurrently.
+static void composeJSONDate (std::string& out, const std::string& epoch)
+{
+  struct tm t;
+  time_t value = (time_t) strtoll (epoch.c_str (), nullptr, 10);
+  if (! Lexer::isAllDigits (epoch) || ! gmtime_r (&value, &t))
+  {
+    out += Datetime (epoch).toISO ();
+    return;
+  }
+
+  char iso[32];
+  strftime (iso, sizeof (iso), "%Y%m%dT%H%M%SZ", &t);
+  out += iso;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 std::string Task::composeJSON (bool decorate /*= false*/) const
 {
-  std::stringstream out;
-  out << '{';
+  std::string out;
+  composeJSON (out, decorate);
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Appends the JSON for the task to out, so that a caller writing many tasks can
+// reuse one buffer.
+// With fields, only the attributes named there are composed, and urgency is
+// only calculated if it is one of them.
+void Task::composeJSON (
+  std::string& out,
+  bool decorate /*= false*/,
+  const std::set <std::string>* fields /*= nullptr*/) const
+{
+  static const std::string string_type = "string";
+
+  auto wanted = [fields] (const std::string& name)
+  {
+    return ! fields || fields->find (name) != fields->end ();
+  };
+
+  out += '{';
 
   // ID inclusion is optional, but not a good idea, because it remains correct
   // only until the next gc.
-  if (decorate)
-    out << "\"id\":" << id << ',';
+  int attributes_written = 0;
+  if (decorate && wanted ("id"))
+  {
+    out += "\"id\":";
+    out += std::to_string (id);
+    ++attributes_written;
+  }
 
   // First the non-annotations.
-  int attributes_written = 0;
   for (auto& i : data)
   {
     // Annotations are not written out here.
@@ -886,23 +1541,25 @@ std::string Task::composeJSON (bool decorate /*= false*/) const
     if (i.second == "")
         continue;
 
+    if (fields && ! wanted (i.first == "modification" ? "modified" : i.first))
+      continue;
+
     if (attributes_written)
-      out << ',';
+      out += ',';
 
-    std::string type = Task::attributes[i.first];
-    if (type == "")
-      type = "string";
+    auto attribute = Task::attributes.find (i.first);
+    const std::string& type = attribute == Task::attributes.end () || attribute->second == ""
+                            ? string_type
+                            : attribute->second;
 
     // Date fields are written as ISO 8601.
     if (type == "date")
     {
-      Datetime d (i.second);
-      out << '"'
-          << (i.first == "modification" ? "modified" : i.first)
-          << "\":\""
-          // Date was deleted, do not export parsed empty string
-          << (i.second == "" ? "" : d.toISO ())
-          << '"';
+      out += '"';
+      out += (i.first == "modification" ? "modified" : i.first);
+      out += "\":\"";
+      composeJSONDate (out, i.second);
+      out += '"';
 
       ++attributes_written;
     }
@@ -915,10 +1572,10 @@ std::string Task::composeJSON (bool decorate /*= false*/) const
 */
     else if (type == "numeric")
     {
-      out << '"'
-          << i.first
-          << "\":"
-          << i.second;
+      out += '"';
+      out += i.first;
+      out += "\":";
+      out += i.second;
 
       ++attributes_written;
     }
@@ -926,20 +1583,9 @@ std::string Task::composeJSON (bool decorate /*= false*/) const
     // Tags are converted to an array.
     else if (i.first == "tags")
     {
-      auto tags = split (i.second, ',');
-
-      out << "\"tags\":[";
-
-      int count = 0;
-      for (auto i : tags)
-      {
-        if (count++)
-          out << ',';
-
-        out << '"' << i << '"';
-      }
-
-      out << ']';
+      out += "\"tags\":[";
+      composeJSONArray (out, i.second);
+      out += ']';
       ++attributes_written;
     }
 
@@ -965,85 +1611,99 @@ std::string Task::composeJSON (bool decorate /*= false*/) const
 #endif
             )
     {
-      auto deps = split (i.second, ',');
-
-      out << "\"depends\":[";
-
-      int count = 0;
-      for (auto i : deps)
-      {
-        if (count++)
-          out << ',';
-
-        out << '"' << i << '"';
-      }
-
-      out << ']';
+      out += "\"depends\":[";
+      composeJSONArray (out, i.second);
+      out += ']';
       ++attributes_written;
     }
 
     // Everything else is a quoted value.
     else
     {
-      out << '"'
-          << i.first
-          << "\":\""
-          << (type == "string" ? json::encode (i.second) : i.second)
-          << '"';
+      out += '"';
+      out += i.first;
+      out += "\":\"";
+      if (type == "string")
+        composeEscaped (out, i.second, false);
+      else
+        out += i.second;
+      out += '"';
 
       ++attributes_written;
     }
   }
 
   // Now the annotations, if any.
-  if (annotation_count)
+  auto annos = annotations ();
+  if (! annos.empty () && wanted ("annotations"))
   {
-    out << ','
-        << "\"annotations\":[";
+    if (attributes_written)
+      out += ',';
+    out += "\"annotations\":[";
+    ++attributes_written;
 
-    int annotations_written = 0;
-    for (auto& i : data)
+    for (auto& i : annos)
     {
-      if (! i.first.compare (0, 11, "annotation_", 11))
-      {
-        if (annotations_written)
-          out << ',';
-
-        Datetime d (i.first.substr (11));
-        out << "{\"entry\":\""
-            << d.toISO ()
-            << "\",\"description\":\""
-            << json::encode (i.second)
-            << "\"}";
-
-        ++annotations_written;
-      }
+      if (&i != &*annos.begin ())
+        out += ',';
+
+      out += "{\"entry\":\"";
+      composeJSONDate (out, i.first.substr (11));
+      out += "\",\"description\":\"";
+      composeEscaped (out, i.second, false);
+      out += "\"}";
     }
 
-    out << ']';
+    out += ']';
   }
 
 #ifdef PRODUCT_TASKWARRIOR
-  // Include urgency.
-  if (decorate)
-    out << ','
-        << "\"urgency\":"
-        << urgency_c ();
+  // Include urgency, formatted as a stream would.
+  if (decorate && wanted ("urgency"))
+  {
+    std::stringstream urgency;
+    urgency << urgency_c ();
+    if (attributes_written)
+      out += ',';
+    out += "\"urgency\":";
+    out += urgency.str ();
+  }
 #endif
 
-  out << '}';
-  return out.str ();
+  out += '}';
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-int Task::getAnnotationCount () const
+// The bytes held by the task, as an estimate for perf.output.
+size_t Task::bytes () const
+{
+  return sizeof (Task) + data.bytes ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Appends the comma-separated values as quoted JSON array elements.
+void Task::composeJSONArray (std::string& out, const std::string& values)
 {
-  int count = 0;
-  for (auto& ann : data)
-    if (! ann.first.compare (0, 11, "annotation_", 11))
-      ++count;
+  std::string::size_type start = 0;
+  while (true)
+  {
+    auto comma = values.find (',', start);
+    out += '"';
+    out.append (values, start, comma == std::string::npos ? std::string::npos : comma - start);
+    out += '"';
+
+    if (comma == std::string::npos)
+      break;
 
-  return count;
+    out += ',';
+    start = comma + 1;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int Task::getAnnotationCount () const
+{
+  return annotations ().size ();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1073,36 +1733,36 @@ void Task::addAnnotation (const std::string& description)
   data[key] = json::decode (description);
   ++annotation_count;
   recalc_urgency = true;
+  recalc_static = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 void Task::removeAnnotations ()
 {
-  // Erase old annotations.
-  auto i = data.begin ();
-  while (i != data.end ())
-  {
-    if (! i->first.compare (0, 11, "annotation_", 11))
-    {
-      --annotation_count;
-      data.erase (i++);
-    }
-    else
-      i++;
-  }
+  // Erase old annotations, which are adjacent.
+  auto i = annotations ().begin ();
+  while (i != data.end () &&
+         ! i->first.compare (0, 11, "annotation_", 11))
+    i = data.erase (i);
+
+  annotation_count = 0;
 
   recalc_urgency = true;
+  recalc_static = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 std::map <std::string, std::string> Task::getAnnotations () const
 {
-  std::map <std::string, std::string> a;
-  for (auto& ann : data)
-    if (! ann.first.compare (0, 11, "annotation_", 11))
-      a.insert (ann);
+  auto annos = annotations ();
+  return std::map <std::string, std::string> (annos.begin (), annos.end ());
+}
 
-  return a;
+////////////////////////////////////////////////////////////////////////////////
+// The annotations in place, in order, without copying them.
+AttributeMap::range Task::annotations () const
+{
+  return data.prefixed ("annotation_");
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1116,6 +1776,7 @@ void Task::setAnnotations (const std::map <std::string, std::string>& annotation
 
   annotation_count = annotations.size ();
   recalc_urgency = true;
+  recalc_static = true;
 }
 
 #ifdef PRODUCT_TASKWARRIOR
@@ -1127,8 +1788,7 @@ void Task::addDependency (int depid)
   if (uuid == "")
     throw format ("Could not create a dependency on task {1} - not found.", depid);
 
-  std::string depends = get ("depends");
-  if (depends.find (uuid) != std::string::npos)
+  if (hasDependency (uuid))
   {
     Context::getContext ().footnote (format ("Task {1} already depends on task {2}.", id, depid));
     return;
@@ -1149,7 +1809,7 @@ void Task::addDependency (const std::string& uuid)
   if (depends != "")
   {
     // Check for extant dependency.
-    if (depends.find (uuid) == std::string::npos)
+    if (! hasDependency (uuid))
       set ("depends", depends + ',' + uuid);
     else
     {
@@ -1169,6 +1829,25 @@ void Task::addDependency (const std::string& uuid)
 #endif
 
   recalc_urgency = true;
+  recalc_static = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Whether the uuid is one of the dependencies, compared whole.
+bool Task::hasDependency (const std::string& uuid) const
+{
+  Uuid key;
+  if (! Uuid::parse (uuid, key))
+    return ! scanFields (get_ref ("depends"), ',', [&] (const char* dep, size_t length)
+    {
+      return length != uuid.length () || memcmp (dep, uuid.data (), length) != 0;
+    });
+
+  return ! scanFields (get_ref ("depends"), ',', [&] (const char* dep, size_t length)
+  {
+    Uuid value;
+    return ! Uuid::parse (dep, length, value) || value != key;
+  });
 }
 
 #ifdef PRODUCT_TASKWARRIOR
@@ -1183,6 +1862,7 @@ void Task::removeDependency (const std::string& uuid)
     deps.erase (i);
     set ("depends", join (",", deps));
     recalc_urgency = true;
+    recalc_static = true;
   }
   else
     throw format ("Could not delete a dependency on task {1} - not found.", uuid);
@@ -1191,9 +1871,8 @@ void Task::removeDependency (const std::string& uuid)
 ////////////////////////////////////////////////////////////////////////////////
 void Task::removeDependency (int id)
 {
-  std::string depends = get ("depends");
   std::string uuid = Context::getContext ().tdb2.pending.uuid (id);
-  if (uuid != "" && depends.find (uuid) != std::string::npos)
+  if (uuid != "" && hasDependency (uuid))
     removeDependency (uuid);
   else
     throw format ("Could not delete a dependency on task {1} - not found.", id);
@@ -1202,9 +1881,17 @@ void Task::removeDependency (int id)
 ////////////////////////////////////////////////////////////////////////////////
 std::vector <int> Task::getDependencyIDs () const
 {
+  auto& deps = get_ref ("depends");
   std::vector <int> all;
-  for (auto& dep : split (get ("depends"), ','))
+  all.reserve (countFields (deps));
+
+  std::string dep;
+  scanFields (deps, ',', [&] (const char* field, size_t length)
+  {
+    dep.assign (field, length);
     all.push_back (Context::getContext ().tdb2.pending.id (dep));
+    return true;
+  });
 
   return all;
 }
@@ -1212,19 +1899,35 @@ std::vector <int> Task::getDependencyIDs () const
 ////////////////////////////////////////////////////////////////////////////////
 std::vector <std::string> Task::getDependencyUUIDs () const
 {
-  return split (get ("depends"), ',');
+  auto& deps = get_ref ("depends");
+  std::vector <std::string> all;
+  all.reserve (countFields (deps));
+
+  scanFields (deps, ',', [&] (const char* dep, size_t length)
+  {
+    all.emplace_back (dep, length);
+    return true;
+  });
+
+  return all;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 std::vector <Task> Task::getDependencyTasks () const
 {
+  auto& deps = get_ref ("depends");
   std::vector <Task> all;
-  for (auto& dep : split (get ("depends"), ','))
+  all.reserve (countFields (deps));
+
+  std::string dep;
+  scanFields (deps, ',', [&] (const char* field, size_t length)
   {
+    dep.assign (field, length);
     Task task;
     Context::getContext ().tdb2.get (dep, task);
     all.push_back (task);
-  }
+    return true;
+  });
 
   return all;
 }
@@ -1233,8 +1936,7 @@ std::vector <Task> Task::getDependencyTasks () const
 ////////////////////////////////////////////////////////////////////////////////
 int Task::getTagCount () const
 {
-  auto tags = split (get ("tags"), ',');
-  return (int) tags.size ();
+  return countFields (get_ref ("tags"));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1255,64 +1957,101 @@ bool Task::hasTag (const std::string& tag) const
   // Note: This list must match that in ::feedback_reserved_tags.
   if (isupper (tag[0]))
   {
-    if (tag == "BLOCKED")   return is_blocked;
-    if (tag == "UNBLOCKED") return !is_blocked;
-    if (tag == "BLOCKING")  return is_blocking;
-#ifdef PRODUCT_TASKWARRIOR
-    if (tag == "READY")     return is_ready ();
-    if (tag == "DUE")       return is_due ();
-    if (tag == "DUETODAY")  return is_duetoday ();                     // 2016-03-29: Deprecated in 2.6.0
-    if (tag == "TODAY")     return is_duetoday ();
-    if (tag == "YESTERDAY") return is_dueyesterday ();
-    if (tag == "TOMORROW")  return is_duetomorrow ();
-    if (tag == "OVERDUE")   return is_overdue ();
-    if (tag == "WEEK")      return is_dueweek ();
-    if (tag == "MONTH")     return is_duemonth ();
-    if (tag == "QUARTER")   return is_duequarter ();
-    if (tag == "YEAR")      return is_dueyear ();
-#endif
-    if (tag == "ACTIVE")    return has ("start");
-    if (tag == "SCHEDULED") return has ("scheduled");
-    if (tag == "CHILD")     return has ("parent") || has ("template"); // 2017-01-07: Deprecated in 2.6.0
-    if (tag == "INSTANCE")  return has ("template") || has ("parent");
-    if (tag == "UNTIL")     return has ("until");
-    if (tag == "ANNOTATED") return hasAnnotations ();
-    if (tag == "TAGGED")    return has ("tags");
-    if (tag == "PARENT")    return has ("mask") || has ("last");       // 2017-01-07: Deprecated in 2.6.0
-    if (tag == "TEMPLATE")  return has ("last") || has ("mask");
-    if (tag == "WAITING")   return get ("status") == "waiting";
-    if (tag == "PENDING")   return get ("status") == "pending";
-    if (tag == "COMPLETED") return get ("status") == "completed";
-    if (tag == "DELETED")   return get ("status") == "deleted";
+    auto virtualTag = virtualTags.find (tag);
+    if (virtualTag != virtualTags.end ())
+      return hasVirtualTag (virtualTag->second);
+  }
+
+  // Concrete tags, found in the comma-separated list without splitting it.
+  auto tags = data.find ("tags");
+  if (tags == data.end () || tag.empty ())
+    return false;
+
+  const std::string& list = tags->second;
+  std::string::size_type start = 0;
+  while ((start = list.find (tag, start)) != std::string::npos)
+  {
+    auto after = start + tag.length ();
+    if ((start == 0 || list[start - 1] == ',') &&
+        (after == list.length () || list[after] == ','))
+      return true;
+
+    start = after;
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Virtual tags that depend only on the attributes are memoized in the task
+// data, and are recalculated after any change to it.  Those that depend on
+// dependency state or the database are not.
+bool Task::hasVirtualTag (int tag) const
+{
+  switch (tag)
+  {
+  case vt_blocked:   return is_blocked;
+  case vt_unblocked: return !is_blocked;
+  case vt_blocking:  return is_blocking;
 #ifdef PRODUCT_TASKWARRIOR
-    if (tag == "UDA")       return is_udaPresent ();
-    if (tag == "ORPHAN")    return is_orphanPresent ();
-    if (tag == "LATEST")    return id == Context::getContext ().tdb2.latest_id ();
+  case vt_ready:     return is_ready ();
+  case vt_latest:    return id == Context::getContext ().tdb2.latest_id ();
 #endif
-    if (tag == "PROJECT")   return has ("project");
-    if (tag == "PRIORITY")  return has ("priority");
   }
 
-  // Concrete tags.
-  auto tags = split (get ("tags"), ',');
+  bool value = false;
+  if (data.get_flag (tag, value))
+    return value;
 
-  if (std::find (tags.begin (), tags.end (), tag) != tags.end ())
-    return true;
+  switch (tag)
+  {
+#ifdef PRODUCT_TASKWARRIOR
+  case vt_due:       value = is_due ();                                  break;
+  case vt_today:     value = is_duetoday ();                             break;
+  case vt_yesterday: value = is_dueyesterday ();                         break;
+  case vt_tomorrow:  value = is_duetomorrow ();                          break;
+  case vt_overdue:   value = is_overdue ();                              break;
+  case vt_week:      value = is_dueweek ();                              break;
+  case vt_month:     value = is_duemonth ();                             break;
+  case vt_quarter:   value = is_duequarter ();                           break;
+  case vt_year:      value = is_dueyear ();                              break;
+  case vt_uda:       value = is_udaPresent ();                           break;
+  case vt_orphan:    value = is_orphanPresent ();                        break;
+#endif
+  case vt_active:    value = has ("start");                              break;
+  case vt_scheduled: value = has ("scheduled");                          break;
+  case vt_instance:  value = has ("template") || has ("parent");         break;
+  case vt_until:     value = has ("until");                              break;
+  case vt_annotated: value = hasAnnotations ();                          break;
+  case vt_tagged:    value = has ("tags");                               break;
+  case vt_template:  value = has ("last") || has ("mask");               break;
+  case vt_waiting:   value = get ("status") == "waiting";                break;
+  case vt_pending:   value = get ("status") == "pending";                break;
+  case vt_completed: value = get ("status") == "completed";              break;
+  case vt_deleted:   value = get ("status") == "deleted";                break;
+  case vt_project:   value = has ("project");                            break;
+  case vt_priority:  value = has ("priority");                           break;
+  }
 
-  return false;
+  data.set_flag (tag, value);
+  return value;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 void Task::addTag (const std::string& tag)
 {
-  auto tags = split (get ("tags"), ',');
+  auto other = [&] (const char* field, size_t length)
+  {
+    return length != tag.length () || memcmp (field, tag.data (), length) != 0;
+  };
 
-  if (std::find (tags.begin (), tags.end (), tag) == tags.end ())
+  auto& tags = get_ref ("tags");
+  if (scanFields (tags, ',', other))
   {
-    tags.push_back (tag);
-    set ("tags", join (",", tags));
+    set ("tags", tags.empty () ? tag : tags + ',' + tag);
 
     recalc_urgency = true;
+    recalc_static = true;
   }
 }
 
@@ -1325,12 +2064,23 @@ void Task::addTags (const std::vector <std::string>& tags)
     addTag (tag);
 
   recalc_urgency = true;
+  recalc_static = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 std::vector <std::string> Task::getTags () const
 {
-  return split (get ("tags"), ',');
+  auto& tags = get_ref ("tags");
+  std::vector <std::string> all;
+  all.reserve (countFields (tags));
+
+  scanFields (tags, ',', [&] (const char* tag, size_t length)
+  {
+    all.emplace_back (tag, length);
+    return true;
+  });
+
+  return all;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1346,6 +2096,7 @@ void Task::removeTag (const std::string& tag)
   }
 
   recalc_urgency = true;
+  recalc_static = true;
 }
 
 #ifdef PRODUCT_TASKWARRIOR
@@ -1478,6 +2229,7 @@ void Task::substitute (
     set ("description", description);
     setAnnotations (annotations);
     recalc_urgency = true;
+    recalc_static = true;
   }
 }
 #endif
@@ -1495,15 +2247,20 @@ void Task::validate (bool applyDefault /* = true */)
     status = getStatus ();
 
   // 1) Provide missing attributes where possible
-  // Provide a UUID if necessary. Validate if present.
+  // Provide a UUID if necessary. Validate if present, where a canonical lower
+  // case UUID, as generated, is recognized without lexing.
   std::string uid = get ("uuid");
+  Uuid canonical;
   if (has ("uuid") && uid != "")
   {
-    Lexer lex (uid);
-    std::string token;
-    Lexer::Type type;
-    if (! lex.isUUID (token, type, true))
-      throw format ("Not a valid UUID '{1}'.", uid);
+    if (! Uuid::parse (uid, canonical))
+    {
+      Lexer lex (uid);
+      std::string token;
+      Lexer::Type type;
+      if (! lex.isUUID (token, type, true))
+        throw format ("Not a valid UUID '{1}'.", uid);
+    }
   }
   else
     set ("uuid", uuid ());
@@ -1672,6 +2429,8 @@ void Task::validate (bool applyDefault /* = true */)
         throw format ("The recurrence value '{1}' is not valid.", value);
     }
   }
+
+  validated = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1803,95 +2562,137 @@ int Task::determineVersion (const std::string& line)
 // See rfc31-urgency.txt for full details.
 //
 float Task::urgency_c () const
+{
+  Trace::Span span ("urgency");
+  float value = urgency_base ();
+#ifdef PRODUCT_TASKWARRIOR
+  if (is_blocking && Context::getContext ().config.getBoolean ("urgency.inherit"))
+    value = urgency_inherited (value, urgency_inherit ());
+#endif
+
+  return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Urgency from the task's own attributes, without inheritance.  The terms that
+// depend on neither the time nor other tasks may be kept from an earlier run.
+float Task::urgency_base () const
+{
+  float value = recalc_static ? urgency_static () : urgency_static_value;
+#ifdef PRODUCT_TASKWARRIOR
+  value += fabsf (Task::urgencyScheduledCoefficient)   > epsilon ? (urgency_scheduled ()   * Task::urgencyScheduledCoefficient)   : 0.0;
+  value += fabsf (Task::urgencyBlockedCoefficient)     > epsilon ? (urgency_blocked ()     * Task::urgencyBlockedCoefficient)     : 0.0;
+  value += fabsf (Task::urgencyDueCoefficient)         > epsilon ? (urgency_due ()         * Task::urgencyDueCoefficient)         : 0.0;
+  value += fabsf (Task::urgencyBlockingCoefficient)    > epsilon ? (urgency_blocking ()    * Task::urgencyBlockingCoefficient)    : 0.0;
+  value += fabsf (Task::urgencyAgeCoefficient)         > epsilon ? (urgency_age ()         * Task::urgencyAgeCoefficient)         : 0.0;
+#endif
+
+  return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The urgency terms that depend only on the task's own attributes and on the
+// urgency coefficients, which Task::urgencyKey identifies.
+float Task::urgency_static () const
 {
   float value = 0.0;
 #ifdef PRODUCT_TASKWARRIOR
   value += fabsf (Task::urgencyProjectCoefficient)     > epsilon ? (urgency_project ()     * Task::urgencyProjectCoefficient)     : 0.0;
   value += fabsf (Task::urgencyActiveCoefficient)      > epsilon ? (urgency_active ()      * Task::urgencyActiveCoefficient)      : 0.0;
-  value += fabsf (Task::urgencyScheduledCoefficient)   > epsilon ? (urgency_scheduled ()   * Task::urgencyScheduledCoefficient)   : 0.0;
   value += fabsf (Task::urgencyWaitingCoefficient)     > epsilon ? (urgency_waiting ()     * Task::urgencyWaitingCoefficient)     : 0.0;
-  value += fabsf (Task::urgencyBlockedCoefficient)     > epsilon ? (urgency_blocked ()     * Task::urgencyBlockedCoefficient)     : 0.0;
   value += fabsf (Task::urgencyAnnotationsCoefficient) > epsilon ? (urgency_annotations () * Task::urgencyAnnotationsCoefficient) : 0.0;
   value += fabsf (Task::urgencyTagsCoefficient)        > epsilon ? (urgency_tags ()        * Task::urgencyTagsCoefficient)        : 0.0;
-  value += fabsf (Task::urgencyDueCoefficient)         > epsilon ? (urgency_due ()         * Task::urgencyDueCoefficient)         : 0.0;
-  value += fabsf (Task::urgencyBlockingCoefficient)    > epsilon ? (urgency_blocking ()    * Task::urgencyBlockingCoefficient)    : 0.0;
-  value += fabsf (Task::urgencyAgeCoefficient)         > epsilon ? (urgency_age ()         * Task::urgencyAgeCoefficient)         : 0.0;
 
   // Tag- and project-specific coefficients.
+  for (auto& rule : Task::userCoefficients)
+    value += urgency_coefficient (rule);
+#endif
+
+  return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Parses the names of the user and UDA coefficients into Task::userCoefficients,
+// in the order of Task::coefficients, so that urgency needs no string handling
+// beyond the comparisons themselves.  Coefficients of zero are dropped.
+void Task::compileCoefficients ()
+{
+  userCoefficients.clear ();
   for (auto& var : Task::coefficients)
   {
-    if (fabs (var.second) > epsilon)
+    if (fabs (var.second) <= epsilon)
+      continue;
+
+    Coefficient rule {Coefficient::project, "", "", 0, var.second};
+    auto end = var.first.find (".coefficient");
+    if (end == std::string::npos)
+      continue;
+
+    if (! var.first.compare (0, 13, "urgency.user.", 13))
     {
-      if (! var.first.compare (0, 13, "urgency.user.", 13))
+      // urgency.user.project.<project>.coefficient
+      if (var.first.substr (13, 8) == "project.")
       {
-        // urgency.user.project.<project>.coefficient
-        auto end = std::string::npos;
-        if (var.first.substr (13, 8) == "project." &&
-            (end = var.first.find (".coefficient")) != std::string::npos)
-        {
-          std::string project = var.first.substr (21, end - 21);
+        rule.name = var.first.substr (21, end - 21);
+        userCoefficients.push_back (rule);
+      }
 
-          if (get ("project").find (project) == 0)
-            value += var.second;
-        }
+      // urgency.user.tag.<tag>.coefficient
+      else if (var.first.substr (13, 4) == "tag.")
+      {
+        rule.kind = Coefficient::tag;
+        rule.name = var.first.substr (17, end - 17);
 
-        // urgency.user.tag.<tag>.coefficient
-        if (var.first.substr (13, 4) == "tag." &&
-            (end = var.first.find (".coefficient")) != std::string::npos)
+        auto virtualTag = virtualTags.find (rule.name);
+        if (rule.name != "" && isupper (rule.name[0]) && virtualTag != virtualTags.end ())
         {
-          std::string tag = var.first.substr (17, end - 17);
-
-          if (hasTag (tag))
-            value += var.second;
+          rule.kind           = Coefficient::virtual_tag;
+          rule.virtual_tag_id = virtualTag->second;
         }
 
-        // urgency.user.keyword.<keyword>.coefficient
-        if (var.first.substr (13, 8) == "keyword." &&
-            (end = var.first.find (".coefficient")) != std::string::npos)
-        {
-          std::string keyword = var.first.substr (21, end - 21);
+        userCoefficients.push_back (rule);
+      }
 
-          if (get ("description").find (keyword) != std::string::npos)
-            value += var.second;
-        }
+      // urgency.user.keyword.<keyword>.coefficient
+      else if (var.first.substr (13, 8) == "keyword.")
+      {
+        rule.kind = Coefficient::keyword;
+        rule.name = var.first.substr (21, end - 21);
+        userCoefficients.push_back (rule);
       }
-      else if (var.first.substr (0, 12) == "urgency.uda.")
+    }
+    else if (var.first.substr (0, 12) == "urgency.uda.")
+    {
+      // urgency.uda.<name>.coefficient
+      // urgency.uda.<name>.<value>.coefficient
+      const std::string uda = var.first.substr (12, end - 12);
+      auto dot = uda.find ('.');
+      if (dot == std::string::npos)
       {
-        // urgency.uda.<name>.coefficient
-        // urgency.uda.<name>.<value>.coefficient
-        auto end = var.first.find (".coefficient");
-        if (end != std::string::npos)
-        {
-          const std::string uda = var.first.substr (12, end - 12);
-          auto dot = uda.find ('.');
-          if (dot == std::string::npos)
-          {
-            // urgency.uda.<name>.coefficient
-            if (has (uda))
-              value += var.second;
-          }
-          else
-          {
-            // urgency.uda.<name>.<value>.coefficient
-            if (get (uda.substr(0, dot)) == uda.substr(dot+1))
-              value += var.second;
-          }
-        }
+        rule.kind = Coefficient::uda;
+        rule.name = uda;
       }
+      else
+      {
+        rule.kind  = Coefficient::uda_value;
+        rule.name  = uda.substr (0, dot);
+        rule.value = uda.substr (dot + 1);
+      }
+
+      userCoefficients.push_back (rule);
     }
   }
+}
 
-  if (is_blocking && Context::getContext ().config.getBoolean ("urgency.inherit"))
-  {
-    float prev = value;
-    value = std::max (value, urgency_inherit ());
-
-    // This is a hackish way of making sure parent tasks are sorted above
-    // child tasks.  For reports that hide blocked tasks, this is not needed.
-    if (prev < value)
-      value += 0.01;
-  }
-#endif
+////////////////////////////////////////////////////////////////////////////////
+// Combines a blocking task's own urgency with the highest urgency of the tasks
+// it blocks.
+float Task::urgency_inherited (float value, float inherited)
+{
+  // This is a hackish way of making sure parent tasks are sorted above
+  // child tasks.  For reports that hide blocked tasks, this is not needed.
+  if (value < inherited)
+    value = inherited + 0.01;
 
   return value;
 }
@@ -2011,11 +2812,8 @@ float Task::urgency_due () const
 {
   if (has ("due"))
   {
-    Datetime now;
-    Datetime due (get_date ("due"));
-
     // Map a range of 21 days to the value 0.2 - 1.0
-    float days_overdue = (now - due) / 86400.0;
+    float days_overdue = (time (nullptr) - get_date ("due")) / 86400.0;
          if (days_overdue >= 7.0)   return 1.0;   // < 1 wk ago
     else if (days_overdue >= -14.0) return ((days_overdue + 14.0) * 0.8 / 21.0) + 0.2;
     else                            return 0.2;   // > 2 wks
@@ -2029,9 +2827,7 @@ float Task::urgency_age () const
 {
   assert (has ("entry"));
 
-  Datetime now;
-  Datetime entry (get_date ("entry"));
-  int age = (now - entry) / 86400;  // in days
+  int age = (time (nullptr) - get_date ("entry")) / 86400;  // in days
 
   if (Task::urgencyAgeMax == 0 || age > Task::urgencyAgeMax)
     return 1.0;
@@ -2039,6 +2835,24 @@ float Task::urgency_age () const
   return (1.0 * age / Task::urgencyAgeMax);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// The contribution of a user or UDA coefficient, if it applies to the task.
+float Task::urgency_coefficient (const Coefficient& rule) const
+{
+  bool applies = false;
+  switch (rule.kind)
+  {
+  case Coefficient::project:     applies = get_ref ("project").compare (0, rule.name.length (), rule.name) == 0; break;
+  case Coefficient::tag:         applies = hasTag (rule.name);                                                   break;
+  case Coefficient::virtual_tag: applies = hasVirtualTag (rule.virtual_tag_id);                                  break;
+  case Coefficient::keyword:     applies = get_ref ("description").find (rule.name) != std::string::npos;       break;
+  case Coefficient::uda:         applies = has (rule.name);                                                      break;
+  case Coefficient::uda_value:   applies = get_ref (rule.name) == rule.value;                                    break;
+  }
+
+  return applies ? rule.coefficient : 0.0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 float Task::urgency_blocking () const
 {
@@ -2066,7 +2880,7 @@ void Task::modify (modType type, bool text_required /* = false */)
   bool mods = false;
   for (auto& a : Context::getContext ().cli2._args)
   {
-    if (a.hasTag ("MODIFICATION"))
+    if (a.hasTag (A2::Tag::MODIFICATION))
     {
       if (a._lextype == Lexer::Type::pair)
       {
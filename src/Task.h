@@ -29,10 +29,13 @@
 
 #include <vector>
 #include <map>
+#include <set>
 #include <string>
 #include <stdio.h>
+#include <stdint.h>
 #include <time.h>
 #include <JSON.h>
+#include <AttributeMap.h>
 
 class Task
 {
@@ -44,6 +47,19 @@ public:
   static bool regex;
   static std::map <std::string, std::string> attributes;  // name -> type
   static std::map <std::string, float> coefficients;
+
+  // A user or UDA coefficient, parsed from its name once, by
+  // Task::compileCoefficients.
+  struct Coefficient
+  {
+    enum kind {project, tag, virtual_tag, keyword, uda, uda_value};
+    enum kind   kind;
+    std::string name;
+    std::string value;
+    int         virtual_tag_id;
+    float       coefficient;
+  };
+  static std::vector <Coefficient> userCoefficients;
   static std::map <std::string, std::vector <std::string>> customOrder;
   static float urgencyProjectCoefficient;
   static float urgencyActiveCoefficient;
@@ -56,6 +72,29 @@ public:
   static float urgencyBlockingCoefficient;
   static float urgencyAgeCoefficient;
   static float urgencyAgeMax;
+  static uint32_t urgencyKey;
+
+  // The boundaries of the date states and due virtual tags, as epochs, found
+  // once per command by Task::compileTimeFrame, so that the tests compare
+  // integers.  The ends of the periods are inclusive.
+  struct TimeFrame
+  {
+    time_t now        {0};
+    time_t yesterday  {0};
+    time_t today      {0};
+    time_t tomorrow   {0};
+    time_t overmorrow {0};
+    time_t imminent   {0};
+    time_t sow        {0};
+    time_t eow        {0};
+    time_t som        {0};
+    time_t eom        {0};
+    time_t soq        {0};
+    time_t eoq        {0};
+    time_t soy        {0};
+    time_t eoy        {0};
+  };
+  static TimeFrame timeFrame;
 
 public:
   Task () = default;
@@ -64,8 +103,12 @@ public:
   Task (const json::object*);
 
   void parse (const std::string&);
+  bool readJSON (const std::string&);
   std::string composeF4 () const;
+  void composeF4 (std::string&) const;
   std::string composeJSON (bool decorate = false) const;
+  void composeJSON (std::string&, bool decorate = false, const std::set <std::string>* fields = nullptr) const;
+  size_t bytes () const;
 
   // Status values.
   enum status {pending, completed, deleted, recurring, waiting};
@@ -74,14 +117,21 @@ public:
   enum dateState {dateNotDue, dateAfterToday, dateLaterToday, dateEarlierToday, dateBeforeToday};
 
   // Public data.
-  std::map <std::string, std::string> data {};
+  AttributeMap data {};
   int id                                   {0};
   float urgency_value                      {0.0};
   bool recalc_urgency                      {true};
+  float urgency_static_value               {0.0};
+  bool recalc_static                       {true};
   bool is_blocked                          {false};
   bool is_blocking                         {false};
   int annotation_count                     {0};
 
+  // Set by validate, so that a task passed on unchanged, as by hooks that
+  // leave it alone, need not be validated again.  A task any hook replaced is
+  // a new Task, without the flag.
+  bool validated                           {false};
+
   // Series of helper functions.
   static status textToStatus (const std::string&);
   static std::string statusToText (status);
@@ -132,6 +182,7 @@ public:
   int getAnnotationCount () const;
   bool hasAnnotations () const;
   std::map <std::string, std::string> getAnnotations () const;
+  AttributeMap::range annotations () const;
   void setAnnotations (const std::map <std::string, std::string>&);
   void addAnnotation (const std::string&);
   void removeAnnotations ();
@@ -140,6 +191,7 @@ public:
   void addDependency (int);
 #endif
   void addDependency (const std::string&);
+  bool hasDependency (const std::string&) const;
 #ifdef PRODUCT_TASKWARRIOR
   void removeDependency (int);
   void removeDependency (const std::string&);
@@ -155,7 +207,12 @@ public:
   void validate (bool applyDefault = true);
 
   float urgency_c () const;
+  float urgency_base () const;
+  float urgency_static () const;
   float urgency ();
+  static float urgency_inherited (float, float);
+  static void compileCoefficients ();
+  static void compileTimeFrame ();
 
 #ifdef PRODUCT_TASKWARRIOR
   enum modType {modReplace, modPrepend, modAppend, modAnnotate};
@@ -166,10 +223,13 @@ private:
   int determineVersion (const std::string&);
   void parseJSON (const std::string&);
   void parseJSON (const json::object*);
+  bool parseF4 (const std::string&);
   void parseLegacy (const std::string&);
   void validate_before (const std::string&, const std::string&);
+  static void composeJSONArray (std::string&, const std::string&);
   const std::string encode (const std::string&) const;
   const std::string decode (const std::string&) const;
+  bool hasVirtualTag (int) const;
 
 public:
   float urgency_project     () const;
@@ -183,6 +243,7 @@ public:
   float urgency_due         () const;
   float urgency_blocking    () const;
   float urgency_age         () const;
+  float urgency_coefficient (const Coefficient&) const;
 };
 
 #endif
@@ -0,0 +1,153 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmake.h>
+#include <Trace.h>
+#include <Allocations.h>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+#include <JSON.h>
+#include <Timer.h>
+
+bool Trace::_enabled = false;
+
+// Started with the process, so that every span is timed from its start.
+static Timer since_start;
+
+struct Event
+{
+  const char*   name;
+  std::string   detail;
+  unsigned long start;
+  unsigned long duration;
+  uint64_t      count;
+  uint64_t      bytes;
+  int           thread;
+};
+
+static std::mutex events_mutex;
+static std::vector <Event> events;
+
+// Threads are numbered in the order in which they first record a span.
+static std::atomic <int> threads {0};
+static thread_local int thread_number = ++threads;
+
+////////////////////////////////////////////////////////////////////////////////
+void Trace::Span::begin (const std::string* detail)
+{
+  if (detail)
+    _detail = *detail;
+
+  _start = since_start.total_us ();
+  _count = Allocations::threadCount ();
+  _bytes = Allocations::threadBytes ();
+  _active = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Trace::Span::end ()
+{
+  record (_name, _detail, _start, since_start.total_us () - _start,
+          Allocations::threadCount () - _count,
+          Allocations::threadBytes () - _bytes);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Trace::enable ()
+{
+  _enabled = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Records a span that ends now, and was timed elsewhere.
+void Trace::add (const char* name, unsigned long duration)
+{
+  if (_enabled)
+  {
+    auto now = since_start.total_us ();
+    record (name, "", duration < now ? now - duration : 0, duration, 0, 0);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Writes all the spans as complete events, 'ph' 'X', with times in
+// microseconds.
+bool Trace::write (const std::string& file)
+{
+  std::lock_guard <std::mutex> lock (events_mutex);
+
+  std::ofstream out (file, std::ios::trunc);
+  out << "{\"traceEvents\":[";
+
+  auto pid = (int) getpid ();
+  auto counted = Allocations::enabled ();
+  bool first = true;
+  for (auto& event : events)
+  {
+    out << (first ? "\n" : ",\n")
+        << "{\"name\":\""  << event.name << '"'
+        << ",\"cat\":\"task\",\"ph\":\"X\""
+        << ",\"ts\":"      << event.start
+        << ",\"dur\":"     << event.duration
+        << ",\"pid\":"     << pid
+        << ",\"tid\":"     << event.thread;
+
+    if (event.detail != "" || counted)
+    {
+      out << ",\"args\":{";
+      if (event.detail != "")
+        out << "\"detail\":\"" << json::encode (event.detail) << '"' << (counted ? "," : "");
+      if (counted)
+        out << "\"allocations\":" << event.count << ",\"bytes\":" << event.bytes;
+      out << '}';
+    }
+
+    out << '}';
+    first = false;
+  }
+
+  out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return (bool) out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Trace::record (
+  const char* name,
+  const std::string& detail,
+  unsigned long start,
+  unsigned long duration,
+  uint64_t count,
+  uint64_t bytes)
+{
+  std::lock_guard <std::mutex> lock (events_mutex);
+  events.push_back (Event {name, detail, start, duration, count, bytes, thread_number});
+}
+
+////////////////////////////////////////////////////////////////////////////////
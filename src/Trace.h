@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef INCLUDED_TRACE
+#define INCLUDED_TRACE
+
+#include <string>
+#include <stdint.h>
+
+// Trace records spans, which are named intervals of time on a thread, while
+// enabled by rc.trace.file, and writes them in the Chrome trace event format,
+// which chrome://tracing and other profilers load.  While tracing is disabled,
+// a span costs a single test of a flag.
+//
+// When allocations are counted, each span also records those made on its
+// thread while it was open.
+class Trace
+{
+public:
+  class Span
+  {
+  public:
+    explicit Span (const char* name) : _name (name)                            { if (_enabled) begin (nullptr); }
+    Span (const char* name, const std::string& detail) : _name (name)          { if (_enabled) begin (&detail); }
+    Span (const Span&) = delete;
+    Span& operator= (const Span&) = delete;
+    ~Span ()                                                                   { if (_active) end (); }
+
+  private:
+    void begin (const std::string*);
+    void end ();
+
+  private:
+    const char*   _name;
+    std::string   _detail {};
+    unsigned long _start  {0};
+    uint64_t      _count  {0};
+    uint64_t      _bytes  {0};
+    bool          _active {false};
+  };
+
+  static void enable ();
+  static bool enabled ()    { return _enabled; }
+  static void add (const char*, unsigned long);
+  static bool write (const std::string&);
+
+private:
+  static void record (const char*, const std::string&, unsigned long, unsigned long, uint64_t, uint64_t);
+
+private:
+  static bool _enabled;
+};
+
+#endif
+////////////////////////////////////////////////////////////////////////////////
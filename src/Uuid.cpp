@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmake.h>
+#include <Uuid.h>
+#include <cstring>
+
+// The value of each hex digit, or -1.
+static const signed char digits[256] =
+{
+#define X -1
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  0, 1, 2, 3, 4, 5, 6, 7, 8, 9, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X,10,11,12,13,14,15, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+#undef X
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Parses xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx, lower case.
+bool Uuid::parse (const std::string& text, Uuid& uuid)
+{
+  return parse (text.data (), text.size (), uuid);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// As above, for a field of a longer string.
+bool Uuid::parse (const char* text, size_t length, Uuid& uuid)
+{
+  if (length != 36 ||
+      text[8] != '-' || text[13] != '-' || text[18] != '-' || text[23] != '-')
+    return false;
+
+  uint64_t words[2] {0, 0};
+  int nibbles = 0;
+  for (size_t i = 0; i < length; ++i)
+  {
+    auto c = text[i];
+    if (c == '-')
+      continue;
+
+    auto digit = digits[(unsigned char) c];
+    if (digit < 0)
+      return false;
+
+    auto& word = words[nibbles++ / 16];
+    word = (word << 4) | (uint64_t) digit;
+  }
+
+  // A hyphen out of place leaves too few digits.
+  if (nibbles != 32)
+    return false;
+
+  uuid._hi = words[0];
+  uuid._lo = words[1];
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The UUIDs of a comma-separated list, such as the depends attribute.  Any
+// that are not UUIDs are skipped.
+void Uuid::parse_list (const std::string& text, std::vector <Uuid>& uuids)
+{
+  auto start = text.data ();
+  auto end   = start + text.size ();
+  while (start < end)
+  {
+    auto comma = (const char*) memchr (start, ',', end - start);
+    if (! comma)
+      comma = end;
+
+    Uuid uuid;
+    if (parse (start, comma - start, uuid))
+      uuids.push_back (uuid);
+
+    start = comma + 1;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::string Uuid::str () const
+{
+  static const char hex[] = "0123456789abcdef";
+
+  std::string text (36, '-');
+  int nibble = 0;
+  for (int i = 0; i < 36; ++i)
+  {
+    if (i == 8 || i == 13 || i == 18 || i == 23)
+      continue;
+
+    auto word = nibble < 16 ? _hi : _lo;
+    text[i] = hex[(word >> (60 - 4 * (nibble % 16))) & 0xf];
+    ++nibble;
+  }
+
+  return text;
+}
+
+////////////////////////////////////////////////////////////////////////////////
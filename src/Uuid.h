@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef INCLUDED_UUID
+#define INCLUDED_UUID
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <stdint.h>
+
+// A UUID as its 128-bit value, so that it is compared and hashed as two words
+// rather than 36 characters.  Only the canonical lower case form is parsed,
+// which is what task generates, so that the text is recovered exactly.
+class Uuid
+{
+public:
+  Uuid () = default;
+  static bool parse (const std::string&, Uuid&);
+  static bool parse (const char*, size_t, Uuid&);
+  static void parse_list (const std::string&, std::vector <Uuid>&);
+
+  std::string str () const;
+
+  bool operator== (const Uuid& other) const  { return _hi == other._hi && _lo == other._lo; }
+  bool operator!= (const Uuid& other) const  { return ! (*this == other); }
+  bool operator<  (const Uuid& other) const  { return _hi < other._hi || (_hi == other._hi && _lo < other._lo); }
+  size_t hash () const                       { return (size_t) (_hi ^ (_lo * 0x9e3779b97f4a7c15ULL)); }
+
+private:
+  uint64_t _hi {0};
+  uint64_t _lo {0};
+};
+
+namespace std
+{
+  template <> struct hash <Uuid>
+  {
+    size_t operator() (const Uuid& uuid) const { return uuid.hash (); }
+  };
+}
+
+#endif
+////////////////////////////////////////////////////////////////////////////////
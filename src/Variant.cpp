@@ -31,10 +31,10 @@
 #include <math.h>
 #include <stdlib.h>
 #include <Variant.h>
+#include <Pattern.h>
 #include <Datetime.h>
 #include <Duration.h>
 #include <Lexer.h>
-#include <RX.h>
 #include <shared.h>
 
 // These are all error messages generated by the expression evaluator, and are
@@ -92,19 +92,6 @@ std::string Variant::dateFormat = "";
 bool Variant::searchCaseSensitive = true;
 bool Variant::searchUsingRegex = true;
 
-////////////////////////////////////////////////////////////////////////////////
-Variant::Variant (const Variant& other)
-{
-  _type     = other._type;
-  _bool     = other._bool;
-  _integer  = other._integer;
-  _real     = other._real;
-  _string   = other._string;
-  _date     = other._date;
-  _duration = other._duration;
-  _source   = other._source;
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 Variant::Variant (const bool value)
 : _type (Variant::type_boolean)
@@ -165,21 +152,6 @@ const std::string& Variant::source () const
   return _source;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-Variant& Variant::operator= (const Variant& other)
-{
-  _type     = other._type;
-  _bool     = other._bool;
-  _integer  = other._integer;
-  _real     = other._real;
-  _string   = other._string;
-  _date     = other._date;
-  _duration = other._duration;
-  _source   = other._source;
-
-  return *this;
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 bool Variant::operator&& (const Variant& other) const
 {
@@ -897,71 +869,7 @@ bool Variant::operator!= (const Variant& other) const
 ////////////////////////////////////////////////////////////////////////////////
 bool Variant::operator_match (const Variant& other, const Task& task) const
 {
-  // Simple matching case first.
-  Variant left (*this);
-  Variant right (other);
-
-  if (left._type == type_string)
-    Lexer::dequote (left._string);
-
-  if (right._type == type_string)
-    Lexer::dequote (right._string);
-
-  left.cast (type_string);
-  right.cast (type_string);
-
-  std::string pattern = right._string;
-  Lexer::dequote (pattern);
-
-  if (searchUsingRegex)
-  {
-    RX r (pattern, searchCaseSensitive);
-    if (r.match (left._string))
-      return true;
-
-    // If the above did not match, and the left source is "description", then
-    // in the annotations.
-    if (left.source () == "description")
-    {
-      for (auto& a : task.getAnnotations ())
-        if (r.match (a.second))
-          return true;
-    }
-  }
-  else
-  {
-    // If pattern starts with '^', look for a leftmost compare only.
-    if (pattern[0] == '^' &&
-        find (left._string,
-              pattern.substr (1),
-              searchCaseSensitive) == 0)
-    {
-      return true;
-    }
-
-    // If pattern ends with '$', look for a rightmost compare only.
-    else if (pattern[pattern.length () - 1] == '$' &&
-             find (left._string,
-                   pattern.substr (0, pattern.length () - 1),
-                   searchCaseSensitive) == (left._string.length () - pattern.length () + 1))
-    {
-      return true;
-    }
-
-    else if (find (left._string, pattern, searchCaseSensitive) != std::string::npos)
-      return true;
-
-    // If the above did not match, and the left source is "description", then
-    // in the annotations.
-    if (left.source () == "description")
-    {
-      for (auto& a : task.getAnnotations ())
-        if (find (a.second, pattern, searchCaseSensitive) != std::string::npos)
-          return true;
-    }
-  }
-
-  return false;
+  return Pattern (other).match (*this, task);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1951,7 +1859,7 @@ void Variant::cast (const enum type new_type)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-int Variant::type ()
+int Variant::type () const
 {
   return _type;
 }
@@ -43,7 +43,8 @@ public:
   enum type {type_boolean, type_integer, type_real, type_string, type_date, type_duration};
 
   Variant () = default;
-  Variant (const Variant&);
+  Variant (const Variant&) = default;
+  Variant (Variant&&) = default;
   Variant (const bool);
   Variant (const int);
   Variant (const double);
@@ -54,7 +55,8 @@ public:
   void source (const std::string&);
   const std::string& source () const;
 
-  Variant& operator= (const Variant&);
+  Variant& operator= (const Variant&) = default;
+  Variant& operator= (Variant&&) = default;
 
   bool operator&& (const Variant&) const;
   bool operator|| (const Variant&) const;
@@ -95,7 +97,7 @@ public:
   void sqrt ();
 
   void cast (const enum type);
-  int type ();
+  int type () const;
   bool trivial () const;
 
   bool               get_bool () const;
@@ -26,13 +26,19 @@
 
 #include <cmake.h>
 #include <ViewTask.h>
+#include <algorithm>
 #include <numeric>
 #include <Context.h>
+#include <Pool.h>
+#include <Trace.h>
 #include <format.h>
 #include <util.h>
 #include <utf8.h>
 #include <main.h>
 
+#define RENDER_BLOCK 65536
+#define RENDER_PARALLEL_MINIMUM 1000
+
 ////////////////////////////////////////////////////////////////////////////////
 ViewTask::ViewTask ()
 : _width (0)
@@ -49,6 +55,7 @@ ViewTask::ViewTask ()
 , _extra_even (0)
 , _truncate_lines (0)
 , _truncate_rows (0)
+, _sample (0)
 , _lines (0)
 , _rows (0)
 {
@@ -63,6 +70,27 @@ ViewTask::~ViewTask ()
   _columns.clear ();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+std::string ViewTask::render (std::vector <Task>& data, std::vector <int>& sequence)
+{
+  auto out = compose (data, sequence, nullptr);
+  Context::getContext ().count_rendered += _rows;
+  Context::getContext ().memory_render = std::max (Context::getContext ().memory_render, (long) out.capacity ());
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Writes the rendered view to the stream as it is composed, so that the first
+// rows are seen before the last are composed, and the whole view is never held
+// in memory.
+void ViewTask::render (std::vector <Task>& data, std::vector <int>& sequence, std::ostream& stream)
+{
+  auto out = compose (data, sequence, &stream);
+  stream << out;
+  Context::getContext ().count_rendered += _rows;
+  Context::getContext ().memory_render = std::max (Context::getContext ().memory_render, (long) out.capacity ());
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //   |<---------- terminal width ---------->|
 //
@@ -87,7 +115,9 @@ ViewTask::~ViewTask ()
 //
 //   - Look at every column, for every task, and determine the minimum and
 //     maximum widths.  The minimum is the length of the largest indivisible
-//     word, and the maximum is the full length of the value.
+//     word, and the maximum is the full length of the value.  With a sample
+//     size, only that many evenly spaced tasks are measured, and any wider
+//     value is wrapped to fit.
 //   - If there is sufficient terminal width to display every task using the
 //     maximum width, then do so.
 //   - If there is insufficient terminal width to display every task using the
@@ -106,8 +136,9 @@ ViewTask::~ViewTask ()
 //       the larger fields.  If the widest field is W0, and the second widest
 //       field is W1, then a solution may be achievable by reducing W0 --> W1.
 //
-std::string ViewTask::render (std::vector <Task>& data, std::vector <int>& sequence)
+std::string ViewTask::compose (std::vector <Task>& data, std::vector <int>& sequence, std::ostream* stream)
 {
+  Trace::Span span ("render");
   Timer timer;
 
   bool const obfuscate           = Context::getContext ().config.getBoolean ("obfuscate");
@@ -125,21 +156,31 @@ std::string ViewTask::render (std::vector <Task>& data, std::vector <int>& seque
     unsigned int global_min = 0;
     unsigned int global_ideal = global_min;
 
-    for (unsigned int s = 0; s < sequence.size (); ++s)
-    {
-      if ((int)s >= _truncate_lines && _truncate_lines != 0)
-        break;
+    // Cells measured by an earlier render are stale.
+    _columns[i]->clearCells ();
 
-      if ((int)s >= _truncate_rows && _truncate_rows != 0)
-        break;
-
-      // Determine minimum and ideal width for this column.
+    // Determine minimum and ideal width for this column.
+    auto measure = [&] (unsigned int s)
+    {
       unsigned int min = 0;
       unsigned int ideal = 0;
       _columns[i]->measure (data[sequence[s]], min, ideal);
 
       if (min   > global_min)   global_min   = min;
       if (ideal > global_ideal) global_ideal = ideal;
+    };
+
+    unsigned int count = sequence.size ();
+    if (_truncate_lines != 0 && (unsigned int) _truncate_lines < count)
+      count = _truncate_lines;
+
+    if (_truncate_rows != 0 && (unsigned int) _truncate_rows < count)
+      count = _truncate_rows;
+
+    unsigned int measured = _sample > 0 && (unsigned int) _sample < count ? _sample : count;
+    for (unsigned int k = 0; k < measured; ++k)
+    {
+      measure (measured == count ? k : (unsigned int) ((uint64_t) k * count / measured));
 
       // If a fixed-width column was just measured, there is no point repeating
       // the measurement for all tasks.
@@ -147,9 +188,15 @@ std::string ViewTask::render (std::vector <Task>& data, std::vector <int>& seque
         break;
     }
 
+    // A column that is empty in the sample is only dropped if it is empty for
+    // every task.
+    if (! print_empty_columns && global_min == 0 && measured < count)
+      for (unsigned int s = 0; s < count && global_min == 0; ++s)
+        measure (s);
+
     if (print_empty_columns || global_min != 0)
     {
-      unsigned int label_length = utf8_width (_columns[i]->label ());
+      unsigned int label_length = textWidth (_columns[i]->label ());
       if (label_length > global_min)   global_min   = label_length;
       if (label_length > global_ideal) global_ideal = label_length;
       minimal.push_back (global_min);
@@ -290,13 +337,21 @@ std::string ViewTask::render (std::vector <Task>& data, std::vector <int>& seque
     }
   }
 
-  // Compose, render columns, in sequence.
-  _rows = 0;
-  std::vector <std::vector <std::string>> cells;
-  for (unsigned int s = 0; s < sequence.size (); ++s)
+  // The padding of a cell with fewer lines than its row, and the length of
+  // a whole line, which is reserved for each line.
+  std::vector <std::string> blanks;
+  size_t line_length = left_margin.length () + 2 * extra_odd.length ();
+  for (unsigned int c = 0; c < _columns.size (); ++c)
   {
-    max_lines = 0;
+    blanks.push_back (std::string (widths[c], ' '));
+    line_length += widths[c] + (c ? intra_odd.length () : 0);
+  }
 
+  // Compose each row into its lines.  Rows are independent once the widths
+  // are fixed, so this may run concurrently for different rows, each thread
+  // reusing its cells from row to row.
+  auto compose_row = [&] (unsigned int s, std::vector <std::vector <std::string>>& cells, std::vector <std::string>& lines)
+  {
     // Apply color rules to task.
     Color rule_color;
     autoColorize (data[sequence[s]], rule_color);
@@ -310,9 +365,11 @@ std::string ViewTask::render (std::vector <Task>& data, std::vector <int>& seque
       row_color.blend (rule_color);
     }
 
+    unsigned int max_lines = 0;
+    cells.resize (_columns.size ());
     for (unsigned int c = 0; c < _columns.size (); ++c)
     {
-      cells.push_back (std::vector <std::string> ());
+      cells[c].clear ();
       _columns[c]->render (cells[c], data[sequence[s]], widths[c], row_color);
 
       if (cells[c].size () > max_lines)
@@ -324,65 +381,131 @@ std::string ViewTask::render (std::vector <Task>& data, std::vector <int>& seque
             cells[c][line] = obfuscateText (cells[c][line]);
     }
 
-    // Listing breaks are simply blank lines inserted when a column value
-    // changes.
-    if (s > 0 &&
-        _breaks.size () > 0)
-    {
-      for (auto& b : _breaks)
-      {
-        if (data[sequence[s - 1]].get (b) != data[sequence[s]].get (b))
-        {
-          out += "\n";
-          ++_lines;
-
-          // Only want one \n, regardless of how many values change.
-          break;
-        }
-      }
-    }
-
     for (unsigned int i = 0; i < max_lines; ++i)
     {
-      out += left_margin + (odd ? extra_odd : extra_even);
+      std::string line;
+      line.reserve (line_length);
+      line += left_margin;
+      line += (odd ? extra_odd : extra_even);
 
       for (unsigned int c = 0; c < _columns.size (); ++c)
       {
         if (c)
         {
           if (row_color.nontrivial ())
-            row_color._colorize (out, intra);
+            colorizeAppend (line, row_color, intra);
           else
-            out += (odd ? intra_odd : intra_even);
+            line += (odd ? intra_odd : intra_even);
         }
 
         if (i < cells[c].size ())
-          out += cells[c][i];
+          line += cells[c][i];
         else
-          row_color._colorize (out, std::string (widths[c], ' '));
+          colorizeAppend (line, row_color, blanks[c]);
       }
 
-      out += (odd ? extra_odd : extra_even);
+      line += (odd ? extra_odd : extra_even);
 
       // Trim right.
-      out.erase (out.find_last_not_of (" ") + 1);
-      out += "\n";
+      line.erase (line.find_last_not_of (" ") + 1);
+      line += "\n";
+      lines.push_back (std::move (line));
+    }
+  };
 
-      // Stop if the line limit is exceeded.
-      if (++_lines >= _truncate_lines && _truncate_lines != 0)
+  // Every row takes at least one line, so no more than the limit of rows or
+  // lines are composed.  Large views are composed in blocks, each split
+  // among the threads, so that little is composed beyond a limit that wrapped
+  // rows reach early.  The first row is composed alone, so that any state built
+  // on first use, such as the dependency graph, is built before the threads.
+  unsigned int count = sequence.size ();
+  if (_truncate_lines != 0 && (unsigned int) _truncate_lines < count)
+    count = _truncate_lines;
+
+  if (_truncate_rows != 0 && (unsigned int) _truncate_rows < count)
+    count = _truncate_rows;
+
+  // Inherited urgency looks up other tasks, so is rendered in one thread.
+  size_t threads = Context::getContext ().config.getInteger ("render.threads");
+  if (threads == 0)
+    threads = Pool::threads ();
+
+  if (Context::getContext ().config.getBoolean ("urgency.inherit"))
+    threads = 1;
+
+  threads = std::min (threads, (size_t) count / RENDER_PARALLEL_MINIMUM);
+
+  // Compose, render columns, in sequence.
+  _rows = 0;
+  std::vector <std::vector <std::string>> rows;
+  std::vector <std::vector <std::string>> cells;
+  for (unsigned int first = 0; first < sequence.size (); first += rows.size ())
+  {
+    unsigned int block = threads > 1 && first > 0 ? threads * RENDER_PARALLEL_MINIMUM : 1;
+    rows.assign (std::min (block, (unsigned int) sequence.size () - first), {});
+
+    if (rows.size () == 1)
+      compose_row (first, cells, rows[0]);
+    else
+    {
+      auto chunk = (rows.size () + threads - 1) / threads;
+      Pool::run (threads, [&] (size_t t)
       {
-        Context::getContext ().time_render_us += timer.total_us ();
-        return out;
-      }
+        std::vector <std::vector <std::string>> local;
+        auto end = std::min (rows.size (), (t + 1) * chunk);
+        for (auto r = t * chunk; r < end; ++r)
+          compose_row (first + r, local, rows[r]);
+      });
     }
 
-    cells.clear ();
-
-    // Stop if the row limit is exceeded.
-    if (++_rows >= _truncate_rows && _truncate_rows != 0)
+    for (unsigned int r = 0; r < rows.size (); ++r)
     {
-      Context::getContext ().time_render_us += timer.total_us ();
-      return out;
+      unsigned int s = first + r;
+
+      // Listing breaks are simply blank lines inserted when a column value
+      // changes.
+      if (s > 0 &&
+          _breaks.size () > 0)
+      {
+        for (auto& b : _breaks)
+        {
+          if (data[sequence[s - 1]].get (b) != data[sequence[s]].get (b))
+          {
+            out += "\n";
+            ++_lines;
+
+            // Only want one \n, regardless of how many values change.
+            break;
+          }
+        }
+      }
+
+      for (auto& line : rows[r])
+      {
+        out += line;
+
+        // Stop if the line limit is exceeded.
+        if (++_lines >= _truncate_lines && _truncate_lines != 0)
+        {
+          Context::getContext ().time_render_us += timer.total_us ();
+          return out;
+        }
+      }
+
+      // Write out what is composed so far, but only whole rows, and only in
+      // blocks, not line by line.
+      if (stream && out.length () >= RENDER_BLOCK)
+      {
+        *stream << out << std::flush;
+        out.clear ();
+      }
+
+      // Stop if the row limit is exceeded.
+      if (++_rows >= _truncate_rows && _truncate_rows != 0)
+      {
+        Context::getContext ().time_render_us += timer.total_us ();
+        return out;
+      }
     }
   }
 
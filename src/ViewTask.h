@@ -28,6 +28,7 @@
 #define INCLUDED_VIEWTASK
 
 #include <string>
+#include <ostream>
 #include <vector>
 #include <Task.h>
 #include <Color.h>
@@ -55,12 +56,17 @@ public:
   void extraColorEven (Color& c)               { _extra_even = c;                                     }
   void truncateLines (int n)                   { _truncate_lines = n;                                 }
   void truncateRows (int n)                    { _truncate_rows = n;                                  }
+  void sample (int n)                          { _sample = n;                                         }
   void addBreak (const std::string& attr)      { _breaks.push_back (attr);                            }
   int lines ()                                 { return _lines;                                       }
   int rows ()                                  { return _rows;                                        }
 
   // View rendering.
   std::string render (std::vector <Task>&, std::vector <int>&);
+  void render (std::vector <Task>&, std::vector <int>&, std::ostream&);
+
+private:
+  std::string compose (std::vector <Task>&, std::vector <int>&, std::ostream*);
 
 private:
   std::vector <Column*>     _columns;
@@ -80,6 +86,7 @@ private:
   Color                     _extra_even;
   int                       _truncate_lines;
   int                       _truncate_rows;
+  int                       _sample;
   int                       _lines;
   int                       _rows;
 };
@@ -25,8 +25,12 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <cmake.h>
+#include <chrono>
+#include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <Eval.h>
@@ -49,6 +53,73 @@ bool get (const std::string&, Variant&)
   return false;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// The seconds taken to run body the given number of times.
+template <typename T>
+static double timed (int runs, T body)
+{
+  auto start = std::chrono::steady_clock::now ();
+  for (int run = 0; run < runs; ++run)
+    body ();
+
+  return std::chrono::duration <double> (std::chrono::steady_clock::now () - start).count ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Evaluates each expression the given number of times, both from the infix
+// text, which includes lexing and parsing, and compiled, which is evaluation
+// alone, and reports the throughput of each.
+static int bench (Eval& e, const std::vector <std::string>& expressions, int runs)
+{
+  int status = 0;
+  double total_infix = 0.0;
+  double total_compiled = 0.0;
+  int measured = 0;
+
+  printf ("%12s %12s  %s\n", "infix/s", "compiled/s", "expression");
+  for (auto& expression : expressions)
+  {
+    try
+    {
+      // Once to check the expression, uncounted.
+      Variant result;
+      e.evaluateInfixExpression (expression, result);
+
+      auto infix = timed (runs, [&] () { e.evaluateInfixExpression (expression, result); });
+
+      std::vector <std::pair <std::string, Lexer::Type>> tokens;
+      Lexer lexer (expression);
+      std::string token;
+      Lexer::Type type;
+      while (lexer.token (token, type))
+        tokens.push_back (std::pair <std::string, Lexer::Type> (token, type));
+
+      e.compileExpression (tokens);
+      auto compiled = timed (runs, [&] () { e.evaluateCompiledExpression (result); });
+
+      printf ("%12.0f %12.0f  %s\n", runs / infix, runs / compiled, expression.c_str ());
+      total_infix += infix;
+      total_compiled += compiled;
+      ++measured;
+    }
+
+    catch (const std::string& error)
+    {
+      printf ("%12s %12s  %s: %s\n", "-", "-", expression.c_str (), error.c_str ());
+      status = 1;
+    }
+  }
+
+  if (measured)
+    printf ("%12.0f %12.0f  (%d expressions, %d runs each)\n",
+            measured * runs / total_infix,
+            measured * runs / total_compiled,
+            measured,
+            runs);
+
+  return status;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 int main (int argc, char** argv)
 {
@@ -65,6 +136,9 @@ int main (int argc, char** argv)
     Duration::standaloneSecondsEnabled = false;
 
     bool infix {true};
+    int runs {0};
+    bool from_file {false};
+    std::vector <std::string> expressions;
 
     // Add a source for constants.
     Eval e;
@@ -84,6 +158,8 @@ int main (int argc, char** argv)
                   << "  -d|--debug        Debug mode\n"
                   << "  -i|--infix        Infix expression (default)\n"
                   << "  -p|--postfix      Postfix expression\n"
+                  << "  -b|--bench N      Evaluate N times, and report the throughput\n"
+                  << "  -f|--file FILE    Read expressions from FILE, one per line\n"
                   << '\n';
         exit (1);
       }
@@ -108,10 +184,47 @@ int main (int argc, char** argv)
         infix = true;
       else if (!strcmp (argv[i], "-p") || !strcmp (argv[i], "--postfix"))
         infix = false;
+      else if ((!strcmp (argv[i], "-b") || !strcmp (argv[i], "--bench")) && i + 1 < argc)
+        runs = strtol (argv[++i], nullptr, 10);
+      else if ((!strcmp (argv[i], "-f") || !strcmp (argv[i], "--file")) && i + 1 < argc)
+      {
+        std::ifstream in (argv[++i]);
+        if (! in)
+          throw format ("Could not read '{1}'.", argv[i]);
+
+        // Blank lines and comments are skipped.
+        from_file = true;
+        std::string line;
+        while (std::getline (in, line))
+          if (line != "" && line[0] != '#')
+            expressions.push_back (line);
+      }
       else
         expression += std::string (argv[i]) + ' ';
     }
 
+    if (expression != "")
+      expressions.push_back (expression);
+
+    if (runs > 0)
+      return bench (e, expressions, runs);
+
+    if (from_file)
+    {
+      for (auto& line : expressions)
+      {
+        Variant result;
+        if (infix)
+          e.evaluateInfixExpression (line, result);
+        else
+          e.evaluatePostfixExpression (line, result);
+
+        std::cout << (std::string) result << '\n';
+      }
+
+      return status;
+    }
+
     Variant result;
     if (infix)
       e.evaluateInfixExpression (expression, result);
@@ -91,7 +91,7 @@ void ColumnDescription::measure (Task& task, unsigned int& minimum, unsigned int
       _style == "combined")
   {
     minimum = longestWord (description);
-    maximum = utf8_width (description);
+    maximum = textWidth (description);
 
     if (task.annotation_count)
     {
@@ -99,19 +99,21 @@ void ColumnDescription::measure (Task& task, unsigned int& minimum, unsigned int
       if (min_anno > minimum)
         minimum = min_anno;
 
-      for (auto& i : task.getAnnotations ())
+      for (auto& i : task.annotations ())
       {
-        unsigned int len = min_anno + 1 + utf8_width (i.second);
+        unsigned int len = min_anno + 1 + textWidth (i.second);
         if (len > maximum)
           maximum = len;
       }
+
+      _cells[&task] = compose (task);
     }
   }
 
   // Just the text
   else if (_style == "desc")
   {
-    maximum = utf8_width (description);
+    maximum = textWidth (description);
     minimum = longestWord (description);
   }
 
@@ -119,13 +121,15 @@ void ColumnDescription::measure (Task& task, unsigned int& minimum, unsigned int
   else if (_style == "oneline")
   {
     minimum = longestWord (description);
-    maximum = utf8_width (description);
+    maximum = textWidth (description);
 
     if (task.annotation_count)
     {
       auto min_anno = Datetime::length (_dateformat);
-      for (auto& i : task.getAnnotations ())
-        maximum += min_anno + 1 + utf8_width (i.second);
+      for (auto& i : task.annotations ())
+        maximum += min_anno + 1 + textWidth (i.second);
+
+      _cells[&task] = compose (task);
     }
   }
 
@@ -133,14 +137,14 @@ void ColumnDescription::measure (Task& task, unsigned int& minimum, unsigned int
   else if (_style == "truncated")
   {
     minimum = 4;
-    maximum = utf8_width (description);
+    maximum = textWidth (description);
   }
 
   // The text [2]
   else if (_style == "count")
   {
     // <description> + ' ' + '[' + <count> + ']'
-    maximum = utf8_width (description) + 1 + 1 + format (task.annotation_count).length () + 1;
+    maximum = textWidth (description) + 1 + 1 + format (task.annotation_count).length () + 1;
     minimum = longestWord (description);
   }
 
@@ -148,7 +152,7 @@ void ColumnDescription::measure (Task& task, unsigned int& minimum, unsigned int
   else if (_style == "truncated_count")
   {
     minimum = 4;
-    maximum = utf8_width (description) + 1 + 1 + format (task.annotation_count).length () + 1;
+    maximum = textWidth (description) + 1 + 1 + format (task.annotation_count).length () + 1;
   }
 }
 
@@ -159,54 +163,38 @@ void ColumnDescription::render (
   int width,
   Color& color)
 {
-  std::string description = task.get (_name);
-
   // This is a description
   // <date> <anno>
   // ...
-  if (_style == "default" ||
-      _style == "combined")
+  // or
+  // This is a description <date> <anno> ...
+  if (_style == "default"  ||
+      _style == "combined" ||
+      _style == "oneline")
   {
-    if (task.annotation_count)
-    {
-      for (const auto& i : task.getAnnotations ())
-      {
-        Datetime dt (strtol (i.first.substr (11).c_str (), nullptr, 10));
-        description += '\n' + std::string (_indent, ' ') + dt.toString (_dateformat) + ' ' + i.second;
-      }
-    }
+    std::string description;
+    auto cell = _cells.find (&task);
+    if (cell != _cells.end ())
+      description = cell->second;
+    else
+      description = compose (task);
 
     std::vector <std::string> raw;
-    wrapText (raw, description, width, _hyphenate);
+    wrap (raw, description, width);
 
     for (const auto& i : raw)
       renderStringLeft (lines, width, color, i);
-  }
 
-  // This is a description
-  else if (_style == "desc")
-  {
-    std::vector <std::string> raw;
-    wrapText (raw, description, width, _hyphenate);
-
-    for (const auto& i : raw)
-      renderStringLeft (lines, width, color, i);
+    return;
   }
 
-  // This is a description <date> <anno> ...
-  else if (_style == "oneline")
-  {
-    if (task.annotation_count)
-    {
-      for (const auto& i : task.getAnnotations ())
-      {
-        Datetime dt (strtol (i.first.substr (11).c_str (), nullptr, 10));
-        description += ' ' + dt.toString (_dateformat) + ' ' + i.second;
-      }
-    }
+  std::string description = task.get (_name);
 
+  // This is a description
+  if (_style == "desc")
+  {
     std::vector <std::string> raw;
-    wrapText (raw, description, width, _hyphenate);
+    wrap (raw, description, width);
 
     for (const auto& i : raw)
       renderStringLeft (lines, width, color, i);
@@ -215,7 +203,7 @@ void ColumnDescription::render (
   // This is a des...
   else if (_style == "truncated")
   {
-    int len = utf8_width (description);
+    int len = textWidth (description);
     if (len > width)
       renderStringLeft (lines, width, color, description.substr (0, width - 3) + "...");
     else
@@ -229,7 +217,7 @@ void ColumnDescription::render (
       description += " [" + format (task.annotation_count) + ']';
 
     std::vector <std::string> raw;
-    wrapText (raw, description, width, _hyphenate);
+    wrap (raw, description, width);
 
     for (const auto& i : raw)
       renderStringLeft (lines, width, color, i);
@@ -238,14 +226,14 @@ void ColumnDescription::render (
   // This is a des... [2]
   else if (_style == "truncated_count")
   {
-    int len = utf8_width (description);
+    int len = textWidth (description);
 
     std::string annos_count;
     int len_annos = 0;
     if (task.annotation_count)
     {
       annos_count = " [" + format (task.annotation_count) + ']';
-      len_annos = utf8_width (annos_count);
+      len_annos = textWidth (annos_count);
       len += len_annos;
     }
 
@@ -257,3 +245,53 @@ void ColumnDescription::render (
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+// The description, with the annotations of the combined and oneline styles.
+std::string ColumnDescription::compose (Task& task) const
+{
+  std::string description = task.get (_name);
+  if (task.annotation_count)
+  {
+    for (const auto& i : task.annotations ())
+    {
+      Datetime dt (strtol (i.first.substr (11).c_str (), nullptr, 10));
+      if (_style == "oneline")
+        description += ' ' + dt.toString (_dateformat) + ' ' + i.second;
+      else
+        description += '\n' + std::string (_indent, ' ') + dt.toString (_dateformat) + ' ' + i.second;
+    }
+  }
+
+  return description;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Text with fewer bytes than the width, and so fewer columns, and no control
+// characters, is a single line.  Only longer text is wrapped.
+void ColumnDescription::wrap (
+  std::vector <std::string>& lines,
+  const std::string& text,
+  int width) const
+{
+  bool something = false;
+  if (text.length () < (size_t) width)
+  {
+    for (auto c : text)
+    {
+      if ((unsigned char) c < ' ' || c == 0x7f)
+      {
+        something = false;
+        break;
+      }
+
+      if (c != ' ')
+        something = true;
+    }
+  }
+
+  if (something)
+    lines.push_back (text);
+  else
+    wrapText (lines, text, width, _hyphenate);
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -36,6 +36,10 @@ public:
   void measure (Task&, unsigned int&, unsigned int&);
   void render (std::vector <std::string>&, Task&, int, Color&);
 
+private:
+  std::string compose (Task&) const;
+  void wrap (std::vector <std::string>&, const std::string&, int) const;
+
 private:
   bool _hyphenate;
   std::string _dateformat;
@@ -36,7 +36,7 @@
 #include <utf8.h>
 #include <util.h>
 
-extern Task& contextTask;
+extern thread_local const Task* contextTask;
 
 ////////////////////////////////////////////////////////////////////////////////
 ColumnProject::ColumnProject ()
@@ -72,7 +72,7 @@ void ColumnProject::measure (Task& task, unsigned int& minimum, unsigned int& ma
     }
 
     minimum = longestWord (project);
-    maximum = utf8_width (project);
+    maximum = textWidth (project);
   }
 }
 
@@ -121,7 +121,7 @@ void ColumnProject::modify (Task& task, const std::string& value)
     {
       Eval e;
       e.addSource (domSource);
-      contextTask = task;
+      contextTask = &task;
 
       Variant v;
       e.evaluateInfixExpression (value, v);
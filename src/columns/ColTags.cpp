@@ -28,6 +28,7 @@
 #include <ColTags.h>
 #include <algorithm>
 #include <Context.h>
+#include <util.h>
 #include <Eval.h>
 #include <Variant.h>
 #include <Filter.h>
@@ -36,7 +37,7 @@
 #include <utf8.h>
 #include <main.h>
 
-extern Task& contextTask;
+extern thread_local const Task* contextTask;
 
 ////////////////////////////////////////////////////////////////////////////////
 ColumnTags::ColumnTags ()
@@ -76,7 +77,7 @@ void ColumnTags::measure (Task& task, unsigned int& minimum, unsigned int& maxim
   {
     if (_style == "indicator")
     {
-      minimum = maximum = utf8_width (Context::getContext ().config.get ("tag.indicator"));
+      minimum = maximum = textWidth (Context::getContext ().config.get ("tag.indicator"));
     }
     else if (_style == "count")
     {
@@ -85,25 +86,28 @@ void ColumnTags::measure (Task& task, unsigned int& minimum, unsigned int& maxim
     else if (_style == "default" ||
              _style == "list")
     {
-      std::string tags = task.get (_name);
+      auto& tags = task.get_ref (_name);
 
       // Find the widest tag.
       if (tags.find (',') != std::string::npos)
       {
-        auto all = split (tags, ',');
-        for (const auto& tag : all)
+        std::string tag;
+        scanFields (tags, ',', [&] (const char* field, size_t length)
         {
-          auto length = utf8_width (tag);
-          if (length > minimum)
-            minimum = length;
-        }
+          tag.assign (field, length);
+          auto width = textWidth (tag);
+          if (width > minimum)
+            minimum = width;
+
+          return true;
+        });
 
-        maximum = utf8_width (tags);
+        maximum = textWidth (tags);
       }
 
       // No need to split a single tag.
       else
-        minimum = maximum = utf8_width (tags);
+        minimum = maximum = textWidth (tags);
     }
   }
 }
@@ -142,8 +146,7 @@ void ColumnTags::render (
     }
     else if (_style == "count")
     {
-      auto all = split (tags, ',');
-      renderStringRight (lines, width, color, '[' + format (static_cast <int> (all.size ())) + ']');
+      renderStringRight (lines, width, color, '[' + format (countFields (tags)) + ']');
     }
   }
 }
@@ -167,7 +170,7 @@ void ColumnTags::modify (Task& task, const std::string& value)
     {
       Eval e;
       e.addSource (domSource);
-      contextTask = task;
+      contextTask = &task;
 
       Variant v;
       e.evaluateInfixExpression (value, v);
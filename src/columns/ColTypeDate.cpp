@@ -34,7 +34,7 @@
 #include <Filter.h>
 #include <format.h>
 
-extern Task& contextTask;
+extern thread_local const Task* contextTask;
 
 ////////////////////////////////////////////////////////////////////////////////
 ColumnTypeDate::ColumnTypeDate ()
@@ -65,68 +65,24 @@ ColumnTypeDate::ColumnTypeDate ()
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-// Set the minimum and maximum widths for the value.
+// Set the minimum and maximum widths for the value.  The formatted value is
+// kept, so that render need not format it again.
 void ColumnTypeDate::measure (Task& task, unsigned int& minimum, unsigned int& maximum)
 {
   minimum = maximum = 0;
   if (task.has (_name))
   {
     Datetime date (task.get_date (_name));
+    std::string value = formatDate (date);
 
+    // The formatted style is as wide as its format allows, not as its value.
     if (_style == "default" ||
         _style == "formatted")
-    {
-      // Determine the output date format, which uses a hierarchy of definitions.
-      //   rc.report.<report>.dateformat
-      //   rc.dateformat.report
-      //   rc.dateformat.
-      std::string format = Context::getContext ().config.get ("report." + _report + ".dateformat");
-      if (format == "")
-        format = Context::getContext ().config.get ("dateformat.report");
-      if (format == "")
-        format = Context::getContext ().config.get ("dateformat");
-
-      minimum = maximum = Datetime::length (format);
-    }
-    else if (_style == "countdown")
-    {
-      Datetime now;
-      minimum = maximum = Duration (now - date).formatVague (true).length ();
-    }
-    else if (_style == "julian")
-    {
-      minimum = maximum = format (date.toJulian (), 13, 12).length ();
-    }
-    else if (_style == "epoch")
-    {
-      minimum = maximum = date.toEpochString ().length ();
-    }
-    else if (_style == "iso")
-    {
-      minimum = maximum = date.toISO ().length ();
-    }
-    else if (_style == "age")
-    {
-      Datetime now;
-      if (now > date)
-        minimum = maximum = Duration (now - date).formatVague (true).length ();
-      else
-        minimum = maximum = Duration (date - now).formatVague (true).length () + 1;
-    }
-    else if (_style == "relative")
-    {
-      Datetime now;
-      if (now < date)
-        minimum = maximum = Duration (date - now).formatVague (true).length ();
-      else
-        minimum = maximum = Duration (now - date).formatVague (true).length () + 1;
-    }
-    else if (_style == "remaining")
-    {
-      Datetime now;
-      if (date > now)
-        minimum = maximum = Duration (date - now).formatVague (true).length ();
-    }
+      minimum = maximum = Datetime::length (dateFormat ());
+    else
+      minimum = maximum = value.length ();
+
+    _cells[&task] = value;
   }
 }
 
@@ -139,63 +95,91 @@ void ColumnTypeDate::render (
 {
   if (task.has (_name))
   {
-    Datetime date (task.get_date (_name));
-
-    if (_style == "default" ||
-        _style == "formatted")
-    {
-      // Determine the output date format, which uses a hierarchy of definitions.
-      //   rc.report.<report>.dateformat
-      //   rc.dateformat.report
-      //   rc.dateformat
-      std::string format = Context::getContext ().config.get ("report." + _report + ".dateformat");
-      if (format == "")
-      {
-        format = Context::getContext ().config.get ("dateformat.report");
-        if (format == "")
-          format = Context::getContext ().config.get ("dateformat");
-      }
-
-      renderStringLeft (lines, width, color, date.toString (format));
-    }
-    else if (_style == "countdown")
+    std::string value;
+    auto cell = _cells.find (&task);
+    if (cell != _cells.end ())
+      value = cell->second;
+    else
     {
-      Datetime now;
-      renderStringRight (lines, width, color, Duration (now - date).formatVague (true));
+      Datetime date (task.get_date (_name));
+      value = formatDate (date);
     }
-    else if (_style == "julian")
-      renderStringRight (lines, width, color, format (date.toJulian (), 13, 12));
 
-    else if (_style == "epoch")
-      renderStringRight (lines, width, color, date.toEpochString ());
+    if (value == "")
+      return;
 
-    else if (_style == "iso")
-      renderStringLeft (lines, width, color, date.toISO ());
+    if (_style == "default"   ||
+        _style == "formatted" ||
+        _style == "iso")
+      renderStringLeft (lines, width, color, value);
+    else
+      renderStringRight (lines, width, color, value);
+  }
+}
 
-    else if (_style == "age")
-    {
-      Datetime now;
-      if (now > date)
-        renderStringRight (lines, width, color, Duration (now - date).formatVague (true));
-      else
-        renderStringRight (lines, width, color, '-' + Duration (date - now).formatVague (true));
-    }
-    else if (_style == "relative")
-    {
-      Datetime now;
-      if (now < date)
-        renderStringRight (lines, width, color, Duration (date - now).formatVague (true));
-      else
-        renderStringRight (lines, width, color, '-' + Duration (now - date).formatVague (true));
-    }
+////////////////////////////////////////////////////////////////////////////////
+// Determine the output date format, which uses a hierarchy of definitions.
+//   rc.report.<report>.dateformat
+//   rc.dateformat.report
+//   rc.dateformat
+std::string ColumnTypeDate::dateFormat () const
+{
+  std::string format = Context::getContext ().config.get ("report." + _report + ".dateformat");
+  if (format == "")
+  {
+    format = Context::getContext ().config.get ("dateformat.report");
+    if (format == "")
+      format = Context::getContext ().config.get ("dateformat");
+  }
 
-    else if (_style == "remaining")
-    {
-      Datetime now;
-      if (date > now)
-        renderStringRight (lines, width, color, Duration (date - now).formatVague (true));
-    }
+  return format;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::string ColumnTypeDate::formatDate (Datetime& date) const
+{
+  if (_style == "default" ||
+      _style == "formatted")
+    return date.toString (dateFormat ());
+
+  else if (_style == "countdown")
+  {
+    Datetime now;
+    return Duration (now - date).formatVague (true);
+  }
+  else if (_style == "julian")
+    return format (date.toJulian (), 13, 12);
+
+  else if (_style == "epoch")
+    return date.toEpochString ();
+
+  else if (_style == "iso")
+    return date.toISO ();
+
+  else if (_style == "age")
+  {
+    Datetime now;
+    if (now > date)
+      return Duration (now - date).formatVague (true);
+    else
+      return '-' + Duration (date - now).formatVague (true);
+  }
+  else if (_style == "relative")
+  {
+    Datetime now;
+    if (now < date)
+      return Duration (date - now).formatVague (true);
+    else
+      return '-' + Duration (now - date).formatVague (true);
   }
+  else if (_style == "remaining")
+  {
+    Datetime now;
+    if (date > now)
+      return Duration (date - now).formatVague (true);
+  }
+
+  return "";
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -213,7 +197,7 @@ void ColumnTypeDate::modify (Task& task, const std::string& value)
   {
     Eval e;
     e.addSource (domSource);
-    contextTask = task;
+    contextTask = &task;
     e.evaluateInfixExpression (value, evaluatedValue);
   }
 
@@ -32,6 +32,7 @@
 #include <Column.h>
 #include <Color.h>
 #include <Task.h>
+#include <Datetime.h>
 
 class ColumnTypeDate : public Column
 {
@@ -41,6 +42,10 @@ public:
   virtual void render (std::vector <std::string>&, Task&, int, Color&);
   virtual bool validate (const std::string&) const;
   virtual void modify (Task&, const std::string&);
+
+protected:
+  std::string dateFormat () const;
+  std::string formatDate (Datetime&) const;
 };
 
 #endif
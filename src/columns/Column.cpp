@@ -29,6 +29,9 @@
 #include <algorithm>
 #include <set>
 #include <Context.h>
+#include <util.h>
+#include <utf8.h>
+#include <main.h>
 #include <ColDepends.h>
 #include <ColDescription.h>
 #include <ColDue.h>
@@ -44,6 +47,7 @@
 #include <ColRecur.h>
 #include <ColRType.h>
 #include <ColScheduled.h>
+#include <ColSource.h>
 #include <ColStart.h>
 #include <ColStatus.h>
 #include <ColTags.h>
@@ -94,6 +98,7 @@ Column* Column::factory (const std::string& name, const std::string& report)
   else if (column_name == "recur")       c = new ColumnRecur ();
   else if (column_name == "rtype")       c = new ColumnRType ();
   else if (column_name == "scheduled")   c = new ColumnScheduled ();
+  else if (column_name == "source")      c = new ColumnSource ();
   else if (column_name == "start")       c = new ColumnStart ();
   else if (column_name == "status")      c = new ColumnStatus ();
   else if (column_name == "tags")        c = new ColumnTags ();
@@ -136,6 +141,7 @@ void Column::factory (std::map <std::string, Column*>& all)
   c = new ColumnRecur ();          all[c->_name] = c;
   c = new ColumnRType ();          all[c->_name] = c;
   c = new ColumnScheduled ();      all[c->_name] = c;
+  c = new ColumnSource ();         all[c->_name] = c;
   c = new ColumnStart ();          all[c->_name] = c;
   c = new ColumnStatus ();         all[c->_name] = c;
   c = new ColumnTags ();           all[c->_name] = c;
@@ -154,15 +160,13 @@ void Column::uda (std::map <std::string, Column*>& all)
   // For each UDA, instantiate and initialize ColumnUDA.
   std::set <std::string> udas;
 
-  for (const auto& i : Context::getContext ().config)
+  auto range = settings (Context::getContext ().config, "uda.");
+  for (auto i = range.first; i != range.second; ++i)
   {
-    if (i.first.substr (0, 4) == "uda.")
-    {
-      std::string::size_type period = 4; // One byte after the first '.'.
+    std::string::size_type period = 4; // One byte after the first '.'.
 
-      if ((period = i.first.find ('.', period)) != std::string::npos)
-        udas.insert (i.first.substr (4, period - 4));
-    }
+    if ((period = i->first.find ('.', period)) != std::string::npos)
+      udas.insert (i->first.substr (4, period - 4));
   }
 
   for (const auto& uda : udas)
@@ -285,6 +289,21 @@ void Column::setStyle (const std::string& style)
   _style = style;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Appends a new line holding the value, padded to the width, in the color.
+// This is equivalent to colorizing the justified value, but the line is
+// written in place, around the color's cached escape sequences.
+static void renderCell (
+  std::vector <std::string>& lines,
+  int width,
+  const Color& color,
+  const std::string& value,
+  bool right)
+{
+  lines.emplace_back ();
+  colorizeAppend (lines.back (), color, value, width - (int) utf8_text_width (value), right);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // All integer values are right-justified.
 void Column::renderInteger (
@@ -293,9 +312,7 @@ void Column::renderInteger (
   Color& color,
   int value)
 {
-  lines.push_back (
-    color.colorize (
-      rightJustify (value, width)));
+  renderCell (lines, width, color, std::to_string (value), true);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -306,10 +323,7 @@ void Column::renderDouble (
   Color& color,
   double value)
 {
-  lines.push_back (
-    color.colorize (
-      rightJustify (
-        format (value, 4, 3), width)));
+  renderCell (lines, width, color, format (value, 4, 3), true);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -319,9 +333,7 @@ void Column::renderStringLeft (
   Color& color,
   const std::string& value)
 {
-  lines.push_back (
-    color.colorize (
-      leftJustify (value, width)));
+  renderCell (lines, width, color, value, false);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -331,9 +343,7 @@ void Column::renderStringRight (
   Color& color,
   const std::string& value)
 {
-  lines.push_back (
-    color.colorize (
-      rightJustify (value, width)));
+  renderCell (lines, width, color, value, true);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
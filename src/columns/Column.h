@@ -29,6 +29,7 @@
 
 #include <vector>
 #include <string>
+#include <unordered_map>
 #include <Color.h>
 #include <Task.h>
 
@@ -52,6 +53,7 @@ public:
   bool is_fixed_width () const                { return _fixed_width; }
   std::vector <std::string> styles () const   { return _styles;      }
   std::vector <std::string> examples () const { return _examples;    }
+  void clearCells ()                          { _cells.clear ();     }
 
   virtual void setStyle  (const std::string&);
   virtual void setLabel  (const std::string& value) { _label = value;  }
@@ -82,6 +84,9 @@ protected:
   bool _fixed_width;
   std::vector <std::string> _styles;
   std::vector <std::string> _examples;
+
+  // Values formatted by measure, kept for render of the same task.
+  std::unordered_map <const Task*, std::string> _cells;
 };
 
 #endif
@@ -60,13 +60,18 @@ int CmdAdd::execute (std::string& output)
   // We may have a situation where both new-id and new-uuid config
   // variables are set. In that case, we'll show the new-uuid, as
   // it's enduring and never changes, and it's unlikely the caller
-  // asked for this if they just wanted a human-friendly number.
+  // asked for this if they just wanted a human-friendly number.  With
+  // data.append, a concurrent addition may take the same ID, so the uuid is
+  // shown.
+  bool new_uuid = Context::getContext ().verbose ("new-uuid") ||
+                  (Context::getContext ().verbose ("new-id") &&
+                   Context::getContext ().config.getBoolean ("data.append"));
 
-  if (Context::getContext ().verbose ("new-uuid") &&
+  if (new_uuid &&
            status != Task::recurring)
     output += format ("Created task {1}.\n", task.get ("uuid"));
 
-  else if (Context::getContext ().verbose ("new-uuid") &&
+  else if (new_uuid &&
            status == Task::recurring)
     output += format ("Created task {1} (recurrence template).\n", task.get ("uuid"));
 
@@ -36,6 +36,7 @@
 #include <Filter.h>
 #include <Datetime.h>
 #include <Duration.h>
+#include <ReportCache.h>
 #include <main.h>
 #include <shared.h>
 #include <format.h>
@@ -126,8 +127,10 @@ public:
   Chart& operator= (const Chart&);   // Unimplemented
   ~Chart ();
 
-  void scan (std::vector <Task>&);
-  void scanForPeak (std::vector <Task>&);
+  void scan (const TaskColumns&);
+  void scanForPeak (const TaskColumns&);
+  std::string save () const;
+  bool restore (const std::string&);
   std::string render ();
 
 private:
@@ -192,98 +195,109 @@ Chart::~Chart ()
 ////////////////////////////////////////////////////////////////////////////////
 // Scan all tasks, quantize the dates by day, and find the peak pending count
 // and corresponding epoch.
-void Chart::scanForPeak (std::vector <Task>& tasks)
+//
+// Each task is pending over a run of days, so it adds one at the first, and
+// subtracts one after the last.  A running total over the days in order is then
+// the pending count.
+void Chart::scanForPeak (const TaskColumns& tasks)
 {
-  std::map <time_t, int> pending;
+  std::map <time_t, int> deltas;
   _current_count = 0;
 
-  for (auto& task : tasks)
+  for (size_t i = 0; i < tasks.size (); ++i)
   {
     // The entry date is when the counting starts.
-    Datetime entry (task.get_date ("entry"));
+    Datetime entry (tasks.entry[i]);
 
     Datetime end;
-    if (task.has ("end"))
-      end = Datetime (task.get_date ("end"));
+    if (tasks.end[i])
+      end = Datetime (tasks.end[i]);
     else
       ++_current_count;
 
-    while (entry < end)
+    if (entry < end)
     {
-      time_t epoch = quantize (entry.toEpoch (), 'D').toEpoch ();
-      if (pending.find (epoch) != pending.end ())
-        ++pending[epoch];
-      else
-        pending[epoch] = 1;
-
-      entry = increment (entry, 'D');
+      // Counted from the day of entry, up to, but not including, the first
+      // day that starts at or after the end.
+      Datetime after = quantize (end, 'D');
+      if (after < end)
+        after = increment (after, 'D');
+
+      ++deltas[quantize (entry, 'D').toEpoch ()];
+      --deltas[after.toEpoch ()];
     }
   }
 
   // Find the peak and peak date.
-  for (auto& count : pending)
+  int count = 0;
+  for (auto& delta : deltas)
   {
-    if (count.second > _peak_count)
+    count += delta.second;
+    if (count > _peak_count)
     {
-      _peak_count = count.second;
-      _peak_epoch = count.first;
+      _peak_count = count;
+      _peak_epoch = delta.first;
     }
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void Chart::scan (std::vector <Task>& tasks)
+// Each task is pending, started or done over runs of periods, which are counted
+// by adding one at the first bar of a run, and subtracting one after the last,
+// then keeping a running total across the bars.
+void Chart::scan (const TaskColumns& tasks)
 {
   generateBars ();
 
-  // Not quantized, so that "while (xxx < now)" is inclusive.
+  // Not quantized, so that a period that includes now is counted.
   Datetime now;
 
+  // The bars, in order, and the counts that begin or end at each.
+  std::vector <time_t> epochs;
+  for (auto& bar : _bars)
+    epochs.push_back (bar.first);
+
+  std::vector <int> pending (epochs.size () + 1, 0);
+  std::vector <int> started (epochs.size () + 1, 0);
+  std::vector <int> done    (epochs.size () + 1, 0);
+
+  // Counts the bars from 'from', up to but not including 'to'.
+  auto span = [&epochs] (std::vector <int>& deltas, const Datetime& from, const Datetime& to)
+  {
+    if (from < to)
+    {
+      auto first = std::lower_bound (epochs.begin (), epochs.end (), from.toEpoch ()) - epochs.begin ();
+      auto last  = std::lower_bound (epochs.begin (), epochs.end (), to.toEpoch ())   - epochs.begin ();
+      ++deltas[first];
+      --deltas[last];
+    }
+  };
+
   time_t epoch;
-  for (auto& task : tasks)
+  for (size_t i = 0; i < tasks.size (); ++i)
   {
     // The entry date is when the counting starts.
-    Datetime from = quantize (Datetime (task.get_date ("entry")), _period);
+    Datetime from = quantize (Datetime (tasks.entry[i]), _period);
     epoch = from.toEpoch ();
 
-    if (_bars.find (epoch) != _bars.end ())
-      ++_bars[epoch]._added;
+    auto bar = _bars.find (epoch);
+    if (bar != _bars.end ())
+      ++bar->second._added;
 
     // e-->   e--s-->
     // ppp>   pppsss>
-    Task::status status = task.getStatus ();
+    Task::status status = tasks.status[i];
     if (status == Task::pending ||
         status == Task::waiting)
     {
-      if (task.has ("start"))
+      if (tasks.start[i])
       {
-        Datetime start = quantize (Datetime (task.get_date ("start")), _period);
-        while (from < start)
-        {
-          epoch = from.toEpoch ();
-          if (_bars.find (epoch) != _bars.end ())
-            ++_bars[epoch]._pending;
-          from = increment (from, _period);
-        }
-
-        while (from < now)
-        {
-          epoch = from.toEpoch ();
-          if (_bars.find (epoch) != _bars.end ())
-            ++_bars[epoch]._started;
-          from = increment (from, _period);
-        }
+        Datetime start = quantize (Datetime (tasks.start[i]), _period);
+        span (pending, from, start);
+        span (started, std::max (from, start), now);
       }
       else
-      {
-        while (from < now)
-        {
-          epoch = from.toEpoch ();
-          if (_bars.find (epoch) != _bars.end ())
-            ++_bars[epoch]._pending;
-          from = increment (from, _period);
-        }
-      }
+        span (pending, from, now);
     }
 
     // e--C   e--s--C
@@ -291,11 +305,12 @@ void Chart::scan (std::vector <Task>& tasks)
     else if (status == Task::completed)
     {
       // Truncate history so it starts at 'earliest' for completed tasks.
-      Datetime end = quantize (Datetime (task.get_date ("end")), _period);
+      Datetime end = quantize (Datetime (tasks.end[i]), _period);
       epoch = end.toEpoch ();
 
-      if (_bars.find (epoch) != _bars.end ())
-        ++_bars[epoch]._removed;
+      bar = _bars.find (epoch);
+      if (bar != _bars.end ())
+        ++bar->second._removed;
 
       // Maintain a running total of 'done' tasks that are off the left of the
       // chart.
@@ -305,21 +320,8 @@ void Chart::scan (std::vector <Task>& tasks)
         continue;
       }
 
-      while (from < end)
-      {
-        epoch = from.toEpoch ();
-        if (_bars.find (epoch) != _bars.end ())
-          ++_bars[epoch]._pending;
-        from = increment (from, _period);
-      }
-
-      while (from < now)
-      {
-        epoch = from.toEpoch ();
-        if (_bars.find (epoch) != _bars.end ())
-          ++_bars[epoch]._done;
-        from = increment (from, _period);
-      }
+      span (pending, from, end);
+      span (done, std::max (from, end), now);
     }
 
     // e--D   e--s--D
@@ -327,28 +329,83 @@ void Chart::scan (std::vector <Task>& tasks)
     else if (status == Task::deleted)
     {
       // Skip old deleted tasks.
-      Datetime end = quantize (Datetime (task.get_date ("end")), _period);
+      Datetime end = quantize (Datetime (tasks.end[i]), _period);
       epoch = end.toEpoch ();
-      if (_bars.find (epoch) != _bars.end ())
-        ++_bars[epoch]._removed;
+
+      bar = _bars.find (epoch);
+      if (bar != _bars.end ())
+        ++bar->second._removed;
 
       if (end < _earliest)
         continue;
 
-      while (from < end)
-      {
-        epoch = from.toEpoch ();
-        if (_bars.find (epoch) != _bars.end ())
-          ++_bars[epoch]._pending;
-        from = increment (from, _period);
-      }
+      span (pending, from, end);
     }
   }
 
+  // Accumulate the running totals into the bars.
+  int p = 0;
+  int s = 0;
+  int d = 0;
+  size_t i = 0;
+  for (auto& bar : _bars)
+  {
+    p += pending[i];
+    s += started[i];
+    d += done[i];
+    ++i;
+
+    bar.second._pending += p;
+    bar.second._started += s;
+    bar.second._done    += d;
+  }
+
   // Size the data.
   maxima ();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// The counts found by the scans, as numbers separated by spaces: the peak, the
+// current count and the carryover, then five for each bar, in order.
+std::string Chart::save () const
+{
+  std::stringstream out;
+  out << _peak_epoch << ' ' << _peak_count << ' ' << _current_count << ' ' << _carryover_done
+      << ' ' << _bars.size ();
+  for (auto& bar : _bars)
+    out << ' ' << bar.second._pending
+        << ' ' << bar.second._started
+        << ' ' << bar.second._done
+        << ' ' << bar.second._added
+        << ' ' << bar.second._removed;
+
+  return out.str ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// In place of the scans, restores the counts saved for the same bars.
+bool Chart::restore (const std::string& saved)
+{
+  generateBars ();
+
+  std::stringstream in (saved);
+  size_t count = 0;
+  if (! (in >> _peak_epoch >> _peak_count >> _current_count >> _carryover_done >> count) ||
+      count != _bars.size ())
+    return false;
+
+  for (auto& bar : _bars)
+    if (! (in >> bar.second._pending
+              >> bar.second._started
+              >> bar.second._done
+              >> bar.second._added
+              >> bar.second._removed))
+      return false;
+
+  maxima ();
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Graph should render like this:
 //   +---------------------------------------------------------------------+
@@ -869,6 +926,56 @@ unsigned Chart::burndown_size (unsigned ntasks)
   return std::numeric_limits<unsigned>::max ();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// The tasks charted.  Unfiltered, the completed tasks are read from the index
+// where possible, rather than parsed.
+static void gather (TaskColumns& tasks)
+{
+  Filter filter;
+  if (filter.hasFilter ())
+  {
+    std::vector <Task> filtered;
+    filter.subset (filtered);
+    for (auto& task : filtered)
+      tasks.add (task);
+  }
+  else
+    Context::getContext ().tdb2.columns (tasks);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// With report.cache set, the counts of a chart are kept, so that a chart
+// repeated before the data or the day changes is drawn without reading the
+// tasks.  The rates are found afresh, as they depend on the time.
+static std::string burndown (char period)
+{
+  // Scan the pending tasks, applying any filter.
+  handleUntil ();
+  handleRecurrence ();
+
+  Chart chart (period);
+  auto key = ReportCache::key ();
+  std::string counts;
+  std::vector <std::string> none;
+  if (key == "" ||
+      ! ReportCache::get (key, counts, none, none) ||
+      ! chart.restore (counts))
+  {
+    Chart scanned (period);
+    TaskColumns tasks;
+    gather (tasks);
+    scanned.scanForPeak (tasks);
+    scanned.scan (tasks);
+
+    if (key != "")
+      ReportCache::put (key, scanned.save (), none, none);
+
+    return scanned.render ();
+  }
+
+  return chart.render ();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 CmdBurndownMonthly::CmdBurndownMonthly ()
 {
@@ -888,21 +995,8 @@ CmdBurndownMonthly::CmdBurndownMonthly ()
 ////////////////////////////////////////////////////////////////////////////////
 int CmdBurndownMonthly::execute (std::string& output)
 {
-  int rc = 0;
-
-  // Scan the pending tasks, applying any filter.
-  handleUntil ();
-  handleRecurrence ();
-  Filter filter;
-  std::vector <Task> filtered;
-  filter.subset (filtered);
-
-  // Create a chart, scan the tasks, then render.
-  Chart chart ('M');
-  chart.scanForPeak (filtered);
-  chart.scan (filtered);
-  output = chart.render ();
-  return rc;
+  output = burndown ('M');
+  return 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -924,21 +1018,8 @@ CmdBurndownWeekly::CmdBurndownWeekly ()
 ////////////////////////////////////////////////////////////////////////////////
 int CmdBurndownWeekly::execute (std::string& output)
 {
-  int rc = 0;
-
-  // Scan the pending tasks, applying any filter.
-  handleUntil ();
-  handleRecurrence ();
-  Filter filter;
-  std::vector <Task> filtered;
-  filter.subset (filtered);
-
-  // Create a chart, scan the tasks, then render.
-  Chart chart ('W');
-  chart.scanForPeak (filtered);
-  chart.scan (filtered);
-  output = chart.render ();
-  return rc;
+  output = burndown ('W');
+  return 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -960,21 +1041,8 @@ CmdBurndownDaily::CmdBurndownDaily ()
 ////////////////////////////////////////////////////////////////////////////////
 int CmdBurndownDaily::execute (std::string& output)
 {
-  int rc = 0;
-
-  // Scan the pending tasks, applying any filter.
-  handleUntil ();
-  handleRecurrence ();
-  Filter filter;
-  std::vector <Task> filtered;
-  filter.subset (filtered);
-
-  // Create a chart, scan the tasks, then render.
-  Chart chart ('D');
-  chart.scanForPeak (filtered);
-  chart.scan (filtered);
-  output = chart.render ();
-  return rc;
+  output = burndown ('D');
+  return 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
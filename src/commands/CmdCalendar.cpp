@@ -38,6 +38,12 @@
 #include <utf8.h>
 #include <main.h>
 
+// A day as yyyymmdd, to key the due dates and holidays.
+static int dayKey (int y, int m, int d)
+{
+  return y * 10000 + m * 100 + d;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 CmdCalendar::CmdCalendar ()
 {
@@ -72,7 +78,7 @@ int CmdCalendar::execute (std::string& output)
   // Load the pending tasks.
   handleUntil ();
   handleRecurrence ();
-  auto tasks = Context::getContext ().tdb2.pending.get_tasks ();
+  auto& tasks = Context::getContext ().tdb2.pending.get_tasks ();
 
   Datetime today;
   auto getPendingDate = false;
@@ -219,6 +225,41 @@ int CmdCalendar::execute (std::string& output)
   auto details_yFrom = yFrom;
   auto details_mFrom = mFrom;
 
+  // The due dates and holidays are found once, by day, rather than for each
+  // day rendered.
+  CalendarDays days;
+  if (Context::getContext ().color ())
+  {
+    if (Context::getContext ().config.get ("calendar.holidays") != "none")
+    {
+      auto dateformat = Context::getContext ().config.get ("dateformat.holiday");
+      for (auto& hol : Context::getContext ().config)
+        if (hol.first.substr (0, 8) == "holiday.")
+          if (hol.first.substr (hol.first.size () - 4) == "date")
+          {
+            std::string value = hol.second;
+            Datetime holDate (value.c_str (), dateformat);
+            ++days.holidays[dayKey (holDate.year (), holDate.month (), holDate.day ())];
+          }
+    }
+
+    if (Context::getContext ().config.get ("calendar.details") != "none")
+    {
+      Context::getContext ().config.set ("due", 0);
+      for (auto& task : tasks)
+      {
+        if (task.getStatus () == Task::pending &&
+            !task.hasTag ("nocal")             &&
+            task.has ("due"))
+        {
+          std::string due = task.get ("due");
+          Datetime duedmy (strtol (due.c_str(), nullptr, 10));
+          days.due[dayKey (duedmy.year (), duedmy.month (), duedmy.day ())].push_back (task.getDateState ("due"));
+        }
+      }
+    }
+  }
+
   std::stringstream out;
   out << '\n';
 
@@ -266,7 +307,7 @@ int CmdCalendar::execute (std::string& output)
 
     out << '\n'
         << optionalBlankLine ()
-        << renderMonths (mFrom, yFrom, today, tasks, monthsPerLine)
+        << renderMonths (mFrom, yFrom, today, days, monthsPerLine)
         << '\n';
 
     mFrom += monthsPerLine;
@@ -416,7 +457,7 @@ std::string CmdCalendar::renderMonths (
   int firstMonth,
   int firstYear,
   const Datetime& today,
-  std::vector <Task>& all,
+  const CalendarDays& days,
   int monthsPerLine)
 {
   // What day of the week does the user consider the first?
@@ -533,20 +574,11 @@ std::string CmdCalendar::renderMonths (
           cellColor.blend (color_weekend);
 
         // colorize holidays
-        if (Context::getContext ().config.get ("calendar.holidays") != "none")
-        {
-          for (auto& hol : Context::getContext ().config)
-            if (hol.first.substr (0, 8) == "holiday.")
-              if (hol.first.substr (hol.first.size () - 4) == "date")
-              {
-                std::string value = hol.second;
-                Datetime holDate (value.c_str (), Context::getContext ().config.get ("dateformat.holiday"));
-                if (holDate.day   () == d           &&
-                    holDate.month () == months[mpl] &&
-                    holDate.year  () == years[mpl])
-                  cellColor.blend (color_holiday);
-              }
-        }
+        auto key = dayKey (years[mpl], months[mpl], d);
+        auto holiday = days.holidays.find (key);
+        if (holiday != days.holidays.end ())
+          for (int i = 0; i < holiday->second; ++i)
+            cellColor.blend (color_holiday);
 
         // colorize today
         if (today.day   () == d                &&
@@ -555,42 +587,29 @@ std::string CmdCalendar::renderMonths (
           cellColor.blend (color_today);
 
         // colorize due tasks
-        if (Context::getContext ().config.get ("calendar.details") != "none")
+        auto due = days.due.find (key);
+        if (due != days.due.end ())
         {
-          Context::getContext ().config.set ("due", 0);
-          for (auto& task : all)
+          for (auto state : due->second)
           {
-            if (task.getStatus () == Task::pending &&
-                !task.hasTag ("nocal")             &&
-                task.has ("due"))
+            switch (state)
             {
-              std::string due = task.get ("due");
-              Datetime duedmy (strtol (due.c_str(), nullptr, 10));
-
-              if (duedmy.day   () == d           &&
-                  duedmy.month () == months[mpl] &&
-                  duedmy.year  () == years[mpl])
-              {
-                switch (task.getDateState ("due"))
-                {
-                case Task::dateNotDue:
-                  break;
-
-                case Task::dateAfterToday:
-                  cellColor.blend (color_due);
-                  break;
-
-                case Task::dateEarlierToday:
-                case Task::dateLaterToday:
-                  cellColor.blend (color_duetoday);
-                  cellColor.blend (color_duetoday);
-                  break;
-
-                case Task::dateBeforeToday:
-                  cellColor.blend (color_overdue);
-                  break;
-                }
-              }
+            case Task::dateNotDue:
+              break;
+
+            case Task::dateAfterToday:
+              cellColor.blend (color_due);
+              break;
+
+            case Task::dateEarlierToday:
+            case Task::dateLaterToday:
+              cellColor.blend (color_duetoday);
+              cellColor.blend (color_duetoday);
+              break;
+
+            case Task::dateBeforeToday:
+              cellColor.blend (color_overdue);
+              break;
             }
           }
         }
@@ -29,10 +29,18 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <Datetime.h>
 #include <Task.h>
 #include <Command.h>
 
+// The due dates and holidays to mark, by day.
+struct CalendarDays
+{
+  std::unordered_map <int, std::vector <Task::dateState>> due;
+  std::unordered_map <int, int>                           holidays;
+};
+
 class CmdCalendar : public Command
 {
 public:
@@ -40,7 +48,7 @@ public:
   int execute (std::string&);
 
 private:
-  std::string renderMonths (int, int, const Datetime&, std::vector <Task>&, int);
+  std::string renderMonths (int, int, const Datetime&, const CalendarDays&, int);
 };
 
 #endif
@@ -0,0 +1,242 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cmake.h>
+#include <CmdCheck.h>
+#include <sstream>
+#include <unordered_map>
+#include <algorithm>
+#include <Context.h>
+#include <Pool.h>
+#include <Uuid.h>
+#include <format.h>
+
+#define CHECK_CHUNK_MINIMUM 1000
+
+// What one line of a data file holds that the check needs, so that the lines
+// of a file are dropped once it is checked, and references are compared as
+// binary uuids.
+struct CheckRecord
+{
+  bool                      parsed     {false};
+  bool                      identified {false};  // The uuid parsed
+  bool                      current    {true};   // Not superseded by a later record
+  bool                      has_parent {false};  // The parent parsed
+  Uuid                      uuid       {};
+  Uuid                      parent     {};
+  std::vector <Uuid>        depends    {};
+  std::vector <std::string> invalid    {};       // References that are not uuids
+  std::string               error      {};
+};
+
+////////////////////////////////////////////////////////////////////////////////
+static void checkLine (const std::string& line, CheckRecord& record)
+{
+  try
+  {
+    Task task (line);
+    record.parsed     = true;
+    record.identified = Uuid::parse (task.get ("uuid"), record.uuid);
+
+    Uuid uuid;
+    for (auto& dep : task.getDependencyUUIDs ())
+    {
+      if (Uuid::parse (dep, uuid))
+        record.depends.push_back (uuid);
+      else
+        record.invalid.push_back (dep);
+    }
+
+    auto parent = task.get ("parent");
+    if (parent != "")
+    {
+      if (Uuid::parse (parent, record.parent))
+        record.has_parent = true;
+      else
+        record.invalid.push_back (parent);
+    }
+  }
+
+  catch (const std::string& error)
+  {
+    record.error = error;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CmdCheck::CmdCheck ()
+{
+  _keyword               = "check";
+  _usage                 = "task          check [repair]";
+  _description           = "Checks the data files for damage, and repairs the indexes";
+  _read_only             = false;
+  _displays_id           = false;
+  _needs_gc              = false;
+  _uses_context          = false;
+  _accepts_filter        = false;
+  _accepts_modifications = false;
+  _accepts_miscellaneous = true;
+  _category              = Command::Category::misc;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reads each data file once, parsing its lines concurrently with data.threads,
+// and finds duplicate tasks, references to tasks that do not exist, lines that
+// do not parse, and indexes that do not describe their files.  An undo may
+// append an older record of a task, so the order of a journal is not checked.  With 'repair', the indexes are rebuilt.
+int CmdCheck::execute (std::string& output)
+{
+  bool repair = false;
+  for (auto& word : Context::getContext ().cli2.getWords ())
+  {
+    if (word == "repair")
+      repair = true;
+    else
+      throw format ("Unrecognized argument '{1}'.", word);
+  }
+
+  size_t threads = Context::getContext ().config.getInteger ("data.threads");
+  if (threads == 0)
+    threads = Pool::threads ();
+
+  auto& tdb2 = Context::getContext ().tdb2;
+  std::vector <TF2*> files {&tdb2.pending, &tdb2.completed};
+  std::vector <std::string> names {"pending.data", "completed.data"};
+  std::vector <std::vector <CheckRecord>> records (files.size ());
+
+  // The file of each task, by uuid.
+  std::unordered_map <Uuid, size_t> owner;
+
+  std::stringstream out;
+  std::vector <std::string> problems;
+  size_t tasks = 0;
+
+  for (size_t f = 0; f < files.size (); ++f)
+  {
+    auto file = files[f];
+    auto& lines = file->get_lines ();
+    auto& recs = records[f];
+    recs.resize (lines.size ());
+
+    // FF4 lines are parsed concurrently, but not JSON, as that parser is not
+    // thread-safe.
+    auto chunks = std::min (threads, lines.size () / CHECK_CHUNK_MINIMUM);
+    if (chunks > 1)
+    {
+      auto chunk = (lines.size () + chunks - 1) / chunks;
+      Pool::run (chunks, [&] (size_t t)
+      {
+        auto end = std::min (lines.size (), (t + 1) * chunk);
+        for (auto i = t * chunk; i < end; ++i)
+          if (lines[i][0] == '[')
+            checkLine (lines[i], recs[i]);
+      });
+    }
+
+    for (size_t i = 0; i < lines.size (); ++i)
+      if (chunks <= 1 || lines[i][0] != '[')
+        checkLine (lines[i], recs[i]);
+
+    // The last record of a journaled task is current.
+    size_t journaled = 0;
+    std::unordered_map <Uuid, size_t> last;
+    last.reserve (recs.size ());
+    for (size_t i = 0; i < recs.size (); ++i)
+    {
+      auto& record = recs[i];
+      if (! record.parsed)
+      {
+        problems.push_back (format ("{1} line {2} does not parse: {3}", names[f], i + 1, record.error));
+        continue;
+      }
+
+      if (! record.identified)
+      {
+        problems.push_back (format ("{1} line {2} has no valid UUID", names[f], i + 1));
+        continue;
+      }
+
+      auto found = last.find (record.uuid);
+      if (found != last.end ())
+      {
+        recs[found->second].current = false;
+        found->second = i;
+        ++journaled;
+        continue;
+      }
+
+      last.emplace (record.uuid, i);
+      ++tasks;
+
+      auto other = owner.emplace (record.uuid, f);
+      if (! other.second)
+        problems.push_back (format ("Found duplicate {1} in {2} and {3}", record.uuid.str (), names[other.first->second], names[f]));
+    }
+
+    std::string index;
+    if (! file->check_index (repair, index))
+      problems.push_back (format ("The index of {1} is {2}", names[f], index));
+
+    out << format ("{1}: {2} lines, {3} journaled, index {4}", names[f], lines.size (), journaled, index)
+        << '\n';
+
+    // The lines are not needed again, and are re-read on demand.
+    std::vector <std::string> ().swap (file->_lines);
+    file->_loaded_lines = false;
+  }
+
+  for (auto& recs : records)
+  {
+    for (auto& record : recs)
+    {
+      if (! record.parsed || ! record.identified || ! record.current)
+        continue;
+
+      for (auto& dep : record.depends)
+        if (owner.find (dep) == owner.end ())
+          problems.push_back (format ("Task {1} depends on nonexistent task: {2}", record.uuid.str (), dep.str ()));
+
+      if (record.has_parent && owner.find (record.parent) == owner.end ())
+        problems.push_back (format ("Task {1} has nonexistent recurrence template {2}", record.uuid.str (), record.parent.str ()));
+
+      for (auto& reference : record.invalid)
+        problems.push_back (format ("Task {1} refers to an invalid UUID: {2}", record.uuid.str (), reference));
+    }
+  }
+
+  for (auto& problem : problems)
+    out << problem << '\n';
+
+  if (problems.empty ())
+    out << format ("Checked {1} tasks, no problems found.", tasks) << '\n';
+  else
+    out << format ("Checked {1} tasks, found {2} problems.", tasks, problems.size ()) << '\n';
+
+  output = out.str ();
+  return problems.empty () ? 0 : 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -143,10 +143,11 @@ void CmdContext::defineContext (const std::vector <std::string>& words, std::str
       throw format ("The name '{1}' is reserved and not allowed to use as a context name.", words[1]);
     }
 
-    // Check if the value is a proper filter by filtering current pending.data
+    // Check if the value is a proper filter by filtering current pending.data,
+    // in place.
     Filter filter;
     std::vector <Task> filtered;
-    auto pending = Context::getContext ().tdb2.pending.get_tasks ();
+    auto& pending = Context::getContext ().tdb2.pending.get_tasks ();
 
     try
     {
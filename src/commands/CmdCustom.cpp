@@ -26,8 +26,10 @@
 
 #include <cmake.h>
 #include <CmdCustom.h>
+#include <iostream>
 #include <sstream>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <algorithm>
 #include <stdlib.h>
@@ -87,13 +89,30 @@ int CmdCustom::execute (std::string& output)
   if (reportFilter != "")
     Context::getContext ().cli2.addFilter (reportFilter);
 
-  // Apply filter.
+  // Report output can be limited by rows or lines.
+  auto maxrows = 0;
+  auto maxlines = 0;
+  Context::getContext ().getLimits (maxrows, maxlines);
+
+  // Apply filter.  An unsorted report that is limited by rows shows the first
+  // tasks to match, so filtering stops there, unless the number of all the
+  // matching tasks is to be reported.
   handleUntil ();
   handleRecurrence ();
   Filter filter;
+  if (sortOrder.size () == 0 &&
+      ! Context::getContext ().verbose ("affected"))
+    filter.limit (maxrows);
+
   std::vector <Task> filtered;
   filter.subset (filtered);
 
+  // Compute urgency for the whole set at once, rather than on demand during
+  // sorting and rendering.
+  if (reportSort.find ("urgency") != std::string::npos ||
+      reportColumns.find ("urgency") != std::string::npos)
+    Context::getContext ().tdb2.urgency (filtered);
+
   std::vector <int> sequence;
   if (sortOrder.size () &&
       sortOrder[0] == "none")
@@ -102,10 +121,17 @@ int CmdCustom::execute (std::string& output)
     // Context::getContext ().cli2._uuid_ranges, in the order in which they appear. This
     // equates to no sorting, just a specified order.
     sortOrder.clear ();
+    std::unordered_map <std::string, int> positions;
+    positions.reserve (filtered.size ());
+    for (unsigned int t = 0; t < filtered.size (); ++t)
+      positions.emplace (filtered[t].get_ref ("uuid"), t);
+
     for (auto& i : Context::getContext ().cli2._uuid_list)
-      for (unsigned int t = 0; t < filtered.size (); ++t)
-        if (filtered[t].get ("uuid") == i)
-          sequence.push_back (t);
+    {
+      auto found = positions.find (i);
+      if (found != positions.end ())
+        sequence.push_back (found->second);
+    }
   }
   else
   {
@@ -114,9 +140,10 @@ int CmdCustom::execute (std::string& output)
     for (unsigned int i = 0; i < filtered.size (); ++i)
       sequence.push_back (i);
 
-    // Sort the tasks.
+    // Sort the tasks.  As every task takes at least one line, no more than
+    // the limit of rows or lines can be shown, and only those are sorted.
     if (sortOrder.size ())
-      sort_tasks (filtered, sequence, reportSort);
+      sort_tasks (filtered, sequence, reportSort, maxrows > 0 ? maxrows : std::max (maxlines, 0));
   }
 
   // Configure the view.
@@ -184,11 +211,6 @@ int CmdCustom::execute (std::string& output)
       table_header = 2;  // Dashes use an extra line.
   }
 
-  // Report output can be limited by rows or lines.
-  auto maxrows = 0;
-  auto maxlines = 0;
-  Context::getContext ().getLimits (maxrows, maxlines);
-
   // Adjust for fluff in the output.
   if (maxlines)
     maxlines -= table_header
@@ -203,10 +225,21 @@ int CmdCustom::execute (std::string& output)
   {
     view.truncateRows (maxrows);
     view.truncateLines (maxlines);
+    view.sample (Context::getContext ().config.getInteger ("column.sample"));
 
-    out << optionalBlankLine ()
-        << view.render (filtered, sequence)
-        << optionalBlankLine ();
+    // A streamed report is written as it is rendered, ahead of the rest of
+    // the output.
+    if (Context::getContext ().config.getBoolean ("print.stream"))
+    {
+      Context::getContext ().writeHeaders ();
+      std::cout << optionalBlankLine ();
+      view.render (filtered, sequence, std::cout);
+      std::cout << optionalBlankLine ();
+    }
+    else
+      out << optionalBlankLine ()
+          << view.render (filtered, sequence)
+          << optionalBlankLine ();
 
     // Print the number of rendered tasks
     if (Context::getContext ().verbose ("affected"))
@@ -72,98 +72,19 @@ int CmdDelete::execute (std::string&)
   // Accumulated project change notifications.
   std::map <std::string, std::string> projectChanges;
 
+  // Every deletion is planned before any is confirmed, and those confirmed are
+  // then applied together.
+  std::vector <Task> planned;
   for (auto& task : filtered)
   {
-    Task before (task);
-
     if (task.getStatus () != Task::deleted)
     {
-      // Delete the specified task.
-      std::string question;
-      question = format ("Delete task {1} '{2}'?",
-                         task.identifier (true),
-                         task.get ("description"));
-
       task.modify (Task::modAnnotate);
       task.setStatus (Task::deleted);
       if (! task.has ("end"))
         task.setAsNow ("end");
 
-      if (permission (question, filtered.size ()))
-      {
-        updateRecurrenceMask (task);
-        ++count;
-        Context::getContext ().tdb2.modify (task);
-        feedback_affected ("Deleting task {1} '{2}'.", task);
-        feedback_unblocked (task);
-        dependencyChainOnComplete (task);
-        if (Context::getContext ().verbose ("project"))
-          projectChanges[task.get ("project")] = onProjectChange (task);
-
-        // Delete siblings.
-        if (task.has ("parent"))
-        {
-          if ((Context::getContext ().config.get ("recurrence.confirmation") == "prompt"
-               && confirm (STRING_CMD_DELETE_CONFIRM_R)) ||
-              Context::getContext ().config.getBoolean ("recurrence.confirmation"))
-          {
-            std::vector <Task> siblings = Context::getContext ().tdb2.siblings (task);
-            for (auto& sibling : siblings)
-            {
-              sibling.modify (Task::modAnnotate);
-              sibling.setStatus (Task::deleted);
-              if (! sibling.has ("end"))
-                sibling.setAsNow ("end");
-
-              updateRecurrenceMask (sibling);
-              Context::getContext ().tdb2.modify (sibling);
-              feedback_affected (STRING_CMD_DELETE_TASK_R, sibling);
-              feedback_unblocked (sibling);
-              ++count;
-            }
-
-            // Delete the parent
-            Task parent;
-            Context::getContext ().tdb2.get (task.get ("parent"), parent);
-            parent.setStatus (Task::deleted);
-            if (! parent.has ("end"))
-              parent.setAsNow ("end");
-
-            Context::getContext ().tdb2.modify (parent);
-          }
-        }
-
-        // Task potentially has child tasks - optionally delete them.
-        else
-        {
-          std::vector <Task> children = Context::getContext ().tdb2.children (task);
-          if (children.size () &&
-              (Context::getContext ().config.getBoolean ("recurrence.confirmation") ||
-               confirm (STRING_CMD_DELETE_CONFIRM_R)))
-          {
-            for (auto& child : children)
-            {
-              child.modify (Task::modAnnotate);
-              child.setStatus (Task::deleted);
-              if (! child.has ("end"))
-                child.setAsNow ("end");
-
-              updateRecurrenceMask (child);
-              Context::getContext ().tdb2.modify (child);
-              feedback_affected (STRING_CMD_DELETE_TASK_R, child);
-              feedback_unblocked (child);
-              ++count;
-            }
-          }
-        }
-      }
-      else
-      {
-        std::cout << "Task not deleted.\n";
-        rc = 1;
-        if (_permission_quit)
-          break;
-      }
+      planned.push_back (task);
     }
     else
     {
@@ -175,6 +96,97 @@ int CmdDelete::execute (std::string&)
     }
   }
 
+  summarize (format ("{1} tasks to delete:", planned.size ()), planned, filtered.size ());
+
+  std::vector <Task> confirmed;
+  for (auto& task : planned)
+  {
+    // Delete the specified task.
+    std::string question;
+    question = format ("Delete task {1} '{2}'?",
+                       task.identifier (true),
+                       task.get ("description"));
+
+    if (permission (question, filtered.size ()))
+      confirmed.push_back (task);
+    else
+    {
+      std::cout << "Task not deleted.\n";
+      rc = 1;
+      if (_permission_quit)
+        break;
+    }
+  }
+
+  for (auto& task : confirmed)
+  {
+    updateRecurrenceMask (task);
+    ++count;
+    Context::getContext ().tdb2.modify (task);
+    feedback_affected ("Deleting task {1} '{2}'.", task);
+    feedback_unblocked (task);
+    dependencyChainOnComplete (task);
+    if (Context::getContext ().verbose ("project"))
+      projectChanges[task.get ("project")] = onProjectChange (task);
+
+    // Delete siblings.
+    if (task.has ("parent"))
+    {
+      if ((Context::getContext ().config.get ("recurrence.confirmation") == "prompt"
+           && confirm (STRING_CMD_DELETE_CONFIRM_R)) ||
+          Context::getContext ().config.getBoolean ("recurrence.confirmation"))
+      {
+        std::vector <Task> siblings = Context::getContext ().tdb2.siblings (task);
+        for (auto& sibling : siblings)
+        {
+          sibling.modify (Task::modAnnotate);
+          sibling.setStatus (Task::deleted);
+          if (! sibling.has ("end"))
+            sibling.setAsNow ("end");
+
+          updateRecurrenceMask (sibling);
+          Context::getContext ().tdb2.modify (sibling);
+          feedback_affected (STRING_CMD_DELETE_TASK_R, sibling);
+          feedback_unblocked (sibling);
+          ++count;
+        }
+
+        // Delete the parent
+        Task parent;
+        Context::getContext ().tdb2.get (task.get ("parent"), parent);
+        parent.setStatus (Task::deleted);
+        if (! parent.has ("end"))
+          parent.setAsNow ("end");
+
+        Context::getContext ().tdb2.modify (parent);
+      }
+    }
+
+    // Task potentially has child tasks - optionally delete them.
+    else
+    {
+      std::vector <Task> children = Context::getContext ().tdb2.children (task);
+      if (children.size () &&
+          (Context::getContext ().config.getBoolean ("recurrence.confirmation") ||
+           confirm (STRING_CMD_DELETE_CONFIRM_R)))
+      {
+        for (auto& child : children)
+        {
+          child.modify (Task::modAnnotate);
+          child.setStatus (Task::deleted);
+          if (! child.has ("end"))
+            child.setAsNow ("end");
+
+          updateRecurrenceMask (child);
+          Context::getContext ().tdb2.modify (child);
+          feedback_affected (STRING_CMD_DELETE_TASK_R, child);
+          feedback_unblocked (child);
+          ++count;
+        }
+      }
+    }
+  }
+
   // Now list the project changes.
   for (const auto& change : projectChanges)
     if (change.first != "")
@@ -75,7 +75,7 @@ int CmdDenotate::execute (std::string&)
   std::string pattern = "";
   for (auto& a : Context::getContext ().cli2._args)
   {
-    if (a.hasTag ("MISCELLANEOUS"))
+    if (a.hasTag (A2::Tag::MISCELLANEOUS))
     {
       if (pattern != "")
         pattern += ' ';
@@ -29,6 +29,7 @@
 #include <iomanip>
 #include <sstream>
 #include <algorithm>
+#include <unordered_set>
 #include <stdlib.h>
 #include <time.h>
 #include <RX.h>
@@ -402,16 +403,14 @@ int CmdDiagnostics::execute (std::string& output)
 
   // Scan tasks for duplicate UUIDs.
   auto all = Context::getContext ().tdb2.all_tasks ();
-  std::map <std::string, int> seen;
+  std::unordered_set <std::string> seen;
+  seen.reserve (all.size ());
   std::vector <std::string> dups;
-  std::string uuid;
   for (auto& i : all)
   {
-    uuid = i.get ("uuid");
-    if (seen.find (uuid) != seen.end ())
+    auto& uuid = i.get_ref ("uuid");
+    if (! seen.insert (uuid).second)
       dups.push_back (uuid);
-    else
-       seen[uuid] = 0;
   }
 
   out << "       Dups: "
@@ -440,7 +439,7 @@ int CmdDiagnostics::execute (std::string& output)
     // Check dependencies
     for (auto& uuid : task.getDependencyUUIDs ())
     {
-      if (! Context::getContext ().tdb2.has (uuid))
+      if (! seen.count (uuid))
       {
         out << "             "
             << format ("Task {1} depends on nonexistent task: {2}", task.get ("uuid"), uuid)
@@ -452,7 +451,7 @@ int CmdDiagnostics::execute (std::string& output)
     // Check recurrence parent
     auto parentUUID = task.get ("parent");
 
-    if (parentUUID != "" && ! Context::getContext ().tdb2.has (parentUUID))
+    if (parentUUID != "" && ! seen.count (parentUUID))
     {
       out << "             "
           << format ("Task {1} has nonexistent recurrence template {2}", task.get ("uuid"), parentUUID)
@@ -68,19 +68,18 @@ int CmdDone::execute (std::string&)
   // Accumulated project change notifications.
   std::map <std::string, std::string> projectChanges;
 
-  auto nagged = false;
+  // Every completion is planned before any is confirmed, and those confirmed
+  // are then applied together.
+  std::vector <Task> before;
+  std::vector <Task> planned;
   for (auto& task : filtered)
   {
-    Task before (task);
-
     if (task.getStatus () == Task::pending ||
         task.getStatus () == Task::waiting)
     {
-      // Complete the specified task.
-      std::string question = format ("Complete task {1} '{2}'?",
-                                     task.identifier (true),
-                                     task.get ("description"));
+      before.push_back (task);
 
+      // Complete the specified task.
       task.modify (Task::modAnnotate);
       task.setStatus (Task::completed);
       if (! task.has ("end"))
@@ -94,26 +93,7 @@ int CmdDone::execute (std::string&)
           task.addAnnotation (Context::getContext ().config.get ("journal.time.stop.annotation"));
       }
 
-      if (permission (taskDifferences (before, task) + question, filtered.size ()))
-      {
-        updateRecurrenceMask (task);
-        Context::getContext ().tdb2.modify (task);
-        ++count;
-        feedback_affected ("Completed task {1} '{2}'.", task);
-        feedback_unblocked (task);
-        if (!nagged)
-          nagged = nag (task);
-        dependencyChainOnComplete (task);
-        if (Context::getContext ().verbose ("project"))
-          projectChanges[task.get ("project")] = onProjectChange (task);
-      }
-      else
-      {
-        std::cout << "Task not completed.\n";
-        rc = 1;
-        if (_permission_quit)
-          break;
-      }
+      planned.push_back (task);
     }
     else
     {
@@ -125,6 +105,41 @@ int CmdDone::execute (std::string&)
     }
   }
 
+  summarize (format ("{1} tasks to complete:", planned.size ()), planned, filtered.size ());
+
+  std::vector <Task> confirmed;
+  for (size_t i = 0; i < planned.size (); ++i)
+  {
+    std::string question = format ("Complete task {1} '{2}'?",
+                                   before[i].identifier (true),
+                                   before[i].get ("description"));
+
+    if (permission (taskDifferences (before[i], planned[i]) + question, filtered.size ()))
+      confirmed.push_back (planned[i]);
+    else
+    {
+      std::cout << "Task not completed.\n";
+      rc = 1;
+      if (_permission_quit)
+        break;
+    }
+  }
+
+  auto nagged = false;
+  for (auto& task : confirmed)
+  {
+    updateRecurrenceMask (task);
+    Context::getContext ().tdb2.modify (task);
+    ++count;
+    feedback_affected ("Completed task {1} '{2}'.", task);
+    feedback_unblocked (task);
+    if (!nagged)
+      nagged = nag (task);
+    dependencyChainOnComplete (task);
+    if (Context::getContext ().verbose ("project"))
+      projectChanges[task.get ("project")] = onProjectChange (task);
+  }
+
   // Now list the project changes.
   for (const auto& change : projectChanges)
     if (change.first != "")
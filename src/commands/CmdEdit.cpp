@@ -100,25 +100,33 @@ int CmdEdit::execute (std::string&)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-std::string CmdEdit::findValue (
+// Splits the text into its named lines, "  <name>: <value>", once.  The values
+// of each name are kept in the order they appear, of which only the first is
+// used, except for annotations and orphans.  As the text is always preceded by
+// the comment lines of formatTask, the first line is never a named one.
+void CmdEdit::parseFields (
   const std::string& text,
-  const std::string& name)
+  std::map <std::string, std::vector <std::string>>& fields)
 {
-  auto found = text.find (name);
-  if (found != std::string::npos)
+  fields.clear ();
+
+  std::string::size_type start = text.find ('\n');
+  while (start != std::string::npos)
   {
-    auto eol = text.find ('\n', found + 1);
-    if (eol != std::string::npos)
-    {
-      std::string value = text.substr (
-        found + name.length (),
-        eol - (found + name.length ()));
+    auto eol = text.find ('\n', start + 1);
+    if (eol == std::string::npos)
+      break;
 
-      return Lexer::trim (value, "\t ");
+    if (text.compare (start + 1, 2, "  ") == 0)
+    {
+      auto colon = text.find (':', start + 3);
+      if (colon != std::string::npos && colon < eol)
+        fields[text.substr (start + 3, colon - start - 3)].push_back (
+          Lexer::trim (text.substr (colon + 1, eol - colon - 1), "\t "));
     }
-  }
 
-  return "";
+    start = eol;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -141,35 +149,6 @@ std::string CmdEdit::findMultilineValue (
   return "";
 }
 
-////////////////////////////////////////////////////////////////////////////////
-std::vector <std::string> CmdEdit::findValues (
-  const std::string& text,
-  const std::string& name)
-{
-  std::vector <std::string> results;
-  std::string::size_type found = 0;
-
-  while (found != std::string::npos)
-  {
-    found = text.find (name, found + 1);
-    if (found != std::string::npos)
-    {
-      auto eol = text.find ('\n', found + 1);
-      if (eol != std::string::npos)
-      {
-        auto value = text.substr (
-          found + name.length (),
-          eol - (found + name.length ()));
-
-        found = eol - 1;
-        results.push_back (Lexer::trim (value, "\t "));
-      }
-    }
-  }
-
-  return results;
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 std::string CmdEdit::formatDate (
   Task& task,
@@ -334,62 +313,108 @@ std::string CmdEdit::formatTask (Task task, const std::string& dateformat)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void CmdEdit::parseTask (Task& task, const std::string& after, const std::string& dateformat)
+void CmdEdit::parseTask (
+  Task& task,
+  const std::string& before,
+  const std::string& after,
+  const std::string& dateformat)
 {
+  // The text is split into its fields once, and only the fields whose text was
+  // edited are applied.
+  std::map <std::string, std::vector <std::string>> original;
+  std::map <std::string, std::vector <std::string>> edited;
+  parseFields (before, original);
+  parseFields (after, edited);
+
+  auto values = [] (const std::map <std::string, std::vector <std::string>>& fields, const std::string& name)
+  {
+    auto found = fields.find (name);
+    return found != fields.end () ? found->second : std::vector <std::string> ();
+  };
+
+  auto field = [&] (const std::string& name)
+  {
+    auto found = edited.find (name);
+    return found != edited.end () ? found->second[0] : std::string ();
+  };
+
+  auto changed = [&] (const std::string& name)
+  {
+    return values (original, name) != values (edited, name);
+  };
+
   // project
-  auto value = findValue (after, "\n  Project:");
-  if (task.get ("project") != value)
+  if (changed ("Project"))
   {
-    if (value != "")
+    auto value = field ("Project");
+    if (task.get ("project") != value)
     {
-      Context::getContext ().footnote ("Project modified.");
-      task.set ("project", value);
-    }
-    else
-    {
-      Context::getContext ().footnote ("Project deleted.");
-      task.remove ("project");
+      if (value != "")
+      {
+        Context::getContext ().footnote ("Project modified.");
+        task.set ("project", value);
+      }
+      else
+      {
+        Context::getContext ().footnote ("Project deleted.");
+        task.remove ("project");
+      }
     }
   }
 
   // tags
-  value = findValue (after, "\n  Tags:");
-  task.remove ("tags");
-  task.addTags (split (value, ' '));
+  if (changed ("Tags"))
+  {
+    auto value = field ("Tags");
+    task.remove ("tags");
+    task.addTags (split (value, ' '));
+  }
 
-  // description.
-  value = findMultilineValue (after, "\n  Description:", "\n  Created:");
-  if (task.get ("description") != value)
+  // description, which may span lines.
+  auto description = findMultilineValue (after, "\n  Description:", "\n  Created:");
+  if (description != findMultilineValue (before, "\n  Description:", "\n  Created:") &&
+      task.get ("description") != description)
   {
-    if (value != "")
+    if (description != "")
     {
       Context::getContext ().footnote ("Description modified.");
-      task.set ("description", value);
+      task.set ("description", description);
     }
     else
       throw std::string ("Cannot remove description.");
   }
 
   // entry
-  value = findValue (after, "\n  Created:");
-  if (value != "")
+  if (changed ("Created"))
   {
-    if (value != formatDate (task, "entry", dateformat))
+    auto value = field ("Created");
+    if (value != "")
     {
-      Context::getContext ().footnote ("Creation date modified.");
-      task.set ("entry", Datetime (value, dateformat).toEpochString ());
+      if (value != formatDate (task, "entry", dateformat))
+      {
+        Context::getContext ().footnote ("Creation date modified.");
+        task.set ("entry", Datetime (value, dateformat).toEpochString ());
+      }
     }
+    else
+      throw std::string ("Cannot remove creation date.");
   }
-  else
-    throw std::string ("Cannot remove creation date.");
 
   // start
-  value = findValue (after, "\n  Started:");
-  if (value != "")
+  if (changed ("Started"))
   {
-    if (task.get ("start") != "")
+    auto value = field ("Started");
+    if (value != "")
     {
-      if (value != formatDate (task, "start", dateformat))
+      if (task.get ("start") != "")
+      {
+        if (value != formatDate (task, "start", dateformat))
+        {
+          Context::getContext ().footnote (STRING_EDIT_START_MOD);
+          task.set ("start", Datetime (value, dateformat).toEpochString ());
+        }
+      }
+      else
       {
         Context::getContext ().footnote (STRING_EDIT_START_MOD);
         task.set ("start", Datetime (value, dateformat).toEpochString ());
@@ -397,51 +422,57 @@ void CmdEdit::parseTask (Task& task, const std::string& after, const std::string
     }
     else
     {
-      Context::getContext ().footnote (STRING_EDIT_START_MOD);
-      task.set ("start", Datetime (value, dateformat).toEpochString ());
-    }
-  }
-  else
-  {
-    if (task.get ("start") != "")
-    {
-      Context::getContext ().footnote ("Start date removed.");
-      task.remove ("start");
+      if (task.get ("start") != "")
+      {
+        Context::getContext ().footnote ("Start date removed.");
+        task.remove ("start");
+      }
     }
   }
 
   // end
-  value = findValue (after, "\n  Ended:");
-  if (value != "")
+  if (changed ("Ended"))
   {
-    if (task.get ("end") != "")
+    auto value = field ("Ended");
+    if (value != "")
     {
-      if (value != formatDate (task, "end", dateformat))
+      if (task.get ("end") != "")
       {
-        Context::getContext ().footnote ("End date modified.");
-        task.set ("end", Datetime (value, dateformat).toEpochString ());
+        if (value != formatDate (task, "end", dateformat))
+        {
+          Context::getContext ().footnote ("End date modified.");
+          task.set ("end", Datetime (value, dateformat).toEpochString ());
+        }
       }
+      else if (task.getStatus () != Task::deleted)
+        throw std::string ("Cannot set a done date on a pending task.");
     }
-    else if (task.getStatus () != Task::deleted)
-      throw std::string ("Cannot set a done date on a pending task.");
-  }
-  else
-  {
-    if (task.get ("end") != "")
+    else
     {
-      Context::getContext ().footnote ("End date removed.");
-      task.setStatus (Task::pending);
-      task.remove ("end");
+      if (task.get ("end") != "")
+      {
+        Context::getContext ().footnote ("End date removed.");
+        task.setStatus (Task::pending);
+        task.remove ("end");
+      }
     }
   }
 
   // scheduled
-  value = findValue (after, "\n  Scheduled:");
-  if (value != "")
+  if (changed ("Scheduled"))
   {
-    if (task.get ("scheduled") != "")
+    auto value = field ("Scheduled");
+    if (value != "")
     {
-      if (value != formatDate (task, "scheduled", dateformat))
+      if (task.get ("scheduled") != "")
+      {
+        if (value != formatDate (task, "scheduled", dateformat))
+        {
+          Context::getContext ().footnote (STRING_EDIT_SCHED_MOD);
+          task.set ("scheduled", Datetime (value, dateformat).toEpochString ());
+        }
+      }
+      else
       {
         Context::getContext ().footnote (STRING_EDIT_SCHED_MOD);
         task.set ("scheduled", Datetime (value, dateformat).toEpochString ());
@@ -449,26 +480,29 @@ void CmdEdit::parseTask (Task& task, const std::string& after, const std::string
     }
     else
     {
-      Context::getContext ().footnote (STRING_EDIT_SCHED_MOD);
-      task.set ("scheduled", Datetime (value, dateformat).toEpochString ());
-    }
-  }
-  else
-  {
-    if (task.get ("scheduled") != "")
-    {
-      Context::getContext ().footnote ("Scheduled date removed.");
-      task.remove ("scheduled");
+      if (task.get ("scheduled") != "")
+      {
+        Context::getContext ().footnote ("Scheduled date removed.");
+        task.remove ("scheduled");
+      }
     }
   }
 
   // due
-  value = findValue (after, "\n  Due:");
-  if (value != "")
+  if (changed ("Due"))
   {
-    if (task.get ("due") != "")
+    auto value = field ("Due");
+    if (value != "")
     {
-      if (value != formatDate (task, "due", dateformat))
+      if (task.get ("due") != "")
+      {
+        if (value != formatDate (task, "due", dateformat))
+        {
+          Context::getContext ().footnote (STRING_EDIT_DUE_MOD);
+          task.set ("due", Datetime (value, dateformat).toEpochString ());
+        }
+      }
+      else
       {
         Context::getContext ().footnote (STRING_EDIT_DUE_MOD);
         task.set ("due", Datetime (value, dateformat).toEpochString ());
@@ -476,34 +510,37 @@ void CmdEdit::parseTask (Task& task, const std::string& after, const std::string
     }
     else
     {
-      Context::getContext ().footnote (STRING_EDIT_DUE_MOD);
-      task.set ("due", Datetime (value, dateformat).toEpochString ());
-    }
-  }
-  else
-  {
-    if (task.get ("due") != "")
-    {
-      if (task.getStatus () == Task::recurring ||
-          task.get ("parent") != "")
+      if (task.get ("due") != "")
       {
-        Context::getContext ().footnote ("Cannot remove a due date from a recurring task.");
-      }
-      else
-      {
-        Context::getContext ().footnote ("Due date removed.");
-        task.remove ("due");
+        if (task.getStatus () == Task::recurring ||
+            task.get ("parent") != "")
+        {
+          Context::getContext ().footnote ("Cannot remove a due date from a recurring task.");
+        }
+        else
+        {
+          Context::getContext ().footnote ("Due date removed.");
+          task.remove ("due");
+        }
       }
     }
   }
 
   // until
-  value = findValue (after, "\n  Until:");
-  if (value != "")
+  if (changed ("Until"))
   {
-    if (task.get ("until") != "")
+    auto value = field ("Until");
+    if (value != "")
     {
-      if (value != formatDate (task, "until", dateformat))
+      if (task.get ("until") != "")
+      {
+        if (value != formatDate (task, "until", dateformat))
+        {
+          Context::getContext ().footnote (STRING_EDIT_UNTIL_MOD);
+          task.set ("until", Datetime (value, dateformat).toEpochString ());
+        }
+      }
+      else
       {
         Context::getContext ().footnote (STRING_EDIT_UNTIL_MOD);
         task.set ("until", Datetime (value, dateformat).toEpochString ());
@@ -511,59 +548,66 @@ void CmdEdit::parseTask (Task& task, const std::string& after, const std::string
     }
     else
     {
-      Context::getContext ().footnote (STRING_EDIT_UNTIL_MOD);
-      task.set ("until", Datetime (value, dateformat).toEpochString ());
-    }
-  }
-  else
-  {
-    if (task.get ("until") != "")
-    {
-      Context::getContext ().footnote ("Until date removed.");
-      task.remove ("until");
+      if (task.get ("until") != "")
+      {
+        Context::getContext ().footnote ("Until date removed.");
+        task.remove ("until");
+      }
     }
   }
 
   // recur
-  value = findValue (after, "\n  Recur:");
-  if (value != task.get ("recur"))
+  if (changed ("Recur"))
   {
-    if (value != "")
+    auto value = field ("Recur");
+    if (value != task.get ("recur"))
     {
-      Duration p;
-      std::string::size_type idx = 0;
-      if (p.parse (value, idx))
+      if (value != "")
       {
-        Context::getContext ().footnote ("Recurrence modified.");
-        if (task.get ("due") != "")
+        Duration p;
+        std::string::size_type idx = 0;
+        if (p.parse (value, idx))
         {
-          task.set ("recur", value);
-          task.setStatus (Task::recurring);
+          Context::getContext ().footnote ("Recurrence modified.");
+          if (task.get ("due") != "")
+          {
+            task.set ("recur", value);
+            task.setStatus (Task::recurring);
+          }
+          else
+            throw std::string ("A recurring task must have a due date.");
         }
         else
-          throw std::string ("A recurring task must have a due date.");
+          throw std::string ("Not a valid recurrence duration.");
       }
       else
-        throw std::string ("Not a valid recurrence duration.");
-    }
-    else
-    {
-      Context::getContext ().footnote ("Recurrence removed.");
-      task.setStatus (Task::pending);
-      task.remove ("recur");
-      task.remove ("until");
-      task.remove ("mask");
-      task.remove ("imask");
+      {
+        Context::getContext ().footnote ("Recurrence removed.");
+        task.setStatus (Task::pending);
+        task.remove ("recur");
+        task.remove ("until");
+        task.remove ("mask");
+        task.remove ("imask");
+      }
     }
   }
 
   // wait
-  value = findValue (after, "\n  Wait until:");
-  if (value != "")
+  if (changed ("Wait until"))
   {
-    if (task.get ("wait") != "")
+    auto value = field ("Wait until");
+    if (value != "")
     {
-      if (value != formatDate (task, "wait", dateformat))
+      if (task.get ("wait") != "")
+      {
+        if (value != formatDate (task, "wait", dateformat))
+        {
+          Context::getContext ().footnote (STRING_EDIT_WAIT_MOD);
+          task.set ("wait", Datetime (value, dateformat).toEpochString ());
+          task.setStatus (Task::waiting);
+        }
+      }
+      else
       {
         Context::getContext ().footnote (STRING_EDIT_WAIT_MOD);
         task.set ("wait", Datetime (value, dateformat).toEpochString ());
@@ -572,58 +616,67 @@ void CmdEdit::parseTask (Task& task, const std::string& after, const std::string
     }
     else
     {
-      Context::getContext ().footnote (STRING_EDIT_WAIT_MOD);
-      task.set ("wait", Datetime (value, dateformat).toEpochString ());
-      task.setStatus (Task::waiting);
-    }
-  }
-  else
-  {
-    if (task.get ("wait") != "")
-    {
-      Context::getContext ().footnote ("Wait date removed.");
-      task.remove ("wait");
-      task.setStatus (Task::pending);
+      if (task.get ("wait") != "")
+      {
+        Context::getContext ().footnote ("Wait date removed.");
+        task.remove ("wait");
+        task.setStatus (Task::pending);
+      }
     }
   }
 
   // parent
-  value = findValue (after, "\n  Parent:");
-  if (value != task.get ("parent"))
+  if (changed ("Parent"))
   {
-    if (value != "")
-    {
-      Context::getContext ().footnote ("Parent UUID modified.");
-      task.set ("parent", value);
-    }
-    else
+    auto value = field ("Parent");
+    if (value != task.get ("parent"))
     {
-      Context::getContext ().footnote ("Parent UUID removed.");
-      task.remove ("parent");
+      if (value != "")
+      {
+        Context::getContext ().footnote ("Parent UUID modified.");
+        task.set ("parent", value);
+      }
+      else
+      {
+        Context::getContext ().footnote ("Parent UUID removed.");
+        task.remove ("parent");
+      }
     }
   }
 
-  // Annotations
-  std::map <std::string, std::string> annotations;
-  std::string::size_type found = 0;
-  while ((found = after.find ("\n  Annotation:", found)) != std::string::npos)
+  // Annotations.  Those left as they were are kept exactly, rather than parsed
+  // back from a date that dateformat may approximate.
+  if (changed ("Annotation"))
   {
-    found += 14;  // Length of "\n  Annotation:".
+    std::multimap <std::string, std::pair <std::string, std::string>> unedited;
+    auto lines = values (original, "Annotation");
+    size_t line = 0;
+    for (auto& anno : task.getAnnotations ())
+      if (line < lines.size ())
+        unedited.emplace (lines[line++], anno);
 
-    auto eol = after.find ('\n', found + 1);
-    if (eol != std::string::npos)
+    std::map <std::string, std::string> annotations;
+    for (auto& value : values (edited, "Annotation"))
     {
-      auto value = Lexer::trim (after.substr (found, eol - found), "\t ");
+      auto same = unedited.find (value);
+      if (same != unedited.end () &&
+          annotations.find (same->second.first) == annotations.end ())
+      {
+        annotations.insert (same->second);
+        unedited.erase (same);
+        continue;
+      }
+
       auto gap = value.find (" -- ");
       if (gap != std::string::npos)
       {
-        // TODO keeping the initial dates even if dateformat approximates them
-        // is complex as finding the correspondence between each original line
-        // and edited line may be impossible (bug #705). It would be simpler if
-        // each annotation was put on a line with a distinguishable id (then
-        // for each line: if the annotation is the same, then it is copied; if
-        // the annotation is modified, then its original date may be kept; and
-        // if there is no corresponding id, then a new unique date is created).
+        // TODO keeping the initial dates of edited annotations, even if
+        // dateformat approximates them, is complex as finding the
+        // correspondence between each original line and edited line may be
+        // impossible (bug #705). It would be simpler if each annotation was
+        // put on a line with a distinguishable id (then for each line: if the
+        // annotation is modified, then its original date may be kept; and if
+        // there is no corresponding id, then a new unique date is created).
         Datetime when (value.substr (0, gap), dateformat);
 
         // If the map already contains a annotation for a given timestamp
@@ -644,30 +697,33 @@ void CmdEdit::parseTask (Task& task, const std::string& after, const std::string
         annotations.insert (std::make_pair (name.str (), json::decode (text)));
       }
     }
-  }
 
-  task.setAnnotations (annotations);
+    task.setAnnotations (annotations);
+  }
 
   // Dependencies
-  value = findValue (after, "\n  Dependencies:");
-  auto dependencies = split (value, ',');
-
-  task.remove ("depends");
-  for (auto& dep : dependencies)
+  if (changed ("Dependencies"))
   {
-    if (dep.length () >= 7)
-      task.addDependency (dep);
-    else
-      task.addDependency ((int) strtol (dep.c_str (), nullptr, 10));
+    auto dependencies = split (field ("Dependencies"), ',');
+
+    task.remove ("depends");
+    for (auto& dep : dependencies)
+    {
+      if (dep.length () >= 7)
+        task.addDependency (dep);
+      else
+        task.addDependency ((int) strtol (dep.c_str (), nullptr, 10));
+    }
   }
 
   // UDAs
   for (auto& col : Context::getContext ().columns)
   {
     auto type = Context::getContext ().config.get ("uda." + col.first + ".type");
-    if (type != "")
+    if (type != "" &&
+        changed ("UDA " + col.first))
     {
-      auto value = findValue (after, "\n  UDA " + col.first + ":");
+      auto value = field ("UDA " + col.first);
       if (type == "string")
         value = json::decode (value);
       if ((task.get (col.first) != value) && (type != "date" ||
@@ -712,18 +768,19 @@ void CmdEdit::parseTask (Task& task, const std::string& after, const std::string
   }
 
   // UDA orphans
-  for (auto& orphan : findValues (after, "\n  UDA Orphan "))
+  for (auto& orphan : edited)
   {
-    auto colon = orphan.find (':');
-    if (colon != std::string::npos)
+    if (orphan.first.compare (0, 11, "UDA Orphan ") == 0 &&
+        changed (orphan.first))
     {
-      std::string name  = Lexer::trim (orphan.substr (0, colon),  "\t ");
-      std::string value = Lexer::trim (orphan.substr (colon + 1), "\t ");
-
-      if (value != "")
-        task.set (name, value);
-      else
-        task.remove (name);
+      std::string name = Lexer::trim (orphan.first.substr (11), "\t ");
+      for (auto& value : orphan.second)
+      {
+        if (value != "")
+          task.set (name, value);
+        else
+          task.remove (name);
+      }
     }
   }
 }
@@ -804,9 +861,13 @@ ARE_THESE_REALLY_HARMFUL:
     std::string problem = "";
     auto oops = false;
 
+    // The edits are applied to a copy, so that a failed attempt leaves none of
+    // them behind for the next, which only applies what differs from before.
     try
     {
-      parseTask (task, after, dateformat);
+      Task edited (task);
+      parseTask (edited, before_orig, after, dateformat);
+      task = edited;
     }
 
     catch (const std::string& e)
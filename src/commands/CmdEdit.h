@@ -27,7 +27,9 @@
 #ifndef INCLUDED_CMDEDIT
 #define INCLUDED_CMDEDIT
 
+#include <map>
 #include <string>
+#include <vector>
 #include <Command.h>
 #include <Task.h>
 
@@ -38,13 +40,12 @@ public:
   int execute (std::string&);
 
 private:
-  std::string findValue (const std::string&, const std::string&);
+  void parseFields (const std::string&, std::map <std::string, std::vector <std::string>>&);
   std::string findMultilineValue (const std::string&, const std::string&, const std::string&);
-  std::vector <std::string> findValues (const std::string&, const std::string&);
   std::string formatDate (Task&, const std::string&, const std::string&);
   std::string formatDuration (Task&, const std::string&);
   std::string formatTask (Task, const std::string&);
-  void parseTask (Task&, const std::string&, const std::string&);
+  void parseTask (Task&, const std::string&, const std::string&, const std::string&);
   enum class editResult { error, changes, nochanges };
   editResult editFile (Task&);
 };
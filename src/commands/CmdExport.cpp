@@ -28,7 +28,15 @@
 #include <CmdExport.h>
 #include <Context.h>
 #include <Filter.h>
+#include <Pool.h>
 #include <main.h>
+#include <shared.h>
+#include <iostream>
+#include <algorithm>
+#include <set>
+
+#define EXPORT_BLOCK 65536
+#define EXPORT_CHUNK 256
 
 ////////////////////////////////////////////////////////////////////////////////
 CmdExport::CmdExport ()
@@ -47,7 +55,7 @@ CmdExport::CmdExport ()
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-int CmdExport::execute (std::string& output)
+int CmdExport::execute (std::string&)
 {
   int rc = 0;
 
@@ -55,50 +63,135 @@ int CmdExport::execute (std::string& output)
   handleUntil ();
   handleRecurrence ();
 
+  // Obey 'limit:N'.  As the export is not sorted, filtering stops at the
+  // limit.
+  int rows = 0;
+  int lines = 0;
+  Context::getContext ().getLimits (rows, lines);
+  int limit = (rows > lines ? rows : lines);
+
+  // A page is taken in order of uuid, which no change to a task disturbs, so
+  // the whole filter is applied first.
+  size_t page = std::max (0, Context::getContext ().config.getInteger ("export.page"));
+  if (page)
+    limit = 0;
+
   // Apply filter.
   Filter filter;
+  filter.limit (limit);
   std::vector <Task> filtered;
   filter.subset (filtered);
 
+  // Only the page itself is sorted, after the tasks before the cursor are
+  // dropped.
+  if (page)
+  {
+    auto after = Context::getContext ().config.get ("export.after");
+    if (after != "")
+      filtered.erase (std::remove_if (filtered.begin (), filtered.end (),
+                                      [&after] (const Task& task) { return task.get_ref ("uuid") <= after; }),
+                      filtered.end ());
+
+    auto by_uuid = [] (const Task& left, const Task& right) { return left.get_ref ("uuid") < right.get_ref ("uuid"); };
+    if (filtered.size () > page)
+    {
+      std::nth_element (filtered.begin (), filtered.begin () + page, filtered.end (), by_uuid);
+      filtered.resize (page);
+    }
+
+    std::sort (filtered.begin (), filtered.end (), by_uuid);
+  }
+
   // Export == render.
   Timer timer;
 
-  // Obey 'limit:N'.
-  int rows = 0;
-  int lines = 0;
-  Context::getContext ().getLimits (rows, lines);
-  int limit = (rows > lines ? rows : lines);
-
   // Is output contained within a JSON array?
   bool json_array = Context::getContext ().config.getBoolean ("json.array");
 
-  // Compose output.
+  // Only the attributes in export.fields are composed, when it is set.
+  std::set <std::string> fields;
+  for (auto& field : split (Context::getContext ().config.get ("export.fields"), ','))
+    if (field != "")
+      fields.insert (field);
+
+  // Inherited urgency looks up other tasks, so is composed in one thread.
+  size_t threads = Context::getContext ().config.getInteger ("export.threads");
+  if (threads == 0)
+    threads = Pool::threads ();
+
+  if (Context::getContext ().config.getBoolean ("urgency.inherit"))
+    threads = 1;
+
+  // The JSON is written to stdout as it is composed, in blocks, so that the
+  // whole export is never held in memory.
+  Context::getContext ().writeHeaders ();
+  std::string buffer;
+  buffer.reserve (EXPORT_BLOCK + 4096);
+
   if (json_array)
-    output += "[\n";
+    buffer += "[\n";
 
-  int counter = 0;
-  for (auto& task : filtered)
+  auto compose = [&] (std::string& out, size_t begin, size_t end)
   {
-    if (counter)
+    for (auto i = begin; i < end; ++i)
     {
-      if (json_array)
-        output += ',';
-      output += '\n';
+      if (i)
+      {
+        if (json_array)
+          out += ',';
+        out += '\n';
+      }
+
+      filtered[i].composeJSON (out, true, fields.size () ? &fields : nullptr);
     }
+  };
 
-    output += task.composeJSON (true);
+  if (threads <= 1 || filtered.size () < 2 * EXPORT_CHUNK)
+  {
+    for (size_t i = 0; i < filtered.size (); ++i)
+    {
+      compose (buffer, i, i + 1);
 
-    ++counter;
-    if (limit && counter >= limit)
-      break;
+      if (buffer.length () >= EXPORT_BLOCK)
+      {
+        std::cout << buffer;
+        buffer.clear ();
+      }
+    }
+  }
+  else
+  {
+    // Each window of tasks is split into one contiguous chunk per thread, and
+    // the chunks are written in order once the whole window is composed.
+    std::vector <std::string> chunks (threads);
+    for (size_t window = 0; window < filtered.size (); window += threads * EXPORT_CHUNK)
+    {
+      auto count = std::min (threads, (filtered.size () - window + EXPORT_CHUNK - 1) / EXPORT_CHUNK);
+      Pool::run (count, [&] (size_t t)
+      {
+        auto begin = window + t * EXPORT_CHUNK;
+        auto end   = std::min (filtered.size (), begin + EXPORT_CHUNK);
+
+        chunks[t].clear ();
+        compose (chunks[t], begin, end);
+      });
+
+      std::cout << buffer;
+      buffer.clear ();
+      for (size_t t = 0; t < count; ++t)
+        std::cout << chunks[t];
+    }
   }
 
   if (filtered.size ())
-    output += '\n';
+    buffer += '\n';
 
   if (json_array)
-    output += "]\n";
+    buffer += "]\n";
+
+  std::cout << buffer << std::flush;
 
+  Context::getContext ().count_rendered += (long) filtered.size ();
   Context::getContext ().time_render_us += timer.total_us ();
   return rc;
 }
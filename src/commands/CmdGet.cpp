@@ -76,8 +76,8 @@ int CmdGet::execute (std::string& output)
     // Look for non-refs to complain about.
     case Lexer::Type::word:
     case Lexer::Type::identifier:
-      if (! arg.hasTag ("BINARY") &&
-          ! arg.hasTag ("CMD"))
+      if (! arg.hasTag (A2::Tag::BINARY) &&
+          ! arg.hasTag (A2::Tag::CMD))
         throw format ("'{1}' is not a DOM reference.", arg.attribute ("raw"));
 
     default:
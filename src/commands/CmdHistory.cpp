@@ -27,6 +27,7 @@
 #include <cmake.h>
 #include <CmdHistory.h>
 #include <sstream>
+#include <time.h>
 #include <Context.h>
 #include <Filter.h>
 #include <Table.h>
@@ -42,6 +43,96 @@
 #define STRING_CMD_HISTORY_COMP      "Completed"
 #define STRING_CMD_HISTORY_DEL       "Deleted"
 
+////////////////////////////////////////////////////////////////////////////////
+// Days since 1970-01-01 of a civil date, and the reverse, using only integer
+// arithmetic.  See https://howardhinnant.github.io/date_algorithms.html
+static int daysFromCivil (int y, int m, int d)
+{
+  y -= m <= 2;
+  int era = (y >= 0 ? y : y - 399) / 400;
+  int yoe = y - era * 400;
+  int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+static void civilFromDays (int z, int& y, int& m, int& d)
+{
+  z += 719468;
+  int era = (z >= 0 ? z : z - 146096) / 146097;
+  int doe = z - era * 146097;
+  int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  int mp  = (5 * doy + 2) / 153;
+  d = doy - (153 * mp + 2) / 5 + 1;
+  m = mp + (mp < 10 ? 3 : -9);
+  y = yoe + era * 400 + (m <= 2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The timeintervals that the strategies group by.  Each numbers its intervals
+// consecutively, and finds the local start time of an interval from its
+// number.
+class DayPeriod
+{
+public:
+  static int ordinal (int y, int m, int d)
+  {
+    return daysFromCivil (y, m, d);
+  }
+
+  static time_t periodStart (int ordinal)
+  {
+    int y, m, d;
+    civilFromDays (ordinal, y, m, d);
+    return Datetime (y, m, d).toEpoch ();
+  }
+};
+
+// Weeks start on Sunday, and 1970-01-01 was a Thursday.
+class WeekPeriod
+{
+public:
+  static int ordinal (int y, int m, int d)
+  {
+    int days = daysFromCivil (y, m, d) + 4;
+    return (days >= 0 ? days : days - 6) / 7;
+  }
+
+  static time_t periodStart (int ordinal)
+  {
+    return DayPeriod::periodStart (ordinal * 7 - 4);
+  }
+};
+
+class MonthPeriod
+{
+public:
+  static int ordinal (int y, int m, int)
+  {
+    return y * 12 + m - 1;
+  }
+
+  static time_t periodStart (int ordinal)
+  {
+    return Datetime (ordinal / 12, ordinal % 12 + 1, 1).toEpoch ();
+  }
+};
+
+class YearPeriod
+{
+public:
+  static int ordinal (int y, int, int)
+  {
+    return y;
+  }
+
+  static time_t periodStart (int ordinal)
+  {
+    return Datetime (ordinal, 1, 1).toEpoch ();
+  }
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 template<class HistoryStrategy>
 CmdHistoryBase<HistoryStrategy>::CmdHistoryBase ()
@@ -83,13 +174,13 @@ void CmdHistoryBase<HistoryStrategy>::outputGraphical (std::string& output)
   // Determine the longest line, and the longest "added" line.
   auto maxAddedLine = 0;
   auto maxRemovedLine = 0;
-  for (auto& i : groups)
+  for (auto& bucket : buckets)
   {
-    if (completedGroup[i.first] + deletedGroup[i.first] > maxRemovedLine)
-      maxRemovedLine = completedGroup[i.first] + deletedGroup[i.first];
+    if (bucket.completed + bucket.deleted > maxRemovedLine)
+      maxRemovedLine = bucket.completed + bucket.deleted;
 
-    if (addedGroup[i.first] > maxAddedLine)
-      maxAddedLine = addedGroup[i.first];
+    if (bucket.added > maxAddedLine)
+      maxAddedLine = bucket.added;
   }
 
   auto maxLine = maxAddedLine + maxRemovedLine;
@@ -103,44 +194,49 @@ void CmdHistoryBase<HistoryStrategy>::outputGraphical (std::string& output)
 
     time_t priorTime = 0;
     auto row = 0;
-    for (auto& i : groups)
+    for (unsigned int b = 0; b < buckets.size (); ++b)
     {
+      auto& bucket = buckets[b];
+      if (! bucket.used)
+        continue;
+
       row = view.addRow ();
 
-      totalAdded     += addedGroup[i.first];
-      totalCompleted += completedGroup[i.first];
-      totalDeleted   += deletedGroup[i.first];
+      totalAdded     += bucket.added;
+      totalCompleted += bucket.completed;
+      totalDeleted   += bucket.deleted;
 
-      HistoryStrategy::insertRowDate (view, row, i.first, priorTime);
-      priorTime = i.first;
+      auto epoch = HistoryStrategy::periodStart (first + b);
+      HistoryStrategy::insertRowDate (view, row, epoch, priorTime);
+      priorTime = epoch;
 
-      unsigned int addedBar     = (widthOfBar *     addedGroup[i.first]) / maxLine;
-      unsigned int completedBar = (widthOfBar * completedGroup[i.first]) / maxLine;
-      unsigned int deletedBar   = (widthOfBar *   deletedGroup[i.first]) / maxLine;
+      unsigned int addedBar     = (widthOfBar *     bucket.added) / maxLine;
+      unsigned int completedBar = (widthOfBar * bucket.completed) / maxLine;
+      unsigned int deletedBar   = (widthOfBar *   bucket.deleted) / maxLine;
 
       std::string bar;
       if (Context::getContext ().color ())
       {
         std::string aBar;
-        if (addedGroup[i.first])
+        if (bucket.added)
         {
-          aBar = format (addedGroup[i.first]);
+          aBar = format (bucket.added);
           while (aBar.length () < addedBar)
             aBar = ' ' + aBar;
         }
 
         std::string cBar;
-        if (completedGroup[i.first])
+        if (bucket.completed)
         {
-          cBar = format (completedGroup[i.first]);
+          cBar = format (bucket.completed);
           while (cBar.length () < completedBar)
             cBar = ' ' + cBar;
         }
 
         std::string dBar;
-        if (deletedGroup[i.first])
+        if (bucket.deleted)
         {
-          dBar = format (deletedGroup[i.first]);
+          dBar = format (bucket.deleted);
           while (dBar.length () < deletedBar)
             dBar = ' ' + dBar;
         }
@@ -211,35 +307,40 @@ void CmdHistoryBase<HistoryStrategy>::outputTabular (std::string& output)
 
   auto row = 0;
   time_t lastTime = 0;
-  for (auto& i : groups)
+  for (unsigned int b = 0; b < buckets.size (); ++b)
   {
+    auto& bucket = buckets[b];
+    if (! bucket.used)
+      continue;
+
     row = view.addRow ();
 
-    totalAdded     += addedGroup     [i.first];
-    totalCompleted += completedGroup [i.first];
-    totalDeleted   += deletedGroup   [i.first];
+    totalAdded     += bucket.added;
+    totalCompleted += bucket.completed;
+    totalDeleted   += bucket.deleted;
 
-    HistoryStrategy::insertRowDate (view, row, i.first, lastTime);
-    lastTime = i.first;
+    auto epoch = HistoryStrategy::periodStart (first + b);
+    HistoryStrategy::insertRowDate (view, row, epoch, lastTime);
+    lastTime = epoch;
 
     auto net = 0;
 
-    if (addedGroup.find (i.first) != addedGroup.end ())
+    if (bucket.added)
     {
-      view.set (row, HistoryStrategy::dateFieldCount + 0, addedGroup[i.first]);
-      net +=addedGroup[i.first];
+      view.set (row, HistoryStrategy::dateFieldCount + 0, bucket.added);
+      net += bucket.added;
     }
 
-    if (completedGroup.find (i.first) != completedGroup.end ())
+    if (bucket.completed)
     {
-      view.set (row, HistoryStrategy::dateFieldCount + 1, completedGroup[i.first]);
-      net -= completedGroup[i.first];
+      view.set (row, HistoryStrategy::dateFieldCount + 1, bucket.completed);
+      net -= bucket.completed;
     }
 
-    if (deletedGroup.find (i.first) != deletedGroup.end ())
+    if (bucket.deleted)
     {
-      view.set (row, HistoryStrategy::dateFieldCount + 2, deletedGroup[i.first]);
-      net -= deletedGroup[i.first];
+      view.set (row, HistoryStrategy::dateFieldCount + 2, bucket.deleted);
+      net -= bucket.deleted;
     }
 
     Color net_color;
@@ -283,14 +384,9 @@ void CmdHistoryBase<HistoryStrategy>::outputTabular (std::string& output)
 }
 
 ////////////////////////////////////////////////////////////////////////////i
-class MonthlyHistoryStrategy
+class MonthlyHistoryStrategy : public MonthPeriod
 {
 public:
-  static Datetime getRelevantDate (const Datetime& dt)
-  {
-    return dt.startOfMonth ();
-  }
-
   static void setupTableDates (Table& view)
   {
     view.add (STRING_CMD_HISTORY_YEAR,  true);
@@ -331,49 +427,52 @@ int CmdHistoryBase<HistoryStrategy>::execute (std::string& output)
 {
   rc = 0;
 
-  // TODO is this necessary?
-  groups.clear ();
-  addedGroup.clear ();
-  deletedGroup.clear ();
-  completedGroup.clear ();
+  buckets.clear ();
+  first = 0;
 
   // Apply filter.
   handleUntil ();
   handleRecurrence ();
   Filter filter;
-  std::vector <Task> filtered;
-  filter.subset (filtered);
 
-  for (auto& task : filtered)
+  // Unfiltered, the per-day counts of all tasks serve, when they are up to date.
+  std::map <time_t, RollupDay> days;
+  if (filter.hasFilter () || ! Context::getContext ().tdb2.get_rollup (days))
   {
-    Datetime entry (task.get_date ("entry"));
+    days.clear ();
+    std::vector <Task> filtered;
+    filter.subset (filtered);
 
-    Datetime end;
-    if (task.has ("end"))
-      end = Datetime (task.get_date ("end"));
+    for (auto& task : filtered)
+      TDB2::rollup_count (days, task, 1);
 
-    auto epoch = HistoryStrategy::getRelevantDate (entry).toEpoch ();
-    groups[epoch] = 0;
+    if (! filter.hasFilter ())
+      Context::getContext ().tdb2.save_rollup (days);
+  }
 
-    // Every task has an entry date, but exclude templates.
-    if (task.getStatus () != Task::recurring)
-      ++addedGroup[epoch];
+  // The days are in order, and so are their timeintervals.
+  for (auto& day : days)
+  {
+    // Templates are counted only to show the interval they were entered in.
+    auto& counts = day.second;
+    if (! counts.added && ! counts.templates && ! counts.completed && ! counts.deleted)
+      continue;
 
-    // All deleted tasks have an end date.
-    if (task.getStatus () == Task::deleted)
-    {
-      epoch = HistoryStrategy::getRelevantDate (end).toEpoch ();
-      groups[epoch] = 0;
-      ++deletedGroup[epoch];
-    }
+    struct tm t;
+    localtime_r (&day.first, &t);
+    auto ordinal = HistoryStrategy::ordinal (t.tm_year + 1900, t.tm_mon + 1, t.tm_mday);
 
-    // All completed tasks have an end date.
-    else if (task.getStatus () == Task::completed)
-    {
-      epoch = HistoryStrategy::getRelevantDate (end).toEpoch ();
-      groups[epoch] = 0;
-      ++completedGroup[epoch];
-    }
+    if (buckets.empty ())
+      first = ordinal;
+
+    if (ordinal - first >= (int) buckets.size ())
+      buckets.resize (ordinal - first + 1);
+
+    auto& bucket = buckets[ordinal - first];
+    bucket.used       = true;
+    bucket.added     += counts.added;
+    bucket.completed += counts.completed;
+    bucket.deleted   += counts.deleted;
   }
 
   // Now build the view.
@@ -386,14 +485,9 @@ int CmdHistoryBase<HistoryStrategy>::execute (std::string& output)
 }
 
 ////////////////////////////////////////////////////////////////////////////i
-class MonthlyGHistoryStrategy
+class MonthlyGHistoryStrategy : public MonthPeriod
 {
 public:
-  static Datetime getRelevantDate (const Datetime& dt)
-  {
-    return dt.startOfMonth ();
-  }
-
   static void setupTableDates (Table& view)
   {
     view.add (STRING_CMD_HISTORY_YEAR,  true);
@@ -429,14 +523,9 @@ public:
 };
 
 ////////////////////////////////////////////////////////////////////////////i
-class AnnualGHistoryStrategy
+class AnnualGHistoryStrategy : public YearPeriod
 {
 public:
-  static Datetime getRelevantDate (const Datetime& dt)
-  {
-    return dt.startOfYear ();
-  }
-
   static void setupTableDates (Table& view)
   {
     view.add (STRING_CMD_HISTORY_YEAR, true);
@@ -469,14 +558,9 @@ public:
 };
 
 ////////////////////////////////////////////////////////////////////////////i
-class AnnualHistoryStrategy
+class AnnualHistoryStrategy : public YearPeriod
 {
 public:
-  static Datetime getRelevantDate (const Datetime& dt)
-  {
-    return dt.startOfYear ();
-  }
-
   static void setupTableDates (Table& view)
   {
     view.add (STRING_CMD_HISTORY_YEAR, true);
@@ -510,14 +594,9 @@ public:
 
 
 ////////////////////////////////////////////////////////////////////////////i
-class DailyHistoryStrategy
+class DailyHistoryStrategy : public DayPeriod
 {
 public:
-  static Datetime getRelevantDate (const Datetime& dt)
-  {
-    return dt.startOfDay ();
-  }
-
   static void setupTableDates (Table& view)
   {
     view.add (STRING_CMD_HISTORY_YEAR,  true);
@@ -560,14 +639,9 @@ public:
 };
 
 ////////////////////////////////////////////////////////////////////////////i
-class DailyGHistoryStrategy
+class DailyGHistoryStrategy : public DayPeriod
 {
 public:
-  static Datetime getRelevantDate (const Datetime& dt)
-  {
-    return dt.startOfDay ();
-  }
-
   static void setupTableDates (Table& view)
   {
     view.add (STRING_CMD_HISTORY_YEAR,  true);
@@ -610,14 +684,9 @@ public:
 };
 
 ////////////////////////////////////////////////////////////////////////////i
-class WeeklyHistoryStrategy
+class WeeklyHistoryStrategy : public WeekPeriod
 {
 public:
-  static Datetime getRelevantDate (const Datetime& dt)
-  {
-    return dt.startOfWeek ();
-  }
-
   static void setupTableDates (Table& view)
   {
     view.add (STRING_CMD_HISTORY_YEAR,  true);
@@ -660,14 +729,9 @@ public:
 };
 
 ////////////////////////////////////////////////////////////////////////////i
-class WeeklyGHistoryStrategy
+class WeeklyGHistoryStrategy : public WeekPeriod
 {
 public:
-  static Datetime getRelevantDate (const Datetime& dt)
-  {
-    return dt.startOfWeek ();
-  }
-
   static void setupTableDates (Table& view)
   {
     view.add (STRING_CMD_HISTORY_YEAR,  true);
@@ -28,6 +28,7 @@
 #define INCLUDED_CMDHISTORY
 
 #include <string>
+#include <vector>
 #include <Command.h>
 #include <Table.h>
 #include <Datetime.h>
@@ -40,10 +41,16 @@ public:
   int execute (std::string&);
 
 private:
-  std::map <time_t, int> groups;          // Represents any timeinterval with data
-  std::map <time_t, int> addedGroup;      // Additions by timeinterval
-  std::map <time_t, int> completedGroup;  // Completions by timeinterval
-  std::map <time_t, int> deletedGroup;    // Deletions by timeinterval
+  struct Bucket
+  {
+    int  added     {0};
+    int  completed {0};
+    int  deleted   {0};
+    bool used      {false};                 // Any task in this timeinterval
+  };
+
+  std::vector <Bucket> buckets;             // Indexed by timeinterval ordinal
+  int first;                                // Ordinal of buckets[0]
   int rc;
 
   void outputTabular (std::string&);
@@ -58,14 +58,14 @@ int CmdIDs::execute (std::string& output)
   handleUntil ();
   handleRecurrence ();
   Filter filter;
-  std::vector <Task> filtered;
-  filter.subset (filtered);
 
   // Find number of matching tasks.
   std::vector <int> ids;
-  for (auto& task : filtered)
+  filter.visit ([&ids] (const Task& task)
+  {
     if (task.id)
       ids.push_back (task.id);
+  });
 
   std::sort (ids.begin (), ids.end ());
   output = compressIds (ids) + '\n';
@@ -152,14 +152,20 @@ int CmdCompletionIds::execute (std::string& output)
   handleUntil ();
   handleRecurrence ();
   Filter filter;
-  std::vector <Task> filtered;
-  filter.subset (filtered);
 
+  // Unfiltered, the IDs are known without reading the tasks.
   std::vector <int> ids;
-  for (auto& task : filtered)
-    if (task.getStatus () != Task::deleted &&
-        task.getStatus () != Task::completed)
-      ids.push_back (task.id);
+  Completions candidates;
+  if (! filter.hasFilter () &&
+      Context::getContext ().tdb2.completions (candidates))
+    ids = candidates.ids;
+  else
+    filter.visit ([&ids] (const Task& task)
+    {
+      if (task.getStatus () != Task::deleted &&
+          task.getStatus () != Task::completed)
+        ids.push_back (task.id);
+    });
 
   std::sort (ids.begin (), ids.end ());
   output = join ("\n", ids) + '\n';
@@ -191,17 +197,17 @@ int CmdZshCompletionIds::execute (std::string& output)
   handleUntil ();
   handleRecurrence ();
   Filter filter;
-  std::vector <Task> filtered;
-  filter.subset (filtered);
 
   std::stringstream out;
-  for (auto& task : filtered)
+  filter.visit ([&out] (const Task& task)
+  {
     if (task.getStatus () != Task::deleted &&
         task.getStatus () != Task::completed)
       out << task.id
           << ':'
           << str_replace(task.get ("description"), ":", zshColonReplacement)
           << '\n';
+  });
 
   output = out.str ();
 
@@ -232,12 +238,9 @@ int CmdUUIDs::execute (std::string& output)
   handleUntil ();
   handleRecurrence ();
   Filter filter;
-  std::vector <Task> filtered;
-  filter.subset (filtered);
 
   std::vector <std::string> uuids;
-  for (auto& task : filtered)
-    uuids.push_back (task.get ("uuid"));
+  filter.visit ([&uuids] (const Task& task) { uuids.push_back (task.get ("uuid")); });
 
   std::sort (uuids.begin (), uuids.end ());
   output = join (" ", uuids) + '\n';
@@ -269,12 +272,9 @@ int CmdCompletionUuids::execute (std::string& output)
   handleUntil ();
   handleRecurrence ();
   Filter filter;
-  std::vector <Task> filtered;
-  filter.subset (filtered);
 
   std::vector <std::string> uuids;
-  for (auto& task : filtered)
-    uuids.push_back (task.get ("uuid"));
+  filter.visit ([&uuids] (const Task& task) { uuids.push_back (task.get ("uuid")); });
 
   std::sort (uuids.begin (), uuids.end ());
   output = join ("\n", uuids) + '\n';
@@ -306,15 +306,15 @@ int CmdZshCompletionUuids::execute (std::string& output)
   handleUntil ();
   handleRecurrence ();
   Filter filter;
-  std::vector <Task> filtered;
-  filter.subset (filtered);
 
   std::stringstream out;
-  for (auto& task : filtered)
+  filter.visit ([&out] (const Task& task)
+  {
     out << task.get ("uuid")
         << ':'
         << str_replace (task.get ("description"), ":", zshColonReplacement)
         << '\n';
+  });
 
   output = out.str ();
 
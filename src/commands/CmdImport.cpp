@@ -28,11 +28,20 @@
 #include <CmdImport.h>
 #include <CmdModify.h>
 #include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <exception>
+#include <Allocations.h>
 #include <Context.h>
+#include <Pool.h>
 #include <format.h>
 #include <shared.h>
 #include <util.h>
 
+#define IMPORT_BLOCK 65536
+#define IMPORT_BATCH 1000
+#define IMPORT_CHUNK_MINIMUM 100
+
 ////////////////////////////////////////////////////////////////////////////////
 CmdImport::CmdImport ()
 {
@@ -57,18 +66,16 @@ int CmdImport::execute (std::string&)
 
   // Get filenames from command line arguments.
   auto words = Context::getContext ().cli2.getWords ();
+
+  // Hooks may be skipped for a bulk import.
+  auto skip_hooks = ! Context::getContext ().config.getBoolean ("import.hooks");
+  auto hooks = skip_hooks && Context::getContext ().hooks.enable (false);
+
   if (! words.size () ||
       (words.size () == 1 && words[0] == "-"))
   {
     std::cout << format ("Importing '{1}'\n", "STDIN");
-
-    std::string json;
-    std::string line;
-    while (std::getline (std::cin, line))
-      json += line + '\n';
-
-    if (nontrivial (json))
-      count = import (json);
+    count = import (std::cin);
   }
   else
   {
@@ -81,98 +88,240 @@ int CmdImport::execute (std::string&)
 
       std::cout << format ("Importing '{1}'\n", word);
 
-      // Load the file.
-      std::string json;
-      incoming.read (json);
-      if (nontrivial (json))
-        count += import (json);
+      std::ifstream in (incoming._data, std::ios::binary);
+      if (! in.good ())
+        throw format ("Could not read '{1}'.", word);
+
+      count += import (in);
     }
   }
 
+  if (skip_hooks)
+    Context::getContext ().hooks.enable (hooks);
+
   Context::getContext ().footnote (format ("Imported {1} tasks.", count));
   return rc;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-int CmdImport::import (const std::string& input)
+// Imports each object in the input as it is read, so that only one object is
+// held in memory at a time.  The input may be a single object, an array of
+// objects, or one object per line:
+//
+//   { ... }
+//
+//   [ { ... } , { ... } ]
+//
+//   { ... }
+//   { ... }
+//
+int CmdImport::import (std::istream& input)
 {
   auto count = 0;
-  try
+
+  std::string object;
+  int depth = 0;
+  bool quoted = false;
+  bool escaped = false;
+
+  char buffer[IMPORT_BLOCK];
+  while (input.read (buffer, sizeof (buffer)) || input.gcount ())
   {
-    json::value* root = json::parse (input);
-    if (root)
+    auto length = input.gcount ();
+    for (std::streamsize i = 0; i < length; ++i)
     {
-      // Single object parse. Input looks like:
-      //   { ... }
-      if (root->type () == json::j_object)
+      char c = buffer[i];
+
+      // Between objects, only the surrounding array is expected.
+      if (depth == 0)
       {
-        // For each object element...
-        json::object* root_obj = (json::object*)root;
-        importSingleTask (root_obj);
-        ++count;
+        if (c == '{')
+        {
+          object = c;
+          depth = 1;
+        }
+        else if (c != '[' && c != ']' && c != ',' && ! isspace ((unsigned char) c))
+          throw format ("Unrecognized input '{1}' between JSON objects.", std::string (1, c));
+
+        continue;
       }
 
-      // Multiple object array. Input looks like:
-      //   [ { ... } , { ... } ]
-      else if (root->type () == json::j_array)
+      object += c;
+
+      if (quoted)
+      {
+        if (escaped)
+          escaped = false;
+        else if (c == '\\')
+          escaped = true;
+        else if (c == '"')
+          quoted = false;
+      }
+      else if (c == '"')
+        quoted = true;
+      else if (c == '{' || c == '[')
+        ++depth;
+      else if ((c == '}' || c == ']') && --depth == 0)
       {
-        json::array* root_arr = (json::array*)root;
+        _objects.push_back (object);
+        object.clear ();
+        ++count;
 
-        // For each object element...
-        for (auto& element : root_arr->_data)
-        {
-          // For each object element...
-          json::object* root_obj = (json::object*)element;
-          importSingleTask (root_obj);
-          ++count;
-        }
+        if (_objects.size () >= IMPORT_BATCH)
+          importBatch ();
       }
+    }
+  }
 
+  // An incomplete object fails to parse, with the parser's explanation.
+  if (depth)
+    _objects.push_back (object);
+
+  importBatch ();
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Parses and validates the task.
+void CmdImport::parseTask (const std::string& input, Staged& staged)
+{
+  // Most tasks are read directly, the rest are parsed whole.
+  Task task;
+  if (! task.readJSON (input))
+  {
+    json::value* root = json::parse (input);
+    if (! root)
+      return;
+
+    try
+    {
+      task = Task ((json::object*) root);
+    }
+
+    catch (...)
+    {
       delete root;
+      throw;
     }
+
+    delete root;
+  }
+
+  // Validate the data.
+  staged.generatedEntry = not task.has ("entry");
+  auto hasExplicitEnd = task.has ("end");
+
+  task.validate ();
+
+  staged.generatedEnd = not hasExplicitEnd and task.has ("end");
+  staged.task = task;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Adds the parsed task to the batch.  A task already in the batch is replaced,
+// keeping any values the replacement only generated, as importing both in turn
+// would.
+void CmdImport::stageTask (Staged& staged)
+{
+  // Validation always provides a uuid, so without one, nothing was parsed.
+  if (! staged.task.has ("uuid"))
+    return;
+
+  auto uuid = staged.task.get ("uuid");
+  auto found = _staged.find (uuid);
+  if (found == _staged.end ())
+  {
+    _staged[uuid] = _batch.size ();
+    _batch.push_back (staged);
   }
+  else
+  {
+    auto& earlier = _batch[found->second];
+
+    if (staged.generatedEntry)
+      staged.task.set ("entry", earlier.task.get ("entry"));
+
+    if (staged.generatedEnd && earlier.task.has ("end"))
+      staged.task.set ("end", earlier.task.get ("end"));
+
+    earlier.task = staged.task;
+    earlier.generatedEntry = earlier.generatedEntry && staged.generatedEntry;
+    earlier.generatedEnd   = earlier.generatedEnd   && staged.generatedEnd;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Parses the objects read so far, concurrently with import.threads, then
+// stages and applies them in input order.  Only parsing and validation are
+// concurrent, as applying a task looks up and modifies the data files.
+void CmdImport::importBatch ()
+{
+  std::vector <Staged> parsed (_objects.size ());
+  std::vector <std::exception_ptr> errors (_objects.size ());
 
-  // If an exception is caught, then it is because the free-form JSON
-  // objects/array above failed to parse. This is an indication that the input
-  // is an old-style line-by-line set of JSON objects, because both an array of
-  // objects, and a single object have failed to parse..
-  //
-  // Input looks like:
-  //   { ... }
-  //   { ... }
-  catch (std::string& e)
+  size_t threads = Context::getContext ().config.getInteger ("import.threads");
+  if (threads == 0)
+    threads = Pool::threads ();
+
+  threads = std::min (threads, _objects.size () / IMPORT_CHUNK_MINIMUM);
+  if (threads <= 1)
+  {
+    for (size_t i = 0; i < _objects.size (); ++i)
+      parseTask (_objects[i], parsed[i]);
+  }
+  else
   {
-    for (auto& line : split (input, '\n'))
+    auto chunk = (_objects.size () + threads - 1) / threads;
+    Pool::run (threads, [&] (size_t t)
     {
-      if (line.length ())
+      auto end = std::min (_objects.size (), (t + 1) * chunk);
+      for (auto i = t * chunk; i < end; ++i)
       {
-        json::value* root = json::parse (line);
-        if (root)
+        try
         {
-          importSingleTask ((json::object*) root);
-          ++count;
-          delete root;
+          parseTask (_objects[i], parsed[i]);
+        }
+
+        catch (...)
+        {
+          errors[i] = std::current_exception ();
         }
       }
-    }
+    });
+
+    // The first error in the input is the one reported.
+    for (auto& error : errors)
+      if (error)
+        std::rethrow_exception (error);
   }
 
-  return count;
-}
+  if (Context::getContext ().config.get ("perf.output") == "json")
+  {
+    long bytes = (long) Allocations::held (_objects);
+    for (auto& staged : parsed)
+      bytes += (long) staged.task.bytes ();
 
-////////////////////////////////////////////////////////////////////////////////
-void CmdImport::importSingleTask (json::object* obj)
-{
-  // Parse the whole thing, validate the data.
-  Task task (obj);
+    Context::getContext ().memory_import = std::max (Context::getContext ().memory_import, bytes);
+  }
 
-  auto hasGeneratedEntry = not task.has ("entry");
-  auto hasExplicitEnd = task.has ("end");
+  _objects.clear ();
 
-  task.validate ();
+  for (auto& staged : parsed)
+    stageTask (staged);
+
+  for (auto& staged : _batch)
+    importSingleTask (staged.task, staged.generatedEntry, staged.generatedEnd);
 
-  auto hasGeneratedEnd = not hasExplicitEnd and task.has ("end");
+  _batch.clear ();
+  _staged.clear ();
+}
 
+////////////////////////////////////////////////////////////////////////////////
+void CmdImport::importSingleTask (
+  Task& task,
+  bool hasGeneratedEntry,
+  bool hasGeneratedEnd)
+{
   // Check whether the imported task is new or a modified existing task.
   Task before;
   if (Context::getContext ().tdb2.get (task.get ("uuid"), before))
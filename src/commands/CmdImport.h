@@ -28,8 +28,12 @@
 #define INCLUDED_CMDIMPORT
 
 #include <string>
+#include <istream>
+#include <vector>
+#include <unordered_map>
 #include <Command.h>
 #include <JSON.h>
+#include <Task.h>
 
 class CmdImport : public Command
 {
@@ -38,8 +42,23 @@ public:
   int execute (std::string&);
 
 private:
-  int import (const std::string&);
-  void importSingleTask (json::object*);
+  struct Staged
+  {
+    Task task           {};
+    bool generatedEntry {false};
+    bool generatedEnd   {false};
+  };
+
+  int import (std::istream&);
+  void parseTask (const std::string&, Staged&);
+  void stageTask (Staged&);
+  void importBatch ();
+  void importSingleTask (Task&, bool, bool);
+
+private:
+  std::vector <std::string> _objects {};
+  std::vector <Staged> _batch {};
+  std::unordered_map <std::string, size_t> _staged {};
 };
 
 #endif
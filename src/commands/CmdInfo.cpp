@@ -76,10 +76,8 @@ int CmdInfo::execute (std::string& output)
     rc = 1;
   }
 
-  // Get the undo data.
+  // The undo data of each task is read as it is shown.
   std::vector <std::string> undo;
-  if (Context::getContext ().config.getBoolean ("journal.info"))
-    undo = Context::getContext ().tdb2.undo.get_lines ();
 
   // Determine the output date format, which uses a hierarchy of definitions.
   //   rc.dateformat.info
@@ -92,19 +90,61 @@ int CmdInfo::execute (std::string& output)
   if (dateformatanno == "")
     dateformatanno = dateformat;
 
+  auto indent      = Context::getContext ().config.getInteger ("indent.annotation");
+  auto journal_info = Context::getContext ().config.getBoolean ("journal.info");
+
+  // The tables are laid out the same for every task, so are set up once, and
+  // copied for each task.
+  auto width     = Context::getContext ().getWidth ();
+  auto obfuscate = Context::getContext ().config.getBoolean ("obfuscate");
+  auto color     = Context::getContext ().color ();
+
+  Table blank_view;
+  blank_view.width (width);
+  if (obfuscate)
+    blank_view.obfuscate ();
+  if (color)
+    blank_view.forceColor ();
+  blank_view.add ("Name");
+  blank_view.add ("Value");
+  setHeaderUnderline (blank_view);
+
+  Table blank_urgency;
+  setHeaderUnderline (blank_urgency);
+  if (color)
+  {
+    Color alternate (Context::getContext ().config.get ("color.alternate"));
+    blank_urgency.colorOdd (alternate);
+    blank_urgency.intraColorOdd (alternate);
+  }
+
+  if (obfuscate)
+    blank_urgency.obfuscate ();
+
+  blank_urgency.width (width);
+  blank_urgency.add (""); // Attribute
+  blank_urgency.add (""); // Value
+  blank_urgency.add (""); // *
+  blank_urgency.add (""); // Coefficient
+  blank_urgency.add (""); // =
+  blank_urgency.add (""); // Result
+
+  Table blank_journal;
+  setHeaderUnderline (blank_journal);
+  if (obfuscate)
+    blank_journal.obfuscate ();
+  if (color)
+    blank_journal.forceColor ();
+
+  blank_journal.width (width);
+  blank_journal.add ("Date");
+  blank_journal.add ("Modification");
+
   // Render each task.
   std::stringstream out;
   for (auto& task : filtered)
   {
-    Table view;
-    view.width (Context::getContext ().getWidth ());
-    if (Context::getContext ().config.getBoolean ("obfuscate"))
-      view.obfuscate ();
-    if (Context::getContext ().color ())
-      view.forceColor ();
-    view.add ("Name");
-    view.add ("Value");
-    setHeaderUnderline (view);
+    Table view = blank_view;
 
     Datetime now;
 
@@ -119,7 +159,6 @@ int CmdInfo::execute (std::string& output)
     Color c;
     autoColorize (task, c);
     auto description = task.get ("description");
-    auto indent = Context::getContext ().config.getInteger ("indent.annotation");
 
     for (auto& anno : task.getAnnotations ())
       description += '\n'
@@ -422,30 +461,9 @@ int CmdInfo::execute (std::string& output)
     }
 
     // Create a second table, containing urgency details, if necessary.
-    Table urgencyDetails;
+    Table urgencyDetails = blank_urgency;
     if (task.urgency () != 0.0)
     {
-      setHeaderUnderline (urgencyDetails);
-      if (Context::getContext ().color ())
-      {
-        Color alternate (Context::getContext ().config.get ("color.alternate"));
-        urgencyDetails.colorOdd (alternate);
-        urgencyDetails.intraColorOdd (alternate);
-      }
-
-      if (Context::getContext ().config.getBoolean ("obfuscate"))
-        urgencyDetails.obfuscate ();
-      if (Context::getContext ().config.getBoolean ("color"))
-        view.forceColor ();
-
-      urgencyDetails.width (Context::getContext ().getWidth ());
-      urgencyDetails.add (""); // Attribute
-      urgencyDetails.add (""); // Value
-      urgencyDetails.add (""); // *
-      urgencyDetails.add (""); // Coefficient
-      urgencyDetails.add (""); // =
-      urgencyDetails.add (""); // Result
-
       urgencyTerm (urgencyDetails, "project",     task.urgency_project (),     Task::urgencyProjectCoefficient);
       urgencyTerm (urgencyDetails, "active",      task.urgency_active (),      Task::urgencyActiveCoefficient);
       urgencyTerm (urgencyDetails, "scheduled",   task.urgency_scheduled (),   Task::urgencyScheduledCoefficient);
@@ -524,19 +542,12 @@ int CmdInfo::execute (std::string& output)
     }
 
     // Create a third table, containing undo log change details.
-    Table journal;
-    setHeaderUnderline (journal);
-
-    if (Context::getContext ().config.getBoolean ("obfuscate"))
-      journal.obfuscate ();
-    if (Context::getContext ().config.getBoolean ("color"))
-      journal.forceColor ();
+    Table journal = blank_journal;
 
-    journal.width (Context::getContext ().getWidth ());
-    journal.add ("Date");
-    journal.add ("Modification");
+    if (journal_info)
+      Context::getContext ().tdb2.undo_history (uuid, undo);
 
-    if (Context::getContext ().config.getBoolean ("journal.info") &&
+    if (journal_info &&
         undo.size () > 3)
     {
       // Scan the undo data for entries matching this task, without making
@@ -70,35 +70,49 @@ int CmdModify::execute (std::string&)
   // Accumulated project change notifications.
   std::map <std::string, std::string> projectChanges;
 
-  auto count = 0;
+  // Every modification is planned, and checked, before any is confirmed, and
+  // those confirmed are then applied together.
+  std::vector <Task> before;
+  std::vector <Task> planned;
   for (auto& task : filtered)
   {
-    Task before (task);
+    Task original (task);
     task.modify (Task::modReplace);
 
-    if (before.data != task.data)
+    if (original.data != task.data)
     {
       // Abort if change introduces inconsistencies.
-      checkConsistency(before, task);
-
-      auto question = format ("Modify task {1} '{2}'?",
-                              task.identifier (true),
-                              task.get ("description"));
-
-      if (permission (taskDifferences (before, task) + question, filtered.size ()))
-      {
-        count += modifyAndUpdate (before, task, &projectChanges);
-      }
-      else
-      {
-        std::cout << "Task not modified.\n";
-        rc = 1;
-        if (_permission_quit)
-          break;
-      }
+      checkConsistency(original, task);
+
+      before.push_back (original);
+      planned.push_back (task);
     }
   }
 
+  summarize (format ("{1} tasks to modify:", planned.size ()), planned, filtered.size ());
+
+  std::vector <size_t> confirmed;
+  for (size_t i = 0; i < planned.size (); ++i)
+  {
+    auto question = format ("Modify task {1} '{2}'?",
+                            planned[i].identifier (true),
+                            planned[i].get ("description"));
+
+    if (permission (taskDifferences (before[i], planned[i]) + question, filtered.size ()))
+      confirmed.push_back (i);
+    else
+    {
+      std::cout << "Task not modified.\n";
+      rc = 1;
+      if (_permission_quit)
+        break;
+    }
+  }
+
+  auto count = 0;
+  for (auto i : confirmed)
+    count += modifyAndUpdate (before[i], planned[i], &projectChanges);
+
   // Now list the project changes.
   for (const auto& change : projectChanges)
     if (change.first != "")
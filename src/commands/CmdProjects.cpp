@@ -30,11 +30,11 @@
 #include <sstream>
 #include <Context.h>
 #include <Filter.h>
+#include <ProjectTree.h>
 #include <Table.h>
 #include <format.h>
 #include <util.h>
 #include <main.h>
-#include <list>
 
 ////////////////////////////////////////////////////////////////////////////////
 CmdProjects::CmdProjects ()
@@ -60,71 +60,84 @@ int CmdProjects::execute (std::string& output)
   // Get all the tasks.
   handleUntil ();
   handleRecurrence ();
-  auto tasks = Context::getContext ().tdb2.pending.get_tasks ();
-
-  if (Context::getContext ().config.getBoolean ("list.all.projects"))
-    for (auto& task : Context::getContext ().tdb2.completed.get_tasks ())
-      tasks.push_back (task);
-
-  // Apply the filter.
-  Filter filter;
-  std::vector <Task> filtered;
-  filter.subset (tasks, filtered);
-  int quantity = filtered.size ();
+  bool all = Context::getContext ().config.getBoolean ("list.all.projects");
 
   std::stringstream out;
 
-  // Scan all the tasks for their project name, building a map using project
-  // names as keys.
-  std::map <std::string, int> unique;
+  // Count the tasks in each project, and its parents.  Unfiltered, and with GC
+  // keeping only pending tasks in pending.data, the counts are kept by commit.
+  ProjectTree projects;
   bool no_project = false;
-  std::string project;
-  for (auto& task : filtered)
+  int quantity = 0;
+  Filter filter;
+  if (! filter.hasFilter () &&
+      Context::getContext ().config.getBoolean ("gc"))
   {
-    if (task.getStatus () == Task::deleted)
+    std::map <std::string, ProjectCount> counts;
+    Context::getContext ().tdb2.counts ("projects", counts);
+    for (auto& count : counts)
     {
-      --quantity;
-      continue;
+      int tasks = count.second.pending + count.second.templates + (all ? count.second.done : 0);
+      if (tasks > 0)
+      {
+        projects.add (count.first).tasks += tasks;
+        quantity += tasks;
+
+        if (count.first == "")
+          no_project = true;
+      }
     }
+  }
+  else
+  {
+    auto tasks = Context::getContext ().tdb2.pending.get_tasks ();
+
+    if (all)
+      for (auto& task : Context::getContext ().tdb2.completed.get_tasks ())
+        tasks.push_back (task);
 
-    // Increase the count for the project the task belongs to and all
-    // its super-projects
-    project = task.get ("project");
+    // Apply the filter.
+    std::vector <Task> filtered;
+    filter.subset (tasks, filtered);
+    quantity = filtered.size ();
 
-    std::vector <std::string> projects = extractParents (project);
-    projects.push_back (project);
+    for (auto& task : filtered)
+    {
+      if (task.getStatus () == Task::deleted)
+      {
+        --quantity;
+        continue;
+      }
 
-    for (auto& parent : projects)
-      unique[parent] += 1;
+      auto project = task.get ("project");
+      ++projects.add (project).tasks;
 
-    if (project == "")
-      no_project = true;
+      if (project == "")
+        no_project = true;
+    }
   }
 
-  if (unique.size ())
+  projects.total ();
+
+  if (projects.shown ())
   {
-    // Render a list of project names from the map.
+    // Render a list of project names from the tree.
     Table view;
     view.width (Context::getContext ().getWidth ());
     view.add ("Project");
     view.add ("Tasks", false);
     setHeaderUnderline (view);
 
-    // create sorted list of table entries
-    std::list <std::pair<std::string, int>> sorted_view;
-    sort_projects (sorted_view, unique);
-
-    // construct view from sorted list
-    for (auto& item: sorted_view)
+    projects.visit ([&view] (const ProjectTree::Node& node)
     {
       int row = view.addRow ();
-      view.set (row, 0, (item.first == ""
+      view.set (row, 0, (node.name == ""
                           ? "(none)"
-                          : indentProject (item.first, "  ", '.')));
-      view.set (row, 1, item.second);
-    }
+                          : indentProject (node.name, "  ", '.')));
+      view.set (row, 1, node.tasks);
+    });
 
-    int number_projects = unique.size ();
+    int number_projects = projects.shown ();
     if (no_project)
       --number_projects;
 
@@ -172,6 +185,21 @@ int CmdCompletionProjects::execute (std::string& output)
   // Get all the tasks.
   handleUntil ();
   handleRecurrence ();
+
+  // Unfiltered, the projects are known without reading the tasks.
+  Completions candidates;
+  if (! Filter ().hasFilter () &&
+      Context::getContext ().tdb2.completions (candidates))
+  {
+    if (Context::getContext ().config.getBoolean ("list.all.projects"))
+      candidates.projects.insert (candidates.done_projects.begin (), candidates.done_projects.end ());
+
+    for (auto& project : candidates.projects)
+      output += project + '\n';
+
+    return 0;
+  }
+
   auto tasks = Context::getContext ().tdb2.pending.get_tasks ();
 
   if (Context::getContext ().config.getBoolean ("list.all.projects"))
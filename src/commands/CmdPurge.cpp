@@ -50,63 +50,92 @@ CmdPurge::CmdPurge ()
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-// Purges the task, while taking care of:
-// - dependencies on this task
-// - child tasks
-void CmdPurge::purgeTask (Task& task, int& count)
+// Adds the task to those to be purged, along with its child tasks.  The tasks
+// are only purged once all are known, so that the dependencies on them are
+// removed in a single pass.
+void CmdPurge::purgeTask (
+  Task& task,
+  std::vector <Task>& purging,
+  std::unordered_set <std::string>& uuids)
 {
-  Context::getContext ().tdb2.purge (task);
-  handleDeps (task);
-  handleChildren (task, count);
-  count++;
+  if (! uuids.insert (task.get ("uuid")).second)
+    return;
+
+  purging.push_back (task);
+  handleChildren (task, purging, uuids);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-// Makes sure that any task having the dependency on the task being purged
-// has that dependency removed, to preserve referential integrity.
-void CmdPurge::handleDeps (Task& task)
+// Makes sure that any task having a dependency on a task being purged has that
+// dependency removed, to preserve referential integrity.  Each such task is
+// modified once, however many of its dependencies are purged.
+void CmdPurge::handleDeps (const std::unordered_set <std::string>& uuids)
 {
-   std::string uuid = task.get ("uuid");
-
-   for (auto& blockedConst: Context::getContext ().tdb2.all_tasks ())
-   {
-     Task& blocked = const_cast<Task&>(blockedConst);
-     if (blocked.has ("depends") &&
-         blocked.get ("depends").find (uuid) != std::string::npos)
-     {
-         blocked.removeDependency (uuid);
-         Context::getContext ().tdb2.modify (blocked);
-     }
-   }
+  // Only the dependent tasks are copied, and modified once the scan is done.
+  std::vector <Task> dependents;
+  for (auto& blocked : Context::getContext ().tdb2.all_tasks ())
+  {
+    if (! blocked.has ("depends") ||
+        uuids.find (blocked.get ("uuid")) != uuids.end ())
+      continue;
+
+    for (auto& uuid : blocked.getDependencyUUIDs ())
+    {
+      if (uuids.find (uuid) != uuids.end ())
+      {
+        dependents.push_back (blocked);
+        break;
+      }
+    }
+  }
+
+  for (auto& blocked : dependents)
+  {
+    for (auto& uuid : blocked.getDependencyUUIDs ())
+      if (uuids.find (uuid) != uuids.end ())
+        blocked.removeDependency (uuid);
+
+    Context::getContext ().tdb2.modify (blocked);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // Makes sure that with any recurrence parent are all the child tasks removed
 // as well. If user chooses not to, the whole command is aborted.
-void CmdPurge::handleChildren (Task& task, int& count)
+void CmdPurge::handleChildren (
+  Task& task,
+  std::vector <Task>& purging,
+  std::unordered_set <std::string>& uuids)
 {
   // If this is not a recurrence parent, we have no job here
   if (!task.has ("mask"))
     return;
 
+  // The children of every task are found in one pass, when first needed.
+  if (! _found_children)
+  {
+    for (auto& child : Context::getContext ().tdb2.all_tasks ())
+      if (child.has ("parent"))
+        _children.emplace (child.get ("parent"), child);
+
+    _found_children = true;
+  }
+
   std::string uuid = task.get ("uuid");
   std::vector<Task> children;
 
   // Find all child tasks
-  for (auto& childConst: Context::getContext ().tdb2.all_tasks ())
+  auto range = _children.equal_range (uuid);
+  for (auto i = range.first; i != range.second; ++i)
   {
-    Task& child = const_cast<Task&> (childConst);
-
-    if (child.get ("parent") == uuid)
-    {
-      if (child.getStatus () != Task::deleted)
-        // In case any child task is not deleted, bail out
-        throw format ("Task '{1}' is a recurrence template. Its child task {2} must be deleted before it can be purged.",
-                      task.get ("description"),
-                      child.identifier (true));
-      else
-        children.push_back (child);
-    }
+    auto& child = i->second;
+    if (child.getStatus () != Task::deleted)
+      // In case any child task is not deleted, bail out
+      throw format ("Task '{1}' is a recurrence template. Its child task {2} must be deleted before it can be purged.",
+                    task.get ("description"),
+                    child.identifier (true));
+    else
+      children.push_back (child);
   }
 
   // If there are no children, our job is done
@@ -123,7 +152,7 @@ void CmdPurge::handleChildren (Task& task, int& count)
        && confirm (question)))
   {
     for (auto& child: children)
-      purgeTask (child, count);
+      purgeTask (child, purging, uuids);
   }
   else
     throw std::string ("Purge operation aborted.");
@@ -134,7 +163,8 @@ void CmdPurge::handleChildren (Task& task, int& count)
 int CmdPurge::execute (std::string&)
 {
   int rc = 0;
-  int count = 0;
+  std::vector <Task> purging;
+  std::unordered_set <std::string> uuids;
 
   Filter filter;
   std::vector <Task> filtered;
@@ -162,10 +192,16 @@ int CmdPurge::execute (std::string&)
                          task.get ("description"));
 
       if (permission (question, filtered.size ()))
-        purgeTask (task, count);
+        purgeTask (task, purging, uuids);
     }
   }
 
+  for (auto& task : purging)
+    Context::getContext ().tdb2.purge (task);
+
+  handleDeps (uuids);
+
+  int count = purging.size ();
   feedback_affected (count == 1 ? "Purged {1} task." : "Purged {1} tasks.", count);
   return rc;
 }
@@ -28,14 +28,20 @@
 #define INCLUDED_CMDPURGE
 
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include <Command.h>
 
 class CmdPurge : public Command
 {
 private:
-  void purgeTask (Task& task, int& count);
-  void handleChildren (Task& task, int& count);
-  void handleDeps (Task& task);
+  void purgeTask (Task& task, std::vector <Task>& purging, std::unordered_set <std::string>& uuids);
+  void handleChildren (Task& task, std::vector <Task>& purging, std::unordered_set <std::string>& uuids);
+  void handleDeps (const std::unordered_set <std::string>& uuids);
+
+  std::unordered_multimap <std::string, Task> _children {};  // By parent uuid
+  bool _found_children {false};
 public:
   CmdPurge ();
   int execute (std::string&);
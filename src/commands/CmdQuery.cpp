@@ -0,0 +1,121 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmake.h>
+#include <CmdQuery.h>
+#include <Context.h>
+#include <Filter.h>
+#include <main.h>
+#include <shared.h>
+#include <format.h>
+#include <iostream>
+#include <set>
+
+////////////////////////////////////////////////////////////////////////////////
+CmdQuery::CmdQuery ()
+{
+  _keyword               = "_query";
+  _usage                 = "task <filter> _query [sort:<order>] [<attribute> ...]";
+  _description           = "Exports the named attributes of tasks, sorted, one JSON object per line";
+  _read_only             = true;
+  _displays_id           = true;
+  _needs_gc              = true;
+  _uses_context          = false;
+  _accepts_filter        = true;
+  _accepts_modifications = false;
+  _accepts_miscellaneous = true;
+  _category              = Command::Category::internal;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// As export, but for integrations that run many queries through one 'tw'
+// process, the output is always one object per line, holding only the named
+// attributes, or all of them when none are named.
+int CmdQuery::execute (std::string&)
+{
+  std::string order;
+  std::set <std::string> attributes;
+  for (auto& word : Context::getContext ().cli2.getWords ())
+  {
+    if (word.substr (0, 5) == "sort:")
+      order = word.substr (5);
+    else
+      attributes.insert (word);
+  }
+
+  auto sortOrder = split (order, ',');
+  for (auto& column : sortOrder)
+    legacySortColumnMap (column);
+
+  // Make sure recurrent tasks are generated.
+  handleUntil ();
+  handleRecurrence ();
+
+  // Obey 'limit:N'.  Unsorted, filtering stops at the limit.
+  int rows = 0;
+  int lines = 0;
+  Context::getContext ().getLimits (rows, lines);
+  int limit = (rows > lines ? rows : lines);
+
+  Filter filter;
+  if (sortOrder.size () == 0)
+    filter.limit (limit);
+
+  std::vector <Task> filtered;
+  filter.subset (filtered);
+
+  std::vector <int> sequence;
+  for (unsigned int i = 0; i < filtered.size (); ++i)
+    sequence.push_back (i);
+
+  if (sortOrder.size ())
+  {
+    if (order.find ("urgency") != std::string::npos)
+      Context::getContext ().tdb2.urgency (filtered);
+
+    // Only the first tasks within the limit are sorted, and kept.
+    sort_tasks (filtered, sequence, order, limit > 0 ? limit : 0);
+  }
+
+  Timer timer;
+  Context::getContext ().writeHeaders ();
+
+  std::string buffer;
+  for (auto i : sequence)
+  {
+    filtered[i].composeJSON (buffer, true, attributes.size () ? &attributes : nullptr);
+    buffer += '\n';
+  }
+
+  std::cout << buffer << std::flush;
+
+  Context::getContext ().count_rendered += (long) sequence.size ();
+  Context::getContext ().time_render_us += timer.total_us ();
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
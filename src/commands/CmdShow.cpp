@@ -29,7 +29,9 @@
 #include <vector>
 #include <sstream>
 #include <algorithm>
+#include <unordered_set>
 #include <format.h>
+#include <shared.h>
 #include <main.h>
 #include <Context.h>
 #include <FS.h>
@@ -72,10 +74,8 @@ int CmdShow::execute (std::string& output)
   int width = Context::getContext ().getWidth ();
 
   // Complain about configuration variables that are not recognized.
-  // These are the regular configuration variables.
-  // Note that there is a leading and trailing space, to make it easier to
-  // search for whole words.
-  std::string recognized =
+  // These are the regular configuration variables, split once into a set.
+  static const std::string names =
     " abbreviation.minimum"
     " active.indicator"
     " allow.empty.filter"
@@ -129,10 +129,19 @@ int CmdShow::execute (std::string& output)
     " color.undo.before"
     " color.until"
     " column.padding"
+    " column.sample"
     " complete.all.tags"
     " confirmation"
     " context"
+    " data.append"
+    " data.atomic"
+    " data.backlog"
+    " data.index"
+    " data.journal"
+    " data.snapshot"
+    " data.sources"
     " data.location"
+    " data.threads"
     " dateformat"
     " dateformat.annotation"
     " dateformat.edit"
@@ -159,11 +168,24 @@ int CmdShow::execute (std::string& output)
     " due"
     " editor"
     " exit.on.missing.db"
+    " export.after"
+    " export.fields"
+    " export.page"
+    " export.threads"
     " expressions"
+    " filter.threads"
     " fontunderline"
     " gc"
+    " gc.deferred"
     " hooks"
+    " hooks.async"
+    " hooks.budget"
+    " hooks.parallel"
+    " hooks.resident"
+    " hooks.timeout"
     " hyphenate"
+    " import.hooks"
+    " import.threads"
     " indent.annotation"
     " indent.report"
     " journal.info"
@@ -175,15 +197,22 @@ int CmdShow::execute (std::string& output)
     " list.all.projects"
     " list.all.tags"
     " locking"
+    " memory.budget"
     " monthsperline"
     " nag"
     " obfuscate"
+    " parser.cache"
+    " perf.file"
+    " perf.output"
     " print.empty.columns"
+    " print.stream"
     " recurrence"
     " recurrence.confirmation"
     " recurrence.indicator"
     " recurrence.limit"
     " regex"
+    " render.threads"
+    " report.cache"
     " reserved.lines"
     " row.padding"
     " rule.color.merge"
@@ -193,12 +222,18 @@ int CmdShow::execute (std::string& output)
     " summary.all.projects"
     " tag.indicator"
     " taskd.server"
+    " taskd.background"
     " taskd.ca"
     " taskd.certificate"
     " taskd.ciphers"
     " taskd.credentials"
     " taskd.key"
+    " taskd.resume"
     " taskd.trust"
+    " threads"
+    " trace.file"
+    " undo.delta"
+    " undo.size"
     " undo.style"
     " urgency.active.coefficient"
     " urgency.scheduled.coefficient"
@@ -217,50 +252,60 @@ int CmdShow::execute (std::string& output)
     " xterm.title"
     " ";
 
-  // This configuration variable is supported, but not documented.  It exists
-  // so that unit tests can force color to be on even when the output from task
-  // is redirected to a file, or stdout is not a tty.
-  recognized += "_forcecolor ";
+  static std::unordered_set <std::string> recognized;
+  if (recognized.empty ())
+  {
+    for (auto& name : split (names, ' '))
+      if (name != "")
+        recognized.insert (name);
+
+    // This configuration variable is supported, but not documented.  It exists
+    // so that unit tests can force color to be on even when the output from
+    // task is redirected to a file, or stdout is not a tty.
+    recognized.insert ("_forcecolor");
+  }
+
+  // These are special configuration variables, because their name is dynamic.
+  static const std::vector <std::string> prefixes =
+  {
+    "color.keyword.",
+    "color.project.",
+    "color.tag.",
+    "color.uda.",
+    "context.",
+    "holiday.",
+    "report.",
+    "alias.",
+    "hook.",
+    "uda.",
+    "default.",
+    "urgency.user.project.",
+    "urgency.user.tag.",
+    "urgency.user.keyword.",
+    "urgency.uda.",
+  };
 
   std::vector <std::string> unrecognized;
+  std::unordered_set <std::string> unrecognized_set;
   for (auto& i : Context::getContext ().config)
   {
-    // Disallow partial matches by tacking a leading and trailing space on each
-    // variable name.
-    std::string pattern = ' ' + i.first + ' ';
-    if (recognized.find (pattern) == std::string::npos)
+    if (recognized.find (i.first) == recognized.end () &&
+        std::none_of (prefixes.begin (), prefixes.end (), [&i] (const std::string& prefix)
+                      { return i.first.compare (0, prefix.length (), prefix) == 0; }))
     {
-      // These are special configuration variables, because their name is
-      // dynamic.
-      if (i.first.substr (0, 14) != "color.keyword."        &&
-          i.first.substr (0, 14) != "color.project."        &&
-          i.first.substr (0, 10) != "color.tag."            &&
-          i.first.substr (0, 10) != "color.uda."            &&
-          i.first.substr (0,  8) != "context."              &&
-          i.first.substr (0,  8) != "holiday."              &&
-          i.first.substr (0,  7) != "report."               &&
-          i.first.substr (0,  6) != "alias."                &&
-          i.first.substr (0,  5) != "hook."                 &&
-          i.first.substr (0,  4) != "uda."                  &&
-          i.first.substr (0,  8) != "default."              &&
-          i.first.substr (0, 21) != "urgency.user.project." &&
-          i.first.substr (0, 17) != "urgency.user.tag."     &&
-          i.first.substr (0, 21) != "urgency.user.keyword." &&
-          i.first.substr (0, 12) != "urgency.uda.")
-      {
-        unrecognized.push_back (i.first);
-      }
+      unrecognized.push_back (i.first);
+      unrecognized_set.insert (i.first);
     }
   }
 
   // Find all the values that match the defaults, for highlighting.
-  std::vector <std::string> default_values;
+  std::unordered_set <std::string> default_values;
   Configuration default_config;
   default_config.parse (configurationDefaults);
 
   for (auto& i : Context::getContext ().config)
     if (i.second != default_config.get (i.first))
-      default_values.push_back (i.first);
+      default_values.insert (i.first);
 
   // Create output view.
   Table view;
@@ -297,12 +342,12 @@ int CmdShow::execute (std::string& output)
     {
       // Look for unrecognized.
       Color color;
-      if (std::find (unrecognized.begin (), unrecognized.end (), i.first) != unrecognized.end ())
+      if (unrecognized_set.find (i.first) != unrecognized_set.end ())
       {
         issue_error = true;
         color = error;
       }
-      else if (std::find (default_values.begin (), default_values.end (), i.first) != default_values.end ())
+      else if (default_values.find (i.first) != default_values.end ())
       {
         issue_warning = true;
         color = warning;
@@ -28,7 +28,7 @@
 #include <CmdStats.h>
 #include <sstream>
 #include <iomanip>
-#include <stdlib.h>
+#include <unordered_set>
 #include <Table.h>
 #include <Datetime.h>
 #include <Duration.h>
@@ -68,28 +68,12 @@ int CmdStats::execute (std::string& output)
                   + Context::getContext ().tdb2.undo._file.size ()
                   + Context::getContext ().tdb2.backlog._file.size ();
 
-  // Count the undo transactions.
-  std::vector <std::string> undoTxns = Context::getContext ().tdb2.undo.get_lines ();
-  int undoCount = 0;
-  for (auto& tx : undoTxns)
-    if (tx == "---")
-      ++undoCount;
-
-  // Count the backlog transactions.
-  std::vector <std::string> backlogTxns = Context::getContext ().tdb2.backlog.get_lines ();
-  int backlogCount = 0;
-  for (auto& tx : backlogTxns)
-    if (tx[0] == '{')
-      ++backlogCount;
-
-  // Get all the tasks.
-  Filter filter;
-  std::vector <Task> all = Context::getContext ().tdb2.all_tasks ();
-  std::vector <Task> filtered;
-  filter.subset (all, filtered);
+  // Count the undo and backlog transactions.
+  int undoCount    = Context::getContext ().tdb2.undo.count_lines ("---");
+  int backlogCount = Context::getContext ().tdb2.backlog_count ();
 
-  Datetime now;
-  time_t earliest   = time (nullptr);
+  time_t now        = time (nullptr);
+  time_t earliest   = now;
   time_t latest     = 1;
   int totalT        = 0;
   int deletedT      = 0;
@@ -103,10 +87,11 @@ int CmdStats::execute (std::string& output)
   int blockedT      = 0;
   float daysPending = 0.0;
   int descLength    = 0;
-  std::map <std::string, int> allTags;
-  std::map <std::string, int> allProjects;
+  std::unordered_set <std::string> allTags;
+  std::unordered_set <std::string> allProjects;
 
-  for (auto& task : filtered)
+  // All the statistics are gathered in one pass over the tasks.
+  auto scan = [&] (const Task& task)
   {
     ++totalT;
 
@@ -123,32 +108,50 @@ int CmdStats::execute (std::string& output)
     if (task.is_blocked)  ++blockedT;
     if (task.is_blocking) ++blockingT;
 
-    time_t entry = strtol (task.get ("entry").c_str (), nullptr, 10);
+    time_t entry = task.get_date ("entry");
     if (entry < earliest) earliest = entry;
     if (entry > latest)   latest   = entry;
 
     if (status == Task::completed)
-    {
-      time_t end = strtol (task.get ("end").c_str (), nullptr, 10);
-      daysPending += (end - entry) / 86400.0;
-    }
+      daysPending += (task.get_date ("end") - entry) / 86400.0;
 
-    if (status == Task::pending)
-      daysPending += (now.toEpoch () - entry) / 86400.0;
+    else if (status == Task::pending)
+      daysPending += (now - entry) / 86400.0;
 
     descLength += task.get ("description").length ();
-    annotationsT += task.getAnnotations ().size ();
+    annotationsT += task.getAnnotationCount ();
 
-    auto tags = task.getTags ();
-    if (tags.size ())
-      ++taggedT;
+    if (task.has ("tags"))
+    {
+      auto tags = task.getTags ();
+      if (tags.size ())
+        ++taggedT;
 
-    for (auto& tag : tags)
-      allTags[tag] = 0;
+      for (auto& tag : tags)
+        allTags.insert (tag);
+    }
 
-    std::string project = task.get ("project");
+    auto project = task.get ("project");
     if (project != "")
-      allProjects[project] = 0;
+      allProjects.insert (project);
+  };
+
+  // Unfiltered, the tasks are scanned where they are, without a copy.
+  Filter filter;
+  if (filter.hasFilter ())
+  {
+    std::vector <Task> filtered;
+    filter.subset (filtered);
+    for (auto& task : filtered)
+      scan (task);
+  }
+  else
+  {
+    for (auto& task : Context::getContext ().tdb2.pending.get_tasks ())
+      scan (task);
+
+    for (auto& task : Context::getContext ().tdb2.completed.get_tasks ())
+      scan (task);
   }
 
   // Create a table for output.
@@ -225,7 +228,7 @@ int CmdStats::execute (std::string& output)
     view.set (row, 1, value.str ());
   }
 
-  if (filtered.size ())
+  if (totalT)
   {
     Datetime e (earliest);
     row = view.addRow ();
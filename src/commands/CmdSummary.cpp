@@ -31,12 +31,12 @@
 #include <stdlib.h>
 #include <Context.h>
 #include <Filter.h>
+#include <ProjectTree.h>
 #include <Table.h>
 #include <Duration.h>
 #include <format.h>
 #include <util.h>
 #include <main.h>
-#include <list>
 
 ////////////////////////////////////////////////////////////////////////////////
 CmdSummary::CmdSummary ()
@@ -70,65 +70,40 @@ int CmdSummary::execute (std::string& output)
   std::vector <Task> filtered;
   filter.subset (filtered);
 
-  // Generate unique list of project names from all pending tasks.
-  std::map <std::string, bool> allProjects;
-  for (auto& task : filtered)
-    if (showAllProjects || task.getStatus () == Task::pending)
-      allProjects[task.get ("project")] = false;
-
-  // Initialize counts, sum.
-  std::map <std::string, int> countPending;
-  std::map <std::string, int> countCompleted;
-  std::map <std::string, double> sumEntry;
-  std::map <std::string, int> counter;
+  // Count the tasks in each project, and its parents.  Only projects with
+  // pending tasks are shown, unless all are requested.
+  ProjectTree projects;
   time_t now = time (nullptr);
-
-  // Initialize counters.
-  for (auto& project : allProjects)
-  {
-    countPending   [project.first] = 0;
-    countCompleted [project.first] = 0;
-    sumEntry       [project.first] = 0.0;
-    counter        [project.first] = 0;
-  }
-
-  // Count the various tasks.
   for (auto& task : filtered)
   {
-    std::string project = task.get ("project");
-    std::vector <std::string> projects = extractParents (project);
-    projects.push_back (project);
-
-    for (auto& parent : projects)
-      ++counter[parent];
+    auto status = task.getStatus ();
+    auto& node = projects.add (task.get ("project"),
+                               showAllProjects || status == Task::pending);
+    ++node.tasks;
 
-    if (task.getStatus () == Task::pending ||
-        task.getStatus () == Task::waiting)
+    if (status == Task::pending ||
+        status == Task::waiting)
     {
-      for (auto& parent : projects)
-      {
-        ++countPending[parent];
-
-        time_t entry = strtol (task.get ("entry").c_str (), nullptr, 10);
-        if (entry)
-          sumEntry[parent] = sumEntry[parent] + (double) (now - entry);
-      }
+      ++node.pending;
+
+      time_t entry = task.get_date ("entry");
+      if (entry)
+        node.age += (double) (now - entry);
     }
 
-    else if (task.getStatus () == Task::completed)
+    else if (status == Task::completed)
     {
-      for (auto& parent : projects)
-      {
-        ++countCompleted[parent];
-
-        time_t entry = strtol (task.get ("entry").c_str (), nullptr, 10);
-        time_t end   = strtol (task.get ("end").c_str (), nullptr, 10);
-        if (entry && end)
-          sumEntry[parent] = sumEntry[parent] + (double) (end - entry);
-      }
+      ++node.completed;
+
+      time_t entry = task.get_date ("entry");
+      time_t end   = task.get_date ("end");
+      if (entry && end)
+        node.age += (double) (end - entry);
     }
   }
 
+  projects.total ();
+
   // Create a table for output.
   Table view;
   view.width (Context::getContext ().getWidth ());
@@ -147,48 +122,42 @@ int CmdSummary::execute (std::string& output)
     bg_color  = Color (Context::getContext ().config.get ("color.summary.background"));
   }
 
-  // sort projects into sorted list
-  std::list<std::pair<std::string, int>> sortedProjects;
-  sort_projects (sortedProjects, allProjects);
-
   int barWidth = 30;
-  // construct view from sorted list
-  for (auto& i : sortedProjects)
+  projects.visit ([&] (const ProjectTree::Node& node)
   {
-      int row = view.addRow ();
-      view.set (row, 0, (i.first == ""
-                          ? "(none)"
-                          : indentProject (i.first, "  ", '.')));
-
-      view.set (row, 1, countPending[i.first]);
-      if (counter[i.first])
-        view.set (row, 2, Duration ((int) (sumEntry[i.first] / (double)counter[i.first])).formatVague ());
-
-      int c = countCompleted[i.first];
-      int p = countPending[i.first];
-      int completedBar = 0;
-      if (c + p)
-        completedBar = (c * barWidth) / (c + p);
-
-      std::string bar;
-      std::string subbar;
-      if (Context::getContext ().color ())
-      {
-        bar += bar_color.colorize (std::string (           completedBar, ' '));
-        bar += bg_color.colorize  (std::string (barWidth - completedBar, ' '));
-      }
-      else
-      {
-        bar += std::string (           completedBar, '=')
-            +  std::string (barWidth - completedBar, ' ');
-      }
-      view.set (row, 4, bar);
-
-      char percent[12] = "0%";
-      if (c + p)
-        snprintf (percent, 12, "%d%%", 100 * c / (c + p));
-      view.set (row, 3, percent);
-  }
+    int row = view.addRow ();
+    view.set (row, 0, (node.name == ""
+                        ? "(none)"
+                        : indentProject (node.name, "  ", '.')));
+
+    view.set (row, 1, node.pending);
+    if (node.tasks)
+      view.set (row, 2, Duration ((int) (node.age / (double) node.tasks)).formatVague ());
+
+    int c = node.completed;
+    int p = node.pending;
+    int completedBar = 0;
+    if (c + p)
+      completedBar = (c * barWidth) / (c + p);
+
+    std::string bar;
+    if (Context::getContext ().color ())
+    {
+      bar += bar_color.colorize (std::string (           completedBar, ' '));
+      bar += bg_color.colorize  (std::string (barWidth - completedBar, ' '));
+    }
+    else
+    {
+      bar += std::string (           completedBar, '=')
+          +  std::string (barWidth - completedBar, ' ');
+    }
+    view.set (row, 4, bar);
+
+    char percent[12] = "0%";
+    if (c + p)
+      snprintf (percent, 12, "%d%%", 100 * c / (c + p));
+    view.set (row, 3, percent);
+  });
 
   std::stringstream out;
   if (view.rows ())
@@ -27,6 +27,10 @@
 #include <cmake.h>
 #include <CmdSync.h>
 #include <sstream>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <unordered_map>
 #include <inttypes.h>
 #include <signal.h>
 #include <Context.h>
@@ -35,6 +39,47 @@
 #include <shared.h>
 #include <format.h>
 #include <util.h>
+#include <FS.h>
+
+#ifdef HAVE_LIBGNUTLS
+////////////////////////////////////////////////////////////////////////////////
+// The tasks of a sync payload, each parsed once, with one version of each
+// uuid.  Of several versions, the one last modified is kept, or of those
+// modified at once, the last sent, in the place of the first.  Any other line
+// is the sync key.
+static std::vector <Task> merge (
+  const std::vector <std::string>& lines,
+  std::string& sync_key)
+{
+  std::vector <Task> tasks;
+  std::unordered_map <std::string, size_t> positions;
+  for (auto& line : lines)
+  {
+    if (line[0] == '{')
+    {
+      Task task (line);
+      auto uuid = task.get ("uuid");
+      auto known = positions.find (uuid);
+      if (known == positions.end ())
+      {
+        positions[uuid] = tasks.size ();
+        tasks.push_back (std::move (task));
+      }
+      else if (task.get_date ("modified") >= tasks[known->second].get_date ("modified"))
+        tasks[known->second] = std::move (task);
+    }
+    else if (line != "")
+    {
+      sync_key = line;
+      Context::getContext ().debug ("Sync key " + sync_key);
+    }
+
+    // Otherwise line is blank, so ignore it.
+  }
+
+  return tasks;
+}
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 CmdSync::CmdSync ()
@@ -132,10 +177,10 @@ int CmdSync::execute (std::string& output)
     // deltas is meaningless.
     Context::getContext ().tdb2.backlog._file.truncate ();
 
-    auto all_tasks = Context::getContext ().tdb2.all_tasks ();
-    for (auto& i : all_tasks)
+    for (auto& i : Context::getContext ().tdb2.all_tasks ())
     {
-      payload += i.composeJSON () + '\n';
+      i.composeJSON (payload);
+      payload += '\n';
       ++upload_count;
     }
   }
@@ -193,58 +238,44 @@ int CmdSync::execute (std::string& output)
         colorChanged = Color (Context::getContext ().config.get ("color.sync.changed"));
       }
 
-      int download_count = 0;
       payload = response.getPayload ();
       auto lines = split (payload, '\n');
-
-      // Load all tasks, but only if necessary.  There is always a sync key in
-      // the payload, so if there are two or more lines, then we have merging
-      // to perform, otherwise it's just a backlog.data update.
-      if (lines.size () > 1)
-        Context::getContext ().tdb2.all_tasks ();
-
+      int download_count = std::count_if (lines.begin (), lines.end (),
+                                          [] (const std::string& line) { return line[0] == '{'; });
+
+      // Several versions of a task, as after a long time offline, are merged
+      // first, so that each task is applied once.  Only the tasks named in the
+      // payload are looked up, through the index where there is one, so
+      // completed.data need not be loaded in full.  All the changes are
+      // committed together, as one undo group.
       std::string sync_key = "";
-      for (auto& line : lines)
+      for (auto& from_server : merge (lines, sync_key))
       {
-        if (line[0] == '{')
+        std::string uuid = from_server.get ("uuid");
+
+        // Is it a new task from the server, or an update to an existing one?
+        if (Context::getContext ().tdb2.has (uuid))
         {
-          ++download_count;
-
-          Task from_server (line);
-          std::string uuid = from_server.get ("uuid");
-
-          // Is it a new task from the server, or an update to an existing one?
-          Task dummy;
-          if (Context::getContext ().tdb2.get (uuid, dummy))
-          {
-            if (Context::getContext ().verbose ("sync"))
-              out << "  "
-                  << colorChanged.colorize (
-                       format ("modify {1} '{2}'",
-                               uuid,
-                               from_server.get ("description")))
-                  << '\n';
-            Context::getContext ().tdb2.modify (from_server, false);
-          }
-          else
-          {
-            if (Context::getContext ().verbose ("sync"))
-              out << "  "
-                  << colorAdded.colorize (
-                       format ("   add {1} '{2}'",
-                               uuid,
-                               from_server.get ("description")))
-                  << '\n';
-            Context::getContext ().tdb2.add (from_server, false);
-          }
+          if (Context::getContext ().verbose ("sync"))
+            out << "  "
+                << colorChanged.colorize (
+                     format ("modify {1} '{2}'",
+                             uuid,
+                             from_server.get ("description")))
+                << '\n';
+          Context::getContext ().tdb2.modify (from_server, false);
         }
-        else if (line != "")
+        else
         {
-          sync_key = line;
-          Context::getContext ().debug ("Sync key " + sync_key);
+          if (Context::getContext ().verbose ("sync"))
+            out << "  "
+                << colorAdded.colorize (
+                     format ("   add {1} '{2}'",
+                             uuid,
+                             from_server.get ("description")))
+                << '\n';
+          Context::getContext ().tdb2.add (from_server, false);
         }
-
-        // Otherwise line is blank, so ignore it.
       }
 
       // Only update everything if there is a new sync_key.  No sync_key means
@@ -368,11 +399,40 @@ bool CmdSync::send (
     client.trust (trust);
     client.ciphers (Context::getContext ().config.get ("taskd.ciphers"));
     client.init (ca, certificate, key);
+
+    // With taskd.resume, the session of the last sync with this server is
+    // offered, to avoid a full handshake.  The file holds the server, then the
+    // session data.
+    bool resume = Context::getContext ().config.getBoolean ("taskd.resume");
+    std::string session_file = (std::string) Context::getContext ().data_dir + "/tls.session";
+    if (resume)
+    {
+      std::ifstream in (session_file, std::ios::binary);
+      std::string saved ((std::istreambuf_iterator <char> (in)), std::istreambuf_iterator <char> ());
+      if (! saved.compare (0, to.length () + 1, to + '\n'))
+        client.session (saved.substr (to.length () + 1));
+    }
+
     client.connect (server, port);
+    if (resume)
+      Context::getContext ().debug (client.resumed () ? "Sync resumed the TLS session" : "Sync performed a full TLS handshake");
+
     client.send (request.serialize () + '\n');
 
     std::string incoming;
     client.recv (incoming);
+
+    // The session data is secret, so only the user may read it.
+    if (resume)
+    {
+      auto data = client.session ();
+      if (data != "" && File::create (session_file, 0600))
+      {
+        std::ofstream out (session_file, std::ios::binary | std::ios::trunc);
+        out << to << '\n' << data;
+      }
+    }
+
     client.bye ();
 
     response.parse (incoming);
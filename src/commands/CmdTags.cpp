@@ -57,30 +57,56 @@ int CmdTags::execute (std::string& output)
   int rc = 0;
   std::stringstream out;
 
-  // Get all the tasks.
-  auto tasks = Context::getContext ().tdb2.pending.get_tasks ();
+  bool all = Context::getContext ().config.getBoolean ("list.all.tags");
+  int quantity = 0;
+  std::map <std::string, int> unique;
+
+  // Unfiltered, and with GC keeping only pending tasks in pending.data, the
+  // counts are kept by commit, and every task has a project, even if "".
+  Filter filter;
+  if (! filter.hasFilter () &&
+      Context::getContext ().config.getBoolean ("gc"))
+  {
+    auto tasks = [all] (const ProjectCount& count)
+    {
+      return count.pending + count.templates + (all ? count.done + count.deleted : 0);
+    };
+
+    std::map <std::string, ProjectCount> counts;
+    Context::getContext ().tdb2.counts ("projects", counts);
+    for (auto& count : counts)
+      quantity += tasks (count.second);
+
+    Context::getContext ().tdb2.counts ("tags", counts);
+    for (auto& count : counts)
+      if (tasks (count.second) > 0)
+        unique[count.first] = tasks (count.second);
+  }
+  else
+  {
+    // Get all the tasks.
+    auto tasks = Context::getContext ().tdb2.pending.get_tasks ();
 
-  if (Context::getContext ().config.getBoolean ("list.all.tags"))
-    for (auto& task : Context::getContext ().tdb2.completed.get_tasks ())
-      tasks.push_back (task);
+    if (all)
+      for (auto& task : Context::getContext ().tdb2.completed.get_tasks ())
+        tasks.push_back (task);
 
-  int quantity = tasks.size ();
+    quantity = tasks.size ();
 
-  // Apply filter.
-  Filter filter;
-  std::vector <Task> filtered;
-  filter.subset (tasks, filtered);
+    // Apply filter.
+    std::vector <Task> filtered;
+    filter.subset (tasks, filtered);
 
-  // Scan all the tasks for their project name, building a map using project
-  // names as keys.
-  std::map <std::string, int> unique;
-  for (auto& task : filtered)
-  {
-    for (auto& tag : task.getTags ())
-      if (unique.find (tag) != unique.end ())
-        unique[tag]++;
-      else
-        unique[tag] = 1;
+    // Scan all the tasks for their tags, building a map using tag names as
+    // keys.
+    for (auto& task : filtered)
+    {
+      for (auto& tag : task.getTags ())
+        if (unique.find (tag) != unique.end ())
+          unique[tag]++;
+        else
+          unique[tag] = 1;
+    }
   }
 
   if (unique.size ())
@@ -156,24 +182,25 @@ CmdCompletionTags::CmdCompletionTags ()
 ////////////////////////////////////////////////////////////////////////////////
 int CmdCompletionTags::execute (std::string& output)
 {
-  // Get all the tasks.
-  auto tasks = Context::getContext ().tdb2.pending.get_tasks ();
-
-  if (Context::getContext ().config.getBoolean ("complete.all.tags"))
-    for (auto& task : Context::getContext ().tdb2.completed.get_tasks ())
-      tasks.push_back (task);
-
-  // Apply filter.
-  Filter filter;
-  std::vector <Task> filtered;
-  filter.subset (filtered);
-
   // Scan all the tasks for their tags, building a map using tag
-  // names as keys.
+  // names as keys.  Unfiltered, the tags are known without reading the tasks.
   std::map <std::string, int> unique;
-  for (auto& task : filtered)
-    for (auto& tag : task.getTags ())
+  Filter filter;
+  Completions candidates;
+  if (! filter.hasFilter () &&
+      Context::getContext ().tdb2.completions (candidates))
+  {
+    for (auto& tag : candidates.tags)
       unique[tag] = 0;
+  }
+  else
+  {
+    filter.visit ([&unique] (const Task& task)
+    {
+      for (auto& tag : task.getTags ())
+        unique[tag] = 0;
+    });
+  }
 
   // Add built-in tags to map.
   unique["nocolor"]   = 0;
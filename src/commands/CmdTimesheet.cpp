@@ -62,7 +62,7 @@ int CmdTimesheet::execute (std::string& output)
   bool hasFilter {false};
   for (auto& a : Context::getContext ().cli2._args)
   {
-    if (a.hasTag ("FILTER"))
+    if (a.hasTag (A2::Tag::FILTER))
     {
       hasFilter = true;
       break;
@@ -77,39 +77,42 @@ int CmdTimesheet::execute (std::string& output)
     Context::getContext ().cli2.addFilter (defaultFilter);
   }
 
-  // Apply filter to get a set of tasks.
+  // Apply filter to get a set of tasks.  The default filter is bounded by end
+  // date for completed tasks, so the index skips the older completed segments.
   handleUntil ();
   handleRecurrence ();
   Filter filter;
   std::vector <Task> filtered;
   filter.subset (filtered);
 
-  // Subset the tasks to only those that are either completed or started.
-  // The _key attribute is represents either the 'start' or 'end' date.
+  // Key the tasks on either their 'end' date, if completed, or their 'start'
+  // date, if started, once, so that they are ordered in one sort of the keys,
+  // and then rendered in one sweep through the weeks.
   int num_completed = 0;
   int num_started = 0;
-  std::vector <Task> shown;
+  std::vector <std::pair <time_t, Task*>> shown;
+  shown.reserve (filtered.size ());
   for (auto& task : filtered)
   {
+    time_t key = 0;
     if (task.getStatus () == Task::completed)
     {
-      task.set ("_key", task.get ("end"));
+      key = task.get_date ("end");
       ++num_completed;
     }
 
     if (task.getStatus () == Task::pending && task.has ("start"))
     {
-      task.set ("_key", task.get ("start"));
+      key = task.get_date ("start");
       ++num_started;
     }
 
-    shown.push_back (task);
+    shown.emplace_back (key, &task);
   }
 
-  // Sort tasks by _key.
-  std::sort (shown.begin (),
-             shown.end (),
-             [](const Task& a, const Task& b) { return a.get ("_key") < b.get ("_key"); });
+  std::stable_sort (shown.begin (),
+                    shown.end (),
+                    [](const std::pair <time_t, Task*>& a, const std::pair <time_t, Task*>& b) { return a.first < b.first; });
 
   // Render the completed table.
   Table table;
@@ -133,9 +136,10 @@ int CmdTimesheet::execute (std::string& output)
   std::string previous_day = "";
   int weekCounter = 0;
   Color week_color;
-  for (auto& task : shown)
+  for (auto& keyed : shown)
   {
-    Datetime key (task.get_date ("_key"));
+    auto& task = *keyed.second;
+    Datetime key (keyed.first);
 
     std::string label = task.has ("end")   ? "Completed"
                       : task.has ("start") ? "Started"
@@ -27,18 +27,24 @@
 #include <cmake.h>
 #include <CmdUrgency.h>
 #include <sstream>
+#include <functional>
+#include <algorithm>
 #include <stdlib.h>
 #include <Context.h>
 #include <Filter.h>
 #include <Lexer.h>
+#include <Table.h>
+#include <Timer.h>
+#include <Trace.h>
 #include <main.h>
 #include <format.h>
+#include <util.h>
 
 ////////////////////////////////////////////////////////////////////////////////
 CmdUrgency::CmdUrgency ()
 {
   _keyword               = "_urgency";
-  _usage                 = "task <filter> _urgency";
+  _usage                 = "task <filter> _urgency [explain]";
   _description           = "Displays the urgency measure of a task";
   _read_only             = true;
   _displays_id           = false;
@@ -46,10 +52,116 @@ CmdUrgency::CmdUrgency ()
   _uses_context          = false;
   _accepts_filter        = true;
   _accepts_modifications = false;
-  _accepts_miscellaneous = false;
+  _accepts_miscellaneous = true;
   _category              = Command::Category::internal;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// One row of the explanation: the tasks a term applies to, the time taken to
+// prepare and evaluate it for every task, and its contributions to those tasks.
+static void explainTerm (
+  Table& view,
+  const std::string& name,
+  std::vector <Task>& tasks,
+  std::function <float (const Task&)> term,
+  std::function <void ()> prepare = nullptr)
+{
+  Trace::Span span ("urgency.term", name);
+  Timer timer;
+  if (prepare)
+    prepare ();
+
+  int count = 0;
+  float minimum = 0.0;
+  float maximum = 0.0;
+  double sum = 0.0;
+  for (auto& task : tasks)
+  {
+    float value = term (task);
+    if (value != 0.0)
+    {
+      minimum = count ? std::min (minimum, value) : value;
+      maximum = count ? std::max (maximum, value) : value;
+      sum += value;
+      ++count;
+    }
+  }
+
+  auto elapsed = timer.total_us ();
+
+  int row = view.addRow ();
+  view.set (row, 0, name);
+  view.set (row, 1, count);
+  view.set (row, 2, format ("{1}", (long) elapsed));
+  if (count)
+  {
+    view.set (row, 3, Lexer::trim (format (minimum,                 6, 3)));
+    view.set (row, 4, Lexer::trim (format ((float) (sum / count),   6, 3)));
+    view.set (row, 5, Lexer::trim (format (maximum,                 6, 3)));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The cost and effect of each urgency term over the tasks, followed by that of
+// the whole computation as every report performs it.  Terms with a coefficient
+// of zero are not evaluated, so are not shown.
+std::string CmdUrgency::explain (std::vector <Task>& tasks)
+{
+  Table view;
+  view.width (Context::getContext ().getWidth ());
+  view.add ("Term");
+  view.add ("Tasks", false);
+  view.add ("Time (us)", false);
+  view.add ("Minimum", false);
+  view.add ("Mean", false);
+  view.add ("Maximum", false);
+  setHeaderUnderline (view);
+
+  auto core = [&] (const std::string& name, float coefficient, float (Task::*term) () const)
+  {
+    if (coefficient != 0.0)
+      explainTerm (view, name, tasks, [=] (const Task& task) { return (task.*term) () * coefficient; });
+  };
+
+  core ("project",     Task::urgencyProjectCoefficient,     &Task::urgency_project);
+  core ("active",      Task::urgencyActiveCoefficient,      &Task::urgency_active);
+  core ("scheduled",   Task::urgencyScheduledCoefficient,   &Task::urgency_scheduled);
+  core ("waiting",     Task::urgencyWaitingCoefficient,     &Task::urgency_waiting);
+  core ("blocked",     Task::urgencyBlockedCoefficient,     &Task::urgency_blocked);
+  core ("blocking",    Task::urgencyBlockingCoefficient,    &Task::urgency_blocking);
+  core ("annotations", Task::urgencyAnnotationsCoefficient, &Task::urgency_annotations);
+  core ("tags",        Task::urgencyTagsCoefficient,        &Task::urgency_tags);
+  core ("due",         Task::urgencyDueCoefficient,         &Task::urgency_due);
+  core ("age",         Task::urgencyAgeCoefficient,         &Task::urgency_age);
+
+  for (auto& rule : Task::userCoefficients)
+  {
+    std::string name;
+    switch (rule.kind)
+    {
+    case Task::Coefficient::project:     name = "project " + rule.name;                  break;
+    case Task::Coefficient::tag:
+    case Task::Coefficient::virtual_tag: name = "tag " + rule.name;                      break;
+    case Task::Coefficient::keyword:     name = "keyword " + rule.name;                  break;
+    case Task::Coefficient::uda:         name = "uda " + rule.name;                      break;
+    case Task::Coefficient::uda_value:   name = "uda " + rule.name + '.' + rule.value;  break;
+    }
+
+    explainTerm (view, name, tasks, [&rule] (const Task& task) { return task.urgency_coefficient (rule); });
+  }
+
+  // The whole computation, including any inheritance, as reports do it.
+  explainTerm (view, "urgency", tasks,
+               [] (const Task& task) { return task.urgency_value; },
+               [&tasks] () { Context::getContext ().tdb2.urgency (tasks); });
+
+  std::stringstream out;
+  out << optionalBlankLine ()
+      << view.render ()
+      << optionalBlankLine ();
+  return out.str ();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 int CmdUrgency::execute (std::string& output)
 {
@@ -64,7 +176,15 @@ int CmdUrgency::execute (std::string& output)
     return 1;
   }
 
-  // Display urgency for the selected tasks.
+  auto words = Context::getContext ().cli2.getWords ();
+  if (words.size () && words[0] == "explain")
+  {
+    output = explain (filtered);
+    return 0;
+  }
+
+  // Display urgency for the selected tasks, computed in one pass.
+  Context::getContext ().tdb2.urgency (filtered);
   std::stringstream out;
   for (auto& task : filtered)
   {
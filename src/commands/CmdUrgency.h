@@ -28,13 +28,18 @@
 #define INCLUDED_CMDURGENCY
 
 #include <string>
+#include <vector>
 #include <Command.h>
+#include <Task.h>
 
 class CmdUrgency : public Command
 {
 public:
   CmdUrgency ();
   int execute (std::string&);
+
+private:
+  std::string explain (std::vector <Task>&);
 };
 
 #endif
@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cmake.h>
+#include <CmdWatch.h>
+#include <iostream>
+#include <vector>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <Allocations.h>
+#include <Context.h>
+#include <format.h>
+
+////////////////////////////////////////////////////////////////////////////////
+CmdWatch::CmdWatch ()
+{
+  _keyword               = "watch";
+  _usage                 = "task          watch <report> [<filter>]";
+  _description           = "Shows a report again whenever the tasks change";
+  _read_only             = true;
+  _displays_id           = false;
+  _needs_gc              = false;
+  _uses_context          = false;
+  _accepts_filter        = false;
+  _accepts_modifications = false;
+  _accepts_miscellaneous = true;
+  _category              = Command::Category::report;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The size, time and inode of a file, which change when it is written, or
+// replaced.
+static std::string stamp (const std::string& file)
+{
+  struct stat s;
+  if (stat (file.c_str (), &s) == -1)
+    return "";
+
+  return format ("{1} {2} {3}", (long long) s.st_size, (long long) s.st_mtime, (long long) s.st_ino);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// 'task watch <report>' shows the report, then shows it again each time the
+// data files change, until interrupted.  The files are checked once a second.
+// The report is run in a Context of its own, with the overrides of the command
+// line, which is kept, as by the shell, until the rc file changes.
+int CmdWatch::execute (std::string&)
+{
+  auto& context = Context::getContext ();
+
+  std::vector <std::string> args {context.cli2.getBinary ()};
+  for (auto& a : context.cli2._args)
+    if (a.hasTag (A2::Tag::RC) || a.hasTag (A2::Tag::CONFIG))
+      args.push_back (a.attribute ("raw"));
+
+  auto words = context.cli2.getWords ();
+  if (words.empty ())
+    throw std::string ("The watch command needs a report, as in 'task watch next'.");
+
+  args.insert (args.end (), words.begin (), words.end ());
+
+  std::vector <const char*> argv;
+  for (auto& arg : args)
+    argv.push_back (arg.c_str ());
+
+  // What each redraw allocates is freed, rather than held in the arena until
+  // the watch is interrupted.
+  Allocations::disableArena ();
+
+  bool terminal = isatty (STDOUT_FILENO);
+  auto rc_file = context.rc_file._data;
+  auto data    = context.data_dir._data;
+  auto files = [&] () { return stamp (data + "/pending.data") + stamp (data + "/completed.data") + stamp (rc_file); };
+
+  Context* report {nullptr};
+  std::string configured;
+  int status {0};
+  try
+  {
+    while (true)
+    {
+      if (terminal)
+        std::cout << "\033[H\033[2J" << std::flush;
+
+      // A changed rc file is read again, by a new Context.
+      if (! report || stamp (rc_file) != configured)
+      {
+        delete report;
+        report = new Context;
+        configured = stamp (rc_file);
+      }
+
+      Context::setContext (report);
+      status = report->initialize ((int) argv.size (), argv.data ());
+      if (status != 0)
+        break;
+
+      auto command = report->cli2.getCommand ();
+      auto found = report->commands.find (command);
+      if (found == report->commands.end () || ! found->second->read_only ())
+        throw format ("The '{1}' command changes tasks, so cannot be watched.", command);
+
+      if (command == _keyword)
+        throw std::string ("The watch command cannot watch itself.");
+
+      report->run ();
+      std::cout << std::flush;
+      Context::setContext (&context);
+
+      auto seen = files ();
+      while (files () == seen)
+        sleep (1);
+    }
+  }
+
+  catch (...)
+  {
+    Context::setContext (&context);
+    delete report;
+    throw;
+  }
+
+  Context::setContext (&context);
+  delete report;
+  return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -42,6 +42,7 @@
 #include <CmdBurndown.h>
 #include <CmdCalc.h>
 #include <CmdCalendar.h>
+#include <CmdCheck.h>
 #include <CmdColor.h>
 #include <CmdColumns.h>
 #include <CmdCommands.h>
@@ -71,6 +72,7 @@
 #include <CmdPrepend.h>
 #include <CmdProjects.h>
 #include <CmdPurge.h>
+#include <CmdQuery.h>
 #include <CmdReports.h>
 #include <CmdShow.h>
 #include <CmdStart.h>
@@ -85,6 +87,7 @@
 #include <CmdUnique.h>
 #include <CmdUrgency.h>
 #include <CmdVersion.h>
+#include <CmdWatch.h>
 
 #include <Context.h>
 #include <ColProject.h>
@@ -103,6 +106,7 @@ void Command::factory (std::map <std::string, Command*>& all)
   c = new CmdBurndownWeekly ();     all[c->keyword ()] = c;
   c = new CmdCalc ();               all[c->keyword ()] = c;
   c = new CmdCalendar ();           all[c->keyword ()] = c;
+  c = new CmdCheck ();              all[c->keyword ()] = c;
   c = new CmdColor ();              all[c->keyword ()] = c;
   c = new CmdColumns ();            all[c->keyword ()] = c;
   c = new CmdCommands ();           all[c->keyword ()] = c;
@@ -149,6 +153,7 @@ void Command::factory (std::map <std::string, Command*>& all)
   c = new CmdPrepend ();            all[c->keyword ()] = c;
   c = new CmdProjects ();           all[c->keyword ()] = c;
   c = new CmdPurge ();              all[c->keyword ()] = c;
+  c = new CmdQuery ();              all[c->keyword ()] = c;
   c = new CmdReports ();            all[c->keyword ()] = c;
   c = new CmdShow ();               all[c->keyword ()] = c;
   c = new CmdShowRaw ();            all[c->keyword ()] = c;
@@ -165,22 +170,21 @@ void Command::factory (std::map <std::string, Command*>& all)
   c = new CmdUrgency ();            all[c->keyword ()] = c;
   c = new CmdUUIDs ();              all[c->keyword ()] = c;
   c = new CmdVersion ();            all[c->keyword ()] = c;
+  c = new CmdWatch ();              all[c->keyword ()] = c;
   c = new CmdZshAttributes ();      all[c->keyword ()] = c;
   c = new CmdZshCommands ();        all[c->keyword ()] = c;
   c = new CmdZshCompletionIds ();   all[c->keyword ()] = c;
   c = new CmdZshCompletionUuids (); all[c->keyword ()] = c;
 
-  // Instantiate a command object for each custom report.
+  // Instantiate a command object for each custom report.  Only the names are
+  // found here; the rest of a report's settings are read when it runs.
   std::vector <std::string> reports;
-  for (auto &i : Context::getContext ().config)
+  auto range = settings (Context::getContext ().config, "report.");
+  for (auto i = range.first; i != range.second; ++i)
   {
-    if (i.first.substr (0, 7) == "report.")
-    {
-      std::string report = i.first.substr (7);
-      auto columns = report.find (".columns");
-      if (columns != std::string::npos)
-        reports.push_back (report.substr (0, columns));
-    }
+    auto columns = i->first.find (".columns", 7);
+    if (columns != std::string::npos)
+      reports.push_back (i->first.substr (7, columns - 7));
   }
 
   for (auto &report : reports)
@@ -332,8 +336,7 @@ bool Command::permission (
 
   // What remains are write commands that have not yet selected 'all' or 'quit'.
   // Describe the task.
-  bool         confirmation = Context::getContext ().config.getBoolean ("confirmation");
-  unsigned int bulk         = Context::getContext ().config.getInteger ("bulk");
+  bool confirmation = Context::getContext ().config.getBoolean ("confirmation");
 
   // Quantity 1 modifications have optional confirmation, and only (y/n).
   if (quantity == 1)
@@ -346,9 +349,7 @@ bool Command::permission (
     return answer;
   }
 
-  // 1 < Quantity < bulk modifications have optional confirmation, in the (y/n/a/q)
-  // style. Bulk = 0 denotes infinite bulk.
-  if ((bulk == 0 || quantity < bulk) && (!_needs_confirm || !confirmation))
+  if (! bulk_prompt (quantity))
     return true;
 
   if (Context::getContext ().verbose ("blank") && !_first_iteration)
@@ -366,3 +367,43 @@ bool Command::permission (
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+// Where the tasks are to be confirmed in the (y/n/a/q) style, lists them all
+// under the heading first, so that 'all' may be answered having seen them, or
+// each reviewed in turn.  The changes are planned before this, so that each
+// question follows the last without waiting on the changes before it.
+void Command::summarize (
+  const std::string& heading,
+  const std::vector <Task>& tasks,
+  unsigned int quantity)
+{
+  if (_read_only        ||
+      _permission_all   ||
+      _permission_quit  ||
+      quantity <= 1     ||
+      tasks.size () < 2 ||
+      ! bulk_prompt (quantity))
+    return;
+
+  std::cout << heading << '\n';
+  for (auto& task : tasks)
+    std::cout << "  "
+              << format ("{1} '{2}'", task.identifier (true), task.get ("description"))
+              << '\n';
+
+  if (Context::getContext ().verbose ("blank"))
+    std::cout << '\n';
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Whether more than one task is to be confirmed in the (y/n/a/q) style.
+// 1 < Quantity < bulk modifications have optional confirmation, and Bulk = 0
+// denotes infinite bulk.
+bool Command::bulk_prompt (unsigned int quantity) const
+{
+  bool         confirmation = Context::getContext ().config.getBoolean ("confirmation");
+  unsigned int bulk         = Context::getContext ().config.getInteger ("bulk");
+
+  return (bulk != 0 && quantity >= bulk) || (_needs_confirm && confirmation);
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -72,6 +72,7 @@ public:
 
 protected:
   bool permission (const std::string&, unsigned int);
+  void summarize (const std::string&, const std::vector <Task>&, unsigned int);
   static const std::map <Command::Category, std::string> categoryNames;
 
 protected:
@@ -88,6 +89,11 @@ protected:
   bool        _accepts_miscellaneous;
   Category    _category;
 
+private:
+  bool bulk_prompt (unsigned int) const;
+
+protected:
+
   // Permission support
   bool        _permission_quit;
   bool        _permission_all;
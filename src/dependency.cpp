@@ -30,6 +30,7 @@
 #include <sstream>
 #include <stack>
 #include <Context.h>
+#include <Uuid.h>
 #include <format.h>
 #include <shared.h>
 #include <main.h>
@@ -39,33 +40,13 @@
 ////////////////////////////////////////////////////////////////////////////////
 std::vector <Task> dependencyGetBlocked (const Task& task)
 {
-  auto uuid = task.get ("uuid");
-
-  std::vector <Task> blocked;
-  for (auto& it : Context::getContext ().tdb2.pending.get_tasks ())
-    if (it.getStatus () != Task::completed &&
-        it.getStatus () != Task::deleted   &&
-        it.has ("depends")                 &&
-        it.get ("depends").find (uuid) != std::string::npos)
-      blocked.push_back (it);
-
-  return blocked;
+  return Context::getContext ().tdb2.blocked (task);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 std::vector <Task> dependencyGetBlocking (const Task& task)
 {
-  auto depends = task.get ("depends");
-
-  std::vector <Task> blocking;
-  if (depends != "")
-    for (auto& it : Context::getContext ().tdb2.pending.get_tasks ())
-      if (it.getStatus () != Task::completed &&
-          it.getStatus () != Task::deleted   &&
-          depends.find (it.get ("uuid")) != std::string::npos)
-        blocking.push_back (it);
-
-  return blocking;
+  return Context::getContext ().tdb2.blocking (task);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -74,45 +55,39 @@ bool dependencyIsCircular (const Task& task)
 {
   // A new task has no UUID assigned yet, and therefore cannot be part of any
   // dependency chain.
-  if (task.has ("uuid"))
+  Uuid task_uuid;
+  if (task.has ("uuid") &&
+      Uuid::parse (task.get ("uuid"), task_uuid))
   {
-    auto task_uuid = task.get ("uuid");
+    // The supplied task may not be committed yet, so its own dependencies are
+    // used rather than those in the graph.
+    std::vector <Uuid> deps;
+    Uuid::parse_list (task.get ("depends"), deps);
 
-    std::stack <Task> s;
-    s.push (task);
+    std::stack <Uuid> s;
+    for (auto& dep : deps)
+      s.push (dep);
 
-    std::unordered_set <std::string> visited;
+    std::unordered_set <Uuid> visited;
     visited.insert (task_uuid);
 
+    // This is a basic depth first search that always terminates given the
+    // fact that we do not visit any task twice
     while (! s.empty ())
     {
-      Task& current = s.top ();
-      auto deps_current = current.getDependencyUUIDs ();
+      auto current = s.top ();
+      s.pop ();
 
-      // This is a basic depth first search that always terminates given the
-      // fact that we do not visit any task twice
-      for (unsigned int i = 0; i < deps_current.size (); i++)
+      if (current == task_uuid)
       {
-        if (Context::getContext ().tdb2.get (deps_current[i], current))
-        {
-          auto current_uuid = current.get ("uuid");
-
-          if (task_uuid == current_uuid)
-          {
-            // Cycle found, initial task reached for the second time!
-            return true;
-          }
-
-          if (visited.find (current_uuid) == visited.end ())
-          {
-            // Push the task to the stack, if it has not been processed yet
-            s.push (current);
-            visited.insert (current_uuid);
-          }
-        }
+        // Cycle found, initial task reached for the second time!
+        return true;
       }
 
-      s.pop ();
+      if (visited.insert (current).second &&
+          Context::getContext ().tdb2.depends (current, deps))
+        for (auto& dep : deps)
+          s.push (dep);
     }
   }
 
@@ -40,7 +40,6 @@
 #include <shared.h>
 #include <format.h>
 
-static void countTasks (const std::vector <Task>&, const std::string&, int&, int&);
 
 ////////////////////////////////////////////////////////////////////////////////
 // Converts a vector of tasks to a human-readable string that represents the tasks.
@@ -405,12 +404,7 @@ void feedback_backlog ()
   if (Context::getContext ().config.get ("taskd.server") != "" &&
       Context::getContext ().verbose ("sync"))
   {
-    int count = 0;
-    std::vector <std::string> lines = Context::getContext ().tdb2.backlog.get_lines ();
-    for (auto& line : lines)
-      if ((line)[0] == '{')
-        ++count;
-
+    int count = Context::getContext ().tdb2.backlog_count ();
     if (count)
       Context::getContext ().footnote (format (count > 1 ?  "There are {1} local changes.  Sync required."
                                                          : "There is {1} local change.  Sync required.", count));
@@ -432,8 +426,7 @@ std::string onProjectChange (Task& task, bool scope /* = true */)
     // Count pending and done tasks, for this project.
     int count_pending = 0;
     int count_done = 0;
-    std::vector <Task> all = Context::getContext ().tdb2.all_tasks ();
-    countTasks (all, project, count_pending, count_done);
+    Context::getContext ().tdb2.project_counts (project, count_pending, count_done);
 
     // count_done  count_pending  percentage
     // ----------  -------------  ----------
@@ -489,35 +482,4 @@ std::string onExpiration (Task& task)
   return msg.str ();
 }
 
-///////////////////////////////////////////////////////////////////////////////
-static void countTasks (
-  const std::vector <Task>& all,
-  const std::string& project,
-  int& count_pending,
-  int& count_done)
-{
-  for (auto& it : all)
-  {
-    if (it.get ("project") == project)
-    {
-      switch (it.getStatus ())
-      {
-      case Task::pending:
-      case Task::waiting:
-        ++count_pending;
-        break;
-
-      case Task::completed:
-        ++count_done;
-        break;
-
-      case Task::deleted:
-      case Task::recurring:
-      default:
-        break;
-      }
-    }
-  }
-}
-
-////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
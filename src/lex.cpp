@@ -1,18 +1,103 @@
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <Lexer.h>
 #include <Context.h>
 
 Context context;
 
+////////////////////////////////////////////////////////////////////////////////
+// Lexes each argument the given number of times, and reports the throughput
+// in tokens and bytes.
+static void bench (const std::vector <std::string>& arguments, int runs)
+{
+  size_t total_tokens = 0;
+  size_t total_bytes = 0;
+  double total = 0.0;
+
+  printf ("%12s %12s %8s  %s\n", "tokens/s", "MB/s", "tokens", "argument");
+  for (auto& argument : arguments)
+  {
+    size_t tokens = 0;
+    std::string token;
+    Lexer::Type type;
+    auto start = std::chrono::steady_clock::now ();
+    for (int run = 0; run < runs; ++run)
+    {
+      Lexer l (argument);
+      while (l.token (token, type))
+        ++tokens;
+    }
+
+    double elapsed = std::chrono::duration <double> (std::chrono::steady_clock::now () - start).count ();
+    printf ("%12.0f %12.2f %8zu  %s\n",
+            tokens / elapsed,
+            argument.length () * runs / elapsed / 1e6,
+            tokens / runs,
+            argument.c_str ());
+
+    total_tokens += tokens;
+    total_bytes += argument.length () * runs;
+    total += elapsed;
+  }
+
+  if (total > 0.0)
+    printf ("%12.0f %12.2f %8zu  (%zu arguments, %d runs each)\n",
+            total_tokens / total,
+            total_bytes / total / 1e6,
+            total_tokens / runs,
+            arguments.size (),
+            runs);
+}
+
+////////////////////////////////////////////////////////////////////////////////
 int main (int argc, char** argv)
 {
+  // With --bench N, the arguments, and any read with --file, are lexed N
+  // times, rather than shown.
+  int runs = 0;
+  std::vector <std::string> arguments;
   for (auto i = 1; i < argc; i++)
   {
-    std::cout << "argument '" << argv[i] << "'\n";
+    if ((! strcmp (argv[i], "-b") || ! strcmp (argv[i], "--bench")) && i + 1 < argc)
+      runs = strtol (argv[++i], nullptr, 10);
+    else if ((! strcmp (argv[i], "-f") || ! strcmp (argv[i], "--file")) && i + 1 < argc)
+    {
+      std::ifstream in (argv[++i]);
+      if (! in)
+      {
+        std::cerr << "Could not read '" << argv[i] << "'.\n";
+        return 1;
+      }
+
+      // Blank lines and comments are skipped.
+      std::string line;
+      while (std::getline (in, line))
+        if (line != "" && line[0] != '#')
+          arguments.push_back (line);
+    }
+    else
+      arguments.push_back (argv[i]);
+  }
+
+  if (runs > 0)
+  {
+    bench (arguments, runs);
+    return 0;
+  }
+
+  for (auto& argument : arguments)
+  {
+    std::cout << "argument '" << argument << "'\n";
 
-    Lexer l (argv[i]);
+    Lexer l (argument);
     std::string token;
     Lexer::Type type;
     while (l.token (token, type))
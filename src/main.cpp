@@ -26,17 +26,289 @@
 
 #include <cmake.h>
 #include <iostream>
+#include <string>
+#include <vector>
 #include <new>
+#include <memory>
 #include <cstring>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <Allocations.h>
 #include <Context.h>
+#include <JSON.h>
+#include <format.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Splits a line typed at the shell into arguments, as sh would, at whitespace
+// not quoted, removing the quotes and backslashes.
+static std::vector <std::string> words (const std::string& line)
+{
+  std::vector <std::string> args;
+  std::string word;
+  bool found = false;
+  char quote = 0;
+
+  for (size_t i = 0; i < line.length (); ++i)
+  {
+    char c = line[i];
+    if (quote)
+    {
+      if (c == quote)
+        quote = 0;
+      else if (c == '\\' && quote == '"' && i + 1 < line.length ())
+        word += line[++i];
+      else
+        word += c;
+    }
+    else if (c == '\'' || c == '"')
+    {
+      quote = c;
+      found = true;
+    }
+    else if (c == '\\' && i + 1 < line.length ())
+    {
+      word += line[++i];
+      found = true;
+    }
+    else if (c == ' ' || c == '\t')
+    {
+      if (found)
+        args.push_back (word);
+      word = "";
+      found = false;
+    }
+    else
+    {
+      word += c;
+      found = true;
+    }
+  }
+
+  if (quote)
+    throw std::string ("Unterminated quote.");
+
+  if (found)
+    args.push_back (word);
+
+  return args;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The size, time and inode of a file, which change when it is written, or
+// replaced.
+static std::string stamp (const std::string& file)
+{
+  struct stat s;
+  if (stat (file.c_str (), &s) == -1)
+    return "";
+
+  return format ("{1} {2} {3}", (long long) s.st_size, (long long) s.st_mtime, (long long) s.st_ino);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Whether the command line overrides the configuration.
+static bool overrides (const std::vector <std::string>& args)
+{
+  for (auto& arg : args)
+    if (! arg.compare (0, 3, "rc.") || ! arg.compare (0, 3, "rc:"))
+      return true;
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Runs a command line, in the given Context if it is reused, otherwise in a new
+// one.
+static int command (
+  Context*& context,
+  const std::vector <std::string>& args,
+  bool reuse)
+{
+  int status {0};
+
+  std::vector <const char*> argv;
+  for (auto& arg : args)
+    argv.push_back (arg.c_str ());
+
+  if (! context || ! reuse)
+  {
+    delete context;
+    context = new Context;
+    Context::setContext (context);
+  }
+
+  try
+  {
+    status = context->initialize ((int) argv.size (), argv.data ());
+    if (status == 0)
+      status = context->run ();
+  }
+
+  catch (const std::string& error)
+  {
+    std::cerr << error << "\n";
+    status = -1;
+  }
+
+  catch (std::bad_alloc& error)
+  {
+    std::cerr << "Error: Memory allocation failed: " << error.what () << "\n";
+    status = -3;
+  }
+
+  catch (...)
+  {
+    std::cerr << "Unknown error. Please report.\n";
+    status = -2;
+  }
+
+  return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// A line read by 'tw' that holds a JSON object is a query, such as
+//   {"filter":"+work","attributes":["id","description"],"sort":"urgency-","limit":10}
+// which is run as the arguments of the _query command.
+static std::vector <std::string> query (const std::string& line)
+{
+  std::unique_ptr <json::value> root;
+  try
+  {
+    root.reset (json::parse (line));
+  }
+
+  catch (const std::string& error)
+  {
+    throw format ("The query is not valid JSON: {1}", error);
+  }
+
+  if (! root || root->type () != json::j_object)
+    throw std::string ("The query must be a JSON object.");
+
+  std::vector <std::string> filter;
+  std::vector <std::string> options;
+  for (auto& i : ((json::object*) root.get ())->_data)
+  {
+    auto type = i.second->type ();
+    if (i.first == "filter" && type == json::j_string)
+      filter = words (json::decode (((json::string*) i.second)->_data));
+
+    else if (i.first == "sort" && type == json::j_string)
+      options.push_back ("sort:" + json::decode (((json::string*) i.second)->_data));
+
+    else if (i.first == "limit" && type == json::j_number)
+      filter.push_back (format ("limit:{1}", (int) *(json::number*) i.second));
+
+    else if (i.first == "attributes" && type == json::j_array)
+    {
+      for (auto& attribute : ((json::array*) i.second)->_data)
+      {
+        if (attribute->type () != json::j_string)
+          throw std::string ("The query attributes must be strings.");
+
+        options.push_back (json::decode (((json::string*) attribute)->_data));
+      }
+    }
+
+    else
+      throw format ("The query member '{1}' is not recognized.", i.first);
+  }
+
+  filter.push_back ("_query");
+  filter.insert (filter.end (), options.begin (), options.end ());
+  return filter;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Run as 'tw' without arguments, the commands typed at the prompt, or read
+// from stdin, are run one after another by the same process, which reads and
+// compiles the configuration once.  It is read again only when the rc file
+// changes, or after a command that overrides it.
+//
+// The response to a query is ended by an empty line, so that an integration
+// can keep one 'tw' process, and send it one query after another.
+static int shell (const char* program)
+{
+  // What each command allocates is freed, rather than held in the arena until
+  // the shell exits.
+  Allocations::disableArena ();
+
+  int status {0};
+  Context* context {nullptr};
+  std::string configured;
+  bool reuse {false};
+  bool interactive = isatty (STDIN_FILENO);
+
+  std::string line;
+  while (true)
+  {
+    if (interactive)
+      std::cout << "tw> " << std::flush;
+
+    if (! std::getline (std::cin, line))
+      break;
+
+    bool request = line.length () && line[0] == '{';
+
+    std::vector <std::string> args;
+    try
+    {
+      args = request ? query (line) : words (line);
+    }
+
+    catch (const std::string& error)
+    {
+      std::cerr << error << "\n";
+      if (request)
+        std::cout << '\n' << std::flush;
+      status = -1;
+      continue;
+    }
+
+    if (args.empty ())
+      continue;
+
+    if (args.size () == 1 && (args[0] == "quit" || args[0] == "exit"))
+      break;
+
+    args.insert (args.begin (), program);
+    bool overridden = overrides (args);
+
+    // The same setup serves the next command, unless the configuration is not
+    // that of the rc file alone.
+    status = command (context, args, reuse && ! overridden && stamp (context->rc_file._data) == configured);
+    if (request)
+      std::cout << '\n' << std::flush;
+
+    // After a failure that escaped the command, or with overrides, the next
+    // command starts afresh.
+    reuse = status >= 0 && ! overridden;
+    configured = stamp (context->rc_file._data);
+  }
+
+  if (interactive)
+    std::cout << '\n';
+
+  delete context;
+  return status;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 int main (int argc, const char** argv)
 {
   int status {0};
 
-  Context globalContext;
-  Context::setContext (&globalContext);
+  auto program = strrchr (argv[0], '/');
+  if (argc == 1 && ! strcmp (program ? program + 1 : argv[0], "tw"))
+    return shell (argv[0]);
+
+  // With arena allocation, the Context, with all the tasks and strings it
+  // holds, is not destroyed on a successful exit, as deleting from the arena
+  // frees nothing, and the memory is released with the process.  After a
+  // failure, or in debug mode, it is, to stop any hook scripts still running,
+  // and report any unwritten changes.
+  auto globalContext = new Context;
+  Context::setContext (globalContext);
 
   // Lightweight version checking that doesn't require initialization or any I/O.
   if (argc == 2 && !strcmp (argv[1], "--version"))
@@ -71,6 +343,11 @@ int main (int argc, const char** argv)
     }
   }
 
+#ifdef HAVE_ARENA
+  if (status != 0 || globalContext->config.getBoolean ("debug"))
+#endif
+    delete globalContext;
+
   return status;
 }
 
@@ -40,11 +40,11 @@
 // recur.cpp
 void handleRecurrence ();
 Datetime getNextRecurrence (Datetime&, std::string&);
-bool generateDueDates (Task&, std::vector <Datetime>&);
+bool generateDueDates (Task&, std::vector <Datetime>&, unsigned int first = 0);
+time_t nextRecurrenceEvent (const Task&);
 void updateRecurrenceMask (Task&);
 
 // recur2.cpp
-void handleRecurrence2 ();
 void handleUntil ();
 
 // nag.cpp
@@ -53,6 +53,8 @@ bool nag (Task&);
 // rules.cpp
 void initializeColorRules ();
 void autoColorize (Task&, Color&);
+void colorizeAppend (std::string&, const Color&, const std::string&);
+void colorizeAppend (std::string&, const Color&, const std::string&, int, bool);
 std::string colorizeHeader (const std::string&);
 std::string colorizeFootnote (const std::string&);
 std::string colorizeError (const std::string&);
@@ -81,9 +83,11 @@ std::string onProjectChange (Task&, Task&);
 std::string onExpiration (Task&);
 
 // sort.cpp
-void sort_tasks (std::vector <Task>&, std::vector <int>&, const std::string&);
-void sort_projects (std::list <std::pair <std::string, int>>& sorted, std::map <std::string, int>& allProjects);
-void sort_projects (std::list <std::pair <std::string, int>>& sorted, std::map <std::string, bool>& allProjects);
+void sort_tasks (std::vector <Task>&, std::vector <int>&, const std::string&, size_t limit = 0);
+
+// sync.cpp
+void syncInBackground ();
+void syncResults ();
 
 // legacy.cpp
 void legacyColumnMap (std::string&);
@@ -40,22 +40,13 @@ bool nag (Task& task)
   if (task.hasTag ("nonag"))
     return false;
 
+  // Nag if any pending, non-recurring task that is READY is more urgent.
   auto msg = Context::getContext ().config.get ("nag");
-  if (msg != "")
+  if (msg != "" &&
+      Context::getContext ().tdb2.ready_urgency () > task.urgency ())
   {
-    // Scan all pending, non-recurring tasks.
-    auto pending = Context::getContext ().tdb2.pending.get_tasks ();
-    for (auto& t : pending)
-    {
-      if ((t.getStatus () == Task::pending  ||
-           t.getStatus () == Task::waiting) &&
-          t.hasTag ("READY")                &&
-          t.urgency () > task.urgency ())
-      {
-        Context::getContext ().footnote (msg);
-        return true;
-      }
-    }
+    Context::getContext ().footnote (msg);
+    return true;
   }
 
   return false;
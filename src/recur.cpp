@@ -26,6 +26,8 @@
 
 #include <cmake.h>
 #include <iostream>
+#include <algorithm>
+#include <limits>
 #include <iomanip>
 #include <fstream>
 #include <sstream>
@@ -41,6 +43,7 @@
 #include <Lexer.h>
 #include <Datetime.h>
 #include <Duration.h>
+#include <Trace.h>
 #include <format.h>
 #include <unicode.h>
 #include <util.h>
@@ -51,100 +54,146 @@
 // child tasks need to be generated to fill gaps.
 void handleRecurrence ()
 {
-  // TODO This is inserted here to create parallel recurrence implementation
-  //      during feature development. This eliminates the need to inject this
-  //      call into 11 command implementations.
-  handleRecurrence2 ();
+  Trace::Span span ("recurrence");
 
   // Recurrence can be disabled.
   // Note: This is currently a workaround for TD-44, TW-1520.
   if (! Context::getContext ().config.getBoolean ("recurrence"))
     return;
 
-  auto tasks = Context::getContext ().tdb2.pending.get_tasks ();
+  // Nothing has been due since the last commit.
+  if (! Context::getContext ().tdb2.events_due ())
+    return;
+
+  auto tasks = Context::getContext ().tdb2.templates ();
   Datetime now;
 
-  // Look at all tasks and find any recurring ones.
+  // The new instances of all templates are added together, and only then are
+  // the masks of their parents updated.
+  std::vector <Task> instances;
+  std::vector <Task> parents;
+
+  // Look at all recurring tasks.
   for (auto& t : tasks)
   {
-    if (t.getStatus () == Task::recurring)
+    // Get the mask from the parent task.  Its length is the number of
+    // instances already generated.
+    auto mask = t.get ("mask");
+
+    // Generate a list of due dates for this recurring task, beyond the
+    // mask.
+    std::vector <Datetime> due;
+    if (! generateDueDates (t, due, mask.length ()))
     {
-      // Generate a list of due dates for this recurring task, regardless of
-      // the mask.
-      std::vector <Datetime> due;
-      if (! generateDueDates (t, due))
-      {
-        // Determine the end date.
-        t.setStatus (Task::deleted);
-        Context::getContext ().tdb2.modify (t);
-        Context::getContext ().footnote (onExpiration (t));
-        continue;
-      }
+      // Determine the end date.
+      t.setStatus (Task::deleted);
+      Context::getContext ().tdb2.modify (t);
+      Context::getContext ().footnote (onExpiration (t));
+      continue;
+    }
+
+    // Iterate over the due dates, each of which is a new instance.
+    auto changed = false;
+    unsigned int i = mask.length ();
+    for (auto& d : due)
+    {
+      changed = true;
 
-      // Get the mask from the parent task.
-      auto mask = t.get ("mask");
+      Task rec (t);                          // Clone the parent.
+      rec.setStatus (Task::pending);         // Change the status.
+      rec.id = Context::getContext ().tdb2.next_id ();      // New ID.
+      rec.set ("uuid", uuid ());             // New UUID.
+      rec.set ("parent", t.get ("uuid"));    // Remember mom.
+      rec.setAsNow ("entry");                // New entry date.
+      rec.set ("due", format (d.toEpoch ()));
 
-      // Iterate over the due dates, and check each against the mask.
-      auto changed = false;
-      unsigned int i = 0;
-      for (auto& d : due)
+      if (t.has ("wait"))
       {
-        if (mask.length () <= i)
-        {
-          changed = true;
-
-          Task rec (t);                          // Clone the parent.
-          rec.setStatus (Task::pending);         // Change the status.
-          rec.id = Context::getContext ().tdb2.next_id ();      // New ID.
-          rec.set ("uuid", uuid ());             // New UUID.
-          rec.set ("parent", t.get ("uuid"));    // Remember mom.
-          rec.setAsNow ("entry");                // New entry date.
-          rec.set ("due", format (d.toEpoch ()));
-
-          if (t.has ("wait"))
-          {
-            Datetime old_wait (t.get_date ("wait"));
-            Datetime old_due (t.get_date ("due"));
-            Datetime due (d);
-            rec.set ("wait", format ((due + (old_wait - old_due)).toEpoch ()));
-            rec.setStatus (Task::waiting);
-            mask += 'W';
-          }
-          else
-          {
-            mask += '-';
-            rec.setStatus (Task::pending);
-          }
-
-          rec.set ("imask", i);
-          rec.remove ("mask");                   // Remove the mask of the parent.
-
-          // Add the new task to the DB.
-          Context::getContext ().tdb2.add (rec);
-        }
-
-        ++i;
+        Datetime old_wait (t.get_date ("wait"));
+        Datetime old_due (t.get_date ("due"));
+        Datetime due (d);
+        rec.set ("wait", format ((due + (old_wait - old_due)).toEpoch ()));
+        rec.setStatus (Task::waiting);
+        mask += 'W';
       }
-
-      // Only modify the parent if necessary.
-      if (changed)
+      else
       {
-        t.set ("mask", mask);
-        Context::getContext ().tdb2.modify (t);
-
-        if (Context::getContext ().verbose ("recur"))
-          Context::getContext ().footnote (format ("Creating recurring task instance '{1}'", t.get ("description")));
+        mask += '-';
+        rec.setStatus (Task::pending);
       }
+
+      rec.set ("imask", i);
+      rec.remove ("mask");                   // Remove the mask of the parent.
+
+      instances.push_back (rec);
+
+      ++i;
+    }
+
+    // Only modify the parent if necessary.
+    if (changed)
+    {
+      t.set ("mask", mask);
+      parents.push_back (t);
     }
   }
+
+  // Add the new tasks to the DB.
+  Context::getContext ().tdb2.add (instances);
+
+  for (auto& t : parents)
+  {
+    Context::getContext ().tdb2.modify (t);
+
+    if (Context::getContext ().verbose ("recur"))
+      Context::getContext ().footnote (format ("Creating recurring task instance '{1}'", t.get ("description")));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Periods that are always the same number of seconds, so that the nth
+// recurrence can be calculated directly.  The calendar periods that
+// getNextRecurrence handles specially are not.
+static bool fixedRecurrence (const std::string& period, time_t& seconds)
+{
+  if (period == "monthly"    || period == "P1M" ||
+      period == "weekdays"   ||
+      period == "quarterly"  || period == "P3M" ||
+      period == "semiannual" || period == "P6M" ||
+      period == "bimonthly"  || period == "P2M" ||
+      period == "biannual"   || period == "biyearly" || period == "P2Y" ||
+      period == "annual"     || period == "yearly"   || period == "P1Y")
+    return false;
+
+  if (period == "")
+    return false;
+
+  if (unicodeLatinDigit (period[0]) &&
+      (period[period.length () - 1] == 'm' ||
+       period[period.length () - 1] == 'q'))
+    return false;
+
+  if (period[0] == 'P'                                            &&
+      Lexer::isAllDigits (period.substr (1, period.length () - 2)) &&
+      period[period.length () - 1] == 'M')
+    return false;
+
+  std::string::size_type idx = 0;
+  Duration p;
+  if (! p.parse (period, idx))
+    return false;
+
+  seconds = p.toTime_t ();
+  return seconds > 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // Determine a start date (due), an optional end date (until), and an increment
-// period (recur).  Then generate a set of corresponding dates.
+// period (recur).  Then generate a set of corresponding dates, omitting the
+// first ones, which are already generated.
 //
 // Returns false if the parent recurring task is depleted.
-bool generateDueDates (Task& parent, std::vector <Datetime>& allDue)
+bool generateDueDates (Task& parent, std::vector <Datetime>& allDue, unsigned int first /* = 0 */)
 {
   // Determine due date, recur period and until date.
   Datetime due (parent.get_date ("due"));
@@ -164,9 +213,38 @@ bool generateDueDates (Task& parent, std::vector <Datetime>& allDue)
   auto recurrence_limit = Context::getContext ().config.getInteger ("recurrence.limit");
   int recurrence_counter = 0;
   Datetime now;
-  for (Datetime i = due; ; i = getNextRecurrence (i, recur))
+
+  Datetime i = due;
+  unsigned int index = 0;
+
+  // For a fixed period, skip directly to the last generated instance, or the
+  // first one after until, whichever is earlier, counting the skipped
+  // instances that are after now.  Calendar periods are stepped through, as
+  // they have few instances.
+  time_t seconds;
+  if (first > 0 && fixedRecurrence (recur, seconds))
+  {
+    time_t start = due.toEpoch ();
+    time_t jump = first - 1;
+    if (specificEnd)
+    {
+      time_t end = until.toEpoch ();
+      jump = std::min (jump, end < start ? 0 : (end - start) / seconds + 1);
+    }
+
+    time_t past = now.toEpoch () < start ? 0 : (now.toEpoch () - start) / seconds + 1;
+    recurrence_counter = jump > past ? jump - past : 0;
+    if (recurrence_counter >= recurrence_limit)
+      return true;
+
+    i = Datetime (start + jump * seconds);
+    index = jump;
+  }
+
+  for (; ; i = getNextRecurrence (i, recur), ++index)
   {
-    allDue.push_back (i);
+    if (index >= first)
+      allDue.push_back (i);
 
     if (specificEnd && i > until)
     {
@@ -174,7 +252,7 @@ bool generateDueDates (Task& parent, std::vector <Datetime>& allDue)
       // parent mask contains all + or X, then there never will be another task
       // to generate, and this parent task may be safely reaped.
       auto mask = parent.get ("mask");
-      if (mask.length () == allDue.size () &&
+      if (mask.length () == index + 1 &&
           mask.find ('-') == std::string::npos)
         return false;
 
@@ -191,6 +269,49 @@ bool generateDueDates (Task& parent, std::vector <Datetime>& allDue)
   return true;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// The due date of the given instance, counting from zero.
+static Datetime instanceDueDate (const Datetime& due, std::string& recur, unsigned int index)
+{
+  time_t seconds;
+  if (fixedRecurrence (recur, seconds))
+    return Datetime (due.toEpoch () + index * seconds);
+
+  Datetime i = due;
+  for (unsigned int n = 0; n < index; ++n)
+    i = getNextRecurrence (i, recur);
+
+  return i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The earliest time at which handleRecurrence may need to change the given
+// template, or 0 if that may be now.  Changes to the template or its instances
+// are not foreseen.
+time_t nextRecurrenceEvent (const Task& parent)
+{
+  Datetime due (parent.get_date ("due"));
+  auto limit = Context::getContext ().config.getInteger ("recurrence.limit");
+  if (due._date == 0 || limit < 1)
+    return 0;
+
+  auto recur = parent.get ("recur");
+  auto mask = parent.get ("mask");
+  unsigned int generated = mask.length ();
+
+  // A series that has passed until generates nothing more, but may be reaped.
+  if (generated > 0 &&
+      parent.get ("until") != "" &&
+      instanceDueDate (due, recur, generated - 1) > Datetime (parent.get ("until")))
+    return mask.find ('-') == std::string::npos ? 0 : std::numeric_limits <time_t>::max ();
+
+  // Another instance is generated once fewer than 'limit' are in the future.
+  if (generated < (unsigned int) limit)
+    return 0;
+
+  return instanceDueDate (due, recur, generated - limit).toEpoch ();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 Datetime getNextRecurrence (Datetime& current, std::string& period)
 {
@@ -26,18 +26,139 @@
 
 #include <cmake.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <Context.h>
 #include <Datetime.h>
 #include <shared.h>
 #include <main.h>
+#include <AhoCorasick.h>
+#include <Trace.h>
+#include <util.h>
+
+// A color rule, with the part of its name that a wildcard rule matches.
+enum ruleType
+{
+  rule_blocked, rule_blocking, rule_tagged, rule_active, rule_scheduled,
+  rule_until, rule_project_none, rule_tag_none, rule_due, rule_due_today,
+  rule_overdue, rule_recurring, rule_completed, rule_deleted,
+  rule_tag, rule_project, rule_keyword, rule_uda, rule_uda_value
+};
+
+struct colorRule
+{
+  ruleType type;
+  Color color;
+  std::string name;
+  std::string value;
+  int keyword;        // Pattern number in gsKeywords
+};
+
+// The escape sequences that a color puts around the text it colorizes.
+struct colorEscapes
+{
+  std::string prefix;
+  std::string suffix;
+};
 
 static std::map <std::string, Color> gsColor;
 static std::vector <std::string> gsPrecedence;
+static std::vector <colorRule> gsRules;
+static AhoCorasick gsKeywords;
+static bool gsMerge {false};
+static bool gsLoaded {false};
 static Datetime now;
 
+////////////////////////////////////////////////////////////////////////////////
+// Compiles the rules in gsPrecedence, with nontrivial colors, into gsRules, in
+// the order they are applied, so that colorizing a task involves no lookup or
+// comparison of rule names.
+static void compileColorRules ()
+{
+  static const std::map <std::string, ruleType> rules =
+  {
+    {"color.blocked",      rule_blocked},
+    {"color.blocking",     rule_blocking},
+    {"color.tagged",       rule_tagged},
+    {"color.active",       rule_active},
+    {"color.scheduled",    rule_scheduled},
+    {"color.until",        rule_until},
+    {"color.project.none", rule_project_none},
+    {"color.tag.none",     rule_tag_none},
+    {"color.due",          rule_due},
+    {"color.due.today",    rule_due_today},
+    {"color.overdue",      rule_overdue},
+    {"color.recurring",    rule_recurring},
+    {"color.completed",    rule_completed},
+    {"color.deleted",      rule_deleted},
+  };
+
+  gsRules.clear ();
+  gsKeywords = AhoCorasick (Context::getContext ().config.getBoolean ("search.case.sensitive"));
+  int keywords = 0;
+
+  for (auto r = gsPrecedence.rbegin (); r != gsPrecedence.rend (); ++r)
+  {
+    colorRule rule {rule_tag, gsColor[*r], "", "", -1};
+    if (! rule.color.nontrivial ())
+      continue;
+
+    auto found = rules.find (*r);
+    if (found != rules.end ())
+      rule.type = found->second;
+
+    // Wildcards
+    else if (! r->compare (0, 10, "color.tag.", 10))
+    {
+      rule.type = rule_tag;
+      rule.name = r->substr (10);
+    }
+    else if (! r->compare (0, 14, "color.project.", 14))
+    {
+      rule.type = rule_project;
+      rule.name = r->substr (14);
+    }
+    else if (! r->compare (0, 14, "color.keyword.", 14))
+    {
+      rule.type = rule_keyword;
+      rule.name = r->substr (14);
+      rule.keyword = keywords++;
+      gsKeywords.add (rule.name);
+    }
+    else if (! r->compare (0, 10, "color.uda.", 10))
+    {
+      // Is the rule color.uda.name.value or color.uda.name?
+      auto pos = r->find ('.', 10);
+      if (pos == std::string::npos)
+      {
+        rule.type = rule_uda;
+        rule.name = r->substr (10);
+      }
+      else
+      {
+        rule.type = rule_uda_value;
+        rule.name = r->substr (10, pos - 10);
+        rule.value = r->substr (pos + 1);
+      }
+    }
+    else
+      continue;
+
+    gsRules.push_back (rule);
+  }
+
+  gsKeywords.compile ();
+
+  gsMerge = Context::getContext ().config.getBoolean ("rule.color.merge");
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void initializeColorRules ()
 {
+  gsLoaded = true;
+
   // If color is not enable/supported, short circuit.
   if (! Context::getContext ().color ())
     return;
@@ -50,15 +171,13 @@ void initializeColorRules ()
     // Load all the configuration values, filter to only the ones that begin with
     // "color.", then store name/value in gsColor, and name in rules.
     std::vector <std::string> rules;
-    for (const auto& v : Context::getContext ().config)
+    auto colors = settings (Context::getContext ().config, "color.");
+    for (auto v = colors.first; v != colors.second; ++v)
     {
-      if (! v.first.compare (0, 6, "color.", 6))
-      {
-        Color c (v.second);
-        gsColor[v.first] = c;
+      Color c (v->second);
+      gsColor[v->first] = c;
 
-        rules.push_back (v.first);
-      }
+      rules.push_back (v->first);
     }
 
     // Load the rule.precedence.color list, split it, then autocomplete against
@@ -75,6 +194,8 @@ void initializeColorRules ()
       for (auto& r : results)
         gsPrecedence.push_back (r);
     }
+
+    compileColorRules ();
   }
 
   catch (const std::string& e)
@@ -137,25 +258,21 @@ static void colorizeUntil (Task& task, const Color& base, Color& c, bool merge)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-static void colorizeTag (Task& task, const std::string& rule, const Color& base, Color& c, bool merge)
+static void colorizeTag (Task& task, const colorRule& rule, Color& c, bool merge)
 {
-  if (task.hasTag (rule.substr (10)))
-    applyColor (base, c, merge);
+  if (task.hasTag (rule.name))
+    applyColor (rule.color, c, merge);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-static void colorizeProject (Task& task, const std::string& rule, const Color& base, Color& c, bool merge)
+static void colorizeProject (Task& task, const colorRule& rule, Color& c, bool merge)
 {
-  // Observe the case sensitivity setting.
-  bool sensitive = Context::getContext ().config.getBoolean ("search.case.sensitive");
-
   auto project = task.get ("project");
-  auto rule_trunc = rule.substr (14);
 
-  // Match project names leftmost.
-  if (rule_trunc.length () <= project.length ())
-    if (compare (rule_trunc, project.substr (0, rule_trunc.length ()), sensitive))
-      applyColor (base, c, merge);
+  // Match project names leftmost, observing the case sensitivity setting.
+  if (rule.name.length () <= project.length ())
+    if (compare (rule.name, project.substr (0, rule.name.length ()), Task::searchCaseSensitive))
+      applyColor (rule.color, c, merge);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -173,49 +290,35 @@ static void colorizeTagNone (Task& task, const Color& base, Color& c, bool merge
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-static void colorizeKeyword (Task& task, const std::string& rule, const Color& base, Color& c, bool merge)
+// All the keyword rules are matched against the description and annotations in
+// one pass, the first time a keyword rule is applied to the task.
+static void colorizeKeyword (Task& task, const colorRule& rule, Color& c, bool merge, std::vector <char>& keywords)
 {
-  // Observe the case sensitivity setting.
-  auto sensitive = Context::getContext ().config.getBoolean ("search.case.sensitive");
-
-  // The easiest thing to check is the description, because it is just one
-  // attribute.
-  if (find (task.get ("description"), rule.substr (14), sensitive) != std::string::npos)
-    applyColor (base, c, merge);
-
-  // Failing the description check, look at all annotations, returning on the
-  // first match.
-  else
+  if (keywords.empty ())
   {
-    for (const auto& att : task.data)
-    {
-      if (! att.first.compare (0, 11, "annotation_", 11) &&
-          find (att.second, rule.substr (14), sensitive) != std::string::npos)
-      {
-        applyColor (base, c, merge);
-        return;
-      }
-    }
+    gsKeywords.match (task.get ("description"), keywords);
+
+    for (const auto& att : task.annotations ())
+      gsKeywords.match (att.second, keywords);
   }
+
+  if (keywords[rule.keyword])
+    applyColor (rule.color, c, merge);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-static void colorizeUDA (Task& task, const std::string& rule, const Color& base, Color& c, bool merge)
+static void colorizeUDA (Task& task, const colorRule& rule, Color& c, bool merge)
 {
-  // Is the rule color.uda.name.value or color.uda.name?
-  auto pos = rule.find ('.', 10);
-  if (pos == std::string::npos)
+  if (rule.type == rule_uda)
   {
-    if (task.has (rule.substr (10)))
-      applyColor (base, c, merge);
+    if (task.has (rule.name))
+      applyColor (rule.color, c, merge);
   }
   else
   {
-    auto uda = rule.substr (10, pos - 10);
-    auto val = rule.substr (pos + 1);
-    if ((val == "none" && ! task.has (uda)) ||
-        task.get (uda) == val)
-      applyColor (base, c, merge);
+    if ((rule.value == "none" && ! task.has (rule.name)) ||
+        task.get (rule.name) == rule.value)
+      applyColor (rule.color, c, merge);
   }
 }
 
@@ -283,6 +386,8 @@ static void colorizeDeleted (Task& task, const Color& base, Color& c, bool merge
 ////////////////////////////////////////////////////////////////////////////////
 void autoColorize (Task& task, Color& c)
 {
+  Trace::Span span ("color rules");
+
   // The special tag 'nocolor' overrides all auto and specific colorization.
   if (! Context::getContext ().color () ||
       task.hasTag ("nocolor"))
@@ -291,76 +396,154 @@ void autoColorize (Task& task, Color& c)
     return;
   }
 
-  auto merge = Context::getContext ().config.getBoolean ("rule.color.merge");
+  if (! gsLoaded)
+    initializeColorRules ();
+
+  auto merge = gsMerge;
+  std::vector <char> keywords;
 
   // Note: c already contains colors specifically assigned via command.
-  // Note: These rules form a hierarchy - the last rule is King, hence the
-  //       reverse iterator.
+  // Note: These rules form a hierarchy - the last rule is King, so gsRules
+  //       holds them in reverse.
 
-  for (auto r = gsPrecedence.rbegin (); r != gsPrecedence.rend (); ++r)
+  for (const auto& rule : gsRules)
   {
-    Color base = gsColor[*r];
-    if (base.nontrivial ())
+    const auto& base = rule.color;
+    switch (rule.type)
     {
-           if (*r == "color.blocked")                      colorizeBlocked      (task, base, c, merge);
-      else if (*r == "color.blocking")                     colorizeBlocking     (task, base, c, merge);
-      else if (*r == "color.tagged")                       colorizeTagged       (task, base, c, merge);
-      else if (*r == "color.active")                       colorizeActive       (task, base, c, merge);
-      else if (*r == "color.scheduled")                    colorizeScheduled    (task, base, c, merge);
-      else if (*r == "color.until")                        colorizeUntil        (task, base, c, merge);
-      else if (*r == "color.project.none")                 colorizeProjectNone  (task, base, c, merge);
-      else if (*r == "color.tag.none")                     colorizeTagNone      (task, base, c, merge);
-      else if (*r == "color.due")                          colorizeDue          (task, base, c, merge);
-      else if (*r == "color.due.today")                    colorizeDueToday     (task, base, c, merge);
-      else if (*r == "color.overdue")                      colorizeOverdue      (task, base, c, merge);
-      else if (*r == "color.recurring")                    colorizeRecurring    (task, base, c, merge);
-      else if (*r == "color.completed")                    colorizeCompleted    (task, base, c, merge);
-      else if (*r == "color.deleted")                      colorizeDeleted      (task, base, c, merge);
-
-      // Wildcards
-      else if (! r->compare (0, 10, "color.tag.", 10))     colorizeTag          (task, *r, base, c, merge);
-      else if (! r->compare (0, 14, "color.project.", 14)) colorizeProject      (task, *r, base, c, merge);
-      else if (! r->compare (0, 14, "color.keyword.", 14)) colorizeKeyword      (task, *r, base, c, merge);
-      else if (! r->compare (0, 10, "color.uda.", 10))     colorizeUDA          (task, *r, base, c, merge);
+    case rule_blocked:      colorizeBlocked      (task, base, c, merge); break;
+    case rule_blocking:     colorizeBlocking     (task, base, c, merge); break;
+    case rule_tagged:       colorizeTagged       (task, base, c, merge); break;
+    case rule_active:       colorizeActive       (task, base, c, merge); break;
+    case rule_scheduled:    colorizeScheduled    (task, base, c, merge); break;
+    case rule_until:        colorizeUntil        (task, base, c, merge); break;
+    case rule_project_none: colorizeProjectNone  (task, base, c, merge); break;
+    case rule_tag_none:     colorizeTagNone      (task, base, c, merge); break;
+    case rule_due:          colorizeDue          (task, base, c, merge); break;
+    case rule_due_today:    colorizeDueToday     (task, base, c, merge); break;
+    case rule_overdue:      colorizeOverdue      (task, base, c, merge); break;
+    case rule_recurring:    colorizeRecurring    (task, base, c, merge); break;
+    case rule_completed:    colorizeCompleted    (task, base, c, merge); break;
+    case rule_deleted:      colorizeDeleted      (task, base, c, merge); break;
+
+    // Wildcards
+    case rule_tag:          colorizeTag          (task, rule, c, merge); break;
+    case rule_project:      colorizeProject      (task, rule, c, merge); break;
+    case rule_keyword:      colorizeKeyword      (task, rule, c, merge, keywords); break;
+    case rule_uda:
+    case rule_uda_value:    colorizeUDA          (task, rule, c, merge); break;
     }
   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The escape sequences of a color depend only on its value, and a report uses
+// few distinct colors, so they are composed once per color.  They are interned
+// for all threads, and each thread remembers those it has looked up, so that
+// it takes the lock only for a color it has not seen.
+static const colorEscapes& escapes (const Color& color)
+{
+  static std::mutex mutex;
+  static std::unordered_map <int, std::unique_ptr <colorEscapes>> interned;
+  static thread_local std::unordered_map <int, const colorEscapes*> seen;
+
+  int key = color;
+  auto found = seen.find (key);
+  if (found != seen.end ())
+    return *found->second;
+
+  std::lock_guard <std::mutex> lock (mutex);
+  auto& entry = interned[key];
+  if (! entry)
+  {
+    auto marked = color.colorize ("\x01");
+    auto marker = marked.find ('\x01');
+    entry.reset (new colorEscapes {marked.substr (0, marker), marked.substr (marker + 1)});
+  }
 
+  seen[key] = entry.get ();
+  return *entry;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-std::string colorizeHeader (const std::string& input)
+// Appends the input in the color, as Color::_colorize does.
+void colorizeAppend (std::string& result, const Color& color, const std::string& input)
 {
-  if (gsColor["color.header"].nontrivial ())
-    return gsColor["color.header"].colorize (input);
+  if (! color.nontrivial ())
+  {
+    result += input;
+    return;
+  }
 
-  return input;
+  auto& e = escapes (color);
+  result.reserve (result.length () + e.prefix.length () + input.length () + e.suffix.length ());
+  result += e.prefix;
+  result += input;
+  result += e.suffix;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-std::string colorizeFootnote (const std::string& input)
+// Appends the input, padded on the left or right to the width, in the color.
+void colorizeAppend (std::string& result, const Color& color, const std::string& input, int padding, bool right)
 {
-  if (gsColor["color.footnote"].nontrivial ())
-    return gsColor["color.footnote"].colorize (input);
+  padding = std::max (padding, 0);
+  auto& e = escapes (color);
+  bool colored = color.nontrivial ();
+
+  result.reserve (result.length () + input.length () + padding + (colored ? e.prefix.length () + e.suffix.length () : 0));
+  if (colored)
+    result += e.prefix;
 
-  return input;
+  if (right)
+    result.append (padding, ' ');
+
+  result += input;
+
+  if (! right)
+    result.append (padding, ' ');
+
+  if (colored)
+    result += e.suffix;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-std::string colorizeError (const std::string& input)
+static std::string colorizeNamed (const std::string& name, const std::string& input)
 {
-  if (gsColor["color.error"].nontrivial ())
-    return gsColor["color.error"].colorize (input);
+  if (! gsLoaded)
+    initializeColorRules ();
+
+  auto found = gsColor.find (name);
+  if (found == gsColor.end () ||
+      ! found->second.nontrivial ())
+    return input;
 
-  return input;
+  std::string result;
+  colorizeAppend (result, found->second, input);
+  return result;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-std::string colorizeDebug (const std::string& input)
+std::string colorizeHeader (const std::string& input)
 {
-  if (gsColor["color.debug"].nontrivial ())
-    return gsColor["color.debug"].colorize (input);
+  return colorizeNamed ("color.header", input);
+}
 
-  return input;
+////////////////////////////////////////////////////////////////////////////////
+std::string colorizeFootnote (const std::string& input)
+{
+  return colorizeNamed ("color.footnote", input);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::string colorizeError (const std::string& input)
+{
+  return colorizeNamed ("color.error", input);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::string colorizeDebug (const std::string& input)
+{
+  return colorizeNamed ("color.debug", input);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
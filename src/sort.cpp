@@ -33,125 +33,158 @@
 #include <stdlib.h>
 #include <Context.h>
 #include <Duration.h>
+#include <Pool.h>
 #include <Task.h>
+#include <Trace.h>
 #include <shared.h>
 #include <util.h>
 #include <format.h>
 
-static std::vector <Task>* global_data = nullptr;
-static std::vector <std::string> global_keys;
-static bool sort_compare (int, int);
+// A sort key, decoded once from the sort specification.
+enum sort_kind
+{
+  sort_urgency,    // Task::urgency
+  sort_id,         // Task::id
+  sort_numeric,    // Numeric UDA
+  sort_string,     // String attribute
+  sort_uda_string, // String UDA, empty values last
+  sort_custom,     // String UDA with a custom sort order
+  sort_date,       // Date attribute or UDA, empty values last
+  sort_depends,    // First dependency
+  sort_duration,   // Duration attribute or UDA
+  sort_none        // UDA of a type that does not sort
+};
+
+// The value of one sort key for one task.  Strings are interned as ranks, so
+// that no comparison touches the task data.
+struct sort_value
+{
+  double number {0.0};
+  int    rank   {0};
+  bool   empty  {false};
+};
+
+// Compares the values of one key: negative if the left task sorts first,
+// positive if it does not, and zero if the next key decides.
+typedef int (*sort_key_compare) (const sort_value&, const sort_value&);
+
+struct sort_key
+{
+  sort_kind        kind;
+  std::string      field;
+  bool             ascending;
+  sort_key_compare compare;
+};
+
+// Compares two tasks, by index, using their extracted values.  It holds no
+// state of its own but the count of comparisons it adds to, so is cheap to
+// copy, and any number may be in use at once, each counting separately.
+class sort_compare
+{
+public:
+  sort_compare (const std::vector <sort_key>& keys, const std::vector <sort_value>& values, long& compared)
+  : _keys (keys)
+  , _values (values)
+  , _compared (&compared)
+  {
+  }
+
+  sort_compare (const sort_compare& other, long& compared)
+  : _keys (other._keys)
+  , _values (other._values)
+  , _compared (&compared)
+  {
+  }
+
+  bool operator() (int, int) const;
+  long& compared () const { return *_compared; }
+
+private:
+  const std::vector <sort_key>&   _keys;
+  const std::vector <sort_value>& _values;  // _keys.size () per task
+  long*                           _compared;
+};
+
+// Fewest tasks per thread, for which a parallel sort is worthwhile.
+#define SORT_PARALLEL_MINIMUM 10000
+
+static void decode_keys (const std::string&, std::vector <sort_key>&);
+static sort_key_compare select_compare (sort_kind, bool);
+static void extract_values (std::vector <Task>&, const std::vector <int>&, const std::vector <sort_key>&, std::vector <sort_value>&);
+static void parallel_sort (std::vector <int>&, const sort_compare&);
 
 ////////////////////////////////////////////////////////////////////////////////
+// Sorts the tasks in 'order', which are indexes into 'data'.  The keys of every
+// task are extracted once, up front, and the comparisons only use those.  With
+// a limit, only that many of the first tasks are sorted, and order is reduced
+// to just those.
 void sort_tasks (
   std::vector <Task>& data,
   std::vector <int>& order,
-  const std::string& keys)
+  const std::string& keys,
+  size_t limit /* = 0 */)
 {
+  Trace::Span span ("sort", keys);
   Timer timer;
-  global_data = &data;
-
-  // Split the key defs.
-  global_keys = split (keys, ',');
 
   // Only sort if necessary.
-  if (order.size ())
-    std::stable_sort (order.begin (), order.end (), sort_compare);
-
-  Context::getContext ().time_sort_us += timer.total_us ();
-}
-
-void sort_projects (
-    std::list <std::pair <std::string, int>>& sorted,
-    std::map <std::string, int>& allProjects)
-{
-  for (auto& project : allProjects)
+  if (order.size () > 1)
   {
-    const std::vector <std::string> parents = extractParents (project.first);
-    if (parents.size ())
+    std::vector <sort_key> decoded;
+    std::vector <sort_value> values;
+    decode_keys (keys, decoded);
+    extract_values (data, order, decoded, values);
+
+    // The comparisons are counted for perf.output.
+    long compared = 0;
+    sort_compare compare (decoded, values, compared);
+    if (limit && limit < order.size ())
     {
-      // if parents exist: store iterator position of last parent
-      std::list <std::pair <std::string, int>>::iterator parent_pos;
-      for (auto& parent : parents)
-      {
-        parent_pos = std::find_if (sorted.begin (), sorted.end (),
-            [&parent](const std::pair <std::string, int>& item) { return item.first == parent; });
-        
-        // if parent does not exist yet: insert into sorted view
-        if (parent_pos == sorted.end ())
-          sorted.push_back (std::make_pair (parent, 1));
-      }
-      
-      // insert new element below latest parent
-      sorted.insert ((parent_pos == sorted.end ()) ? parent_pos : ++parent_pos, project);
+      // Ties are broken by position, as a stable sort would leave them.
+      std::vector <size_t> position (data.size ());
+      for (size_t i = 0; i < order.size (); ++i)
+        position[order[i]] = i;
+
+      std::partial_sort (order.begin (), order.begin () + limit, order.end (),
+                         [&compare, &position] (int left, int right)
+                         {
+                           if (compare (left, right))
+                             return true;
+
+                           return ! compare (right, left) &&
+                                  position[left] < position[right];
+                         });
+      order.resize (limit);
     }
+    else if (order.size () >= 2 * SORT_PARALLEL_MINIMUM)
+      parallel_sort (order, compare);
     else
-    {
-      // if has no parents: simply push to end of list
-      sorted.push_back (project);
-    }
+      std::stable_sort (order.begin (), order.end (), compare);
+
+    Context::getContext ().count_compared += compared;
   }
-}
 
-void sort_projects (
-    std::list <std::pair <std::string, int>>& sorted,
-    std::map <std::string, bool>& allProjects)
-{
-  std::map <std::string, int> allProjectsInt;
-  for (auto& p : allProjects)
-    allProjectsInt[p.first] = (int) p.second;
-  
-  sort_projects (sorted, allProjectsInt);
+  Context::getContext ().time_sort_us += timer.total_us ();
 }
 
-
 ////////////////////////////////////////////////////////////////////////////////
-// Re-implementation, using direct Task access instead of data copies that
-// require re-parsing.
-//
-// Essentially a static implementation of a dynamic operator<.
-static bool sort_compare (int left, int right)
+// Split and decode the key defs.
+static void decode_keys (const std::string& keys, std::vector <sort_key>& decoded)
 {
-  std::string field;
-  bool ascending;
-  bool breakIndicator;
-  Column* column;
-  int left_number;
-  int right_number;
-  float left_real;
-  float right_real;
-
-  for (auto& k : global_keys)
+  decoded.clear ();
+  for (auto& k : split (keys, ','))
   {
-    Context::getContext ().decomposeSortField (k, field, ascending, breakIndicator);
+    sort_key key;
+    bool breakIndicator;
+    Context::getContext ().decomposeSortField (k, key.field, key.ascending, breakIndicator);
 
-    // Urgency.
+    auto& field = key.field;
     if (field == "urgency")
-    {
-      left_real  = (*global_data)[left].urgency ();
-      right_real = (*global_data)[right].urgency ();
-
-      if (left_real == right_real)
-        continue;
-
-      return ascending ? (left_real < right_real)
-                       : (left_real > right_real);
-    }
+      key.kind = sort_urgency;
 
-    // Number.
     else if (field == "id")
-    {
-      left_number  = (*global_data)[left].id;
-      right_number = (*global_data)[right].id;
-
-      if (left_number == right_number)
-        continue;
-
-      return ascending ? (left_number < right_number)
-                       : (left_number > right_number);
-    }
+      key.kind = sort_id;
 
-    // String.
     else if (field == "description" ||
              field == "project"     ||
              field == "status"      ||
@@ -160,18 +193,8 @@ static bool sort_compare (int left, int right)
              field == "parent"      ||
              field == "imask"       ||
              field == "mask")
-    {
-      auto left_string  = (*global_data)[left].get_ref  (field);
-      auto right_string = (*global_data)[right].get_ref (field);
-
-      if (left_string == right_string)
-        continue;
-
-      return ascending ? (left_string < right_string)
-                       : (left_string > right_string);
-    }
+      key.kind = sort_string;
 
-    // Due Date.
     else if (field == "due"      ||
              field == "end"      ||
              field == "entry"    ||
@@ -180,143 +203,350 @@ static bool sort_compare (int left, int right)
              field == "wait"     ||
              field == "modified" ||
              field == "scheduled")
-    {
-      auto left_string  = (*global_data)[left].get_ref  (field);
-      auto right_string = (*global_data)[right].get_ref (field);
-
-      if (left_string != "" && right_string == "")
-        return true;
+      key.kind = sort_date;
 
-      if (left_string == "" && right_string != "")
-        return false;
+    else if (field == "depends")
+      key.kind = sort_depends;
 
-      if (left_string == right_string)
-        continue;
+    else if (field == "recur")
+      key.kind = sort_duration;
 
-      return ascending ? (left_string < right_string)
-                       : (left_string > right_string);
+    else
+    {
+      // UDAs.
+      auto column = Context::getContext ().columns.find (field);
+      if (column == Context::getContext ().columns.end () ||
+          column->second == nullptr)
+        throw format ("The '{1}' column is not a valid sort field.", field);
+
+      std::string type = column->second->type ();
+           if (type == "numeric")  key.kind = sort_numeric;
+      else if (type == "date")     key.kind = sort_date;
+      else if (type == "duration") key.kind = sort_duration;
+      else if (type == "string")
+        key.kind = Task::customOrder.find (field) != Task::customOrder.end ()
+                     ? sort_custom
+                     : sort_uda_string;
+      else
+        key.kind = sort_none;
     }
 
-    // Depends string.
-    else if (field == "depends")
-    {
-      // Raw data is a comma-separated list of uuids
-      auto left_string  = (*global_data)[left].get_ref  (field);
-      auto right_string = (*global_data)[right].get_ref (field);
+    key.compare = select_compare (key.kind, key.ascending);
+    decoded.push_back (key);
+  }
+}
 
-      if (left_string == right_string)
-        continue;
+////////////////////////////////////////////////////////////////////////////////
+// Extract the value of every key for every task being sorted.
+static void extract_values (
+  std::vector <Task>& data,
+  const std::vector <int>& order,
+  const std::vector <sort_key>& keys,
+  std::vector <sort_value>& values)
+{
+  auto count = keys.size ();
+  values.assign (data.size () * count, sort_value ());
 
-      if (left_string == "" && right_string != "")
-        return ascending;
+  for (unsigned int k = 0; k < count; ++k)
+  {
+    auto& key = keys[k];
+
+    // Rank the distinct string values, in string order.
+    std::map <std::string, int> ranks;
+    if (key.kind != sort_urgency &&
+        key.kind != sort_id      &&
+        key.kind != sort_numeric &&
+        key.kind != sort_none)
+    {
+      for (auto i : order)
+        ranks.emplace (data[i].get_ref (key.field), 0);
 
-      if (left_string != "" && right_string == "")
-        return !ascending;
+      int rank = 0;
+      for (auto& r : ranks)
+        r.second = rank++;
+    }
 
-      // Sort on the first dependency.
-      left_number  = Context::getContext ().tdb2.id (left_string.substr (0, 36));
-      right_number = Context::getContext ().tdb2.id (right_string.substr (0, 36));
+    // Custom orders are only searched once per distinct value.
+    std::map <std::string, int> positions;
+    if (key.kind == sort_custom)
+    {
+      // Guaranteed to be found, because of ColUDA::validate ().
+      auto& custom = Task::customOrder[key.field];
+      for (auto& r : ranks)
+        positions[r.first] = std::find (custom.begin (), custom.end (), r.first) - custom.begin ();
+    }
 
-      if (left_number == right_number)
-        continue;
+    // Urgency is computed concurrently for many tasks, unless inherited, which
+    // looks up other tasks.
+    if (key.kind == sort_urgency &&
+        order.size () >= 2 * SORT_PARALLEL_MINIMUM &&
+        ! Context::getContext ().config.getBoolean ("urgency.inherit"))
+    {
+      auto threads = std::min (Pool::threads (), order.size () / SORT_PARALLEL_MINIMUM);
+      Pool::run (threads, [&] (size_t t)
+      {
+        auto end = order.size () * (t + 1) / threads;
+        for (auto j = order.size () * t / threads; j < end; ++j)
+          values[order[j] * count + k].number = data[order[j]].urgency ();
+      });
 
-      return ascending ? (left_number < right_number)
-                       : (left_number > right_number);
+      continue;
     }
 
-    // Duration.
-    else if (field == "recur")
+    for (auto i : order)
     {
-      auto left_string  = (*global_data)[left].get_ref  (field);
-      auto right_string = (*global_data)[right].get_ref (field);
+      auto& task  = data[i];
+      auto& value = values[i * count + k];
 
-      if (left_string == right_string)
+      if (key.kind == sort_urgency)
+      {
+        value.number = task.urgency ();
         continue;
+      }
 
-      Duration left_duration (left_string);
-      Duration right_duration (right_string);
-      return ascending ? (left_duration < right_duration)
-                       : (left_duration > right_duration);
-    }
+      if (key.kind == sort_id)
+      {
+        value.number = task.id;
+        continue;
+      }
 
-    // UDAs.
-    else if ((column = Context::getContext ().columns[field]) != nullptr)
-    {
-      std::string type = column->type ();
-      if (type == "numeric")
+      if (key.kind == sort_numeric)
       {
-        auto left_real  = strtof (((*global_data)[left].get_ref  (field)).c_str (), nullptr);
-        auto right_real = strtof (((*global_data)[right].get_ref (field)).c_str (), nullptr);
+        value.number = task.get_float (key.field);
+        continue;
+      }
 
-        if (left_real == right_real)
-          continue;
+      if (key.kind == sort_none)
+        continue;
 
-        return ascending ? (left_real < right_real)
-                         : (left_real > right_real);
-      }
-      else if (type == "string")
+      auto& text = task.get_ref (key.field);
+      value.rank  = ranks[text];
+      value.empty = text == "";
+
+      switch (key.kind)
       {
-        auto left_string = (*global_data)[left].get_ref (field);
-        auto right_string = (*global_data)[right].get_ref (field);
-
-        if (left_string == right_string)
-          continue;
-
-        // UDAs of the type string can have custom sort orders, which need to be considered.
-        auto order = Task::customOrder.find (field);
-        if (order != Task::customOrder.end ())
-        {
-          // Guaranteed to be found, because of ColUDA::validate ().
-          auto posLeft  = std::find (order->second.begin (), order->second.end (), left_string);
-          auto posRight = std::find (order->second.begin (), order->second.end (), right_string);
-          return ascending ? (posLeft < posRight) : (posLeft > posRight);
-        }
-        else
-        {
-          // Empty values are unconditionally last, if no custom order was specified.
-          if (left_string == "")
-            return false;
-          else if (right_string == "")
-            return true;
-
-          return ascending ? (left_string < right_string)
-                           : (left_string > right_string);
-        }
+      case sort_date:
+        value.number = task.get_date (key.field);
+        break;
+
+      case sort_depends:
+        // Sort on the first dependency.
+        if (! value.empty)
+          value.number = Context::getContext ().tdb2.id (text.substr (0, 36));
+        break;
+
+      case sort_duration:
+        value.number = Duration (text).toTime_t ();
+        break;
+
+      case sort_custom:
+        value.number = positions[text];
+        break;
+
+      default:
+        break;
       }
+    }
+  }
+}
 
-      else if (type == "date")
-      {
-        auto left_string  = (*global_data)[left].get_ref  (field);
-        auto right_string = (*global_data)[right].get_ref (field);
+////////////////////////////////////////////////////////////////////////////////
+// Sorts contiguous chunks of 'order' concurrently, then merges neighbouring
+// chunks until one remains.  Sorting each chunk stably, and merging with left
+// elements first, gives the same result as one std::stable_sort.
+static void parallel_sort (std::vector <int>& order, const sort_compare& compare)
+{
+  auto threads = std::min (Pool::threads (), order.size () / SORT_PARALLEL_MINIMUM);
 
-        if (left_string != "" && right_string == "")
-          return true;
+  std::vector <size_t> bounds;
+  for (size_t t = 0; t < threads; ++t)
+    bounds.push_back (order.size () * t / threads);
+  bounds.push_back (order.size ());
 
-        if (left_string == "" && right_string != "")
-          return false;
+  // Each thread counts its own comparisons.
+  std::vector <long> counts (bounds.size () - 1, 0);
+  Pool::run (bounds.size () - 1, [&order, &bounds, &compare, &counts] (size_t t)
+  {
+    std::stable_sort (order.begin () + bounds[t], order.begin () + bounds[t + 1],
+                      sort_compare (compare, counts[t]));
+  });
 
-        if (left_string == right_string)
-          continue;
+  while (bounds.size () > 2)
+  {
+    // Neighbouring pairs are merged, leaving any odd one out as it is.
+    Pool::run ((bounds.size () - 1) / 2, [&order, &bounds, &compare, &counts] (size_t pair)
+    {
+      auto t = pair * 2;
+      std::inplace_merge (order.begin () + bounds[t],
+                          order.begin () + bounds[t + 1],
+                          order.begin () + bounds[t + 2],
+                          sort_compare (compare, counts[t]));
+    });
+
+    std::vector <size_t> merged;
+    for (size_t t = 0; t + 1 < bounds.size (); t += 2)
+      merged.push_back (bounds[t]);
+    merged.push_back (order.size ());
+
+    bounds = merged;
+  }
 
-        return ascending ? (left_string < right_string)
-                         : (left_string > right_string);
-      }
-      else if (type == "duration")
-      {
-        auto left_string  = (*global_data)[left].get_ref  (field);
-        auto right_string = (*global_data)[right].get_ref (field);
+  for (auto count : counts)
+    compare.compared () += count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The comparisons of each kind of key, with the direction fixed at compile
+// time, so that a comparison neither dispatches on the kind nor tests the
+// direction.
+template <bool ascending>
+static inline int sort_direction (double left, double right)
+{
+  return (ascending ? left < right : left > right) ? -1 : 1;
+}
 
-        if (left_string == right_string)
-          continue;
+////////////////////////////////////////////////////////////////////////////////
+// Numbers.
+template <bool ascending>
+static int compare_number (const sort_value& l, const sort_value& r)
+{
+  if (l.number == r.number)
+    return 0;
 
-        Duration left_duration (left_string);
-        Duration right_duration (right_string);
-        return ascending ? (left_duration < right_duration)
-                         : (left_duration > right_duration);
-      }
-    }
-    else
-      throw format ("The '{1}' column is not a valid sort field.", field);
+  return sort_direction <ascending> (l.number, r.number);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Strings.
+template <bool ascending>
+static int compare_string (const sort_value& l, const sort_value& r)
+{
+  if (l.rank == r.rank)
+    return 0;
+
+  return sort_direction <ascending> (l.rank, r.rank);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Empty values are unconditionally last, if no custom order was specified.
+template <bool ascending>
+static int compare_uda_string (const sort_value& l, const sort_value& r)
+{
+  if (l.rank == r.rank)
+    return 0;
+
+  if (l.empty)
+    return 1;
+  else if (r.empty)
+    return -1;
+
+  return sort_direction <ascending> (l.rank, r.rank);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// UDAs of the type string can have custom sort orders.  Durations, also ranked
+// by their text, compare the same way.
+template <bool ascending>
+static int compare_position (const sort_value& l, const sort_value& r)
+{
+  if (l.rank == r.rank)
+    return 0;
+
+  return sort_direction <ascending> (l.number, r.number);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Dates, with undated tasks last.
+template <bool ascending>
+static int compare_date (const sort_value& l, const sort_value& r)
+{
+  if (! l.empty && r.empty)
+    return -1;
+
+  if (l.empty && ! r.empty)
+    return 1;
+
+  if (l.rank == r.rank)
+    return 0;
+
+  return sort_direction <ascending> (l.number, r.number);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Depends, by the ID of the first dependency.
+template <bool ascending>
+static int compare_depends (const sort_value& l, const sort_value& r)
+{
+  if (l.rank == r.rank)
+    return 0;
+
+  if (l.empty && ! r.empty)
+    return ascending ? -1 : 1;
+
+  if (! l.empty && r.empty)
+    return ascending ? 1 : -1;
+
+  if (l.number == r.number)
+    return 0;
+
+  return sort_direction <ascending> (l.number, r.number);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static int compare_none (const sort_value&, const sort_value&)
+{
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Chooses the comparison for a key, once per sort.
+static sort_key_compare select_compare (sort_kind kind, bool ascending)
+{
+  switch (kind)
+  {
+  case sort_urgency:
+  case sort_id:
+  case sort_numeric:
+    return ascending ? compare_number <true> : compare_number <false>;
+
+  case sort_string:
+    return ascending ? compare_string <true> : compare_string <false>;
+
+  case sort_uda_string:
+    return ascending ? compare_uda_string <true> : compare_uda_string <false>;
+
+  case sort_custom:
+  case sort_duration:
+    return ascending ? compare_position <true> : compare_position <false>;
+
+  case sort_date:
+    return ascending ? compare_date <true> : compare_date <false>;
+
+  case sort_depends:
+    return ascending ? compare_depends <true> : compare_depends <false>;
+
+  case sort_none:
+    break;
+  }
+
+  return compare_none;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Essentially a static implementation of a dynamic operator<, with the kind
+// and direction of each key already resolved to its comparison.
+bool sort_compare::operator() (int left, int right) const
+{
+  auto count = _keys.size ();
+  const sort_value* lhs = &_values[left  * count];
+  const sort_value* rhs = &_values[right * count];
+  ++*_compared;
+
+  for (unsigned int k = 0; k < count; ++k)
+  {
+    int result = _keys[k].compare (lhs[k], rhs[k]);
+    if (result)
+      return result < 0;
   }
 
   return false;
@@ -0,0 +1,205 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cmake.h>
+#include <fstream>
+#include <algorithm>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <Context.h>
+#include <FS.h>
+#include <main.h>
+
+// A background sync, with taskd.background, keeps its state in the data
+// directory:
+//   sync.lock     Held by the running background sync.
+//   sync.pending  Changes were made while it ran, so it syncs again.
+//   sync.result   Messages from the last background sync, shown once.
+//   sync.backoff  After a failure, the time before which no sync starts, and
+//                 the delay that led to it.
+
+////////////////////////////////////////////////////////////////////////////////
+static std::string syncFile (const std::string& name)
+{
+  return (std::string) Context::getContext ().data_dir + '/' + name;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Runs one sync in a child process, with its footnotes and errors written to
+// the result file, and returns whether it succeeded.
+static bool runSync (const std::string& result)
+{
+  auto pid = fork ();
+  if (pid == 0)
+  {
+    int null = open ("/dev/null", O_RDWR);
+    int messages = open (result.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (null == -1 || messages == -1)
+      _exit (127);
+
+    dup2 (null, STDIN_FILENO);
+    dup2 (null, STDOUT_FILENO);
+    dup2 (messages, STDERR_FILENO);
+
+    setenv ("TASKRC", Context::getContext ().rc_file._data.c_str (), 1);
+    setenv ("TASKDATA", Context::getContext ().data_dir._data.c_str (), 1);
+
+    const char* argv[] = {"task",
+                          "rc.taskd.background=0",
+                          "rc.confirmation=0",
+                          "rc.color=0",
+                          "rc.verbose=footnote",
+                          "synchronize",
+                          nullptr};
+
+    char program[PATH_MAX];
+    auto length = readlink ("/proc/self/exe", program, sizeof (program) - 1);
+    if (length > 0)
+    {
+      program[length] = '\0';
+      execv (program, (char* const*) argv);
+    }
+
+    execvp ("task", (char* const*) argv);
+    _exit (127);
+  }
+
+  int status = 0;
+  if (pid < 0 || waitpid (pid, &status, 0) != pid)
+    return false;
+
+  return WIFEXITED (status) && WEXITSTATUS (status) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Syncs in a detached process, so that the command does not wait on the
+// network.  Requests made while a sync runs are coalesced into one more sync,
+// and after a failure, none is started until the backoff has passed.
+void syncInBackground ()
+{
+  auto& context = Context::getContext ();
+  if (! context.config.getBoolean ("taskd.background") ||
+      context.config.get ("taskd.server") == "" ||
+      context.cli2.getCommand () == "synchronize")
+    return;
+
+  // The changes stay in backlog.data, for the first sync after the backoff.
+  long until = 0;
+  long delay = 0;
+  {
+    std::ifstream in (syncFile ("sync.backoff"));
+    in >> until >> delay;
+  }
+
+  if (time (nullptr) < until)
+    return;
+
+  int lock = open (syncFile ("sync.lock").c_str (), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (lock == -1)
+    return;
+
+  if (flock (lock, LOCK_EX | LOCK_NB) == -1)
+  {
+    close (lock);
+    File::create (syncFile ("sync.pending"), 0600);
+    return;
+  }
+
+  auto pid = fork ();
+  if (pid == 0)
+  {
+    // Detach, and leave the worker to be reaped by init.  It writes nothing to
+    // the terminal, nor holds open a pipe that the caller reads to its end.
+    setsid ();
+    if (fork () != 0)
+      _exit (0);
+
+    int null = open ("/dev/null", O_RDWR);
+    if (null != -1)
+    {
+      dup2 (null, STDIN_FILENO);
+      dup2 (null, STDOUT_FILENO);
+      dup2 (null, STDERR_FILENO);
+      if (null > STDERR_FILENO)
+        close (null);
+    }
+
+    auto pending = syncFile ("sync.pending");
+    auto result  = syncFile ("sync.result");
+
+    bool ok;
+    do
+    {
+      unlink (pending.c_str ());
+      ok = runSync (result + ".new");
+    }
+    while (ok && File (pending).exists ());
+
+    // The delay doubles with each failure, from a minute up to an hour.
+    if (ok)
+      unlink (syncFile ("sync.backoff").c_str ());
+    else
+    {
+      delay = std::min (std::max (delay * 2, 60L), 3600L);
+      std::ofstream out (syncFile ("sync.backoff"));
+      out << time (nullptr) + delay << ' ' << delay << '\n';
+    }
+
+    rename ((result + ".new").c_str (), result.c_str ());
+    _exit (0);
+  }
+
+  // The worker holds the lock through its own descriptor.
+  close (lock);
+  if (pid > 0)
+    waitpid (pid, nullptr, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Shows the messages of the last background sync, once.
+void syncResults ()
+{
+  auto result = syncFile ("sync.result");
+  std::ifstream in (result);
+  if (! in.good ())
+    return;
+
+  std::string line;
+  while (std::getline (in, line))
+    if (line != "")
+      Context::getContext ().footnote (line);
+
+  unlink (result.c_str ());
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -37,6 +37,7 @@
 #include <sstream>
 #include <vector>
 #include <algorithm>
+#include <mutex>
 #include <cstring>
 #include <string>
 #include <stdint.h>
@@ -50,6 +51,8 @@
 #include <pwd.h>
 #include <signal.h>
 #include <sys/select.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <Lexer.h>
 #include <unicode.h>
 #include <utf8.h>
@@ -125,6 +128,92 @@ int confirm4 (const std::string& question)
   return 0;
 }
 
+// Random (version 4) UUIDs are made from a buffer of random bytes, read from
+// /dev/urandom a block at a time, so that adding or duplicating many tasks does
+// not pay for a system call and a call to libuuid each.  Where /dev/urandom
+// cannot be read, the UUID comes from the system library, as below.
+//
+// The buffer is shared by the import threads, so it is taken under a mutex, and
+// it is dropped in a forked child, which would otherwise issue the same UUIDs
+// as its parent.
+static bool randomUuid (char* out)
+{
+  static std::mutex mutex;
+  static unsigned char buffer[4096];
+  static size_t used = sizeof (buffer);
+  static pid_t owner = 0;
+  static int fd = -2;
+
+  unsigned char bytes[16];
+  {
+    std::lock_guard <std::mutex> lock (mutex);
+    if (owner != getpid ())
+    {
+      memset (buffer, 0, sizeof (buffer));
+      used = sizeof (buffer);
+      owner = getpid ();
+    }
+
+    if (used + 16 > sizeof (buffer))
+    {
+      if (fd == -2)
+        fd = open ("/dev/urandom", O_RDONLY | O_CLOEXEC);
+
+      size_t filled = 0;
+      while (fd >= 0 && filled < sizeof (buffer))
+      {
+        auto got = read (fd, buffer + filled, sizeof (buffer) - filled);
+        if (got > 0)
+          filled += got;
+        else if (got < 0 && errno == EINTR)
+          continue;
+        else
+        {
+          close (fd);
+          fd = -1;
+        }
+      }
+
+      if (fd < 0)
+        return false;
+
+      used = 0;
+    }
+
+    // Used bytes are not left behind.
+    memcpy (bytes, buffer + used, 16);
+    memset (buffer + used, 0, 16);
+    used += 16;
+  }
+
+  bytes[6] = (bytes[6] & 0x0f) | 0x40;   // Version 4.
+  bytes[8] = (bytes[8] & 0x3f) | 0x80;   // RFC 4122 variant.
+
+  // Each byte is written as two digits at once, from a table of all 256.
+  static const std::string pairs = [] ()
+  {
+    static const char hex[] = "0123456789abcdef";
+    std::string table (512, '0');
+    for (int i = 0; i < 256; ++i)
+    {
+      table[2 * i]     = hex[i >> 4];
+      table[2 * i + 1] = hex[i & 0xf];
+    }
+    return table;
+  } ();
+
+  for (int i = 0; i < 16; ++i)
+  {
+    memcpy (out, pairs.data () + 2 * bytes[i], 2);
+    out += 2;
+    if (i == 3 || i == 5 || i == 7 || i == 9)
+      *out++ = '-';
+  }
+
+  memset (bytes, 0, sizeof (bytes));
+  return true;
+}
+
 // Handle the generation of UUIDs on FreeBSD in a separate implementation
 // of the uuid () function, since the API is quite different from Linux's.
 // Also, uuid_unparse_lower is not needed on FreeBSD, because the string
@@ -134,13 +223,17 @@ int confirm4 (const std::string& question)
 #if defined(FREEBSD) || defined(OPENBSD)
 const std::string uuid ()
 {
+  std::string res (36, '-');
+  if (randomUuid (&res[0]))
+    return res;
+
   uuid_t id;
   uint32_t status;
   char *buffer (0);
   uuid_create (&id, &status);
   uuid_to_string (&id, &buffer, &status);
 
-  std::string res (buffer);
+  res = buffer;
   free (buffer);
 
   return res;
@@ -161,6 +254,10 @@ void uuid_unparse_lower (uuid_t uu, char *out)
 
 const std::string uuid ()
 {
+  std::string res (36, '-');
+  if (randomUuid (&res[0]))
+    return res;
+
   uuid_t id;
   uuid_generate (id);
   char buffer[100] {};
@@ -273,6 +370,58 @@ bool nontrivial (const std::string& input)
   return false;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Equivalent to utf8_width, but with a fast path for printable ASCII, which is
+// tested eight bytes at a time.  Only the remainder of a string after the first
+// other byte is measured by utf8_width.
+unsigned int textWidth (const std::string& input)
+{
+  const uint64_t ones  = 0x0101010101010101ULL;
+  const uint64_t highs = 0x8080808080808080ULL;
+
+  auto data = input.data ();
+  auto length = input.length ();
+  std::string::size_type i = 0;
+
+  for (; i + 8 <= length; i += 8)
+  {
+    uint64_t x;
+    memcpy (&x, data + i, 8);
+
+    // Any byte with the high bit set, below ' ', or equal to DEL.
+    uint64_t del = x ^ (ones * 0x7f);
+    if ((x & highs) ||
+        ((x - ones * 0x20) & ~x & highs) ||
+        ((del - ones) & ~del & highs))
+      break;
+  }
+
+  for (; i < length; ++i)
+  {
+    auto c = (unsigned char) data[i];
+    if (c < 0x20 || c >= 0x7f)
+      return i + utf8_width (input.substr (i));
+  }
+
+  return i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Configuration is an ordered map, so the settings sharing a prefix are
+// adjacent, and are found without visiting every other setting.
+std::pair <Configuration::const_iterator, Configuration::const_iterator> settings (
+  const Configuration& config,
+  const std::string& prefix)
+{
+  auto first = config.lower_bound (prefix);
+  auto last = first;
+  while (last != config.end () &&
+         ! last->first.compare (0, prefix.length (), prefix))
+    ++last;
+
+  return {first, last};
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 const char* optionalBlankLine ()
 {
@@ -309,3 +458,13 @@ void setHeaderUnderline (Table& table)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+// The number of fields in a delimited list, as split would find them.
+int countFields (const std::string& list, char delimiter)
+{
+  if (list.empty ())
+    return 0;
+
+  return 1 + (int) std::count (list.begin (), list.end (), delimiter);
+}
+
+////////////////////////////////////////////////////////////////////////////////
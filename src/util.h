@@ -31,6 +31,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <cstring>
 #include <sys/types.h>
 #if defined(FREEBSD) || defined(OPENBSD)
 #include <uuid.h>
@@ -38,6 +39,7 @@
 #include <uuid/uuid.h>
 #endif
 #include <Table.h>
+#include <Configuration.h>
 
 // util.cpp
 int confirm4 (const std::string&);
@@ -61,8 +63,36 @@ const std::vector <std::string> extractParents (
 #endif
 
 bool nontrivial (const std::string&);
+unsigned int textWidth (const std::string&);
+std::pair <Configuration::const_iterator, Configuration::const_iterator> settings (
+  const Configuration&,
+  const std::string&);
 const char* optionalBlankLine ();
 void setHeaderUnderline (Table&);
+int countFields (const std::string&, char delimiter = ',');
+
+////////////////////////////////////////////////////////////////////////////////
+// Calls fn (const char*, size_t) with each field of a delimited list, as split
+// would find them, without copying the list.  Stops, and returns false, when
+// fn returns false.
+template <typename F>
+bool scanFields (const std::string& list, char delimiter, F fn)
+{
+  if (list.empty ())
+    return true;
+
+  auto start = list.data ();
+  auto end   = start + list.size ();
+  while (auto found = (const char*) memchr (start, delimiter, end - start))
+  {
+    if (! fn (start, (size_t) (found - start)))
+      return false;
+
+    start = found + 1;
+  }
+
+  return fn (start, (size_t) (end - start));
+}
 
 #endif
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2013 - 2019, Göteborg Bit Factory.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmake.h>
+#include <AhoCorasick.h>
+#include <test.h>
+
+////////////////////////////////////////////////////////////////////////////////
+int main (int, char**)
+{
+  UnitTest t (13);
+
+  AhoCorasick sensitive;
+  sensitive.add ("he");
+  sensitive.add ("she");
+  sensitive.add ("his");
+  sensitive.add ("hers");
+  sensitive.compile ();
+
+  std::vector <char> found;
+  sensitive.match ("ushers", found);
+  t.is ((int) found.size (), 4,  "match 'ushers' -> 4 results");
+  t.ok (found[0],                "match 'ushers' -> 'he'");
+  t.ok (found[1],                "match 'ushers' -> 'she'");
+  t.notok (found[2],             "match 'ushers' -> not 'his'");
+  t.ok (found[3],                "match 'ushers' -> 'hers'");
+
+  found.clear ();
+  sensitive.match ("USHERS", found);
+  t.notok (found[0] || found[1] || found[3], "match 'USHERS' -> none, case sensitive");
+
+  sensitive.match ("this", found);
+  t.ok (found[2],                "match 'this' -> 'his', accumulated");
+
+  AhoCorasick insensitive (false);
+  insensitive.add ("Foo");
+  insensitive.add ("");
+  insensitive.add ("oba");
+  insensitive.compile ();
+
+  found.clear ();
+  insensitive.match ("xFOOBAR", found);
+  t.ok (found[0],                "match 'xFOOBAR' -> 'Foo', case insensitive");
+  t.ok (found[1],                "match 'xFOOBAR' -> '', empty pattern");
+  t.ok (found[2],                "match 'xFOOBAR' -> 'oba', overlapping");
+
+  found.clear ();
+  insensitive.match ("fo", found);
+  t.notok (found[0],             "match 'fo' -> not 'Foo'");
+
+  AhoCorasick none;
+  none.compile ();
+  t.ok (none.empty (),           "empty -> true");
+
+  found.clear ();
+  none.match ("anything", found);
+  t.is ((int) found.size (), 0,  "match 'anything' -> no patterns");
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
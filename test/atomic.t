@@ -0,0 +1,190 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+###############################################################################
+#
+# Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+# https://www.opensource.org/licenses/mit-license.php
+#
+###############################################################################
+
+import sys
+import os
+import threading
+import unittest
+
+# Ensure python finds the local simpletap module
+sys.path.append(os.path.dirname(os.path.abspath(__file__)))
+
+from basetest import Task, TestCase
+
+
+class TestDataAtomic(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t.config('data.atomic', '1')
+
+    def data_file(self, name):
+        return os.path.join(self.t.datadir, name)
+
+    def test_atomic_commit(self):
+        """Changes to every file are committed under one lock"""
+        self.t('add one')
+        self.t('add two')
+        self.t('1 done')
+        self.t('2 modify three')
+
+        code, out, err = self.t('_ids')
+        self.assertEqual(out.split(), ['1'])
+        code, out, err = self.t('1 _unique description')
+        self.assertEqual(out.strip(), 'three')
+        code, out, err = self.t('completed')
+        self.assertIn('one', out)
+
+        self.assertTrue(os.path.exists(self.data_file('lock.data')))
+        for name in ('pending.data', 'completed.data', 'undo.data'):
+            self.assertFalse(os.path.exists(self.data_file(name + '.new')))
+
+    def test_atomic_undo(self):
+        """Undo works on files committed atomically"""
+        self.t('add one')
+        self.t('1 modify two')
+        self.t('undo', input='y\n')
+        code, out, err = self.t('1 _unique description')
+        self.assertEqual(out.strip(), 'one')
+
+    def test_atomic_debug(self):
+        """The atomic commit is reported in debug output"""
+        code, out, err = self.t('add one rc.debug=1')
+        self.assertIn('under one lock', out + err)
+
+
+class TestDataReplace(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t.config('data.atomic', '0')
+
+    def data_file(self, name):
+        return os.path.join(self.t.datadir, name)
+
+    def test_rewrite_replaces_file(self):
+        """A rewritten file replaces the old one, keeping its permissions"""
+        self.t('add one')
+        self.t('add two')
+        os.chmod(self.data_file('pending.data'), 0o640)
+        before = os.stat(self.data_file('pending.data'))
+
+        self.t('1 modify three')
+        after = os.stat(self.data_file('pending.data'))
+        self.assertNotEqual(before.st_ino, after.st_ino)
+        self.assertEqual(after.st_mode & 0o777, 0o640)
+        self.assertFalse(os.path.exists(self.data_file('pending.data.new')))
+
+        code, out, err = self.t('_unique description')
+        self.assertEqual(out.split(), ['three', 'two'])
+
+    def test_append_in_place(self):
+        """An added task is appended to the file in place"""
+        self.t('add one')
+        before = os.stat(self.data_file('pending.data'))
+        self.t('add two')
+        after = os.stat(self.data_file('pending.data'))
+        self.assertEqual(before.st_ino, after.st_ino)
+
+
+class TestDataAppend(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t.config('data.append', '1')
+
+    def data_file(self, name):
+        return os.path.join(self.t.datadir, name)
+
+    def test_append_concurrent(self):
+        """Additions made at the same time are all kept"""
+        def adder(n):
+            for i in range(5):
+                self.t('add writer{0}task{1}'.format(n, i))
+
+        threads = [threading.Thread(target=adder, args=(n,)) for n in range(4)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+        code, out, err = self.t('_unique description')
+        self.assertEqual(len(out.split()), 20)
+        code, out, err = self.t('_ids')
+        self.assertEqual(out.split(), [str(i) for i in range(1, 21)])
+
+    def test_append_shows_uuid(self):
+        """An addition shows the uuid, as the ID is found later"""
+        code, out, err = self.t('add one')
+        self.assertRegex(out, 'Created task [0-9a-f]{8}-')
+
+    def test_append_partial_record(self):
+        """A partial record at the end is ignored, then cut off"""
+        self.t('add one')
+        with open(self.data_file('pending.data'), 'a') as fh:
+            fh.write('[description:"torn" sta')
+
+        code, out, err = self.t('_unique description')
+        self.assertEqual(out.split(), ['one'])
+
+        self.t('add two')
+        with open(self.data_file('pending.data')) as fh:
+            lines = fh.read().splitlines()
+        self.assertEqual(len(lines), 2)
+        self.assertTrue(all(line.endswith(']') for line in lines))
+
+
+class TestDataSnapshot(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t.config('data.snapshot', '1')
+        self.t('add one')
+        self.t('add two')
+
+    def test_generation(self):
+        """Each commit is a generation, which a snapshot reads"""
+        with open(os.path.join(self.t.datadir, 'lock.data')) as fh:
+            self.assertEqual(fh.read(), '2\n')
+
+        code, out, err = self.t('_unique description rc.debug:1')
+        self.assertIn('TDB2::snapshot generation 2', out + err)
+        self.assertIn('one', out)
+        self.assertIn('two', out)
+
+    def test_write_after_snapshot(self):
+        """A read-only command that writes commits the files as they are"""
+        self.t('1 done')
+        code, out, err = self.t('_unique description')
+        self.assertEqual(out, 'two\n')
+
+        code, out, err = self.t('completed')
+        self.assertIn('one', out)
+
+
+if __name__ == "__main__":
+    from simpletap import TAPTestRunner
+    unittest.main(testRunner=TAPTestRunner())
+
+# vim: ai sts=4 et sw=4 ft=python
@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2013 - 2019, Göteborg Bit Factory.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmake.h>
+#include <test.h>
+#include <AttributeMap.h>
+
+////////////////////////////////////////////////////////////////////////////////
+int main (int, char**)
+{
+  UnitTest t (30);
+
+  AttributeMap map;
+  t.ok (map.empty (),                            "AttributeMap starts empty");
+  t.ok (map.find ("x") == map.end (),            "find (x) --> end");
+
+  map["description"] = "foo";
+  map["project"]     = "bar";
+  map["due"]         = "1234";
+  t.is ((int) map.size (), 3,                    "3 attributes");
+  t.is (map["project"], "bar",                   "[project] --> bar");
+  t.is ((int) map.count ("due"), 1,              "count (due) --> 1");
+  t.is ((int) map.count ("end"), 0,              "count (end) --> 0");
+
+  // Sorted iteration, as for std::map.
+  auto i = map.begin ();
+  t.is (i->first, "description",                 "first --> description");
+  ++i;
+  t.is (i->first, "due",                         "second --> due");
+  ++i;
+  t.is (i->first, "project",                     "third --> project");
+
+  // Insert does not replace.
+  t.notok (map.insert (AttributeMap::value_type ("due", "5678")).second, "insert (due) --> false");
+  t.is (map["due"], "1234",                      "[due] --> 1234");
+  t.ok (map.insert (AttributeMap::value_type ("end", "5678")).second, "insert (end) --> true");
+
+  // Erase.
+  t.is ((int) map.erase ("end"), 1,              "erase (end) --> 1");
+  t.is ((int) map.erase ("end"), 0,              "erase (end) --> 0");
+  auto next = map.erase (map.find ("due"));
+  t.is (next->first, "project",                  "erase (due) --> project");
+
+  // Equality.
+  AttributeMap other;
+  other["project"] = "bar";
+  t.ok (map != other,                            "map != other");
+  other["description"] = "foo";
+  t.ok (map == other,                            "map == other");
+
+  // Typed, cached values.
+  map["entry"] = "1500000000";
+  t.is ((int) map.get_date ("entry"), 1500000000, "get_date (entry) --> 1500000000");
+  map["entry"] = "1600000000";
+  t.is ((int) map.get_date ("entry"), 1600000000, "get_date (entry) after change --> 1600000000");
+  t.is ((int) map.get_date ("end"), 0,          "get_date (end) --> 0");
+
+  map["priority"] = "2.5";
+  t.is (map.get_float ("priority"), 2.5,  0.001, "get_float (priority) --> 2.5");
+
+  AttributeMap copy (map);
+  copy["priority"] = "3.5";
+  t.is (copy.get_float ("priority"), 3.5, 0.001, "copy get_float (priority) --> 3.5");
+  t.is (map.get_float ("priority"), 2.5,  0.001, "original get_float (priority) --> 2.5");
+
+  // Memoized flags.
+  bool flag = false;
+  t.notok (map.get_flag (3, flag),               "get_flag (3) --> unknown");
+  map.set_flag (3, true);
+  t.ok (map.get_flag (3, flag) && flag,          "get_flag (3) --> true");
+  map["project"] = "baz";
+  t.notok (map.get_flag (3, flag),               "get_flag (3) after change --> unknown");
+
+  // Adjacent names with a prefix.
+  map["annotation_1500000002"] = "two";
+  map["annotation_1500000001"] = "one";
+  auto annos = map.prefixed ("annotation_");
+  t.is ((int) annos.size (), 2,                  "prefixed (annotation_) --> 2");
+  t.is (annos.begin ()->second, "one",           "prefixed (annotation_) first --> one");
+  t.is ((annos.begin () + 1)->second, "two",     "prefixed (annotation_) second --> two");
+  t.ok (map.prefixed ("x").empty (),             "prefixed (x) --> empty");
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
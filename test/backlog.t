@@ -81,6 +81,39 @@ class Test1510(TestCase):
         self.t("add test4 project:random")
         self.assertNoEmptyValueInBacklog('project')
 
+
+class TestDataBacklog(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t.config('data.backlog', '0')
+
+    def backlog_lines(self):
+        backlog_path = os.path.join(self.t.datadir, 'backlog.data')
+        if not os.path.exists(backlog_path):
+            return []
+        with open(backlog_path) as backlog:
+            return backlog.readlines()
+
+    def test_no_backlog_without_server(self):
+        """data.backlog=0 records nothing while taskd.server is unset"""
+        self.t('add one')
+        self.t('1 modify two')
+        self.assertEqual(self.backlog_lines(), [])
+
+    def test_undo_without_backlog(self):
+        """Undo works when nothing is recorded in backlog.data"""
+        self.t('add one')
+        self.t('1 modify two')
+        self.t('undo', input='y\n')
+        code, out, err = self.t('_get 1.description')
+        self.assertEqual(out.strip(), 'one')
+
+    def test_backlog_with_server(self):
+        """data.backlog=0 still records changes once taskd.server is set"""
+        self.t.config('taskd.server', 'localhost:53589')
+        self.t('add one')
+        self.assertEqual(len(self.backlog_lines()), 1)
+
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
     unittest.main(testRunner=TAPTestRunner())
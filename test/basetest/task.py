@@ -188,6 +188,24 @@ class Task(object):
     def latest(self):
         return self.export_one("+LATEST")
 
+    def perf(self, args="", input=None):
+        """Run task with rc.perf.output=json, and fail if exit code != 0.
+
+        Returns the JSON object written, whose "counters" hold the work done,
+        such as the tasks "parsed", the sort comparisons "compared", and the
+        hook scripts "spawned".
+        """
+        path = os.path.join(self.datadir, "perf.json")
+        if os.path.exists(path):
+            os.remove(path)
+
+        args = self._split_string_args_if_string(args)
+        self.runSuccess(["rc.perf.output=json", "rc.perf.file=" + path] + args,
+                        input=input)
+
+        with open(path) as fh:
+            return json.loads(fh.readlines()[-1])
+
     @staticmethod
     def _split_string_args_if_string(args):
         """Helper function to parse and split into arguments a single string
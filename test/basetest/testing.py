@@ -13,6 +13,25 @@ class BaseTestCase(unittest.TestCase):
             sys.stderr.write(line + '\n')
         sys.stderr.write("---  tap output end  ---\n")
 
+    def assertCounters(self, perf, **bounds):
+        """Assert that the counters of a Task.perf result are within bounds.
+
+        Each bound is a maximum, or a (minimum, maximum) pair, of the counter
+        of that name, so that a test fails on an increase in work done, as an
+        algorithmic regression would cause, without timing anything:
+
+            self.assertCounters(self.t.perf("list"), parsed=10, spawned=(0, 0))
+        """
+        counters = perf["counters"]
+        for name in sorted(bounds):
+            self.assertIn(name, counters, "No '{0}' counter".format(name))
+
+            bound = bounds[name]
+            low, high = bound if isinstance(bound, tuple) else (0, bound)
+            if not low <= counters[name] <= high:
+                self.fail("'{0}' {1} counted {2}, outside {3}..{4}".format(
+                    perf["command"], name, counters[name], low, high))
+
 
 @unittest.skipIf(TASKW_SKIP, "TASKW_SKIP set, skipping task tests.")
 class TestCase(BaseTestCase):
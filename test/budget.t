@@ -0,0 +1,106 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+###############################################################################
+#
+# Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+# https://www.opensource.org/licenses/mit-license.php
+#
+###############################################################################
+
+
+import sys
+import os
+import json
+import math
+import unittest
+import uuid
+# Ensure python finds the local simpletap module
+sys.path.append(os.path.dirname(os.path.abspath(__file__)))
+
+from basetest import Task, TestCase
+
+# Enough tasks that quadratic work is far outside the bounds of linear or
+# n log n work.
+COUNT = 100
+
+# The comparisons allowed for sorting COUNT tasks.
+SORTED = 2 * COUNT * int(math.ceil(math.log(COUNT, 2)))
+
+
+class TestReportBudget(TestCase):
+    @classmethod
+    def setUpClass(cls):
+        """Executed once before any test in the class"""
+        cls.t = Task()
+        tasks = [json.dumps({"uuid": str(uuid.uuid4()),
+                             "description": "Task {0:03d}".format(COUNT - i),
+                             "status": "pending",
+                             "entry": "20200101T000000Z"})
+                 for i in range(COUNT)]
+        cls.t("import -", input="\n".join(tasks) + "\n")
+
+        # The first command to read pending.data builds its index.
+        cls.t("list")
+
+    def test_list(self):
+        """A report parses and renders each task once, and spawns nothing"""
+        self.assertCounters(self.t.perf("list"),
+                            parsed=COUNT, rendered=(COUNT, COUNT),
+                            compared=SORTED, spawned=(0, 0))
+
+    def test_sort_description(self):
+        """Sorting by description is within n log n comparisons"""
+        perf = self.t.perf("rc.report.list.sort=description+ list")
+        self.assertCounters(perf, compared=(COUNT - 1, SORTED))
+
+    def test_limit(self):
+        """A limited report sorts within n log n comparisons"""
+        perf = self.t.perf("list limit:5")
+        self.assertCounters(perf, rendered=(5, 5), compared=SORTED)
+
+    def test_count(self):
+        """Counting sorts nothing"""
+        self.assertCounters(self.t.perf("count"), compared=(0, 0))
+
+
+class TestHookBudget(TestCase):
+    def setUp(self):
+        """Executed before each test"""
+        self.t = Task()
+        self.t.activate_hooks()
+        self.t.hooks.add_default("on-add-accept")
+
+    def test_add(self):
+        """Adding a task spawns its on-add script once"""
+        self.assertCounters(self.t.perf("add foo"), spawned=(1, 1))
+
+    def test_list(self):
+        """A report spawns no on-add script"""
+        self.t("add foo")
+        self.assertCounters(self.t.perf("list"), spawned=(0, 0))
+
+
+if __name__ == "__main__":
+    from simpletap import TAPTestRunner
+    unittest.main(testRunner=TAPTestRunner())
+
+# vim: ai sts=4 et sw=4 ft=python
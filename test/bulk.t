@@ -167,6 +167,23 @@ class TestBulk(TestCase):
         self.assertIn("Deleted 0 tasks", out)
         self.assertNotIn("Deleting task", out)
 
+    def test_bulk_summary(self):
+        """bulk delete lists every task before the first question"""
+        code, out, err = self.t("1-3 delete rc.confirmation:1", input="all\n")
+        self.assertRegexpMatches(out, "3 tasks to delete:\n  1 'one'\n  2 'two'\n  3 'three'\n")
+        self.assertLess(out.index("three'\n"), out.index("(yes/no/all/quit)"))
+
+    def test_bulk_summary_not_bulk(self):
+        """not bulk delete without confirmation lists nothing"""
+        code, out, err = self.t("1-2 delete rc.confirmation:0")
+        self.assertNotIn("tasks to delete:", out)
+
+    def test_bulk_summary_modify(self):
+        """bulk modify lists the tasks that would change"""
+        code, out, err = self.t.runError("1-3 modify pri:H", input="y\nn\ny\n")
+        self.assertIn("3 tasks to modify:", out)
+        self.assertIn("Modified 2 tasks", out)
+
 
 class TestBugBulk(TestCase):
     @classmethod
@@ -86,6 +86,43 @@ class TestBurndownCommand(TestCase):
         self.assertIn("+", out)
         self.assertIn("X", out)
 
+    def test_burndown_from_index(self):
+        """Ensure burndown charts completed tasks from the index as parsed"""
+        # Reading every task writes the completed.data index.
+        self.t("all")
+        for period in ("daily", "weekly", "monthly"):
+            code, indexed, err = self.t("burndown." + period)
+            code, parsed, err = self.t("burndown.{0} rc.data.index=0".format(period))
+            self.assertEqual(indexed, parsed)
+
+
+class TestBurndownCache(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task()
+        self.t.config("report.cache", "600")
+        self.t("add one entry:-3w")
+        self.t("add two entry:-2w")
+        self.t("2 done")
+
+    def test_burndown_cached(self):
+        """Ensure a repeated burndown chart is drawn from its cached counts"""
+        code, scanned, err = self.t("burndown.weekly rc.report.cache=0")
+        code, first, err = self.t("burndown.weekly")
+        self.assertTrue(os.path.exists(os.path.join(self.t.datadir, "report.cache")))
+        code, second, err = self.t("burndown.weekly")
+        self.assertEqual(scanned, first)
+        self.assertEqual(first, second)
+
+    def test_burndown_cache_changed(self):
+        """Ensure a burndown chart is scanned again when the tasks change"""
+        self.t("burndown.daily")
+        self.t("add three")
+        self.t("add four")
+        code, cached, err = self.t("burndown.daily")
+        code, scanned, err = self.t("burndown.daily rc.report.cache=0")
+        self.assertEqual(cached, scanned)
+
 
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
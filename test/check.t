@@ -0,0 +1,124 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+###############################################################################
+#
+# Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+# https://www.opensource.org/licenses/mit-license.php
+#
+###############################################################################
+
+import sys
+import os
+import unittest
+# Ensure python finds the local simpletap module
+sys.path.append(os.path.dirname(os.path.abspath(__file__)))
+
+from basetest import Task, TestCase
+
+
+class TestCheck(TestCase):
+    def setUp(self):
+        self.t = Task()
+
+    def data_path(self, name):
+        return os.path.join(self.t.datadir, name)
+
+    def append_line(self, name, line):
+        with open(self.data_path(name), 'a') as fh:
+            fh.write(line + '\n')
+
+    def test_check_clean(self):
+        """check finds no problems in a sound database"""
+        self.t('add one')
+        self.t('add two depends:1')
+        self.t('2 done')
+        code, out, err = self.t('check')
+        self.assertIn('Checked 2 tasks, no problems found.', out)
+
+    def test_check_broken_depends(self):
+        """check reports a dependency on a nonexistent task"""
+        self.append_line('pending.data',
+            '[depends:"11111111-1111-4111-8111-111111111111" '
+            'description:"one" entry:"1500000000" status:"pending" '
+            'uuid:"22222222-2222-4222-8222-222222222222"]')
+        code, out, err = self.t.runError('check')
+        self.assertIn('Task 22222222-2222-4222-8222-222222222222 depends on '
+                      'nonexistent task: 11111111-1111-4111-8111-111111111111', out)
+
+    def test_check_broken_parent(self):
+        """check reports a nonexistent recurrence template"""
+        self.append_line('pending.data',
+            '[description:"one" entry:"1500000000" '
+            'parent:"11111111-1111-4111-8111-111111111111" status:"pending" '
+            'uuid:"22222222-2222-4222-8222-222222222222"]')
+        code, out, err = self.t.runError('check')
+        self.assertIn('has nonexistent recurrence template '
+                      '11111111-1111-4111-8111-111111111111', out)
+
+    def test_check_duplicate(self):
+        """check reports a task in both data files"""
+        line = ('[description:"one" entry:"1500000000" status:"pending" '
+                'uuid:"22222222-2222-4222-8222-222222222222"]')
+        self.append_line('pending.data', line)
+        self.append_line('completed.data', line)
+        code, out, err = self.t.runError('check')
+        self.assertIn('Found duplicate 22222222-2222-4222-8222-222222222222 '
+                      'in pending.data and completed.data', out)
+
+    def test_check_unparseable(self):
+        """check reports a line that does not parse"""
+        self.t('add one')
+        self.append_line('pending.data', 'garbage')
+        code, out, err = self.t.runError('check')
+        self.assertIn('pending.data line 2 does not parse', out)
+
+    def test_check_repair_index(self):
+        """check finds an index that does not describe its file, and repairs it"""
+        self.t('add one')
+        self.t('add two')
+        self.t('1 done')
+        self.t('check')
+
+        # Change the file behind the index, keeping its size and time.
+        path = self.data_path('pending.data')
+        stat = os.stat(path)
+        with open(path) as fh:
+            text = fh.read()
+        with open(path, 'w') as fh:
+            fh.write(text.replace('status:"pending"', 'status:"waiting"'))
+        os.utime(path, ns=(stat.st_atime_ns, stat.st_mtime_ns))
+
+        code, out, err = self.t.runError('check')
+        self.assertIn('The index of pending.data is inconsistent', out)
+
+        code, out, err = self.t.runError('check repair')
+        self.assertIn('rebuilt', out)
+
+        code, out, err = self.t('check')
+        self.assertIn('no problems found', out)
+
+
+if __name__ == "__main__":
+    from simpletap import TAPTestRunner
+    unittest.main(testRunner=TAPTestRunner())
+
+# vim: ai sts=4 et sw=4 ft=python
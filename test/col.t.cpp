@@ -27,13 +27,14 @@
 #include <cmake.h>
 #include <stdlib.h>
 #include <columns/ColID.h>
+#include <format.h>
 #include <main.h>
 #include <test.h>
 
 ////////////////////////////////////////////////////////////////////////////////
 int main (int, char**)
 {
-  UnitTest test (12);
+  UnitTest test (16);
 
   // Ensure environment has no influence.
   unsetenv ("TASKDATA");
@@ -74,6 +75,20 @@ int main (int, char**)
   test.is ((int)minimum, 6, "id:333333 --> ColID::measure minimum 6");
   test.is ((int)maximum, 6, "id:333333 --> ColID::measure maximum 6");
 
+  // Cells are written in place, as the justified value would be colorized.
+  std::vector <std::string> lines;
+  Color plain;
+  t1.id = 3;
+  columnID.render (lines, t1, 5, plain);
+  test.is ((int)lines.size (), 1, "id:3 --> ColID::render one line");
+  test.is (lines[0], "    3", "id:3 --> ColID::render '    3'");
+
+  lines.clear ();
+  Color red ("red");
+  columnID.render (lines, t1, 5, red);
+  test.is ((int)lines.size (), 1, "id:3 red --> ColID::render one line");
+  test.is (lines[0], red.colorize (rightJustify (3, 5)), "id:3 red --> ColID::render colorized '    3'");
+
   return 0;
 }
 
@@ -55,6 +55,46 @@ class TestCount(TestCase):
         self.assertEqual(out.strip(), "1")
 
 
+class TestCountTerms(TestCase):
+    """Filters of one project, tag or status term are counted without
+       evaluation, and must agree with it"""
+
+    @classmethod
+    def setUpClass(cls):
+        cls.t = Task()
+        cls.t("add one project:Home +a")
+        cls.t("add two project:Home.Garden +b")
+        cls.t("log three project:Work +a")
+        cls.t("add four")
+        cls.t("add five project:Home due:tomorrow recur:weekly +a")
+        cls.t("description:four delete", input="y\n")
+
+    def assertCount(self, filter, expected):
+        code, out, err = self.t(filter + " count")
+        self.assertEqual(out.strip(), expected)
+
+        # The same filter, evaluated.
+        code, out, err = self.t("(" + filter + " or false) count")
+        self.assertEqual(out.strip(), expected)
+
+    def test_count_project(self):
+        """Projects match hierarchically, and a recurring template is not counted"""
+        self.assertCount("project:Home", "3")
+        self.assertCount("project:Work", "1")
+        self.assertCount("project:", "1")
+
+    def test_count_tag(self):
+        """Tags count each task that has them"""
+        self.assertCount("+a", "3")
+        self.assertCount("-a", "2")
+        self.assertCount("+missing", "0")
+
+    def test_count_status(self):
+        """Statuses that are counted apart"""
+        self.assertCount("status:completed", "1")
+        self.assertCount("status:Deleted", "1")
+
+
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
     unittest.main(testRunner=TAPTestRunner())
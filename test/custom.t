@@ -73,6 +73,39 @@ class TestCustomReports(TestCase):
         code, out, err = self.t("foo rc._forcecolor:on rc.report.foo.filter:")
         self.assertIn("[44m", out)
 
+class TestReportCache(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t.config("report.cache", "60")
+        self.t.config("report.foo.columns", "id,priority,description")
+        self.t.config("report.foo.labels",  "ID,P,DESCRIPTION")
+        self.t("add one priority:H")
+        self.t("add two")
+
+    def test_repeated_report(self):
+        """A repeated report is reused"""
+        code, first, err = self.t("foo")
+        self.assertTrue(os.path.exists(os.path.join(self.t.datadir, "report.cache")))
+
+        code, second, err = self.t("foo")
+        self.assertEqual(first, second)
+        self.assertIn("2 tasks", second)
+
+    def test_modification(self):
+        """A modification, even of the same size, is not answered from the cache"""
+        self.t("foo")
+        self.t("1 modify priority:L")
+        code, out, err = self.t("foo")
+        self.assertRegexpMatches(out, "1\s+L\s+one")
+
+    def test_different_filter(self):
+        """A different command line is not answered from the cache"""
+        self.t("foo")
+        code, out, err = self.t("foo two")
+        self.assertIn("two", out)
+        self.assertNotIn("one", out)
+
+
 class TestCustomErrorHandling(TestCase):
     def setUp(self):
         self.t = Task()
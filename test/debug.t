@@ -28,6 +28,7 @@
 
 import sys
 import os
+import json
 import unittest
 # Ensure python finds the local simpletap module
 sys.path.append(os.path.dirname(os.path.abspath(__file__)))
@@ -86,6 +87,79 @@ class TestDebugMode(TestCase):
         self.assertIn("Perf task", err)
 
 
+class TestPerfOutput(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task()
+        self.t("add one")
+        self.t("add two")
+        self.t("1 done")
+
+    def test_perf_json(self):
+        """Verify rc.perf.output=json writes timings and counters"""
+        path = os.path.join(self.t.datadir, "perf.json")
+        self.t("rc.perf.output=json rc.perf.file={0} list".format(path))
+        self.t("rc.perf.output=json rc.perf.file={0} all".format(path))
+
+        with open(path) as fh:
+            lines = [json.loads(line) for line in fh]
+
+        self.assertEqual([p["command"] for p in lines], ["list", "all"])
+        self.assertIn("total", lines[0]["timing"])
+        for name in ("init_config", "init_parse", "init_hooks"):
+            self.assertLessEqual(lines[0]["timing"][name], lines[0]["timing"]["init"])
+        self.assertEqual(lines[0]["counters"]["filtered"], 1)
+        self.assertEqual(lines[0]["counters"]["rendered"], 1)
+        self.assertEqual(lines[1]["counters"]["filtered"], 2)
+
+    def test_perf_memory(self):
+        """Verify rc.perf.output=json reports peak RSS and bytes held"""
+        path = os.path.join(self.t.datadir, "perf.json")
+        self.t("rc.perf.output=json rc.perf.file={0} all".format(path))
+
+        with open(path) as fh:
+            memory = json.loads(fh.readline())["memory"]
+
+        self.assertGreater(memory["peak_rss"], 0)
+        self.assertGreater(memory["tasks"], 0)
+        self.assertGreater(memory["render"], 0)
+        self.assertEqual(memory["import"], 0)
+
+    def test_perf_stderr(self):
+        """Verify rc.perf.output=json without perf.file writes to stderr"""
+        code, out, err = self.t("rc.perf.output=json list")
+        self.assertIn('"command":"list"', err)
+
+
+class TestTrace(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task()
+        self.t("add one due:tomorrow")
+        self.t("add two")
+
+    def test_trace_file(self):
+        """Verify rc.trace.file writes Chrome trace events"""
+        path = os.path.join(self.t.datadir, "trace.json")
+        self.t("rc.trace.file={0} next".format(path))
+
+        with open(path) as fh:
+            trace = json.load(fh)
+
+        names = set(e["name"] for e in trace["traceEvents"])
+        for name in ("init", "config", "parse", "hooks init", "command", "filter", "sort", "render", "urgency"):
+            self.assertIn(name, names)
+
+        for event in trace["traceEvents"]:
+            self.assertEqual(event["ph"], "X")
+            self.assertGreaterEqual(event["dur"], 0)
+
+    def test_trace_off(self):
+        """Verify no trace is written by default"""
+        self.t("next")
+        self.assertFalse(os.path.exists(os.path.join(self.t.datadir, "trace.json")))
+
+
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
     unittest.main(testRunner=TAPTestRunner())
@@ -303,6 +303,19 @@ class TestDOMSync(TestCase):
         self.assertNotIn("0", out)
         self.assertIn("1", out)
 
+    def test_dom_tw_syncneeded_after_sync(self):
+        """ DOM tw.syncneeded --> false, once backlog.data is rewritten """
+        self.t("add foo")
+        self.t("_get tw.syncneeded")
+        self.assertTrue(os.path.exists(os.path.join(self.t.datadir, "backlog.data.count")))
+
+        # As a sync leaves it, with only the sync key.
+        with open(os.path.join(self.t.datadir, "backlog.data"), "w") as fh:
+            fh.write("b1a2c3d4-0000-4000-8000-000000000000\n")
+
+        code, out, err = self.t("_get tw.syncneeded")
+        self.assertIn("0", out)
+
 
 class TestDOMDirectReferencesOnAddition(TestCase):
     """
@@ -496,6 +509,42 @@ class TestDOMDirectReferencesFiltering(TestCase):
         self.assertEqual("matching task", result['description'])
 
 
+class TestDOMTaskReferencesFiltering(TestCase):
+    """
+    This class tests that DOM references to the task being evaluated give the
+    value of each task in turn.
+    """
+
+    @classmethod
+    def setUpClass(cls):
+        cls.t = Task()
+        cls.t.config("uda.size.type", "numeric")
+
+        cls.t("add one due:2015-09-01 size:1")
+        cls.t("add two due:2016-09-01 size:2")
+        cls.t("add three")
+        cls.t("2 annotate note")
+        cls.t("2 annotate other")
+
+    def test_dom_filter_date_element(self):
+        """ DOM date element of each task in filter """
+        code, out, err = self.t("due.year == 2016 _unique description")
+        self.assertEqual(out, "two\n")
+
+    def test_dom_filter_numeric_uda(self):
+        """ DOM numeric UDA of each task in filter """
+        code, out, err = self.t("size > 1 _unique description")
+        self.assertEqual(out, "two\n")
+
+    def test_dom_filter_annotations(self):
+        """ DOM annotations of each task in filter """
+        code, out, err = self.t("annotations.count == 2 _unique description")
+        self.assertEqual(out, "two\n")
+
+        code, out, err = self.t("annotations.2.description == other _unique description")
+        self.assertEqual(out, "two\n")
+
+
 class TestBug1300(TestCase):
     @classmethod
     def setUp(cls):
@@ -98,6 +98,41 @@ class TestTaskEdit(TestCase):
         self.t("1 edit")
 
 
+class TestTaskEditAnnotations(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t("add foo")
+        self.t("1 annotate one")
+        self.t("1 annotate two")
+        self.t("1 annotate three")
+
+    def test_unedited_annotations_kept(self):
+        """task edit - annotations left as they were keep their exact dates"""
+        before = self.t.export_one()["annotations"]
+
+        # The edit date format drops the time, yet only the edited annotation
+        # is parsed back with it.
+        self.t.env["VISUAL"] = mkstemp_exec(b"sed -i 's/ -- two$/ -- deux/' $1\n")
+        self.t("1 edit rc.dateformat.edit:Y-M-D")
+
+        before = dict((a["description"], a["entry"]) for a in before)
+        after = dict((a["description"], a["entry"]) for a in self.t.export_one()["annotations"])
+        self.assertEqual(sorted(after), ["deux", "one", "three"])
+        self.assertEqual(after["one"], before["one"])
+        self.assertEqual(after["three"], before["three"])
+
+    def test_other_field_edited(self):
+        """task edit - annotations are untouched by an edit elsewhere"""
+        before = self.t.export_one()["annotations"]
+
+        self.t.env["VISUAL"] = mkstemp_exec(b"sed -i 's/^  Project: .*$/  Project: P/' $1\n")
+        self.t("1 edit rc.dateformat.edit:Y-M-D")
+
+        task = self.t.export_one()
+        self.assertEqual(task["project"], "P")
+        self.assertEqual(task["annotations"], before)
+
+
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
     unittest.main(testRunner=TAPTestRunner())
@@ -30,10 +30,18 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 // A few hard-coded symbols.
+// Lookups of 'y', which are skipped by short-circuit evaluation.
+static int lookups = 0;
+
 bool get (const std::string& name, Variant& value)
 {
   if (name == "x")
     value = Variant (true);
+  else if (name == "y")
+  {
+    ++lookups;
+    value = Variant (true);
+  }
   else
     return false;
 
@@ -43,7 +51,7 @@ bool get (const std::string& name, Variant& value)
 ////////////////////////////////////////////////////////////////////////////////
 int main (int, char**)
 {
-  UnitTest t (52);
+  UnitTest t (68);
 
   // Test the source independently.
   Variant v;
@@ -160,6 +168,67 @@ int main (int, char**)
   t.is (result.type (), Variant::type_duration, "infix '- 2days' --> duration");
   t.is (result.get_duration (), -86400*2,      "infix '- 2days' --> -86400 * 2");
 
+  // Compiled expressions, evaluated repeatedly.
+  std::vector <std::pair <std::string, Lexer::Type>> tokens;
+  Lexer l ("2*3+1");
+  std::string token;
+  Lexer::Type type;
+  while (l.token (token, type))
+    tokens.push_back (std::pair <std::string, Lexer::Type> (token, type));
+
+  e.compileExpression (tokens);
+  e.evaluateCompiledExpression (result);
+  t.is (result.type (), Variant::type_integer, "compiled '2*3+1' --> integer");
+  t.is (result.get_integer (), 7,              "compiled '2*3+1' --> 7");
+  e.evaluateCompiledExpression (result);
+  t.is (result.get_integer (), 7,              "compiled '2*3+1' again --> 7");
+
+  tokens.clear ();
+  Lexer l2 ("x and ! false");
+  while (l2.token (token, type))
+    tokens.push_back (std::pair <std::string, Lexer::Type> (token, type));
+
+  e.compileExpression (tokens);
+  e.evaluateCompiledExpression (result);
+  t.is (result.type (), Variant::type_boolean, "compiled 'x and ! false' --> boolean");
+  t.is (result.get_bool (), true,              "compiled 'x and ! false' --> true");
+  e.evaluateCompiledExpression (result);
+  t.is (result.get_bool (), true,              "compiled 'x and ! false' again --> true");
+
+  // Short-circuit evaluation.
+  auto compiled = [&] (const std::string& expression)
+  {
+    std::vector <std::pair <std::string, Lexer::Type>> expressionTokens;
+    Lexer lexer (expression);
+    while (lexer.token (token, type))
+      expressionTokens.push_back (std::pair <std::string, Lexer::Type> (token, type));
+
+    lookups = 0;
+    e.compileExpression (expressionTokens);
+    e.evaluateCompiledExpression (result);
+  };
+
+  compiled ("false and y");
+  t.is (result.get_bool (), false,             "compiled 'false and y' --> false");
+  t.is (lookups, 0,                            "compiled 'false and y' skips y");
+
+  compiled ("x or y");
+  t.is (result.get_bool (), true,              "compiled 'x or y' --> true");
+  t.is (lookups, 0,                            "compiled 'x or y' skips y");
+
+  compiled ("y and false");
+  t.is (result.get_bool (), false,             "compiled 'y and false' --> false");
+  t.is (lookups, 0,                            "compiled 'y and false' evaluates false first");
+
+  compiled ("x and y");
+  t.is (result.get_bool (), true,              "compiled 'x and y' --> true");
+  t.is (lookups, 1,                            "compiled 'x and y' looks up y");
+
+  // Constant folding.
+  compiled ("2d + 1d");
+  t.is (result.type (), Variant::type_duration, "compiled '2d + 1d' --> duration");
+  t.is (result.get_duration (), 86400*3,       "compiled '2d + 1d' --> 86400 * 3");
+
   return 0;
 }
 
@@ -208,6 +208,85 @@ class TestExportCommandLimit(TestCase):
         self.assertIn("one", out)
         self.assertNotIn("two", out)
 
+    def test_export_pages(self):
+        """Verify that export.page and export.after read every task once, in uuid order"""
+        for i in range(7):
+            self.t("add task{0}".format(i))
+
+        code, out, err = self.t("export")
+        everything = sorted(task["uuid"] for task in json.loads(out))
+
+        pages = []
+        after = ""
+        while True:
+            code, out, err = self.t("rc.export.page=3 rc.export.after={0} export".format(after))
+            page = [task["uuid"] for task in json.loads(out)]
+            pages.append(page)
+            if len(page) < 3:
+                break
+            after = page[-1]
+
+        self.assertEqual([len(page) for page in pages], [3, 3, 1])
+        self.assertEqual(sum(pages, []), everything)
+
+    def test_export_fields(self):
+        """Verify that rc.export.fields limits the exported attributes"""
+        self.t('add one project:p due:tomorrow')
+        self.t('1 annotate note')
+
+        code, out, err = self.t("rc.export.fields=id,project,annotations export")
+        task = json.loads(out)[0]
+        self.assertEqual(sorted(task.keys()), ["annotations", "id", "project"])
+        self.assertEqual(task["annotations"][0]["description"], "note")
+
+        code, out, err = self.t("rc.export.fields=due,urgency export")
+        task = json.loads(out)[0]
+        self.assertEqual(sorted(task.keys()), ["due", "urgency"])
+
+        code, out, err = self.t("rc.export.fields=annotations rc.json.array=0 export")
+        self.assertIn("annotations", json.loads(out))
+
+    def test_export_limit_completed(self):
+        """Verify that 'task export limit:N' continues into completed tasks"""
+        self.t('add one')
+        self.t('log two')
+        self.t('log three')
+
+        code, out, err = self.t("export")
+        full = [task["description"] for task in json.loads(out)]
+
+        code, out, err = self.t("limit:2 export")
+        self.assertEqual([task["description"] for task in json.loads(out)], full[:2])
+
+        code, out, err = self.t("status:completed limit:1 export")
+        self.assertEqual(len(json.loads(out)), 1)
+
+
+class TestExportCommandLarge(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.tasks = [{"uuid": "00000000-0000-0000-0000-{0:012d}".format(i),
+                       "description": "task {0} {1}".format(i, "x" * 200),
+                       "status": "pending",
+                       "entry": "20200101T000000Z"} for i in range(1000)]
+        self.t("import", input=json.dumps(self.tasks))
+
+    def test_export_spans_blocks(self):
+        """Verify that an export larger than one written block is whole"""
+        code, out, err = self.t("export")
+        exported = json.loads(out)
+        self.assertEqual(len(exported), 1000)
+        self.assertEqual(exported[-1]["description"], self.tasks[-1]["description"])
+
+    def test_export_threads(self):
+        """Verify that export.threads does not change the export"""
+        code, single, err = self.t("rc.export.threads=1 export")
+        code, multiple, err = self.t("rc.export.threads=4 export")
+        self.assertEqual(single, multiple)
+
+        code, out, err = self.t("rc.export.threads=4 limit:600 export")
+        self.assertEqual(len(json.loads(out)), 600)
+
 
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
@@ -62,6 +62,16 @@ class TestPrintEmptyColumns(TestCase):
         code, out, err = self.t("rc.print.empty.columns:no /two/ list")
         self.assertIn("Project", out)
 
+    def test_empty_columns_sampled(self):
+        """Verify a column empty in the rc.column.sample tasks is still shown"""
+        for n in range(5):
+            self.t("add task{0}".format(n))
+        self.t("add last project:work")
+
+        code, out, err = self.t("rc.column.sample:2 rc.print.empty.columns:no list")
+        self.assertIn("Project", out)
+        self.assertIn("work", out)
+
 
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
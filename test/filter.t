@@ -1099,6 +1099,98 @@ class TestBug1915(TestCase):
         self.assertIn("thingB", out)
         self.assertNotIn("thingC", out)
 
+class TestFilterThreads(TestCase):
+    def setUp(self):
+        self.t = Task()
+
+        # Write the data directly, as adding this many tasks is slow.
+        with open(os.path.join(self.t.datadir, "pending.data"), "w") as fh:
+            for i in range(1, 3001):
+                fh.write('[description:"task {0}" entry:"1500000000" '
+                         'project:"{1}" status:"pending" '
+                         'uuid:"{2:08x}-0000-4000-8000-000000000000"]\n'
+                         .format(i, "AB"[i % 2], i))
+
+    def test_threads_match_serial(self):
+        """Filtering on several threads gives the same tasks in the same order"""
+        code, serial, err = self.t("rc.filter.threads:1 project:A and description~5 _uuids")
+        code, parallel, err = self.t("rc.filter.threads:4 project:A and description~5 _uuids")
+        self.assertEqual(serial, parallel)
+        self.assertEqual(len(serial.split()), 285)
+
+    def test_threads_zero(self):
+        """Filtering with filter.threads:0 uses all cores"""
+        code, out, err = self.t("rc.filter.threads:0 project:B count")
+        self.assertEqual(out.strip(), "1500")
+
+
+class TestFilterSelection(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t("add one   project:Home      due:2020-01-10")
+        self.t("add two   project:Home.Attic due:2020-03-01")
+        self.t("add three project:Work      due:2020-01-05")
+        self.t("add four  project:Home")
+        self.t("add five  project:HomeOffice due:2020-01-02")
+        self.t("5 done")
+
+    def test_simple_conjuncts(self):
+        """Tasks rejected on status, due and project are never the matches"""
+        code, out, err = self.t("status:pending due.before:2020-02-01 project:Home _ids")
+        self.assertEqual(out.split(), ["1"])
+
+    def test_missing_due(self):
+        """A task without a due date is left to the full filter"""
+        code, out, err = self.t("project:Home due.before:2020-02-01 or due: _ids")
+        self.assertEqual(out.split(), ["1", "4"])
+
+    def test_ids_with_status(self):
+        """An ID in the filter does not rule out pending tasks"""
+        code, out, err = self.t("1,3 status:pending due.after:2020-01-01 _ids")
+        self.assertEqual(out.split(), ["1", "3"])
+
+
+class TestParseCache(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t.config("parser.cache", "1")
+        self.t("add one project:A +tag")
+        self.t("add two project:B")
+        self.t("add three project:A")
+
+    def test_repeated_filter(self):
+        """A repeated filter gives the same result from the parse cache"""
+        code, first, err = self.t("project:A or +tag ls")
+        self.assertTrue(os.path.exists(os.path.join(self.t.datadir, "parse.cache")))
+
+        code, second, err = self.t("project:A or +tag ls")
+        self.assertEqual(first, second)
+        self.assertIn("one", second)
+        self.assertIn("three", second)
+        self.assertNotIn("two", second)
+
+    def test_configuration_change(self):
+        """A change of configuration is not answered from the parse cache"""
+        self.t("1 count")
+        self.t.config("alias.sel", "ls")
+        code, out, err = self.t("sel")
+        self.assertIn("two", out)
+
+    def test_context_change(self):
+        """A context filter is cached by its definition"""
+        self.t.config("context.work", "project:A")
+        self.t.config("context", "work")
+        code, first, err = self.t("ls")
+        code, second, err = self.t("ls")
+        self.assertEqual(first, second)
+        self.assertNotIn("two", second)
+
+        self.t.config("context.work", "project:B")
+        code, out, err = self.t("ls")
+        self.assertIn("two", out)
+        self.assertNotIn("one", out)
+
+
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
     unittest.main(testRunner=TAPTestRunner())
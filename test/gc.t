@@ -71,6 +71,43 @@ class TestGC(TestCase):
         self.assertRegexpMatches(out, "2\s+three")
 
 
+class TestDeferredGC(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t.config("report.gctest.description", "gctest")
+        self.t.config("report.gctest.columns", "id,description,tags")
+        self.t.config("report.gctest.sort", "id+")
+        self.t("add one")
+        self.t("add two")
+        self.t("add three")
+        self.t("1 done")
+
+    def pending_lines(self):
+        with open(os.path.join(self.t.datadir, "pending.data")) as fh:
+            return len(fh.readlines())
+
+    def test_report_leaves_files(self):
+        """A report collects in memory, and leaves pending.data as it was"""
+        code, out, err = self.t("gctest")
+        self.assertRegexpMatches(out, "1\s+two")
+        self.assertRegexpMatches(out, "2\s+three")
+        self.assertEqual(self.pending_lines(), 3)
+
+    def test_write_collects(self):
+        """The next command that writes collects the files"""
+        self.t("gctest")
+        self.t("1 mod +TWO")
+        self.assertEqual(self.pending_lines(), 2)
+
+        code, out, err = self.t("gctest")
+        self.assertRegexpMatches(out, "1\s+two\s+TWO")
+
+    def test_deferred_off(self):
+        """With gc.deferred off, a report rewrites pending.data"""
+        self.t("gctest rc.gc.deferred:0")
+        self.assertEqual(self.pending_lines(), 2)
+
+
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
     unittest.main(testRunner=TAPTestRunner())
@@ -172,6 +172,50 @@ class TestHistoryAnnual(TestCase):
         self.assertRegexpMatches(out, "2014\s+\++X+\s")
         self.assertRegexpMatches(out, "2015\s+\++X+\-+")
 
+class TestHistoryRollup(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task()
+        self.t("add one entry:20150102T120000Z")
+        self.t("add two entry:20150102T120000Z")
+        self.t("add three entry:20150202T120000Z")
+        self.t("1 done end:20150202T120000Z")
+
+    def fresh(self, command):
+        """Report without the stored per-day counts"""
+        rollup = os.path.join(self.t.datadir, "rollup.data")
+        if os.path.exists(rollup):
+            os.remove(rollup)
+        return self.t(command)[1]
+
+    def test_history_rollup_kept(self):
+        """Verify stored per-day counts follow modifications"""
+        code, out, err = self.t("history.monthly")
+        self.assertTrue(os.path.exists(os.path.join(self.t.datadir, "rollup.data")))
+        self.assertRegexpMatches(out, "January\s+2\s+0\s+0\s+2")
+
+        self.t("2 delete end:20150202T120000Z", input="y\n")
+        self.t("add four entry:20150202T120000Z")
+        code, out, err = self.t("history.monthly")
+        self.assertRegexpMatches(out, "February\s+2\s+1\s+1\s+0")
+        self.assertEqual(out, self.fresh("history.monthly"))
+
+    def test_history_rollup_undo(self):
+        """Verify stored per-day counts are not used after undo"""
+        self.t("history.monthly")
+        self.t("2 done end:20150202T120000Z")
+        self.t("undo", input="y\n")
+        code, out, err = self.t("history.monthly")
+        self.assertRegexpMatches(out, "February\s+1\s+1\s+0\s+0")
+        self.assertEqual(out, self.fresh("history.monthly"))
+
+    def test_history_rollup_filtered(self):
+        """Verify a filtered history counts only matching tasks"""
+        self.t("history.monthly")
+        code, out, err = self.t("history.monthly three")
+        self.assertRegexpMatches(out, "February\s+1\s+0\s+0\s+1")
+        self.assertNotIn("January", out)
+
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
     unittest.main(testRunner=TAPTestRunner())
@@ -155,6 +155,123 @@ class TestHooksOnAdd(TestCase):
 
         logs = hook.get_logs()
         self.assertEqual(logs["output"]["msgs"][0], "FEEDBACK")
+    def test_onadd_import_hooks_off(self):
+        """on-add-reject - skipped by import when import.hooks=0"""
+        hookname = 'on-add-reject'
+        self.t.hooks.add_default(hookname, log=True)
+
+        j = '{"description":"foo"}'
+        self.t.runError("import", input=j)
+
+        code, out, err = self.t("import rc.import.hooks=0", input=j)
+        self.assertIn("Imported 1 tasks", err)
+
+        code, out, err = self.t("1 info")
+        self.assertIn("Description   foo", out)
+
+    def test_onadd_import_many(self):
+        """on-add-accept - resolved once, triggered for every imported task"""
+        hookname = 'on-add-accept'
+        self.t.hooks.add_default(hookname, log=True)
+
+        j = '{"description":"one"}\n{"description":"two"}\n{"description":"three"}'
+        code, out, err = self.t("import", input=j)
+        self.assertIn("Imported 3 tasks", err)
+
+        hook = self.t.hooks[hookname]
+        hook.assertTriggeredCount(3)
+        hook.assertExitcode(0)
+
+    def test_onadd_chain_echo(self):
+        """on-add hook echoing its input passes on the previous change"""
+        self.t.hooks.add("on-add-1-change", """#!/usr/bin/env python
+import sys
+import json
+
+task = json.loads(sys.stdin.readline())
+task["project"] = "changed"
+sys.stdout.write(json.dumps(task, separators=(',', ':')) + '\\n')
+""")
+        self.t.hooks.add("on-add-2-echo", """#!/usr/bin/env python
+import sys
+
+sys.stdout.write(sys.stdin.readline())
+""")
+
+        self.t("add foo")
+        code, out, err = self.t("_get 1.project")
+        self.assertEqual("changed\n", out)
+
+    def test_onadd_changed_task_validated(self):
+        """on-add hook changing the task is validated again"""
+        self.t.hooks.add("on-add-recur", """#!/usr/bin/env python
+import sys
+import json
+
+task = json.loads(sys.stdin.readline())
+task["recur"] = "weekly"
+sys.stdout.write(json.dumps(task, separators=(',', ':')) + '\n')
+""")
+
+        code, out, err = self.t.runError("add foo")
+        self.assertIn("A recurring task must also have a 'due' date.", err)
+
+
+class TestHooksOnAddBatch(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task()
+        self.t.activate_hooks()
+
+    def test_onadd_batch_recurrence(self):
+        """on-add-batch hook sees all new recurring instances at once"""
+        hookname = "on-add-batch-count"
+        content = """#!/usr/bin/env python
+import sys
+import json
+
+lines = sys.stdin.readlines()
+for added_task in lines:
+    task = json.loads(added_task)
+    task["project"] = "batch%d" % len(lines)
+    sys.stdout.write(json.dumps(task, separators=(',', ':')) + '\\n')
+sys.stdout.write("FEEDBACK\\n")
+"""
+        self.t.hooks.add(hookname, content)
+        self.t.hooks.add_default("on-add-accept", log=True)
+
+        self.t("add one due:-3d recur:daily")
+        code, out, err = self.t("list")
+        self.assertIn("FEEDBACK", err)
+
+        # The template alone is added with on-add.
+        self.t.hooks["on-add-accept"].assertTriggeredCount(1)
+
+        code, out, err = self.t("+CHILD count")
+        count = out.strip()
+        self.assertNotEqual("0", count)
+        self.assertNotEqual("1", count)
+
+        code, out, err = self.t("project:batch%s count" % count)
+        self.assertEqual(count + "\n", out)
+
+    def test_onadd_batch_count(self):
+        """on-add-batch hook must emit every task"""
+        hookname = "on-add-batch-drop"
+        content = """#!/usr/bin/env python
+import sys
+
+lines = sys.stdin.readlines()
+sys.stdout.write(lines[0])
+"""
+        self.t.hooks.add(hookname, content)
+
+        self.t("add one due:-3d recur:daily")
+        code, out, err = self.t.runError("list")
+        self.assertIn("found 1", err)
+
+        code, out, err = self.t("+CHILD count")
+        self.assertEqual("0\n", out)
 
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
@@ -28,6 +28,8 @@
 
 import sys
 import os
+import json
+import time
 import unittest
 # Ensure python finds the local simpletap module
 sys.path.append(os.path.dirname(os.path.abspath(__file__)))
@@ -104,6 +106,43 @@ class TestHooksOnExit(TestCase):
         logs = hook.get_logs()
         self.assertEqual(logs["output"]["msgs"][0], "FEEDBACK")
 
+class TestHooksOnExitAsync(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task()
+        self.t.activate_hooks()
+
+    def test_onexit_async(self):
+        """on-exit hook listed in hooks.async is not waited on"""
+        marker = os.path.join(self.t.datadir, "marker")
+        self.t.config("hooks.async", "on-exit-slow")
+        self.t.hooks.add("on-exit-slow",
+                         "#!/bin/sh\ncat > {0}.new\nsleep 2\nmv {0}.new {0}\nexit 1\n".format(marker))
+
+        start = time.time()
+        code, out, err = self.t("add foo")
+        self.assertLess(time.time() - start, 2)
+        self.assertFalse(os.path.exists(marker))
+
+        for i in range(50):
+            if os.path.exists(marker):
+                break
+            time.sleep(0.1)
+
+        with open(marker) as fh:
+            self.assertIn('"description":"foo"', fh.read())
+
+    def test_onexit_perf(self):
+        """perf.output reports the time taken by each hook script"""
+        path = os.path.join(self.t.datadir, "perf.json")
+        self.t.hooks.add("on-exit-good", "#!/bin/sh\nexit 0\n")
+        self.t("rc.perf.output=json rc.perf.file={0} add foo".format(path))
+
+        with open(path) as fh:
+            hooks = json.loads(fh.readline())["hooks"]
+
+        self.assertIn("on-exit-good", hooks)
+
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
     unittest.main(testRunner=TAPTestRunner())
@@ -104,6 +104,67 @@ class TestHooksOnLaunch(TestCase):
         logs = hook.get_logs()
         self.assertEqual(logs["output"]["msgs"][0], "FEEDBACK")
 
+class TestHooksOnLaunchParallel(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task()
+        self.t.activate_hooks()
+        self.t.config("hooks.parallel", "on-launch-first,on-launch-second")
+
+    def test_onlaunch_parallel_order(self):
+        """on-launch parallel hooks report feedback in script order"""
+        self.t.hooks.add("on-launch-first", "#!/bin/sh\nsleep 1\necho FIRST\nexit 0\n")
+        self.t.hooks.add("on-launch-second", "#!/bin/sh\necho SECOND\nexit 0\n")
+
+        code, out, err = self.t("version")
+        self.assertIn("Taskwarrior", out)
+        self.assertRegexpMatches(out + err, "FIRST(.|\n)*SECOND")
+
+    def test_onlaunch_parallel_bad(self):
+        """on-launch parallel hook failure prevents processing"""
+        self.t.hooks.add("on-launch-first", "#!/bin/sh\necho FAILED\nexit 1\n")
+        self.t.hooks.add("on-launch-second", "#!/bin/sh\necho SECOND\nexit 0\n")
+
+        code, out, err = self.t.runError("version")
+        self.assertNotIn("Taskwarrior", out)
+        self.assertIn("FAILED", err)
+        self.assertNotIn("SECOND", out + err)
+
+class TestHooksOnLaunchTimeout(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task()
+        self.t.activate_hooks()
+
+    def test_onlaunch_timeout(self):
+        """on-launch hook running past hooks.timeout is stopped, and fails"""
+        self.t.config("hooks.timeout", "200")
+        self.t.hooks.add("on-launch-slow", "#!/bin/sh\nsleep 10\necho SLOW\nexit 0\n")
+
+        code, out, err = self.t.runError("version")
+        self.assertNotIn("Taskwarrior", out)
+        self.assertIn("Hook script exceeded its time limit of 200ms: on-launch-slow", err)
+        self.assertNotIn("SLOW", out + err)
+
+    def test_onlaunch_budget(self):
+        """on-launch hooks running past hooks.budget together are stopped"""
+        self.t.config("hooks.budget", "1500")
+        self.t.hooks.add("on-launch-first", "#!/bin/sh\nsleep 1\necho FIRST\nexit 0\n")
+        self.t.hooks.add("on-launch-second", "#!/bin/sh\nsleep 1\necho SECOND\nexit 0\n")
+
+        code, out, err = self.t.runError("version")
+        self.assertNotIn("SECOND", out + err)
+        self.assertRegexpMatches(err, "time limit of [0-9]+ms: on-launch-second")
+
+    def test_onlaunch_within_timeout(self):
+        """on-launch hook finishing within hooks.timeout succeeds"""
+        self.t.config("hooks.timeout", "5000")
+        self.t.hooks.add("on-launch-quick", "#!/bin/sh\necho QUICK\nexit 0\n")
+
+        code, out, err = self.t("version")
+        self.assertIn("Taskwarrior", out)
+        self.assertIn("QUICK", out + err)
+
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
     unittest.main(testRunner=TAPTestRunner())
@@ -173,6 +173,112 @@ class TestHooksOnModify(TestCase):
         hook.assertTriggeredCount(1)
         hook.assertExitcode(0)
 
+class TestHooksOnModifyBatch(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task()
+        self.t.activate_hooks()
+
+    def test_onmodify_batch(self):
+        """on-modify-batch hook sees all modified tasks at once"""
+        hookname = "on-modify-batch-count"
+        content = """#!/usr/bin/env python
+import sys
+import json
+
+lines = sys.stdin.readlines()
+for modified_task in lines[1::2]:
+    task = json.loads(modified_task)
+    task["project"] = "batch%d" % (len(lines) // 2)
+    sys.stdout.write(json.dumps(task, separators=(',', ':')) + '\\n')
+sys.stdout.write("FEEDBACK\\n")
+"""
+        self.t.hooks.add(hookname, content)
+
+        self.t("add one")
+        self.t("add two")
+        code, out, err = self.t("1,2 modify +tag")
+        self.assertIn("FEEDBACK", err)
+
+        code, out, err = self.t("_get 1.project 2.project")
+        self.assertEqual("batch2 batch2\n", out)
+
+        code, out, err = self.t("+tag count")
+        self.assertEqual("2\n", out)
+
+    def test_onmodify_batch_count(self):
+        """on-modify-batch hook must emit every task"""
+        hookname = "on-modify-batch-drop"
+        content = """#!/usr/bin/env python
+import sys
+
+lines = sys.stdin.readlines()
+sys.stdout.write(lines[1])
+"""
+        self.t.hooks.add(hookname, content)
+
+        self.t("add one")
+        self.t("add two")
+        code, out, err = self.t.runError("1,2 modify +tag")
+        self.assertIn("Expected 2 JSON task(s), found 1", err)
+
+        code, out, err = self.t("+tag count")
+        self.assertEqual("0\n", out)
+
+class TestHooksOnModifyResident(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task()
+        self.t.activate_hooks()
+
+    def test_onmodify_resident(self):
+        """on-modify resident hook sees every event in one process"""
+        hookname = "on-modify-resident"
+        content = """#!/usr/bin/env python
+import sys
+import json
+
+if "api:3" not in sys.argv:
+    sys.exit(1)
+
+count = 0
+while True:
+    original_task = sys.stdin.readline()
+    modified_task = sys.stdin.readline()
+    if not modified_task:
+        break
+
+    count += 1
+    task = json.loads(modified_task)
+    task["project"] = "event%d" % count
+    sys.stdout.write(json.dumps(task, separators=(',', ':')) + '\\n')
+    sys.stdout.write("status:0\\n")
+    sys.stdout.flush()
+"""
+        self.t.hooks.add(hookname, content)
+        self.t.config("hooks.resident", hookname)
+
+        self.t("add one")
+        self.t("add two")
+        self.t("1,2 modify +tag")
+
+        code, out, err = self.t("_get 1.project 2.project")
+        self.assertEqual("event1 event2\n", out)
+
+    def test_onmodify_resident_ends(self):
+        """on-modify resident hook that exits is an error"""
+        hookname = "on-modify-resident"
+        content = """#!/usr/bin/env python
+import sys
+sys.exit(0)
+"""
+        self.t.hooks.add(hookname, content)
+        self.t.config("hooks.resident", hookname)
+
+        self.t("add one")
+        code, out, err = self.t.runError("1 modify +tag")
+        self.assertIn("Resident hook script ended unexpectedly: on-modify-resident", err)
+
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
     unittest.main(testRunner=TAPTestRunner())
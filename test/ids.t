@@ -117,6 +117,115 @@ class TestIDMisParse(TestCase):
         self.assertNotIn("three", out)
 
 
+class TestDataThreads(TestCase):
+    def setUp(self):
+        self.t = Task()
+
+        # Write the data directly, as adding this many tasks is slow.  One
+        # JSON line is included, which is always parsed serially.
+        with open(os.path.join(self.t.datadir, "pending.data"), "w") as fh:
+            for i in range(1, 3001):
+                if i == 1500:
+                    fh.write('{{"description":"task {0}","entry":"1500000000",'
+                             '"status":"pending",'
+                             '"uuid":"{0:08x}-0000-4000-8000-000000000000"}}\n'
+                             .format(i))
+                else:
+                    fh.write('[description:"task {0}" entry:"1500000000" '
+                             'status:"pending" '
+                             'uuid:"{0:08x}-0000-4000-8000-000000000000"]\n'
+                             .format(i))
+
+    def test_threads_match_serial(self):
+        """Parsing on several threads assigns the same IDs as parsing serially"""
+        code, serial, err = self.t("rc.data.threads:1 rc.gc:0 1499-1501 _uuids")
+        code, parallel, err = self.t("rc.data.threads:4 rc.gc:0 1499-1501 _uuids")
+        self.assertEqual(serial, parallel)
+
+        code, out, err = self.t("rc.data.threads:4 rc.gc:0 1500 _uuids")
+        self.assertEqual(out.strip(), "000005dc-0000-4000-8000-000000000000")
+
+
+class TestIDLookup(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t("add one project:A")
+        self.t("add two project:B")
+        self.t("add three project:A")
+        self.t("add four project:B")
+        self.t("1 done")
+
+    def test_id_set_looked_up(self):
+        """An ID set is looked up, rather than evaluated for every task"""
+        code, out, err = self.t("2,4 _uuids rc.debug:1")
+        self.assertIn("[id lookup]", err)
+        self.assertIn("Filtered 2 tasks --> 2 tasks", err)
+
+    def test_id_set_and_filter(self):
+        """An ID set AND-ed with other terms is filtered by those terms"""
+        code, out, err = self.t("1-3 project:A _unique description")
+        self.assertEqual(out, "three\n")
+
+    def test_id_range_beyond_latest(self):
+        """An ID range beyond the latest ID is clipped"""
+        code, out, err = self.t("2-1000000 count")
+        self.assertEqual(out.strip(), "3")
+
+    def test_completed_uuid(self):
+        """A completed task is found by its UUID"""
+        code, uuid, err = self.t("status:completed _uuids")
+        code, out, err = self.t("{0} _unique description".format(uuid.strip()))
+        self.assertEqual(out, "one\n")
+
+    def test_or_not_looked_up(self):
+        """An ID set joined to other terms by 'or' is evaluated for every task"""
+        code, out, err = self.t("2 or project:A _unique description rc.debug:1")
+        self.assertNotIn("[id lookup]", err)
+        self.assertEqual(sorted(out.split()), ["one", "three", "two"])
+
+
+class TestCompletionHelpers(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t("add one project:A +x")
+        self.t("add two project:B +y")
+        self.t("add three project:A")
+        self.t("1 done")
+
+    def test_ids_numbered_as_after_gc(self):
+        """_ids numbers the tasks as a GC would, before one has run"""
+        code, out, err = self.t("_ids")
+        self.assertEqual(out, "1\n2\n")
+
+        # From completion.data.
+        code, out, err = self.t("_ids")
+        self.assertEqual(out, "1\n2\n")
+
+        code, out, err = self.t("ids")
+        self.assertEqual(out, "1-2\n")
+
+    def test_projects_and_tags(self):
+        """_projects and _tags are kept up to date by commit"""
+        code, out, err = self.t("_projects")
+        self.assertEqual(out, "A\nB\n")
+
+        self.t("2 done")
+        code, out, err = self.t("_projects")
+        self.assertEqual(out, "A\n")
+
+        code, out, err = self.t("_projects rc.list.all.projects:1")
+        self.assertEqual(out, "A\nB\n")
+
+        code, out, err = self.t("_tags")
+        self.assertIn("x\n", out)
+        self.assertIn("y\n", out)
+
+    def test_no_gc(self):
+        """Without GC, the completed task keeps its ID"""
+        code, out, err = self.t("_ids rc.gc:0")
+        self.assertEqual(out, "2\n3\n")
+
+
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
     unittest.main(testRunner=TAPTestRunner())
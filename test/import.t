@@ -225,6 +225,18 @@ class TestImport(TestCase):
         for _uuid in ["a1111111-a111-a111-a111-a11111111111","a2222222-a222-a222-a222-a22222222222"]:
             self.assertTrue((_t["depends"][0] == _uuid) or (_t["depends"][1] == _uuid))
 
+    def test_import_same_task_in_batch(self):
+        """Test import same task twice in one input"""
+        _data = """{"uuid":"a1111111-a222-a333-a444-a55555555555","description":"data4"}
+{"uuid":"a1111111-a222-a333-a444-a55555555555","description":"data5"}"""
+        code, out, err = self.t("import", input=_data)
+        self.assertIn("Imported 2 tasks", err)
+        self.assertEqual(out.count(" add  "), 1)
+        self.assertNotIn(" mod  ", out)
+
+        code, out, err = self.t("_get 1.description")
+        self.assertEqual("data5\n", out)
+
     def test_import_same_task_twice(self):
         """Test import same task twice"""
         _data = """{"uuid":"a1111111-a222-a333-a444-a55555555555","description":"data4"}"""
@@ -235,6 +247,26 @@ class TestImport(TestCase):
         code, out2, err = self.t("export")
         self.assertEqual(out1, out2)
 
+    def test_import_direct_and_parsed(self):
+        """Test tasks read directly import as those parsed whole do"""
+        # A boolean urgency, though ignored, is only read by the full parse.
+        _data = """{"uuid":"a1111111-a222-a333-a444-a55555555555","description":"a \\"quoted\\" [value]","status":"pending","entry":"20200229T120000Z","due":"2020-03-01T00:00:00Z","tags":["one","two"],"annotations":[{"entry":"20200301T000000Z","description":"note"}],"orphan":"kept","urgency":1.5}
+{"uuid":"b1111111-b222-b333-b444-b55555555555","description":"a \\"quoted\\" [value]","status":"pending","entry":"20200229T120000Z","due":"2020-03-01T00:00:00Z","tags":["one","two"],"annotations":[{"entry":"20200301T000000Z","description":"note"}],"orphan":"kept","urgency":true}"""
+        self.t("import", input=_data)
+
+        direct = self.t.export("a1111111-a222-a333-a444-a55555555555")[0]
+        parsed = self.t.export("b1111111-b222-b333-b444-b55555555555")[0]
+        for _t in (direct, parsed):
+            del _t["uuid"]
+            del _t["id"]
+            _t.pop("modified", None)
+        self.assertEqual(direct, parsed)
+        self.assertEqual(direct["description"], 'a "quoted" [value]')
+        self.assertEqual(direct["entry"], "20200229T120000Z")
+        self.assertEqual(direct["due"], "20200301T000000Z")
+        self.assertEqual(direct["tags"], ["one", "two"])
+        self.assertEqual(direct["orphan"], "kept")
+
 
 class TestImportExportRoundtrip(TestCase):
     def setUp(self):
@@ -274,6 +306,53 @@ class TestImportExportRoundtrip(TestCase):
         self._validate_data(self.t2)
 
 
+class TestImportThreads(TestCase):
+    def setUp(self):
+        self.t = Task()
+
+    def test_import_threads(self):
+        """Verify that import.threads imports every task, in order"""
+        tasks = [{"uuid": "00000000-0000-0000-0000-{0:012d}".format(i),
+                  "description": "task {0}".format(i)} for i in range(500)]
+        code, out, err = self.t("import rc.import.threads=4", input=json.dumps(tasks))
+        self.assertIn("Imported 500 tasks", err)
+
+        code, out, err = self.t("_get 1.description 500.description")
+        self.assertEqual("task 0 task 499\n", out)
+
+    def test_import_threads_first_error(self):
+        """Verify that import.threads reports the first invalid task"""
+        tasks = [{"description": "task {0}".format(i)} for i in range(500)]
+        tasks[200] = {"status": "foo", "description": "bad"}
+        tasks[400] = {"description": ""}
+        code, out, err = self.t.runError("import rc.import.threads=4", input=json.dumps(tasks))
+        self.assertIn("The status 'foo' is not valid.", err)
+
+    def test_import_threads_shared(self):
+        """Verify that import.threads shares fewer threads, and their messages"""
+        tasks = [{"uuid": "00000000-0000-0000-0000-{0:012d}".format(i),
+                  "description": "task {0}".format(i)} for i in range(500)]
+        tasks[300]["wait"] = "20300101T000000Z"
+        tasks[300]["due"] = "20200101T000000Z"
+        code, out, err = self.t("import rc.import.threads=8 rc.threads=2", input=json.dumps(tasks))
+        self.assertIn("Imported 500 tasks", err)
+        self.assertEqual(err.count("Warning: You have specified that the 'wait' date is after the 'due' date."), 1)
+
+        code, out, err = self.t("_get 1.description 500.description")
+        self.assertEqual("task 0 task 499\n", out)
+
+    def test_import_threads_unique_uuids(self):
+        """Verify that import.threads gives every task without one a unique UUID"""
+        tasks = [{"description": "task {0}".format(i)} for i in range(2000)]
+        code, out, err = self.t("import rc.import.threads=8", input=json.dumps(tasks))
+        self.assertIn("Imported 2000 tasks", err)
+
+        code, out, err = self.t("_uuids")
+        uuids = out.split()
+        self.assertEqual(len(uuids), 2000)
+        self.assertEqual(len(set(uuids)), 2000)
+
+
 class TestImportValidate(TestCase):
     def setUp(self):
         self.t = Task()
@@ -303,6 +382,27 @@ class TestImportValidate(TestCase):
         code, out, err = self.t.runError("import", input=j)
         self.assertIn("The status 'foo' is not valid.", err)
 
+    def test_import_garbage_between_objects(self):
+        """Verify input other than JSON objects is caught"""
+        j = '{"description":"one"}\nfoo\n{"description":"two"}'
+        code, out, err = self.t.runError("import", input=j)
+        self.assertIn("Unrecognized input 'f' between JSON objects.", err)
+
+    def test_import_incomplete_object(self):
+        """Verify an incomplete object is caught, and nothing is imported"""
+        j = '[{"description":"one"},{"description":"tw'
+        self.t.runError("import", input=j)
+        code, out, err = self.t("count")
+        self.assertEqual("0\n", out)
+
+    def test_import_braces_in_strings(self):
+        """Verify braces and quotes within strings do not split objects"""
+        j = '[{"description":"a } b \\" { c"},{"description":"[d]"}]'
+        code, out, err = self.t("import", input=j)
+        self.assertIn("Imported 2 tasks", err)
+        code, out, err = self.t("_get 1.description 2.description")
+        self.assertIn('a } b " { c [d]', out)
+
 
 class TestImportWithoutISO(TestCase):
     def setUp(self):
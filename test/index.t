@@ -0,0 +1,358 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+###############################################################################
+#
+# Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+# https://www.opensource.org/licenses/mit-license.php
+#
+###############################################################################
+
+import sys
+import os
+import re
+import json
+import unittest
+
+# Ensure python finds the local simpletap module
+sys.path.append(os.path.dirname(os.path.abspath(__file__)))
+
+from basetest import Task, TestCase
+
+
+class TestDataIndex(TestCase):
+    def setUp(self):
+        self.t = Task()
+
+    def index_path(self, name):
+        return os.path.join(self.t.datadir, name + '.idx')
+
+    def test_index_written(self):
+        """Index files are written alongside pending.data and completed.data"""
+        self.t('add one')
+        self.t('add two')
+        self.t('1 done')
+        self.assertTrue(os.path.exists(self.index_path('pending.data')))
+        self.assertTrue(os.path.exists(self.index_path('completed.data')))
+
+    def test_index_disabled(self):
+        """No index files are written when rc.data.index is off"""
+        self.t.config('data.index', 'off')
+        self.t('add one')
+        self.t('1 done')
+        self.assertFalse(os.path.exists(self.index_path('pending.data')))
+        self.assertFalse(os.path.exists(self.index_path('completed.data')))
+
+    def test_stale_index_ignored(self):
+        """A stale index is not trusted"""
+        self.t('add one')
+        self.t('1 done')
+        uuid = self.t.export_one()['uuid']
+
+        # Rewrite completed.data behind the index's back.
+        with open(os.path.join(self.t.datadir, 'completed.data'), 'w') as fh:
+            fh.write('')
+
+        code, out, err = self.t.runError('{0} info'.format(uuid))
+        self.assertIn('No matches', err)
+
+    def test_completed_task_lookup(self):
+        """Completed tasks are found by uuid via the index"""
+        self.t('add one')
+        self.t('add two')
+        self.t('1 done')
+        self.t('list')
+        code, out, err = self.t('_get {0}.description'.format(
+            self.t('_uuids +COMPLETED')[1].strip()))
+        self.assertIn('one', out)
+
+
+    def test_byte_order_mark(self):
+        """A byte order mark before the first task is skipped, as is its size in the index"""
+        with open(os.path.join(self.t.datadir, 'pending.data'), 'wb') as fh:
+            fh.write(b'\xef\xbb\xbf'
+                     b'[description:"one" entry:"1500000000" status:"pending" '
+                     b'uuid:"11111111-1111-4111-8111-111111111111"]\n'
+                     b'[description:"two" entry:"1500000000" status:"pending" '
+                     b'uuid:"22222222-2222-4222-8222-222222222222"]\n')
+
+        code, out, err = self.t('list')
+        self.assertIn('one', out)
+        self.assertIn('two', out)
+        self.assertTrue(os.path.exists(self.index_path('pending.data')))
+
+        code, out, err = self.t('_get 11111111-1111-4111-8111-111111111111.description')
+        self.assertEqual('one\n', out)
+        code, out, err = self.t('check')
+        self.assertNotIn('inconsistent', out)
+
+
+class TestDataSegments(TestCase):
+    def setUp(self):
+        self.t = Task()
+
+        # Write the data directly, as completing this many tasks is slow.  Each
+        # task ends an hour after the previous one.
+        with open(os.path.join(self.t.datadir, 'completed.data'), 'w') as fh:
+            for i in range(1, 1001):
+                fh.write('[description:"task {0}" end:"{1}" entry:"1500000000" '
+                         'project:"P{2}" status:"completed" '
+                         'uuid:"{0:08x}-0000-4000-8000-000000000000"]\n'
+                         .format(i, 1500000000 + i * 3600, i % 3))
+
+        # The first command builds the index.
+        self.t('count')
+
+    def test_end_range(self):
+        """Filtering on end gives the same tasks with or without the index"""
+        # 2017-08-01T00:00:00Z is 1501545600, so tasks 430 onwards.
+        code, out, err = self.t('end.after:2017-08-01T00:00:00Z count')
+        self.assertEqual(out.strip(), '571')
+        code, out, err = self.t('rc.data.index:0 end.after:2017-08-01T00:00:00Z count')
+        self.assertEqual(out.strip(), '571')
+
+    def test_project_and_end(self):
+        """Filtering on project and end skips nothing that matches"""
+        code, out, err = self.t('project:P1 end.before:2017-08-01T00:00:00Z count')
+        self.assertEqual(out.strip(), '143')
+
+    def test_pushdown(self):
+        """Status, project, uuid and disjunctions give the same counts"""
+        code, out, err = self.t('+COMPLETED project:P2 count')
+        self.assertEqual(out.strip(), '333')
+        code, out, err = self.t('status:deleted count')
+        self.assertEqual(out.strip(), '0')
+        code, out, err = self.t('( project:P1 or project:P2 ) count')
+        self.assertEqual(out.strip(), '667')
+        code, out, err = self.t('000001f4-0000-4000-8000-000000000000 _unique description')
+        self.assertEqual(out.strip(), 'task 500')
+
+    def test_alternatives(self):
+        """Each term of a disjunction bounds the tasks it can match"""
+        path = os.path.join(self.t.datadir, 'perf.json')
+        code, out, err = self.t('rc.perf.output=json rc.perf.file={0} '
+                                '( +PENDING and start.after:2017-01-01 ) or '
+                                '( +COMPLETED and end.after:2017-08-01T00:00:00Z ) count'
+                                .format(path))
+        self.assertEqual(out.strip(), '571')
+        with open(path) as fh:
+            self.assertLess(json.loads(fh.readlines()[-1])['counters']['parsed'], 1000)
+
+        code, out, err = self.t('rc.data.index:0 '
+                                '( +PENDING and start.after:2017-01-01 ) or '
+                                '( +COMPLETED and end.after:2017-08-01T00:00:00Z ) count')
+        self.assertEqual(out.strip(), '571')
+
+    def test_journaled_record(self):
+        """A later record of a task is used, wherever it is in the file"""
+        with open(os.path.join(self.t.datadir, 'completed.data'), 'a') as fh:
+            fh.write('[description:"moved" end:"1400000000" entry:"1500000000" '
+                     'status:"completed" '
+                     'uuid:"000003e8-0000-4000-8000-000000000000"]\n')
+
+        code, out, err = self.t('end.after:2017-08-01T00:00:00Z count')
+        self.assertEqual(out.strip(), '570')
+
+
+class TestDataEndOrder(TestCase):
+    def setUp(self):
+        self.t = Task()
+
+        # Tasks written in reverse order of end, as an import might leave them.
+        with open(os.path.join(self.t.datadir, 'completed.data'), 'w') as fh:
+            for i in range(1000, 0, -1):
+                fh.write('[description:"task {0}" end:"{1}" entry:"1500000000" '
+                         'status:"completed" '
+                         'uuid:"{0:08x}-0000-4000-8000-000000000000"]\n'
+                         .format(i, 1500000000 + i * 3600))
+
+    def ends(self):
+        with open(os.path.join(self.t.datadir, 'completed.data')) as fh:
+            return [int(re.search(r'end:"(\d+)"', line).group(1)) for line in fh]
+
+    def test_rewritten_in_end_order(self):
+        """A rewritten completed.data is ordered by end"""
+        self.t('000001f4-0000-4000-8000-000000000000 modify project:X')
+        ends = self.ends()
+        self.assertEqual(len(ends), 1000)
+        self.assertEqual(ends, sorted(ends))
+
+    def test_end_range_after_rewrite(self):
+        """A range of end reads only the segments that hold it"""
+        self.t('000001f4-0000-4000-8000-000000000000 modify project:X')
+        code, out, err = self.t('rc.debug:1 end.after:2017-08-01T00:00:00Z count')
+        self.assertIn('571', out)
+        self.assertIn('from 3 of 4 segments', out + err)
+        code, out, err = self.t('rc.data.index:0 end.after:2017-08-01T00:00:00Z count')
+        self.assertEqual(out.strip(), '571')
+
+        code, out, err = self.t('end.after:2017-07-20T00:00:00Z end.before:2017-07-21T00:00:00Z count')
+        self.assertEqual(out.strip(), '24')
+
+    def test_appended_out_of_order(self):
+        """A task appended out of order is still found"""
+        self.t('000001f4-0000-4000-8000-000000000000 modify project:X')
+        with open(os.path.join(self.t.datadir, 'completed.data'), 'a') as fh:
+            fh.write('[description:"late" end:"1400000000" entry:"1400000000" '
+                     'status:"completed" '
+                     'uuid:"00001000-0000-4000-8000-000000000000"]\n')
+
+        code, out, err = self.t('end.before:2015-01-01 count')
+        self.assertEqual(out.strip(), '1')
+
+
+class TestDataProjects(TestCase):
+    def setUp(self):
+        self.t = Task()
+
+        # Long dotted projects, beyond any fixed width.
+        with open(os.path.join(self.t.datadir, 'completed.data'), 'w') as fh:
+            for i in range(1, 1001):
+                fh.write('[description:"task {0}" end:"1500000000" entry:"1500000000" '
+                         'project:"Company.Department.Division.Team.Project{1}" '
+                         'status:"completed" '
+                         'uuid:"{0:08x}-0000-4000-8000-000000000000"]\n'
+                         .format(i, i % 4))
+
+        self.t('count')
+
+    def test_long_project(self):
+        """A long project is known in full, so other projects are not parsed"""
+        path = os.path.join(self.t.datadir, 'perf.json')
+        code, out, err = self.t('rc.perf.output=json rc.perf.file={0} '
+                                'project:Company.Department.Division.Team.Project1 count'
+                                .format(path))
+        self.assertEqual(out.strip(), '250')
+        with open(path) as fh:
+            self.assertLessEqual(json.loads(fh.readlines()[-1])['counters']['parsed'], 250)
+
+        code, out, err = self.t('rc.data.index:0 project:Company.Department.Division.Team.Project1 count')
+        self.assertEqual(out.strip(), '250')
+
+    def test_added_project(self):
+        """A project first seen in an appended task is coded too"""
+        self.t('add new project:Company.Department.Division.Team.Other')
+        self.t('1 done')
+        code, out, err = self.t('project:Company.Department.Division.Team.Other count')
+        self.assertEqual(out.strip(), '1')
+        code, out, err = self.t('project:Company.Department.Division.Team count')
+        self.assertEqual(out.strip(), '1001')
+
+
+class TestDataWords(TestCase):
+    def setUp(self):
+        self.t = Task()
+
+        # Every tenth task is a zebra, and one has an annotation.
+        with open(os.path.join(self.t.datadir, 'completed.data'), 'w') as fh:
+            for i in range(1, 1001):
+                fh.write('[{2}description:"{1} {0}" end:"1500000000" '
+                         'entry:"1500000000" status:"completed" '
+                         'uuid:"{0:08x}-0000-4000-8000-000000000000"]\n'
+                         .format(i, 'zebra' if i % 10 == 0 else 'task',
+                                 'annotation_1500000000:"fed the quokka" '
+                                 if i == 7 else ''))
+
+        self.t('count')
+
+    def test_word(self):
+        """A word search gives the same count with or without the index"""
+        code, out, err = self.t('zebra count')
+        self.assertEqual(out.strip(), '100')
+        code, out, err = self.t('rc.data.index:0 zebra count')
+        self.assertEqual(out.strip(), '100')
+        code, out, err = self.t('description.contains:ebr count')
+        self.assertEqual(out.strip(), '100')
+
+    def test_annotation(self):
+        """A word in an annotation is found"""
+        code, out, err = self.t('quokka _unique description')
+        self.assertEqual(out.strip(), 'task 7')
+
+    def test_absent_word(self):
+        """A word that no task holds matches none"""
+        code, out, err = self.t('rc.verbose:nothing wombat count')
+        self.assertEqual(out.strip(), '0')
+
+    def test_regex(self):
+        """A regex is not taken as a word"""
+        code, out, err = self.t('rc.regex:on zeb.a count')
+        self.assertEqual(out.strip(), '100')
+
+
+
+class TestDataAppend(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t('add one')
+        self.t('add two')
+        self.t('1 done')
+
+        # The first command to read pending.data builds its index.
+        self.t('list')
+
+    def parsed(self, command):
+        path = os.path.join(self.t.datadir, 'perf.json')
+        code, out, err = self.t('rc.perf.output=json rc.perf.file={0} {1}'
+                                .format(path, command))
+        with open(path) as fh:
+            perf = json.loads(fh.readlines()[-1])
+        return out, perf['counters']['parsed']
+
+    def test_add_unloaded(self):
+        """An add is numbered from the index, without parsing either file"""
+        out, parsed = self.parsed('add three')
+        self.assertIn('Created task 2.', out)
+        self.assertEqual(parsed, 0)
+
+        out, parsed = self.parsed('add four')
+        self.assertIn('Created task 3.', out)
+        self.assertEqual(parsed, 0)
+
+        code, out, err = self.t('_get 3.description')
+        self.assertEqual(out.strip(), 'four')
+
+    def test_add_dependency_unloaded(self):
+        """An ID given to depends is found from the index, without parsing"""
+        code, uuid, err = self.t('_get 1.uuid')
+        out, parsed = self.parsed('add three depends:1')
+        self.assertIn('Created task 2.', out)
+        self.assertEqual(parsed, 0)
+
+        code, out, err = self.t('_get 2.depends')
+        self.assertEqual(out.strip(), uuid.strip())
+
+        code, out, err = self.t.runError('add four depends:3')
+        self.assertIn('Could not create a dependency on task 3 - not found.', err)
+
+    def test_add_without_index(self):
+        """Without an index, an add still loads pending.data to number the task"""
+        self.t.config('data.index', 'off')
+        out, parsed = self.parsed('add three')
+        self.assertIn('Created task 2.', out)
+        self.assertNotEqual(parsed, 0)
+
+
+if __name__ == "__main__":
+    from simpletap import TAPTestRunner
+    unittest.main(testRunner=TAPTestRunner())
+
+# vim: ai sts=4 et sw=4 ft=python
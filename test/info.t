@@ -103,6 +103,41 @@ class TestInfoCommand(TestCase):
         self.assertIn("U_ONE", out)
         self.assertIn("U_TWO", out)
 
+class TestInfoJournal(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t("add one")
+        self.t("add other")
+        self.t("1 modify two")
+        self.t("2 modify another")
+        self.t("1 modify three")
+        self.index = os.path.join(self.t.datadir, "undo.data.index")
+
+    def test_info_journal(self):
+        """Verify the journal shows only the changes to the task"""
+        code, out, err = self.t("1 info")
+        self.assertTrue(os.path.exists(self.index))
+        self.assertIn("Description changed from 'one' to 'two'.", out)
+        self.assertIn("Description changed from 'two' to 'three'.", out)
+        self.assertNotIn("another", out)
+
+    def test_info_journal_undo(self):
+        """Verify the journal follows an undo"""
+        self.t("1 info")
+        self.t("undo", input="y\n")
+        code, out, err = self.t("1 info")
+        self.assertIn("Description changed from 'one' to 'two'.", out)
+        self.assertNotIn("three", out)
+
+    def test_info_journal_rebuilt(self):
+        """Verify the journal is found without undo.data.index"""
+        if os.path.exists(self.index):
+            os.remove(self.index)
+        code, out, err = self.t("1 info")
+        self.assertIn("Description changed from 'two' to 'three'.", out)
+        self.assertTrue(os.path.exists(self.index))
+
+
 class TestBug425(TestCase):
     def setUp(self):
         self.t = Task()
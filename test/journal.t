@@ -0,0 +1,123 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+###############################################################################
+#
+# Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+# https://www.opensource.org/licenses/mit-license.php
+#
+###############################################################################
+
+import sys
+import os
+import unittest
+
+# Ensure python finds the local simpletap module
+sys.path.append(os.path.dirname(os.path.abspath(__file__)))
+
+from basetest import Task, TestCase
+
+
+class TestDataJournal(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t.config('data.journal', '3')
+
+    def pending_lines(self):
+        with open(os.path.join(self.t.datadir, 'pending.data')) as fh:
+            return fh.read().splitlines()
+
+    def test_modification_appended(self):
+        """A modification is appended, and supersedes the earlier record"""
+        self.t('add one')
+        self.t('add two')
+        self.t('1 modify three')
+        self.assertEqual(len(self.pending_lines()), 3)
+
+        code, out, err = self.t('_ids')
+        self.assertEqual(out.split(), ['1', '2'])
+        code, out, err = self.t('1 _unique description')
+        self.assertEqual(out.strip(), 'three')
+
+    def test_journal_compacted(self):
+        """The file is rewritten once the journal passes data.journal"""
+        self.t('add one')
+        for word in ('a', 'b', 'c'):
+            self.t('1 modify {0}'.format(word))
+        self.assertEqual(len(self.pending_lines()), 4)
+
+        self.t('1 modify d')
+        self.assertEqual(len(self.pending_lines()), 1)
+        code, out, err = self.t('1 _unique description')
+        self.assertEqual(out.strip(), 'd')
+
+    def test_journal_undo(self):
+        """Undo reverts the current record of a journaled task"""
+        self.t('add one')
+        self.t('1 modify two')
+        self.t('undo', input='y\n')
+        code, out, err = self.t('1 _unique description')
+        self.assertEqual(out.strip(), 'one')
+        self.assertEqual(len(self.pending_lines()), 1)
+
+    def test_completed_modified_unloaded(self):
+        """A completed task found through the index is appended to"""
+        j = '{"uuid":"a1111111-a111-a111-a111-a11111111111","description":"one","status":"completed","entry":"20200101T000000Z","end":"20200102T000000Z"}'
+        self.t('import', input=j)
+        self.t('import', input=j.replace('"one"', '"two"'))
+
+        with open(os.path.join(self.t.datadir, 'completed.data')) as fh:
+            self.assertEqual(len(fh.read().splitlines()), 2)
+
+        code, out, err = self.t('a1111111-a111-a111-a111-a11111111111 _unique description')
+        self.assertEqual(out.strip(), 'two')
+
+    def test_completed_streamed(self):
+        """A read-only filter over completed.data without an index sees only current records"""
+        tasks = ['{{"uuid":"a{0}{0}{0}{0}{0}{0}{0}-a{0}{0}{0}-a{0}{0}{0}-a{0}{0}{0}-a{0}{0}{0}{0}{0}{0}{0}{0}{0}{0}{0}","description":"{1}","status":"completed","entry":"20200101T000000Z","end":"20200102T000000Z"}}'.format(i, d)
+                 for i, d in ((1, 'one'), (2, 'two'), (3, 'three'))]
+        for j in tasks:
+            self.t('import', input=j)
+        self.t('import', input=tasks[1].replace('"two"', '"four"'))
+
+        with open(os.path.join(self.t.datadir, 'completed.data')) as fh:
+            self.assertEqual(len(fh.read().splitlines()), 4)
+
+        tasks = self.t.export('rc.data.index=0 status:completed')
+        self.assertEqual(sorted(t['description'] for t in tasks), ['four', 'one', 'three'])
+
+        # Under a memory budget, the file is streamed, index or not.
+        tasks = self.t.export('rc.memory.budget=1 status:completed')
+        self.assertEqual(sorted(t['description'] for t in tasks), ['four', 'one', 'three'])
+
+    def test_journal_disabled(self):
+        """With data.journal:0 a modification rewrites the file"""
+        self.t.config('data.journal', '0')
+        self.t('add one')
+        self.t('1 modify two')
+        self.assertEqual(len(self.pending_lines()), 1)
+
+
+if __name__ == "__main__":
+    from simpletap import TAPTestRunner
+    unittest.main(testRunner=TAPTestRunner())
+
+# vim: ai sts=4 et sw=4 ft=python
@@ -99,6 +99,30 @@ class TestLimit(TestCase):
         code, out, err = self.t("ls limit:page")
         self.assertIn("30 tasks, truncated to 22 lines", out)
 
+    def test_limit_sorted(self):
+        """Verify limit:N shows the first N tasks of the full sort, ties in order"""
+        self.t.config("verbose", "nothing")
+        for n, priority in enumerate("LHMHLMH"):
+            self.t("add task{0} priority:{1}".format(n, priority))
+
+        code, out, err = self.t("rc.report.ls.sort:priority- ls")
+        full = out.splitlines()
+        code, out, err = self.t("rc.report.ls.sort:priority- ls limit:4")
+        self.assertEqual(out.splitlines(), full[:len(out.splitlines())])
+        self.assertEqual(len(out.splitlines()), 4)
+
+    def test_limit_unsorted(self):
+        """Verify limit:N shows the first N tasks of an unsorted report"""
+        self.t.config("verbose", "nothing")
+        for n in range(6):
+            self.t("add task{0}".format(n))
+
+        code, out, err = self.t("rc.report.ls.sort: ls")
+        full = out.splitlines()
+        code, out, err = self.t("rc.report.ls.sort: ls limit:3")
+        self.assertEqual(out.splitlines(), full[:len(out.splitlines())])
+        self.assertEqual(len(out.splitlines()), 3)
+
 
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
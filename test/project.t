@@ -171,6 +171,65 @@ class TestProjects(TestCase):
         self.assertIn("C", out)
 
 
+class TestProjectCounts(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t("add one pro:foo")
+        self.t("add two pro:foo")
+        self.t("add three pro:foo")
+
+        self.STATUS = ("Project '{0}' is {1} complete \({2} remaining\)\.")
+        self.counts = os.path.join(self.t.datadir, "projects.data")
+
+    def test_project_counts_kept(self):
+        """Verify stored per-project counts follow modifications"""
+        self.assertTrue(os.path.exists(self.counts))
+
+        code, out, err = self.t("1 done")
+        self.assertRegexpMatches(err, self.STATUS.format("foo", "33%",
+                                                         "2 of 3 tasks"))
+
+        code, out, err = self.t("log four pro:foo")
+        self.assertRegexpMatches(err, self.STATUS.format("foo", "50%",
+                                                         "2 of 4 tasks"))
+
+    def test_project_counts_missing(self):
+        """Verify the counts are found without projects.data"""
+        self.t("1 done")
+        os.remove(self.counts)
+
+        code, out, err = self.t("2 done")
+        self.assertRegexpMatches(err, self.STATUS.format("foo", "66%",
+                                                         "1 of 3 tasks"))
+        self.assertTrue(os.path.exists(self.counts))
+
+    def test_project_counts_undo(self):
+        """Verify the counts are not used after undo"""
+        self.t("1 done")
+        self.t("undo", input="y\n")
+
+        code, out, err = self.t("2 done")
+        self.assertRegexpMatches(err, self.STATUS.format("foo", "33%",
+                                                         "2 of 3 tasks"))
+
+    def test_projects_from_counts(self):
+        """Verify the projects command agrees with its stored counts"""
+        self.t("add four")
+        self.t("1 done")
+        self.t("2 delete", input="y\n")
+
+        # Filtered, the tasks are counted instead.
+        for command in ("projects", "projects status.not:x"):
+            code, out, err = self.t(command)
+            self.assertRegexpMatches(out, r"\(none\)\s+1")
+            self.assertRegexpMatches(out, r"foo\s+1")
+            self.assertIn("1 project (2 tasks)", out)
+
+        code, out, err = self.t("projects rc.list.all.projects:1")
+        self.assertRegexpMatches(out, r"foo\s+2")
+        self.assertIn("1 project (3 tasks)", out)
+
+
 class TestSubprojects(TestCase):
     @classmethod
     def setUpClass(cls):
@@ -515,6 +574,32 @@ class TestBug1904(TestCase):
         self.validate_order(out)
 
 
+class TestProjectHierarchy(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task()
+        self.t("add pro:a.c.x one")
+        self.t("add pro:a.b two")
+        self.t("add pro:a.c three")
+        self.t("add pro:b four")
+        self.t("log pro:a.b five")
+        self.t("log pro:d six")
+
+    def test_projects_order(self):
+        """Verify subprojects are listed in order, with subproject counts"""
+        code, out, err = self.t("projects")
+        self.assertRegexpMatches(out, "a\s+3\n  b\s+1\n  c\s+2\n    x\s+1\nb\s+1\n")
+
+    def test_summary_order(self):
+        """Verify summary lists subprojects in order, and rolls up counts"""
+        code, out, err = self.t("summary")
+        self.assertRegexpMatches(out, "a\s+3\s.+\s25%.*\n  b\s+1\s.+\s50%.*\n  c\s+2\s.+\s0%.*\n    x\s+1\s")
+        self.assertNotIn("d ", out)
+
+        code, out, err = self.t("summary rc.summary.all.projects:1")
+        self.assertRegexpMatches(out, "\nd\s+0\s.+\s100%")
+
+
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
     unittest.main(testRunner=TAPTestRunner())
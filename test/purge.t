@@ -71,6 +71,23 @@ class TestDelete(TestCase):
         dependencies = self.t("_get 1.depends")[1].strip()
         self.assertNotIn(uuid, dependencies)
 
+    def test_purge_remove_several_deps(self):
+        """Purging several tasks removes them all from a dependent task"""
+        self.t("add one")
+        self.t("add two")
+        self.t("add three")
+        self.t("add four dep:1,2,3")
+        uuid1, uuid2, uuid3 = self.t("_get 1.uuid 2.uuid 3.uuid")[1].split()
+
+        self.t("1,2 delete", input="y\ny\n")
+        code, out, err = self.t("status:deleted purge", input="y\ny\n")
+        self.assertIn("Purged 2 tasks.", out)
+
+        code, out, err = self.t("_get 2.depends")
+        self.assertNotIn(uuid1, out)
+        self.assertNotIn(uuid2, out)
+        self.assertIn(uuid3, out)
+
     def test_purge_children(self):
         """Purge command indirectly purges child tasks"""
         self.t("add one recur:daily due:yesterday")
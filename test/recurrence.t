@@ -30,6 +30,7 @@ import sys
 import os
 import re
 import unittest
+from datetime import datetime, timedelta
 # Ensure python finds the local simpletap module
 sys.path.append(os.path.dirname(os.path.abspath(__file__)))
 
@@ -103,6 +104,38 @@ class TestRecurrenceLimit(TestCase):
         self.assertEqual(out.count("one"), 4)
 
 
+class TestRecurrenceHighWater(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task()
+
+    def instances(self):
+        """Due dates of all instances, by imask"""
+        self.t("list")  # GC/handleRecurrence
+        tasks = self.t.export("parent.any: status:pending")
+        return dict((int(t["imask"]), t["due"]) for t in tasks)
+
+    def test_recurrence_continues(self):
+        """Verify that instances continue the series from the last one"""
+        self.t.faketime("2020-01-10 00:00:00")
+        self.t("add one due:2020-01-01T12:00:00 recur:P3D")
+        first = self.instances()
+        self.assertEqual(sorted(first), [0, 1, 2, 3])
+
+        # Next instance not due yet, so nothing new.
+        self.t.faketime("2020-01-10 06:00:00")
+        self.assertEqual(self.instances(), first)
+
+        self.t.faketime("2020-01-20 00:00:00")
+        later = self.instances()
+        self.assertEqual(sorted(later), [0, 1, 2, 3, 4, 5, 6, 7])
+        self.assertEqual(later[3], first[3])
+
+        dates = [datetime.strptime(later[i], "%Y%m%dT%H%M%SZ") for i in range(8)]
+        for i in range(1, 8):
+            self.assertEqual(dates[i] - dates[i - 1], timedelta(days=3))
+
+
 class TestRecurrenceWeekdays(TestCase):
     def setUp(self):
         """Executed before each test in the class"""
@@ -162,6 +195,46 @@ class TestRecurrenceUntil(TestCase):
         self.assertIn("Task 4 'one' expired and was deleted.", err)
 
 
+class TestRecurrenceEvents(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task()
+
+    def test_events_recorded(self):
+        """Verify that the next expiration is recorded, and a stale record ignored"""
+        self.t("add one until:now+1d")
+        self.t("list")
+        self.assertTrue(os.path.exists(os.path.join(self.t.datadir, "pending.data.next")))
+
+        # A task written to pending.data by something else is still expired.
+        with open(os.path.join(self.t.datadir, "pending.data"), "a") as f:
+            f.write('[description:"two" entry:"1500000000" status:"pending" '
+                    'until:"1500000100" uuid:"a0a0a0a0-a0a0-a0a0-a0a0-a0a0a0a0a0a0"]\n')
+
+        code, out, err = self.t("list")
+        self.assertIn("'two' expired and was deleted.", err)
+
+        self.t.faketime("+2d")
+        code, out, err = self.t("list")
+        self.assertIn("'one' expired and was deleted.", err)
+
+    def test_expiry_recorded_apart(self):
+        """Verify that the earliest until date is recorded apart from recurrences"""
+        self.t("add one until:now+1d")
+        self.t("add two due:tomorrow recur:weekly until:now+30d")
+        self.t("list")
+
+        with open(os.path.join(self.t.datadir, "pending.data.next")) as f:
+            fields = f.read().split()
+        self.assertEqual(len(fields), 5)
+
+        # Only the task whose until date passed is deleted.
+        self.t.faketime("+2d")
+        code, out, err = self.t("list")
+        self.assertIn("'one' expired and was deleted.", err)
+        self.assertNotIn("'two' expired", err)
+
+
 class TestRecurrenceTasks(TestCase):
     def setUp(self):
         """Executed before each test in the class"""
@@ -53,6 +53,38 @@ class TestReportCommand(TestCase):
         self.assertIn("Most urgent tasks", out)
 
 
+class TestReportThreads(TestCase):
+    def setUp(self):
+        self.t = Task()
+
+        # Write the data directly, as adding this many tasks is slow.
+        with open(os.path.join(self.t.datadir, "pending.data"), "w") as fh:
+            for i in range(1, 5001):
+                fh.write('[description:"task {0} with a description long '
+                         'enough to wrap" entry:"1500000000" project:"{1}" '
+                         'status:"pending" '
+                         'uuid:"{2:08x}-0000-4000-8000-000000000000"]\n'
+                         .format(i, "AB"[i % 2], i))
+
+    def test_threads_match_serial(self):
+        """Rendering rows on several threads gives the same report"""
+        report = ("rc.defaultwidth:40 rc._forcecolor:on rc.color.project.A:red "
+                  "rc.report.list.sort:project+,description+ rc.report.list.break:project "
+                  "list")
+        code, serial, err = self.t("rc.render.threads:1 " + report)
+        code, parallel, err = self.t("rc.render.threads:4 " + report)
+        self.assertEqual(serial, parallel)
+        self.assertIn("task 4999", parallel)
+
+    def test_threads_limit(self):
+        """Rendering rows on several threads stops at the limit"""
+        code, out, err = self.t("rc.render.threads:4 rc.report.list.sort:description+ limit:3 list")
+        self.assertIn("task 1 ", out)
+        self.assertIn("task 100 ", out)
+        self.assertNotIn("task 1000 ", out)
+        self.assertNotIn("task 2 ", out)
+
+
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
     unittest.main(testRunner=TAPTestRunner())
@@ -263,6 +263,46 @@ class TestBug1479(TestCase):
         self.assertIn("P2", out)
 
 
+class TestMatchOperator(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task()
+        self.t.config("verbose", "nothing")
+        self.t("add Alpha one")
+        self.t("1 annotate note")
+        self.t("add beta two")
+        self.t("add gamma three")
+
+    def test_literal_caseless(self):
+        """A literal pattern matches regardless of case when search is caseless"""
+        code, out, err = self.t("rc.search.case.sensitive:no description ~ alpha _unique description")
+        self.assertEqual(out, "Alpha one\n")
+
+        code, out, err = self.t("rc.search.case.sensitive:yes description ~ alpha count")
+        self.assertEqual(out.strip(), "0")
+
+    def test_regex_alternation(self):
+        """A pattern with metacharacters is matched as a regex"""
+        code, out, err = self.t("rc.regex:on description ~ \\'beta|gamma\\' count")
+        self.assertEqual(out.strip(), "2")
+
+        code, out, err = self.t("rc.regex:off description ~ \\'beta|gamma\\' count")
+        self.assertEqual(out.strip(), "0")
+
+    def test_annotation(self):
+        """A literal pattern also matches annotations"""
+        code, out, err = self.t("rc.regex:on description ~ note _unique description")
+        self.assertEqual(out, "Alpha one\n")
+
+    def test_nomatch(self):
+        """The !~ operator is the negation of ~"""
+        code, out, err = self.t("rc.regex:on description !~ a _unique description")
+        self.assertEqual(out, "")
+
+        code, out, err = self.t("rc.regex:on description !~ two count")
+        self.assertEqual(out.strip(), "2")
+
+
 # TODO Search with patterns
 
 
@@ -71,6 +71,15 @@ class TestShowCommand(TestCase):
         code, out, err = self.t("show")
         self.assertIn("Your .taskrc file contains these unrecognized variables:\n  foo", out)
 
+    def test_show_unrecognized_prefix(self):
+        """Verify show command recognizes whole names and dynamic prefixes"""
+        self.t.config("colo", "red")
+        self.t.config("report", "x")
+        self.t.config("color.tag.foo", "red")
+        self.t.config("urgency.user.tag.foo.coefficient", "1.0")
+        code, out, err = self.t("show")
+        self.assertIn("Your .taskrc file contains these unrecognized variables:\n  colo\n  report\n", out)
+
 
 class TestShowHelperCommand(TestCase):
     def setUp(self):
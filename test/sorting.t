@@ -263,6 +263,18 @@ class TestSortNone(TestCase):
         code, out, err = self.t("%s %s %s list rc.report.list.sort:none rc.report.list.columns:id,description rc.report.list.labels:id,desc" % (uuid2, uuid3, uuid1))
         self.assertRegexpMatches(out, ' 2 two\n 3 three\n 1 one')
 
+    def test_sort_none_unmatched(self):
+        """Verify that 'sort:none' skips listed tasks the filter excludes"""
+        self.t("add one")
+        self.t("add two")
+        self.t("add three")
+        code, out, err = self.t("_get 1.uuid 2.uuid 3.uuid")
+        uuid1, uuid2, uuid3 = out.strip().split(' ')
+        self.t("2 done")
+        code, out, err = self.t("%s %s %s list rc.report.list.sort:none rc.report.list.columns:id,description rc.report.list.labels:id,desc" % (uuid3, uuid2, uuid1))
+        self.assertRegexpMatches(out, ' 2 three\n 1 one')
+        self.assertNotIn("two", out)
+
 
 if __name__ == "__main__":
     from simpletap import TAPTestRunner
@@ -0,0 +1,84 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+###############################################################################
+#
+# Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+# https://www.opensource.org/licenses/mit-license.php
+#
+###############################################################################
+import sys
+import os
+import json
+import unittest
+# Ensure python finds the local simpletap module
+sys.path.append(os.path.dirname(os.path.abspath(__file__)))
+
+from basetest import Task, TestCase
+
+
+class TestDataSources(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.other = Task()
+        self.other("add theirs project:Web")
+        self.other("log done")
+
+        self.t = Task()
+        self.t("add mine")
+        self.t.config("data.sources", "web:" + self.other.datadir)
+
+    def test_report_includes_sources(self):
+        """Read-only commands include the tasks of the sources"""
+        code, out, err = self.t("export")
+        tasks = json.loads(out)
+        self.assertEqual(sorted(t["description"] for t in tasks), ["done", "mine", "theirs"])
+        self.assertEqual(sorted(t.get("source", "") for t in tasks), ["", "web", "web"])
+
+        code, out, err = self.t("count")
+        self.assertEqual(out.strip(), "3")
+
+    def test_source_filter(self):
+        """The source attribute selects the tasks of one location"""
+        code, out, err = self.t("source:web status:pending export")
+        self.assertEqual([t["description"] for t in json.loads(out)], ["theirs"])
+
+        code, out, err = self.t("source: export")
+        self.assertEqual([t["description"] for t in json.loads(out)], ["mine"])
+
+    def test_sources_unchanged(self):
+        """A command that changes tasks does not see the sources"""
+        code, out, err = self.t.runError("project:Web modify +seen", input="y\n")
+        self.assertIn("No tasks specified.", err)
+        code, out, err = self.other("_get 1.tags")
+        self.assertEqual(out.strip(), "")
+
+    def test_bad_source(self):
+        """A source must name an existing directory"""
+        code, out, err = self.t.runError("rc.data.sources:nowhere export")
+        self.assertIn("is not of the form <name>:<directory>", err)
+
+
+if __name__ == "__main__":
+    from simpletap import TAPTestRunner
+    unittest.main(testRunner=TAPTestRunner())
+
+# vim: ai sts=4 et sw=4 ft=python
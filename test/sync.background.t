@@ -0,0 +1,87 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+###############################################################################
+#
+# Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+# https://www.opensource.org/licenses/mit-license.php
+#
+###############################################################################
+
+import sys
+import os
+import time
+import unittest
+
+# Ensure python finds the local simpletap module
+sys.path.append(os.path.dirname(os.path.abspath(__file__)))
+
+from basetest import Task, TestCase
+
+
+class TestSyncBackground(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t.config('taskd.server', 'localhost:1')
+        self.t.config('taskd.background', '1')
+
+    def wait_for(self, name):
+        path = os.path.join(self.t.datadir, name)
+        for _ in range(100):
+            if os.path.exists(path):
+                return True
+            time.sleep(0.1)
+        return False
+
+    def test_background_result_shown_once(self):
+        """A failed background sync is reported by the next command, once"""
+        self.t('add one')
+        self.assertTrue(self.wait_for('sync.result'))
+
+        code, out, err = self.t('list')
+        self.assertRegexpMatches(err, 'credentials malformed|GnuTLS')
+
+        code, out, err = self.t('list')
+        self.assertNotRegexpMatches(err, 'credentials malformed|GnuTLS')
+
+    def test_background_backoff(self):
+        """After a failed background sync, no sync starts during the backoff"""
+        self.t('add one')
+        self.assertTrue(self.wait_for('sync.backoff'))
+        self.assertTrue(self.wait_for('sync.result'))
+        self.t('list')
+
+        self.t('add two')
+        time.sleep(1)
+        self.assertFalse(os.path.exists(os.path.join(self.t.datadir, 'sync.result')))
+
+    def test_read_only_command(self):
+        """A command that changes nothing does not sync"""
+        self.t('list')
+        time.sleep(1)
+        self.assertFalse(os.path.exists(os.path.join(self.t.datadir, 'sync.result')))
+
+
+if __name__ == "__main__":
+    from simpletap import TAPTestRunner
+    unittest.main(testRunner=TAPTestRunner())
+
+# vim: ai sts=4 et sw=4 ft=python
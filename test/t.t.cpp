@@ -32,7 +32,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 int main (int, char**)
 {
-  UnitTest test (49);
+  UnitTest test (58);
 
   // Ensure environment has no influence.
   unsetenv ("TASKDATA");
@@ -60,6 +60,18 @@ int main (int, char**)
   after = t3.composeF4 ();
   test.is (before, after, "Task::composeF4 -> parse round trip 4 iterations");
 
+  // Values with escapes and entities.
+  Task t4;
+  t4.set ("description", "a \"quoted\" [bracketed] \\ value");
+  t4.parse (t4.composeF4 ());
+  test.is (t4.get ("description"), "a \"quoted\" [bracketed] \\ value", "Task::parse escapes and entities");
+  test.is (t4.composeF4 (), "[description:\"a \\\"quoted\\\" &open;bracketed&close; \\\\ value\"]", "Task::composeF4 escapes and entities");
+
+  // Composed into a buffer, appended.
+  std::string buffer = "x";
+  t3.composeF4 (buffer);
+  test.is (buffer, "x" + before, "Task::composeF4 appends to a buffer");
+
   // Legacy Format 1 (no longer supported)
   //   [tags] [attributes] description\n
   //   X [tags] [attributes] description\n
@@ -242,6 +254,15 @@ TODO Task::decode
   test.is (t6.composeF4 (), "[description:\"DESC\" entry:\"20130602T224000Z\" tags:\"tag1,tag2\"]", "F4 good");
   test.is (t6.composeJSON (), "{\"description\":\"DESC\",\"entry\":\"20130602T224000Z\",\"tags\":[\"tag1\",\"tag2\"]}", "JSON good");
 
+  // Concrete tags match whole names only, and virtual tags follow changes.
+  test.ok    (t6.hasTag ("tag2"),    "t6 +tag2");
+  test.notok (t6.hasTag ("tag"),     "t6 -tag");
+  test.notok (t6.hasTag ("ag1"),     "t6 -ag1");
+  test.ok    (t6.hasTag ("TAGGED"),  "t6 +TAGGED");
+  test.notok (t6.hasTag ("ACTIVE"),  "t6 -ACTIVE");
+  t6.set ("start", "20130602T224000Z");
+  test.ok    (t6.hasTag ("ACTIVE"),  "t6 +ACTIVE after start");
+
   good = true;
   Task t7;
   try {t7 = Task ("{\"description\":\"DESC\",\"entry\":\"20130602T224000Z\",\"tags\":[\"tag1\",\"tag2\"]}");}
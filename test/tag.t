@@ -75,6 +75,40 @@ class TestTags(TestCase):
         self.assertIn("Modified 0 tasks", out)
 
 
+class TestTagCounts(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task()
+        self.t("add one +a +b")
+        self.t("add two +a")
+        self.t("add three +b")
+        self.t("1 done")
+        self.t("list")
+
+    def test_tags_from_counts(self):
+        """The tags command agrees with its stored counts"""
+        # Filtered, the tasks are counted instead.
+        for command in ("tags", "tags status.not:x"):
+            code, out, err = self.t(command)
+            self.assertRegexpMatches(out, r"a\s+1")
+            self.assertRegexpMatches(out, r"b\s+1")
+            self.assertIn("(2 tasks)", err)
+
+        code, out, err = self.t("tags rc.list.all.tags:1")
+        self.assertRegexpMatches(out, r"a\s+2")
+        self.assertRegexpMatches(out, r"b\s+2")
+        self.assertIn("(3 tasks)", err)
+
+    def test_tags_follow_changes(self):
+        """Stored tag counts follow modifications"""
+        self.t("tags")
+        self.t("2 modify -b +c")
+        code, out, err = self.t("tags")
+        self.assertRegexpMatches(out, r"a\s+1")
+        self.assertRegexpMatches(out, r"c\s+1")
+        self.assertNotRegexpMatches(out, r"\bb\s")
+
+
 class TestVirtualTags(TestCase):
     @classmethod
     def setUpClass(cls):
@@ -36,7 +36,7 @@ Context context;
 ////////////////////////////////////////////////////////////////////////////////
 int main (int, char**)
 {
-  UnitTest t (12);
+  UnitTest t (16);
 
   // Ensure environment has no influence.
   unsetenv ("TASKDATA");
@@ -95,6 +95,25 @@ int main (int, char**)
     t.is ((int) undo.size (),      7, "TDB2 after add, 7 undo lines");
     t.is ((int) backlog.size (),   2, "TDB2 after add, 2 backlog task");
 
+    // Blocked and blocking follow dependencies as they change.
+    Task other ("[description:\"other\"]");
+    other.set ("depends", task.get ("uuid"));
+    context.tdb2.add (other);
+
+    Task found;
+    context.tdb2.get (task.get ("uuid"), found);
+    t.ok (other.is_blocked,  "TDB2 after add, dependent task is blocked");
+    t.ok (found.is_blocking, "TDB2 after add, dependency is blocking");
+
+    task.setStatus (Task::completed);
+    context.tdb2.modify (task);
+
+    context.tdb2.get (other.get ("uuid"), found);
+    t.notok (found.is_blocked, "TDB2 after done, dependent task is not blocked");
+
+    context.tdb2.get (task.get ("uuid"), found);
+    t.notok (found.is_blocking, "TDB2 after done, dependency is not blocking");
+
     context.tdb2.commit ();
 
     // Reset for reuse.
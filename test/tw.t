@@ -0,0 +1,107 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+###############################################################################
+#
+# Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+# https://www.opensource.org/licenses/mit-license.php
+#
+###############################################################################
+import sys
+import os
+import json
+import unittest
+# Ensure python finds the local simpletap module
+sys.path.append(os.path.dirname(os.path.abspath(__file__)))
+
+from basetest import Task, TestCase
+from basetest.utils import task_binary_location
+
+
+class TestShellMode(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task(taskw=task_binary_location("tw"))
+        self.t.config("verbose", "nothing")
+
+    def test_commands_in_turn(self):
+        """Commands read by tw see the changes of those before them"""
+        code, out, err = self.t("", input="add one\nadd 'two words'\ncount\n1 done\ncount\n")
+        self.assertEqual(out.split(), ["2", "1"])
+
+        code, out, err = self.t("_get 2.description")
+        self.assertEqual(out.strip(), "two words")
+
+    def test_overrides_apply_once(self):
+        """An override applies to its command alone"""
+        code, out, err = self.t("", input="add one\nrc.verbose=affected list\nlist\n")
+        self.assertEqual(out.count("1 task"), 1)
+
+    def test_limit_applies_once(self):
+        """A limit:N applies to its command alone"""
+        code, out, err = self.t("", input="add one\nadd two\nlist limit:1\nlist\n")
+        self.assertEqual(out.count("one") + out.count("two"), 3)
+
+    def test_config_change(self):
+        """A command that changes the rc file is seen by the next"""
+        code, out, err = self.t("", input="add one\nconfig verbose affected\ny\nlist\n")
+        self.assertIn("1 task", out)
+
+    def test_query(self):
+        """A JSON query is answered with NDJSON, ended by an empty line"""
+        self.t("add one priority:L")
+        self.t("add two priority:H +work")
+        self.t("add three +work")
+
+        q = '{"filter":"+work","sort":"priority-","limit":1,"attributes":["id","description"]}\n'
+        code, out, err = self.t("", input=q + "count\n")
+        lines = out.split("\n")
+        self.assertEqual(lines[0], '{"id":2,"description":"two"}')
+        self.assertEqual(lines[1], "")
+        self.assertEqual(lines[2], "3")
+
+    def test_query_all_attributes(self):
+        """A JSON query without attributes shows them all"""
+        self.t("add one")
+
+        code, out, err = self.t("", input='{"filter":"one"}\n')
+        task = json.loads(out.split("\n")[0])
+        self.assertEqual(task["description"], "one")
+        self.assertIn("uuid", task)
+
+    def test_query_error(self):
+        """A JSON query that is not understood still ends its response"""
+        code, out, err = self.t.runError("", input='{"columns":["id"]}\n')
+        self.assertIn("The query member 'columns' is not recognized.", err)
+        self.assertEqual(out, "\n")
+
+    def test_quit(self):
+        """Commands after quit are not run"""
+        code, out, err = self.t("", input="add one\nquit\nadd two\n")
+        code, out, err = self.t("count")
+        self.assertEqual(out.strip(), "1")
+
+
+if __name__ == "__main__":
+    from simpletap import TAPTestRunner
+    unittest.main(testRunner=TAPTestRunner())
+
+# vim: ai sts=4 et sw=4 ft=python
@@ -89,6 +89,185 @@ class TestUndoStyle(TestCase):
         self.assertNotRegexpMatches(out, "tags\s+tag\s*")
 
 
+class TestUndoSize(TestCase):
+    def setUp(self):
+        self.t = Task()
+
+    def undo_size(self):
+        return os.path.getsize(os.path.join(self.t.datadir, 'undo.data'))
+
+    def test_undo_repeated(self):
+        """Successive undos each revert one older transaction"""
+        self.t('add one')
+        self.t('1 modify two')
+        self.t('1 modify three')
+        self.t('undo', input='y\n')
+        code, out, err = self.t('_get 1.description')
+        self.assertEqual(out.strip(), 'two')
+        self.t('undo', input='y\n')
+        code, out, err = self.t('_get 1.description')
+        self.assertEqual(out.strip(), 'one')
+        self.t('undo', input='y\n')
+        code, out, err = self.t.runError('undo')
+        self.assertIn('There are no recorded transactions to undo.', err)
+
+    def test_undo_size_limit(self):
+        """undo.size discards the oldest transactions"""
+        self.t.config('undo.size', '1')
+        for n in range(20):
+            self.t('add task number {0}'.format(n))
+        self.assertLessEqual(self.undo_size(), 1024)
+
+        self.t('undo', input='y\n')
+        code, out, err = self.t('_get 20.description')
+        self.assertEqual(out.strip(), '')
+        code, out, err = self.t('_get 19.description')
+        self.assertEqual(out.strip(), 'task number 18')
+
+
+class TestUndoJournal(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t.config('data.journal', '10')
+
+    def data_lines(self, name):
+        with open(os.path.join(self.t.datadir, name)) as fh:
+            return fh.read().splitlines()
+
+    def test_undo_modify_appends(self):
+        """With data.journal, undoing a modification appends the prior record"""
+        self.t('add one')
+        self.t('list')
+        self.t('1 modify two')
+        before = self.data_lines('pending.data')
+        self.t('undo', input='y\n')
+        after = self.data_lines('pending.data')
+        self.assertEqual(after[:len(before)], before)
+        self.assertEqual(len(after), len(before) + 1)
+        code, out, err = self.t('_get 1.description')
+        self.assertEqual(out.strip(), 'one')
+
+    def test_undo_done_moves(self):
+        """A completed task reverted to pending is moved back to pending.data"""
+        self.t('add one')
+        self.t('1 done')
+        self.t('list')
+        self.t('undo', input='y\n')
+        code, out, err = self.t('_get 1.status')
+        self.assertEqual(out.strip(), 'pending')
+        self.assertEqual(len(self.data_lines('completed.data')), 0)
+
+
+class TestUndoGroup(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t('add one')
+        self.t('add two')
+        self.t('add three')
+
+    def test_undo_bulk_modify(self):
+        """All the changes of one bulk command are undone together"""
+        self.t('1-3 modify project:X', input='a\n')
+        code, out, err = self.t('undo', input='y\n')
+        self.assertIn('The last command changed 3 tasks.', out)
+        for n in (1, 2, 3):
+            code, out, err = self.t('_get {0}.project'.format(n))
+            self.assertEqual(out.strip(), '')
+
+        # The additions were separate commands.
+        self.t('undo', input='y\n')
+        code, out, err = self.t('_get 3.description')
+        self.assertEqual(out.strip(), '')
+        code, out, err = self.t('_get 2.description')
+        self.assertEqual(out.strip(), 'two')
+
+    def test_undo_bulk_journal(self):
+        """A bulk modification is undone through the data files with data.journal"""
+        self.t.config('data.journal', '10')
+        self.t('list')
+        self.t('1-3 modify project:X', input='a\n')
+        self.t('undo', input='y\n')
+        code, out, err = self.t('project:X count')
+        self.assertEqual(out.strip(), '0')
+        code, out, err = self.t('count')
+        self.assertEqual(out.strip(), '3')
+
+    def test_undo_bulk_done(self):
+        """A bulk completion is undone together"""
+        self.t('1-3 done', input='a\n')
+        self.t('undo', input='y\n')
+        code, out, err = self.t('status:pending count')
+        self.assertEqual(out.strip(), '3')
+
+
+class TestUndoDelta(TestCase):
+    def setUp(self):
+        self.t = Task()
+        self.t.config('undo.delta', '1')
+
+    def undo_lines(self):
+        with open(os.path.join(self.t.datadir, 'undo.data')) as fh:
+            return fh.read().splitlines()
+
+    def test_undo_delta_recorded(self):
+        """undo.delta keeps only the changed attributes, before and after"""
+        self.t('add one project:A')
+        self.t('1 modify two project: +tag')
+        lines = self.undo_lines()
+        was = [l for l in lines if l.startswith('was ')]
+        self.assertEqual(len(was), 1)
+        self.assertIn('description:"one"', was[0])
+        self.assertIn('project:"A"', was[0])
+        self.assertIn('tags:""', was[0])
+        self.assertNotIn('uuid:', was[0])
+
+        changed = [l for l in lines if l.startswith('set ')]
+        self.assertEqual(len(changed), 1)
+        self.assertIn('description:"two"', changed[0])
+        self.assertIn('project:""', changed[0])
+        self.assertIn('tags:"tag"', changed[0])
+        self.assertIn('uuid:', changed[0])
+        self.assertNotIn('entry:', changed[0])
+
+        # Only the addition is whole.
+        self.assertEqual(len([l for l in lines if l.startswith('new ')]), 1)
+
+    def test_undo_delta_revert(self):
+        """A prior record kept by undo.delta is undone, and shown by info"""
+        self.t('add one project:A')
+        self.t('1 modify two project: +tag')
+        code, out, err = self.t('rc.journal.info=1 1 info')
+        self.assertIn("Description changed from 'one' to 'two'.", out)
+        self.t('undo', input='y\n')
+        code, out, err = self.t('_get 1.description 1.project 1.tags')
+        self.assertEqual(out.strip(), 'one A')
+
+    def test_undo_delta_repeated(self):
+        """Successive modifications kept by undo.delta are undone in turn"""
+        self.t('add one')
+        self.t('1 start')
+        self.t('1 modify two')
+        self.t('1 stop')
+        self.t('undo', input='y\n')
+        code, out, err = self.t('_get 1.description 1.start')
+        self.assertEqual(out.split()[0], 'two')
+        self.assertEqual(len(out.split()), 2)
+        self.t('undo', input='y\n')
+        self.t('undo', input='y\n')
+        code, out, err = self.t('_get 1.description 1.start')
+        self.assertEqual(out.strip(), 'one')
+
+    def test_undo_delta_mixed(self):
+        """Records written before undo.delta are still read"""
+        self.t('rc.undo.delta=0 add one')
+        self.t('rc.undo.delta=0 1 modify two')
+        self.t('1 modify three')
+        self.t('undo', input='y\n')
+        self.t('undo', input='y\n')
+        code, out, err = self.t('_get 1.description')
+        self.assertEqual(out.strip(), 'one')
+
+
 class TestBug634(TestCase):
     def setUp(self):
         self.t = Task()
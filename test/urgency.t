@@ -267,6 +267,13 @@ class TestUrgency(TestCase):
         code, out, err = self.t("rc.urgency.uda.priority.H.coefficient:0.01234 _get 47.urgency")
         self.assertApproximately(0.01234, out)
 
+    def test_urgency_explain(self):
+        """Verify _urgency explain shows each term"""
+        code, out, err = self.t("2 _urgency explain")
+        self.assertRegex(out, r"uda priority\.H\s+1\s+\d+\s+10\s+10\s+10\n")
+        self.assertRegex(out, r"urgency\s+1\s+\d+\s+10\s+10\s+10\n")
+        self.assertNotIn("task 2 urgency", out)
+
     def test_urgency_no_task(self):
         """Verify no error when no tasks match"""
         code, out, err = self.t.runError("999 _urgency")
@@ -290,6 +297,42 @@ class TestUrgency(TestCase):
         self.assertEqual("task 1 urgency 0\n", out)
 
 
+class TestUrgencyKept(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task()
+        self.t.config("urgency.age.coefficient", "0")
+        self.t("add one project:P +tag")
+
+        # Sorting by urgency keeps the static terms in the index.
+        self.t("next")
+
+    def test_kept_coefficients(self):
+        """Kept urgency is not used with other coefficients"""
+        code, out, err = self.t("_get 1.urgency")
+        self.assertEqual("1.8\n", out)
+
+        code, out, err = self.t("rc.urgency.project.coefficient:5 _get 1.urgency")
+        self.assertEqual("5.8\n", out)
+
+    def test_kept_modified(self):
+        """Kept urgency follows a modified task"""
+        self.t("1 modify project:")
+        code, out, err = self.t("_get 1.urgency")
+        self.assertEqual("0.8\n", out)
+
+        self.t("next")
+        code, out, err = self.t("_get 1.urgency")
+        self.assertEqual("0.8\n", out)
+
+    def test_kept_dependencies(self):
+        """Kept urgency follows the dependencies of a task"""
+        self.t("add two dep:1")
+        self.t("next")
+        code, out, err = self.t("_get 1.urgency")
+        self.assertEqual("9.8\n", out)
+
+
 class TestBug837(TestCase):
     def setUp(self):
         """Executed before each test in the class"""
@@ -29,12 +29,15 @@
 #include <stdlib.h>
 #include <main.h>
 #include <util.h>
+#include <shared.h>
+#include <utf8.h>
+#include <Uuid.h>
 #include <test.h>
 
 ////////////////////////////////////////////////////////////////////////////////
 int main (int, char**)
 {
-  UnitTest t (19);
+  UnitTest t (40);
 
   // Ensure environment has no influence.
   unsetenv ("TASKDATA");
@@ -84,6 +87,54 @@ int main (int, char**)
   t.ok    (nontrivial ("  \t\ta"),                "nontrivial '  \\t\\ta' -> true");
   t.ok    (nontrivial ("a\t\t  "),                "nontrivial 'a\\t\\t  ' -> true");
 
+  // unsigned int textWidth (const std::string&);
+  t.is ((int) textWidth (""),                     0,  "textWidth '' -> 0");
+  t.is ((int) textWidth ("abc"),                  3,  "textWidth 'abc' -> 3");
+  t.is ((int) textWidth ("a longer ASCII text"), 19,  "textWidth 'a longer ASCII text' -> 19");
+  t.is ((int) textWidth ("tab\there and there"), 17,  "textWidth 'tab\\there and there' -> 17");
+  t.is ((int) textWidth ("ASCII then \u4e2d\u6587"), 15, "textWidth 'ASCII then CJK' -> 15");
+  t.is ((int) textWidth ("\u00e9l\u00e8ve"), (int) utf8_width ("\u00e9l\u00e8ve"), "textWidth matches utf8_width");
+
+  // std::pair <...> settings (const Configuration&, const std::string&);
+  Configuration config;
+  config.set ("alias", "x");
+  config.set ("alias.one", "1");
+  config.set ("alias.two", "2");
+  config.set ("aliases", "x");
+  auto range = settings (config, "alias.");
+  t.is (range.first->first, "alias.one",                  "settings 'alias.' starts at 'alias.one'");
+  t.is ((int) std::distance (range.first, range.second), 2, "settings 'alias.' -> 2 settings");
+  range = settings (config, "color.");
+  t.ok (range.first == range.second,                      "settings 'color.' -> none");
+  t.ok (settings (config, "aliases").first != config.end (), "settings 'aliases' -> found");
+
+  // int countFields (const std::string&, char delimiter = ',');
+  t.is (countFields (""),                         0,  "countFields '' -> 0");
+  t.is (countFields ("a"),                        1,  "countFields 'a' -> 1");
+  t.is (countFields ("a,,b,"),                    4,  "countFields 'a,,b,' -> 4");
+
+  // bool scanFields (const std::string&, char, F);
+  std::vector <std::string> fields;
+  auto collect = [&] (const char* field, size_t length)
+  {
+    fields.emplace_back (field, length);
+    return fields.size () < 2;
+  };
+
+  t.ok (scanFields ("", ',', collect),             "scanFields '' -> true");
+  t.ok (scanFields ("one", ',', collect),          "scanFields 'one' -> true");
+  t.notok (scanFields ("two,,three", ',', collect), "scanFields 'two,,three' stopped -> false");
+  t.is (join ("|", fields), "one|two",             "scanFields found 'one', 'two'");
+
+  // const std::string uuid ();
+  auto first = uuid ();
+  auto second = uuid ();
+  Uuid parsed;
+  t.ok (Uuid::parse (first, parsed),               "uuid -> canonical lower case");
+  t.is (first[14], '4',                            "uuid -> version 4");
+  t.ok (strchr ("89ab", first[19]) != nullptr,     "uuid -> RFC 4122 variant");
+  t.ok (first != second,                           "uuid -> distinct");
+
   return 0;
 }
 
@@ -0,0 +1,66 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// https://www.opensource.org/licenses/mit-license.php
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmake.h>
+#include <unordered_set>
+#include <Uuid.h>
+#include <test.h>
+
+////////////////////////////////////////////////////////////////////////////////
+int main (int, char**)
+{
+  UnitTest t (14);
+
+  Uuid a;
+  t.ok (Uuid::parse ("8ad2e3db-914d-4832-b0e6-72fa04f6e331", a), "parse canonical -> true");
+  t.is (a.str (), "8ad2e3db-914d-4832-b0e6-72fa04f6e331",          "str round trip");
+
+  Uuid b;
+  t.ok (Uuid::parse ("00000000-0000-0000-0000-000000000001", b), "parse ...0001 -> true");
+  t.is (b.str (), "00000000-0000-0000-0000-000000000001",          "str keeps leading zeros");
+  t.ok (b < a,                                                     "ordered by value");
+  t.ok (a != b,                                                    "different -> !=");
+
+  Uuid c;
+  t.notok (Uuid::parse ("8AD2E3DB-914D-4832-B0E6-72FA04F6E331", c), "parse upper case -> false");
+  t.notok (Uuid::parse ("8ad2e3db-914d-4832-b0e6-72fa04f6e33", c),  "parse short -> false");
+  t.notok (Uuid::parse ("8ad2e3db0914d-4832-b0e6-72fa04f6e331", c), "parse misplaced hyphen -> false");
+  t.notok (Uuid::parse ("8ad2e3db-914d-4832-b0e6-72fa04f6e33g", c), "parse non-hex -> false");
+
+  std::vector <Uuid> list;
+  Uuid::parse_list ("8ad2e3db-914d-4832-b0e6-72fa04f6e331,junk,00000000-0000-0000-0000-000000000001", list);
+  t.is ((int) list.size (), 2,                                     "parse_list skips junk");
+  t.ok (list.size () == 2 && list[0] == a && list[1] == b,         "parse_list keeps order");
+
+  std::unordered_set <Uuid> set {a, b};
+  t.ok (set.find (a) != set.end (),                                "hashed lookup finds a");
+  t.ok (set.find (Uuid ()) == set.end (),                          "hashed lookup misses nil");
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,116 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+###############################################################################
+#
+# Copyright 2006 - 2019, Paul Beckingham, Federico Hernandez.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+# https://www.opensource.org/licenses/mit-license.php
+#
+###############################################################################
+import sys
+import os
+import subprocess
+import tempfile
+import time
+import unittest
+# Ensure python finds the local simpletap module
+sys.path.append(os.path.dirname(os.path.abspath(__file__)))
+
+from basetest import Task, TestCase
+
+
+class TestWatch(TestCase):
+    def setUp(self):
+        """Executed before each test in the class"""
+        self.t = Task()
+        self.t("add one")
+
+    def test_watch_write_command(self):
+        """A command that changes tasks cannot be watched"""
+        code, out, err = self.t.runError("watch add two")
+        self.assertIn("The 'add' command changes tasks, so cannot be watched.", err)
+
+        code, out, err = self.t("count")
+        self.assertEqual(out.strip(), "1")
+
+    def test_watch_no_report(self):
+        """watch needs a report"""
+        code, out, err = self.t.runError("watch")
+        self.assertIn("The watch command needs a report", err)
+
+    def test_watch_redraw(self):
+        """A watched report, after overrides and abbreviated, is shown again when a task changes"""
+        def wait_for(output, text):
+            for _ in range(100):
+                output.seek(0)
+                if text in output.read():
+                    return True
+                time.sleep(0.1)
+            return False
+
+        with tempfile.TemporaryFile(mode="w+") as output:
+            watch = subprocess.Popen([self.t.taskw, "rc.verbose=nothing", "watc", "ls"],
+                                     stdout=output, stderr=subprocess.STDOUT,
+                                     env=self.t.env)
+            try:
+                self.assertTrue(wait_for(output, "one"))
+                self.t("1 modify three")
+                self.assertTrue(wait_for(output, "three"))
+            finally:
+                watch.kill()
+                watch.wait()
+
+    def test_watch_redraw_config(self):
+        """A setting changed by a watched command does not carry into the next redraw"""
+        def wait_for(output, size):
+            for _ in range(100):
+                output.seek(0)
+                text = output.read()
+                if len(text) >= size:
+                    return text
+                time.sleep(0.1)
+            return text
+
+        # The calendar sets 'due' to 0, which would mark the task as due in
+        # a later redraw, and so color it differently.
+        self.t("1 modify due:20d")
+        with tempfile.TemporaryFile(mode="w+") as output:
+            watch = subprocess.Popen([self.t.taskw, "rc._forcecolor=on", "rc.verbose=nothing", "watch", "calendar"],
+                                     stdout=output, stderr=subprocess.STDOUT,
+                                     env=self.t.env)
+            try:
+                first = wait_for(output, 1)
+                time.sleep(1)
+                first = wait_for(output, len(first))
+                self.assertNotEqual(first, "")
+
+                self.t("add two")
+                self.assertEqual(wait_for(output, 2 * len(first)), first * 2)
+            finally:
+                watch.kill()
+                watch.wait()
+
+
+if __name__ == "__main__":
+    from simpletap import TAPTestRunner
+    unittest.main(testRunner=TAPTestRunner())
+
+# vim: ai sts=4 et sw=4 ft=python